@@ -26,23 +26,41 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "app/BatchManifest.h"
 #include "app/BuildInfo.h"
+#include "app/EngineContext.h"
+#include "app/PluginChainPool.h"
+#include "app/RenderDaemon.h"
+#include "app/RenderSegment.h"
 #include "audio/AudioSettings.h"
+#include "audio/SampleBufferQueue.h"
+#include "base/AllocationCounter.h"
 #include "base/PlatformUtilities.h"
+#include "base/Thread.h"
 #include "io/SampleSource.h"
 #include "io/SampleSourcePcm.h"
 #include "logging/EventLogger.h"
 #include "logging/LogPrinter.h"
 #include "midi/MidiSequence.h"
 #include "midi/MidiSource.h"
+#include "plugin/PluginAutomation.h"
 #include "plugin/PluginChain.h"
 #include "time/AudioClock.h"
 
 #include "MrsWatsonOptions.h"
 #include "MrsWatson.h"
 
+// Number of MIDI events per block which can be scheduled without allocating
+// memory during processing. Blocks with more events than this still work, but
+// the event list grows the first time that it happens.
+#define MIDI_EVENTS_PER_BLOCK_CAPACITY 64
+// Number of input blocks which can be queued for the alternative chains of
+// --plugin when --pipeline does not give a queue size
+#define FAN_OUT_QUEUE_SIZE 8
+
 static void _printTaskTime(void* item, void* userData) {
   TaskTimer taskTimer = (TaskTimer)item;
   TaskTimer totalTimer = (TaskTimer)userData;
@@ -52,6 +70,12 @@ static void _printTaskTime(void* item, void* userData) {
   freeCharString(prettyTimeString);
 }
 
+static void _printQueueOccupancy(const char* queueName, SampleBufferQueue queue) {
+  logInfo("  %s queue: %.1f of %lu blocks used on average (%lu max), producer waited %lu times, consumer waited %lu times",
+    queueName, sampleBufferQueueGetAverageOccupancy(queue), queue->capacity, queue->maxOccupancy,
+    queue->producerStalls, queue->consumerStalls);
+}
+
 static void _remapFileToErrorReport(ErrorReporter errorReporter, ProgramOptions options, unsigned int index, boolByte copyFile) {
   if(options->options[index]->enabled) {
     CharString optionString = programOptionsGetString(options, index);
@@ -119,8 +143,6 @@ static ReturnCodes buildPluginChain(PluginChain pluginChain, const CharString ar
   if(!pluginChainAddFromArgumentString(pluginChain, argument, pluginSearchRoot)) {
     return RETURN_CODE_INVALID_PLUGIN_CHAIN;
   }
-  // No longer needed
-  freeCharString(pluginSearchRoot);
 
   if(pluginChain->numPlugins == 0) {
     logError("No plugins loaded");
@@ -160,124 +182,1599 @@ static ReturnCodes setupMidiSource(MidiSource midiSource, MidiSequence* outSeque
       logWarn("Failed reading MIDI events from source '%s'", midiSource->sourceName->data);
       return RETURN_CODE_IO_ERROR;
     }
-  }
+  }
+
+  return RETURN_CODE_SUCCESS;
+}
+
+static ReturnCodes setupOutputSource(SampleSource outputSource) {
+  if(outputSource == NULL) {
+    return RETURN_CODE_INVALID_ARGUMENT;
+  }
+  if(!outputSource->openSampleSource(outputSource, SAMPLE_SOURCE_OPEN_WRITE)) {
+    logError("Output source '%s' could not be opened", outputSource->sourceName->data);
+    return RETURN_CODE_IO_ERROR;
+  }
+
+  return RETURN_CODE_SUCCESS;
+}
+
+static void _processMidiMetaEvent(void* item, void* userData) {
+  MidiEvent midiEvent = (MidiEvent)item;
+  boolByte *finishedReading = (boolByte*)userData;
+  if(midiEvent->eventType == MIDI_TYPE_META) {
+    switch(midiEvent->status) {
+      case MIDI_META_TYPE_TEMPO:
+        setTempoFromMidiBytes(midiEvent->extraData);
+        break;
+      case MIDI_META_TYPE_TIME_SIGNATURE:
+        if(!setTimeSignatureFromMidiBytes(midiEvent->extraData)) {
+          logWarn("Could not set time signature from MIDI file");
+        }
+        break;
+      case MIDI_META_TYPE_TRACK_END:
+        logInfo("Reached end of MIDI track");
+        *finishedReading = true;
+        break;
+      default:
+        logWarn("Don't know how to process MIDI meta event of type 0x%x", midiEvent->status);
+        break;
+    }
+  }
+}
+
+/**
+ * Collect all MIDI events in the current block and apply any meta events. The
+ * events are sent to the plugin chain together with the block's audio.
+ * @param midiSequence Sequence to read events from
+ * @param midiEventsForBlock List to collect the block's events in, which is
+ * reused for each block so that no memory needs to be allocated
+ * @param currentFrame Start frame of the current block
+ * @return True if the end of the MIDI sequence has been reached
+ */
+static boolByte _readMidiForBlock(MidiSequence midiSequence, LinkedList midiEventsForBlock, unsigned long currentFrame) {
+  boolByte finishedReading;
+  linkedListClear(midiEventsForBlock);
+  finishedReading = (boolByte)!fillMidiEventsFromRange(midiSequence, currentFrame, getBlocksize(), midiEventsForBlock);
+  linkedListForeach(midiEventsForBlock, _processMidiMetaEvent, &finishedReading);
+  return finishedReading;
+}
+
+/**
+ *  Reads from inputSource.
+ *
+ * @param inputSource The SampleSource to read from.
+ * @param silenceSource The source from where to read silentTailFrames silent tail frames.
+ * @param buffer The SampleBuffer to which the samples will be written.
+ * @param scratchBuffer Buffer with the same size as buffer, used to read the silent tail frames.
+ * @param silentTailFrames Number of silent samples that will be provided at the end of inputSource.
+ * @return True if there is more input to read.
+ */
+boolByte readInput(SampleSource inputSource, SampleSource silenceSource, SampleBuffer buffer,
+  SampleBuffer scratchBuffer, unsigned long silentTailFrames) {
+  unsigned long framesRead;
+  unsigned long bufferSize = buffer->blocksize;
+
+  inputSource->readSampleBlock(inputSource, buffer);
+  framesRead = buffer->blocksize; //buffer->blocksize tells how man frames have been read from inputSource, during tail period it will be 0.
+
+  //We are not done until framesRead < bufferSize and silenceSource->numSamplesProcessed/buffer->numChannels == silentTailFrames
+  if(framesRead == bufferSize) {
+    return true; // more input
+  } else if(framesRead < bufferSize) {
+    unsigned long remainingSilence = silentTailFrames - silenceSource->numSamplesProcessed/buffer->numChannels; // 0 < remainingSilence <= silentTailFrames
+    unsigned long numberOfFrames = remainingSilence < (bufferSize - framesRead) ? remainingSilence : (bufferSize - framesRead); // 0 < numberOfFrames <= bufferSize
+    scratchBuffer->blocksize = numberOfFrames;
+    if(!silenceSource->readSampleBlock(silenceSource, scratchBuffer)) {
+      logInternalError("SilentSource does not behave correct.");
+    }
+    buffer->blocksize = framesRead + numberOfFrames; // 0 < buffer->blocksize <= bufferSize.
+    sampleBufferCopyAndMapChannelsWithOffset(buffer, framesRead, scratchBuffer, 0, numberOfFrames);
+    return (boolByte)(silenceSource->numSamplesProcessed/buffer->numChannels != silentTailFrames);
+  } else {
+    logInternalError("framesRead > bufferSize");
+    return false; //stop here.
+  }
+}
+
+/**
+ *  Writes to outputSource.
+ *
+ * @param outputSource The SampleSource to write to.
+ * @param silenceSource The source from where to write skipHeadFrames frames.
+ * @param buffer The SampleBuffer with the samples to be written.
+ * @param scratchBuffer Buffer with the same size as buffer, used when only part of the block is written.
+ * @param skipHeadFrames Number of frames to ignore before writing to outputSource.
+ * @param currentFrame Start frame of the block in buffer.
+ */
+void writeOutput(SampleSource outputSource, SampleSource silenceSource, SampleBuffer buffer,
+  SampleBuffer scratchBuffer, unsigned long skipHeadFrames, unsigned long currentFrame) {
+  unsigned long framesSkiped = silenceSource->numSamplesProcessed / buffer->numChannels;
+  unsigned long framesProcessed = framesSkiped + outputSource->numSamplesProcessed / buffer->numChannels;
+  unsigned long nextBlockStart = framesProcessed + buffer->blocksize;
+
+  if(framesProcessed != currentFrame) {
+    logInternalError("framesProcessed (%lu) != currentFrame (%lu)", framesProcessed, currentFrame);
+  }
+  //Cut the delay at the start
+  if(        nextBlockStart <= skipHeadFrames ) {
+    // Cutting away the whole block. nothing is written to the outputSource
+    silenceSource->writeSampleBlock(silenceSource, buffer);
+  } else if(framesProcessed <  skipHeadFrames
+         &&                    skipHeadFrames < nextBlockStart) {
+    SampleBuffer sourceBuffer = scratchBuffer;//blocksize < skipHeadFrames
+    unsigned long skippedFrames = skipHeadFrames - framesProcessed;
+    unsigned long soundFrames = nextBlockStart - skipHeadFrames;
+
+    // Cutting away start part of the block.
+    sourceBuffer->blocksize = skippedFrames;
+    sampleBufferCopyAndMapChannelsWithOffset(sourceBuffer, 0, buffer, 0, sourceBuffer->blocksize);
+    silenceSource->writeSampleBlock(silenceSource, sourceBuffer);
+
+    // Writing remaining end part of the block.
+    sourceBuffer->blocksize = soundFrames;
+    sampleBufferCopyAndMapChannelsWithOffset(sourceBuffer, 0, buffer, skippedFrames, sourceBuffer->blocksize);
+    outputSource->writeSampleBlock(outputSource, sourceBuffer);
+  } else { //                  skipHeadFrames <=  framesProcessed
+    // Normal case: Nothing more to cut. The whole block shall be written.
+    outputSource->writeSampleBlock(outputSource, buffer);
+  }
+}
+
+/**
+ * Called periodically while rendering
+ * @param userData User data given to the render state
+ * @param numFrames Number of frames processed so far
+ */
+typedef void (*RenderProgressFunc)(void* userData, unsigned long numFrames);
+
+// State shared by the processing loops. When running with --pipeline, the input
+// and output sources are handled on their own threads, and each queue has
+// exactly one producer and one consumer. Otherwise the queues are NULL and the
+// sample buffers are used instead.
+typedef struct {
+  SampleSource inputSource;
+  SampleSource silentSampleInput;
+  SampleSource outputSource;
+  SampleSource silentSampleOutput;
+  MidiSequence midiSequence;
+  PluginChain pluginChain;
+  // Parameter changes to apply while processing, may be NULL. Not owned by the
+  // render state, and must have been prepared for the plugin chain.
+  PluginAutomation automation;
+  SampleBuffer inputSampleBuffer;
+  SampleBuffer outputSampleBuffer;
+  // Used by readInput() and writeOutput() for partial blocks. With --pipeline,
+  // each one is only used by the thread for its source.
+  SampleBuffer inputScratchBuffer;
+  SampleBuffer outputScratchBuffer;
+  LinkedList midiEventsForBlock;
+  SampleBufferQueue inputQueue;
+  SampleBufferQueue outputQueue;
+  // Input blocks shared with the alternative chains of --plugin, with this
+  // state's chain as the first consumer. NULL when only one chain is rendered.
+  SampleBufferQueue fanOutQueue;
+  TaskTimer inputTimer;
+  TaskTimer outputTimer;
+  unsigned long tailTimeInFrames;
+  unsigned long processingDelayInFrames;
+  unsigned long maxTimeInFrames;
+  unsigned long startFrame;
+  // Context of the thread which started the render, worker threads must use it too
+  EngineContext engineContext;
+  // Called about once per second of processed audio, may be NULL
+  RenderProgressFunc progressFunc;
+  void* progressUserData;
+  unsigned long nextProgressFrame;
+} RenderStateMembers;
+typedef RenderStateMembers* RenderState;
+
+/**
+ * Create the render state for a plugin chain, along with the buffers, queues,
+ * and timers which it owns. The sources must be set by the caller before
+ * rendering.
+ * @param pluginChain Initialized plugin chain
+ * @param pipelineQueueSize Number of blocks per queue, or 0 to process serially
+ * @return Initialized RenderState
+ */
+static RenderState _newRenderState(PluginChain pluginChain, unsigned long pipelineQueueSize) {
+  RenderState state = (RenderState)malloc(sizeof(RenderStateMembers));
+  state->inputSource = NULL;
+  state->silentSampleInput = NULL;
+  state->outputSource = NULL;
+  state->silentSampleOutput = NULL;
+  state->midiSequence = NULL;
+  state->pluginChain = pluginChain;
+  state->automation = NULL;
+  state->inputSampleBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  state->outputSampleBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  state->inputScratchBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  state->outputScratchBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  state->midiEventsForBlock = newLinkedListWithCapacity(MIDI_EVENTS_PER_BLOCK_CAPACITY);
+  state->inputQueue = NULL;
+  state->outputQueue = NULL;
+  state->fanOutQueue = NULL;
+  state->inputTimer = newTaskTimerWithCString(PROGRAM_NAME, "Input Source");
+  state->outputTimer = newTaskTimerWithCString(PROGRAM_NAME, "Output Source");
+  state->tailTimeInFrames = 0;
+  state->processingDelayInFrames = 0;
+  state->maxTimeInFrames = 0;
+  state->startFrame = 0;
+  state->engineContext = getCurrentEngineContext();
+  state->progressFunc = NULL;
+  state->progressUserData = NULL;
+  state->nextProgressFrame = 0;
+
+  if(pipelineQueueSize > 0) {
+    logDebug("Pipelined processing with %lu blocks per queue", pipelineQueueSize);
+    state->inputQueue = newSampleBufferQueue(pipelineQueueSize, getNumChannels(), getBlocksize());
+    state->outputQueue = newSampleBufferQueue(pipelineQueueSize, getNumChannels(), getBlocksize());
+  }
+  return state;
+}
+
+static void _freeRenderState(RenderState self) {
+  freeSampleBuffer(self->inputSampleBuffer);
+  freeSampleBuffer(self->outputSampleBuffer);
+  freeSampleBuffer(self->inputScratchBuffer);
+  freeSampleBuffer(self->outputScratchBuffer);
+  freeLinkedList(self->midiEventsForBlock);
+  freeSampleBufferQueue(self->inputQueue);
+  freeSampleBufferQueue(self->outputQueue);
+  freeTaskTimer(self->inputTimer);
+  freeTaskTimer(self->outputTimer);
+  free(self);
+}
+
+static void _reportProgress(RenderState state, AudioClock audioClock) {
+  if(state->progressFunc != NULL && audioClock->currentFrame >= state->nextProgressFrame) {
+    state->progressFunc(state->progressUserData, audioClock->currentFrame - state->startFrame);
+    state->nextProgressFrame = audioClock->currentFrame + (unsigned long)getSampleRate();
+  }
+}
+
+static void _processAudioForBlock(RenderState state, AudioClock audioClock,
+  SampleBuffer inBuffer, SampleBuffer outBuffer) {
+  LinkedList midiEvents = state->midiSequence != NULL ? state->midiEventsForBlock : NULL;
+  if(state->automation != NULL) {
+    // Automation may split the block, so the events are sent with each piece
+    pluginAutomationProcessAudio(state->automation, state->pluginChain, audioClock, midiEvents, inBuffer, outBuffer);
+  }
+  else {
+    if(midiEvents != NULL) {
+      pluginChainProcessMidi(state->pluginChain, midiEvents);
+    }
+    pluginChainProcessAudio(state->pluginChain, inBuffer, outBuffer);
+  }
+}
+
+static void* _pipelineReaderThread(void* userData) {
+  RenderState state = (RenderState)userData;
+  SampleBuffer buffer;
+  boolByte moreInput = true;
+
+  engineContextMakeCurrent(state->engineContext);
+
+  // When a MIDI sequence is given it decides when processing stops, so keep
+  // producing blocks until the processing thread cancels the queue.
+  while(moreInput || state->midiSequence != NULL) {
+    buffer = sampleBufferQueueAcquireWrite(state->inputQueue);
+    if(buffer == NULL) {
+      break;
+    }
+    buffer->blocksize = getBlocksize();
+    taskTimerStart(state->inputTimer);
+    moreInput = readInput(state->inputSource, state->silentSampleInput, buffer, state->inputScratchBuffer,
+      state->tailTimeInFrames);
+    taskTimerStop(state->inputTimer);
+    sampleBufferQueueCommitWrite(state->inputQueue, (boolByte)!moreInput);
+    // Everything after the first block should run without touching the heap
+    allocationCounterStart();
+  }
+
+  allocationCounterStop();
+  return NULL;
+}
+
+static void* _pipelineWriterThread(void* userData) {
+  RenderState state = (RenderState)userData;
+  SampleBuffer buffer;
+  boolByte isLastBlock = false;
+  unsigned long currentFrame = state->startFrame;
+
+  engineContextMakeCurrent(state->engineContext);
+
+  while(!isLastBlock) {
+    buffer = sampleBufferQueueAcquireRead(state->outputQueue, &isLastBlock);
+    if(buffer == NULL) {
+      break;
+    }
+    taskTimerStart(state->outputTimer);
+    writeOutput(state->outputSource, state->silentSampleOutput, buffer, state->outputScratchBuffer,
+      state->processingDelayInFrames, currentFrame);
+    taskTimerStop(state->outputTimer);
+    currentFrame += buffer->blocksize;
+    sampleBufferQueueCommitRead(state->outputQueue);
+    allocationCounterStart();
+  }
+
+  allocationCounterStop();
+  return NULL;
+}
+
+/**
+ * Run the main processing loop with the input and output sources on their own
+ * threads. The plugin chain is processed on the calling thread, so that plugins
+ * always see the same thread as during initialization.
+ * @param stages Pipeline state
+ * @param audioClock Clock to advance after each processed block
+ * @return False if the threads could not be started, in which case nothing has
+ * been read from the input source.
+ */
+static boolByte _runPipelinedProcessingLoop(RenderState state, AudioClock audioClock) {
+  Thread readerThread = newThread(_pipelineReaderThread, state);
+  Thread writerThread = newThread(_pipelineWriterThread, state);
+  SampleBuffer inputBuffer;
+  SampleBuffer outputBuffer;
+  boolByte finishedReading = false;
+
+  if(!threadStart(writerThread)) {
+    freeThread(readerThread);
+    freeThread(writerThread);
+    return false;
+  }
+  if(!threadStart(readerThread)) {
+    sampleBufferQueueCancel(state->outputQueue);
+    freeThread(readerThread);
+    freeThread(writerThread);
+    return false;
+  }
+
+  while(!finishedReading) {
+    inputBuffer = sampleBufferQueueAcquireRead(state->inputQueue, &finishedReading);
+    if(inputBuffer == NULL) {
+      logInternalError("Input queue was cancelled during processing");
+      break;
+    }
+
+    if(state->midiSequence != NULL) {
+      // MIDI source overrides the value set to finishedReading by the input source
+      finishedReading = _readMidiForBlock(state->midiSequence, state->midiEventsForBlock, audioClock->currentFrame);
+    }
+
+    if(state->maxTimeInFrames > 0 && audioClock->currentFrame >= state->maxTimeInFrames) {
+      logInfo("Maximum time reached, stopping processing after this block");
+      finishedReading = true;
+    }
+
+    outputBuffer = sampleBufferQueueAcquireWrite(state->outputQueue);
+    if(outputBuffer == NULL) {
+      logInternalError("Output queue was cancelled during processing");
+      break;
+    }
+    // Buffers are recycled, and the final block of a previous run may have been shorter
+    outputBuffer->blocksize = getBlocksize();
+    _processAudioForBlock(state, audioClock, inputBuffer, outputBuffer);
+    if(finishedReading) {
+      outputBuffer->blocksize = inputBuffer->blocksize;//The input buffer size has been adjusted.
+      logDebug("Using buffer size of %d for final block", outputBuffer->blocksize);
+    }
+    sampleBufferQueueCommitWrite(state->outputQueue, finishedReading);
+    advanceAudioClock(audioClock, outputBuffer->blocksize);
+    sampleBufferQueueCommitRead(state->inputQueue);
+    _reportProgress(state, audioClock);
+    allocationCounterStart();
+  }
+  allocationCounterStop();
+
+  // The reader may still be waiting for a free slot if processing was stopped
+  // by the MIDI source or --max-time
+  sampleBufferQueueCancel(state->inputQueue);
+  threadJoin(readerThread);
+  threadJoin(writerThread);
+  freeThread(readerThread);
+  freeThread(writerThread);
+  return true;
+}
+
+/**
+ * Run the main processing loop, reading, processing, and writing each block
+ * in turn on the calling thread.
+ * @param state Render state
+ * @param audioClock Clock to advance after each processed block
+ */
+static void _runProcessingLoop(RenderState state, AudioClock audioClock) {
+  SampleBuffer inputSampleBuffer = state->inputSampleBuffer;
+  SampleBuffer outputSampleBuffer = state->outputSampleBuffer;
+  boolByte finishedReading = false;
+
+  while(!finishedReading) {
+    taskTimerStart(state->inputTimer);
+    finishedReading = (boolByte)!readInput(state->inputSource, state->silentSampleInput, inputSampleBuffer,
+      state->inputScratchBuffer, state->tailTimeInFrames);
+
+    // TODO: For streaming MIDI, we would need to read in events from source here
+    if(state->midiSequence != NULL) {
+      // MIDI source overrides the value set to finishedReading by the input source
+      finishedReading = _readMidiForBlock(state->midiSequence, state->midiEventsForBlock, audioClock->currentFrame);
+    }
+    taskTimerStop(state->inputTimer);
+
+    if(state->maxTimeInFrames > 0 && audioClock->currentFrame >= state->maxTimeInFrames) {
+      logInfo("Maximum time reached, stopping processing after this block");
+      finishedReading = true;
+    }
+
+    _processAudioForBlock(state, audioClock, inputSampleBuffer, outputSampleBuffer);
+
+    taskTimerStart(state->outputTimer);
+    if(finishedReading) {
+      outputSampleBuffer->blocksize = inputSampleBuffer->blocksize;//The input buffer size has been adjusted.
+      logDebug("Using buffer size of %d for final block", outputSampleBuffer->blocksize);
+    }
+    writeOutput(state->outputSource, state->silentSampleOutput, outputSampleBuffer, state->outputScratchBuffer,
+      state->processingDelayInFrames, audioClock->currentFrame);
+    taskTimerStop(state->outputTimer);
+    advanceAudioClock(audioClock, outputSampleBuffer->blocksize);
+    _reportProgress(state, audioClock);
+    // Plugins and sources may allocate lazily while handling the first block,
+    // but every block after that should run without touching the heap
+    allocationCounterStart();
+  }
+  allocationCounterStop();
+}
+
+/**
+ * Run the main processing loop while sharing each input block with the
+ * alternative chains of --plugin. Blocks are read into the fan-out queue on
+ * the calling thread, which then processes them with its own chain just like
+ * the other consumers of the queue.
+ * @param state Render state
+ * @param audioClock Clock to advance after each processed block
+ */
+static void _runFanOutProcessingLoop(RenderState state, AudioClock audioClock) {
+  SampleBuffer inputSampleBuffer;
+  SampleBuffer outputSampleBuffer = state->outputSampleBuffer;
+  boolByte finishedReading = false;
+
+  while(!finishedReading) {
+    inputSampleBuffer = sampleBufferQueueAcquireWrite(state->fanOutQueue);
+    if(inputSampleBuffer == NULL) {
+      logInternalError("Fan-out queue was cancelled during processing");
+      break;
+    }
+    // Buffers are recycled, and the final block of a previous run may have been shorter
+    inputSampleBuffer->blocksize = getBlocksize();
+    taskTimerStart(state->inputTimer);
+    finishedReading = (boolByte)!readInput(state->inputSource, state->silentSampleInput, inputSampleBuffer,
+      state->inputScratchBuffer, state->tailTimeInFrames);
+    taskTimerStop(state->inputTimer);
+
+    if(state->maxTimeInFrames > 0 && audioClock->currentFrame >= state->maxTimeInFrames) {
+      logInfo("Maximum time reached, stopping processing after this block");
+      finishedReading = true;
+    }
+    sampleBufferQueueCommitWrite(state->fanOutQueue, finishedReading);
+    // This is the block which was just written, since the calling thread is
+    // always the first consumer to read it
+    sampleBufferQueueAcquireRead(state->fanOutQueue, NULL);
+
+    _processAudioForBlock(state, audioClock, inputSampleBuffer, outputSampleBuffer);
+
+    taskTimerStart(state->outputTimer);
+    if(finishedReading) {
+      outputSampleBuffer->blocksize = inputSampleBuffer->blocksize;
+      logDebug("Using buffer size of %d for final block", outputSampleBuffer->blocksize);
+    }
+    writeOutput(state->outputSource, state->silentSampleOutput, outputSampleBuffer, state->outputScratchBuffer,
+      state->processingDelayInFrames, audioClock->currentFrame);
+    taskTimerStop(state->outputTimer);
+    advanceAudioClock(audioClock, outputSampleBuffer->blocksize);
+    sampleBufferQueueCommitRead(state->fanOutQueue);
+    _reportProgress(state, audioClock);
+    allocationCounterStart();
+  }
+  allocationCounterStop();
+}
+
+/**
+ * Render the input source through the plugin chain to the output source, and
+ * close both sources afterwards. The sample buffers are restored to the full
+ * blocksize so that the state can be used again for the next batch job.
+ * @param state Render state
+ * @param audioClock Clock to advance after each processed block
+ */
+static void _render(RenderState state, AudioClock audioClock) {
+  boolByte finished = false;
+
+  state->silentSampleInput = sampleSourceFactory(NULL);
+  state->silentSampleOutput = sampleSourceFactory(NULL);
+  state->startFrame = audioClock->currentFrame;
+  state->nextProgressFrame = audioClock->currentFrame + (unsigned long)getSampleRate();
+  state->inputSampleBuffer->blocksize = getBlocksize();
+  state->outputSampleBuffer->blocksize = getBlocksize();
+  if(state->automation != NULL) {
+    pluginAutomationRewind(state->automation);
+  }
+  if(state->pluginChain->realtimeScheduler != NULL) {
+    realtimeSchedulerRestart(state->pluginChain->realtimeScheduler);
+  }
+
+  if(state->fanOutQueue != NULL) {
+    _runFanOutProcessingLoop(state, audioClock);
+    finished = true;
+  }
+  else if(state->inputQueue != NULL) {
+    sampleBufferQueueReset(state->inputQueue);
+    sampleBufferQueueReset(state->outputQueue);
+    finished = _runPipelinedProcessingLoop(state, audioClock);
+    if(!finished) {
+      logWarn("Could not start pipeline threads, falling back to serial processing");
+      freeSampleBufferQueue(state->inputQueue);
+      freeSampleBufferQueue(state->outputQueue);
+      state->inputQueue = NULL;
+      state->outputQueue = NULL;
+    }
+  }
+  if(!finished) {
+    _runProcessingLoop(state, audioClock);
+  }
+
+  // Close file handles for input/output sources
+  state->silentSampleInput->closeSampleSource(state->silentSampleInput);
+  state->silentSampleOutput->closeSampleSource(state->silentSampleOutput);
+  state->inputSource->closeSampleSource(state->inputSource);
+  state->outputSource->closeSampleSource(state->outputSource);
+  freeSampleSource(state->silentSampleInput);
+  freeSampleSource(state->silentSampleOutput);
+  state->silentSampleInput = NULL;
+  state->silentSampleOutput = NULL;
+}
+
+// Everything needed to render one segment with --segments. The first segment
+// is rendered on the main thread with the main plugin chain and written
+// straight to the output source. The others are rendered on their own threads,
+// each in its own engine context, and kept in a temporary file until the
+// segments before them have been written.
+typedef struct {
+  RenderSegment segment;
+  // Settings to copy into the context of a worker thread
+  AudioSettings audioSettings;
+  LogLevel logLevel;
+  boolByte useColor;
+  CharString inputSourceName;
+  CharString pluginArgument;
+  CharString pluginSearchRoot;
+  LinkedList parameters;
+  unsigned long tailTimeInFrames;
+  unsigned long processingDelayInFrames;
+
+  PluginChain pluginChain;
+  SampleSource inputSource;
+  // Either the output source, or NULL to write to outputFile
+  SampleSource outputSource;
+  FILE* outputFile;
+  unsigned long numSamplesRead;
+  TaskTimer inputTimer;
+  TaskTimer outputTimer;
+  ReturnCodes result;
+} SegmentRenderJobMembers;
+typedef SegmentRenderJobMembers* SegmentRenderJob;
+
+static boolByte _seekInputSource(SampleSource inputSource, SampleBuffer buffer, unsigned long frame) {
+  if(frame == 0) {
+    return true;
+  }
+  if(inputSource->seekSampleSource != NULL && inputSource->seekSampleSource(inputSource, frame)) {
+    return true;
+  }
+
+  logDebug("Input source can't seek, skipping %lu frames", frame);
+  while(frame > 0) {
+    buffer->blocksize = frame < getBlocksize() ? frame : getBlocksize();
+    if(!inputSource->readSampleBlock(inputSource, buffer)) {
+      return false;
+    }
+    frame -= buffer->blocksize;
+  }
+  return true;
+}
+
+static boolByte _writeSegmentBlock(SegmentRenderJob job, SampleBuffer buffer, SampleBuffer scratchBuffer,
+  unsigned long blockStartFrame, unsigned long skipHeadFrames) {
+  unsigned long skippedFrames;
+  unsigned int i;
+
+  if(blockStartFrame + buffer->blocksize <= skipHeadFrames) {
+    return true;
+  }
+  else if(blockStartFrame < skipHeadFrames) {
+    skippedFrames = skipHeadFrames - blockStartFrame;
+    scratchBuffer->blocksize = buffer->blocksize - skippedFrames;
+    sampleBufferCopyAndMapChannelsWithOffset(scratchBuffer, 0, buffer, skippedFrames, scratchBuffer->blocksize);
+    buffer = scratchBuffer;
+  }
+
+  if(job->outputSource != NULL) {
+    return job->outputSource->writeSampleBlock(job->outputSource, buffer);
+  }
+
+  // Blocks are stored as the frame count followed by each channel in turn
+  if(fwrite(&buffer->blocksize, sizeof(unsigned long), 1, job->outputFile) != 1) {
+    return false;
+  }
+  for(i = 0; i < buffer->numChannels; i++) {
+    if(fwrite(buffer->samples[i], sizeof(Sample), buffer->blocksize, job->outputFile) != buffer->blocksize) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Render a segment of the input source with the plugin chain of the job. The
+ * input source must be open, and is read from the start of the segment's
+ * warm-up. Output for the warm-up and the processing delay of the chain is
+ * thrown away, so each segment except the last one writes exactly its own
+ * length. The last one also renders the tail.
+ * @param job Segment to render
+ * @param audioClock Clock for the job's plugin chain
+ * @return RETURN_CODE_SUCCESS, or RETURN_CODE_IO_ERROR if the input could not
+ * be read or the output could not be written
+ */
+static ReturnCodes _renderSegment(SegmentRenderJob job, AudioClock audioClock) {
+  RenderSegment segment = job->segment;
+  SampleSource silenceSource = sampleSourceFactory(NULL);
+  SampleBuffer inputBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer outputBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer scratchBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  const unsigned long readStartFrame = segment->startFrame - segment->warmupFrames;
+  const unsigned long skipHeadFrames = segment->warmupFrames + job->processingDelayInFrames;
+  const unsigned long framesToRender = skipHeadFrames + segment->numFrames;
+  unsigned long framesRendered = 0;
+  ReturnCodes result = RETURN_CODE_SUCCESS;
+  boolByte finished = false;
+
+  if(!_seekInputSource(job->inputSource, inputBuffer, readStartFrame)) {
+    logError("Could not find frame %lu in input source", readStartFrame);
+    finished = true;
+    result = RETURN_CODE_IO_ERROR;
+  }
+  audioClock->currentFrame = readStartFrame;
+
+  while(!finished) {
+    taskTimerStart(job->inputTimer);
+    inputBuffer->blocksize = getBlocksize();
+    if(segment->isLast) {
+      finished = (boolByte)!readInput(job->inputSource, silenceSource, inputBuffer, scratchBuffer,
+        job->tailTimeInFrames);
+    }
+    else {
+      if(framesToRender - framesRendered < inputBuffer->blocksize) {
+        inputBuffer->blocksize = framesToRender - framesRendered;
+      }
+      // The processing delay may reach past the end of the input, in which case
+      // the rest of the block is left silent
+      sampleBufferClear(inputBuffer);
+      scratchBuffer->blocksize = inputBuffer->blocksize;
+      job->inputSource->readSampleBlock(job->inputSource, inputBuffer);
+      inputBuffer->blocksize = scratchBuffer->blocksize;
+      finished = (boolByte)(framesRendered + inputBuffer->blocksize >= framesToRender);
+    }
+    taskTimerStop(job->inputTimer);
+
+    outputBuffer->blocksize = getBlocksize();
+    pluginChainProcessAudio(job->pluginChain, inputBuffer, outputBuffer);
+    outputBuffer->blocksize = inputBuffer->blocksize;
+
+    taskTimerStart(job->outputTimer);
+    if(!_writeSegmentBlock(job, outputBuffer, scratchBuffer, framesRendered, skipHeadFrames)) {
+      logError("Could not write rendered segment");
+      finished = true;
+      result = RETURN_CODE_IO_ERROR;
+    }
+    taskTimerStop(job->outputTimer);
+    framesRendered += outputBuffer->blocksize;
+    advanceAudioClock(audioClock, outputBuffer->blocksize);
+  }
+
+  freeSampleSource(silenceSource);
+  freeSampleBuffer(inputBuffer);
+  freeSampleBuffer(outputBuffer);
+  freeSampleBuffer(scratchBuffer);
+  return result;
+}
+
+static void* _segmentRenderThread(void* userData) {
+  SegmentRenderJob job = (SegmentRenderJob)userData;
+  EngineContext engineContext = newEngineContext();
+
+  *(engineContext->audioSettings) = *(job->audioSettings);
+  engineContext->eventLogger->logLevel = job->logLevel;
+  engineContext->eventLogger->useColor = job->useColor;
+  engineContextMakeCurrent(engineContext);
+
+  job->pluginChain = engineContext->pluginChain;
+  job->result = buildPluginChain(job->pluginChain, job->pluginArgument, job->pluginSearchRoot);
+  if(job->result == RETURN_CODE_SUCCESS) {
+    job->result = pluginChainInitialize(job->pluginChain);
+  }
+  if(job->result == RETURN_CODE_SUCCESS && job->parameters != NULL &&
+    !pluginChainSetParameters(job->pluginChain, job->parameters)) {
+    job->result = RETURN_CODE_INVALID_ARGUMENT;
+  }
+  if(job->result == RETURN_CODE_SUCCESS) {
+    job->inputSource = sampleSourceFactory(job->inputSourceName);
+    job->result = setupInputSource(job->inputSource);
+  }
+  if(job->result == RETURN_CODE_SUCCESS) {
+    job->outputFile = tmpfile();
+    if(job->outputFile == NULL) {
+      logError("Could not create temporary file for segment output");
+      job->result = RETURN_CODE_IO_ERROR;
+    }
+  }
+
+  if(job->result == RETURN_CODE_SUCCESS) {
+    pluginChainPrepareForProcessing(job->pluginChain);
+    job->result = _renderSegment(job, engineContext->audioClock);
+  }
+
+  if(job->inputSource != NULL) {
+    job->numSamplesRead = job->inputSource->numSamplesProcessed;
+    if(job->inputSource->openedAs != SAMPLE_SOURCE_OPEN_NOT_OPENED) {
+      job->inputSource->closeSampleSource(job->inputSource);
+    }
+    freeSampleSource(job->inputSource);
+    job->inputSource = NULL;
+  }
+  engineContextMakeCurrent(NULL);
+  freeEngineContext(engineContext);
+  return NULL;
+}
+
+static boolByte _appendSegmentOutput(SegmentRenderJob job, SampleSource outputSource, SampleBuffer buffer) {
+  unsigned long numFrames;
+  unsigned int i;
+
+  rewind(job->outputFile);
+  while(fread(&numFrames, sizeof(unsigned long), 1, job->outputFile) == 1) {
+    if(numFrames > getBlocksize()) {
+      return false;
+    }
+    buffer->blocksize = numFrames;
+    for(i = 0; i < buffer->numChannels; i++) {
+      if(fread(buffer->samples[i], sizeof(Sample), numFrames, job->outputFile) != numFrames) {
+        return false;
+      }
+    }
+    outputSource->writeSampleBlock(outputSource, buffer);
+  }
+  return true;
+}
+
+/**
+ * Render the input source in segments, see RenderSegment.h. The first segment
+ * uses the plugin chain and timers of the render state, and the other ones
+ * load their own chain with the same arguments and parameters. Both sources
+ * are closed afterwards.
+ * @param state Render state, with the input source opened at its first frame
+ * @param audioClock Clock for the main plugin chain
+ * @param segments List of RenderSegment objects
+ * @param pluginArgument Plugin chain argument string
+ * @param pluginSearchRoot Plugin search root
+ * @param parameters Parameters to set on each chain, may be NULL
+ * @return RETURN_CODE_SUCCESS, or the first error which occurred in any segment
+ */
+static ReturnCodes _renderSegments(RenderState state, AudioClock audioClock, LinkedList segments,
+  const CharString pluginArgument, const CharString pluginSearchRoot, const LinkedList parameters) {
+  const int numSegments = linkedListLength(segments);
+  // Settings may belong to the process or to the context of mrsWatsonRender()
+  EngineContext currentContext = getCurrentEngineContext();
+  AudioSettings audioSettings = currentContext != NULL ? currentContext->audioSettings : audioSettingsInstance;
+  EventLogger eventLogger = currentContext != NULL ? currentContext->eventLogger : eventLoggerInstance;
+  SegmentRenderJob* jobs = (SegmentRenderJob*)malloc(sizeof(SegmentRenderJob) * numSegments);
+  Thread* threads = (Thread*)malloc(sizeof(Thread) * numSegments);
+  LinkedListIterator iterator = segments;
+  SegmentRenderJob job;
+  ReturnCodes result;
+  int i;
+
+  for(i = 0; i < numSegments; i++) {
+    job = (SegmentRenderJob)malloc(sizeof(SegmentRenderJobMembers));
+    job->segment = (RenderSegment)iterator->item;
+    job->audioSettings = audioSettings;
+    job->logLevel = eventLogger->logLevel;
+    job->useColor = eventLogger->useColor;
+    job->inputSourceName = state->inputSource->sourceName;
+    job->pluginArgument = pluginArgument;
+    job->pluginSearchRoot = pluginSearchRoot;
+    job->parameters = parameters;
+    job->tailTimeInFrames = state->tailTimeInFrames;
+    job->processingDelayInFrames = state->processingDelayInFrames;
+    job->pluginChain = NULL;
+    job->inputSource = NULL;
+    job->outputSource = NULL;
+    job->outputFile = NULL;
+    job->numSamplesRead = 0;
+    // The first segment's time is reported with the render state's timers,
+    // the others overlap with it
+    job->inputTimer = i > 0 ? newTaskTimerWithCString(PROGRAM_NAME, "Input Source") : state->inputTimer;
+    job->outputTimer = i > 0 ? newTaskTimerWithCString(PROGRAM_NAME, "Output Source") : state->outputTimer;
+    job->result = RETURN_CODE_SUCCESS;
+    jobs[i] = job;
+    threads[i] = NULL;
+    iterator = (LinkedListIterator)iterator->nextItem;
+  }
+
+  for(i = 1; i < numSegments; i++) {
+    logDebug("Starting segment %d at frame %lu", i + 1, jobs[i]->segment->startFrame);
+    threads[i] = newThread(_segmentRenderThread, jobs[i]);
+    if(!threadStart(threads[i])) {
+      logError("Could not start thread for segment %d", i + 1);
+      jobs[i]->result = RETURN_CODE_INTERNAL_ERROR;
+      freeThread(threads[i]);
+      threads[i] = NULL;
+    }
+  }
+
+  // The main chain was initialized on this thread, so it renders the first segment here
+  jobs[0]->pluginChain = state->pluginChain;
+  jobs[0]->inputSource = state->inputSource;
+  jobs[0]->outputSource = state->outputSource;
+  result = _renderSegment(jobs[0], audioClock);
+
+  for(i = 1; i < numSegments; i++) {
+    if(threads[i] != NULL) {
+      threadJoin(threads[i]);
+      freeThread(threads[i]);
+    }
+    // Includes the warm-up, so this counts some frames more than once
+    state->inputSource->numSamplesProcessed += jobs[i]->numSamplesRead;
+    if(result == RETURN_CODE_SUCCESS) {
+      result = jobs[i]->result;
+      if(result == RETURN_CODE_SUCCESS &&
+        !_appendSegmentOutput(jobs[i], state->outputSource, state->outputSampleBuffer)) {
+        logError("Could not read output of segment %d", i + 1);
+        result = RETURN_CODE_IO_ERROR;
+      }
+    }
+    if(jobs[i]->outputFile != NULL) {
+      fclose(jobs[i]->outputFile);
+    }
+  }
+
+  state->inputSource->closeSampleSource(state->inputSource);
+  state->outputSource->closeSampleSource(state->outputSource);
+  state->outputSampleBuffer->blocksize = getBlocksize();
+  for(i = 0; i < numSegments; i++) {
+    if(i > 0) {
+      freeTaskTimer(jobs[i]->inputTimer);
+      freeTaskTimer(jobs[i]->outputTimer);
+    }
+    free(jobs[i]);
+  }
+  free(jobs);
+  free(threads);
+  return result;
+}
+
+static void _printRenderSummary(SampleSource inputSource, SampleSource outputSource,
+  MidiSource midiSource, MidiSequence midiSequence) {
+  if(midiSequence != NULL) {
+    logInfo("Read %ld MIDI events from %s",
+      midiSequence->numMidiEventsProcessed,
+      midiSource->sourceName->data);
+  }
+  else {
+    logInfo("Read %ld frames from %s",
+      inputSource->numSamplesProcessed / getNumChannels(),
+      inputSource->sourceName->data);
+  }
+  logInfo("Wrote %ld frames to %s",
+    outputSource->numSamplesProcessed / getNumChannels(),
+    outputSource->sourceName->data);
+}
+
+static void _printThroughput(const char* description, unsigned long numFrames, double elapsedTimeInMs) {
+  double audioTimeInMs = 1000.0 * numFrames / getSampleRate();
+  if(elapsedTimeInMs > 0.0) {
+    logInfo("%s: %lu frames (%.2f seconds) rendered in %.0fms, %.1fx realtime",
+      description, numFrames, audioTimeInMs / 1000.0, elapsedTimeInMs, audioTimeInMs / elapsedTimeInMs);
+  }
+  else {
+    logInfo("%s: %lu frames (%.2f seconds) rendered in <1ms", description, numFrames, audioTimeInMs / 1000.0);
+  }
+}
+
+// One of the alternative chains given with --plugin "chain1|chain2", except
+// for the first one, which is rendered by the main thread. Each job loads its
+// chain in its own engine context on its own thread, and reads the blocks which
+// the main thread puts into the fan-out queue.
+typedef struct {
+  unsigned int consumer;
+  // Settings to copy into the context of the worker thread
+  AudioSettings audioSettings;
+  LogLevel logLevel;
+  boolByte useColor;
+  CharString pluginArgument;
+  CharString pluginSearchRoot;
+  LinkedList parameters;
+  CharString outputSourceName;
+  unsigned long userTailTimeInMs;
+  SampleBufferQueue inputQueue;
+
+  // Set by the worker thread before isReady
+  unsigned long tailTimeInFrames;
+  unsigned long processingDelayInFrames;
+  ReturnCodes result;
+  volatile boolByte isReady;
+  // Notified when isReady has been set
+  ThreadSignal readySignal;
+  // Set by the worker thread when it has finished
+  unsigned long numFramesWritten;
+  double processingTimeInMs;
+} FanOutJobMembers;
+typedef FanOutJobMembers* FanOutJob;
+
+static void _renderFanOutJob(FanOutJob job, PluginChain pluginChain, SampleSource outputSource,
+  AudioClock audioClock) {
+  SampleSource silenceSource = sampleSourceFactory(NULL);
+  SampleBuffer outputBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer scratchBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer inputBuffer;
+  boolByte isLastBlock = false;
+
+  while(!isLastBlock) {
+    inputBuffer = sampleBufferQueueAcquireReadForConsumer(job->inputQueue, job->consumer, &isLastBlock);
+    if(inputBuffer == NULL) {
+      break;
+    }
+    outputBuffer->blocksize = getBlocksize();
+    pluginChainProcessAudio(pluginChain, inputBuffer, outputBuffer);
+    outputBuffer->blocksize = inputBuffer->blocksize;
+    writeOutput(outputSource, silenceSource, outputBuffer, scratchBuffer, job->processingDelayInFrames,
+      audioClock->currentFrame);
+    advanceAudioClock(audioClock, outputBuffer->blocksize);
+    sampleBufferQueueCommitReadForConsumer(job->inputQueue, job->consumer);
+  }
+
+  job->numFramesWritten = outputSource->numSamplesProcessed / getNumChannels();
+  silenceSource->closeSampleSource(silenceSource);
+  freeSampleSource(silenceSource);
+  freeSampleBuffer(outputBuffer);
+  freeSampleBuffer(scratchBuffer);
+}
+
+static void* _fanOutRenderThread(void* userData) {
+  FanOutJob job = (FanOutJob)userData;
+  EngineContext engineContext = newEngineContext();
+  SampleSource outputSource = NULL;
+  TaskTimer renderTimer = newTaskTimerWithCString(PROGRAM_NAME, "Fan-out");
+  unsigned long tailTimeInMs;
+
+  *(engineContext->audioSettings) = *(job->audioSettings);
+  engineContext->eventLogger->logLevel = job->logLevel;
+  engineContext->eventLogger->useColor = job->useColor;
+  engineContextMakeCurrent(engineContext);
+
+  job->result = buildPluginChain(engineContext->pluginChain, job->pluginArgument, job->pluginSearchRoot);
+  if(job->result == RETURN_CODE_SUCCESS) {
+    job->result = pluginChainInitialize(engineContext->pluginChain);
+  }
+  if(job->result == RETURN_CODE_SUCCESS && job->parameters != NULL &&
+    !pluginChainSetParameters(engineContext->pluginChain, job->parameters)) {
+    job->result = RETURN_CODE_INVALID_ARGUMENT;
+  }
+  if(job->result == RETURN_CODE_SUCCESS) {
+    outputSource = sampleSourceFactory(job->outputSourceName);
+    job->result = setupOutputSource(outputSource);
+  }
+  if(job->result == RETURN_CODE_SUCCESS) {
+    job->processingDelayInFrames = pluginChainGetProcessingDelay(engineContext->pluginChain);
+    tailTimeInMs = job->userTailTimeInMs + pluginChainGetMaximumTailTimeInMs(engineContext->pluginChain);
+    job->tailTimeInFrames = (unsigned long)(tailTimeInMs * getSampleRate()) / 1000l + job->processingDelayInFrames;
+    pluginChainPrepareForProcessing(engineContext->pluginChain);
+  }
+  threadMemoryBarrier();
+  job->isReady = true;
+  threadSignalNotify(job->readySignal);
+
+  if(job->result == RETURN_CODE_SUCCESS) {
+    taskTimerStart(renderTimer);
+    _renderFanOutJob(job, engineContext->pluginChain, outputSource, engineContext->audioClock);
+    job->processingTimeInMs = taskTimerStop(renderTimer);
+  }
+
+  if(outputSource != NULL) {
+    if(outputSource->openedAs != SAMPLE_SOURCE_OPEN_NOT_OPENED) {
+      outputSource->closeSampleSource(outputSource);
+    }
+    freeSampleSource(outputSource);
+  }
+  freeTaskTimer(renderTimer);
+  engineContextMakeCurrent(NULL);
+  freeEngineContext(engineContext);
+  return NULL;
+}
+
+/**
+ * Load and start rendering the alternative chains of --plugin, each on its
+ * own thread. This waits until all chains have been initialized, so that the
+ * longest tail time is known before the main thread starts reading input.
+ * @param chainArguments List of plugin chain argument strings. The first one
+ * is skipped, since it is rendered by the main thread.
+ * @param outputSourceNames List of output source names, one for each chain
+ * @param inputQueue Queue which the main thread will read the input into, with
+ * one consumer for each chain including the main one
+ * @param pluginSearchRoot Plugin search root
+ * @param parameters Parameters to set on each chain, may be NULL
+ * @param userTailTimeInMs Tail time given on the command line
+ * @param outThreads Set to an array with the thread of each job
+ * @param outJobs Set to an array with each job
+ * @return RETURN_CODE_SUCCESS, or the first error which occurred while loading
+ * any chain, in which case the queue has been cancelled
+ */
+static ReturnCodes _startFanOutJobs(LinkedList chainArguments, LinkedList outputSourceNames,
+  SampleBufferQueue inputQueue, const CharString pluginSearchRoot, const LinkedList parameters,
+  unsigned long userTailTimeInMs, Thread** outThreads, FanOutJob** outJobs) {
+  const int numJobs = linkedListLength(chainArguments) - 1;
+  // Settings may belong to the process or to the context of mrsWatsonRender()
+  EngineContext currentContext = getCurrentEngineContext();
+  AudioSettings audioSettings = currentContext != NULL ? currentContext->audioSettings : audioSettingsInstance;
+  EventLogger eventLogger = currentContext != NULL ? currentContext->eventLogger : eventLoggerInstance;
+  FanOutJob* jobs = (FanOutJob*)malloc(sizeof(FanOutJob) * numJobs);
+  Thread* threads = (Thread*)malloc(sizeof(Thread) * numJobs);
+  LinkedListIterator chainIterator = (LinkedListIterator)chainArguments->nextItem;
+  LinkedListIterator outputIterator = (LinkedListIterator)outputSourceNames->nextItem;
+  ReturnCodes result = RETURN_CODE_SUCCESS;
+  FanOutJob job;
+  unsigned long generation;
+  int i;
+
+  for(i = 0; i < numJobs; i++) {
+    job = (FanOutJob)malloc(sizeof(FanOutJobMembers));
+    job->consumer = (unsigned int)(i + 1);
+    job->audioSettings = audioSettings;
+    job->logLevel = eventLogger->logLevel;
+    job->useColor = eventLogger->useColor;
+    job->pluginArgument = (CharString)chainIterator->item;
+    job->pluginSearchRoot = pluginSearchRoot;
+    job->parameters = parameters;
+    job->outputSourceName = (CharString)outputIterator->item;
+    job->userTailTimeInMs = userTailTimeInMs;
+    job->inputQueue = inputQueue;
+    job->tailTimeInFrames = 0;
+    job->processingDelayInFrames = 0;
+    job->result = RETURN_CODE_SUCCESS;
+    job->isReady = false;
+    job->readySignal = newThreadSignal();
+    job->numFramesWritten = 0;
+    job->processingTimeInMs = 0.0;
+    jobs[i] = job;
+
+    logInfo("Starting chain %d with '%s'", i + 2, job->pluginArgument->data);
+    threads[i] = newThread(_fanOutRenderThread, job);
+    if(!threadStart(threads[i])) {
+      logError("Could not start thread for chain %d", i + 2);
+      job->result = RETURN_CODE_INTERNAL_ERROR;
+      job->isReady = true;
+      freeThread(threads[i]);
+      threads[i] = NULL;
+    }
+    chainIterator = (LinkedListIterator)chainIterator->nextItem;
+    outputIterator = (LinkedListIterator)outputIterator->nextItem;
+  }
+
+  for(i = 0; i < numJobs; i++) {
+    for(;;) {
+      generation = threadSignalGetGeneration(jobs[i]->readySignal);
+      if(jobs[i]->isReady) {
+        break;
+      }
+      threadSignalWait(jobs[i]->readySignal, generation);
+    }
+    threadMemoryBarrier();
+    if(jobs[i]->result != RETURN_CODE_SUCCESS && result == RETURN_CODE_SUCCESS) {
+      logError("Chain %d could not be loaded", i + 2);
+      result = jobs[i]->result;
+    }
+  }
+  if(result != RETURN_CODE_SUCCESS) {
+    sampleBufferQueueCancel(inputQueue);
+  }
+
+  *outThreads = threads;
+  *outJobs = jobs;
+  return result;
+}
+
+/**
+ * Wait for the alternative chains of --plugin to finish and free the jobs.
+ * @param threads Threads returned by _startFanOutJobs()
+ * @param jobs Jobs returned by _startFanOutJobs()
+ * @param numJobs Number of jobs
+ * @return RETURN_CODE_SUCCESS, or the first error which occurred in any chain
+ */
+static ReturnCodes _finishFanOutJobs(Thread* threads, FanOutJob* jobs, int numJobs) {
+  ReturnCodes result = RETURN_CODE_SUCCESS;
+  CharString description = newCharString();
+  int i;
+
+  for(i = 0; i < numJobs; i++) {
+    if(threads[i] != NULL) {
+      threadJoin(threads[i]);
+      freeThread(threads[i]);
+    }
+    if(jobs[i]->result == RETURN_CODE_SUCCESS) {
+      logInfo("Wrote %ld frames to %s", jobs[i]->numFramesWritten, jobs[i]->outputSourceName->data);
+      snprintf(description->data, description->capacity, "Chain %d", i + 2);
+      _printThroughput(description->data, jobs[i]->numFramesWritten, jobs[i]->processingTimeInMs);
+    }
+    else if(result == RETURN_CODE_SUCCESS) {
+      result = jobs[i]->result;
+    }
+    freeThreadSignal(jobs[i]->readySignal);
+    free(jobs[i]);
+  }
+  free(threads);
+  free(jobs);
+  freeCharString(description);
+  return result;
+}
+
+/**
+ * Render a job from a batch manifest with the already initialized plugin
+ * chain. The chain is reset to the state it had after initialization before
+ * processing starts. Jobs must use the same sample rate and channel count as
+ * the first one, since the chain is not initialized again.
+ * @param state Render state, the sources are replaced with those of the job
+ * @param audioClock Clock to reset and advance during processing
+ * @param job Job to render
+ * @param parameters Parameters to apply after resetting the chain, may be NULL
+ * @param outNumFrames Set to the number of frames written to the output source
+ * @return RETURN_CODE_SUCCESS if the job was rendered. If the plugin chain
+ * could not be reset, RETURN_CODE_INVALID_PLUGIN_CHAIN is returned and no
+ * further jobs should be rendered.
+ */
+static ReturnCodes _renderBatchJob(RenderState state, AudioClock audioClock, const BatchJob job,
+  const LinkedList parameters, unsigned long* outNumFrames) {
+  const double sampleRate = getSampleRate();
+  const unsigned int numChannels = getNumChannels();
+  SampleSource inputSource = NULL;
+  SampleSource outputSource = NULL;
+  MidiSource midiSource = NULL;
+  MidiSequence midiSequence = NULL;
+  ReturnCodes result = RETURN_CODE_SUCCESS;
+  boolByte inputSourceOpened = false;
+
+  *outNumFrames = 0;
+  if(!pluginChainReset(state->pluginChain)) {
+    logError("Could not reset plugin chain");
+    return RETURN_CODE_INVALID_PLUGIN_CHAIN;
+  }
+  if(parameters != NULL && !pluginChainSetParameters(state->pluginChain, parameters)) {
+    logError("Could not set parameters after resetting plugin chain");
+    return RETURN_CODE_INVALID_PLUGIN_CHAIN;
+  }
+
+  inputSource = sampleSourceFactory(job->inputSource);
+  outputSource = sampleSourceFactory(job->outputSource);
+  if(!charStringIsEmpty(job->midiSource)) {
+    midiSource = newMidiSource(guessMidiSourceType(job->midiSource), job->midiSource);
+  }
+
+  if(inputSource != NULL && inputSource->sampleSourceType == SAMPLE_SOURCE_TYPE_SILENCE &&
+    state->pluginChain->plugins[0]->pluginType != PLUGIN_TYPE_INSTRUMENT) {
+    logError("Plugin chain contains only effects, but no input source was supplied");
+    result = RETURN_CODE_MISSING_REQUIRED_OPTION;
+  }
+  else if((result = setupInputSource(inputSource)) != RETURN_CODE_SUCCESS) {
+    logError("Input source could not be opened, skipping job");
+  }
+  else {
+    inputSourceOpened = true;
+    if(getSampleRate() != sampleRate || getNumChannels() != numChannels) {
+      logError("Input source '%s' does not match the plugin chain's sample rate of %.0fHz and %d channels, skipping job",
+        inputSource->sourceName->data, sampleRate, numChannels);
+      setSampleRate(sampleRate);
+      setNumChannels(numChannels);
+      result = RETURN_CODE_INVALID_ARGUMENT;
+    }
+    else if((result = setupMidiSource(midiSource, &midiSequence)) != RETURN_CODE_SUCCESS) {
+      logError("MIDI source could not be opened, skipping job");
+    }
+    else if((result = setupOutputSource(outputSource)) != RETURN_CODE_SUCCESS) {
+      logError("Output source could not be opened, skipping job");
+    }
+  }
+
+  if(result == RETURN_CODE_SUCCESS) {
+    audioClockReset(audioClock);
+    pluginChainPrepareForProcessing(state->pluginChain);
+    state->inputSource = inputSource;
+    state->outputSource = outputSource;
+    state->midiSequence = midiSequence;
+    _render(state, audioClock);
+    _printRenderSummary(inputSource, outputSource, midiSource, midiSequence);
+    *outNumFrames = outputSource->numSamplesProcessed / getNumChannels();
+    state->inputSource = NULL;
+    state->outputSource = NULL;
+    state->midiSequence = NULL;
+  }
+  else if(inputSourceOpened) {
+    inputSource->closeSampleSource(inputSource);
+  }
+
+  if(inputSource != NULL) {
+    freeSampleSource(inputSource);
+  }
+  if(outputSource != NULL) {
+    freeSampleSource(outputSource);
+  }
+  if(midiSource != NULL) {
+    freeMidiSource(midiSource);
+  }
+  if(midiSequence != NULL) {
+    freeMidiSequence(midiSequence);
+  }
+  return result;
+}
+
+static ReturnCodes _applyDaemonJobSettings(ProgramOptions options) {
+  if(options->options[OPTION_BLOCKSIZE]->enabled) {
+    setBlocksize((const unsigned long)programOptionsGetNumber(options, OPTION_BLOCKSIZE));
+  }
+  if(options->options[OPTION_CHANNELS]->enabled) {
+    setNumChannels((const unsigned long)programOptionsGetNumber(options, OPTION_CHANNELS));
+  }
+  if(options->options[OPTION_SAMPLE_RATE]->enabled) {
+    setSampleRate(programOptionsGetNumber(options, OPTION_SAMPLE_RATE));
+  }
+  if(options->options[OPTION_COMPRESSION_LEVEL]->enabled) {
+    if(!setCompressionLevel((const unsigned int)programOptionsGetNumber(options, OPTION_COMPRESSION_LEVEL))) {
+      return RETURN_CODE_INVALID_ARGUMENT;
+    }
+  }
+  if(options->options[OPTION_TEMPO]->enabled) {
+    setTempo(programOptionsGetNumber(options, OPTION_TEMPO));
+  }
+  if(options->options[OPTION_TIME_SIGNATURE]->enabled) {
+    if(!setTimeSignatureFromString(programOptionsGetString(options, OPTION_TIME_SIGNATURE))) {
+      return RETURN_CODE_INVALID_ARGUMENT;
+    }
+  }
+  if(options->options[OPTION_OUTPUT_FORMAT]->enabled) {
+    if(!setOutputSampleFormatFromString(programOptionsGetString(options, OPTION_OUTPUT_FORMAT))) {
+      return RETURN_CODE_INVALID_ARGUMENT;
+    }
+  }
+  if(options->options[OPTION_HUGE_PAGES]->enabled) {
+    setUseHugePages(true);
+  }
+  if(options->options[OPTION_WRITE_BEHIND]->enabled) {
+    setUseWriteBehind(true);
+  }
+  if(options->options[OPTION_PIPELINE]->enabled && programOptionsGetNumber(options, OPTION_PIPELINE) < 1.0f) {
+    logError("Pipeline queue size must be at least 1 block");
+    return RETURN_CODE_INVALID_ARGUMENT;
+  }
+  return RETURN_CODE_SUCCESS;
+}
+
+/**
+ * Find a loaded plugin chain which was built with the same arguments and
+ * settings as those of the current job, or load a new one and add it to the
+ * pool. Must be called with the process-wide context current, after the job's
+ * settings have been applied to it.
+ * @param pool Pool of loaded chains
+ * @param job Job to send the load status to
+ * @param pluginArgument Plugin chain argument string
+ * @param pluginSearchRoot Plugin search root
+ * @param outResult Set to the reason for failure if the chain could not be loaded
+ * @return Context of the chain, which has been made current on the calling
+ * thread, or NULL if the chain could not be loaded
+ */
+static EngineContext _getPooledEngineContext(PluginChainPool pool, RenderDaemonJob job,
+  const CharString pluginArgument, const CharString pluginSearchRoot, ReturnCodes* outResult) {
+  const AudioSettings jobSettings = audioSettingsInstance;
+  CharString key = newCharStringWithCapacity(kCharStringLengthLong);
+  EngineContext engineContext;
+  TaskTimer loadTimer;
+
+  // The chain is initialized with the sample rate, channel count, and
+  // blocksize, so it can't be reused for jobs where any of these differ
+  snprintf(key->data, key->capacity, "%s|%s|%.0f|%u|%lu", pluginArgument->data, pluginSearchRoot->data,
+    getSampleRate(), getNumChannels(), getBlocksize());
+
+  engineContext = pluginChainPoolGet(pool, key);
+  if(engineContext != NULL) {
+    engineContextMakeCurrent(engineContext);
+    *(engineContext->audioSettings) = *jobSettings;
+    if(pluginChainReset(engineContext->pluginChain)) {
+      logInfo("Reusing loaded plugin chain");
+      renderDaemonJobSendMessage(job, "chain warm 0");
+      freeCharString(key);
+      return engineContext;
+    }
+    logWarn("Could not reset plugin chain, loading it again");
+    engineContextMakeCurrent(NULL);
+    pluginChainPoolRemove(pool, key);
+  }
+
+  loadTimer = newTaskTimerWithCString(PROGRAM_NAME, "Plugin Chain Load");
+  taskTimerStart(loadTimer);
+  engineContext = newEngineContext();
+  *(engineContext->audioSettings) = *jobSettings;
+  engineContext->eventLogger->logLevel = eventLoggerInstance->logLevel;
+  engineContext->eventLogger->useColor = eventLoggerInstance->useColor;
+  engineContextMakeCurrent(engineContext);
+
+  *outResult = buildPluginChain(engineContext->pluginChain, pluginArgument, pluginSearchRoot);
+  if(*outResult == RETURN_CODE_SUCCESS) {
+    *outResult = pluginChainInitialize(engineContext->pluginChain);
+  }
+  if(*outResult == RETURN_CODE_SUCCESS) {
+    pluginChainPoolAdd(pool, key, engineContext);
+    renderDaemonJobSendMessage(job, "chain cold %.0f", taskTimerStop(loadTimer));
+  }
+  else {
+    engineContextMakeCurrent(NULL);
+    freeEngineContext(engineContext);
+    engineContext = NULL;
+  }
+
+  freeTaskTimer(loadTimer);
+  freeCharString(key);
+  return engineContext;
+}
+
+static void _sendDaemonJobProgress(void* userData, unsigned long numFrames) {
+  renderDaemonJobSendMessage((RenderDaemonJob)userData, "progress %lu %.2f", numFrames, numFrames / getSampleRate());
+}
+
+static void _sendDaemonJobTaskTime(void* item, void* userData) {
+  TaskTimer taskTimer = (TaskTimer)item;
+  renderDaemonJobSendMessage((RenderDaemonJob)userData, "timer %.3f %s %s",
+    taskTimer->totalTaskTime, taskTimer->component->data, taskTimer->subcomponent->data);
+}
+
+/**
+ * Render a job received by the daemon. The job's settings are applied to the
+ * process-wide context, and the input source is opened there so that its
+ * sample rate is known before looking up a chain in the pool. Processing then
+ * happens in the context of the pooled chain.
+ * @param job Job to render. Status messages are sent to its connection, ending
+ * with the "done" message.
+ * @param pool Pool of loaded chains
+ * @param defaultPluginSearchRoot Search root used when the job doesn't give one
+ * @return Result of the job
+ */
+static ReturnCodes _renderDaemonJob(RenderDaemonJob job, PluginChainPool pool, const CharString defaultPluginSearchRoot) {
+  ProgramOptions options;
+  ReturnCodes result = RETURN_CODE_SUCCESS;
+  const char* errorMessage = NULL;
+  SampleSource inputSource = NULL;
+  SampleSource outputSource = NULL;
+  MidiSource midiSource = NULL;
+  MidiSequence midiSequence = NULL;
+  PluginAutomation automation = NULL;
+  EngineContext engineContext = NULL;
+  PluginChain pluginChain;
+  RenderState renderState;
+  LinkedList taskTimerList;
+  TaskTimer jobTimer = newTaskTimerWithCString(PROGRAM_NAME, "Daemon Job");
+  boolByte inputSourceOpened = false;
+  unsigned long maxTimeInMs = 0;
+  unsigned long tailTimeInMs = 0;
+  unsigned long tailTimeInFrames;
+  unsigned long processingDelayInFrames;
+  unsigned long pipelineQueueSize = 0;
+  unsigned long numFrames = 0;
+  unsigned int i;
+
+  taskTimerStart(jobTimer);
+  logInfo("Received job: %s", job->request->data);
+
+  // Each job starts with the default settings, not those of the previous job
+  engineContextMakeCurrent(NULL);
+  initAudioSettings();
+  options = newMrsWatsonOptions();
+  if(!programOptionsParseArgs(options, job->argc, job->argv)) {
+    result = RETURN_CODE_INVALID_ARGUMENT;
+    errorMessage = "Invalid arguments";
+  }
+  else if(!options->options[OPTION_PLUGIN]->enabled) {
+    result = RETURN_CODE_MISSING_REQUIRED_OPTION;
+    errorMessage = "No plugin chain given";
+  }
+  else if(!options->options[OPTION_OUTPUT_SOURCE]->enabled) {
+    result = RETURN_CODE_MISSING_REQUIRED_OPTION;
+    errorMessage = "No output source given";
+  }
+  else if((result = _applyDaemonJobSettings(options)) != RETURN_CODE_SUCCESS) {
+    errorMessage = "Invalid settings";
+  }
+  else {
+    if(options->options[OPTION_MAX_TIME]->enabled) {
+      maxTimeInMs = (unsigned long)programOptionsGetNumber(options, OPTION_MAX_TIME);
+    }
+    if(options->options[OPTION_TAIL_TIME]->enabled) {
+      tailTimeInMs = (unsigned long)programOptionsGetNumber(options, OPTION_TAIL_TIME);
+    }
+    if(options->options[OPTION_PIPELINE]->enabled) {
+      pipelineQueueSize = (unsigned long)programOptionsGetNumber(options, OPTION_PIPELINE);
+    }
 
-  return RETURN_CODE_SUCCESS;
-}
+    inputSource = sampleSourceFactory(options->options[OPTION_INPUT_SOURCE]->enabled ?
+      programOptionsGetString(options, OPTION_INPUT_SOURCE) : NULL);
+    outputSource = sampleSourceFactory(programOptionsGetString(options, OPTION_OUTPUT_SOURCE));
+    if(options->options[OPTION_MIDI_SOURCE]->enabled) {
+      midiSource = newMidiSource(guessMidiSourceType(programOptionsGetString(options, OPTION_MIDI_SOURCE)),
+        programOptionsGetString(options, OPTION_MIDI_SOURCE));
+    }
 
-static ReturnCodes setupOutputSource(SampleSource outputSource) {
-  if(outputSource == NULL) {
-    return RETURN_CODE_INVALID_ARGUMENT;
-  }
-  if(!outputSource->openSampleSource(outputSource, SAMPLE_SOURCE_OPEN_WRITE)) {
-    logError("Output source '%s' could not be opened", outputSource->sourceName->data);
-    return RETURN_CODE_IO_ERROR;
+    if(options->options[OPTION_AUTOMATION]->enabled &&
+      (automation = newPluginAutomationWithFile(programOptionsGetString(options, OPTION_AUTOMATION))) == NULL) {
+      result = RETURN_CODE_INVALID_ARGUMENT;
+      errorMessage = "Automation file could not be read";
+    }
+    else if((result = setupInputSource(inputSource)) != RETURN_CODE_SUCCESS) {
+      errorMessage = "Input source could not be opened";
+    }
+    else {
+      inputSourceOpened = true;
+      if((result = setupMidiSource(midiSource, &midiSequence)) != RETURN_CODE_SUCCESS) {
+        errorMessage = "MIDI source could not be opened";
+      }
+    }
   }
 
-  return RETURN_CODE_SUCCESS;
-}
+  if(result == RETURN_CODE_SUCCESS) {
+    engineContext = _getPooledEngineContext(pool, job, programOptionsGetString(options, OPTION_PLUGIN),
+      options->options[OPTION_PLUGIN_ROOT]->enabled ?
+        programOptionsGetString(options, OPTION_PLUGIN_ROOT) : defaultPluginSearchRoot,
+      &result);
+    if(engineContext == NULL) {
+      errorMessage = "Plugin chain could not be loaded";
+    }
+  }
 
-static void _processMidiMetaEvent(void* item, void* userData) {
-  MidiEvent midiEvent = (MidiEvent)item;
-  boolByte *finishedReading = (boolByte*)userData;
-  if(midiEvent->eventType == MIDI_TYPE_META) {
-    switch(midiEvent->status) {
-      case MIDI_META_TYPE_TEMPO:
-        setTempoFromMidiBytes(midiEvent->extraData);
-        break;
-      case MIDI_META_TYPE_TIME_SIGNATURE:
-        if(!setTimeSignatureFromMidiBytes(midiEvent->extraData)) {
-          logWarn("Could not set time signature from MIDI file");
-        }
-        break;
-      case MIDI_META_TYPE_TRACK_END:
-        logInfo("Reached end of MIDI track");
-        *finishedReading = true;
-        break;
-      default:
-        logWarn("Don't know how to process MIDI meta event of type 0x%x", midiEvent->status);
-        break;
+  if(result == RETURN_CODE_SUCCESS) {
+    pluginChain = engineContext->pluginChain;
+    if(inputSource->sampleSourceType == SAMPLE_SOURCE_TYPE_SILENCE) {
+      if(pluginChain->plugins[0]->pluginType != PLUGIN_TYPE_INSTRUMENT) {
+        result = RETURN_CODE_MISSING_REQUIRED_OPTION;
+        errorMessage = "Plugin chain contains only effects, but no input source was supplied";
+      }
+      else if(midiSource == NULL && maxTimeInMs == 0) {
+        result = RETURN_CODE_MISSING_REQUIRED_OPTION;
+        errorMessage = "No valid input source or maximum time, don't know when to stop processing";
+      }
+    }
+    if(result == RETURN_CODE_SUCCESS && options->options[OPTION_PARAMETER]->enabled &&
+      !pluginChainSetParameters(pluginChain, programOptionsGetList(options, OPTION_PARAMETER))) {
+      result = RETURN_CODE_INVALID_ARGUMENT;
+      errorMessage = "Could not set parameters";
+    }
+    if(result == RETURN_CODE_SUCCESS && automation != NULL && !pluginAutomationPrepare(automation, pluginChain)) {
+      result = RETURN_CODE_INVALID_ARGUMENT;
+      errorMessage = "Automation does not match the plugin chain";
+    }
+    if(result == RETURN_CODE_SUCCESS && (result = setupOutputSource(outputSource)) != RETURN_CODE_SUCCESS) {
+      errorMessage = "Output source could not be opened";
     }
   }
-}
 
-/**
- *  Reads from inputSource.
- *
- * @param inputSource The SampleSource to read from.
- * @param silenceSource The source from where to read silentTailFrames silent tail frames.
- * @param buffer The SampleBuffer to which the samples will be written.
- * @param silentTailFrames Number of silent samples that will be provided at the end of inputSource.
- * @return True if there is more input to read.
- */
-boolByte readInput(SampleSource inputSource, SampleSource silenceSource, SampleBuffer buffer, unsigned long silentTailFrames) {
-  unsigned long framesRead;
-  unsigned long bufferSize = buffer->blocksize;
+  if(result == RETURN_CODE_SUCCESS) {
+    processingDelayInFrames = pluginChainGetProcessingDelay(pluginChain);
+    tailTimeInMs += pluginChainGetMaximumTailTimeInMs(pluginChain);
+    tailTimeInFrames = (unsigned long)(tailTimeInMs * getSampleRate()) / 1000l + processingDelayInFrames;
+    audioClockReset(engineContext->audioClock);
+    pluginChainSetMidiEventSplitting(pluginChain, options->options[OPTION_SPLIT_MIDI_EVENTS]->enabled);
+    pluginChainPrepareForProcessing(pluginChain);
+    // The chain's timers keep adding up over all jobs rendered with it
+    for(i = 0; i < pluginChain->numPlugins; i++) {
+      pluginChain->audioTimers[i]->totalTaskTime = 0.0;
+      pluginChain->midiTimers[i]->totalTaskTime = 0.0;
+    }
 
-  inputSource->readSampleBlock(inputSource, buffer);
-  framesRead = buffer->blocksize; //buffer->blocksize tells how man frames have been read from inputSource, during tail period it will be 0.
+    renderState = _newRenderState(pluginChain, pipelineQueueSize);
+    renderState->inputSource = inputSource;
+    renderState->outputSource = outputSource;
+    renderState->midiSequence = midiSequence;
+    renderState->automation = automation;
+    renderState->tailTimeInFrames = tailTimeInFrames;
+    renderState->processingDelayInFrames = processingDelayInFrames;
+    renderState->maxTimeInFrames = (unsigned long)(maxTimeInMs * getSampleRate()) / 1000l;
+    renderState->progressFunc = _sendDaemonJobProgress;
+    renderState->progressUserData = job;
+    _render(renderState, engineContext->audioClock);
+    inputSourceOpened = false;
+    _printRenderSummary(inputSource, outputSource, midiSource, midiSequence);
+    numFrames = outputSource->numSamplesProcessed / getNumChannels();
 
-  //We are not done until framesRead < bufferSize and silenceSource->numSamplesProcessed/buffer->numChannels == silentTailFrames
-  if(framesRead == bufferSize) {
-    return true; // more input
-  } else if(framesRead < bufferSize) {
-    unsigned long remainingSilence = silentTailFrames - silenceSource->numSamplesProcessed/buffer->numChannels; // 0 < remainingSilence <= silentTailFrames
-    unsigned long numberOfFrames = remainingSilence < (bufferSize - framesRead) ? remainingSilence : (bufferSize - framesRead); // 0 < numberOfFrames <= bufferSize
-    SampleBuffer silenceBuffer = newSampleBuffer(buffer->numChannels, numberOfFrames);
-    if(!silenceSource->readSampleBlock(silenceSource, silenceBuffer)) {
-      logInternalError("SilentSource does not behave correct.");
+    taskTimerList = newLinkedList();
+    linkedListAppend(taskTimerList, renderState->inputTimer);
+    linkedListAppend(taskTimerList, renderState->outputTimer);
+    for(i = 0; i < pluginChain->numPlugins; i++) {
+      linkedListAppend(taskTimerList, pluginChain->audioTimers[i]);
+      linkedListAppend(taskTimerList, pluginChain->midiTimers[i]);
     }
-    buffer->blocksize = framesRead + numberOfFrames; // 0 < buffer->blocksize <= bufferSize.
-    sampleBufferCopyAndMapChannelsWithOffset(buffer, framesRead, silenceBuffer, 0, numberOfFrames);
-    freeSampleBuffer(silenceBuffer);
-    return (boolByte)(silenceSource->numSamplesProcessed/buffer->numChannels != silentTailFrames);
-  } else {
-    logInternalError("framesRead > bufferSize");
-    return false; //stop here.
+    linkedListForeach(taskTimerList, _sendDaemonJobTaskTime, job);
+    freeLinkedList(taskTimerList);
+    _freeRenderState(renderState);
+  }
+
+  if(inputSourceOpened) {
+    inputSource->closeSampleSource(inputSource);
   }
+  engineContextMakeCurrent(NULL);
+  taskTimerStop(jobTimer);
+  if(errorMessage != NULL) {
+    logError("%s, skipping job", errorMessage);
+    renderDaemonJobSendMessage(job, "error %s", errorMessage);
+  }
+  else {
+    _printThroughput("Job", numFrames, jobTimer->totalTaskTime);
+  }
+  renderDaemonJobSendMessage(job, "done %d %lu %.0f", result, numFrames, jobTimer->totalTaskTime);
+
+  freeTaskTimer(jobTimer);
+  if(inputSource != NULL) {
+    freeSampleSource(inputSource);
+  }
+  if(outputSource != NULL) {
+    freeSampleSource(outputSource);
+  }
+  if(midiSource != NULL) {
+    freeMidiSource(midiSource);
+  }
+  if(midiSequence != NULL) {
+    freeMidiSequence(midiSequence);
+  }
+  freePluginAutomation(automation);
+  freeProgramOptions(options);
+  return result;
 }
 
 /**
- *  Writes to outputSource.
- *
- * @param outputSource The SampleSource to write to.
- * @param silenceSource The source from where to write skipHeadFrames frames.
- * @param buffer The SampleBuffer with the samples to be written.
- * @param skipHeadFrames Number of frames to ignore before writing to outputSource.
+ * Listen for render jobs until a client sends the shutdown request.
+ * @param socketPath Path of the Unix domain socket to listen on
+ * @param defaultPluginSearchRoot Search root used for jobs which don't give one
+ * @return RETURN_CODE_SUCCESS if the daemon was shut down by a client
  */
-void writeOutput(SampleSource outputSource, SampleSource silenceSource, SampleBuffer buffer, unsigned long skipHeadFrames) {
-  unsigned long framesSkiped = silenceSource->numSamplesProcessed / buffer->numChannels;
-  unsigned long framesProcessed = framesSkiped + outputSource->numSamplesProcessed / buffer->numChannels;
-  unsigned long nextBlockStart = framesProcessed + buffer->blocksize;
-
-  if(framesProcessed != getAudioClock()->currentFrame) {
-    logInternalError("framesProcessed (%lu) != getAudioClock()->currentFrame (%lu)", framesProcessed, getAudioClock()->currentFrame);
+static ReturnCodes _runRenderDaemon(const CharString socketPath, const CharString defaultPluginSearchRoot) {
+  RenderDaemon daemon = newRenderDaemon(socketPath);
+  PluginChainPool pool;
+  RenderDaemonJob job;
+  ReturnCodes result = RETURN_CODE_IO_ERROR;
+  unsigned long numJobs = 0;
+
+  if(!renderDaemonListen(daemon)) {
+    freeRenderDaemon(daemon);
+    return RETURN_CODE_IO_ERROR;
   }
-  //Cut the delay at the start
-  if(        nextBlockStart <= skipHeadFrames ) {
-    // Cutting away the whole block. nothing is written to the outputSource
-    silenceSource->writeSampleBlock(silenceSource, buffer);
-  } else if(framesProcessed <  skipHeadFrames
-         &&                    skipHeadFrames < nextBlockStart) {
-    SampleBuffer sourceBuffer = newSampleBuffer(buffer->numChannels, buffer->blocksize);//blocksize < skipHeadFrames
-    unsigned long skippedFrames = skipHeadFrames - framesProcessed;
-    unsigned long soundFrames = nextBlockStart - skipHeadFrames;
-
-    // Cutting away start part of the block.
-    sourceBuffer->blocksize = skippedFrames;
-    sampleBufferCopyAndMapChannelsWithOffset(sourceBuffer, 0, buffer, 0, sourceBuffer->blocksize);
-    silenceSource->writeSampleBlock(silenceSource, sourceBuffer);
-
-    // Writing remaining end part of the block.
-    sourceBuffer->blocksize = soundFrames;
-    sampleBufferCopyAndMapChannelsWithOffset(sourceBuffer, 0, buffer, skippedFrames, sourceBuffer->blocksize);
-    outputSource->writeSampleBlock(outputSource, sourceBuffer);
 
-    freeSampleBuffer(sourceBuffer);
-  } else { //                  skipHeadFrames <=  framesProcessed
-    // Normal case: Nothing more to cut. The whole block shall be written.
-    outputSource->writeSampleBlock(outputSource, buffer);
+  pool = newPluginChainPool(DEFAULT_PLUGIN_CHAIN_POOL_SIZE);
+  logInfo("Listening for render jobs on '%s'", socketPath->data);
+  while((job = renderDaemonAcceptJob(daemon)) != NULL) {
+    if(renderDaemonJobIsShutdownRequest(job)) {
+      logInfo("Received shutdown request");
+      renderDaemonJobSendMessage(job, "done %d 0 0", RETURN_CODE_SUCCESS);
+      freeRenderDaemonJob(job);
+      result = RETURN_CODE_SUCCESS;
+      break;
+    }
+    _renderDaemonJob(job, pool, defaultPluginSearchRoot);
+    freeRenderDaemonJob(job);
+    numJobs++;
   }
+
+  logInfo("Handled %lu jobs, unloading plugins", numJobs);
+  freePluginChainPool(pool);
+  freeRenderDaemon(daemon);
+  return result;
 }
 
 int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
@@ -296,17 +1793,44 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
   unsigned long tailTimeInMs = 0;
   unsigned long tailTimeInFrames = 0;
   unsigned long processingDelayInFrames;
+  unsigned long expectedOutputFrames;
+  unsigned long pipelineQueueSize = 0;
+  unsigned int numSegments = 0;
+  unsigned long segmentOverlapInFrames;
+  LinkedList renderSegments = NULL;
+  RenderState renderState = NULL;
+  LinkedList batchJobs = NULL;
+  LinkedListIterator batchIterator;
+  BatchJob batchJob;
+  LinkedList parameters = NULL;
+  PluginAutomation automation = NULL;
+  LinkedListIterator tapIterator;
+  CharString tapArgument;
+  PluginTap tap;
+  CharString pluginArgument;
+  LinkedList chainArguments = NULL;
+  LinkedList outputSourceNames = NULL;
+  SampleBufferQueue fanOutQueue = NULL;
+  Thread* fanOutThreads = NULL;
+  FanOutJob* fanOutJobs = NULL;
+  int numFanOutJobs = 0;
+  unsigned long userTailTimeInMs;
+  TaskTimer batchTimer = NULL;
+  CharString batchJobName = NULL;
+  ReturnCodes batchResult = RETURN_CODE_SUCCESS;
+  unsigned long batchJobFrames;
+  unsigned long batchTotalFrames = 0;
+  int batchJobNumber;
+  int numBatchJobsFailed = 0;
+  float initialTempo;
+  unsigned short initialBeatsPerMeasure;
+  unsigned short initialNoteValue;
   ProgramOptions programOptions;
   ProgramOption option;
   Plugin headPlugin;
-  SampleBuffer inputSampleBuffer = NULL;
-  SampleBuffer outputSampleBuffer = NULL;
-  TaskTimer initTimer, totalTimer, inputTimer, outputTimer = NULL;
+  TaskTimer initTimer, totalTimer;
   LinkedList taskTimerList = NULL;
   CharString totalTimeString = NULL;
-  boolByte finishedReading = false;
-  SampleSource silentSampleInput;
-  SampleSource silentSampleOutput;
   unsigned int i;
 
   initTimer = newTaskTimerWithCString(PROGRAM_NAME, "Initialization");
@@ -420,12 +1944,33 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
     option = programOptions->options[i];
     if(option->enabled) {
       switch(option->index) {
+        case OPTION_AUTOMATION:
+          automation = newPluginAutomationWithFile(programOptionsGetString(programOptions, OPTION_AUTOMATION));
+          if(automation == NULL) {
+            return RETURN_CODE_INVALID_ARGUMENT;
+          }
+          break;
+        case OPTION_BATCH:
+          batchJobs = batchManifestReadJobs(programOptionsGetString(programOptions, OPTION_BATCH));
+          if(batchJobs == NULL) {
+            return RETURN_CODE_INVALID_ARGUMENT;
+          }
+          else if(linkedListLength(batchJobs) == 0) {
+            logError("Batch manifest does not contain any jobs");
+            return RETURN_CODE_INVALID_ARGUMENT;
+          }
+          break;
         case OPTION_BLOCKSIZE:
           setBlocksize((const unsigned long)programOptionsGetNumber(programOptions, OPTION_BLOCKSIZE));
           break;
         case OPTION_CHANNELS:
           setNumChannels((const unsigned long)programOptionsGetNumber(programOptions, OPTION_CHANNELS));
           break;
+        case OPTION_COMPRESSION_LEVEL:
+          if(!setCompressionLevel((const unsigned int)programOptionsGetNumber(programOptions, OPTION_COMPRESSION_LEVEL))) {
+            return RETURN_CODE_INVALID_ARGUMENT;
+          }
+          break;
         case OPTION_DISPLAY_INFO:
           shouldDisplayPluginInfo = true;
           break;
@@ -441,8 +1986,24 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
             programOptions, OPTION_MIDI_SOURCE)),
             programOptionsGetString(programOptions, OPTION_MIDI_SOURCE));
           break;
+        case OPTION_OUTPUT_FORMAT:
+          if(!setOutputSampleFormatFromString(programOptionsGetString(programOptions, OPTION_OUTPUT_FORMAT))) {
+            return RETURN_CODE_INVALID_ARGUMENT;
+          }
+          break;
         case OPTION_OUTPUT_SOURCE:
-          outputSource = sampleSourceFactory(programOptionsGetString(programOptions, OPTION_OUTPUT_SOURCE));
+          // With several outputs, the source is created below along with the plugin chains
+          if(strchr(programOptionsGetString(programOptions, OPTION_OUTPUT_SOURCE)->data,
+            CHAIN_STRING_ALTERNATIVE_SEPARATOR) == NULL) {
+            outputSource = sampleSourceFactory(programOptionsGetString(programOptions, OPTION_OUTPUT_SOURCE));
+          }
+          break;
+        case OPTION_PIPELINE:
+          pipelineQueueSize = (unsigned long)programOptionsGetNumber(programOptions, OPTION_PIPELINE);
+          if(pipelineQueueSize == 0) {
+            logError("Pipeline queue size must be at least 1 block");
+            return RETURN_CODE_INVALID_ARGUMENT;
+          }
           break;
         case OPTION_PLUGIN_ROOT:
           charStringCopy(pluginSearchRoot, programOptionsGetString(programOptions, OPTION_PLUGIN_ROOT));
@@ -453,6 +2014,12 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
         case OPTION_SAMPLE_RATE:
           setSampleRate(programOptionsGetNumber(programOptions, OPTION_SAMPLE_RATE));
           break;
+        case OPTION_SEGMENTS:
+          numSegments = (unsigned int)programOptionsGetNumber(programOptions, OPTION_SEGMENTS);
+          break;
+        case OPTION_SPLIT_MIDI_EVENTS:
+          pluginChainSetMidiEventSplitting(pluginChain, true);
+          break;
         case OPTION_TAIL_TIME:
           tailTimeInMs = (unsigned long)programOptionsGetNumber(programOptions, OPTION_TAIL_TIME);
           break;
@@ -464,6 +2031,12 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
             return RETURN_CODE_INVALID_ARGUMENT;
           }
           break;
+        case OPTION_HUGE_PAGES:
+          setUseHugePages(true);
+          break;
+        case OPTION_WRITE_BEHIND:
+          setUseWriteBehind(true);
+          break;
         case OPTION_ZEBRA_SIZE:
           setLoggingZebraSize((const unsigned long)programOptionsGetNumber(programOptions, OPTION_ZEBRA_SIZE));
           break;
@@ -483,13 +2056,87 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
     return RETURN_CODE_NOT_RUN;
   }
 
+  // The daemon reads everything else from the requests which it receives
+  if(programOptions->options[OPTION_DAEMON]->enabled) {
+    printWelcomeMessage(argc, argv);
+    if(programOptions->options[OPTION_TAP]->enabled) {
+      logWarn("Taps can't be used in daemon mode, ignoring");
+    }
+    result = _runRenderDaemon(programOptionsGetString(programOptions, OPTION_DAEMON), pluginSearchRoot);
+    freeSampleSource(inputSource);
+    if(outputSource != NULL) {
+      freeSampleSource(outputSource);
+    }
+    if(midiSource != NULL) {
+      freeMidiSource(midiSource);
+    }
+    freeCharString(pluginSearchRoot);
+    freeProgramOptions(programOptions);
+    freeTaskTimer(initTimer);
+    freeTaskTimer(totalTimer);
+    freePluginChain(pluginChain);
+    freeAudioSettings();
+    logInfo("Goodbye!");
+    freeEventLogger();
+    freeAudioClock(getAudioClock());
+    freeErrorReporter(errorReporter);
+    return result;
+  }
+
+  // In batch mode the first job is set up like a regular run, which also
+  // initializes the plugin chain with its sample rate
+  if(batchJobs != NULL) {
+    if(programOptions->options[OPTION_INPUT_SOURCE]->enabled ||
+      programOptions->options[OPTION_OUTPUT_SOURCE]->enabled ||
+      programOptions->options[OPTION_MIDI_SOURCE]->enabled) {
+      logWarn("Input, output, and MIDI sources are ignored in batch mode");
+    }
+    batchJob = (BatchJob)batchJobs->item;
+    freeSampleSource(inputSource);
+    inputSource = sampleSourceFactory(batchJob->inputSource);
+    if(outputSource != NULL) {
+      freeSampleSource(outputSource);
+    }
+    outputSource = sampleSourceFactory(batchJob->outputSource);
+    if(midiSource != NULL) {
+      freeMidiSource(midiSource);
+      midiSource = NULL;
+    }
+    if(!charStringIsEmpty(batchJob->midiSource)) {
+      midiSource = newMidiSource(guessMidiSourceType(batchJob->midiSource), batchJob->midiSource);
+    }
+  }
+
+  // Alternative chains render the same input, each to its own output source.
+  // The first one is handled like a regular chain.
+  pluginArgument = programOptionsGetString(programOptions, OPTION_PLUGIN);
+  if(strchr(pluginArgument->data, CHAIN_STRING_ALTERNATIVE_SEPARATOR) != NULL) {
+    if(batchJobs != NULL || midiSource != NULL || automation != NULL) {
+      logError("Multiple plugin chains can't be used with batch mode, MIDI, or automation");
+      return RETURN_CODE_INVALID_ARGUMENT;
+    }
+    chainArguments = charStringSplit(pluginArgument, CHAIN_STRING_ALTERNATIVE_SEPARATOR);
+    outputSourceNames = charStringSplit(programOptionsGetString(programOptions, OPTION_OUTPUT_SOURCE),
+      CHAIN_STRING_ALTERNATIVE_SEPARATOR);
+    if(linkedListLength(chainArguments) == 0 ||
+      linkedListLength(outputSourceNames) != linkedListLength(chainArguments)) {
+      logError("Each plugin chain needs its own output source, but %d chains and %d output sources were given",
+        linkedListLength(chainArguments), linkedListLength(outputSourceNames));
+      return RETURN_CODE_INVALID_ARGUMENT;
+    }
+    pluginArgument = (CharString)chainArguments->item;
+    if(outputSource != NULL) {
+      freeSampleSource(outputSource);
+    }
+    outputSource = sampleSourceFactory((CharString)outputSourceNames->item);
+  }
+
   printWelcomeMessage(argc, argv);
   if((result = setupInputSource(inputSource)) != RETURN_CODE_SUCCESS) {
     logError("Input source could not be opened, exiting");
     return result;
   }
-  if((result = buildPluginChain(pluginChain, programOptionsGetString(programOptions, OPTION_PLUGIN),
-    pluginSearchRoot)) != RETURN_CODE_SUCCESS) {
+  if((result = buildPluginChain(pluginChain, pluginArgument, pluginSearchRoot)) != RETURN_CODE_SUCCESS) {
     logError("Plugin chain could not be constructed, exiting");
     return result;
   }
@@ -524,10 +2171,37 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
 
   // Execute any parameter changes
   if(programOptions->options[OPTION_PARAMETER]->enabled) {
-    if(!pluginChainSetParameters(pluginChain, programOptionsGetList(programOptions, OPTION_PARAMETER))) {
+    parameters = programOptionsGetList(programOptions, OPTION_PARAMETER);
+    if(!pluginChainSetParameters(pluginChain, parameters)) {
       return RETURN_CODE_INVALID_ARGUMENT;
     }
   }
+  if(automation != NULL && !pluginAutomationPrepare(automation, pluginChain)) {
+    return RETURN_CODE_INVALID_ARGUMENT;
+  }
+
+  // Taps are opened here since they are compensated for the processing delay
+  // of the initialized plugins
+  if(programOptions->options[OPTION_TAP]->enabled) {
+    if(batchJobs != NULL) {
+      logWarn("Taps can't be used in batch mode, ignoring");
+    }
+    else {
+      for(tapIterator = programOptionsGetList(programOptions, OPTION_TAP);
+        tapIterator != NULL && tapIterator->item != NULL; tapIterator = tapIterator->nextItem) {
+        tapArgument = newCharStringWithCString((char*)tapIterator->item);
+        tap = newPluginTapWithString(tapArgument);
+        freeCharString(tapArgument);
+        if(tap == NULL) {
+          return RETURN_CODE_INVALID_ARGUMENT;
+        }
+        if(!pluginChainAddTap(pluginChain, tap)) {
+          freePluginTap(tap);
+          return RETURN_CODE_INVALID_ARGUMENT;
+        }
+      }
+    }
+  }
 
   // Setup output source here. Having an invalid output source should not cause the program
   // to exit if the user only wants to list plugins or query info about a chain.
@@ -540,8 +2214,7 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
   // otherwise the head plugin type is not known, which influences whether we must abort
   // processing.
   if(programOptions->options[OPTION_ERROR_REPORT]->enabled) {
-    if(charStringIsEqualToCString(inputSource->sourceName, "-", false) ||
-       charStringIsEqualToCString(outputSource->sourceName, "-", false)) {
+    if(sampleSourceIsStdio(inputSource->sourceName) || sampleSourceIsStdio(outputSource->sourceName)) {
       printf("ERROR: Using stdin/stdout is incompatible with --error-report\n");
       return RETURN_CODE_NOT_RUN;
     }
@@ -582,25 +2255,40 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
     }
   }
 
-  inputSampleBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
-  inputTimer = newTaskTimerWithCString(PROGRAM_NAME, "Input Source");
-  outputSampleBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
-  outputTimer = newTaskTimerWithCString(PROGRAM_NAME, "Output Source");
-
-  // Initialization is finished, we should be able to free this memory now
-  freeProgramOptions(programOptions);
-
   // If a maximum time was given, figure it out here
   if(maxTimeInMs > 0) {
     maxTimeInFrames = (unsigned long)(maxTimeInMs * getSampleRate()) / 1000l;
   }
 
+  // Pipeline stages must be set before the processing delay is known, since
+  // each stage adds a block of delay
+  if(programOptions->options[OPTION_PIPELINE_PLUGINS]->enabled) {
+    if(automation != NULL || chainArguments != NULL || numSegments > 1) {
+      logWarn("Plugin pipelining can't be used with automation, multiple chains, or segments, ignoring");
+    }
+    else if(!pluginChainSetPipelineStages(pluginChain,
+      (unsigned int)programOptionsGetNumber(programOptions, OPTION_PIPELINE_PLUGINS))) {
+      return RETURN_CODE_INVALID_ARGUMENT;
+    }
+  }
+
   processingDelayInFrames = pluginChainGetProcessingDelay(pluginChain);
   // Get largest tail time requested by any plugin in the chain
+  userTailTimeInMs = tailTimeInMs;
   tailTimeInMs += pluginChainGetMaximumTailTimeInMs(pluginChain);
   tailTimeInFrames = (unsigned long)(tailTimeInMs * getSampleRate()) / 1000l + processingDelayInFrames;
   pluginChainPrepareForProcessing(pluginChain);
 
+  // The processing delay is cut from the start of the output, so the output is
+  // as long as the input plus the tail time
+  if(programOptions->options[OPTION_WRITE_BEHIND]->enabled && inputSource->lengthInFrames > 0) {
+    expectedOutputFrames = inputSource->lengthInFrames + tailTimeInFrames - processingDelayInFrames;
+    if(maxTimeInFrames > 0 && maxTimeInFrames < expectedOutputFrames) {
+      expectedOutputFrames = maxTimeInFrames;
+    }
+    sampleSourcePreallocate(outputSource, expectedOutputFrames);
+  }
+
   // Update sample rate on the event logger
   setLoggingZebraSize((const unsigned long)getSampleRate());
   logInfo("Starting processing input source");
@@ -612,46 +2300,150 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
   logDebug("Time signature: %d/%d", getTimeSignatureBeatsPerMeasure(), getTimeSignatureNoteValue());
   taskTimerStop(initTimer);
 
-  silentSampleInput = sampleSourceFactory(NULL);
-  silentSampleOutput = sampleSourceFactory(NULL);
-  // Main processing loop
-  while(!finishedReading) {
-    taskTimerStart(inputTimer);
-    finishedReading = (boolByte)!readInput(inputSource, silentSampleInput, inputSampleBuffer, tailTimeInFrames);
+  // Batch jobs start with the tempo and time signature given on the command
+  // line, not the ones set by MIDI meta events from the previous job
+  initialTempo = getTempo();
+  initialBeatsPerMeasure = getTimeSignatureBeatsPerMeasure();
+  initialNoteValue = getTimeSignatureNoteValue();
+
+  // Segments need their own copy of the chain, which only gives the same result
+  // as a serial render if the chain's output only depends on the audio input
+  if(numSegments > 1) {
+    if(batchJobs != NULL || midiSequence != NULL || automation != NULL || maxTimeInFrames > 0 ||
+      programOptions->options[OPTION_REALTIME]->enabled || pluginChain->taps->item != NULL ||
+      chainArguments != NULL) {
+      logWarn("Segments can't be used with batch mode, MIDI, automation, maximum time, realtime, taps, or multiple chains, ignoring");
+    }
+    else if(inputSource->lengthInFrames == 0) {
+      logWarn("Length of input source '%s' is not known, rendering without segments", inputSource->sourceName->data);
+    }
+    else {
+      segmentOverlapInFrames = (unsigned long)(programOptionsGetNumber(programOptions, OPTION_SEGMENT_OVERLAP) *
+        getSampleRate()) / 1000l;
+      renderSegments = newRenderSegmentList(inputSource->lengthInFrames, numSegments, segmentOverlapInFrames,
+        getBlocksize());
+      logInfo("Rendering %d segments in parallel", linkedListLength(renderSegments));
+      pipelineQueueSize = 0;
+    }
+  }
 
-    // TODO: For streaming MIDI, we would need to read in events from source here
-    if(midiSequence != NULL) {
-      LinkedList midiEventsForBlock = newLinkedList();
-      // MIDI source overrides the value set to finishedReading by the input source
-      finishedReading = (boolByte)!fillMidiEventsFromRange(midiSequence, audioClock->currentFrame, getBlocksize(), midiEventsForBlock);
-      linkedListForeach(midiEventsForBlock, _processMidiMetaEvent, &finishedReading);
-      pluginChainProcessMidi(pluginChain, midiEventsForBlock);
-      freeLinkedList(midiEventsForBlock);
+  if(chainArguments != NULL && linkedListLength(chainArguments) > 1) {
+    numFanOutJobs = linkedListLength(chainArguments) - 1;
+    fanOutQueue = newSampleBufferQueueWithConsumers(pipelineQueueSize > 0 ? pipelineQueueSize : FAN_OUT_QUEUE_SIZE,
+      (unsigned int)numFanOutJobs + 1, getNumChannels(), getBlocksize());
+    result = _startFanOutJobs(chainArguments, outputSourceNames, fanOutQueue, pluginSearchRoot, parameters,
+      userTailTimeInMs, &fanOutThreads, &fanOutJobs);
+    if(result != RETURN_CODE_SUCCESS) {
+      _finishFanOutJobs(fanOutThreads, fanOutJobs, numFanOutJobs);
+      logError("Plugin chains could not be constructed, exiting");
+      return result;
+    }
+    // The input is read once for all chains, so it must last for the longest tail
+    for(i = 0; i < (unsigned int)numFanOutJobs; i++) {
+      if(fanOutJobs[i]->tailTimeInFrames > tailTimeInFrames) {
+        tailTimeInFrames = fanOutJobs[i]->tailTimeInFrames;
+      }
     }
-    taskTimerStop(inputTimer);
+    logInfo("Rendering %d plugin chains in parallel", numFanOutJobs + 1);
+    // The input is read on the main thread, so that its blocks can be shared
+    pipelineQueueSize = 0;
+  }
 
-    if(maxTimeInFrames > 0 && audioClock->currentFrame >= maxTimeInFrames) {
-      logInfo("Maximum time reached, stopping processing after this block");
-      finishedReading = true;
+  renderState = _newRenderState(pluginChain, pipelineQueueSize);
+  renderState->inputSource = inputSource;
+  renderState->outputSource = outputSource;
+  renderState->fanOutQueue = fanOutQueue;
+  renderState->midiSequence = midiSequence;
+  renderState->tailTimeInFrames = tailTimeInFrames;
+  renderState->processingDelayInFrames = processingDelayInFrames;
+  renderState->maxTimeInFrames = maxTimeInFrames;
+  renderState->automation = automation;
+
+  if(batchJobs != NULL) {
+    batchTimer = newTaskTimerWithCString(PROGRAM_NAME, "Batch");
+    logInfo("Rendering job 1 of %d", linkedListLength(batchJobs));
+    taskTimerStart(batchTimer);
+  }
+
+  if(renderSegments != NULL) {
+    result = _renderSegments(renderState, audioClock, renderSegments, programOptionsGetString(programOptions, OPTION_PLUGIN),
+      pluginSearchRoot, parameters);
+    freeLinkedListAndItems(renderSegments, (LinkedListFreeItemFunc)freeRenderSegment);
+    if(result != RETURN_CODE_SUCCESS) {
+      logError("Segmented render failed");
+      return result;
+    }
+  }
+  else {
+    _render(renderState, audioClock);
+  }
+
+  if(fanOutQueue != NULL) {
+    result = _finishFanOutJobs(fanOutThreads, fanOutJobs, numFanOutJobs);
+    if(result != RETURN_CODE_SUCCESS) {
+      logError("Rendering alternative plugin chains failed");
+      return result;
     }
+  }
 
-    pluginChainProcessAudio(pluginChain, inputSampleBuffer, outputSampleBuffer);
+  if(batchJobs != NULL) {
+    _printRenderSummary(inputSource, outputSource, midiSource, midiSequence);
+    batchJobFrames = outputSource->numSamplesProcessed / getNumChannels();
+    batchTotalFrames += batchJobFrames;
+    _printThroughput("Job 1", batchJobFrames, taskTimerStop(batchTimer));
+
+    batchJobNumber = 2;
+    batchIterator = (LinkedListIterator)batchJobs->nextItem;
+    batchJobName = newCharString();
+    while(batchIterator != NULL) {
+      batchJob = (BatchJob)batchIterator->item;
+      logInfo("Rendering job %d of %d", batchJobNumber, linkedListLength(batchJobs));
+      if(getTempo() != initialTempo) {
+        setTempo(initialTempo);
+      }
+      if(getTimeSignatureBeatsPerMeasure() != initialBeatsPerMeasure ||
+        getTimeSignatureNoteValue() != initialNoteValue) {
+        setTimeSignatureBeatsPerMeasure(initialBeatsPerMeasure);
+        setTimeSignatureNoteValue(initialNoteValue);
+      }
 
-    taskTimerStart(outputTimer);
-    if(finishedReading) {
-      outputSampleBuffer->blocksize = inputSampleBuffer->blocksize;//The input buffer size has been adjusted.
-      logDebug("Using buffer size of %d for final block", outputSampleBuffer->blocksize);
+      taskTimerStart(batchTimer);
+      result = _renderBatchJob(renderState, audioClock, batchJob, parameters, &batchJobFrames);
+      snprintf(batchJobName->data, batchJobName->capacity, "Job %d", batchJobNumber);
+      if(result == RETURN_CODE_SUCCESS) {
+        batchTotalFrames += batchJobFrames;
+        _printThroughput(batchJobName->data, batchJobFrames, taskTimerStop(batchTimer));
+      }
+      else {
+        taskTimerStop(batchTimer);
+        numBatchJobsFailed++;
+        batchResult = result;
+      }
+
+      if(result == RETURN_CODE_INVALID_PLUGIN_CHAIN) {
+        logError("Plugin chain is in an unknown state, not rendering remaining jobs");
+        numBatchJobsFailed += linkedListLength(batchJobs) - batchJobNumber;
+        break;
+      }
+      batchJobNumber++;
+      batchIterator = (LinkedListIterator)batchIterator->nextItem;
     }
-    writeOutput(outputSource, silentSampleOutput, outputSampleBuffer, processingDelayInFrames);
-    taskTimerStop(outputTimer);
-    advanceAudioClock(audioClock, outputSampleBuffer->blocksize);
+    freeCharString(batchJobName);
+
+    logInfo("Rendered %d of %d jobs", linkedListLength(batchJobs) - numBatchJobsFailed, linkedListLength(batchJobs));
+    _printThroughput("Batch total", batchTotalFrames, batchTimer->totalTaskTime);
   }
 
-  // Close file handles for input/output sources
-  silentSampleInput->closeSampleSource(silentSampleInput);
-  silentSampleOutput->closeSampleSource(silentSampleOutput);
-  inputSource->closeSampleSource(inputSource);
-  outputSource->closeSampleSource(outputSource);
+  if(pluginChain->realtimeScheduler != NULL) {
+    realtimeSchedulerPrintStats(pluginChain->realtimeScheduler);
+    if(programOptions->options[OPTION_REALTIME_STATS]->enabled) {
+      realtimeSchedulerWriteStats(pluginChain->realtimeScheduler,
+        programOptionsGetString(programOptions, OPTION_REALTIME_STATS));
+    }
+  }
+  else if(programOptions->options[OPTION_REALTIME_STATS]->enabled) {
+    logWarn("Realtime statistics are only available with --realtime");
+  }
 
   // Print out statistics about each plugin's time usage
   // TODO: On windows, the total processing time is stored in clocks and not milliseconds
@@ -662,8 +2454,8 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
   if(totalTimer->totalTaskTime > 0) {
     taskTimerList = newLinkedList();
     linkedListAppend(taskTimerList, initTimer);
-    linkedListAppend(taskTimerList, inputTimer);
-    linkedListAppend(taskTimerList, outputTimer);
+    linkedListAppend(taskTimerList, renderState->inputTimer);
+    linkedListAppend(taskTimerList, renderState->outputTimer);
     for(i = 0; i < pluginChain->numPlugins; i++) {
       linkedListAppend(taskTimerList, pluginChain->audioTimers[i]);
       linkedListAppend(taskTimerList, pluginChain->midiTimers[i]);
@@ -672,38 +2464,42 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
     totalTimeString = taskTimerHumanReadbleString(totalTimer);
     logInfo("Total processing time %s, approximate breakdown:", totalTimeString->data);
     linkedListForeach(taskTimerList, _printTaskTime, totalTimer);
+    if(renderState->inputQueue != NULL) {
+      logInfo("Input and output times overlap with plugin processing in pipelined mode");
+      _printQueueOccupancy("Input", renderState->inputQueue);
+      _printQueueOccupancy("Output", renderState->outputQueue);
+    }
   }
   else {
     // Woo-hoo!
     logInfo("Total processing time <1ms. Either something went wrong, or your computer is smokin' fast!");
   }
   freeTaskTimer(initTimer);
-  freeTaskTimer(inputTimer);
-  freeTaskTimer(outputTimer);
   freeTaskTimer(totalTimer);
+  freeTaskTimer(batchTimer);
   freeLinkedList(taskTimerList);
   freeCharString(totalTimeString);
 
-  if(midiSequence != NULL) {
-    logInfo("Read %ld MIDI events from %s",
-      midiSequence->numMidiEventsProcessed,
-      midiSource->sourceName->data);
+  if(batchJobs == NULL) {
+    _printRenderSummary(inputSource, outputSource, midiSource, midiSequence);
   }
-  else {
-    logInfo("Read %ld frames from %s",
-      inputSource->numSamplesProcessed / getNumChannels(),
-      inputSource->sourceName->data);
-  }
-  logInfo("Wrote %ld frames to %s",
-    outputSource->numSamplesProcessed / getNumChannels(),
-    outputSource->sourceName->data);
 
   // Shut down and free data (will also close open files, plugins, etc)
   logInfo("Shutting down");
   freeSampleSource(inputSource);
   freeSampleSource(outputSource);
-  freeSampleBuffer(inputSampleBuffer);
-  freeSampleBuffer(outputSampleBuffer);
+  _freeRenderState(renderState);
+  freePluginAutomation(automation);
+  freeSampleBufferQueue(fanOutQueue);
+  if(chainArguments != NULL) {
+    freeLinkedListAndItems(chainArguments, (LinkedListFreeItemFunc)freeCharString);
+    freeLinkedListAndItems(outputSourceNames, (LinkedListFreeItemFunc)freeCharString);
+  }
+  if(batchJobs != NULL) {
+    freeLinkedListAndItems(batchJobs, (LinkedListFreeItemFunc)freeBatchJob);
+  }
+  freeProgramOptions(programOptions);
+  freeCharString(pluginSearchRoot);
   pluginChainShutdown(pluginChain);
   freePluginChain(pluginChain);
 
@@ -724,5 +2520,15 @@ int mrsWatsonMain(ErrorReporter errorReporter, int argc, char** argv) {
   }
   freeErrorReporter(errorReporter);
 
-  return RETURN_CODE_SUCCESS;
+  return batchResult;
+}
+
+int mrsWatsonRender(EngineContext engineContext, int argc, char* argv[]) {
+  EngineContext previousContext = getCurrentEngineContext();
+  int result;
+
+  engineContextMakeCurrent(engineContext);
+  result = mrsWatsonMain(newErrorReporter(), argc, argv);
+  engineContextMakeCurrent(previousContext);
+  return result;
 }
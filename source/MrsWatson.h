@@ -28,10 +28,25 @@
 #ifndef MrsWatson_MrsWatson_h
 #define MrsWatson_MrsWatson_h
 
+#include "app/EngineContext.h"
 #include "app/ReturnCodes.h"
 #include "base/CharString.h"
 #include "logging/ErrorReporter.h"
 
 int mrsWatsonMain(ErrorReporter errorReporter, int argc, char* argv[]);
 
+/**
+ * Run a render from another application, using the same arguments as the
+ * command line program. Create the context with newEngineContext() and free it
+ * with freeEngineContext() afterwards. Several renders may run at the same time
+ * on different threads, as long as each one has its own context.
+ * @param engineContext Context which holds the settings, plugin chain, etc.
+ * for this render. A context can be reused for several renders, but not for
+ * concurrent ones.
+ * @param argc Number of arguments
+ * @param argv Arguments, where the first one is the program name
+ * @return Return code for the render, see ReturnCodes.h
+ */
+int mrsWatsonRender(EngineContext engineContext, int argc, char* argv[]);
+
 #endif
@@ -29,12 +29,38 @@
 
 #include "audio/AudioSettings.h"
 #include "base/File.h"
+#include "plugin/PluginChain.h"
 
 #include "MrsWatsonOptions.h"
 
 ProgramOptions newMrsWatsonOptions(void) {
   ProgramOptions options = newProgramOptions(NUM_OPTIONS);
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_AUTOMATION, "automation",
+    "Change plugin parameters at exact sample positions while processing. The \
+argument is a file with one change per line, like so:\n\n\
+\t0,0,1,0.25\n\
+\t1500,0,1,0.75,500\n\
+\t88200f,1,0,1.0\n\n\
+Each line gives the time, the index of the plugin in the chain (starting with \
+0), the parameter index, the new value, and an optional ramp time. Times are \
+in milliseconds, or in sample frames when followed by 'f'. With a ramp time, \
+the parameter moves linearly from its previous value to the new one. Empty \
+lines and lines starting with '#' are ignored.",
+    false, kProgramOptionTypeString, kProgramOptionArgumentTypeRequired));
+
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_BATCH, "batch",
+    "Render several jobs in a row with the same plugin chain, which is only loaded \
+once. The argument is a manifest file with one job per line, like so:\n\n\
+\tinput.wav,output.wav\n\
+\t,output.wav,song.mid\n\n\
+Each line gives the input source, output source, and optional MIDI file for a \
+job. Empty lines and lines starting with '#' are ignored. The plugin state is \
+reset between jobs, and all inputs must have the same sample rate and channel \
+count as the first one. When this option is given, --input, --output, and \
+--midi-file are ignored.",
+    false, kProgramOptionTypeString, kProgramOptionArgumentTypeRequired));
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_BLOCKSIZE, "blocksize",
     "Blocksize in frames to use for processing. If input source is not an even \
 multiple of the blocksize, then empty frames will be added to the last block.",
@@ -59,6 +85,12 @@ used automatically unless 'none' is given to this option.",
     false, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeNone));
   options->options[OPTION_COLOR_TEST]->hideInHelp = true;
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_COMPRESSION_LEVEL, "compression-level",
+    "Compression level for FLAC output, from 0 (fastest) to 8 (smallest). FLAC \
+frames are encoded on one worker thread per additional processor core.",
+    false, kProgramOptionTypeNumber, kProgramOptionArgumentTypeRequired));
+  programOptionsSetNumber(options, OPTION_COMPRESSION_LEVEL, (const float)getCompressionLevel());
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_CONFIG_FILE, "config-file",
     "Load options from a configuration file. The file will be read *after* other \
 options have been parsed, so any options given on the command line will be overriden \
@@ -69,6 +101,18 @@ like so:\n\n\
 \t--verbose",
     false, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeRequired));
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_DAEMON, "daemon",
+    "Run as a daemon which listens for render jobs on the Unix domain socket at \
+<argument>. Plugin chains are kept loaded between jobs, so that rendering with \
+the same plugins and presets again does not need to load them again. Clients \
+send one request per connection, which is a single line with the arguments \
+for the job, for example:\n\n\
+\t--plugin again --input in.wav --output out.wav\n\n\
+The daemon replies with progress messages and the timing breakdown, and closes \
+the connection after a final 'done <return code>' line. Send 'shutdown' to \
+stop the daemon. Only options related to processing are used from requests.",
+    false, kProgramOptionTypeString, kProgramOptionArgumentTypeRequired));
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_DISPLAY_INFO, "display-info",
     "Print information about each plugin in the chain.",
     false, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeNone));
@@ -87,10 +131,17 @@ Otherwise, extended help can be printed for an individual option given by \
 [argument], or use 'full' to print extended help for all options.",
     true, kProgramOptionTypeString, kProgramOptionArgumentTypeOptional));
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_HUGE_PAGES, "huge-pages",
+    "Back large sample buffers with huge pages where the system provides them, \
+which can reduce TLB misses when processing with very large blocksizes. Buffers \
+fall back to regular memory if no huge pages are available. Only supported on \
+Linux.",
+    false, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeNone));
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_INPUT_SOURCE, "input",
     "Input source to use for processing, where the file type is determined from \
 the extension. Run with --list-file-types to see a list of supported types. Use \
-'-' to read from stdin.",
+'-' to read raw PCM data from stdin, or '-.wav' to read a WAVE stream.",
     true, kProgramOptionTypeString, kProgramOptionArgumentTypeRequired));
 
   programOptionsAdd(options, newProgramOptionWithName(OPTION_LIST_PLUGINS, "list-plugins",
@@ -118,10 +169,18 @@ that --tail-time is still applied as normal after this limit is reached.",
     "MIDI file to read events from. Required if processing an instrument plugin.",
     true, kProgramOptionTypeString, kProgramOptionArgumentTypeRequired));
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_OUTPUT_FORMAT, "output-format",
+    "Sample format of the output file, one of int16, int24, int32, float32 or \
+float64. Only used by file types which support more than one format, such as \
+WAVE files.",
+    false, kProgramOptionTypeString, kProgramOptionArgumentTypeRequired));
+  programOptionsSetCString(options, OPTION_OUTPUT_FORMAT, "int16");
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_OUTPUT_SOURCE, "output",
     "Output source to write processed data to, where the file type is determined \
 from the extension. Run with --list-file-types to see a list of supported types. \
-Use '-' to write to stdout..",
+Use '-' to write raw PCM data to stdout, or '-.wav' to write a WAVE stream. When several plugin chains are given with --plugin, \
+give one output for each chain, separated by '|'.",
     true, kProgramOptionTypeString, kProgramOptionArgumentTypeOptional));
   programOptionsSetCString(options, OPTION_OUTPUT_SOURCE, "out.wav");
 
@@ -133,6 +192,25 @@ index/value, for example:\n\n\
 \t--parameter 1,0.3 --parameter 0,0.75",
     false, kProgramOptionTypeList, kProgramOptionArgumentTypeRequired));
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_PIPELINE, "pipeline",
+    "Read the input source, process the plugin chain, and write the output source \
+on separate threads. Blocks are passed between the threads through queues which \
+hold up to [argument] blocks each. This can speed up long offline renders where \
+file I/O would otherwise stall the plugin chain, but does not change the output.",
+    false, kProgramOptionTypeNumber, kProgramOptionArgumentTypeOptional));
+  programOptionsSetNumber(options, OPTION_PIPELINE, 8);
+
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_PIPELINE_PLUGINS, "pipeline-plugins",
+    "Divide the plugins in the chain into stages which are processed on separate \
+threads, passing blocks from one stage to the next through queues. This lets \
+long chains of heavy plugins use more than one core. The argument sets the \
+maximum number of stages, by default each plugin gets its own stage. Every stage \
+after the first adds one block of delay, which is removed from the output like \
+the plugins' own delay. Can't be used with plugin graphs, automation, or \
+multiple chains.",
+    false, kProgramOptionTypeNumber, kProgramOptionArgumentTypeOptional));
+  programOptionsSetNumber(options, OPTION_PIPELINE_PLUGINS, MAX_PLUGINS);
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_PLUGIN, "plugin",
     "Plugin(s) to process. Multiple plugins can given in a semicolon-separated \
 list, in which case they will be placed into a chain in the order specified. \
@@ -144,11 +222,22 @@ for the OS. File extensions are added automatically to plugin names. Each plugin
 may be followed by a comma with a program to be loaded, which should be of the \
 corresponding file format for the respective plugin. For shell plugins (like \
 Waves), use --display-info to get a list of sub-plugin ID's and then use a colon \
-to indicate which plugin to load. Examples:\n\n\
+to indicate which plugin to load. Plugins can also be processed in parallel \
+branches by putting them in square brackets with '+' between the branches, in \
+which case the outputs of the branches are summed and shorter branches are \
+delayed to match the processing delay of the slowest one. Branches may contain \
+several plugins or other groups, and empty branches pass the signal through \
+unchanged. Plugins are numbered in the order in which they appear. Several \
+alternative chains can be separated with '|', in which case the input is read \
+once and rendered through each chain in parallel, and --output must list one \
+output for each chain. The --parameter option applies to the first plugin of \
+each chain, and --tap only to the first chain. Examples:\n\n\
 \t--plugin LFX-1310\n\
 \t--plugin 'AutoTune,KayneWest.fxp;Compressor,SoftKnee.fxp;Limiter'\n\
+\t--plugin 'Compressor;[+Reverb];Limiter' (dry signal mixed with reverb)\n\
 \t--plugin 'WavesShell-VST' --display-info (list shell sub-plugins)\n\
-\t--plugin 'WavesShell-VST:IDFX' (load a shell plugins)",
+\t--plugin 'WavesShell-VST:IDFX' (load a shell plugins)\n\
+\t--plugin 'Compressor;Limiter|Limiter' --output 'a.wav|b.wav' (compare two chains)",
     true, kProgramOptionTypeString, kProgramOptionArgumentTypeRequired));
 
   programOptionsAdd(options, newProgramOptionWithName(OPTION_PLUGIN_ROOT, "plugin-root",
@@ -161,11 +250,18 @@ to indicate which plugin to load. Examples:\n\n\
     true, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeNone));
 
   programOptionsAdd(options, newProgramOptionWithName(OPTION_REALTIME, "realtime",
-    "Simulate running in realtime by sleeping for any remaining time needed to process \
-the given block. Some plugins which are unable to do offline rendering may require this \
-option in order to function properly.",
+    "Simulate running in realtime by sleeping until the time at which each block \
+would be needed by a realtime stream. Some plugins which are unable to do offline \
+rendering may require this option in order to function properly. Blocks which are \
+processed too late are counted, and a summary is printed when processing finishes.",
     false, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeNone));
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_REALTIME_STATS, "realtime-stats",
+    "Write statistics about late blocks when using --realtime to <argument> as a \
+JSON object. This contains the number of blocks, the number of late blocks, the \
+worst lateness in milliseconds, and a histogram of lateness.",
+    false, kProgramOptionTypeString, kProgramOptionArgumentTypeRequired));
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_SAMPLE_RATE, "sample-rate",
     "Sample rate to use when processing. If the input source specifies its own \
 sample rate, that value will override the one set by this option. No error checking \
@@ -174,6 +270,31 @@ using unusual sample rates will probably result in weird behavior from plugins."
     true, kProgramOptionTypeNumber, kProgramOptionArgumentTypeRequired));
   programOptionsSetNumber(options, OPTION_SAMPLE_RATE, (const float)getSampleRate());
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_SEGMENT_OVERLAP, "segment-overlap",
+    "Number of milliseconds to render before the start of each segment when \
+using --segments. The output for this time is thrown away, but it lets \
+filters, compressors, etc. settle so that the segments join without clicks. \
+Use at least the longest release or decay time in the chain.",
+    false, kProgramOptionTypeNumber, kProgramOptionArgumentTypeRequired));
+  programOptionsSetNumber(options, OPTION_SEGMENT_OVERLAP, 1000);
+
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_SEGMENTS, "segments",
+    "Split the input source into <argument> segments and render them in \
+parallel, each on its own thread with its own instance of the plugin chain. \
+The results are joined in order in the output source. This can greatly speed up \
+rendering long files, but is only suitable for effect chains whose output \
+depends on recent input alone (see --segment-overlap). The input source must be \
+a file whose length is known, and this option is ignored when using a MIDI \
+source, --automation, --max-time, or --realtime.",
+    false, kProgramOptionTypeNumber, kProgramOptionArgumentTypeRequired));
+
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_SPLIT_MIDI_EVENTS, "split-midi-events",
+    "Split processing of the first plugin in the chain at the timestamps of MIDI \
+events, sending each event right before the part of the block where it occurs. \
+Use this for instruments which play all events at the start of the block, \
+instead of lowering the blocksize. The other plugins still process whole blocks.",
+    false, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeNone));
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_TAIL_TIME, "tail-time",
     "Continue processing for up to <argument> extra milliseconds after input \
 source is finished, in addition to any tail time requested by plugins in the \
@@ -181,6 +302,16 @@ chain. If any plugins in chain the require tail time, the largest value will be
 used and added to <argument>.",
     false, kProgramOptionTypeNumber, kProgramOptionArgumentTypeRequired));
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_TAP, "tap",
+    "Write the output of a single plugin in the chain to its own file while \
+processing. May be specified multiple times. The argument has the form \
+<plugin index>:<file>, where the index of the first plugin in the chain is 0. \
+The start of each file is trimmed by the processing delay of the plugin and all \
+plugins before it, so that it lines up with the input. For example:\n\n\
+\t--plugin \"plugin1;plugin2\" --tap 0:plugin1.wav --tap 1:plugin2.wav\n\n\
+Taps are not written in batch or daemon mode.",
+    false, kProgramOptionTypeList, kProgramOptionArgumentTypeRequired));
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_TEMPO, "tempo",
     "Tempo to use when processing.",
     false, kProgramOptionTypeNumber, kProgramOptionArgumentTypeRequired));
@@ -203,6 +334,12 @@ used and added to <argument>.",
     "Print full program version and copyright information.",
     false, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeNone));
 
+  programOptionsAdd(options, newProgramOptionWithName(OPTION_WRITE_BEHIND, "write-behind",
+    "Write the output file on a separate thread, collecting many blocks into each \
+write. When the length of the input is known, disk space for the output is also \
+reserved in advance. Useful when writing to slow or network-attached storage.",
+    false, kProgramOptionTypeEmpty, kProgramOptionArgumentTypeNone));
+
   programOptionsAdd(options, newProgramOptionWithName(OPTION_ZEBRA_SIZE, "zebra-size",
     "Alternate logging output colors every <argument> frames.",
     false, kProgramOptionTypeNumber, kProgramOptionArgumentTypeRequired));
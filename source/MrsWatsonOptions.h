@@ -32,14 +32,19 @@
 
 // Runtime options
 typedef enum {
+  OPTION_AUTOMATION,
+  OPTION_BATCH,
   OPTION_BLOCKSIZE,
   OPTION_CHANNELS,
   OPTION_COLOR_LOGGING,
   OPTION_COLOR_TEST,
+  OPTION_COMPRESSION_LEVEL,
   OPTION_CONFIG_FILE,
+  OPTION_DAEMON,
   OPTION_DISPLAY_INFO,
   OPTION_ERROR_REPORT,
   OPTION_HELP,
+  OPTION_HUGE_PAGES,
   OPTION_INPUT_SOURCE,
   OPTION_LIST_FILE_TYPES,
   OPTION_LIST_PLUGINS,
@@ -47,18 +52,27 @@ typedef enum {
   OPTION_LOG_LEVEL,
   OPTION_MAX_TIME,
   OPTION_MIDI_SOURCE,
+  OPTION_OUTPUT_FORMAT,
   OPTION_OUTPUT_SOURCE,
   OPTION_PARAMETER,
+  OPTION_PIPELINE,
+  OPTION_PIPELINE_PLUGINS,
   OPTION_PLUGIN,
   OPTION_PLUGIN_ROOT,
   OPTION_QUIET,
   OPTION_REALTIME,
+  OPTION_REALTIME_STATS,
   OPTION_SAMPLE_RATE,
+  OPTION_SEGMENT_OVERLAP,
+  OPTION_SEGMENTS,
+  OPTION_SPLIT_MIDI_EVENTS,
   OPTION_TAIL_TIME,
+  OPTION_TAP,
   OPTION_TEMPO,
   OPTION_TIME_SIGNATURE,
   OPTION_VERBOSE,
   OPTION_VERSION,
+  OPTION_WRITE_BEHIND,
   OPTION_ZEBRA_SIZE,
   NUM_OPTIONS
 } ProgramOptionIndex;
@@ -0,0 +1,149 @@
+//
+// BatchManifest.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "app/BatchManifest.h"
+#include "base/File.h"
+#include "logging/EventLogger.h"
+
+static CharString _newCharStringWithSubstring(const char* start, size_t length) {
+  CharString result = newCharStringWithCapacity(length < kCharStringLengthDefault ? kCharStringLengthDefault : length + 1);
+  strncpy(result->data, start, length);
+  return result;
+}
+
+BatchJob newBatchJobWithManifestLine(const CharString line) {
+  BatchJob job;
+  char* fields[3] = {NULL, NULL, NULL};
+  char* separator;
+  char* lineEnd;
+  int numFields = 0;
+
+  if(line == NULL || charStringIsEmpty(line)) {
+    return NULL;
+  }
+
+  // Split the line by hand, since charStringSplit() drops empty fields and the
+  // input source may be empty for instruments
+  fields[numFields++] = line->data;
+  separator = strchr(line->data, BATCH_MANIFEST_FIELD_SEPARATOR);
+  while(separator != NULL) {
+    if(numFields >= 3) {
+      logError("Batch manifest line '%s' has too many fields", line->data);
+      return NULL;
+    }
+    fields[numFields++] = separator + 1;
+    separator = strchr(separator + 1, BATCH_MANIFEST_FIELD_SEPARATOR);
+  }
+  if(numFields < 2) {
+    logError("Batch manifest line '%s' has no output source", line->data);
+    return NULL;
+  }
+
+  job = (BatchJob)malloc(sizeof(BatchJobMembers));
+  lineEnd = line->data + strlen(line->data);
+  job->inputSource = _newCharStringWithSubstring(fields[0], fields[1] - fields[0] - 1);
+  if(numFields == 3) {
+    job->outputSource = _newCharStringWithSubstring(fields[1], fields[2] - fields[1] - 1);
+    job->midiSource = _newCharStringWithSubstring(fields[2], lineEnd - fields[2]);
+  }
+  else {
+    job->outputSource = _newCharStringWithSubstring(fields[1], lineEnd - fields[1]);
+    job->midiSource = newCharString();
+  }
+
+  if(charStringIsEmpty(job->outputSource)) {
+    logError("Batch manifest line '%s' has no output source", line->data);
+    freeBatchJob(job);
+    return NULL;
+  }
+  if(charStringIsEmpty(job->inputSource) && charStringIsEmpty(job->midiSource)) {
+    logError("Batch manifest line '%s' has neither an input source nor a MIDI file", line->data);
+    freeBatchJob(job);
+    return NULL;
+  }
+
+  return job;
+}
+
+LinkedList batchManifestReadJobs(const CharString manifestFilename) {
+  File manifestFile = NULL;
+  LinkedList manifestLines = NULL;
+  LinkedList jobs = NULL;
+  LinkedListIterator iterator;
+  CharString line;
+  BatchJob job;
+
+  if(manifestFilename == NULL || charStringIsEmpty(manifestFilename)) {
+    logError("Cannot read batch manifest from empty filename");
+    return NULL;
+  }
+
+  manifestFile = newFileWithPath(manifestFilename);
+  if(manifestFile == NULL || manifestFile->fileType != kFileTypeFile) {
+    logError("Batch manifest '%s' does not exist", manifestFilename->data);
+    freeFile(manifestFile);
+    return NULL;
+  }
+
+  manifestLines = fileReadLines(manifestFile);
+  freeFile(manifestFile);
+  if(manifestLines == NULL) {
+    logError("Could not read batch manifest '%s'", manifestFilename->data);
+    return NULL;
+  }
+
+  jobs = newLinkedList();
+  iterator = manifestLines;
+  while(iterator != NULL) {
+    line = (CharString)iterator->item;
+    if(line != NULL && !charStringIsEmpty(line) && line->data[0] != BATCH_MANIFEST_COMMENT_CHAR) {
+      job = newBatchJobWithManifestLine(line);
+      if(job == NULL) {
+        freeLinkedListAndItems(jobs, (LinkedListFreeItemFunc)freeBatchJob);
+        freeLinkedListAndItems(manifestLines, (LinkedListFreeItemFunc)freeCharString);
+        return NULL;
+      }
+      linkedListAppend(jobs, job);
+    }
+    iterator = iterator->nextItem;
+  }
+
+  freeLinkedListAndItems(manifestLines, (LinkedListFreeItemFunc)freeCharString);
+  return jobs;
+}
+
+void freeBatchJob(BatchJob self) {
+  if(self != NULL) {
+    freeCharString(self->inputSource);
+    freeCharString(self->outputSource);
+    freeCharString(self->midiSource);
+    free(self);
+  }
+}
@@ -0,0 +1,74 @@
+//
+// BatchManifest.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_BatchManifest_h
+#define MrsWatson_BatchManifest_h
+
+#include "base/CharString.h"
+#include "base/LinkedList.h"
+
+#define BATCH_MANIFEST_FIELD_SEPARATOR ','
+#define BATCH_MANIFEST_COMMENT_CHAR '#'
+
+/**
+ * A single render job from a batch manifest. Each job is rendered through the
+ * same plugin chain, but with its own input, output, and MIDI sources.
+ */
+typedef struct {
+  CharString inputSource;
+  CharString outputSource;
+  CharString midiSource;
+} BatchJobMembers;
+typedef BatchJobMembers* BatchJob;
+
+/**
+ * Parse a line from a batch manifest. Lines have the following format, where
+ * the input source may be left empty when rendering an instrument:
+ *
+ *   <input source>,<output source>[,<MIDI file>]
+ *
+ * @param line Line to parse
+ * @return Initialized BatchJob, or NULL if the line is malformed
+ */
+BatchJob newBatchJobWithManifestLine(const CharString line);
+
+/**
+ * Read all jobs from a batch manifest file. Empty lines and lines starting
+ * with '#' are ignored.
+ * @param manifestFilename Path to the manifest
+ * @return List of BatchJob objects, or NULL if the manifest could not be read
+ * or contained malformed lines. The caller must free this list and its items.
+ */
+LinkedList batchManifestReadJobs(const CharString manifestFilename);
+
+/**
+ * Free a batch job and all associated resources
+ * @param self
+ */
+void freeBatchJob(BatchJob self);
+
+#endif
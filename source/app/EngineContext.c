@@ -0,0 +1,87 @@
+//
+// EngineContext.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#include <stdlib.h>
+
+#include "app/EngineContext.h"
+#include "base/Thread.h"
+
+static THREAD_LOCAL EngineContext currentEngineContext = NULL;
+
+EngineContext newEngineContext(void) {
+  EngineContext context = (EngineContext)malloc(sizeof(EngineContextMembers));
+  context->audioSettings = newAudioSettings();
+  context->audioClock = newAudioClock();
+  context->pluginChain = newPluginChain();
+  context->eventLogger = newEventLogger();
+  return context;
+}
+
+void engineContextMakeCurrent(EngineContext self) {
+  currentEngineContext = self;
+}
+
+void engineContextInitWithClock(EngineContext self, AudioClock audioClock) {
+  EngineContext currentContext = getCurrentEngineContext();
+  self->audioSettings = currentContext != NULL ? currentContext->audioSettings : audioSettingsInstance;
+  self->audioClock = audioClock;
+  self->pluginChain = getPluginChain();
+  self->eventLogger = currentContext != NULL ? currentContext->eventLogger : eventLoggerInstance;
+}
+
+EngineContext getCurrentEngineContext(void) {
+  return currentEngineContext;
+}
+
+void freeEngineContext(EngineContext self) {
+  EngineContext previousContext;
+
+  if(self == NULL) {
+    return;
+  }
+
+  // Plugins may log or ask for the time while closing, so they must see the
+  // objects from their own context
+  previousContext = getCurrentEngineContext();
+  engineContextMakeCurrent(self);
+  if(self->pluginChain != NULL) {
+    pluginChainShutdown(self->pluginChain);
+    freePluginChain(self->pluginChain);
+  }
+  if(self->audioSettings != NULL) {
+    freeAudioSettings();
+  }
+  if(self->eventLogger != NULL) {
+    freeEventLogger();
+  }
+  if(self->audioClock != NULL) {
+    freeAudioClock(self->audioClock);
+  }
+  engineContextMakeCurrent(previousContext == self ? NULL : previousContext);
+  free(self);
+}
@@ -0,0 +1,93 @@
+//
+// EngineContext.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+
+#ifndef MrsWatson_EngineContext_h
+#define MrsWatson_EngineContext_h
+
+#include "audio/AudioSettings.h"
+#include "logging/EventLogger.h"
+#include "plugin/PluginChain.h"
+#include "time/AudioClock.h"
+
+/**
+ * Owns the audio settings, clock, plugin chain, and logger used for a render.
+ * The functions which access these objects (ie, getSampleRate(),
+ * getAudioClock(), logInfo(), etc.) use the context which has been made
+ * current on the calling thread, or the process-wide instances if no context
+ * is current. This allows several renders to run concurrently in one process,
+ * as long as each one uses its own context.
+ */
+typedef struct {
+  AudioSettings audioSettings;
+  AudioClock audioClock;
+  PluginChain pluginChain;
+  EventLogger eventLogger;
+} EngineContextMembers;
+typedef EngineContextMembers* EngineContext;
+
+/**
+ * Create a new engine context with default settings, an empty plugin chain,
+ * and a logger which writes to the console.
+ * @return Initialized EngineContext
+ */
+EngineContext newEngineContext(void);
+
+/**
+ * Use this context for all settings, clock, plugin chain, and logging calls
+ * made from the calling thread. Each thread has its own current context, so
+ * this must also be called on any worker threads started during a render.
+ * @param self Context to use, or NULL to use the process-wide instances
+ */
+void engineContextMakeCurrent(EngineContext self);
+
+/**
+ * Fill in a context which shares the settings, plugin chain, and logger of the
+ * calling thread but has its own clock. Worker threads which process another
+ * block than the calling thread make this current to see that block's position.
+ * The shared objects are only borrowed, so the context must not be passed to
+ * freeEngineContext().
+ * @param self Context to fill in
+ * @param audioClock Clock to use in the context
+ */
+void engineContextInitWithClock(EngineContext self, AudioClock audioClock);
+
+/**
+ * Get the context which is current on the calling thread.
+ * @return Current context, or NULL if none has been set
+ */
+EngineContext getCurrentEngineContext(void);
+
+/**
+ * Free a context and all objects owned by it. Any plugins which are still
+ * loaded in the context's chain are shut down. The context must not be current
+ * on any thread when it is freed.
+ * @param self
+ */
+void freeEngineContext(EngineContext self);
+
+#endif
@@ -0,0 +1,120 @@
+//
+// PluginChainPool.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+
+#include "app/PluginChainPool.h"
+#include "logging/EventLogger.h"
+
+PluginChainPool newPluginChainPool(unsigned int maxEntries) {
+  PluginChainPool pool = (PluginChainPool)malloc(sizeof(PluginChainPoolMembers));
+  pool->maxEntries = maxEntries > 0 ? maxEntries : 1;
+  pool->entries = (PluginChainPoolEntry*)malloc(sizeof(PluginChainPoolEntry) * pool->maxEntries);
+  pool->numEntries = 0;
+  pool->_useCounter = 0;
+  return pool;
+}
+
+static int _findEntryIndex(PluginChainPool self, const CharString key) {
+  unsigned int i;
+  for(i = 0; i < self->numEntries; i++) {
+    if(charStringIsEqualTo(self->entries[i]->key, key, false)) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+static void _freeEntryAtIndex(PluginChainPool self, unsigned int index) {
+  PluginChainPoolEntry entry = self->entries[index];
+  unsigned int i;
+
+  freeEngineContext(entry->engineContext);
+  freeCharString(entry->key);
+  free(entry);
+  for(i = index; i + 1 < self->numEntries; i++) {
+    self->entries[i] = self->entries[i + 1];
+  }
+  self->numEntries--;
+}
+
+EngineContext pluginChainPoolGet(PluginChainPool self, const CharString key) {
+  int index = _findEntryIndex(self, key);
+  if(index < 0) {
+    return NULL;
+  }
+  self->entries[index]->lastUsed = ++self->_useCounter;
+  return self->entries[index]->engineContext;
+}
+
+void pluginChainPoolAdd(PluginChainPool self, const CharString key, EngineContext engineContext) {
+  PluginChainPoolEntry entry;
+  unsigned int leastRecentlyUsed = 0;
+  unsigned int i;
+  int index;
+
+  index = _findEntryIndex(self, key);
+  if(index >= 0) {
+    _freeEntryAtIndex(self, (unsigned int)index);
+  }
+
+  if(self->numEntries == self->maxEntries) {
+    for(i = 1; i < self->numEntries; i++) {
+      if(self->entries[i]->lastUsed < self->entries[leastRecentlyUsed]->lastUsed) {
+        leastRecentlyUsed = i;
+      }
+    }
+    logDebug("Plugin chain pool is full, unloading '%s'", self->entries[leastRecentlyUsed]->key->data);
+    _freeEntryAtIndex(self, leastRecentlyUsed);
+  }
+
+  entry = (PluginChainPoolEntry)malloc(sizeof(PluginChainPoolEntryMembers));
+  entry->key = newCharStringWithCapacity(key->capacity);
+  charStringCopy(entry->key, key);
+  entry->engineContext = engineContext;
+  entry->lastUsed = ++self->_useCounter;
+  self->entries[self->numEntries++] = entry;
+}
+
+boolByte pluginChainPoolRemove(PluginChainPool self, const CharString key) {
+  int index = _findEntryIndex(self, key);
+  if(index < 0) {
+    return false;
+  }
+  _freeEntryAtIndex(self, (unsigned int)index);
+  return true;
+}
+
+void freePluginChainPool(PluginChainPool self) {
+  if(self != NULL) {
+    while(self->numEntries > 0) {
+      _freeEntryAtIndex(self, self->numEntries - 1);
+    }
+    free(self->entries);
+    free(self);
+  }
+}
@@ -0,0 +1,98 @@
+//
+// PluginChainPool.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_PluginChainPool_h
+#define MrsWatson_PluginChainPool_h
+
+#include "app/EngineContext.h"
+#include "base/CharString.h"
+
+#define DEFAULT_PLUGIN_CHAIN_POOL_SIZE 8
+
+typedef struct {
+  CharString key;
+  EngineContext engineContext;
+  unsigned long lastUsed;
+} PluginChainPoolEntryMembers;
+typedef PluginChainPoolEntryMembers* PluginChainPoolEntry;
+
+/**
+ * Keeps initialized plugin chains around between renders, so that plugins do
+ * not need to be loaded again for each job. Each chain lives in its own engine
+ * context, and is looked up by a key which describes how it was built (ie, the
+ * plugin argument string and the sample rate it was initialized with). When the
+ * pool is full, the least recently used chain is shut down to make room.
+ */
+typedef struct {
+  PluginChainPoolEntry* entries;
+  unsigned int numEntries;
+  unsigned int maxEntries;
+  unsigned long _useCounter;
+} PluginChainPoolMembers;
+typedef PluginChainPoolMembers* PluginChainPool;
+
+/**
+ * Create a new pool
+ * @param maxEntries Maximum number of chains to keep loaded
+ * @return Initialized PluginChainPool
+ */
+PluginChainPool newPluginChainPool(unsigned int maxEntries);
+
+/**
+ * Find the context for a chain and mark it as the most recently used one.
+ * @param self
+ * @param key Key given when the context was added
+ * @return Context, or NULL if no chain with this key is in the pool
+ */
+EngineContext pluginChainPoolGet(PluginChainPool self, const CharString key);
+
+/**
+ * Add a context to the pool, which then takes ownership of it. If the pool is
+ * full, the least recently used context is freed first.
+ * @param self
+ * @param key Key to find the context with. Any existing context with the same
+ * key is freed.
+ * @param engineContext Context with an initialized plugin chain
+ */
+void pluginChainPoolAdd(PluginChainPool self, const CharString key, EngineContext engineContext);
+
+/**
+ * Remove a context from the pool and free it. Used when a chain can no longer
+ * be reused, for instance if it could not be reset.
+ * @param self
+ * @param key Key of the context to remove
+ * @return True if a context was removed
+ */
+boolByte pluginChainPoolRemove(PluginChainPool self, const CharString key);
+
+/**
+ * Free the pool and all contexts in it, shutting down their plugins.
+ * @param self
+ */
+void freePluginChainPool(PluginChainPool self);
+
+#endif
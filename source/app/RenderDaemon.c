@@ -0,0 +1,383 @@
+//
+// RenderDaemon.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app/BuildInfo.h"
+#include "app/RenderDaemon.h"
+#include "base/LinkedList.h"
+#include "base/PlatformUtilities.h"
+#include "logging/EventLogger.h"
+
+#if UNIX
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+RenderDaemon newRenderDaemon(const CharString socketPath) {
+  RenderDaemon daemon = (RenderDaemon)malloc(sizeof(RenderDaemonMembers));
+  daemon->socketPath = newCharStringWithCapacity(socketPath->capacity);
+  charStringCopy(daemon->socketPath, socketPath);
+  daemon->_socket = -1;
+  return daemon;
+}
+
+#if UNIX
+/**
+ * Remove a socket which was left behind by a daemon that was killed. Anything
+ * else at the socket path is left alone, including the socket of a daemon which
+ * is still running.
+ * @param path Socket path
+ * @param address Address for the socket path
+ * @return True if bind() can be called on the path
+ */
+static boolByte _removeStaleSocket(const char* path, const struct sockaddr_un* address) {
+  struct stat fileInfo;
+  int probe;
+
+  if(lstat(path, &fileInfo) != 0) {
+    if(errno == ENOENT) {
+      return true;
+    }
+    logError("Could not check socket path '%s': %s", path, strerror(errno));
+    return false;
+  }
+  if(!S_ISSOCK(fileInfo.st_mode)) {
+    logError("'%s' already exists and is not a socket, refusing to replace it", path);
+    return false;
+  }
+
+  probe = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(probe < 0) {
+    logError("Could not create socket: %s", strerror(errno));
+    return false;
+  }
+  if(connect(probe, (const struct sockaddr*)address, sizeof(*address)) == 0) {
+    close(probe);
+    logError("Another daemon is already listening on '%s'", path);
+    return false;
+  }
+  close(probe);
+
+  logDebug("Removing stale socket '%s'", path);
+  if(unlink(path) != 0) {
+    logError("Could not remove stale socket '%s': %s", path, strerror(errno));
+    return false;
+  }
+  return true;
+}
+#endif
+
+boolByte renderDaemonListen(RenderDaemon self) {
+#if UNIX
+  struct sockaddr_un address;
+
+  if(charStringIsEmpty(self->socketPath)) {
+    logError("Cannot listen on socket with empty path");
+    return false;
+  }
+  if(strlen(self->socketPath->data) >= sizeof(address.sun_path)) {
+    logError("Socket path '%s' is too long", self->socketPath->data);
+    return false;
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, self->socketPath->data, sizeof(address.sun_path) - 1);
+
+  if(!_removeStaleSocket(self->socketPath->data, &address)) {
+    return false;
+  }
+  self->_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(self->_socket < 0) {
+    logError("Could not create socket: %s", strerror(errno));
+    return false;
+  }
+  if(bind(self->_socket, (struct sockaddr*)&address, sizeof(address)) != 0) {
+    logError("Could not bind socket to '%s': %s", self->socketPath->data, strerror(errno));
+    close(self->_socket);
+    self->_socket = -1;
+    return false;
+  }
+  if(listen(self->_socket, SOMAXCONN) != 0) {
+    logError("Could not listen on socket '%s': %s", self->socketPath->data, strerror(errno));
+    close(self->_socket);
+    self->_socket = -1;
+    unlink(self->socketPath->data);
+    return false;
+  }
+
+  return true;
+#else
+  logUnsupportedFeature("Render daemon on this platform");
+  return false;
+#endif
+}
+
+#if UNIX
+/**
+ * Read the request line from a connection, stopping at the first newline.
+ * @param connection Socket to read from
+ * @param buffer Buffer to read into, which is always null-terminated
+ * @param bufferSize Size of the buffer in bytes
+ * @return True if a complete line was read
+ */
+static boolByte _readRequestLine(int connection, char* buffer, size_t bufferSize) {
+  size_t length = 0;
+  ssize_t bytesRead;
+  char* newline;
+
+  buffer[0] = '\0';
+  while(length < bufferSize - 1) {
+    bytesRead = recv(connection, buffer + length, bufferSize - 1 - length, 0);
+    if(bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    else if(bytesRead <= 0) {
+      // A client may close its end without sending the final newline
+      return (boolByte)(length > 0);
+    }
+    length += (size_t)bytesRead;
+    buffer[length] = '\0';
+    newline = strchr(buffer, '\n');
+    if(newline != NULL) {
+      *newline = '\0';
+      if(newline > buffer && *(newline - 1) == '\r') {
+        *(newline - 1) = '\0';
+      }
+      return true;
+    }
+  }
+
+  logError("Render daemon request is longer than %d bytes", RENDER_DAEMON_MAX_REQUEST_LENGTH);
+  return false;
+}
+#endif
+
+RenderDaemonJob renderDaemonAcceptJob(RenderDaemon self) {
+#if UNIX
+  char* requestBuffer;
+  RenderDaemonJob job = NULL;
+  int connection;
+
+  if(self->_socket < 0) {
+    return NULL;
+  }
+
+  requestBuffer = (char*)malloc(RENDER_DAEMON_MAX_REQUEST_LENGTH);
+  while(job == NULL) {
+    connection = accept(self->_socket, NULL, NULL);
+    if(connection < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      logError("Could not accept connection: %s", strerror(errno));
+      break;
+    }
+
+    if(_readRequestLine(connection, requestBuffer, RENDER_DAEMON_MAX_REQUEST_LENGTH)) {
+      job = newRenderDaemonJobWithRequest(requestBuffer);
+    }
+    if(job == NULL) {
+      // Other daemons connect without sending anything to check whether the
+      // socket is in use
+      if(requestBuffer[0] != '\0') {
+        logWarn("Ignoring malformed request '%s'", requestBuffer);
+      }
+      close(connection);
+    }
+    else {
+      job->_connection = connection;
+    }
+  }
+
+  free(requestBuffer);
+  return job;
+#else
+  return NULL;
+#endif
+}
+
+static CharString _newArgumentWithLength(const char* start, size_t length) {
+  CharString argument = newCharStringWithCapacity(length + 1);
+  memcpy(argument->data, start, length);
+  argument->data[length] = '\0';
+  return argument;
+}
+
+RenderDaemonJob newRenderDaemonJobWithRequest(const char* request) {
+  RenderDaemonJob job;
+  LinkedList arguments;
+  LinkedListIterator iterator;
+  CharString argument;
+  char* token;
+  const char* c;
+  size_t tokenLength = 0;
+  boolByte inQuotes = false;
+  boolByte inToken = false;
+  int i;
+
+  if(request == NULL) {
+    return NULL;
+  }
+
+  // Tokens can't be longer than the request itself, so one buffer is enough
+  token = (char*)malloc(strlen(request) + 1);
+  arguments = newLinkedList();
+  for(c = request; ; c++) {
+    if(*c == '"') {
+      inQuotes = (boolByte)!inQuotes;
+      inToken = true;
+    }
+    else if(*c == '\0' || (!inQuotes && (*c == ' ' || *c == '\t'))) {
+      if(inToken) {
+        linkedListAppend(arguments, _newArgumentWithLength(token, tokenLength));
+        tokenLength = 0;
+        inToken = false;
+      }
+      if(*c == '\0') {
+        break;
+      }
+    }
+    else {
+      token[tokenLength++] = *c;
+      inToken = true;
+    }
+  }
+  free(token);
+
+  if(inQuotes) {
+    logError("Request '%s' has an unterminated quote", request);
+    freeLinkedListAndItems(arguments, (LinkedListFreeItemFunc)freeCharString);
+    return NULL;
+  }
+  if(linkedListLength(arguments) == 0) {
+    freeLinkedList(arguments);
+    return NULL;
+  }
+
+  job = (RenderDaemonJob)malloc(sizeof(RenderDaemonJobMembers));
+  job->request = newCharStringWithCapacity(strlen(request) + 1);
+  strncpy(job->request->data, request, job->request->capacity);
+  // Like a regular argv, the first argument is the program name
+  job->argc = linkedListLength(arguments) + 1;
+  job->argv = (char**)malloc(sizeof(char*) * job->argc);
+  job->argv[0] = (char*)malloc(strlen(PROGRAM_NAME) + 1);
+  strcpy(job->argv[0], PROGRAM_NAME);
+  iterator = arguments;
+  for(i = 1; i < job->argc; i++) {
+    argument = (CharString)iterator->item;
+    job->argv[i] = (char*)malloc(strlen(argument->data) + 1);
+    strcpy(job->argv[i], argument->data);
+    iterator = iterator->nextItem;
+  }
+  job->_connection = -1;
+
+  freeLinkedListAndItems(arguments, (LinkedListFreeItemFunc)freeCharString);
+  return job;
+}
+
+boolByte renderDaemonJobIsShutdownRequest(const RenderDaemonJob self) {
+  return (boolByte)(self->argc == 2 && !strcmp(self->argv[1], RENDER_DAEMON_SHUTDOWN_REQUEST));
+}
+
+boolByte renderDaemonJobSendMessage(RenderDaemonJob self, const char* format, ...) {
+#if UNIX
+  char message[RENDER_DAEMON_MAX_MESSAGE_LENGTH];
+  va_list arguments;
+  size_t length;
+  size_t bytesSent = 0;
+  ssize_t result;
+  int flags = 0;
+
+  if(self->_connection < 0) {
+    return false;
+  }
+
+  va_start(arguments, format);
+  vsnprintf(message, RENDER_DAEMON_MAX_MESSAGE_LENGTH - 1, format, arguments);
+  va_end(arguments);
+  message[RENDER_DAEMON_MAX_MESSAGE_LENGTH - 2] = '\0';
+  length = strlen(message);
+  message[length++] = '\n';
+
+#ifdef MSG_NOSIGNAL
+  // Don't get killed by SIGPIPE if the client has gone away
+  flags = MSG_NOSIGNAL;
+#endif
+  while(bytesSent < length) {
+    result = send(self->_connection, message + bytesSent, length - bytesSent, flags);
+    if(result < 0 && errno == EINTR) {
+      continue;
+    }
+    else if(result <= 0) {
+      logDebug("Could not send message to daemon client: %s", strerror(errno));
+      return false;
+    }
+    bytesSent += (size_t)result;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void freeRenderDaemonJob(RenderDaemonJob self) {
+  int i;
+  if(self != NULL) {
+#if UNIX
+    if(self->_connection >= 0) {
+      close(self->_connection);
+    }
+#endif
+    for(i = 0; i < self->argc; i++) {
+      free(self->argv[i]);
+    }
+    free(self->argv);
+    freeCharString(self->request);
+    free(self);
+  }
+}
+
+void freeRenderDaemon(RenderDaemon self) {
+  if(self != NULL) {
+#if UNIX
+    if(self->_socket >= 0) {
+      close(self->_socket);
+      unlink(self->socketPath->data);
+    }
+#endif
+    freeCharString(self->socketPath);
+    free(self);
+  }
+}
@@ -0,0 +1,139 @@
+//
+// RenderDaemon.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_RenderDaemon_h
+#define MrsWatson_RenderDaemon_h
+
+#include "base/CharString.h"
+#include "base/Types.h"
+
+#define RENDER_DAEMON_MAX_REQUEST_LENGTH 8192
+#define RENDER_DAEMON_MAX_MESSAGE_LENGTH 1024
+#define RENDER_DAEMON_SHUTDOWN_REQUEST "shutdown"
+
+/**
+ * Listens on a local Unix domain socket for render jobs. Clients connect,
+ * send a single request line, and then read status messages until the daemon
+ * closes the connection. The request line contains the same arguments which
+ * would be given on the command line, for example:
+ *
+ *   --plugin again --input "in.wav" --output "out.wav" --parameter 0,0.5
+ *
+ * Each message sent back to the client is also a single line, starting with a
+ * keyword which describes the rest of the line:
+ *
+ *   chain warm|cold <load time in ms>
+ *   progress <frames rendered> <seconds rendered>
+ *   timer <time in ms> <component> <subcomponent>
+ *   error <message>
+ *   done <return code> <frames written> <total time in ms>
+ *
+ * The "done" message is always sent last. Sending "shutdown" as the request
+ * makes the daemon exit after unloading all plugins.
+ */
+typedef struct {
+  CharString socketPath;
+  int _socket;
+} RenderDaemonMembers;
+typedef RenderDaemonMembers* RenderDaemon;
+
+/**
+ * A request received from a daemon client. The arguments are split up in the
+ * same way as a shell would, except that only double quotes are supported.
+ */
+typedef struct {
+  CharString request;
+  int argc;
+  char** argv;
+  int _connection;
+} RenderDaemonJobMembers;
+typedef RenderDaemonJobMembers* RenderDaemonJob;
+
+/**
+ * Create a new daemon. The socket is not opened until renderDaemonListen() is
+ * called.
+ * @param socketPath Path to the socket file
+ * @return Initialized RenderDaemon
+ */
+RenderDaemon newRenderDaemon(const CharString socketPath);
+
+/**
+ * Create the socket and start listening for connections. A socket left behind
+ * by a daemon which was killed is replaced, but this fails if any other file
+ * exists at the socket path or another daemon is still listening on it.
+ * @param self
+ * @return True on success, false if the socket could not be created
+ */
+boolByte renderDaemonListen(RenderDaemon self);
+
+/**
+ * Wait for the next client and read its request. Connections which send an
+ * empty or malformed request are closed without returning.
+ * @param self
+ * @return Job for the next request, or NULL if the socket was closed or an
+ * error occurred
+ */
+RenderDaemonJob renderDaemonAcceptJob(RenderDaemon self);
+
+/**
+ * Create a job from a request line. Used by renderDaemonAcceptJob(), but also
+ * useful for parsing requests which were not received over a socket.
+ * @param request Request line, without the trailing newline
+ * @return Job with the request split into arguments, or NULL if the request is
+ * empty or contains an unterminated quote
+ */
+RenderDaemonJob newRenderDaemonJobWithRequest(const char* request);
+
+/**
+ * @param self
+ * @return True if the client asked the daemon to exit
+ */
+boolByte renderDaemonJobIsShutdownRequest(const RenderDaemonJob self);
+
+/**
+ * Send a message line to the client. The newline is appended automatically.
+ * Errors are ignored by the caller, since a client which disconnects during a
+ * render should not stop the render itself.
+ * @param self
+ * @param format Format string, like printf()
+ * @return True if the message was sent
+ */
+boolByte renderDaemonJobSendMessage(RenderDaemonJob self, const char* format, ...);
+
+/**
+ * Free a job and close its connection.
+ * @param self
+ */
+void freeRenderDaemonJob(RenderDaemonJob self);
+
+/**
+ * Stop listening and remove the socket file.
+ * @param self
+ */
+void freeRenderDaemon(RenderDaemon self);
+
+#endif
@@ -0,0 +1,75 @@
+//
+// RenderSegment.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+
+#include "app/RenderSegment.h"
+
+LinkedList newRenderSegmentList(unsigned long totalFrames, unsigned int numSegments,
+  unsigned long warmupFrames, unsigned long blocksize) {
+  LinkedList segments = newLinkedList();
+  RenderSegment segment;
+  unsigned long numBlocks;
+  unsigned long blocksPerSegment;
+  unsigned long extraBlocks;
+  unsigned long startBlock = 0;
+  unsigned long endFrame;
+  unsigned long warmupBlocks;
+  unsigned int i;
+
+  if(blocksize == 0) {
+    blocksize = 1;
+  }
+  numBlocks = (totalFrames + blocksize - 1) / blocksize;
+  if(numSegments > numBlocks) {
+    numSegments = (unsigned int)numBlocks;
+  }
+  if(numSegments == 0) {
+    numSegments = 1;
+  }
+  blocksPerSegment = numBlocks / numSegments;
+  extraBlocks = numBlocks % numSegments;
+  warmupBlocks = (warmupFrames + blocksize - 1) / blocksize;
+
+  for(i = 0; i < numSegments; i++) {
+    segment = (RenderSegment)malloc(sizeof(RenderSegmentMembers));
+    segment->startFrame = startBlock * blocksize;
+    segment->warmupFrames = (warmupBlocks < startBlock ? warmupBlocks : startBlock) * blocksize;
+    // Spread the remaining blocks over the first segments
+    startBlock += blocksPerSegment + (i < extraBlocks ? 1 : 0);
+    endFrame = startBlock * blocksize;
+    segment->numFrames = (endFrame < totalFrames ? endFrame : totalFrames) - segment->startFrame;
+    segment->isLast = (boolByte)(i + 1 == numSegments);
+    linkedListAppend(segments, segment);
+  }
+
+  return segments;
+}
+
+void freeRenderSegment(RenderSegment self) {
+  free(self);
+}
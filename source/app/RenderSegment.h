@@ -0,0 +1,70 @@
+//
+// RenderSegment.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_RenderSegment_h
+#define MrsWatson_RenderSegment_h
+
+#include "base/LinkedList.h"
+#include "base/Types.h"
+
+/**
+ * A range of the input source which is rendered independently of the others
+ * with --segments. Each segment starts rendering warmupFrames before its start
+ * frame so that the plugins have settled by the time its first frame is
+ * reached, and the output for those frames is thrown away.
+ */
+typedef struct {
+  unsigned long startFrame;
+  unsigned long numFrames;
+  unsigned long warmupFrames;
+  // Only the last segment renders the tail of the plugin chain
+  boolByte isLast;
+} RenderSegmentMembers;
+typedef RenderSegmentMembers* RenderSegment;
+
+/**
+ * Split an input source into segments of roughly equal length. Segment
+ * boundaries and warm-up lengths are rounded to whole blocks, so that each
+ * segment processes blocks at the same positions as a serial render would.
+ * Fewer segments than requested are returned if the input has fewer blocks.
+ * @param totalFrames Length of the input source
+ * @param numSegments Number of segments to split the input into
+ * @param warmupFrames Minimum number of frames to render before each segment
+ * @param blocksize Blocksize used for processing
+ * @return List of RenderSegment objects in order, which contains at least one
+ * segment. Free with freeLinkedListAndItems() and freeRenderSegment().
+ */
+LinkedList newRenderSegmentList(unsigned long totalFrames, unsigned int numSegments,
+  unsigned long warmupFrames, unsigned long blocksize);
+
+/**
+ * Free a segment
+ * @param self
+ */
+void freeRenderSegment(RenderSegment self);
+
+#endif
@@ -30,29 +30,47 @@
 #include <string.h>
 #include <math.h>
 
+#include "app/EngineContext.h"
 #include "audio/AudioSettings.h"
 #include "logging/EventLogger.h"
 
 AudioSettings audioSettingsInstance = NULL;
 
+// Location of the instance used by the calling thread
+static AudioSettings* _getAudioSettingsInstance(void) {
+  EngineContext context = getCurrentEngineContext();
+  return context != NULL ? &context->audioSettings : &audioSettingsInstance;
+}
+
+AudioSettings newAudioSettings(void) {
+  AudioSettings settings = (AudioSettings)malloc(sizeof(AudioSettingsMembers));
+  settings->sampleRate = DEFAULT_SAMPLE_RATE;
+  settings->numChannels = DEFAULT_NUM_CHANNELS;
+  settings->blocksize = DEFAULT_BLOCKSIZE;
+  settings->tempo = DEFAULT_TEMPO;
+  settings->timeSignatureBeatsPerMeasure = DEFAULT_TIMESIG_BEATS_PER_MEASURE;
+  settings->timeSignatureNoteValue = DEFAULT_TIMESIG_NOTE_VALUE;
+  settings->outputSampleFormat = DEFAULT_OUTPUT_SAMPLE_FORMAT;
+  settings->compressionLevel = DEFAULT_COMPRESSION_LEVEL;
+  settings->useHugePages = false;
+  settings->useWriteBehind = false;
+  return settings;
+}
+
 void initAudioSettings(void) {
-  if(audioSettingsInstance != NULL) {
+  AudioSettings* instance = _getAudioSettingsInstance();
+  if(*instance != NULL) {
     freeAudioSettings();
   }
-  audioSettingsInstance = malloc(sizeof(AudioSettingsMembers));
-  audioSettingsInstance->sampleRate = DEFAULT_SAMPLE_RATE;
-  audioSettingsInstance->numChannels = DEFAULT_NUM_CHANNELS;
-  audioSettingsInstance->blocksize = DEFAULT_BLOCKSIZE;
-  audioSettingsInstance->tempo = DEFAULT_TEMPO;
-  audioSettingsInstance->timeSignatureBeatsPerMeasure = DEFAULT_TIMESIG_BEATS_PER_MEASURE;
-  audioSettingsInstance->timeSignatureNoteValue = DEFAULT_TIMESIG_NOTE_VALUE;
+  *instance = newAudioSettings();
 }
 
 static AudioSettings _getAudioSettings(void) {
-  if(audioSettingsInstance == NULL) {
+  AudioSettings* instance = _getAudioSettingsInstance();
+  if(*instance == NULL) {
     initAudioSettings();
   }
-  return audioSettingsInstance;
+  return *instance;
 }
 
 double getSampleRate(void) {
@@ -79,6 +97,22 @@ unsigned short getTimeSignatureNoteValue(void) {
   return _getAudioSettings()->timeSignatureNoteValue;
 }
 
+PcmSampleFormat getOutputSampleFormat(void) {
+  return _getAudioSettings()->outputSampleFormat;
+}
+
+unsigned int getCompressionLevel(void) {
+  return _getAudioSettings()->compressionLevel;
+}
+
+boolByte getUseHugePages(void) {
+  return _getAudioSettings()->useHugePages;
+}
+
+boolByte getUseWriteBehind(void) {
+  return _getAudioSettings()->useWriteBehind;
+}
+
 
 void setSampleRate(const double sampleRate) {
   if(sampleRate <= 0.0f) {
@@ -182,7 +216,52 @@ boolByte setTimeSignatureFromMidiBytes(const byte* bytes) {
   return false;
 }
 
+boolByte setOutputSampleFormat(const PcmSampleFormat format) {
+  if(format >= PCM_SAMPLE_FORMAT_NUM_FORMATS) {
+    logError("Ignoring attempt to set invalid output sample format %d", format);
+    return false;
+  }
+  logInfo("Setting output sample format to %s", pcmSampleFormatGetName(format));
+  _getAudioSettings()->outputSampleFormat = format;
+  return true;
+}
+
+boolByte setOutputSampleFormatFromString(const CharString formatName) {
+  PcmSampleFormat format;
+  if(charStringIsEmpty(formatName)) {
+    return false;
+  }
+  format = pcmSampleFormatFromName(formatName->data);
+  if(format == PCM_SAMPLE_FORMAT_NUM_FORMATS) {
+    logError("Unknown output sample format '%s'", formatName->data);
+    return false;
+  }
+  return setOutputSampleFormat(format);
+}
+
+boolByte setCompressionLevel(const unsigned int compressionLevel) {
+  if(compressionLevel > MAX_COMPRESSION_LEVEL) {
+    logError("Ignoring attempt to set invalid compression level %d", compressionLevel);
+    return false;
+  }
+  logInfo("Setting compression level to %d", compressionLevel);
+  _getAudioSettings()->compressionLevel = compressionLevel;
+  return true;
+}
+
+void setUseHugePages(const boolByte useHugePages) {
+  if(useHugePages) {
+    logInfo("Using huge pages for large sample buffers");
+  }
+  _getAudioSettings()->useHugePages = useHugePages;
+}
+
+void setUseWriteBehind(const boolByte useWriteBehind) {
+  _getAudioSettings()->useWriteBehind = useWriteBehind;
+}
+
 void freeAudioSettings(void) {
-  free(audioSettingsInstance);
-  audioSettingsInstance = NULL;
+  AudioSettings* instance = _getAudioSettingsInstance();
+  free(*instance);
+  *instance = NULL;
 }
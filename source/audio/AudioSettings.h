@@ -28,6 +28,7 @@
 #ifndef MrsWatson_AudioSettings_h
 #define MrsWatson_AudioSettings_h
 
+#include "audio/PcmConversion.h"
 #include "base/Types.h"
 #include "base/CharString.h"
 
@@ -39,6 +40,9 @@
 #define DEFAULT_TEMPO 120.0f
 #define DEFAULT_TIMESIG_BEATS_PER_MEASURE 4
 #define DEFAULT_TIMESIG_NOTE_VALUE 4
+#define DEFAULT_OUTPUT_SAMPLE_FORMAT PCM_SAMPLE_FORMAT_INT16
+#define DEFAULT_COMPRESSION_LEVEL 5
+#define MAX_COMPRESSION_LEVEL 8
 
 typedef struct {
   double sampleRate;
@@ -47,15 +51,28 @@ typedef struct {
   float tempo;
   unsigned short timeSignatureBeatsPerMeasure;
   unsigned short timeSignatureNoteValue;
+  PcmSampleFormat outputSampleFormat;
+  unsigned int compressionLevel;
+  boolByte useHugePages;
+  boolByte useWriteBehind;
 } AudioSettingsMembers;
 
 typedef AudioSettingsMembers* AudioSettings;
 extern AudioSettings audioSettingsInstance;
 
 /**
- * Initialize the global audio settings instance. Since many different classes
- * require quick access to the audio settings, this is one of the few classes
- * that has a global singleton instance rather than a "new" allocator.
+ * Create a new audio settings object with the default values. This is mostly
+ * used by EngineContext, other code should use the getters and setters below.
+ * @return Initialized AudioSettings
+ */
+AudioSettings newAudioSettings(void);
+
+/**
+ * Initialize the audio settings instance. Since many different classes
+ * require quick access to the audio settings, they are reached through
+ * getters rather than passing an object around. The getters and setters use
+ * the settings of the current EngineContext, or a global instance if no
+ * context is current on the calling thread.
  */
 void initAudioSettings(void);
 
@@ -99,6 +116,34 @@ unsigned short getTimeSignatureBeatsPerMeasure(void);
  */
 unsigned short getTimeSignatureNoteValue(void);
 
+/**
+ * Get the sample format used when writing output files which support more
+ * than one format, such as WAVE files.
+ * @return Output sample format
+ */
+PcmSampleFormat getOutputSampleFormat(void);
+
+/**
+ * Get the compression level used when writing compressed output files, such
+ * as FLAC files.
+ * @return Compression level, from 0 (fastest) to MAX_COMPRESSION_LEVEL (smallest)
+ */
+unsigned int getCompressionLevel(void);
+
+/**
+ * Check whether large sample buffers should be backed by huge pages, see
+ * newSampleBuffer().
+ * @return True if huge pages should be used
+ */
+boolByte getUseHugePages(void);
+
+/**
+ * Check whether output files should be written on a separate thread, see
+ * sampleSourcePcmStartWriteBehind().
+ * @return True if write-behind is enabled
+ */
+boolByte getUseWriteBehind(void);
+
 /**
  * Set the sample rate to be used during processing. This must be set before the
  * plugin chain is initialized. This function only requires a nonzero value,
@@ -170,9 +215,44 @@ boolByte setTimeSignatureFromMidiBytes(const byte* bytes);
 boolByte setTimeSignatureFromString(const CharString signature);
 
 /**
- * Release memory of the global audio settings instance. Any attempt to use the
- * audio settings functions after this has been called will result in undefined
- * behavior.
+ * Set the sample format used when writing output files.
+ * @param format Output sample format
+ * @return True if successfully set, false otherwise
+ */
+boolByte setOutputSampleFormat(const PcmSampleFormat format);
+
+/**
+ * Set the output sample format from its name, for example "int24" or "float32".
+ * @param formatName Name of the format
+ * @return True if successfully set, false otherwise
+ */
+boolByte setOutputSampleFormatFromString(const CharString formatName);
+
+/**
+ * Set the compression level used when writing compressed output files.
+ * @param compressionLevel Compression level, from 0 to MAX_COMPRESSION_LEVEL
+ * @return True if successfully set, false otherwise
+ */
+boolByte setCompressionLevel(const unsigned int compressionLevel);
+
+/**
+ * Allow large sample buffers to be backed by huge pages where the platform
+ * supports it. Only buffers created after this call are affected. Disabled by
+ * default.
+ * @param useHugePages True to enable huge pages
+ */
+void setUseHugePages(const boolByte useHugePages);
+
+/**
+ * Enable or disable write-behind mode for all output sources which are opened
+ * afterwards. Disabled by default.
+ * @param useWriteBehind True to write output on a separate thread
+ */
+void setUseWriteBehind(const boolByte useWriteBehind);
+
+/**
+ * Release memory of the current audio settings instance. Calling any getter or
+ * setter afterwards will create a new instance with the default values.
  */
 void freeAudioSettings(void);
 
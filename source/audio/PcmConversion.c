@@ -0,0 +1,1003 @@
+//
+// PcmConversion.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <math.h>
+#include <string.h>
+
+#include "audio/PcmConversion.h"
+#include "base/PlatformUtilities.h"
+#include "logging/EventLogger.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define PCM_CONVERSION_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PCM_TARGET_SSE2
+#define PCM_TARGET_AVX2
+#else
+// Allows the kernels to be built without enabling these instruction sets for
+// the entire program, since they are only called when the CPU supports them
+#define PCM_TARGET_SSE2 __attribute__((target("sse2")))
+#define PCM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define PCM_CONVERSION_X86 0
+#endif
+
+// Number of samples converted at a time when data must pass through a
+// temporary buffer, small enough to stay in the L1 cache
+#define PCM_CONVERSION_CHUNK_SIZE 1024
+
+// Scaling and clipping ranges for each integer format. Note that the largest
+// 32-bit integer cannot be represented as a float, so the closest value below
+// it is used as the upper clipping bound instead.
+#define INT16_SCALE 32767.0f
+#define INT16_MIN_VALUE -32768.0f
+#define INT16_MAX_VALUE 32767.0f
+#define INT24_SCALE 8388607.0f
+#define INT24_MIN_VALUE -8388608.0f
+#define INT24_MAX_VALUE 8388607.0f
+#define INT32_SCALE 2147483648.0f
+#define INT32_MIN_VALUE -2147483648.0f
+#define INT32_MAX_VALUE 2147483520.0f
+
+// Convert a contiguous block of numSamples samples, regardless of channels
+typedef void (*_PcmToFloatFunc)(const void* in, Sample* out, unsigned long numSamples);
+typedef void (*_PcmFromFloatFunc)(const Sample* in, void* out, unsigned long numSamples);
+// Split interlaced stereo samples into two channels, and the reverse
+typedef void (*_DeinterleaveStereoFunc)(const Sample* in, Sample* left, Sample* right, unsigned long numFrames);
+typedef void (*_InterleaveStereoFunc)(const Sample* left, const Sample* right, Sample* out, unsigned long numFrames);
+// Reverse the byte order of numSamples samples in place
+typedef void (*_FlipEndianFunc)(void* pcm, unsigned long numSamples);
+
+typedef struct {
+  _PcmToFloatFunc toFloat[PCM_SAMPLE_FORMAT_NUM_FORMATS];
+  _PcmFromFloatFunc fromFloat[PCM_SAMPLE_FORMAT_NUM_FORMATS];
+  _DeinterleaveStereoFunc deinterleaveStereo;
+  _InterleaveStereoFunc interleaveStereo;
+  _FlipEndianFunc flipEndian[PCM_SAMPLE_FORMAT_NUM_FORMATS];
+} _PcmKernels;
+
+static const _PcmKernels* _kernels = NULL;
+static PcmInstructionSet _instructionSet = PCM_INSTRUCTION_SET_SCALAR;
+
+unsigned int pcmSampleFormatGetBytesPerSample(const PcmSampleFormat format) {
+  switch(format) {
+    case PCM_SAMPLE_FORMAT_INT16:
+      return 2;
+    case PCM_SAMPLE_FORMAT_INT24:
+      return 3;
+    case PCM_SAMPLE_FORMAT_INT32:
+    case PCM_SAMPLE_FORMAT_FLOAT32:
+      return 4;
+    case PCM_SAMPLE_FORMAT_FLOAT64:
+      return 8;
+    default:
+      logInternalError("Invalid PCM sample format %d", format);
+      return 0;
+  }
+}
+
+boolByte pcmSampleFormatIsFloat(const PcmSampleFormat format) {
+  return (boolByte)(format == PCM_SAMPLE_FORMAT_FLOAT32 || format == PCM_SAMPLE_FORMAT_FLOAT64);
+}
+
+const char* pcmSampleFormatGetName(const PcmSampleFormat format) {
+  switch(format) {
+    case PCM_SAMPLE_FORMAT_INT16:
+      return "int16";
+    case PCM_SAMPLE_FORMAT_INT24:
+      return "int24";
+    case PCM_SAMPLE_FORMAT_INT32:
+      return "int32";
+    case PCM_SAMPLE_FORMAT_FLOAT32:
+      return "float32";
+    case PCM_SAMPLE_FORMAT_FLOAT64:
+      return "float64";
+    default:
+      return "unknown";
+  }
+}
+
+PcmSampleFormat pcmSampleFormatFromName(const char* name) {
+  int i;
+  for(i = 0; i < PCM_SAMPLE_FORMAT_NUM_FORMATS; i++) {
+    if(name != NULL && strcmp(name, pcmSampleFormatGetName((PcmSampleFormat)i)) == 0) {
+      return (PcmSampleFormat)i;
+    }
+  }
+  return PCM_SAMPLE_FORMAT_NUM_FORMATS;
+}
+
+// Scalar kernels //////////////////////////////////////////////////////////////
+// These are the reference implementation, which the vectorized kernels must
+// match bit for bit. Clipping is written so that NaN is handled the same way
+// as the SIMD min/max instructions, and samples are rounded to the nearest
+// integer so that converting between integer formats loses as little as
+// possible.
+
+static Sample _clip(Sample value, Sample minValue, Sample maxValue) {
+  value = value > minValue ? value : minValue;
+  return value < maxValue ? value : maxValue;
+}
+
+static int _unpackInt24(const byte* in, boolByte littleEndian) {
+  int value;
+  if(littleEndian) {
+    value = in[0] | (in[1] << 8) | (in[2] << 16);
+  }
+  else {
+    value = (in[0] << 16) | (in[1] << 8) | in[2];
+  }
+  return (value & 0x800000) ? value - 0x1000000 : value;
+}
+
+static void _packInt24(int value, byte* out, boolByte littleEndian) {
+  unsigned int bits = (unsigned int)value;
+  if(littleEndian) {
+    out[0] = (byte)(bits & 0xff);
+    out[1] = (byte)((bits >> 8) & 0xff);
+    out[2] = (byte)((bits >> 16) & 0xff);
+  }
+  else {
+    out[0] = (byte)((bits >> 16) & 0xff);
+    out[1] = (byte)((bits >> 8) & 0xff);
+    out[2] = (byte)(bits & 0xff);
+  }
+}
+
+static void _int16ToFloatScalar(const void* in, Sample* out, unsigned long numSamples) {
+  const short* pcm = (const short*)in;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    out[i] = (Sample)pcm[i] / INT16_SCALE;
+  }
+}
+
+static void _int24ToFloatScalar(const void* in, Sample* out, unsigned long numSamples) {
+  const byte* pcm = (const byte*)in;
+  const boolByte littleEndian = isHostLittleEndian();
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    out[i] = (Sample)_unpackInt24(pcm + i * 3, littleEndian) / INT24_SCALE;
+  }
+}
+
+static void _int32ToFloatScalar(const void* in, Sample* out, unsigned long numSamples) {
+  const int* pcm = (const int*)in;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    out[i] = (Sample)pcm[i] / INT32_SCALE;
+  }
+}
+
+static void _float32ToFloat(const void* in, Sample* out, unsigned long numSamples) {
+  memcpy(out, in, sizeof(Sample) * numSamples);
+}
+
+static void _float64ToFloatScalar(const void* in, Sample* out, unsigned long numSamples) {
+  const double* pcm = (const double*)in;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    out[i] = (Sample)pcm[i];
+  }
+}
+
+static void _floatToInt16Scalar(const Sample* in, void* out, unsigned long numSamples) {
+  short* pcm = (short*)out;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    pcm[i] = (short)lrintf(_clip(in[i] * INT16_SCALE, INT16_MIN_VALUE, INT16_MAX_VALUE));
+  }
+}
+
+static void _floatToInt24Scalar(const Sample* in, void* out, unsigned long numSamples) {
+  byte* pcm = (byte*)out;
+  const boolByte littleEndian = isHostLittleEndian();
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    _packInt24((int)lrintf(_clip(in[i] * INT24_SCALE, INT24_MIN_VALUE, INT24_MAX_VALUE)), pcm + i * 3, littleEndian);
+  }
+}
+
+static void _floatToInt32Scalar(const Sample* in, void* out, unsigned long numSamples) {
+  int* pcm = (int*)out;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    pcm[i] = (int)lrintf(_clip(in[i] * INT32_SCALE, INT32_MIN_VALUE, INT32_MAX_VALUE));
+  }
+}
+
+static void _floatToFloat32(const Sample* in, void* out, unsigned long numSamples) {
+  memcpy(out, in, sizeof(Sample) * numSamples);
+}
+
+static void _floatToFloat64Scalar(const Sample* in, void* out, unsigned long numSamples) {
+  double* pcm = (double*)out;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    pcm[i] = (double)in[i];
+  }
+}
+
+static void _deinterleaveStereoScalar(const Sample* in, Sample* left, Sample* right, unsigned long numFrames) {
+  unsigned long i;
+  for(i = 0; i < numFrames; i++) {
+    left[i] = in[i * 2];
+    right[i] = in[i * 2 + 1];
+  }
+}
+
+static void _interleaveStereoScalar(const Sample* left, const Sample* right, Sample* out, unsigned long numFrames) {
+  unsigned long i;
+  for(i = 0; i < numFrames; i++) {
+    out[i * 2] = left[i];
+    out[i * 2 + 1] = right[i];
+  }
+}
+
+static void _flipEndian16Scalar(void* pcm, unsigned long numSamples) {
+  unsigned short* samples = (unsigned short*)pcm;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    samples[i] = (unsigned short)((samples[i] << 8) | (samples[i] >> 8));
+  }
+}
+
+static void _flipEndian24Scalar(void* pcm, unsigned long numSamples) {
+  byte* samples = (byte*)pcm;
+  byte swap;
+  unsigned long i;
+  for(i = 0; i < numSamples * 3; i += 3) {
+    swap = samples[i];
+    samples[i] = samples[i + 2];
+    samples[i + 2] = swap;
+  }
+}
+
+static void _flipEndian32Scalar(void* pcm, unsigned long numSamples) {
+  unsigned int* samples = (unsigned int*)pcm;
+  unsigned int value;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    value = samples[i];
+    samples[i] = (value << 24) | ((value << 8) & 0x00ff0000) | ((value >> 8) & 0x0000ff00) | (value >> 24);
+  }
+}
+
+static void _flipEndian64Scalar(void* pcm, unsigned long numSamples) {
+  unsigned int* samples = (unsigned int*)pcm;
+  unsigned int swap;
+  unsigned long i;
+  // Flip each half, and then swap the halves
+  _flipEndian32Scalar(pcm, numSamples * 2);
+  for(i = 0; i < numSamples * 2; i += 2) {
+    swap = samples[i];
+    samples[i] = samples[i + 1];
+    samples[i + 1] = swap;
+  }
+}
+
+static const _PcmKernels _scalarKernels = {
+  {_int16ToFloatScalar, _int24ToFloatScalar, _int32ToFloatScalar, _float32ToFloat, _float64ToFloatScalar},
+  {_floatToInt16Scalar, _floatToInt24Scalar, _floatToInt32Scalar, _floatToFloat32, _floatToFloat64Scalar},
+  _deinterleaveStereoScalar,
+  _interleaveStereoScalar,
+  {_flipEndian16Scalar, _flipEndian24Scalar, _flipEndian32Scalar, _flipEndian32Scalar, _flipEndian64Scalar}
+};
+
+#if PCM_CONVERSION_X86
+
+// SSE2 kernels ////////////////////////////////////////////////////////////////
+
+PCM_TARGET_SSE2
+static void _int16ToFloatSse2(const void* in, Sample* out, unsigned long numSamples) {
+  const short* pcm = (const short*)in;
+  const __m128 scale = _mm_set1_ps(INT16_SCALE);
+  __m128i packed;
+  __m128i low;
+  __m128i high;
+  unsigned long i = 0;
+
+  for(; i + 8 <= numSamples; i += 8) {
+    packed = _mm_loadu_si128((const __m128i*)(pcm + i));
+    // Sign-extend by placing each sample in the upper half of a 32-bit lane
+    low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+    high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+    _mm_storeu_ps(out + i, _mm_div_ps(_mm_cvtepi32_ps(low), scale));
+    _mm_storeu_ps(out + i + 4, _mm_div_ps(_mm_cvtepi32_ps(high), scale));
+  }
+  _int16ToFloatScalar(pcm + i, out + i, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static void _int24ToFloatSse2(const void* in, Sample* out, unsigned long numSamples) {
+  const byte* pcm = (const byte*)in;
+  const boolByte littleEndian = isHostLittleEndian();
+  const __m128 scale = _mm_set1_ps(INT24_SCALE);
+  __m128i unpacked;
+  unsigned long i = 0;
+
+  // SSE2 has no byte shuffle, so only the conversion is vectorized here
+  for(; i + 4 <= numSamples; i += 4) {
+    unpacked = _mm_setr_epi32(_unpackInt24(pcm + i * 3, littleEndian),
+      _unpackInt24(pcm + i * 3 + 3, littleEndian),
+      _unpackInt24(pcm + i * 3 + 6, littleEndian),
+      _unpackInt24(pcm + i * 3 + 9, littleEndian));
+    _mm_storeu_ps(out + i, _mm_div_ps(_mm_cvtepi32_ps(unpacked), scale));
+  }
+  _int24ToFloatScalar(pcm + i * 3, out + i, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static void _int32ToFloatSse2(const void* in, Sample* out, unsigned long numSamples) {
+  const int* pcm = (const int*)in;
+  const __m128 scale = _mm_set1_ps(INT32_SCALE);
+  unsigned long i = 0;
+
+  for(; i + 4 <= numSamples; i += 4) {
+    __m128i packed = _mm_loadu_si128((const __m128i*)(pcm + i));
+    _mm_storeu_ps(out + i, _mm_div_ps(_mm_cvtepi32_ps(packed), scale));
+  }
+  _int32ToFloatScalar(pcm + i, out + i, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static __m128i _floatToInt32LanesSse2(const Sample* in, __m128 scale, __m128 minValue, __m128 maxValue) {
+  __m128 value = _mm_mul_ps(_mm_loadu_ps(in), scale);
+  value = _mm_min_ps(_mm_max_ps(value, minValue), maxValue);
+  return _mm_cvtps_epi32(value);
+}
+
+PCM_TARGET_SSE2
+static void _floatToInt16Sse2(const Sample* in, void* out, unsigned long numSamples) {
+  short* pcm = (short*)out;
+  const __m128 scale = _mm_set1_ps(INT16_SCALE);
+  const __m128 minValue = _mm_set1_ps(INT16_MIN_VALUE);
+  const __m128 maxValue = _mm_set1_ps(INT16_MAX_VALUE);
+  __m128i low;
+  __m128i high;
+  unsigned long i = 0;
+
+  for(; i + 8 <= numSamples; i += 8) {
+    low = _floatToInt32LanesSse2(in + i, scale, minValue, maxValue);
+    high = _floatToInt32LanesSse2(in + i + 4, scale, minValue, maxValue);
+    _mm_storeu_si128((__m128i*)(pcm + i), _mm_packs_epi32(low, high));
+  }
+  _floatToInt16Scalar(in + i, pcm + i, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static void _floatToInt24Sse2(const Sample* in, void* out, unsigned long numSamples) {
+  byte* pcm = (byte*)out;
+  const boolByte littleEndian = isHostLittleEndian();
+  const __m128 scale = _mm_set1_ps(INT24_SCALE);
+  const __m128 minValue = _mm_set1_ps(INT24_MIN_VALUE);
+  const __m128 maxValue = _mm_set1_ps(INT24_MAX_VALUE);
+  int converted[4];
+  unsigned long i = 0;
+  unsigned int j;
+
+  for(; i + 4 <= numSamples; i += 4) {
+    _mm_storeu_si128((__m128i*)converted, _floatToInt32LanesSse2(in + i, scale, minValue, maxValue));
+    for(j = 0; j < 4; j++) {
+      _packInt24(converted[j], pcm + (i + j) * 3, littleEndian);
+    }
+  }
+  _floatToInt24Scalar(in + i, pcm + i * 3, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static void _floatToInt32Sse2(const Sample* in, void* out, unsigned long numSamples) {
+  int* pcm = (int*)out;
+  const __m128 scale = _mm_set1_ps(INT32_SCALE);
+  const __m128 minValue = _mm_set1_ps(INT32_MIN_VALUE);
+  const __m128 maxValue = _mm_set1_ps(INT32_MAX_VALUE);
+  unsigned long i = 0;
+
+  for(; i + 4 <= numSamples; i += 4) {
+    _mm_storeu_si128((__m128i*)(pcm + i), _floatToInt32LanesSse2(in + i, scale, minValue, maxValue));
+  }
+  _floatToInt32Scalar(in + i, pcm + i, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static void _float64ToFloatSse2(const void* in, Sample* out, unsigned long numSamples) {
+  const double* pcm = (const double*)in;
+  __m128 low;
+  __m128 high;
+  unsigned long i = 0;
+
+  for(; i + 4 <= numSamples; i += 4) {
+    low = _mm_cvtpd_ps(_mm_loadu_pd(pcm + i));
+    high = _mm_cvtpd_ps(_mm_loadu_pd(pcm + i + 2));
+    _mm_storeu_ps(out + i, _mm_movelh_ps(low, high));
+  }
+  _float64ToFloatScalar(pcm + i, out + i, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static void _floatToFloat64Sse2(const Sample* in, void* out, unsigned long numSamples) {
+  double* pcm = (double*)out;
+  __m128 samples;
+  unsigned long i = 0;
+
+  for(; i + 4 <= numSamples; i += 4) {
+    samples = _mm_loadu_ps(in + i);
+    _mm_storeu_pd(pcm + i, _mm_cvtps_pd(samples));
+    _mm_storeu_pd(pcm + i + 2, _mm_cvtps_pd(_mm_movehl_ps(samples, samples)));
+  }
+  _floatToFloat64Scalar(in + i, pcm + i, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static void _deinterleaveStereoSse2(const Sample* in, Sample* left, Sample* right, unsigned long numFrames) {
+  __m128 first;
+  __m128 second;
+  unsigned long i = 0;
+
+  for(; i + 4 <= numFrames; i += 4) {
+    first = _mm_loadu_ps(in + i * 2);
+    second = _mm_loadu_ps(in + i * 2 + 4);
+    _mm_storeu_ps(left + i, _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(right + i, _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  _deinterleaveStereoScalar(in + i * 2, left + i, right + i, numFrames - i);
+}
+
+PCM_TARGET_SSE2
+static void _interleaveStereoSse2(const Sample* left, const Sample* right, Sample* out, unsigned long numFrames) {
+  __m128 leftSamples;
+  __m128 rightSamples;
+  unsigned long i = 0;
+
+  for(; i + 4 <= numFrames; i += 4) {
+    leftSamples = _mm_loadu_ps(left + i);
+    rightSamples = _mm_loadu_ps(right + i);
+    _mm_storeu_ps(out + i * 2, _mm_unpacklo_ps(leftSamples, rightSamples));
+    _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(leftSamples, rightSamples));
+  }
+  _interleaveStereoScalar(left + i, right + i, out + i * 2, numFrames - i);
+}
+
+// Swap the bytes of each 16-bit lane
+PCM_TARGET_SSE2
+static __m128i _flipEndian16LanesSse2(__m128i value) {
+  return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+PCM_TARGET_SSE2
+static void _flipEndian16Sse2(void* pcm, unsigned long numSamples) {
+  unsigned short* samples = (unsigned short*)pcm;
+  unsigned long i = 0;
+
+  for(; i + 8 <= numSamples; i += 8) {
+    _mm_storeu_si128((__m128i*)(samples + i), _flipEndian16LanesSse2(_mm_loadu_si128((const __m128i*)(samples + i))));
+  }
+  _flipEndian16Scalar(samples + i, numSamples - i);
+}
+
+// SSE2 has no byte shuffle, so wider samples have the bytes of each 16-bit
+// lane swapped first, and then the order of the lanes reversed
+PCM_TARGET_SSE2
+static void _flipEndian32Sse2(void* pcm, unsigned long numSamples) {
+  unsigned int* samples = (unsigned int*)pcm;
+  __m128i value;
+  unsigned long i = 0;
+
+  for(; i + 4 <= numSamples; i += 4) {
+    value = _flipEndian16LanesSse2(_mm_loadu_si128((const __m128i*)(samples + i)));
+    value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+    _mm_storeu_si128((__m128i*)(samples + i), value);
+  }
+  _flipEndian32Scalar(samples + i, numSamples - i);
+}
+
+PCM_TARGET_SSE2
+static void _flipEndian64Sse2(void* pcm, unsigned long numSamples) {
+  unsigned int* samples = (unsigned int*)pcm;
+  __m128i value;
+  unsigned long i = 0;
+
+  for(; i + 2 <= numSamples; i += 2) {
+    value = _flipEndian16LanesSse2(_mm_loadu_si128((const __m128i*)(samples + i * 2)));
+    value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+    _mm_storeu_si128((__m128i*)(samples + i * 2), value);
+  }
+  _flipEndian64Scalar(samples + i * 2, numSamples - i);
+}
+
+static const _PcmKernels _sse2Kernels = {
+  {_int16ToFloatSse2, _int24ToFloatSse2, _int32ToFloatSse2, _float32ToFloat, _float64ToFloatSse2},
+  {_floatToInt16Sse2, _floatToInt24Sse2, _floatToInt32Sse2, _floatToFloat32, _floatToFloat64Sse2},
+  _deinterleaveStereoSse2,
+  _interleaveStereoSse2,
+  {_flipEndian16Sse2, _flipEndian24Scalar, _flipEndian32Sse2, _flipEndian32Sse2, _flipEndian64Sse2}
+};
+
+// AVX2 kernels ////////////////////////////////////////////////////////////////
+
+PCM_TARGET_AVX2
+static void _int16ToFloatAvx2(const void* in, Sample* out, unsigned long numSamples) {
+  const short* pcm = (const short*)in;
+  const __m256 scale = _mm256_set1_ps(INT16_SCALE);
+  __m256i unpacked;
+  unsigned long i = 0;
+
+  for(; i + 8 <= numSamples; i += 8) {
+    unpacked = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(pcm + i)));
+    _mm256_storeu_ps(out + i, _mm256_div_ps(_mm256_cvtepi32_ps(unpacked), scale));
+  }
+  _int16ToFloatScalar(pcm + i, out + i, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static void _int24ToFloatAvx2(const void* in, Sample* out, unsigned long numSamples) {
+  const byte* pcm = (const byte*)in;
+  const __m256 scale = _mm256_set1_ps(INT24_SCALE);
+  // Moves each 3-byte sample into the upper bytes of a 32-bit lane, so that an
+  // arithmetic shift sign-extends it. Each 128-bit lane holds 4 samples.
+  const __m256i shuffle = _mm256_setr_epi8(
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+  __m256i packed;
+  unsigned long i = 0;
+
+  // This is only valid on little-endian hosts, which all x86 CPUs are. Each
+  // iteration reads 28 bytes, so stop while at least that many remain.
+  for(; i + 10 <= numSamples; i += 8) {
+    packed = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(pcm + i * 3)));
+    packed = _mm256_inserti128_si256(packed, _mm_loadu_si128((const __m128i*)(pcm + i * 3 + 12)), 1);
+    packed = _mm256_srai_epi32(_mm256_shuffle_epi8(packed, shuffle), 8);
+    _mm256_storeu_ps(out + i, _mm256_div_ps(_mm256_cvtepi32_ps(packed), scale));
+  }
+  _int24ToFloatScalar(pcm + i * 3, out + i, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static void _int32ToFloatAvx2(const void* in, Sample* out, unsigned long numSamples) {
+  const int* pcm = (const int*)in;
+  const __m256 scale = _mm256_set1_ps(INT32_SCALE);
+  unsigned long i = 0;
+
+  for(; i + 8 <= numSamples; i += 8) {
+    __m256i packed = _mm256_loadu_si256((const __m256i*)(pcm + i));
+    _mm256_storeu_ps(out + i, _mm256_div_ps(_mm256_cvtepi32_ps(packed), scale));
+  }
+  _int32ToFloatScalar(pcm + i, out + i, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static __m256i _floatToInt32LanesAvx2(const Sample* in, __m256 scale, __m256 minValue, __m256 maxValue) {
+  __m256 value = _mm256_mul_ps(_mm256_loadu_ps(in), scale);
+  value = _mm256_min_ps(_mm256_max_ps(value, minValue), maxValue);
+  return _mm256_cvtps_epi32(value);
+}
+
+PCM_TARGET_AVX2
+static void _floatToInt16Avx2(const Sample* in, void* out, unsigned long numSamples) {
+  short* pcm = (short*)out;
+  const __m256 scale = _mm256_set1_ps(INT16_SCALE);
+  const __m256 minValue = _mm256_set1_ps(INT16_MIN_VALUE);
+  const __m256 maxValue = _mm256_set1_ps(INT16_MAX_VALUE);
+  __m256i low;
+  __m256i high;
+  __m256i packed;
+  unsigned long i = 0;
+
+  for(; i + 16 <= numSamples; i += 16) {
+    low = _floatToInt32LanesAvx2(in + i, scale, minValue, maxValue);
+    high = _floatToInt32LanesAvx2(in + i + 8, scale, minValue, maxValue);
+    // Packing works within each 128-bit lane, so the middle two quarters of
+    // the result must be swapped to restore the original order
+    packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256((__m256i*)(pcm + i), packed);
+  }
+  _floatToInt16Scalar(in + i, pcm + i, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static void _floatToInt24Avx2(const Sample* in, void* out, unsigned long numSamples) {
+  byte* pcm = (byte*)out;
+  const boolByte littleEndian = isHostLittleEndian();
+  const __m256 scale = _mm256_set1_ps(INT24_SCALE);
+  const __m256 minValue = _mm256_set1_ps(INT24_MIN_VALUE);
+  const __m256 maxValue = _mm256_set1_ps(INT24_MAX_VALUE);
+  int converted[8];
+  unsigned long i = 0;
+  unsigned int j;
+
+  for(; i + 8 <= numSamples; i += 8) {
+    _mm256_storeu_si256((__m256i*)converted, _floatToInt32LanesAvx2(in + i, scale, minValue, maxValue));
+    for(j = 0; j < 8; j++) {
+      _packInt24(converted[j], pcm + (i + j) * 3, littleEndian);
+    }
+  }
+  _floatToInt24Scalar(in + i, pcm + i * 3, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static void _floatToInt32Avx2(const Sample* in, void* out, unsigned long numSamples) {
+  int* pcm = (int*)out;
+  const __m256 scale = _mm256_set1_ps(INT32_SCALE);
+  const __m256 minValue = _mm256_set1_ps(INT32_MIN_VALUE);
+  const __m256 maxValue = _mm256_set1_ps(INT32_MAX_VALUE);
+  unsigned long i = 0;
+
+  for(; i + 8 <= numSamples; i += 8) {
+    _mm256_storeu_si256((__m256i*)(pcm + i), _floatToInt32LanesAvx2(in + i, scale, minValue, maxValue));
+  }
+  _floatToInt32Scalar(in + i, pcm + i, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static void _float64ToFloatAvx2(const void* in, Sample* out, unsigned long numSamples) {
+  const double* pcm = (const double*)in;
+  unsigned long i = 0;
+
+  for(; i + 4 <= numSamples; i += 4) {
+    _mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_loadu_pd(pcm + i)));
+  }
+  _float64ToFloatScalar(pcm + i, out + i, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static void _floatToFloat64Avx2(const Sample* in, void* out, unsigned long numSamples) {
+  double* pcm = (double*)out;
+  unsigned long i = 0;
+
+  for(; i + 4 <= numSamples; i += 4) {
+    _mm256_storeu_pd(pcm + i, _mm256_cvtps_pd(_mm_loadu_ps(in + i)));
+  }
+  _floatToFloat64Scalar(in + i, pcm + i, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static void _deinterleaveStereoAvx2(const Sample* in, Sample* left, Sample* right, unsigned long numFrames) {
+  __m256 first;
+  __m256 second;
+  __m256 shuffled;
+  unsigned long i = 0;
+
+  for(; i + 8 <= numFrames; i += 8) {
+    first = _mm256_loadu_ps(in + i * 2);
+    second = _mm256_loadu_ps(in + i * 2 + 8);
+    // Shuffling works within each 128-bit lane, which leaves pairs of frames
+    // in the order 0 2 1 3, so these are swapped back afterwards
+    shuffled = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+    _mm256_storeu_ps(left + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(shuffled), _MM_SHUFFLE(3, 1, 2, 0))));
+    shuffled = _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm256_storeu_ps(right + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(shuffled), _MM_SHUFFLE(3, 1, 2, 0))));
+  }
+  _deinterleaveStereoScalar(in + i * 2, left + i, right + i, numFrames - i);
+}
+
+PCM_TARGET_AVX2
+static void _interleaveStereoAvx2(const Sample* left, const Sample* right, Sample* out, unsigned long numFrames) {
+  __m256 leftSamples;
+  __m256 rightSamples;
+  __m256 low;
+  __m256 high;
+  unsigned long i = 0;
+
+  for(; i + 8 <= numFrames; i += 8) {
+    leftSamples = _mm256_loadu_ps(left + i);
+    rightSamples = _mm256_loadu_ps(right + i);
+    low = _mm256_unpacklo_ps(leftSamples, rightSamples);
+    high = _mm256_unpackhi_ps(leftSamples, rightSamples);
+    _mm256_storeu_ps(out + i * 2, _mm256_permute2f128_ps(low, high, 0x20));
+    _mm256_storeu_ps(out + i * 2 + 8, _mm256_permute2f128_ps(low, high, 0x31));
+  }
+  _interleaveStereoScalar(left + i, right + i, out + i * 2, numFrames - i);
+}
+
+// Reverse the bytes of each 32 bytes with a shuffle, where the mask gives the
+// source byte within each 128-bit lane
+PCM_TARGET_AVX2
+static void _flipEndianAvx2(byte* pcm, unsigned long numBytes, __m256i mask) {
+  unsigned long i;
+  for(i = 0; i + 32 <= numBytes; i += 32) {
+    _mm256_storeu_si256((__m256i*)(pcm + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(pcm + i)), mask));
+  }
+}
+
+PCM_TARGET_AVX2
+static void _flipEndian16Avx2(void* pcm, unsigned long numSamples) {
+  const __m256i mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  const unsigned long numVectorSamples = numSamples & ~15ul;
+  _flipEndianAvx2((byte*)pcm, numVectorSamples * 2, mask);
+  _flipEndian16Scalar((unsigned short*)pcm + numVectorSamples, numSamples - numVectorSamples);
+}
+
+PCM_TARGET_AVX2
+static void _flipEndian24Avx2(void* pcm, unsigned long numSamples) {
+  byte* samples = (byte*)pcm;
+  // Five samples fit in each 16 bytes, and the last byte is left as it is
+  const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+  unsigned long i = 0;
+
+  // The last byte which is stored belongs to the next sample, so it must exist
+  for(; i + 5 < numSamples; i += 5) {
+    _mm_storeu_si128((__m128i*)(samples + i * 3), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(samples + i * 3)), mask));
+  }
+  _flipEndian24Scalar(samples + i * 3, numSamples - i);
+}
+
+PCM_TARGET_AVX2
+static void _flipEndian32Avx2(void* pcm, unsigned long numSamples) {
+  const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  const unsigned long numVectorSamples = numSamples & ~7ul;
+  _flipEndianAvx2((byte*)pcm, numVectorSamples * 4, mask);
+  _flipEndian32Scalar((unsigned int*)pcm + numVectorSamples, numSamples - numVectorSamples);
+}
+
+PCM_TARGET_AVX2
+static void _flipEndian64Avx2(void* pcm, unsigned long numSamples) {
+  const __m256i mask = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  const unsigned long numVectorSamples = numSamples & ~3ul;
+  _flipEndianAvx2((byte*)pcm, numVectorSamples * 8, mask);
+  _flipEndian64Scalar((unsigned int*)pcm + numVectorSamples * 2, numSamples - numVectorSamples);
+}
+
+static const _PcmKernels _avx2Kernels = {
+  {_int16ToFloatAvx2, _int24ToFloatAvx2, _int32ToFloatAvx2, _float32ToFloat, _float64ToFloatAvx2},
+  {_floatToInt16Avx2, _floatToInt24Avx2, _floatToInt32Avx2, _floatToFloat32, _floatToFloat64Avx2},
+  _deinterleaveStereoAvx2,
+  _interleaveStereoAvx2,
+  {_flipEndian16Avx2, _flipEndian24Avx2, _flipEndian32Avx2, _flipEndian32Avx2, _flipEndian64Avx2}
+};
+
+#endif
+
+// Dispatch ////////////////////////////////////////////////////////////////////
+
+boolByte pcmIsInstructionSetSupported(const PcmInstructionSet instructionSet) {
+#if PCM_CONVERSION_X86 && defined(_MSC_VER)
+  int info[4];
+  int maxLeaf;
+#endif
+
+  switch(instructionSet) {
+    case PCM_INSTRUCTION_SET_SCALAR:
+      return true;
+#if PCM_CONVERSION_X86
+#if defined(_MSC_VER)
+    case PCM_INSTRUCTION_SET_SSE2:
+      __cpuid(info, 1);
+      return (boolByte)((info[3] & (1 << 26)) != 0);
+    case PCM_INSTRUCTION_SET_AVX2:
+      __cpuid(info, 0);
+      maxLeaf = info[0];
+      __cpuid(info, 1);
+      // Both the CPU and the OS must support AVX (OSXSAVE and AVX bits), and
+      // the OS must save the upper halves of the YMM registers
+      if(maxLeaf < 7 || (info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) {
+        return false;
+      }
+      if((_xgetbv(0) & 6) != 6) {
+        return false;
+      }
+      __cpuidex(info, 7, 0);
+      return (boolByte)((info[1] & (1 << 5)) != 0);
+#else
+    case PCM_INSTRUCTION_SET_SSE2:
+      __builtin_cpu_init();
+      return (boolByte)(__builtin_cpu_supports("sse2") != 0);
+    case PCM_INSTRUCTION_SET_AVX2:
+      __builtin_cpu_init();
+      return (boolByte)(__builtin_cpu_supports("avx2") != 0);
+#endif
+#endif
+    default:
+      return false;
+  }
+}
+
+boolByte pcmSetInstructionSet(const PcmInstructionSet instructionSet) {
+  if(!pcmIsInstructionSetSupported(instructionSet)) {
+    return false;
+  }
+
+  switch(instructionSet) {
+#if PCM_CONVERSION_X86
+    case PCM_INSTRUCTION_SET_SSE2:
+      _kernels = &_sse2Kernels;
+      break;
+    case PCM_INSTRUCTION_SET_AVX2:
+      _kernels = &_avx2Kernels;
+      break;
+#endif
+    default:
+      _kernels = &_scalarKernels;
+      break;
+  }
+  _instructionSet = instructionSet;
+  logDebug("Using %s kernels for PCM conversion", pcmInstructionSetGetName(instructionSet));
+  return true;
+}
+
+static const _PcmKernels* _getKernels(void) {
+  int i;
+  if(_kernels == NULL) {
+    for(i = PCM_INSTRUCTION_SET_NUM_SETS - 1; i >= 0; i--) {
+      if(pcmSetInstructionSet((PcmInstructionSet)i)) {
+        break;
+      }
+    }
+  }
+  return _kernels;
+}
+
+PcmInstructionSet pcmGetInstructionSet(void) {
+  _getKernels();
+  return _instructionSet;
+}
+
+const char* pcmInstructionSetGetName(const PcmInstructionSet instructionSet) {
+  switch(instructionSet) {
+    case PCM_INSTRUCTION_SET_SCALAR:
+      return "scalar";
+    case PCM_INSTRUCTION_SET_SSE2:
+      return "SSE2";
+    case PCM_INSTRUCTION_SET_AVX2:
+      return "AVX2";
+    default:
+      return "unknown";
+  }
+}
+
+// Conversion //////////////////////////////////////////////////////////////////
+
+void pcmDeinterleaveSamples(const void* inPcmSamples, const PcmSampleFormat format,
+  Samples* outSamples, const unsigned int numChannels, const unsigned long numFrames) {
+  const _PcmKernels* kernels = _getKernels();
+  const byte* pcm = (const byte*)inPcmSamples;
+  const unsigned int bytesPerSample = pcmSampleFormatGetBytesPerSample(format);
+  Sample chunk[PCM_CONVERSION_CHUNK_SIZE];
+  unsigned long chunkFrames;
+  unsigned long frame;
+  unsigned long numChunkFrames;
+  unsigned long i;
+  unsigned int channel;
+
+  if(numChannels == 0 || numFrames == 0 || bytesPerSample == 0) {
+    return;
+  }
+
+  // Mono data is already planar, so it can be converted in place
+  if(numChannels == 1) {
+    kernels->toFloat[format](pcm, outSamples[0], numFrames);
+    return;
+  }
+  // Nothing to convert, only split the channels
+  if(numChannels == 2 && format == PCM_SAMPLE_FORMAT_FLOAT32) {
+    kernels->deinterleaveStereo((const Sample*)inPcmSamples, outSamples[0], outSamples[1], numFrames);
+    return;
+  }
+
+  // Otherwise convert a chunk at a time into a temporary buffer, and split the
+  // channels from there
+  chunkFrames = PCM_CONVERSION_CHUNK_SIZE / numChannels;
+  if(chunkFrames == 0) {
+    chunkFrames = 1;
+  }
+  for(frame = 0; frame < numFrames; frame += numChunkFrames) {
+    numChunkFrames = numFrames - frame < chunkFrames ? numFrames - frame : chunkFrames;
+    if(numChannels > PCM_CONVERSION_CHUNK_SIZE) {
+      // Absurdly many channels, convert one sample at a time
+      for(channel = 0; channel < numChannels; channel++) {
+        kernels->toFloat[format](pcm + (frame * numChannels + channel) * bytesPerSample, outSamples[channel] + frame, 1);
+      }
+      continue;
+    }
+
+    kernels->toFloat[format](pcm + frame * numChannels * bytesPerSample, chunk, numChunkFrames * numChannels);
+    if(numChannels == 2) {
+      kernels->deinterleaveStereo(chunk, outSamples[0] + frame, outSamples[1] + frame, numChunkFrames);
+    }
+    else {
+      for(channel = 0; channel < numChannels; channel++) {
+        for(i = 0; i < numChunkFrames; i++) {
+          outSamples[channel][frame + i] = chunk[i * numChannels + channel];
+        }
+      }
+    }
+  }
+}
+
+void pcmInterleaveSamples(const Samples* inSamples, const unsigned int numChannels,
+  const unsigned long numFrames, void* outPcmSamples, const PcmSampleFormat format) {
+  const _PcmKernels* kernels = _getKernels();
+  byte* pcm = (byte*)outPcmSamples;
+  const unsigned int bytesPerSample = pcmSampleFormatGetBytesPerSample(format);
+  Sample chunk[PCM_CONVERSION_CHUNK_SIZE];
+  unsigned long chunkFrames;
+  unsigned long frame;
+  unsigned long numChunkFrames;
+  unsigned long i;
+  unsigned int channel;
+
+  if(numChannels == 0 || numFrames == 0 || bytesPerSample == 0) {
+    return;
+  }
+
+  if(numChannels == 1) {
+    kernels->fromFloat[format](inSamples[0], pcm, numFrames);
+    return;
+  }
+  if(numChannels == 2 && format == PCM_SAMPLE_FORMAT_FLOAT32) {
+    kernels->interleaveStereo(inSamples[0], inSamples[1], (Sample*)outPcmSamples, numFrames);
+    return;
+  }
+
+  chunkFrames = PCM_CONVERSION_CHUNK_SIZE / numChannels;
+  if(chunkFrames == 0) {
+    chunkFrames = 1;
+  }
+  for(frame = 0; frame < numFrames; frame += numChunkFrames) {
+    numChunkFrames = numFrames - frame < chunkFrames ? numFrames - frame : chunkFrames;
+    if(numChannels > PCM_CONVERSION_CHUNK_SIZE) {
+      for(channel = 0; channel < numChannels; channel++) {
+        kernels->fromFloat[format](inSamples[channel] + frame, pcm + (frame * numChannels + channel) * bytesPerSample, 1);
+      }
+      continue;
+    }
+
+    if(numChannels == 2) {
+      kernels->interleaveStereo(inSamples[0] + frame, inSamples[1] + frame, chunk, numChunkFrames);
+    }
+    else {
+      for(channel = 0; channel < numChannels; channel++) {
+        for(i = 0; i < numChunkFrames; i++) {
+          chunk[i * numChannels + channel] = inSamples[channel][frame + i];
+        }
+      }
+    }
+    kernels->fromFloat[format](chunk, pcm + frame * numChannels * bytesPerSample, numChunkFrames * numChannels);
+  }
+}
+
+void pcmConvertSamplesToInt(const Sample* inSamples, int* outSamples,
+  const unsigned long numSamples, const unsigned int bitsPerSample) {
+  const Sample scale = (Sample)((1l << (bitsPerSample - 1)) - 1);
+  const Sample minValue = -scale - 1.0f;
+  unsigned long i;
+  for(i = 0; i < numSamples; i++) {
+    outSamples[i] = (int)lrintf(_clip(inSamples[i] * scale, minValue, scale));
+  }
+}
+
+void pcmFlipEndian(void* pcmSamples, const PcmSampleFormat format, const unsigned long numSamples) {
+  if(format >= PCM_SAMPLE_FORMAT_NUM_FORMATS || numSamples == 0) {
+    return;
+  }
+  _getKernels()->flipEndian[format](pcmSamples, numSamples);
+}
@@ -0,0 +1,166 @@
+//
+// PcmConversion.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_PcmConversion_h
+#define MrsWatson_PcmConversion_h
+
+#include "audio/SampleBuffer.h"
+#include "base/Types.h"
+
+/**
+ * Formats of interlaced PCM data which can be converted to and from planar
+ * floating-point samples. All formats are expected to be in the host's byte
+ * order, see pcmFlipEndian() for data which is not.
+ */
+typedef enum {
+  // Signed 16-bit integers
+  PCM_SAMPLE_FORMAT_INT16,
+  // Signed 24-bit integers, packed into 3 bytes each
+  PCM_SAMPLE_FORMAT_INT24,
+  // Signed 32-bit integers
+  PCM_SAMPLE_FORMAT_INT32,
+  // 32-bit floating point, which is copied as-is
+  PCM_SAMPLE_FORMAT_FLOAT32,
+  // 64-bit floating point
+  PCM_SAMPLE_FORMAT_FLOAT64,
+  PCM_SAMPLE_FORMAT_NUM_FORMATS
+} PcmSampleFormat;
+
+/**
+ * Instruction sets which the conversion kernels may use. The best one which
+ * is supported by the CPU is picked the first time that samples are converted.
+ */
+typedef enum {
+  PCM_INSTRUCTION_SET_SCALAR,
+  PCM_INSTRUCTION_SET_SSE2,
+  PCM_INSTRUCTION_SET_AVX2,
+  PCM_INSTRUCTION_SET_NUM_SETS
+} PcmInstructionSet;
+
+/**
+ * @param format PCM sample format
+ * @return Number of bytes used by a single sample in this format
+ */
+unsigned int pcmSampleFormatGetBytesPerSample(const PcmSampleFormat format);
+
+/**
+ * @param format PCM sample format
+ * @return True if the format holds floating-point samples
+ */
+boolByte pcmSampleFormatIsFloat(const PcmSampleFormat format);
+
+/**
+ * @param format PCM sample format
+ * @return Name of the format, such as "int24"
+ */
+const char* pcmSampleFormatGetName(const PcmSampleFormat format);
+
+/**
+ * Find a sample format by name
+ * @param name Name of the format, as given by pcmSampleFormatGetName()
+ * @return Matching format, or PCM_SAMPLE_FORMAT_NUM_FORMATS if no format has
+ * this name
+ */
+PcmSampleFormat pcmSampleFormatFromName(const char* name);
+
+/**
+ * Convert interlaced PCM data to planar floating-point samples. Integer formats
+ * are scaled to the range of [-1.0, 1.0].
+ * @param inPcmSamples Interlaced data, which must hold numChannels * numFrames
+ * samples
+ * @param format Format of inPcmSamples
+ * @param outSamples Planar output, one array of at least numFrames samples for
+ * each channel
+ * @param numChannels Number of channels
+ * @param numFrames Number of frames to convert
+ */
+void pcmDeinterleaveSamples(const void* inPcmSamples, const PcmSampleFormat format,
+  Samples* outSamples, const unsigned int numChannels, const unsigned long numFrames);
+
+/**
+ * Convert planar floating-point samples to interlaced PCM data. When converting
+ * to integer formats, samples are rounded to the nearest integer and samples
+ * outside of the range of [-1.0, 1.0] are clipped.
+ * @param inSamples Planar input, one array of at least numFrames samples for
+ * each channel
+ * @param numChannels Number of channels
+ * @param numFrames Number of frames to convert
+ * @param outPcmSamples Pre-allocated array large enough to hold numChannels *
+ * numFrames samples of the given format
+ * @param format Format of outPcmSamples
+ */
+void pcmInterleaveSamples(const Samples* inSamples, const unsigned int numChannels,
+  const unsigned long numFrames, void* outPcmSamples, const PcmSampleFormat format);
+
+/**
+ * Convert floating-point samples to integers with the given number of bits,
+ * which are rounded and clipped in the same way as by pcmInterleaveSamples().
+ * This is used by encoders which work on whole integers rather than PCM data.
+ * @param inSamples Samples to convert
+ * @param outSamples Pre-allocated array of at least numSamples integers
+ * @param numSamples Number of samples to convert
+ * @param bitsPerSample Size of the output samples, from 8 to 24 bits
+ */
+void pcmConvertSamplesToInt(const Sample* inSamples, int* outSamples,
+  const unsigned long numSamples, const unsigned int bitsPerSample);
+
+/**
+ * Reverse the byte order of each sample in a block of PCM data
+ * @param pcmSamples PCM data to flip in place
+ * @param format Format of pcmSamples
+ * @param numSamples Total number of samples (not frames) in pcmSamples
+ */
+void pcmFlipEndian(void* pcmSamples, const PcmSampleFormat format, const unsigned long numSamples);
+
+/**
+ * @param instructionSet Instruction set to check
+ * @return True if this CPU (and build) is able to use the instruction set
+ */
+boolByte pcmIsInstructionSetSupported(const PcmInstructionSet instructionSet);
+
+/**
+ * @return The instruction set currently used by the conversion kernels
+ */
+PcmInstructionSet pcmGetInstructionSet(void);
+
+/**
+ * Force the conversion kernels to use a given instruction set. Mostly useful
+ * for testing and benchmarking, since the fastest supported instruction set is
+ * otherwise picked automatically.
+ * @param instructionSet Instruction set to use
+ * @return True if the instruction set was selected, false if it is not
+ * supported on this CPU
+ */
+boolByte pcmSetInstructionSet(const PcmInstructionSet instructionSet);
+
+/**
+ * @param instructionSet Instruction set
+ * @return Short name of the instruction set, such as "AVX2"
+ */
+const char* pcmInstructionSetGetName(const PcmInstructionSet instructionSet);
+
+#endif
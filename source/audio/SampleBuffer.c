@@ -25,25 +25,108 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#if LINUX
+// Needed for MAP_ANONYMOUS and MAP_HUGETLB
+#define _DEFAULT_SOURCE 1
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "audio/AudioSettings.h"
+#include "audio/PcmConversion.h"
 #include "audio/SampleBuffer.h"
 #include "base/PlatformUtilities.h"
 #include "logging/EventLogger.h"
 
+#if WINDOWS
+#include <malloc.h>
+#elif LINUX
+#include <sys/mman.h>
+#endif
+
+#define SAMPLES_PER_ALIGNMENT (SAMPLE_BUFFER_ALIGNMENT / sizeof(Sample))
+
+static unsigned long _roundUp(unsigned long value, unsigned long multiple) {
+  return ((value + multiple - 1) / multiple) * multiple;
+}
+
+#if LINUX
+static void* _allocateHugePages(unsigned long size) {
+  void* result = mmap(NULL, size, PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  return result == MAP_FAILED ? NULL : result;
+}
+#endif
+
+static void* _allocateAligned(unsigned long size) {
+#if WINDOWS
+  return _aligned_malloc(size, SAMPLE_BUFFER_ALIGNMENT);
+#else
+  void* result = NULL;
+  if(posix_memalign(&result, SAMPLE_BUFFER_ALIGNMENT, size) != 0) {
+    return NULL;
+  }
+  return result;
+#endif
+}
+
+static void _freeAligned(void* data) {
+#if WINDOWS
+  _aligned_free(data);
+#else
+  free(data);
+#endif
+}
+
 SampleBuffer newSampleBuffer(unsigned int numChannels, unsigned long blocksize) {
   SampleBuffer sampleBuffer = NULL;
+  unsigned long pointersSize;
   unsigned int i;
+  byte* channelData;
 
   sampleBuffer = (SampleBuffer)malloc(sizeof(SampleBufferMembers));
   sampleBuffer->numChannels = numChannels;
   sampleBuffer->blocksize = blocksize;
+  sampleBuffer->_channelStride = _roundUp(blocksize, SAMPLES_PER_ALIGNMENT);
+  sampleBuffer->_isHugePageBacked = false;
+
+  // The samples array is placed at the start of the storage, padded so that
+  // the first channel which follows it is also aligned
+  pointersSize = _roundUp(sizeof(Samples) * numChannels, SAMPLE_BUFFER_ALIGNMENT);
+  sampleBuffer->_storageSize = pointersSize +
+    sizeof(Sample) * sampleBuffer->_channelStride * numChannels;
+  // Allocate at least one aligned block, even for empty buffers
+  if(sampleBuffer->_storageSize == 0) {
+    sampleBuffer->_storageSize = SAMPLE_BUFFER_ALIGNMENT;
+  }
 
-  sampleBuffer->samples = (Samples*)malloc(sizeof(Samples) * numChannels);
+  sampleBuffer->_storage = NULL;
+#if LINUX
+  if(sampleBuffer->_storageSize >= SAMPLE_BUFFER_HUGE_PAGE_THRESHOLD && getUseHugePages()) {
+    sampleBuffer->_storageSize = _roundUp(sampleBuffer->_storageSize, SAMPLE_BUFFER_HUGE_PAGE_THRESHOLD);
+    sampleBuffer->_storage = _allocateHugePages(sampleBuffer->_storageSize);
+    if(sampleBuffer->_storage != NULL) {
+      sampleBuffer->_isHugePageBacked = true;
+    } else {
+      logDebug("Huge pages not available, using regular allocation for %lu bytes", sampleBuffer->_storageSize);
+    }
+  }
+#endif
+  if(sampleBuffer->_storage == NULL) {
+    sampleBuffer->_storage = _allocateAligned(sampleBuffer->_storageSize);
+  }
+  if(sampleBuffer->_storage == NULL) {
+    logCritical("Could not allocate %lu bytes for sample buffer", sampleBuffer->_storageSize);
+    free(sampleBuffer);
+    return NULL;
+  }
+
+  sampleBuffer->samples = (Samples*)sampleBuffer->_storage;
+  channelData = (byte*)sampleBuffer->_storage + pointersSize;
   for(i = 0; i < numChannels; i++) {
-    sampleBuffer->samples[i] = (Samples)malloc(sizeof(Sample) * blocksize);
+    sampleBuffer->samples[i] = (Samples)channelData + i * sampleBuffer->_channelStride;
   }
   sampleBufferClear(sampleBuffer);
 
@@ -110,54 +193,27 @@ boolByte sampleBufferCopyAndMapChannels(SampleBuffer self, const SampleBuffer bu
 }
 
 void sampleBufferCopyPcmSamples(SampleBuffer self, const short* inPcmSamples) {
-  const unsigned int numChannels = self->numChannels;
-  const unsigned long numInterlacedSamples = numChannels * self->blocksize;
-  unsigned int currentInterlacedSample = 0;
-  unsigned int currentDeinterlacedSample = 0;
-  unsigned int currentChannel;
-
-  while(currentInterlacedSample < numInterlacedSamples) {
-    for(currentChannel = 0; currentChannel < numChannels; ++currentChannel) {
-      Sample convertedSample = (Sample)inPcmSamples[currentInterlacedSample++] / 32767.0f;
-      self->samples[currentChannel][currentDeinterlacedSample] = convertedSample;
-    }
-    ++currentDeinterlacedSample;
-  }
+  pcmDeinterleaveSamples(inPcmSamples, PCM_SAMPLE_FORMAT_INT16, self->samples, self->numChannels, self->blocksize);
 }
 
 void sampleBufferGetPcmSamples(const SampleBuffer self, short* outPcmSamples, boolByte flipEndian) {
-  const unsigned long blocksize = self->blocksize;
-  const unsigned int numChannels = self->numChannels;
-  unsigned int currentInterlacedSample = 0;
-  unsigned int currentSample = 0;
-  unsigned int currentChannel = 0;
-  short shortValue;
-  Sample sample;
-
-  for(currentSample = 0; currentSample < blocksize; ++currentSample) {
-    for(currentChannel = 0; currentChannel < numChannels; ++currentChannel) {
-      sample = self->samples[currentChannel][currentSample];
-      shortValue = (short)(sample * 32767.0f);
-      if(flipEndian) {
-        outPcmSamples[currentInterlacedSample++] = flipShortEndian(shortValue);
-      }
-      else {
-        outPcmSamples[currentInterlacedSample++] = shortValue;
-      }
-    }
+  pcmInterleaveSamples(self->samples, self->numChannels, self->blocksize, outPcmSamples, PCM_SAMPLE_FORMAT_INT16);
+  if(flipEndian) {
+    pcmFlipEndian(outPcmSamples, PCM_SAMPLE_FORMAT_INT16, self->numChannels * self->blocksize);
   }
 }
 
 void freeSampleBuffer(SampleBuffer sampleBuffer) {
-  unsigned int i;
   if(sampleBuffer == NULL) {
     return;
   }
-  if(sampleBuffer->samples != NULL) {
-    for(i = 0; i < sampleBuffer->numChannels; i++) {
-      free(sampleBuffer->samples[i]);
-    }
-    free(sampleBuffer->samples);
+#if LINUX
+  if(sampleBuffer->_isHugePageBacked) {
+    munmap(sampleBuffer->_storage, sampleBuffer->_storageSize);
+    free(sampleBuffer);
+    return;
   }
+#endif
+  _freeAligned(sampleBuffer->_storage);
   free(sampleBuffer);
 }
@@ -33,15 +33,36 @@
 typedef float Sample;
 typedef Sample* Samples;
 
+// Alignment (in bytes) of each channel in a SampleBuffer. This is the size of
+// a cache line on most hardware, and is also enough for any SIMD load.
+#define SAMPLE_BUFFER_ALIGNMENT 64
+// Buffers at least this large (in bytes) may be backed by huge pages, see
+// setUseHugePages()
+#define SAMPLE_BUFFER_HUGE_PAGE_THRESHOLD (2 * 1024 * 1024)
+
 typedef struct {
   unsigned int numChannels;
   unsigned long blocksize;
+  // Planar view of the sample data. Each channel starts on an aligned address,
+  // and channels are laid out one after the other in a single allocation.
   Samples* samples;
+
+  // Number of samples between the start of each channel, which is the
+  // blocksize rounded up to a multiple of the alignment
+  unsigned long _channelStride;
+  // Holds both the samples array and the sample data
+  void* _storage;
+  unsigned long _storageSize;
+  boolByte _isHugePageBacked;
 } SampleBufferMembers;
 typedef SampleBufferMembers* SampleBuffer;
 
 /**
- * Create a new SampleBuffer instance
+ * Create a new SampleBuffer instance. When getUseHugePages() is set, buffers of
+ * at least SAMPLE_BUFFER_HUGE_PAGE_THRESHOLD bytes are backed by huge pages
+ * where the platform supports it, which can reduce TLB misses when processing
+ * very long blocks. If no huge pages are available, the buffer falls back to a
+ * regular aligned allocation.
  * @param numChannels Number of channels
  * @param blocksize Processing blocksize to use
  * @return An initialized SampleBuffer instance
@@ -87,7 +108,8 @@ void sampleBufferCopyPcmSamples(SampleBuffer self, const short* inPcmSamples);
 /**
  * Get an array of interlaced short integer samples from the SampleBuffer. This
  * function will also convert the samples from floating-point numbers to short
- * integers. Mostly useful for writing raw PCM data.
+ * integers, clipping any samples outside of [-1.0, 1.0]. Mostly useful for
+ * writing raw PCM data.
  * @param self
  * @param outPcmSamples A pre-allocated array large enough to hold the result of
  * the conversion. This means that at least blocksize * channel count samples
@@ -0,0 +1,206 @@
+//
+// SampleBufferQueue.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+
+#include "audio/SampleBufferQueue.h"
+#include "base/Thread.h"
+
+SampleBufferQueue newSampleBufferQueue(unsigned long capacity, unsigned int numChannels, unsigned long blocksize) {
+  return newSampleBufferQueueWithConsumers(capacity, 1, numChannels, blocksize);
+}
+
+SampleBufferQueue newSampleBufferQueueWithConsumers(unsigned long capacity, unsigned int numConsumers,
+  unsigned int numChannels, unsigned long blocksize) {
+  SampleBufferQueue queue = (SampleBufferQueue)malloc(sizeof(SampleBufferQueueMembers));
+  unsigned long i;
+
+  queue->capacity = capacity > 0 ? capacity : 1;
+  queue->buffers = (SampleBuffer*)malloc(sizeof(SampleBuffer) * queue->capacity);
+  queue->lastBlockFlags = (boolByte*)malloc(sizeof(boolByte) * queue->capacity);
+  for(i = 0; i < queue->capacity; i++) {
+    queue->buffers[i] = newSampleBuffer(numChannels, blocksize);
+    queue->lastBlockFlags[i] = false;
+  }
+
+  queue->numConsumers = numConsumers > 0 ? numConsumers : 1;
+  queue->_writeCount = 0;
+  queue->_readCounts = (volatile unsigned long*)malloc(sizeof(unsigned long) * queue->numConsumers);
+  for(i = 0; i < queue->numConsumers; i++) {
+    queue->_readCounts[i] = 0;
+  }
+  queue->_cancelled = false;
+  queue->_signal = newThreadSignal();
+
+  queue->numBlocksPushed = 0;
+  queue->occupancySum = 0;
+  queue->maxOccupancy = 0;
+  queue->producerStalls = 0;
+  queue->consumerStalls = 0;
+
+  return queue;
+}
+
+// Read count of the consumer which is furthest behind
+static unsigned long _sampleBufferQueueGetMinReadCount(SampleBufferQueue self) {
+  unsigned long minReadCount = self->_readCounts[0];
+  unsigned int i;
+  for(i = 1; i < self->numConsumers; i++) {
+    if(self->_readCounts[i] < minReadCount) {
+      minReadCount = self->_readCounts[i];
+    }
+  }
+  return minReadCount;
+}
+
+SampleBuffer sampleBufferQueueAcquireWrite(SampleBufferQueue self) {
+  boolByte stalled = false;
+  unsigned long generation;
+
+  for(;;) {
+    generation = threadSignalGetGeneration(self->_signal);
+    if(self->_cancelled) {
+      return NULL;
+    }
+    if(self->_writeCount - _sampleBufferQueueGetMinReadCount(self) < self->capacity) {
+      break;
+    }
+    stalled = true;
+    threadSignalWait(self->_signal, generation);
+  }
+  if(stalled) {
+    self->producerStalls++;
+  }
+  // Make sure the consumer is really finished with this slot before reusing it
+  threadMemoryBarrier();
+  return self->_cancelled ? NULL : self->buffers[self->_writeCount % self->capacity];
+}
+
+void sampleBufferQueueCommitWrite(SampleBufferQueue self, boolByte isLastBlock) {
+  unsigned long occupancy;
+
+  self->lastBlockFlags[self->_writeCount % self->capacity] = isLastBlock;
+  // The buffer contents must be visible before the consumer sees the new count
+  threadMemoryBarrier();
+  self->_writeCount++;
+  threadSignalNotify(self->_signal);
+
+  occupancy = self->_writeCount - _sampleBufferQueueGetMinReadCount(self);
+  self->numBlocksPushed++;
+  self->occupancySum += occupancy;
+  if(occupancy > self->maxOccupancy) {
+    self->maxOccupancy = occupancy;
+  }
+}
+
+SampleBuffer sampleBufferQueueAcquireRead(SampleBufferQueue self, boolByte* outIsLastBlock) {
+  return sampleBufferQueueAcquireReadForConsumer(self, 0, outIsLastBlock);
+}
+
+SampleBuffer sampleBufferQueueAcquireReadForConsumer(SampleBufferQueue self, unsigned int consumer,
+  boolByte* outIsLastBlock) {
+  unsigned long index;
+  unsigned long generation;
+  boolByte stalled = false;
+
+  for(;;) {
+    generation = threadSignalGetGeneration(self->_signal);
+    if(self->_writeCount != self->_readCounts[consumer]) {
+      break;
+    }
+    if(self->_cancelled) {
+      return NULL;
+    }
+    stalled = true;
+    threadSignalWait(self->_signal, generation);
+  }
+  if(stalled && consumer == 0) {
+    self->consumerStalls++;
+  }
+  threadMemoryBarrier();
+
+  index = self->_readCounts[consumer] % self->capacity;
+  if(outIsLastBlock != NULL) {
+    *outIsLastBlock = self->lastBlockFlags[index];
+  }
+  return self->buffers[index];
+}
+
+void sampleBufferQueueCommitRead(SampleBufferQueue self) {
+  sampleBufferQueueCommitReadForConsumer(self, 0);
+}
+
+void sampleBufferQueueCommitReadForConsumer(SampleBufferQueue self, unsigned int consumer) {
+  // Finish reading the buffer before handing the slot back to the producer
+  threadMemoryBarrier();
+  self->_readCounts[consumer]++;
+  threadSignalNotify(self->_signal);
+}
+
+unsigned long sampleBufferQueueGetOccupancy(SampleBufferQueue self) {
+  return self->_writeCount - _sampleBufferQueueGetMinReadCount(self);
+}
+
+double sampleBufferQueueGetAverageOccupancy(SampleBufferQueue self) {
+  if(self->numBlocksPushed == 0) {
+    return 0.0;
+  }
+  return (double)self->occupancySum / (double)self->numBlocksPushed;
+}
+
+void sampleBufferQueueCancel(SampleBufferQueue self) {
+  self->_cancelled = true;
+  threadMemoryBarrier();
+  threadSignalNotify(self->_signal);
+}
+
+void sampleBufferQueueReset(SampleBufferQueue self) {
+  unsigned long i;
+  for(i = 0; i < self->capacity; i++) {
+    self->lastBlockFlags[i] = false;
+  }
+  for(i = 0; i < self->numConsumers; i++) {
+    self->_readCounts[i] = 0;
+  }
+  self->_writeCount = 0;
+  self->_cancelled = false;
+  threadMemoryBarrier();
+}
+
+void freeSampleBufferQueue(SampleBufferQueue self) {
+  unsigned long i;
+  if(self != NULL) {
+    for(i = 0; i < self->capacity; i++) {
+      freeSampleBuffer(self->buffers[i]);
+    }
+    free(self->buffers);
+    free(self->lastBlockFlags);
+    free((void*)self->_readCounts);
+    freeThreadSignal(self->_signal);
+    free(self);
+  }
+}
@@ -0,0 +1,185 @@
+//
+// SampleBufferQueue.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_SampleBufferQueue_h
+#define MrsWatson_SampleBufferQueue_h
+
+#include "audio/SampleBuffer.h"
+#include "base/Thread.h"
+#include "base/Types.h"
+
+/**
+ * A bounded queue of SampleBuffers which is shared between exactly one
+ * producer thread and one or more consumer threads. All buffers are allocated
+ * up front, and blocks are handed off by reference, so no copying or allocation
+ * takes place once processing has started. With several consumers, each one
+ * sees every block, and a slot is only reused after all consumers have
+ * released it. Consumers must then treat the buffers as read-only. The slot
+ * counters are read without locking, but threads which have to wait for a slot
+ * block on a ThreadSignal, and each commit notifies it, which takes its mutex.
+ */
+typedef struct {
+  unsigned long capacity;
+  SampleBuffer* buffers;
+  boolByte* lastBlockFlags;
+
+  unsigned int numConsumers;
+
+  // Monotonically increasing counters, the slot index is found by taking the
+  // counter modulo the capacity. The write counter is only modified by the
+  // producer and each read counter only by its consumer.
+  volatile unsigned long _writeCount;
+  volatile unsigned long* _readCounts;
+  volatile boolByte _cancelled;
+  // Notified whenever a block is published or released, or the queue is
+  // cancelled, so that waiting threads can sleep instead of polling
+  ThreadSignal _signal;
+
+  // Statistics, updated by the producer (occupancy, producer stalls) and the
+  // first consumer (consumer stalls). Occupancy is measured against the
+  // slowest consumer.
+  unsigned long numBlocksPushed;
+  unsigned long occupancySum;
+  unsigned long maxOccupancy;
+  unsigned long producerStalls;
+  unsigned long consumerStalls;
+} SampleBufferQueueMembers;
+typedef SampleBufferQueueMembers* SampleBufferQueue;
+
+/**
+ * Create a new queue and allocate all buffers it will hold.
+ * @param capacity Maximum number of blocks which may be queued at once
+ * @param numChannels Number of channels for each buffer
+ * @param blocksize Blocksize for each buffer
+ * @return An initialized SampleBufferQueue instance
+ */
+SampleBufferQueue newSampleBufferQueue(unsigned long capacity, unsigned int numChannels, unsigned long blocksize);
+
+/**
+ * Create a new queue which hands each block to several consumers.
+ * @param capacity Maximum number of blocks which may be queued at once
+ * @param numConsumers Number of consumer threads, each of which must read
+ * every block
+ * @param numChannels Number of channels for each buffer
+ * @param blocksize Blocksize for each buffer
+ * @return An initialized SampleBufferQueue instance
+ */
+SampleBufferQueue newSampleBufferQueueWithConsumers(unsigned long capacity, unsigned int numConsumers,
+  unsigned int numChannels, unsigned long blocksize);
+
+/**
+ * Get the next free buffer for the producer to fill. If the queue is full, this
+ * call waits until all consumers have released the oldest block. Must only be called from the
+ * producer thread.
+ * @param self
+ * @return Buffer to write to, or NULL if the queue has been cancelled
+ */
+SampleBuffer sampleBufferQueueAcquireWrite(SampleBufferQueue self);
+
+/**
+ * Publish the buffer obtained with sampleBufferQueueAcquireWrite() to the
+ * consumer. Must only be called from the producer thread.
+ * @param self
+ * @param isLastBlock True if this is the final block which will be produced
+ */
+void sampleBufferQueueCommitWrite(SampleBufferQueue self, boolByte isLastBlock);
+
+/**
+ * Get the oldest published buffer. If the queue is empty, this call waits
+ * until the producer publishes a block. Must only be called from the consumer
+ * thread, or from the first consumer if the queue has several.
+ * @param self
+ * @param outIsLastBlock Set to true if this is the final block, may be NULL
+ * @return Buffer to read from, or NULL if the queue has been cancelled
+ */
+SampleBuffer sampleBufferQueueAcquireRead(SampleBufferQueue self, boolByte* outIsLastBlock);
+
+/**
+ * Get the oldest buffer published which the given consumer has not yet read.
+ * If there is none, this call waits until the producer publishes a block. Must
+ * only be called from the thread of that consumer.
+ * @param self
+ * @param consumer Index of the consumer, starting at 0
+ * @param outIsLastBlock Set to true if this is the final block, may be NULL
+ * @return Buffer to read from, or NULL if the queue has been cancelled
+ */
+SampleBuffer sampleBufferQueueAcquireReadForConsumer(SampleBufferQueue self, unsigned int consumer,
+  boolByte* outIsLastBlock);
+
+/**
+ * Release the buffer obtained with sampleBufferQueueAcquireRead() so that it
+ * may be reused by the producer. Must only be called from the consumer thread.
+ * @param self
+ */
+void sampleBufferQueueCommitRead(SampleBufferQueue self);
+
+/**
+ * Release the buffer obtained with sampleBufferQueueAcquireReadForConsumer().
+ * Must only be called from the thread of that consumer.
+ * @param self
+ * @param consumer Index of the consumer, starting at 0
+ */
+void sampleBufferQueueCommitReadForConsumer(SampleBufferQueue self, unsigned int consumer);
+
+/**
+ * Get the number of blocks currently waiting to be consumed by the slowest
+ * consumer.
+ * @param self
+ * @return Number of queued blocks
+ */
+unsigned long sampleBufferQueueGetOccupancy(SampleBufferQueue self);
+
+/**
+ * Get the average number of queued blocks, as measured each time a block was
+ * published.
+ * @param self
+ * @return Average occupancy, in blocks
+ */
+double sampleBufferQueueGetAverageOccupancy(SampleBufferQueue self);
+
+/**
+ * Wake up any thread waiting on the queue and cause all further acquire calls
+ * to return NULL. May be called from any thread.
+ * @param self
+ */
+void sampleBufferQueueCancel(SampleBufferQueue self);
+
+/**
+ * Discard any queued blocks and clear the cancelled state so that the queue
+ * can be used for another run. Statistics are kept. Must only be called when
+ * no other thread is using the queue.
+ * @param self
+ */
+void sampleBufferQueueReset(SampleBufferQueue self);
+
+/**
+ * Free a queue and all of its buffers
+ * @param self
+ */
+void freeSampleBufferQueue(SampleBufferQueue self);
+
+#endif
@@ -0,0 +1,118 @@
+//
+// AllocationCounter.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+
+#include "base/AllocationCounter.h"
+#include "base/Thread.h"
+
+#if WITH_ALLOCATION_COUNTER
+static volatile unsigned long numAllocations = 0;
+static volatile unsigned long numFrees = 0;
+static THREAD_LOCAL boolByte countingOnThisThread = false;
+
+// Provided by the linker when linking with --wrap=malloc, etc.
+extern void* __real_malloc(size_t size);
+extern void* __real_calloc(size_t numItems, size_t size);
+extern void* __real_realloc(void* ptr, size_t size);
+extern void __real_free(void* ptr);
+
+void* __wrap_malloc(size_t size);
+void* __wrap_malloc(size_t size) {
+  if(countingOnThisThread) {
+    __sync_fetch_and_add(&numAllocations, 1);
+  }
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t numItems, size_t size);
+void* __wrap_calloc(size_t numItems, size_t size) {
+  if(countingOnThisThread) {
+    __sync_fetch_and_add(&numAllocations, 1);
+  }
+  return __real_calloc(numItems, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size);
+void* __wrap_realloc(void* ptr, size_t size) {
+  if(countingOnThisThread) {
+    __sync_fetch_and_add(&numAllocations, 1);
+  }
+  return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void* ptr);
+void __wrap_free(void* ptr) {
+  if(countingOnThisThread && ptr != NULL) {
+    __sync_fetch_and_add(&numFrees, 1);
+  }
+  __real_free(ptr);
+}
+#endif
+
+boolByte allocationCounterIsAvailable(void) {
+#if WITH_ALLOCATION_COUNTER
+  return true;
+#else
+  return false;
+#endif
+}
+
+void allocationCounterReset(void) {
+#if WITH_ALLOCATION_COUNTER
+  numAllocations = 0;
+  numFrees = 0;
+#endif
+}
+
+void allocationCounterStart(void) {
+#if WITH_ALLOCATION_COUNTER
+  countingOnThisThread = true;
+#endif
+}
+
+void allocationCounterStop(void) {
+#if WITH_ALLOCATION_COUNTER
+  countingOnThisThread = false;
+#endif
+}
+
+unsigned long allocationCounterGetNumAllocations(void) {
+#if WITH_ALLOCATION_COUNTER
+  return numAllocations;
+#else
+  return 0;
+#endif
+}
+
+unsigned long allocationCounterGetNumFrees(void) {
+#if WITH_ALLOCATION_COUNTER
+  return numFrees;
+#else
+  return 0;
+#endif
+}
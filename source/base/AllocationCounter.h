@@ -0,0 +1,73 @@
+//
+// AllocationCounter.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_AllocationCounter_h
+#define MrsWatson_AllocationCounter_h
+
+#include "base/Types.h"
+
+/**
+ * Counts heap allocations made while processing, which should be zero once the
+ * render loop has been set up. Counting only works in builds configured with
+ * WITH_ALLOCATION_COUNTER, which wraps malloc() and friends at link time (this
+ * is only supported with the GNU linker). In other builds these functions do
+ * nothing and the counts stay at zero.
+ */
+
+/**
+ * @return True if this build counts allocations
+ */
+boolByte allocationCounterIsAvailable(void);
+
+/**
+ * Reset the counts to zero. This affects the counts for all threads.
+ */
+void allocationCounterReset(void);
+
+/**
+ * Start counting allocations made on the calling thread.
+ */
+void allocationCounterStart(void);
+
+/**
+ * Stop counting allocations made on the calling thread.
+ */
+void allocationCounterStop(void);
+
+/**
+ * @return Number of calls to malloc(), calloc(), and realloc() made by all
+ * threads while counting since the last reset
+ */
+unsigned long allocationCounterGetNumAllocations(void);
+
+/**
+ * @return Number of calls to free() made by all threads while counting since
+ * the last reset
+ */
+unsigned long allocationCounterGetNumFrees(void);
+
+#endif
@@ -41,6 +41,19 @@ LinkedList newLinkedList(void) {
   return list;
 }
 
+LinkedList newLinkedListWithCapacity(int capacity) {
+  LinkedList list = newLinkedList();
+  LinkedListIterator iterator = list;
+  int i;
+
+  for(i = 1; i < capacity; i++) {
+    iterator->nextItem = newLinkedList();
+    iterator = (LinkedListIterator)(iterator->nextItem);
+  }
+
+  return list;
+}
+
 void linkedListAppend(LinkedList self, void* item) {
   LinkedListIterator iterator = self;
   LinkedListIterator headNode;
@@ -59,7 +72,13 @@ void linkedListAppend(LinkedList self, void* item) {
 
   headNode = self;
   while(true) {
-    if(iterator->nextItem == NULL) {
+    if(iterator->item == NULL) {
+      // Empty node left behind by linkedListClear()
+      iterator->item = item;
+      headNode->_numItems++;
+      break;
+    }
+    else if(iterator->nextItem == NULL) {
       nextItem = newLinkedList();
       nextItem->item = item;
       iterator->nextItem = nextItem;
@@ -72,6 +91,20 @@ void linkedListAppend(LinkedList self, void* item) {
   }
 }
 
+void linkedListClear(LinkedList self) {
+  LinkedListIterator iterator = self;
+
+  if(self == NULL) {
+    return;
+  }
+
+  while(iterator != NULL && iterator->item != NULL) {
+    iterator->item = NULL;
+    iterator = (LinkedListIterator)(iterator->nextItem);
+  }
+  self->_numItems = 0;
+}
+
 int linkedListLength(LinkedList self) {
   return self != NULL ? self->_numItems : 0;
 }
@@ -134,12 +167,16 @@ void freeLinkedListAndItems(LinkedList self, LinkedListFreeItemFunc freeItem) {
 
   while(true) {
     if(iterator->nextItem == NULL) {
-      freeItem(iterator->item);
+      if(iterator->item != NULL) {
+        freeItem(iterator->item);
+      }
       free(iterator);
       break;
     }
     else {
-      freeItem(iterator->item);
+      if(iterator->item != NULL) {
+        freeItem(iterator->item);
+      }
       current = iterator;
       iterator = (LinkedListIterator)(iterator->nextItem);
       free(current);
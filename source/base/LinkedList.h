@@ -48,6 +48,14 @@ typedef void (*LinkedListFreeItemFunc)(void* item);
  */
 LinkedList newLinkedList(void);
 
+/**
+ * Create a new linked list with nodes for the given number of items already
+ * allocated, so that appending up to that many items does not allocate memory.
+ * @param capacity Number of nodes to allocate
+ * @return Linked list with no items
+ */
+LinkedList newLinkedListWithCapacity(int capacity);
+
 /**
  * Add an item to the end of a list
  * @param self
@@ -57,6 +65,14 @@ LinkedList newLinkedList(void);
  */
 void linkedListAppend(LinkedList self, void* item);
 
+/**
+ * Remove all items from a list, without freeing them. The nodes of the list are
+ * kept and reused by linkedListAppend(), so a list which is cleared and filled
+ * again in a loop only allocates memory when it grows beyond its largest size.
+ * @param self
+ */
+void linkedListClear(LinkedList self);
+
 /**
  * Get the number of items in a list. Use this function instead of accessing
  * the fields of the list, as the field names or use may change in the future.
@@ -0,0 +1,119 @@
+//
+// MappedFile.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "base/MappedFile.h"
+#include "base/PlatformUtilities.h"
+#include "logging/EventLogger.h"
+
+#if WINDOWS
+#include <Windows.h>
+#ifndef S_ISREG
+#define S_ISREG(mode) (((mode) & _S_IFMT) == _S_IFREG)
+#endif
+#elif UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MappedFile newMappedFile(const CharString path) {
+  MappedFile self = NULL;
+  struct stat fileStat;
+  const void* data = NULL;
+  void* mapping = NULL;
+#if WINDOWS
+  HANDLE fileHandle;
+#elif UNIX
+  int fd;
+#endif
+
+  if(path == NULL || charStringIsEmpty(path)) {
+    return NULL;
+  }
+  // Pipes, devices and empty files can't be mapped, and files too large for
+  // the address space must be read in pieces instead
+  if(stat(path->data, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) ||
+    fileStat.st_size <= 0 || (unsigned long long)fileStat.st_size > (size_t)-1) {
+    return NULL;
+  }
+
+#if WINDOWS
+  fileHandle = CreateFileA(path->data, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(fileHandle == INVALID_HANDLE_VALUE) {
+    return NULL;
+  }
+  mapping = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+  // The mapping holds its own reference to the file
+  CloseHandle(fileHandle);
+  if(mapping == NULL) {
+    return NULL;
+  }
+  data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if(data == NULL) {
+    CloseHandle(mapping);
+    return NULL;
+  }
+#elif UNIX
+  fd = open(path->data, O_RDONLY);
+  if(fd < 0) {
+    return NULL;
+  }
+  data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  // Closing the descriptor does not unmap the file
+  close(fd);
+  if(data == MAP_FAILED) {
+    logDebug("Could not map file '%s'", path->data);
+    return NULL;
+  }
+  posix_madvise((void*)data, (size_t)fileStat.st_size, POSIX_MADV_SEQUENTIAL);
+#else
+  return NULL;
+#endif
+
+  self = (MappedFile)malloc(sizeof(MappedFileMembers));
+  self->data = (const byte*)data;
+  self->size = (size_t)fileStat.st_size;
+  self->_mapping = mapping;
+  return self;
+}
+
+void freeMappedFile(MappedFile self) {
+  if(self == NULL) {
+    return;
+  }
+#if WINDOWS
+  UnmapViewOfFile(self->data);
+  CloseHandle((HANDLE)self->_mapping);
+#elif UNIX
+  munmap((void*)self->data, self->size);
+#endif
+  free(self);
+}
@@ -0,0 +1,63 @@
+//
+// MappedFile.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_MappedFile_h
+#define MrsWatson_MappedFile_h
+
+#include <stddef.h>
+
+#include "base/CharString.h"
+#include "base/Types.h"
+
+typedef struct {
+  // Contents of the file, which must never be written to
+  const byte* data;
+  // Size of the file, in bytes
+  size_t size;
+
+  /** Private, handle to the mapping object on Windows */
+  void* _mapping;
+} MappedFileMembers;
+typedef MappedFileMembers* MappedFile;
+
+/**
+ * Map an existing file into memory for reading. The operating system is told
+ * that the file will be read from start to finish, so pages are read ahead and
+ * dropped after use.
+ * @param path File to map
+ * @return Mapped file, or NULL if the file is empty, is not a regular file, or
+ * could not be mapped on this platform. Callers should fall back to stdio.
+ */
+MappedFile newMappedFile(const CharString path);
+
+/**
+ * Unmap a file and free all associated memory
+ * @param self
+ */
+void freeMappedFile(MappedFile self);
+
+#endif
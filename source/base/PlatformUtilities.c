@@ -258,6 +258,21 @@ boolByte isHost64Bit(void) {
   return result;
 }
 
+unsigned int getNumProcessors(void) {
+  unsigned int result = 1;
+#if WINDOWS
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  result = (unsigned int)systemInfo.dwNumberOfProcessors;
+#elif UNIX
+  long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+  if(numProcessors > 0) {
+    result = (unsigned int)numProcessors;
+  }
+#endif
+  return result > 0 ? result : 1;
+}
+
 boolByte isHostLittleEndian(void) {
   int num = 1;
   return (boolByte)(*(char*)&num == 1);
@@ -305,12 +320,23 @@ unsigned short convertByteArrayToUnsignedShort(const byte* value) {
 
 unsigned int convertByteArrayToUnsignedInt(const byte* value) {
   if(isHostLittleEndian()) {
-    return ((value[3] << 24) | ((value[2] << 16) & 0x00ff0000) |
+    return (((unsigned int)value[3] << 24) | ((value[2] << 16) & 0x00ff0000) |
       ((value[1] << 8) & 0x0000ff00) | value[0]);
   }
   else {
-    return ((value[0] << 24) | ((value[1] << 16) & 0x00ff0000) |
-      ((value[2] << 8) & 0x0000ff00) | value[0]);
+    return (((unsigned int)value[0] << 24) | ((value[1] << 16) & 0x00ff0000) |
+      ((value[2] << 8) & 0x0000ff00) | value[3]);
+  }
+}
+
+unsigned long long convertByteArrayToUnsignedLongLong(const byte* value) {
+  unsigned long long first = convertByteArrayToUnsignedInt(value);
+  unsigned long long second = convertByteArrayToUnsignedInt(value + 4);
+  if(isHostLittleEndian()) {
+    return (second << 32) | first;
+  }
+  else {
+    return (first << 32) | second;
   }
 }
 
@@ -119,6 +119,12 @@ boolByte isExecutable64Bit(void);
  */
 boolByte isHost64Bit(void);
 
+/**
+ * Get the number of processors which are currently online.
+ * @return Number of processors, at least 1
+ */
+unsigned int getNumProcessors(void);
+
 /**
  * See if the host operating system is running on little endian hardware.
  * @return True if the host's CPU is little endian
@@ -181,6 +187,14 @@ unsigned short convertByteArrayToUnsignedShort(const byte* value);
  */
 unsigned int convertByteArrayToUnsignedInt(const byte* value);
 
+/**
+ * Convert raw bytes to an unsigned 64-bit value, taking into account the host's
+ * endian-ness.
+ * @param value A buffer which holds at least eight bytes
+ * @return Unsigned long long integer
+ */
+unsigned long long convertByteArrayToUnsignedLongLong(const byte* value);
+
 /**
  * Suspend execution for a given amount of milliseconds. Depending on the host
  * operating system, the amount of time actually slept may differ slightly from
@@ -0,0 +1,190 @@
+//
+// Thread.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+
+#if UNIX
+#include <sched.h>
+#endif
+
+#include "base/Thread.h"
+#include "logging/EventLogger.h"
+
+Thread newThread(ThreadFunc function, void* userData) {
+  Thread thread = (Thread)malloc(sizeof(ThreadMembers));
+  thread->function = function;
+  thread->userData = userData;
+  thread->running = false;
+  return thread;
+}
+
+#if WINDOWS
+static DWORD WINAPI _threadWindowsEntry(LPVOID threadPtr) {
+  Thread self = (Thread)threadPtr;
+  self->function(self->userData);
+  return 0;
+}
+#endif
+
+boolByte threadStart(Thread self) {
+  if(self->running) {
+    logInternalError("Thread already running");
+    return false;
+  }
+
+#if WINDOWS
+  self->_handle = CreateThread(NULL, 0, _threadWindowsEntry, self, 0, NULL);
+  if(self->_handle == NULL) {
+    logError("Could not create thread, error %d", GetLastError());
+    return false;
+  }
+#elif UNIX
+  if(pthread_create(&(self->_handle), NULL, self->function, self->userData) != 0) {
+    logError("Could not create thread");
+    return false;
+  }
+#else
+  logUnsupportedFeature("Threads on this platform");
+  return false;
+#endif
+
+  self->running = true;
+  return true;
+}
+
+boolByte threadJoin(Thread self) {
+  if(!self->running) {
+    return false;
+  }
+
+#if WINDOWS
+  WaitForSingleObject(self->_handle, INFINITE);
+  CloseHandle(self->_handle);
+#elif UNIX
+  if(pthread_join(self->_handle, NULL) != 0) {
+    logError("Could not join thread");
+    return false;
+  }
+#endif
+
+  self->running = false;
+  return true;
+}
+
+void threadYield(void) {
+#if WINDOWS
+  SwitchToThread();
+#elif UNIX
+  sched_yield();
+#endif
+}
+
+void threadMemoryBarrier(void) {
+#if WINDOWS
+  MemoryBarrier();
+#else
+  __sync_synchronize();
+#endif
+}
+
+ThreadSignal newThreadSignal(void) {
+  ThreadSignal signal = (ThreadSignal)malloc(sizeof(ThreadSignalMembers));
+  signal->generation = 0;
+#if WINDOWS
+  InitializeCriticalSection(&(signal->_lock));
+  InitializeConditionVariable(&(signal->_condition));
+#elif UNIX
+  pthread_mutex_init(&(signal->_lock), NULL);
+  pthread_cond_init(&(signal->_condition), NULL);
+#endif
+  return signal;
+}
+
+unsigned long threadSignalGetGeneration(ThreadSignal self) {
+  unsigned long generation = self->generation;
+  // The shared state must be read after the generation
+  threadMemoryBarrier();
+  return generation;
+}
+
+void threadSignalWait(ThreadSignal self, unsigned long generation) {
+#if WINDOWS
+  EnterCriticalSection(&(self->_lock));
+  while(self->generation == generation) {
+    SleepConditionVariableCS(&(self->_condition), &(self->_lock), INFINITE);
+  }
+  LeaveCriticalSection(&(self->_lock));
+#elif UNIX
+  pthread_mutex_lock(&(self->_lock));
+  while(self->generation == generation) {
+    pthread_cond_wait(&(self->_condition), &(self->_lock));
+  }
+  pthread_mutex_unlock(&(self->_lock));
+#else
+  while(self->generation == generation) {
+    threadYield();
+  }
+#endif
+}
+
+void threadSignalNotify(ThreadSignal self) {
+#if WINDOWS
+  EnterCriticalSection(&(self->_lock));
+  self->generation++;
+  WakeAllConditionVariable(&(self->_condition));
+  LeaveCriticalSection(&(self->_lock));
+#elif UNIX
+  pthread_mutex_lock(&(self->_lock));
+  self->generation++;
+  pthread_cond_broadcast(&(self->_condition));
+  pthread_mutex_unlock(&(self->_lock));
+#else
+  threadMemoryBarrier();
+  self->generation++;
+#endif
+}
+
+void freeThreadSignal(ThreadSignal self) {
+  if(self != NULL) {
+#if WINDOWS
+    DeleteCriticalSection(&(self->_lock));
+#elif UNIX
+    pthread_mutex_destroy(&(self->_lock));
+    pthread_cond_destroy(&(self->_condition));
+#endif
+    free(self);
+  }
+}
+
+void freeThread(Thread self) {
+  if(self != NULL) {
+    if(self->running) {
+      threadJoin(self);
+    }
+    free(self);
+  }
+}
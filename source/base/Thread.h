@@ -0,0 +1,163 @@
+//
+// Thread.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_Thread_h
+#define MrsWatson_Thread_h
+
+#include "base/PlatformUtilities.h"
+#include "base/Types.h"
+
+#if UNIX
+#include <pthread.h>
+#endif
+
+// Storage class for variables which have a separate instance on each thread
+#if WINDOWS
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+typedef void* (*ThreadFunc)(void* userData);
+
+typedef struct {
+  ThreadFunc function;
+  void* userData;
+  boolByte running;
+
+#if WINDOWS
+  HANDLE _handle;
+#elif UNIX
+  pthread_t _handle;
+#endif
+} ThreadMembers;
+typedef ThreadMembers* Thread;
+
+/**
+ * Lets threads sleep until some state which they share with other threads has
+ * changed. The state itself is kept elsewhere, usually in lock-free counters,
+ * and the signal only counts how often it has been notified. A waiting thread
+ * takes the count before checking the state, so that a notification which
+ * arrives in between is not lost:
+ *
+ *   for(;;) {
+ *     generation = threadSignalGetGeneration(signal);
+ *     if(stateIsReady()) break;
+ *     threadSignalWait(signal, generation);
+ *   }
+ */
+typedef struct {
+  volatile unsigned long generation;
+
+#if WINDOWS
+  CRITICAL_SECTION _lock;
+  CONDITION_VARIABLE _condition;
+#elif UNIX
+  pthread_mutex_t _lock;
+  pthread_cond_t _condition;
+#endif
+} ThreadSignalMembers;
+typedef ThreadSignalMembers* ThreadSignal;
+
+/**
+ * Create a new thread object. The thread is not started until threadStart()
+ * is called.
+ * @param function Function to execute on the new thread
+ * @param userData Argument to pass to function
+ * @return Initialized thread object
+ */
+Thread newThread(ThreadFunc function, void* userData);
+
+/**
+ * Start executing the thread's function.
+ * @param self
+ * @return True if the thread was started
+ */
+boolByte threadStart(Thread self);
+
+/**
+ * Wait for the thread's function to return.
+ * @param self
+ * @return True if the thread was joined successfully
+ */
+boolByte threadJoin(Thread self);
+
+/**
+ * Give up the rest of the calling thread's time slice. Used when polling
+ * lock-free structures which are shared between threads.
+ */
+void threadYield(void);
+
+/**
+ * Issue a full memory barrier, so that all reads and writes made before this
+ * call are visible to other threads before any made after it.
+ */
+void threadMemoryBarrier(void);
+
+/**
+ * Create a new signal with a generation of 0
+ * @return Initialized ThreadSignal
+ */
+ThreadSignal newThreadSignal(void);
+
+/**
+ * Get the number of times the signal has been notified. Must be called before
+ * checking the shared state which the caller is waiting for.
+ * @param self
+ * @return Current generation
+ */
+unsigned long threadSignalGetGeneration(ThreadSignal self);
+
+/**
+ * Block the calling thread until the signal is notified, unless it has already
+ * been notified since the given generation was taken.
+ * @param self
+ * @param generation Value returned by threadSignalGetGeneration()
+ */
+void threadSignalWait(ThreadSignal self, unsigned long generation);
+
+/**
+ * Wake all threads waiting on the signal. Must be called after the shared
+ * state has been changed. May be called from any thread.
+ * @param self
+ */
+void threadSignalNotify(ThreadSignal self);
+
+/**
+ * Free a signal. No thread may be waiting on it.
+ * @param self
+ */
+void freeThreadSignal(ThreadSignal self);
+
+/**
+ * Free a thread object. If the thread is still running, it will be joined
+ * first.
+ * @param self
+ */
+void freeThread(Thread self);
+
+#endif
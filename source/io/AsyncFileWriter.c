@@ -0,0 +1,227 @@
+//
+// AsyncFileWriter.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+
+#include "io/AsyncFileWriter.h"
+#include "logging/EventLogger.h"
+
+#if WINDOWS
+#include <malloc.h>
+#endif
+
+static void* _allocateAligned(size_t size) {
+#if WINDOWS
+  return _aligned_malloc(size, ASYNC_FILE_WRITER_ALIGNMENT);
+#else
+  void* result = NULL;
+  if(posix_memalign(&result, ASYNC_FILE_WRITER_ALIGNMENT, size) != 0) {
+    return NULL;
+  }
+  return result;
+#endif
+}
+
+static void _freeAligned(void* data) {
+#if WINDOWS
+  _aligned_free(data);
+#else
+  free(data);
+#endif
+}
+
+static byte* _asyncFileWriterGetBuffer(AsyncFileWriter self, unsigned long count) {
+  return self->_storage + (count % self->numBuffers) * self->bufferSize;
+}
+
+static void* _asyncFileWriterThread(void* userData) {
+  AsyncFileWriter self = (AsyncFileWriter)userData;
+  unsigned long generation;
+  size_t numBytes;
+
+  while(true) {
+    for(;;) {
+      generation = threadSignalGetGeneration(self->_signal);
+      if(self->_submitCount != self->_completeCount) {
+        break;
+      }
+      if(self->_stopping) {
+        return NULL;
+      }
+      threadSignalWait(self->_signal, generation);
+    }
+    // Make sure the buffer contents are visible before reading them
+    threadMemoryBarrier();
+
+    numBytes = self->_bufferFills[self->_completeCount % self->numBuffers];
+    if(!self->_failed && numBytes > 0) {
+      if(fwrite(_asyncFileWriterGetBuffer(self, self->_completeCount), 1, numBytes, self->fileHandle) != numBytes) {
+        logError("Could not write %lu bytes to output file", (unsigned long)numBytes);
+        self->_failed = true;
+      }
+      else {
+        self->numBytesWritten += numBytes;
+        self->numWrites++;
+      }
+    }
+
+    // The buffer must not be reused before the write has finished with it
+    threadMemoryBarrier();
+    self->_completeCount++;
+    threadSignalNotify(self->_signal);
+  }
+}
+
+AsyncFileWriter newAsyncFileWriter(FILE* fileHandle, size_t bufferSize, unsigned int numBuffers) {
+  AsyncFileWriter self = (AsyncFileWriter)malloc(sizeof(AsyncFileWriterMembers));
+  unsigned int i;
+
+  self->fileHandle = fileHandle;
+  self->bufferSize = ((bufferSize + ASYNC_FILE_WRITER_ALIGNMENT - 1) / ASYNC_FILE_WRITER_ALIGNMENT) *
+    ASYNC_FILE_WRITER_ALIGNMENT;
+  if(self->bufferSize == 0) {
+    self->bufferSize = ASYNC_FILE_WRITER_ALIGNMENT;
+  }
+  // With only one buffer the producer would always wait for the writer
+  self->numBuffers = numBuffers > 2 ? numBuffers : 2;
+
+  self->numBytesWritten = 0;
+  self->numWrites = 0;
+  self->producerStalls = 0;
+
+  self->_submitCount = 0;
+  self->_completeCount = 0;
+  self->_stopping = false;
+  self->_failed = false;
+
+  self->_storage = (byte*)_allocateAligned(self->bufferSize * self->numBuffers);
+  if(self->_storage == NULL) {
+    logError("Could not allocate %d output buffers of %lu bytes", self->numBuffers, (unsigned long)self->bufferSize);
+    free(self);
+    return NULL;
+  }
+  self->_bufferFills = (size_t*)malloc(sizeof(size_t) * self->numBuffers);
+  for(i = 0; i < self->numBuffers; i++) {
+    self->_bufferFills[i] = 0;
+  }
+
+  self->_signal = newThreadSignal();
+  self->_thread = newThread(_asyncFileWriterThread, self);
+  if(!threadStart(self->_thread)) {
+    logError("Could not start output writer thread");
+    freeThread(self->_thread);
+    freeThreadSignal(self->_signal);
+    free(self->_bufferFills);
+    _freeAligned(self->_storage);
+    free(self);
+    return NULL;
+  }
+  return self;
+}
+
+// Hand the producer's current buffer to the writer thread
+static void _asyncFileWriterSubmit(AsyncFileWriter self) {
+  // The buffer contents must be visible before the writer sees the new count
+  threadMemoryBarrier();
+  self->_submitCount++;
+  threadSignalNotify(self->_signal);
+}
+
+// Wait until the producer's current buffer is no longer queued for writing
+static void _asyncFileWriterWaitForBuffer(AsyncFileWriter self) {
+  boolByte stalled = false;
+  unsigned long generation;
+  for(;;) {
+    generation = threadSignalGetGeneration(self->_signal);
+    if(self->_submitCount - self->_completeCount < self->numBuffers) {
+      break;
+    }
+    stalled = true;
+    threadSignalWait(self->_signal, generation);
+  }
+  if(stalled) {
+    self->producerStalls++;
+  }
+  threadMemoryBarrier();
+}
+
+byte* asyncFileWriterAcquire(AsyncFileWriter self, size_t numBytes) {
+  size_t fill;
+
+  if(numBytes > self->bufferSize) {
+    return NULL;
+  }
+  fill = self->_bufferFills[self->_submitCount % self->numBuffers];
+  if(fill + numBytes > self->bufferSize) {
+    _asyncFileWriterSubmit(self);
+    _asyncFileWriterWaitForBuffer(self);
+    self->_bufferFills[self->_submitCount % self->numBuffers] = 0;
+    fill = 0;
+  }
+  return _asyncFileWriterGetBuffer(self, self->_submitCount) + fill;
+}
+
+void asyncFileWriterCommit(AsyncFileWriter self, size_t numBytes) {
+  self->_bufferFills[self->_submitCount % self->numBuffers] += numBytes;
+}
+
+boolByte asyncFileWriterFlush(AsyncFileWriter self) {
+  unsigned long generation;
+  if(self->_bufferFills[self->_submitCount % self->numBuffers] > 0) {
+    _asyncFileWriterSubmit(self);
+  }
+  for(;;) {
+    generation = threadSignalGetGeneration(self->_signal);
+    if(self->_completeCount == self->_submitCount) {
+      break;
+    }
+    threadSignalWait(self->_signal, generation);
+  }
+  // The file's state must be visible to the calling thread
+  threadMemoryBarrier();
+  self->_bufferFills[self->_submitCount % self->numBuffers] = 0;
+  return (boolByte)!self->_failed;
+}
+
+boolByte asyncFileWriterHasFailed(AsyncFileWriter self) {
+  return self->_failed;
+}
+
+void freeAsyncFileWriter(AsyncFileWriter self) {
+  if(self == NULL) {
+    return;
+  }
+  asyncFileWriterFlush(self);
+  self->_stopping = true;
+  threadSignalNotify(self->_signal);
+  threadJoin(self->_thread);
+  freeThread(self->_thread);
+  freeThreadSignal(self->_signal);
+  free(self->_bufferFills);
+  _freeAligned(self->_storage);
+  free(self);
+}
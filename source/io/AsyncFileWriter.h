@@ -0,0 +1,132 @@
+//
+// AsyncFileWriter.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_AsyncFileWriter_h
+#define MrsWatson_AsyncFileWriter_h
+
+#include <stdio.h>
+
+#include "base/Thread.h"
+#include "base/Types.h"
+
+// Buffers are aligned to the page size, so that the writes issued for them
+// also start on page boundaries
+#define ASYNC_FILE_WRITER_ALIGNMENT 4096
+#define ASYNC_FILE_WRITER_DEFAULT_BUFFER_SIZE (1024 * 1024)
+#define ASYNC_FILE_WRITER_DEFAULT_NUM_BUFFERS 4
+
+/**
+ * Writes data to a file on a background thread. The producer fills one buffer
+ * at a time, which is handed to the writer thread once the next write doesn't
+ * fit in it. Many small writes are thus coalesced into one large write call,
+ * and the producer only waits for I/O when every buffer is queued. The file
+ * must not be touched by anything else until asyncFileWriterFlush() returns.
+ */
+typedef struct {
+  FILE* fileHandle;
+  size_t bufferSize;
+  unsigned int numBuffers;
+
+  // Statistics, updated by the producer (stalls) and the writer thread (writes)
+  unsigned long long numBytesWritten;
+  unsigned long numWrites;
+  unsigned long producerStalls;
+
+  /** Private, one aligned allocation holding all buffers */
+  byte* _storage;
+  /** Private, number of bytes used in each buffer */
+  size_t* _bufferFills;
+  /** Private */
+  Thread _thread;
+  // Notified whenever a buffer is submitted or written, and when stopping
+  ThreadSignal _signal;
+  // Monotonically increasing counters, the buffer index is found by taking the
+  // counter modulo the number of buffers. The submit counter is only modified
+  // by the producer and the complete counter only by the writer thread.
+  volatile unsigned long _submitCount;
+  volatile unsigned long _completeCount;
+  volatile boolByte _stopping;
+  volatile boolByte _failed;
+} AsyncFileWriterMembers;
+typedef AsyncFileWriterMembers* AsyncFileWriter;
+
+/**
+ * Create a new writer and start its thread
+ * @param fileHandle File to write to, positioned where the data should start
+ * @param bufferSize Size of each buffer, in bytes. This is rounded up to the
+ * alignment, and limits the size of a single write.
+ * @param numBuffers Number of buffers, at least 2 are used
+ * @return Initialized writer, or NULL if the buffers or thread could not be
+ * created
+ */
+AsyncFileWriter newAsyncFileWriter(FILE* fileHandle, size_t bufferSize, unsigned int numBuffers);
+
+/**
+ * Get space for the producer to write to. If the current buffer doesn't have
+ * enough room left, it is queued for writing and this call waits for the next
+ * buffer to be free. Must only be called from the producer thread.
+ * @param self
+ * @param numBytes Number of bytes which will be written
+ * @return Pointer to the space, or NULL if numBytes is larger than the buffer
+ * size. In that case the caller should flush the writer and write the data
+ * itself.
+ */
+byte* asyncFileWriterAcquire(AsyncFileWriter self, size_t numBytes);
+
+/**
+ * Mark the space obtained with asyncFileWriterAcquire() as filled. Must only be
+ * called from the producer thread.
+ * @param self
+ * @param numBytes Number of bytes which were written, at most the number
+ * which were acquired
+ */
+void asyncFileWriterCommit(AsyncFileWriter self, size_t numBytes);
+
+/**
+ * Queue any partially filled buffer and wait until everything has been written
+ * to the file. Afterwards the file may be used by the calling thread again,
+ * until the next call to asyncFileWriterAcquire(). Must only be called from
+ * the producer thread.
+ * @param self
+ * @return False if any write has failed
+ */
+boolByte asyncFileWriterFlush(AsyncFileWriter self);
+
+/**
+ * @param self
+ * @return True if a write to the file has failed. Further data is discarded.
+ */
+boolByte asyncFileWriterHasFailed(AsyncFileWriter self);
+
+/**
+ * Flush all remaining data, stop the writer thread, and free all buffers. The
+ * file itself is not closed.
+ * @param self
+ */
+void freeAsyncFileWriter(AsyncFileWriter self);
+
+#endif
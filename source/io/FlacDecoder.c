@@ -0,0 +1,832 @@
+//
+// FlacDecoder.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "io/FlacDecoder.h"
+#include "logging/EventLogger.h"
+
+#define FLAC_DECODER_INITIAL_BUFFER_SIZE (64 * 1024)
+// The input buffer always has this many zero bytes after the data, so that
+// bits can be read by loading whole 64-bit words
+#define FLAC_DECODER_BUFFER_PADDING 8
+#define FLAC_DECODER_DEFAULT_BLOCKSIZE 4096
+#define ID3V2_HEADER_SIZE 10
+
+typedef struct {
+  unsigned int blocksize;
+  unsigned int channelAssignment;
+  unsigned int numChannels;
+  unsigned int bitsPerSample;
+} FlacFrameHeader;
+
+static const unsigned int kFlacSampleSizes[8] = {0, 8, 12, 0, 16, 20, 24, 32};
+
+// Move data which is still needed to the start of the buffer and read more
+// from the file after it. The buffer is grown if it is full.
+static boolByte _flacDecoderRefill(FlacDecoder self) {
+  size_t numBytesRead;
+
+  if(self->_markPosition > 0) {
+    memmove(self->_buffer, self->_buffer + self->_markPosition, self->_bufferLength - self->_markPosition);
+    self->_bufferLength -= self->_markPosition;
+    self->_bytePosition -= self->_markPosition;
+    self->_bufferFileOffset += (long)self->_markPosition;
+    self->_markPosition = 0;
+  }
+  if(self->_bufferLength == self->_bufferSize) {
+    self->_bufferSize *= 2;
+    self->_buffer = (byte*)realloc(self->_buffer, self->_bufferSize + FLAC_DECODER_BUFFER_PADDING);
+  }
+
+  numBytesRead = fread(self->_buffer + self->_bufferLength, 1,
+    self->_bufferSize - self->_bufferLength, self->_fileHandle);
+  self->_bufferLength += numBytesRead;
+  memset(self->_buffer + self->_bufferLength, 0, FLAC_DECODER_BUFFER_PADDING);
+  return (boolByte)(numBytesRead > 0);
+}
+
+static boolByte _flacDecoderEnsureBytes(FlacDecoder self, size_t numBytes) {
+  while(self->_bufferLength - self->_bytePosition < numBytes) {
+    if(!_flacDecoderRefill(self)) {
+      self->_isTruncated = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+static unsigned long long _loadBigEndian64(const byte* data) {
+  return ((unsigned long long)data[0] << 56) | ((unsigned long long)data[1] << 48) |
+    ((unsigned long long)data[2] << 40) | ((unsigned long long)data[3] << 32) |
+    ((unsigned long long)data[4] << 24) | ((unsigned long long)data[5] << 16) |
+    ((unsigned long long)data[6] << 8) | (unsigned long long)data[7];
+}
+
+// Read up to 32 bits. On truncated input, 0 is returned and _isTruncated is set.
+static unsigned int _flacDecoderReadBits(FlacDecoder self, unsigned int numBits) {
+  unsigned long long cache;
+
+  if(numBits == 0) {
+    return 0;
+  }
+  if(self->_bufferLength - self->_bytePosition < (self->_bitPosition + numBits + 7) / 8 &&
+    !_flacDecoderEnsureBytes(self, (self->_bitPosition + numBits + 7) / 8)) {
+    return 0;
+  }
+  // At most 7 bits of the first byte have been used, so at least 57 are left
+  cache = _loadBigEndian64(self->_buffer + self->_bytePosition) << self->_bitPosition;
+  self->_bitPosition += numBits;
+  self->_bytePosition += self->_bitPosition / 8;
+  self->_bitPosition %= 8;
+  return (unsigned int)(cache >> (64 - numBits));
+}
+
+static int _flacDecoderReadSignedBits(FlacDecoder self, unsigned int numBits) {
+  unsigned int value = _flacDecoderReadBits(self, numBits);
+  if(numBits == 0) {
+    return 0;
+  }
+  // Sign extend from the top bit of the value
+  value <<= 32 - numBits;
+  return (int)value >> (32 - numBits);
+}
+
+// Count zero bits up to and including the next one bit
+static unsigned int _flacDecoderReadUnary(FlacDecoder self) {
+  unsigned int result = 0;
+  byte bits;
+
+  while(true) {
+    if(self->_bytePosition == self->_bufferLength && !_flacDecoderEnsureBytes(self, 1)) {
+      return 0;
+    }
+    bits = (byte)(self->_buffer[self->_bytePosition] << self->_bitPosition);
+    if(bits != 0) {
+      while(!(bits & 0x80)) {
+        bits <<= 1;
+        result++;
+        self->_bitPosition++;
+      }
+      self->_bitPosition++;
+      self->_bytePosition += self->_bitPosition / 8;
+      self->_bitPosition %= 8;
+      return result;
+    }
+    result += 8 - self->_bitPosition;
+    self->_bytePosition++;
+    self->_bitPosition = 0;
+  }
+}
+
+static void _flacDecoderAlignToByte(FlacDecoder self) {
+  if(self->_bitPosition > 0) {
+    self->_bitPosition = 0;
+    self->_bytePosition++;
+  }
+}
+
+static boolByte _flacDecoderSkipBytes(FlacDecoder self, unsigned long numBytes) {
+  size_t available = self->_bufferLength - self->_bytePosition;
+  byte discard[1024];
+  size_t numBytesToRead;
+
+  if(numBytes <= available) {
+    self->_bytePosition += numBytes;
+    return true;
+  }
+
+  // Drop the whole buffer and skip the rest in the file itself
+  numBytes -= (unsigned long)available;
+  self->_bufferFileOffset += (long)self->_bufferLength;
+  self->_bufferLength = 0;
+  self->_bytePosition = 0;
+  self->_markPosition = 0;
+  if(fseek(self->_fileHandle, (long)numBytes, SEEK_CUR) == 0) {
+    self->_bufferFileOffset += (long)numBytes;
+    return true;
+  }
+  while(numBytes > 0) {
+    numBytesToRead = numBytes < sizeof(discard) ? numBytes : sizeof(discard);
+    if(fread(discard, 1, numBytesToRead, self->_fileHandle) != numBytesToRead) {
+      self->_isTruncated = true;
+      return false;
+    }
+    self->_bufferFileOffset += (long)numBytesToRead;
+    numBytes -= (unsigned long)numBytesToRead;
+  }
+  return true;
+}
+
+static void _flacDecoderResizeDecodedSamples(FlacDecoder self, unsigned int blocksize) {
+  unsigned int i;
+  if(blocksize > self->_decodedCapacity) {
+    self->_decodedCapacity = blocksize;
+    for(i = 0; i < FLAC_MAX_CHANNELS; i++) {
+      self->decodedSamples[i] = (int*)realloc(self->decodedSamples[i], sizeof(int) * blocksize);
+    }
+  }
+}
+
+// ID3v2 tags are not part of the FLAC format, but some taggers put them at
+// the start of FLAC files anyways
+static boolByte _flacDecoderSkipId3Tag(FlacDecoder self) {
+  const byte* header;
+  unsigned long tagSize;
+
+  if(!_flacDecoderEnsureBytes(self, ID3V2_HEADER_SIZE)) {
+    self->_isTruncated = false;
+    return true;
+  }
+  header = self->_buffer + self->_bytePosition;
+  if(memcmp(header, "ID3", 3) != 0) {
+    return true;
+  }
+  // The size is stored in 4 bytes with 7 bits each, and doesn't count the
+  // header or the optional footer
+  tagSize = ((unsigned long)(header[6] & 0x7f) << 21) | ((unsigned long)(header[7] & 0x7f) << 14) |
+    ((unsigned long)(header[8] & 0x7f) << 7) | (unsigned long)(header[9] & 0x7f);
+  if(header[5] & 0x10) {
+    tagSize += ID3V2_HEADER_SIZE;
+  }
+  logDebug("Skipping ID3 tag of %lu bytes", tagSize);
+  return _flacDecoderSkipBytes(self, ID3V2_HEADER_SIZE + tagSize);
+}
+
+static void _flacDecoderReadStreamInfo(FlacDecoder self) {
+  self->minBlocksize = _flacDecoderReadBits(self, 16);
+  self->maxBlocksize = _flacDecoderReadBits(self, 16);
+  // Minimum and maximum frame sizes aren't needed
+  _flacDecoderReadBits(self, 24);
+  _flacDecoderReadBits(self, 24);
+  self->sampleRate = _flacDecoderReadBits(self, 20);
+  self->numChannels = _flacDecoderReadBits(self, 3) + 1;
+  self->bitsPerSample = _flacDecoderReadBits(self, 5) + 1;
+  self->totalSamples = (unsigned long long)_flacDecoderReadBits(self, 4) << 32;
+  self->totalSamples |= _flacDecoderReadBits(self, 32);
+  // The MD5 signature of the audio data is not checked
+  _flacDecoderSkipBytes(self, 16);
+}
+
+static void _flacDecoderReadSeekTable(FlacDecoder self, unsigned long length) {
+  unsigned long numPoints = length / FLAC_SEEKPOINT_SIZE;
+  FlacSeekPoint* point;
+  unsigned long i;
+
+  free(self->seekPoints);
+  self->seekPoints = (FlacSeekPoint*)malloc(sizeof(FlacSeekPoint) * (numPoints > 0 ? numPoints : 1));
+  self->numSeekPoints = 0;
+  for(i = 0; i < numPoints; i++) {
+    self->_markPosition = self->_bytePosition;
+    point = &self->seekPoints[self->numSeekPoints];
+    point->sampleNumber = (unsigned long long)_flacDecoderReadBits(self, 32) << 32;
+    point->sampleNumber |= _flacDecoderReadBits(self, 32);
+    point->streamOffset = (unsigned long long)_flacDecoderReadBits(self, 32) << 32;
+    point->streamOffset |= _flacDecoderReadBits(self, 32);
+    point->numSamples = _flacDecoderReadBits(self, 16);
+    if(point->sampleNumber != FLAC_SEEKPOINT_PLACEHOLDER) {
+      self->numSeekPoints++;
+    }
+  }
+  _flacDecoderSkipBytes(self, length - numPoints * FLAC_SEEKPOINT_SIZE);
+  logDebug("FLAC seek table has %d points", self->numSeekPoints);
+}
+
+static boolByte _flacDecoderReadMetadata(FlacDecoder self, const char* filename) {
+  boolByte isLastBlock = false;
+  boolByte hasStreamInfo = false;
+  unsigned int blockType;
+  unsigned long blockLength;
+
+  if(!_flacDecoderSkipId3Tag(self) || !_flacDecoderEnsureBytes(self, 4) ||
+    memcmp(self->_buffer + self->_bytePosition, FLAC_STREAM_MARKER, 4) != 0) {
+    logFileError(filename, "Not a FLAC file");
+    return false;
+  }
+  self->_bytePosition += 4;
+
+  while(!isLastBlock) {
+    self->_markPosition = self->_bytePosition;
+    isLastBlock = (boolByte)_flacDecoderReadBits(self, 1);
+    blockType = _flacDecoderReadBits(self, 7);
+    blockLength = _flacDecoderReadBits(self, 24);
+    if(self->_isTruncated) {
+      break;
+    }
+
+    if(blockType == FLAC_METADATA_STREAMINFO && blockLength == FLAC_STREAMINFO_SIZE) {
+      _flacDecoderReadStreamInfo(self);
+      hasStreamInfo = true;
+    }
+    else if(blockType == FLAC_METADATA_SEEKTABLE) {
+      _flacDecoderReadSeekTable(self, blockLength);
+    }
+    else {
+      _flacDecoderSkipBytes(self, blockLength);
+    }
+    if(self->_isTruncated) {
+      break;
+    }
+  }
+
+  if(self->_isTruncated) {
+    logFileError(filename, "FLAC metadata is truncated");
+    return false;
+  }
+  if(!hasStreamInfo) {
+    logFileError(filename, "FLAC file has no STREAMINFO block");
+    return false;
+  }
+  if(self->sampleRate == 0 || self->bitsPerSample < 4) {
+    logFileError(filename, "FLAC file has an invalid STREAMINFO block");
+    return false;
+  }
+  return true;
+}
+
+static boolByte _flacDecoderFindSync(FlacDecoder self) {
+  unsigned long numBytesSkipped = 0;
+
+  _flacDecoderAlignToByte(self);
+  while(true) {
+    self->_markPosition = self->_bytePosition;
+    if(!_flacDecoderEnsureBytes(self, 2)) {
+      return false;
+    }
+    if(self->_buffer[self->_bytePosition] == 0xff && (self->_buffer[self->_bytePosition + 1] & 0xfe) == 0xf8) {
+      if(numBytesSkipped > 0) {
+        logDebug("Skipped %lu bytes to find the next FLAC frame", numBytesSkipped);
+      }
+      return true;
+    }
+    self->_bytePosition++;
+    numBytesSkipped++;
+  }
+}
+
+static boolByte _flacDecoderReadFrameHeader(FlacDecoder self, FlacFrameHeader* header) {
+  unsigned int blocksizeCode;
+  unsigned int sampleRateCode;
+  unsigned int sampleSizeCode;
+  unsigned int firstByte;
+  unsigned int crc;
+
+  // Sync code and blocking strategy. The stream position is tracked by counting
+  // samples, so the frame or sample number is not needed either.
+  if(_flacDecoderReadBits(self, 15) != FLAC_FRAME_SYNC_CODE << 1) {
+    return false;
+  }
+  _flacDecoderReadBits(self, 1);
+  blocksizeCode = _flacDecoderReadBits(self, 4);
+  sampleRateCode = _flacDecoderReadBits(self, 4);
+  header->channelAssignment = _flacDecoderReadBits(self, 4);
+  sampleSizeCode = _flacDecoderReadBits(self, 3);
+  if(_flacDecoderReadBits(self, 1) != 0 || blocksizeCode == 0 || sampleRateCode == 15 ||
+    header->channelAssignment > FLAC_CHANNELS_MID_SIDE || sampleSizeCode == 3) {
+    return false;
+  }
+
+  // Frame or sample number, coded like UTF-8
+  firstByte = _flacDecoderReadBits(self, 8);
+  if(firstByte & 0x80) {
+    if((firstByte & 0xc0) == 0x80 || firstByte == 0xff) {
+      return false;
+    }
+    for(firstByte <<= 1; firstByte & 0x80; firstByte <<= 1) {
+      if((_flacDecoderReadBits(self, 8) & 0xc0) != 0x80) {
+        return false;
+      }
+    }
+  }
+
+  if(blocksizeCode == 1) {
+    header->blocksize = 192;
+  }
+  else if(blocksizeCode <= 5) {
+    header->blocksize = 576 << (blocksizeCode - 2);
+  }
+  else if(blocksizeCode == 6) {
+    header->blocksize = _flacDecoderReadBits(self, 8) + 1;
+  }
+  else if(blocksizeCode == 7) {
+    header->blocksize = _flacDecoderReadBits(self, 16) + 1;
+  }
+  else {
+    header->blocksize = 256 << (blocksizeCode - 8);
+  }
+
+  // The sample rate of the stream is taken from STREAMINFO, so coded rates
+  // are only read past
+  if(sampleRateCode == 12) {
+    _flacDecoderReadBits(self, 8);
+  }
+  else if(sampleRateCode == 13 || sampleRateCode == 14) {
+    _flacDecoderReadBits(self, 16);
+  }
+
+  header->numChannels = header->channelAssignment < FLAC_CHANNELS_LEFT_SIDE ?
+    header->channelAssignment + 1 : 2;
+  header->bitsPerSample = sampleSizeCode == 0 ? self->bitsPerSample : kFlacSampleSizes[sampleSizeCode];
+
+  crc = _flacDecoderReadBits(self, 8);
+  if(self->_isTruncated) {
+    return false;
+  }
+  return (boolByte)(crc == flacCrc8(self->_buffer + self->_markPosition,
+    self->_bytePosition - self->_markPosition - 1));
+}
+
+static boolByte _flacDecoderReadResidual(FlacDecoder self, int* samples, unsigned int blocksize, unsigned int order) {
+  unsigned int method = _flacDecoderReadBits(self, 2);
+  unsigned int parameterBits = method == 0 ? 4 : 5;
+  unsigned int escapeCode = (1u << parameterBits) - 1;
+  unsigned int partitionOrder = _flacDecoderReadBits(self, 4);
+  unsigned int partitionSize = blocksize >> partitionOrder;
+  unsigned int numPartitions = 1u << partitionOrder;
+  unsigned int partition;
+  unsigned int parameter;
+  unsigned int rawBits;
+  unsigned int numSamples;
+  unsigned int value;
+  unsigned int i = order;
+  unsigned int end;
+
+  if(method > 1 || (partitionSize << partitionOrder) != blocksize || partitionSize < order) {
+    return false;
+  }
+
+  for(partition = 0; partition < numPartitions; partition++) {
+    numSamples = partition == 0 ? partitionSize - order : partitionSize;
+    end = i + numSamples;
+    parameter = _flacDecoderReadBits(self, parameterBits);
+    if(parameter == escapeCode) {
+      rawBits = _flacDecoderReadBits(self, 5);
+      for(; i < end; i++) {
+        samples[i] = _flacDecoderReadSignedBits(self, rawBits);
+      }
+    }
+    else {
+      for(; i < end; i++) {
+        value = (_flacDecoderReadUnary(self) << parameter) | _flacDecoderReadBits(self, parameter);
+        // Residuals are zigzag coded, so that small negative values stay small
+        samples[i] = (int)(value >> 1) ^ -(int)(value & 1);
+      }
+    }
+    if(self->_isTruncated) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void _flacRestoreFixed(int* samples, unsigned int blocksize, unsigned int order) {
+  unsigned int i;
+  switch(order) {
+    case 1:
+      for(i = 1; i < blocksize; i++) {
+        samples[i] += samples[i - 1];
+      }
+      break;
+    case 2:
+      for(i = 2; i < blocksize; i++) {
+        samples[i] += (int)(2LL * samples[i - 1] - samples[i - 2]);
+      }
+      break;
+    case 3:
+      for(i = 3; i < blocksize; i++) {
+        samples[i] += (int)(3LL * samples[i - 1] - 3LL * samples[i - 2] + samples[i - 3]);
+      }
+      break;
+    case 4:
+      for(i = 4; i < blocksize; i++) {
+        samples[i] += (int)(4LL * samples[i - 1] - 6LL * samples[i - 2] + 4LL * samples[i - 3] - samples[i - 4]);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static void _flacRestoreLpc(int* samples, unsigned int blocksize, const int* coefficients,
+  unsigned int order, int shift) {
+  long long sum;
+  unsigned int i;
+  unsigned int j;
+
+  for(i = order; i < blocksize; i++) {
+    sum = 0;
+    for(j = 0; j < order; j++) {
+      sum += (long long)coefficients[j] * samples[i - j - 1];
+    }
+    samples[i] += (int)(sum >> shift);
+  }
+}
+
+static boolByte _flacDecoderReadSubframe(FlacDecoder self, int* samples, unsigned int blocksize,
+  unsigned int bitsPerSample) {
+  int coefficients[FLAC_MAX_LPC_ORDER];
+  unsigned int type;
+  unsigned int wastedBits = 0;
+  unsigned int order;
+  unsigned int precision;
+  int shift;
+  int value;
+  unsigned int i;
+
+  if(_flacDecoderReadBits(self, 1) != 0) {
+    return false;
+  }
+  type = _flacDecoderReadBits(self, 6);
+  if(_flacDecoderReadBits(self, 1)) {
+    wastedBits = _flacDecoderReadUnary(self) + 1;
+    if(wastedBits >= bitsPerSample) {
+      return false;
+    }
+    bitsPerSample -= wastedBits;
+  }
+
+  if(type == 0) {
+    value = _flacDecoderReadSignedBits(self, bitsPerSample);
+    for(i = 0; i < blocksize; i++) {
+      samples[i] = value;
+    }
+  }
+  else if(type == 1) {
+    for(i = 0; i < blocksize; i++) {
+      samples[i] = _flacDecoderReadSignedBits(self, bitsPerSample);
+    }
+  }
+  else if(type >= 8 && type <= 8 + FLAC_MAX_FIXED_ORDER) {
+    order = type - 8;
+    if(order > blocksize) {
+      return false;
+    }
+    for(i = 0; i < order; i++) {
+      samples[i] = _flacDecoderReadSignedBits(self, bitsPerSample);
+    }
+    if(!_flacDecoderReadResidual(self, samples, blocksize, order)) {
+      return false;
+    }
+    _flacRestoreFixed(samples, blocksize, order);
+  }
+  else if(type >= 32) {
+    order = type - 31;
+    if(order > blocksize) {
+      return false;
+    }
+    for(i = 0; i < order; i++) {
+      samples[i] = _flacDecoderReadSignedBits(self, bitsPerSample);
+    }
+    precision = _flacDecoderReadBits(self, 4) + 1;
+    shift = _flacDecoderReadSignedBits(self, 5);
+    if(precision == 16 || shift < 0) {
+      return false;
+    }
+    for(i = 0; i < order; i++) {
+      coefficients[i] = _flacDecoderReadSignedBits(self, precision);
+    }
+    if(!_flacDecoderReadResidual(self, samples, blocksize, order)) {
+      return false;
+    }
+    _flacRestoreLpc(samples, blocksize, coefficients, order, shift);
+  }
+  else {
+    // Reserved subframe types
+    return false;
+  }
+
+  if(wastedBits > 0) {
+    for(i = 0; i < blocksize; i++) {
+      samples[i] = (int)((unsigned int)samples[i] << wastedBits);
+    }
+  }
+  return (boolByte)!self->_isTruncated;
+}
+
+static void _flacDecorrelateChannels(FlacDecoder self, unsigned int channelAssignment, unsigned int blocksize) {
+  int* left = self->decodedSamples[0];
+  int* right = self->decodedSamples[1];
+  int mid;
+  int side;
+  unsigned int i;
+
+  switch(channelAssignment) {
+    case FLAC_CHANNELS_LEFT_SIDE:
+      for(i = 0; i < blocksize; i++) {
+        right[i] = left[i] - right[i];
+      }
+      break;
+    case FLAC_CHANNELS_SIDE_RIGHT:
+      for(i = 0; i < blocksize; i++) {
+        left[i] += right[i];
+      }
+      break;
+    case FLAC_CHANNELS_MID_SIDE:
+      for(i = 0; i < blocksize; i++) {
+        side = right[i];
+        // The lowest bit of the mid channel was dropped, but it is the same as
+        // the lowest bit of the side channel
+        mid = (int)((unsigned int)left[i] << 1) | (side & 1);
+        left[i] = (mid + side) >> 1;
+        right[i] = (mid - side) >> 1;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+boolByte flacDecoderDecodeFrame(FlacDecoder self) {
+  FlacFrameHeader header;
+  unsigned int channel;
+  unsigned int bitsPerSample;
+  unsigned int crc;
+
+  self->decodedBlocksize = 0;
+  self->decodedReadPosition = 0;
+
+  while(true) {
+    if(!_flacDecoderFindSync(self)) {
+      // Running out of data while looking for a frame is the normal end of the stream
+      self->_isTruncated = false;
+      return false;
+    }
+    if(_flacDecoderReadFrameHeader(self, &header)) {
+      break;
+    }
+    if(self->_isTruncated) {
+      logError("FLAC file ended in a frame header");
+      return false;
+    }
+    // This was not a frame header after all, so keep searching from the next byte
+    self->_bytePosition = self->_markPosition + 1;
+    self->_bitPosition = 0;
+  }
+
+  if(header.numChannels != self->numChannels || header.bitsPerSample != self->bitsPerSample) {
+    logError("FLAC frame at sample %llu has a different format than the stream", self->_nextFramePosition);
+    return false;
+  }
+  _flacDecoderResizeDecodedSamples(self, header.blocksize);
+
+  for(channel = 0; channel < header.numChannels; channel++) {
+    // Side channels need one more bit
+    bitsPerSample = header.bitsPerSample;
+    if((header.channelAssignment == FLAC_CHANNELS_LEFT_SIDE && channel == 1) ||
+      (header.channelAssignment == FLAC_CHANNELS_SIDE_RIGHT && channel == 0) ||
+      (header.channelAssignment == FLAC_CHANNELS_MID_SIDE && channel == 1)) {
+      bitsPerSample++;
+    }
+    if(bitsPerSample > FLAC_MAX_BITS_PER_SAMPLE) {
+      logUnsupportedFeature("FLAC files with 32-bit stereo decorrelation");
+      return false;
+    }
+    if(!_flacDecoderReadSubframe(self, self->decodedSamples[channel], header.blocksize, bitsPerSample)) {
+      if(self->_isTruncated) {
+        logError("FLAC file ended in the middle of a frame");
+      }
+      else {
+        logError("Invalid subframe in FLAC frame at sample %llu", self->_nextFramePosition);
+      }
+      return false;
+    }
+  }
+
+  // The frame CRC covers everything up to the footer, which starts on the next byte
+  _flacDecoderAlignToByte(self);
+  if(!_flacDecoderEnsureBytes(self, 2)) {
+    logError("FLAC file ended in the middle of a frame");
+    return false;
+  }
+  crc = flacCrc16(self->_buffer + self->_markPosition, self->_bytePosition - self->_markPosition);
+  if(_flacDecoderReadBits(self, 16) != crc) {
+    logError("CRC mismatch in FLAC frame at sample %llu", self->_nextFramePosition);
+    return false;
+  }
+
+  _flacDecorrelateChannels(self, header.channelAssignment, header.blocksize);
+  self->decodedBlocksize = header.blocksize;
+  self->decodedPosition = self->_nextFramePosition;
+  self->_nextFramePosition += header.blocksize;
+  return true;
+}
+
+// Integer samples are scaled like the PCM conversion functions do, so that
+// FLAC and uncompressed files with the same content decode to the same values
+static float _flacGetSampleScale(unsigned int bitsPerSample) {
+  if(bitsPerSample >= 32) {
+    return 2147483648.0f;
+  }
+  return (float)((1ul << (bitsPerSample - 1)) - 1);
+}
+
+unsigned long flacDecoderRead(FlacDecoder self, SampleBuffer sampleBuffer) {
+  const float scale = _flacGetSampleScale(self->bitsPerSample);
+  unsigned long numFramesRead = 0;
+  unsigned long numFrames;
+  unsigned long i;
+  unsigned int channel;
+  const int* in;
+  Sample* out;
+
+  while(numFramesRead < sampleBuffer->blocksize) {
+    if(self->decodedReadPosition >= self->decodedBlocksize && !flacDecoderDecodeFrame(self)) {
+      break;
+    }
+    numFrames = self->decodedBlocksize - self->decodedReadPosition;
+    if(numFrames > sampleBuffer->blocksize - numFramesRead) {
+      numFrames = sampleBuffer->blocksize - numFramesRead;
+    }
+
+    for(channel = 0; channel < sampleBuffer->numChannels; channel++) {
+      out = sampleBuffer->samples[channel] + numFramesRead;
+      if(channel < self->numChannels) {
+        in = self->decodedSamples[channel] + self->decodedReadPosition;
+        for(i = 0; i < numFrames; i++) {
+          out[i] = (Sample)in[i] / scale;
+        }
+      }
+      else {
+        memset(out, 0, sizeof(Sample) * numFrames);
+      }
+    }
+    self->decodedReadPosition += (unsigned int)numFrames;
+    numFramesRead += numFrames;
+  }
+  return numFramesRead;
+}
+
+boolByte flacDecoderSeek(FlacDecoder self, unsigned long long sampleNumber) {
+  const FlacSeekPoint* seekPoint = NULL;
+  unsigned long long startPosition = 0;
+  long fileOffset = self->_firstFrameOffset;
+  unsigned int i;
+
+  if(self->totalSamples > 0 && sampleNumber > self->totalSamples) {
+    return false;
+  }
+  // Samples in the last decoded frame are still in memory
+  if(self->decodedBlocksize > 0 && sampleNumber >= self->decodedPosition &&
+    sampleNumber < self->decodedPosition + self->decodedBlocksize) {
+    self->decodedReadPosition = (unsigned int)(sampleNumber - self->decodedPosition);
+    return true;
+  }
+
+  for(i = 0; i < self->numSeekPoints; i++) {
+    if(self->seekPoints[i].sampleNumber <= sampleNumber &&
+      (seekPoint == NULL || self->seekPoints[i].sampleNumber > seekPoint->sampleNumber)) {
+      seekPoint = &self->seekPoints[i];
+    }
+  }
+  if(seekPoint != NULL) {
+    startPosition = seekPoint->sampleNumber;
+    fileOffset += (long)seekPoint->streamOffset;
+  }
+  if(fseek(self->_fileHandle, fileOffset, SEEK_SET) != 0) {
+    return false;
+  }
+
+  self->_bufferLength = 0;
+  self->_bytePosition = 0;
+  self->_bitPosition = 0;
+  self->_markPosition = 0;
+  self->_bufferFileOffset = fileOffset;
+  self->_isTruncated = false;
+  self->_nextFramePosition = startPosition;
+  self->decodedPosition = startPosition;
+  self->decodedBlocksize = 0;
+  self->decodedReadPosition = 0;
+
+  // Decode frames until reaching the one which holds the sample
+  while(self->_nextFramePosition <= sampleNumber) {
+    if(!flacDecoderDecodeFrame(self)) {
+      // The end of the stream is also a valid position
+      return (boolByte)(self->_nextFramePosition == sampleNumber);
+    }
+  }
+  self->decodedReadPosition = (unsigned int)(sampleNumber - self->decodedPosition);
+  return true;
+}
+
+FlacDecoder newFlacDecoder(FILE* fileHandle, const char* filename) {
+  FlacDecoder self = (FlacDecoder)malloc(sizeof(FlacDecoderMembers));
+  unsigned int i;
+
+  self->sampleRate = 0;
+  self->numChannels = 0;
+  self->bitsPerSample = 0;
+  self->minBlocksize = 0;
+  self->maxBlocksize = 0;
+  self->totalSamples = 0;
+  self->seekPoints = NULL;
+  self->numSeekPoints = 0;
+  for(i = 0; i < FLAC_MAX_CHANNELS; i++) {
+    self->decodedSamples[i] = NULL;
+  }
+  self->decodedBlocksize = 0;
+  self->decodedPosition = 0;
+  self->decodedReadPosition = 0;
+
+  self->_fileHandle = fileHandle;
+  self->_firstFrameOffset = 0;
+  self->_nextFramePosition = 0;
+  self->_decodedCapacity = 0;
+  self->_bufferSize = FLAC_DECODER_INITIAL_BUFFER_SIZE;
+  self->_buffer = (byte*)malloc(self->_bufferSize + FLAC_DECODER_BUFFER_PADDING);
+  memset(self->_buffer, 0, FLAC_DECODER_BUFFER_PADDING);
+  self->_bufferLength = 0;
+  self->_bytePosition = 0;
+  self->_bitPosition = 0;
+  self->_markPosition = 0;
+  self->_bufferFileOffset = ftell(fileHandle);
+  self->_isTruncated = false;
+
+  if(!_flacDecoderReadMetadata(self, filename)) {
+    freeFlacDecoder(self);
+    return NULL;
+  }
+  self->_firstFrameOffset = self->_bufferFileOffset + (long)self->_bytePosition;
+  _flacDecoderResizeDecodedSamples(self, self->maxBlocksize > 0 ? self->maxBlocksize : FLAC_DECODER_DEFAULT_BLOCKSIZE);
+
+  logDebug("FLAC stream has %d channels, %d bits per sample, %llu samples",
+    self->numChannels, self->bitsPerSample, self->totalSamples);
+  return self;
+}
+
+void freeFlacDecoder(FlacDecoder self) {
+  unsigned int i;
+  if(self == NULL) {
+    return;
+  }
+  for(i = 0; i < FLAC_MAX_CHANNELS; i++) {
+    free(self->decodedSamples[i]);
+  }
+  free(self->seekPoints);
+  free(self->_buffer);
+  free(self);
+}
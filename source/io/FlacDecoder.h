@@ -0,0 +1,138 @@
+//
+// FlacDecoder.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_FlacDecoder_h
+#define MrsWatson_FlacDecoder_h
+
+#include <stdio.h>
+
+#include "audio/SampleBuffer.h"
+#include "base/Types.h"
+#include "io/FlacFormat.h"
+
+/**
+ * Streaming decoder for native FLAC files. Frames are decoded one at a time
+ * to integer samples, which are then converted into the planar channels of a
+ * SampleBuffer. The decoder has no dependencies besides the C library.
+ */
+typedef struct {
+  // Stream properties from the STREAMINFO block
+  unsigned int sampleRate;
+  unsigned int numChannels;
+  unsigned int bitsPerSample;
+  unsigned int minBlocksize;
+  unsigned int maxBlocksize;
+  // Number of samples in each channel, or 0 if the encoder didn't know it
+  unsigned long long totalSamples;
+
+  // Seek points from the SEEKTABLE block, without placeholders
+  FlacSeekPoint* seekPoints;
+  unsigned int numSeekPoints;
+
+  // Samples of the last decoded frame, one array per channel
+  int* decodedSamples[FLAC_MAX_CHANNELS];
+  unsigned int decodedBlocksize;
+  // Number of the first sample in the last decoded frame
+  unsigned long long decodedPosition;
+  // Index of the next sample from the last decoded frame to be returned
+  unsigned int decodedReadPosition;
+
+  /** Private */
+  FILE* _fileHandle;
+  /** Private, file offset of the first frame */
+  long _firstFrameOffset;
+  /** Private, number of the first sample in the next frame */
+  unsigned long long _nextFramePosition;
+  /** Private, capacity of each array in decodedSamples */
+  unsigned int _decodedCapacity;
+
+  // Input buffer. Data from _markPosition onwards is kept when refilling, so
+  // that a frame is in memory as a whole when its CRC is checked.
+  /** Private */
+  byte* _buffer;
+  /** Private */
+  size_t _bufferSize;
+  /** Private */
+  size_t _bufferLength;
+  /** Private */
+  size_t _bytePosition;
+  /** Private */
+  unsigned int _bitPosition;
+  /** Private */
+  size_t _markPosition;
+  /** Private, file offset of the start of the buffer */
+  long _bufferFileOffset;
+  /** Private, set when a read ran past the end of the file */
+  boolByte _isTruncated;
+} FlacDecoderMembers;
+typedef FlacDecoderMembers* FlacDecoder;
+
+/**
+ * Create a new decoder and read the stream's metadata
+ * @param fileHandle File to decode, positioned at the start of the stream. It
+ * is not closed by the decoder.
+ * @param filename Name of the file, for error messages
+ * @return Initialized decoder, or NULL if the file is not a valid FLAC stream
+ */
+FlacDecoder newFlacDecoder(FILE* fileHandle, const char* filename);
+
+/**
+ * Decode the next frame in the stream into decodedSamples
+ * @param self
+ * @return False at the end of the stream, or if the frame is invalid
+ */
+boolByte flacDecoderDecodeFrame(FlacDecoder self);
+
+/**
+ * Decode samples into a SampleBuffer, which is filled from as many frames as
+ * needed. Samples are scaled to [-1.0, 1.0] in the same way as integer PCM data.
+ * Buffer channels which are not in the stream are set to silence.
+ * @param self
+ * @param sampleBuffer Buffer to fill, up to its blocksize
+ * @return Number of frames decoded, which is less than the blocksize only at
+ * the end of the stream
+ */
+unsigned long flacDecoderRead(FlacDecoder self, SampleBuffer sampleBuffer);
+
+/**
+ * Move to the given sample. The nearest seek point before the sample is used
+ * to find the frame containing it, or the start of the stream if there is no
+ * seek table.
+ * @param self
+ * @param sampleNumber Sample to be returned next by flacDecoderRead()
+ * @return True on success, false if the sample is past the end of the stream
+ * or the file can't be seeked
+ */
+boolByte flacDecoderSeek(FlacDecoder self, unsigned long long sampleNumber);
+
+/**
+ * Free a decoder and all associated memory
+ * @param self
+ */
+void freeFlacDecoder(FlacDecoder self);
+
+#endif
@@ -0,0 +1,1210 @@
+//
+// FlacEncoder.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/PcmConversion.h"
+#include "io/FlacEncoder.h"
+#include "logging/EventLogger.h"
+
+#define FLAC_ENCODER_JOBS_PER_THREAD 2
+#define FLAC_ENCODER_MAX_PARTITION_ORDER 8
+#define FLAC_ENCODER_MAX_RICE_PARAMETER 30
+// Largest Rice parameter which can be stored with 4 bits, since 15 is the escape code
+#define FLAC_ENCODER_MAX_SHORT_RICE_PARAMETER 14
+#define FLAC_ENCODER_MAX_LPC_SHIFT 15
+#define FLAC_ENCODER_MAX_LPC_PRECISION 15
+#define FLAC_ENCODER_PI 3.14159265358979323846
+
+typedef enum {
+  FLAC_SUBFRAME_CONSTANT,
+  FLAC_SUBFRAME_VERBATIM,
+  FLAC_SUBFRAME_FIXED,
+  FLAC_SUBFRAME_LPC
+} FlacSubframeType;
+
+typedef enum {
+  FLAC_JOB_FREE,
+  FLAC_JOB_SUBMITTED,
+  FLAC_JOB_ENCODED
+} FlacJobState;
+
+// Settings for each compression level, modeled after those of the reference encoder
+typedef struct {
+  unsigned int blocksize;
+  boolByte decorrelateStereo;
+  unsigned int maxLpcOrder;
+  unsigned int maxPartitionOrder;
+  // Try every LPC order instead of the one which the prediction error suggests
+  boolByte exhaustiveLpcSearch;
+} FlacCompressionSettings;
+
+static const FlacCompressionSettings kFlacCompressionLevels[FLAC_ENCODER_MAX_COMPRESSION_LEVEL + 1] = {
+  {1152, false, 0, 3, false},
+  {1152, true, 0, 3, false},
+  {1152, true, 0, 4, false},
+  {4096, false, 6, 4, false},
+  {4096, true, 8, 4, false},
+  {4096, true, 8, 5, false},
+  {4096, true, 8, 6, false},
+  {4096, true, 12, 6, false},
+  {4096, true, 12, 6, true}
+};
+
+// How a subframe is to be encoded. The bit count is exact for all parts but
+// the residual, where it is an upper bound.
+typedef struct {
+  FlacSubframeType type;
+  unsigned int bitsPerSample;
+  unsigned int wastedBits;
+  unsigned int order;
+  unsigned int precision;
+  int shift;
+  int coefficients[FLAC_MAX_LPC_ORDER];
+  unsigned int partitionOrder;
+  unsigned int riceParameters[1 << FLAC_ENCODER_MAX_PARTITION_ORDER];
+  unsigned long long numBits;
+} FlacSubframe;
+
+typedef struct FlacEncoderJobMembers {
+  volatile FlacJobState state;
+  unsigned long frameNumber;
+  unsigned int blocksize;
+
+  // Input samples for each channel. For stereo streams, the third and fourth
+  // arrays hold the mid and side signals.
+  int* samples[FLAC_MAX_CHANNELS];
+  // Residual of the best subframe found so far for each signal, and one more
+  // for trying the next candidate
+  int* residuals[FLAC_MAX_CHANNELS];
+  int* trialResidual;
+  FlacSubframe subframes[FLAC_MAX_CHANNELS];
+  FlacSubframe trialSubframe;
+
+  double* window;
+  double* windowedSamples;
+  unsigned int windowBlocksize;
+
+  byte* output;
+  size_t outputSize;
+  size_t outputCapacity;
+} FlacEncoderJob;
+
+typedef struct FlacEncoderWorkerMembers {
+  FlacEncoder encoder;
+  unsigned int index;
+  Thread thread;
+  // Notified when a job is submitted to this worker, or when it should stop
+  ThreadSignal signal;
+} FlacEncoderWorker;
+
+typedef struct {
+  byte* data;
+  size_t position;
+  unsigned long long cache;
+  unsigned int cacheBits;
+} FlacBitWriter;
+
+static void _bitWriterPut(FlacBitWriter* writer, unsigned int value, unsigned int numBits) {
+  if(numBits == 0) {
+    return;
+  }
+  if(numBits < 32) {
+    value &= (1u << numBits) - 1;
+  }
+  writer->cache = (writer->cache << numBits) | value;
+  writer->cacheBits += numBits;
+  while(writer->cacheBits >= 8) {
+    writer->cacheBits -= 8;
+    writer->data[writer->position++] = (byte)(writer->cache >> writer->cacheBits);
+  }
+}
+
+static void _bitWriterPutSigned(FlacBitWriter* writer, int value, unsigned int numBits) {
+  _bitWriterPut(writer, (unsigned int)value, numBits);
+}
+
+static void _bitWriterPutRice(FlacBitWriter* writer, int value, unsigned int parameter) {
+  const unsigned int zigzag = ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+  unsigned int quotient = zigzag >> parameter;
+
+  // Most values fit in a single write of the zeros, the stop bit and the remainder
+  if(quotient + 1 + parameter <= 32) {
+    _bitWriterPut(writer, (1u << parameter) | (zigzag & ((1u << parameter) - 1)), quotient + 1 + parameter);
+    return;
+  }
+  while(quotient >= 32) {
+    _bitWriterPut(writer, 0, 32);
+    quotient -= 32;
+  }
+  _bitWriterPut(writer, 1, quotient + 1);
+  _bitWriterPut(writer, zigzag, parameter);
+}
+
+static void _bitWriterAlign(FlacBitWriter* writer) {
+  if(writer->cacheBits > 0) {
+    _bitWriterPut(writer, 0, 8 - writer->cacheBits);
+  }
+}
+
+static unsigned int _getBlocksizeCode(unsigned int blocksize) {
+  switch(blocksize) {
+    case 192: return 1;
+    case 576: return 2;
+    case 1152: return 3;
+    case 2304: return 4;
+    case 4608: return 5;
+    case 256: return 8;
+    case 512: return 9;
+    case 1024: return 10;
+    case 2048: return 11;
+    case 4096: return 12;
+    case 8192: return 13;
+    case 16384: return 14;
+    case 32768: return 15;
+    default:
+      // Stored after the frame number, as blocksize - 1 in 8 or 16 bits
+      return blocksize <= 256 ? 6 : 7;
+  }
+}
+
+static unsigned int _getSampleRateCode(unsigned int sampleRate) {
+  switch(sampleRate) {
+    case 88200: return 1;
+    case 176400: return 2;
+    case 192000: return 3;
+    case 8000: return 4;
+    case 16000: return 5;
+    case 22050: return 6;
+    case 24000: return 7;
+    case 32000: return 8;
+    case 44100: return 9;
+    case 48000: return 10;
+    case 96000: return 11;
+    default:
+      break;
+  }
+  if(sampleRate % 1000 == 0 && sampleRate / 1000 <= 255) {
+    return 12;
+  }
+  else if(sampleRate <= 65535) {
+    return 13;
+  }
+  else if(sampleRate % 10 == 0 && sampleRate / 10 <= 65535) {
+    return 14;
+  }
+  // Taken from STREAMINFO
+  return 0;
+}
+
+static unsigned int _getSampleSizeCode(unsigned int bitsPerSample) {
+  switch(bitsPerSample) {
+    case 8: return 1;
+    case 12: return 2;
+    case 16: return 4;
+    case 20: return 5;
+    case 24: return 6;
+    default: return 0;
+  }
+}
+
+// Precision of quantized LPC coefficients, as chosen by the reference encoder
+static unsigned int _getLpcPrecision(unsigned int bitsPerSample, unsigned int blocksize) {
+  if(bitsPerSample < 16) {
+    return 2 + bitsPerSample / 2 > 5 ? 2 + bitsPerSample / 2 : 5;
+  }
+  else if(bitsPerSample == 16) {
+    if(blocksize <= 192) {
+      return 7;
+    }
+    else if(blocksize <= 384) {
+      return 8;
+    }
+    else if(blocksize <= 576) {
+      return 9;
+    }
+    else if(blocksize <= 1152) {
+      return 10;
+    }
+    else if(blocksize <= 2304) {
+      return 11;
+    }
+    else if(blocksize <= 4608) {
+      return 12;
+    }
+    return 13;
+  }
+  return FLAC_ENCODER_MAX_LPC_PRECISION;
+}
+
+static unsigned long long _getRiceBits(unsigned long long sum, unsigned int numSamples, unsigned int parameter) {
+  // The sum of the quotients is never larger than the quotient of the sum, so
+  // this is an upper bound for the actual size
+  return (unsigned long long)numSamples * (parameter + 1) + (sum >> parameter);
+}
+
+static unsigned int _getRiceParameter(unsigned long long sum, unsigned int numSamples) {
+  unsigned int parameter = 0;
+  unsigned int best;
+
+  if(numSamples == 0) {
+    return 0;
+  }
+  // Start near log2 of the mean, then check the neighbours
+  while(parameter < FLAC_ENCODER_MAX_RICE_PARAMETER && ((unsigned long long)numSamples << (parameter + 1)) <= sum) {
+    parameter++;
+  }
+  best = parameter;
+  if(parameter > 0 && _getRiceBits(sum, numSamples, parameter - 1) < _getRiceBits(sum, numSamples, best)) {
+    best = parameter - 1;
+  }
+  if(parameter < FLAC_ENCODER_MAX_RICE_PARAMETER &&
+    _getRiceBits(sum, numSamples, parameter + 1) < _getRiceBits(sum, numSamples, best)) {
+    best = parameter + 1;
+  }
+  return best;
+}
+
+/**
+ * Choose the partition order and Rice parameters for a residual
+ * @param residual Residual of samples order to blocksize - 1
+ * @param blocksize Number of samples in the subframe
+ * @param order Predictor order
+ * @param maxPartitionOrder Largest partition order to try
+ * @param subframe Subframe which receives the partition order and parameters
+ * @return Number of bits needed for the residual, including its header
+ */
+static unsigned long long _chooseRiceParameters(const int* residual, unsigned int blocksize, unsigned int order,
+  unsigned int maxPartitionOrder, FlacSubframe* subframe) {
+  unsigned long long sums[1 << FLAC_ENCODER_MAX_PARTITION_ORDER];
+  unsigned int parameters[1 << FLAC_ENCODER_MAX_PARTITION_ORDER];
+  unsigned long long bestBits = 0;
+  unsigned long long bits;
+  unsigned int partitionOrder;
+  unsigned int numPartitions;
+  unsigned int partitionSize;
+  unsigned int numSamples;
+  unsigned int partition;
+  unsigned int i;
+  unsigned int start;
+  unsigned int end;
+  boolByte needsLongParameters;
+
+  if(maxPartitionOrder > FLAC_ENCODER_MAX_PARTITION_ORDER) {
+    maxPartitionOrder = FLAC_ENCODER_MAX_PARTITION_ORDER;
+  }
+  // Partitions must divide the block evenly and be longer than the warmup
+  while(maxPartitionOrder > 0 && ((blocksize & ((1u << maxPartitionOrder) - 1)) != 0 ||
+    (blocksize >> maxPartitionOrder) <= order)) {
+    maxPartitionOrder--;
+  }
+
+  // Sum up the zigzag coded values in the smallest partitions, larger
+  // partitions are found by adding neighbouring sums
+  numPartitions = 1u << maxPartitionOrder;
+  partitionSize = blocksize >> maxPartitionOrder;
+  for(partition = 0; partition < numPartitions; partition++) {
+    start = partition == 0 ? 0 : partition * partitionSize - order;
+    end = (partition + 1) * partitionSize - order;
+    sums[partition] = 0;
+    for(i = start; i < end; i++) {
+      sums[partition] += ((unsigned int)residual[i] << 1) ^ (unsigned int)(residual[i] >> 31);
+    }
+  }
+
+  for(partitionOrder = maxPartitionOrder + 1; partitionOrder-- > 0;) {
+    numPartitions = 1u << partitionOrder;
+    partitionSize = blocksize >> partitionOrder;
+    // Coding method and partition order
+    bits = 2 + 4;
+    needsLongParameters = false;
+    for(partition = 0; partition < numPartitions; partition++) {
+      numSamples = partition == 0 ? partitionSize - order : partitionSize;
+      parameters[partition] = _getRiceParameter(sums[partition], numSamples);
+      if(parameters[partition] > FLAC_ENCODER_MAX_SHORT_RICE_PARAMETER) {
+        needsLongParameters = true;
+      }
+      bits += _getRiceBits(sums[partition], numSamples, parameters[partition]);
+    }
+    bits += numPartitions * (needsLongParameters ? 5 : 4);
+
+    if(partitionOrder == maxPartitionOrder || bits < bestBits) {
+      bestBits = bits;
+      subframe->partitionOrder = partitionOrder;
+      memcpy(subframe->riceParameters, parameters, sizeof(unsigned int) * numPartitions);
+    }
+
+    for(partition = 0; partition < numPartitions / 2; partition++) {
+      sums[partition] = sums[2 * partition] + sums[2 * partition + 1];
+    }
+  }
+  return bestBits;
+}
+
+static void _computeFixedResidual(const int* samples, unsigned int blocksize, unsigned int order, int* residual) {
+  unsigned int i;
+  for(i = order; i < blocksize; i++) {
+    switch(order) {
+      case 0:
+        residual[i] = samples[i];
+        break;
+      case 1:
+        residual[i - 1] = samples[i] - samples[i - 1];
+        break;
+      case 2:
+        residual[i - 2] = (int)(samples[i] - 2LL * samples[i - 1] + samples[i - 2]);
+        break;
+      case 3:
+        residual[i - 3] = (int)(samples[i] - 3LL * samples[i - 1] + 3LL * samples[i - 2] - samples[i - 3]);
+        break;
+      default:
+        residual[i - 4] = (int)(samples[i] - 4LL * samples[i - 1] + 6LL * samples[i - 2] -
+          4LL * samples[i - 3] + samples[i - 4]);
+        break;
+    }
+  }
+}
+
+// Estimate the best fixed predictor order from the sum of the absolute residuals
+static unsigned int _chooseFixedOrder(const int* samples, unsigned int blocksize) {
+  unsigned long long sums[FLAC_MAX_FIXED_ORDER + 1] = {0, 0, 0, 0, 0};
+  long long error0;
+  long long error1;
+  long long error2;
+  long long error3;
+  long long error4;
+  unsigned int best = 0;
+  unsigned int order;
+  unsigned int i;
+
+  for(i = FLAC_MAX_FIXED_ORDER; i < blocksize; i++) {
+    error0 = samples[i];
+    error1 = error0 - samples[i - 1];
+    error2 = error1 - ((long long)samples[i - 1] - samples[i - 2]);
+    error3 = error2 - ((long long)samples[i - 1] - 2LL * samples[i - 2] + samples[i - 3]);
+    error4 = error3 - ((long long)samples[i - 1] - 3LL * samples[i - 2] + 3LL * samples[i - 3] - samples[i - 4]);
+    sums[0] += (unsigned long long)llabs(error0);
+    sums[1] += (unsigned long long)llabs(error1);
+    sums[2] += (unsigned long long)llabs(error2);
+    sums[3] += (unsigned long long)llabs(error3);
+    sums[4] += (unsigned long long)llabs(error4);
+  }
+  for(order = 1; order <= FLAC_MAX_FIXED_ORDER; order++) {
+    if(sums[order] < sums[best]) {
+      best = order;
+    }
+  }
+  return best;
+}
+
+// Tukey window with half of the samples tapered, like the reference encoder's default
+static void _computeWindow(double* window, unsigned int blocksize) {
+  const unsigned int taperSize = blocksize / 4;
+  unsigned int i;
+
+  for(i = 0; i < blocksize; i++) {
+    window[i] = 1.0;
+  }
+  if(taperSize < 2) {
+    return;
+  }
+  for(i = 0; i < taperSize; i++) {
+    window[i] = 0.5 - 0.5 * cos(FLAC_ENCODER_PI * i / taperSize);
+    window[blocksize - 1 - i] = window[i];
+  }
+}
+
+/**
+ * Find LPC coefficients for every order up to maxOrder with the Levinson-Durbin
+ * recursion.
+ * @return Highest order which could be computed
+ */
+static unsigned int _computeLpcCoefficients(const double* autocorrelation, unsigned int maxOrder,
+  double coefficients[FLAC_MAX_LPC_ORDER][FLAC_MAX_LPC_ORDER], double* errors) {
+  double reflection[FLAC_MAX_LPC_ORDER];
+  double error = autocorrelation[0];
+  double r;
+  double temp;
+  unsigned int i;
+  unsigned int j;
+
+  for(i = 0; i < maxOrder; i++) {
+    r = -autocorrelation[i + 1];
+    for(j = 0; j < i; j++) {
+      r -= reflection[j] * autocorrelation[i - j];
+    }
+    r /= error;
+
+    reflection[i] = r;
+    for(j = 0; j < i / 2; j++) {
+      temp = reflection[j];
+      reflection[j] += r * reflection[i - 1 - j];
+      reflection[i - 1 - j] += r * temp;
+    }
+    if(i & 1) {
+      reflection[j] += reflection[j] * r;
+    }
+    error *= 1.0 - r * r;
+
+    for(j = 0; j <= i; j++) {
+      coefficients[i][j] = -reflection[j];
+    }
+    errors[i] = error;
+    if(error <= 0.0) {
+      return i + 1;
+    }
+  }
+  return maxOrder;
+}
+
+static boolByte _quantizeLpcCoefficients(const double* coefficients, unsigned int order, unsigned int precision,
+  int* quantized, int* shift) {
+  const int maxCoefficient = (1 << (precision - 1)) - 1;
+  const int minCoefficient = -(1 << (precision - 1));
+  double maxMagnitude = 0.0;
+  double error = 0.0;
+  int exponent;
+  long value;
+  unsigned int i;
+
+  for(i = 0; i < order; i++) {
+    if(fabs(coefficients[i]) > maxMagnitude) {
+      maxMagnitude = fabs(coefficients[i]);
+    }
+  }
+  if(maxMagnitude <= 0.0) {
+    return false;
+  }
+
+  // Scale so that the largest coefficient uses all bits of the precision
+  frexp(maxMagnitude, &exponent);
+  *shift = (int)precision - 1 - exponent;
+  if(*shift > FLAC_ENCODER_MAX_LPC_SHIFT) {
+    *shift = FLAC_ENCODER_MAX_LPC_SHIFT;
+  }
+  else if(*shift < 0) {
+    return false;
+  }
+
+  // Carry the rounding error over to the next coefficient
+  for(i = 0; i < order; i++) {
+    error += coefficients[i] * (double)(1 << *shift);
+    value = lround(error);
+    if(value > maxCoefficient) {
+      value = maxCoefficient;
+    }
+    else if(value < minCoefficient) {
+      value = minCoefficient;
+    }
+    error -= (double)value;
+    quantized[i] = (int)value;
+  }
+  return true;
+}
+
+static boolByte _computeLpcResidual(const int* samples, unsigned int blocksize, const int* coefficients,
+  unsigned int order, int shift, int* residual) {
+  long long sum;
+  long long value;
+  unsigned int i;
+  unsigned int j;
+
+  for(i = order; i < blocksize; i++) {
+    sum = 0;
+    for(j = 0; j < order; j++) {
+      sum += (long long)coefficients[j] * samples[i - j - 1];
+    }
+    value = samples[i] - (sum >> shift);
+    // Residuals must fit in 32 bits, which bad predictions of loud signals may not
+    if(value > 0x3fffffffLL || value < -0x3fffffffLL) {
+      return false;
+    }
+    residual[i - order] = (int)value;
+  }
+  return true;
+}
+
+static void _keepTrialSubframe(FlacEncoderJob* job, unsigned int signal) {
+  int* residual = job->residuals[signal];
+  job->residuals[signal] = job->trialResidual;
+  job->trialResidual = residual;
+  job->subframes[signal] = job->trialSubframe;
+}
+
+static void _tryLpcSubframes(FlacEncoderJob* job, unsigned int signal,
+  const FlacCompressionSettings* settings, unsigned int headerBits) {
+  const int* samples = job->samples[signal];
+  const unsigned int blocksize = job->blocksize;
+  FlacSubframe* trial = &job->trialSubframe;
+  const unsigned int bitsPerSample = job->subframes[signal].bitsPerSample;
+  const unsigned int precision = _getLpcPrecision(bitsPerSample, blocksize);
+  double autocorrelation[FLAC_MAX_LPC_ORDER + 1];
+  double coefficients[FLAC_MAX_LPC_ORDER][FLAC_MAX_LPC_ORDER];
+  double errors[FLAC_MAX_LPC_ORDER];
+  double bestEstimate = 0.0;
+  double estimate;
+  double bitsPerResidual;
+  unsigned int maxOrder = settings->maxLpcOrder;
+  unsigned int minOrder;
+  unsigned int order;
+  unsigned int lag;
+  unsigned int i;
+  unsigned long long bits;
+
+  if(maxOrder >= blocksize) {
+    maxOrder = blocksize - 1;
+  }
+
+  if(job->windowBlocksize != blocksize) {
+    _computeWindow(job->window, blocksize);
+    job->windowBlocksize = blocksize;
+  }
+  for(i = 0; i < blocksize; i++) {
+    job->windowedSamples[i] = samples[i] * job->window[i];
+  }
+  for(lag = 0; lag <= maxOrder; lag++) {
+    autocorrelation[lag] = 0.0;
+    for(i = lag; i < blocksize; i++) {
+      autocorrelation[lag] += job->windowedSamples[i] * job->windowedSamples[i - lag];
+    }
+  }
+  if(autocorrelation[0] <= 0.0) {
+    return;
+  }
+  maxOrder = _computeLpcCoefficients(autocorrelation, maxOrder, coefficients, errors);
+
+  minOrder = 1;
+  if(!settings->exhaustiveLpcSearch) {
+    // Estimate the size of each order from its prediction error, and only try the best one
+    for(order = 1; order <= maxOrder; order++) {
+      bitsPerResidual = errors[order - 1] > 0.0 ? 0.5 * log(0.5 * errors[order - 1] / blocksize) / log(2.0) : 0.0;
+      if(bitsPerResidual < 0.0) {
+        bitsPerResidual = 0.0;
+      }
+      estimate = bitsPerResidual * (blocksize - order) + (double)order * (bitsPerSample + precision);
+      if(order == 1 || estimate < bestEstimate) {
+        bestEstimate = estimate;
+        minOrder = order;
+      }
+    }
+    maxOrder = minOrder;
+  }
+
+  for(order = minOrder; order <= maxOrder; order++) {
+    trial->type = FLAC_SUBFRAME_LPC;
+    trial->bitsPerSample = bitsPerSample;
+    trial->wastedBits = job->subframes[signal].wastedBits;
+    trial->order = order;
+    trial->precision = precision;
+    if(!_quantizeLpcCoefficients(coefficients[order - 1], order, precision, trial->coefficients, &trial->shift) ||
+      !_computeLpcResidual(samples, blocksize, trial->coefficients, order, trial->shift, job->trialResidual)) {
+      continue;
+    }
+    bits = headerBits + order * bitsPerSample + 4 + 5 + order * precision +
+      _chooseRiceParameters(job->trialResidual, blocksize, order, settings->maxPartitionOrder, trial);
+    if(bits < job->subframes[signal].numBits) {
+      trial->numBits = bits;
+      _keepTrialSubframe(job, signal);
+    }
+  }
+}
+
+/**
+ * Find the smallest encoding for one signal of a job. The result is stored
+ * in the job's subframe and residual for that signal.
+ */
+static void _analyzeSubframe(FlacEncoder self, FlacEncoderJob* job, unsigned int signal, unsigned int bitsPerSample) {
+  const FlacCompressionSettings* settings = &kFlacCompressionLevels[self->compressionLevel];
+  const unsigned int blocksize = job->blocksize;
+  int* samples = job->samples[signal];
+  FlacSubframe* best = &job->subframes[signal];
+  FlacSubframe* trial = &job->trialSubframe;
+  unsigned int headerBits;
+  unsigned int wastedBits = 0;
+  unsigned int bits = 0;
+  unsigned int order;
+  unsigned int i;
+
+  for(i = 1; i < blocksize && samples[i] == samples[0]; i++) {
+  }
+  if(i == blocksize) {
+    best->type = FLAC_SUBFRAME_CONSTANT;
+    best->bitsPerSample = bitsPerSample;
+    best->wastedBits = 0;
+    best->numBits = 8 + bitsPerSample;
+    return;
+  }
+
+  // Low bits which are zero in every sample don't need to be stored
+  for(i = 0; i < blocksize; i++) {
+    bits |= (unsigned int)samples[i];
+  }
+  while(!(bits & 1) && wastedBits < bitsPerSample - 1) {
+    bits >>= 1;
+    wastedBits++;
+  }
+  if(wastedBits > 0) {
+    for(i = 0; i < blocksize; i++) {
+      samples[i] >>= wastedBits;
+    }
+    bitsPerSample -= wastedBits;
+  }
+  headerBits = 8 + wastedBits;
+
+  best->type = FLAC_SUBFRAME_VERBATIM;
+  best->bitsPerSample = bitsPerSample;
+  best->wastedBits = wastedBits;
+  best->numBits = headerBits + (unsigned long long)blocksize * bitsPerSample;
+  if(blocksize <= FLAC_MAX_FIXED_ORDER) {
+    return;
+  }
+
+  order = _chooseFixedOrder(samples, blocksize);
+  trial->type = FLAC_SUBFRAME_FIXED;
+  trial->bitsPerSample = bitsPerSample;
+  trial->wastedBits = wastedBits;
+  trial->order = order;
+  _computeFixedResidual(samples, blocksize, order, job->trialResidual);
+  trial->numBits = headerBits + order * bitsPerSample +
+    _chooseRiceParameters(job->trialResidual, blocksize, order, settings->maxPartitionOrder, trial);
+  if(trial->numBits < best->numBits) {
+    _keepTrialSubframe(job, signal);
+  }
+
+  if(settings->maxLpcOrder > 0) {
+    _tryLpcSubframes(job, signal, settings, headerBits);
+  }
+}
+
+static void _writeResidual(FlacBitWriter* writer, const FlacSubframe* subframe, const int* residual,
+  unsigned int blocksize) {
+  const unsigned int numPartitions = 1u << subframe->partitionOrder;
+  const unsigned int partitionSize = blocksize >> subframe->partitionOrder;
+  unsigned int parameterBits = 4;
+  unsigned int partition;
+  unsigned int parameter;
+  unsigned int i = 0;
+  unsigned int end;
+
+  for(partition = 0; partition < numPartitions; partition++) {
+    if(subframe->riceParameters[partition] > FLAC_ENCODER_MAX_SHORT_RICE_PARAMETER) {
+      parameterBits = 5;
+    }
+  }
+  _bitWriterPut(writer, parameterBits == 4 ? 0 : 1, 2);
+  _bitWriterPut(writer, subframe->partitionOrder, 4);
+  for(partition = 0; partition < numPartitions; partition++) {
+    parameter = subframe->riceParameters[partition];
+    _bitWriterPut(writer, parameter, parameterBits);
+    end = (partition + 1) * partitionSize - subframe->order;
+    for(; i < end; i++) {
+      _bitWriterPutRice(writer, residual[i], parameter);
+    }
+  }
+}
+
+static void _writeSubframe(FlacBitWriter* writer, const FlacSubframe* subframe, const int* samples,
+  const int* residual, unsigned int blocksize) {
+  unsigned int i;
+
+  _bitWriterPut(writer, 0, 1);
+  switch(subframe->type) {
+    case FLAC_SUBFRAME_CONSTANT:
+      _bitWriterPut(writer, 0, 6);
+      break;
+    case FLAC_SUBFRAME_VERBATIM:
+      _bitWriterPut(writer, 1, 6);
+      break;
+    case FLAC_SUBFRAME_FIXED:
+      _bitWriterPut(writer, 8 + subframe->order, 6);
+      break;
+    case FLAC_SUBFRAME_LPC:
+      _bitWriterPut(writer, 31 + subframe->order, 6);
+      break;
+  }
+  if(subframe->wastedBits > 0) {
+    // Flag followed by the number of wasted bits - 1 in unary
+    _bitWriterPut(writer, 1, 1);
+    _bitWriterPut(writer, 1, subframe->wastedBits);
+  }
+  else {
+    _bitWriterPut(writer, 0, 1);
+  }
+
+  if(subframe->type == FLAC_SUBFRAME_CONSTANT) {
+    _bitWriterPutSigned(writer, samples[0], subframe->bitsPerSample);
+    return;
+  }
+  else if(subframe->type == FLAC_SUBFRAME_VERBATIM) {
+    for(i = 0; i < blocksize; i++) {
+      _bitWriterPutSigned(writer, samples[i], subframe->bitsPerSample);
+    }
+    return;
+  }
+
+  for(i = 0; i < subframe->order; i++) {
+    _bitWriterPutSigned(writer, samples[i], subframe->bitsPerSample);
+  }
+  if(subframe->type == FLAC_SUBFRAME_LPC) {
+    _bitWriterPut(writer, subframe->precision - 1, 4);
+    _bitWriterPutSigned(writer, subframe->shift, 5);
+    for(i = 0; i < subframe->order; i++) {
+      _bitWriterPutSigned(writer, subframe->coefficients[i], subframe->precision);
+    }
+  }
+  _writeResidual(writer, subframe, residual, blocksize);
+}
+
+static void _writeFrameNumber(FlacBitWriter* writer, unsigned long frameNumber) {
+  unsigned int numBytes;
+  unsigned int i;
+
+  // Coded like UTF-8, with up to 36 bits in 7 bytes
+  if(frameNumber < 0x80) {
+    _bitWriterPut(writer, (unsigned int)frameNumber, 8);
+    return;
+  }
+  for(numBytes = 2; numBytes < 7 && frameNumber >= (1ul << (5 * numBytes + 1)); numBytes++) {
+  }
+  _bitWriterPut(writer, ((0xff00u >> numBytes) & 0xff) | (unsigned int)(frameNumber >> (6 * (numBytes - 1))), 8);
+  for(i = numBytes - 1; i-- > 0;) {
+    _bitWriterPut(writer, 0x80 | (unsigned int)((frameNumber >> (6 * i)) & 0x3f), 8);
+  }
+}
+
+static void _encodeJob(FlacEncoder self, FlacEncoderJob* job) {
+  const unsigned int blocksize = job->blocksize;
+  const FlacSubframe* subframes = job->subframes;
+  FlacBitWriter writer = {job->output, 0, 0, 0};
+  unsigned int channelAssignment = self->numChannels - 1;
+  unsigned int signals[FLAC_MAX_CHANNELS];
+  unsigned long long bits;
+  unsigned long long bestBits;
+  unsigned int blocksizeCode = _getBlocksizeCode(blocksize);
+  unsigned int sampleRateCode = _getSampleRateCode(self->sampleRate);
+  unsigned int channel;
+  unsigned int i;
+  int* left;
+  int* right;
+
+  for(channel = 0; channel < self->numChannels; channel++) {
+    signals[channel] = channel;
+  }
+
+  if(self->numChannels == 2 && kFlacCompressionLevels[self->compressionLevel].decorrelateStereo) {
+    // Mid and side go to the otherwise unused third and fourth arrays. These
+    // have to be computed before analyzing the channels, which may shift them.
+    left = job->samples[0];
+    right = job->samples[1];
+    for(i = 0; i < blocksize; i++) {
+      job->samples[2][i] = (int)(((long long)left[i] + right[i]) >> 1);
+      job->samples[3][i] = left[i] - right[i];
+    }
+    _analyzeSubframe(self, job, 0, self->bitsPerSample);
+    _analyzeSubframe(self, job, 1, self->bitsPerSample);
+    _analyzeSubframe(self, job, 2, self->bitsPerSample);
+    _analyzeSubframe(self, job, 3, self->bitsPerSample + 1);
+
+    bestBits = subframes[0].numBits + subframes[1].numBits;
+    bits = subframes[0].numBits + subframes[3].numBits;
+    if(bits < bestBits) {
+      bestBits = bits;
+      channelAssignment = FLAC_CHANNELS_LEFT_SIDE;
+      signals[1] = 3;
+    }
+    bits = subframes[3].numBits + subframes[1].numBits;
+    if(bits < bestBits) {
+      bestBits = bits;
+      channelAssignment = FLAC_CHANNELS_SIDE_RIGHT;
+      signals[0] = 3;
+      signals[1] = 1;
+    }
+    bits = subframes[2].numBits + subframes[3].numBits;
+    if(bits < bestBits) {
+      channelAssignment = FLAC_CHANNELS_MID_SIDE;
+      signals[0] = 2;
+      signals[1] = 3;
+    }
+  }
+  else {
+    for(channel = 0; channel < self->numChannels; channel++) {
+      _analyzeSubframe(self, job, channel, self->bitsPerSample);
+    }
+  }
+
+  // Frame header, with a fixed blocksize stream so the frame number is given
+  _bitWriterPut(&writer, FLAC_FRAME_SYNC_CODE, 14);
+  _bitWriterPut(&writer, 0, 2);
+  _bitWriterPut(&writer, blocksizeCode, 4);
+  _bitWriterPut(&writer, sampleRateCode, 4);
+  _bitWriterPut(&writer, channelAssignment, 4);
+  _bitWriterPut(&writer, _getSampleSizeCode(self->bitsPerSample), 3);
+  _bitWriterPut(&writer, 0, 1);
+  _writeFrameNumber(&writer, job->frameNumber);
+  if(blocksizeCode == 6) {
+    _bitWriterPut(&writer, blocksize - 1, 8);
+  }
+  else if(blocksizeCode == 7) {
+    _bitWriterPut(&writer, blocksize - 1, 16);
+  }
+  if(sampleRateCode == 12) {
+    _bitWriterPut(&writer, self->sampleRate / 1000, 8);
+  }
+  else if(sampleRateCode == 13) {
+    _bitWriterPut(&writer, self->sampleRate, 16);
+  }
+  else if(sampleRateCode == 14) {
+    _bitWriterPut(&writer, self->sampleRate / 10, 16);
+  }
+  _bitWriterPut(&writer, flacCrc8(writer.data, writer.position), 8);
+
+  for(channel = 0; channel < self->numChannels; channel++) {
+    _writeSubframe(&writer, &subframes[signals[channel]], job->samples[signals[channel]],
+      job->residuals[signals[channel]], blocksize);
+  }
+  _bitWriterAlign(&writer);
+  _bitWriterPut(&writer, flacCrc16(writer.data, writer.position), 16);
+  job->outputSize = writer.position;
+}
+
+static void* _flacEncoderWorkerThread(void* userData) {
+  FlacEncoderWorker* worker = (FlacEncoderWorker*)userData;
+  FlacEncoder self = worker->encoder;
+  FlacEncoderJob* job;
+  unsigned long jobNumber;
+  unsigned long generation;
+
+  // The number of jobs is a multiple of the number of threads, so each job slot
+  // always belongs to the same worker
+  for(jobNumber = worker->index; true; jobNumber += self->numThreads) {
+    job = &self->_jobs[jobNumber % self->_numJobs];
+    for(;;) {
+      generation = threadSignalGetGeneration(worker->signal);
+      if(job->state == FLAC_JOB_SUBMITTED) {
+        break;
+      }
+      if(self->_stopping) {
+        return NULL;
+      }
+      threadSignalWait(worker->signal, generation);
+    }
+    threadMemoryBarrier();
+    _encodeJob(self, job);
+    threadMemoryBarrier();
+    job->state = FLAC_JOB_ENCODED;
+    threadSignalNotify(self->_signal);
+  }
+}
+
+static void _writeStreamInfo(FlacEncoder self, byte* out) {
+  FlacBitWriter writer = {out, 0, 0, 0};
+  _bitWriterPut(&writer, self->blocksize, 16);
+  _bitWriterPut(&writer, self->blocksize, 16);
+  _bitWriterPut(&writer, self->_minFrameSize, 24);
+  _bitWriterPut(&writer, self->_maxFrameSize, 24);
+  _bitWriterPut(&writer, self->sampleRate, 20);
+  _bitWriterPut(&writer, self->numChannels - 1, 3);
+  _bitWriterPut(&writer, self->bitsPerSample - 1, 5);
+  _bitWriterPut(&writer, (unsigned int)(self->totalSamples >> 32), 4);
+  _bitWriterPut(&writer, (unsigned int)(self->totalSamples & 0xffffffff), 32);
+  // The MD5 signature is left empty, which means that it wasn't computed
+  memset(out + writer.position, 0, 16);
+}
+
+// Write finished frames in order. If waitForOldest is set and the oldest frame
+// isn't finished yet, wait for it.
+static void _writeEncodedJobs(FlacEncoder self, boolByte waitForOldest) {
+  FlacEncoderJob* job;
+  unsigned long generation;
+
+  while(self->_writeCount < self->_submitCount) {
+    job = &self->_jobs[self->_writeCount % self->_numJobs];
+    if(job->state != FLAC_JOB_ENCODED) {
+      if(!waitForOldest) {
+        break;
+      }
+      self->producerStalls++;
+      for(;;) {
+        generation = threadSignalGetGeneration(self->_signal);
+        if(job->state == FLAC_JOB_ENCODED) {
+          break;
+        }
+        threadSignalWait(self->_signal, generation);
+      }
+    }
+    threadMemoryBarrier();
+
+    if(!self->_failed && fwrite(job->output, 1, job->outputSize, self->_fileHandle) != job->outputSize) {
+      logError("Could not write FLAC frame to file");
+      self->_failed = true;
+    }
+    self->numBytesWritten += job->outputSize;
+    if(self->_minFrameSize == 0 || job->outputSize < self->_minFrameSize) {
+      self->_minFrameSize = (unsigned int)job->outputSize;
+    }
+    if(job->outputSize > self->_maxFrameSize) {
+      self->_maxFrameSize = (unsigned int)job->outputSize;
+    }
+    job->state = FLAC_JOB_FREE;
+    self->_writeCount++;
+    waitForOldest = false;
+  }
+}
+
+static void _submitJob(FlacEncoder self) {
+  FlacEncoderJob* job = &self->_jobs[self->_submitCount % self->_numJobs];
+
+  job->blocksize = self->_jobFill;
+  job->frameNumber = self->_submitCount;
+  self->totalSamples += self->_jobFill;
+  self->numFrames++;
+  self->_jobFill = 0;
+
+  if(self->numThreads == 0) {
+    _encodeJob(self, job);
+    job->state = FLAC_JOB_ENCODED;
+  }
+  else {
+    threadMemoryBarrier();
+    job->state = FLAC_JOB_SUBMITTED;
+    threadSignalNotify(self->_workers[self->_submitCount % self->numThreads].signal);
+  }
+  self->_submitCount++;
+}
+
+boolByte flacEncoderWrite(FlacEncoder self, const SampleBuffer sampleBuffer) {
+  FlacEncoderJob* job;
+  unsigned long frame = 0;
+  unsigned long numFrames;
+  unsigned int channel;
+
+  while(frame < sampleBuffer->blocksize) {
+    // Before filling a new job, make sure that its slot has been written
+    if(self->_jobFill == 0 && self->_submitCount - self->_writeCount >= self->_numJobs) {
+      _writeEncodedJobs(self, true);
+    }
+    job = &self->_jobs[self->_submitCount % self->_numJobs];
+    numFrames = self->blocksize - self->_jobFill;
+    if(numFrames > sampleBuffer->blocksize - frame) {
+      numFrames = sampleBuffer->blocksize - frame;
+    }
+
+    for(channel = 0; channel < self->numChannels; channel++) {
+      if(channel < sampleBuffer->numChannels) {
+        pcmConvertSamplesToInt(sampleBuffer->samples[channel] + frame, job->samples[channel] + self->_jobFill,
+          numFrames, self->bitsPerSample);
+      }
+      else {
+        memset(job->samples[channel] + self->_jobFill, 0, sizeof(int) * numFrames);
+      }
+    }
+    self->_jobFill += (unsigned int)numFrames;
+    frame += numFrames;
+    if(self->_jobFill == self->blocksize) {
+      _submitJob(self);
+    }
+  }
+
+  _writeEncodedJobs(self, false);
+  return (boolByte)!self->_failed;
+}
+
+boolByte flacEncoderFinish(FlacEncoder self) {
+  byte streamInfo[FLAC_STREAMINFO_SIZE];
+
+  if(self->_jobFill > 0) {
+    _submitJob(self);
+  }
+  while(self->_writeCount < self->_submitCount) {
+    _writeEncodedJobs(self, true);
+  }
+  logDebug("Wrote %lu FLAC frames, %llu bytes, producer stalled %lu times",
+    self->numFrames, self->numBytesWritten, self->producerStalls);
+
+  if(self->_streamInfoOffset >= 0 && !self->_failed) {
+    _writeStreamInfo(self, streamInfo);
+    if(fseek(self->_fileHandle, self->_streamInfoOffset, SEEK_SET) != 0 ||
+      fwrite(streamInfo, 1, FLAC_STREAMINFO_SIZE, self->_fileHandle) != FLAC_STREAMINFO_SIZE ||
+      fseek(self->_fileHandle, 0, SEEK_END) != 0) {
+      logError("Could not update FLAC stream header");
+      self->_failed = true;
+    }
+  }
+  if(fflush(self->_fileHandle) != 0) {
+    self->_failed = true;
+  }
+  return (boolByte)!self->_failed;
+}
+
+static void _initJob(FlacEncoder self, FlacEncoderJob* job) {
+  // Stereo streams use two extra arrays for the mid and side signals
+  const unsigned int numSignals = self->numChannels == 2 ? 4 : self->numChannels;
+  unsigned int i;
+
+  job->state = FLAC_JOB_FREE;
+  job->frameNumber = 0;
+  job->blocksize = 0;
+  for(i = 0; i < FLAC_MAX_CHANNELS; i++) {
+    job->samples[i] = i < numSignals ? (int*)malloc(sizeof(int) * self->blocksize) : NULL;
+    job->residuals[i] = i < numSignals ? (int*)malloc(sizeof(int) * self->blocksize) : NULL;
+  }
+  job->trialResidual = (int*)malloc(sizeof(int) * self->blocksize);
+  job->window = (double*)malloc(sizeof(double) * self->blocksize);
+  job->windowedSamples = (double*)malloc(sizeof(double) * self->blocksize);
+  job->windowBlocksize = 0;
+
+  // The chosen encoding of each subframe is never larger than verbatim, and
+  // side channels need one extra bit. The header and footer take up to 18 bytes.
+  job->outputCapacity = 32 + self->numChannels * (8 + ((size_t)self->blocksize * (self->bitsPerSample + 1) + 7) / 8);
+  job->output = (byte*)malloc(job->outputCapacity);
+  job->outputSize = 0;
+}
+
+static void _freeJob(FlacEncoderJob* job) {
+  unsigned int i;
+  for(i = 0; i < FLAC_MAX_CHANNELS; i++) {
+    free(job->samples[i]);
+    free(job->residuals[i]);
+  }
+  free(job->trialResidual);
+  free(job->window);
+  free(job->windowedSamples);
+  free(job->output);
+}
+
+static void _stopFlacEncoderWorkers(FlacEncoder self, unsigned int numWorkers) {
+  unsigned int i;
+
+  self->_stopping = true;
+  threadMemoryBarrier();
+  for(i = 0; i < numWorkers; i++) {
+    threadSignalNotify(self->_workers[i].signal);
+    freeThread(self->_workers[i].thread);
+    freeThreadSignal(self->_workers[i].signal);
+  }
+  free(self->_workers);
+  self->_workers = NULL;
+}
+
+FlacEncoder newFlacEncoder(FILE* fileHandle, unsigned int sampleRate, unsigned int numChannels,
+  unsigned int bitsPerSample, unsigned int compressionLevel, unsigned int numThreads) {
+  FlacEncoder self;
+  byte header[4 + FLAC_METADATA_HEADER_SIZE + FLAC_STREAMINFO_SIZE];
+  long position;
+  unsigned int i;
+
+  if(fileHandle == NULL || numChannels == 0 || numChannels > FLAC_MAX_CHANNELS ||
+    bitsPerSample < 8 || bitsPerSample > 24 || sampleRate == 0 || sampleRate >= (1 << 20) ||
+    compressionLevel > FLAC_ENCODER_MAX_COMPRESSION_LEVEL) {
+    logError("Invalid settings for FLAC encoder");
+    return NULL;
+  }
+
+  self = (FlacEncoder)malloc(sizeof(FlacEncoderMembers));
+  self->sampleRate = sampleRate;
+  self->numChannels = numChannels;
+  self->bitsPerSample = bitsPerSample;
+  self->blocksize = kFlacCompressionLevels[compressionLevel].blocksize;
+  self->compressionLevel = compressionLevel;
+  self->numThreads = numThreads > FLAC_ENCODER_MAX_THREADS ? FLAC_ENCODER_MAX_THREADS : numThreads;
+  self->totalSamples = 0;
+  self->numFrames = 0;
+  self->numBytesWritten = 0;
+  self->producerStalls = 0;
+
+  self->_fileHandle = fileHandle;
+  self->_minFrameSize = 0;
+  self->_maxFrameSize = 0;
+  self->_numJobs = self->numThreads > 0 ? self->numThreads * FLAC_ENCODER_JOBS_PER_THREAD : 1;
+  self->_jobs = (FlacEncoderJob*)malloc(sizeof(FlacEncoderJob) * self->_numJobs);
+  for(i = 0; i < self->_numJobs; i++) {
+    _initJob(self, &self->_jobs[i]);
+  }
+  self->_jobFill = 0;
+  self->_workers = NULL;
+  self->_submitCount = 0;
+  self->_writeCount = 0;
+  self->_signal = newThreadSignal();
+  self->_stopping = false;
+  self->_failed = false;
+
+  // The stream info is rewritten with the length and frame sizes when
+  // finishing, which isn't possible when writing to a pipe
+  position = ftell(fileHandle);
+  self->_streamInfoOffset = position >= 0 ? position + 4 + FLAC_METADATA_HEADER_SIZE : -1;
+  memcpy(header, FLAC_STREAM_MARKER, 4);
+  // Last metadata block flag and type, then the 24-bit block size
+  header[4] = 0x80 | FLAC_METADATA_STREAMINFO;
+  header[5] = 0;
+  header[6] = 0;
+  header[7] = FLAC_STREAMINFO_SIZE;
+  _writeStreamInfo(self, header + 4 + FLAC_METADATA_HEADER_SIZE);
+  if(fwrite(header, 1, sizeof(header), fileHandle) != sizeof(header)) {
+    logError("Could not write FLAC stream header");
+    freeFlacEncoder(self);
+    return NULL;
+  }
+
+  if(self->numThreads > 0) {
+    self->_workers = (FlacEncoderWorker*)malloc(sizeof(FlacEncoderWorker) * self->numThreads);
+    for(i = 0; i < self->numThreads; i++) {
+      self->_workers[i].encoder = self;
+      self->_workers[i].index = i;
+      self->_workers[i].signal = newThreadSignal();
+      self->_workers[i].thread = newThread(_flacEncoderWorkerThread, &self->_workers[i]);
+      if(!threadStart(self->_workers[i].thread)) {
+        logWarn("Could not start FLAC encoder thread, encoding on the calling thread instead");
+        _stopFlacEncoderWorkers(self, i + 1);
+        self->numThreads = 0;
+        self->_stopping = false;
+        break;
+      }
+    }
+  }
+
+  logDebug("Encoding FLAC at level %d with %d threads", compressionLevel, self->numThreads);
+  return self;
+}
+
+void freeFlacEncoder(FlacEncoder self) {
+  unsigned int i;
+
+  if(self == NULL) {
+    return;
+  }
+  if(self->_workers != NULL) {
+    _stopFlacEncoderWorkers(self, self->numThreads);
+  }
+  freeThreadSignal(self->_signal);
+  for(i = 0; i < self->_numJobs; i++) {
+    _freeJob(&self->_jobs[i]);
+  }
+  free(self->_jobs);
+  free(self);
+}
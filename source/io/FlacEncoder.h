@@ -0,0 +1,136 @@
+//
+// FlacEncoder.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_FlacEncoder_h
+#define MrsWatson_FlacEncoder_h
+
+#include <stdio.h>
+
+#include "audio/SampleBuffer.h"
+#include "base/Thread.h"
+#include "base/Types.h"
+#include "io/FlacFormat.h"
+
+#define FLAC_ENCODER_MAX_COMPRESSION_LEVEL 8
+#define FLAC_ENCODER_MAX_THREADS 16
+
+struct FlacEncoderJobMembers;
+struct FlacEncoderWorkerMembers;
+
+/**
+ * Encoder for native FLAC files. Samples are collected into blocks, and every
+ * block is encoded as an independent frame. Frames are handed to a pool of
+ * worker threads, where frame N goes to worker N modulo the number of workers,
+ * and are written to the file in order by the thread calling flacEncoderWrite().
+ * That thread only waits for the workers when every job slot is in use.
+ */
+typedef struct {
+  unsigned int sampleRate;
+  unsigned int numChannels;
+  unsigned int bitsPerSample;
+  unsigned int blocksize;
+  unsigned int compressionLevel;
+  unsigned int numThreads;
+
+  // Statistics, updated by the thread which writes samples
+  unsigned long long totalSamples;
+  unsigned long numFrames;
+  unsigned long long numBytesWritten;
+  unsigned long producerStalls;
+
+  /** Private */
+  FILE* _fileHandle;
+  /** Private, file offset of the STREAMINFO block, or -1 if it can't be rewritten */
+  long _streamInfoOffset;
+  /** Private */
+  unsigned int _minFrameSize;
+  /** Private */
+  unsigned int _maxFrameSize;
+  /** Private */
+  struct FlacEncoderJobMembers* _jobs;
+  /** Private */
+  unsigned int _numJobs;
+  /** Private, number of frames in the job being filled */
+  unsigned int _jobFill;
+  /** Private */
+  struct FlacEncoderWorkerMembers* _workers;
+  // Monotonically increasing job counters, the job slot is found by taking the
+  // counter modulo the number of jobs. Both are only modified by the producer.
+  /** Private */
+  unsigned long _submitCount;
+  /** Private */
+  unsigned long _writeCount;
+  /** Private, notified by the workers whenever a job has been encoded */
+  ThreadSignal _signal;
+  /** Private */
+  volatile boolByte _stopping;
+  /** Private */
+  boolByte _failed;
+} FlacEncoderMembers;
+typedef FlacEncoderMembers* FlacEncoder;
+
+/**
+ * Create a new encoder, write the stream header and start the worker threads
+ * @param fileHandle File to write to. It is not closed by the encoder.
+ * @param sampleRate Sample rate of the stream
+ * @param numChannels Number of channels, from 1 to 8
+ * @param bitsPerSample Size of the encoded samples, from 8 to 24 bits
+ * @param compressionLevel From 0 (fastest) to 8 (smallest), which sets the
+ * blocksize and how hard the encoder searches for a good prediction
+ * @param numThreads Number of worker threads. With 0, frames are encoded on the
+ * thread which writes samples, which is also done if the threads can't be started.
+ * @return Initialized encoder, or NULL if the settings are not valid
+ */
+FlacEncoder newFlacEncoder(FILE* fileHandle, unsigned int sampleRate, unsigned int numChannels,
+  unsigned int bitsPerSample, unsigned int compressionLevel, unsigned int numThreads);
+
+/**
+ * Add samples to the stream. Full blocks are submitted to the workers, and
+ * frames which are finished by then are written to the file.
+ * @param self
+ * @param sampleBuffer Samples to encode. Channels beyond the encoder's channels
+ * are ignored, and missing channels are encoded as silence.
+ * @return False if writing to the file has failed
+ */
+boolByte flacEncoderWrite(FlacEncoder self, const SampleBuffer sampleBuffer);
+
+/**
+ * Encode any remaining samples, wait for all frames to be written, and update
+ * the stream header with the total length if the file can be seeked.
+ * @param self
+ * @return False if writing to the file has failed
+ */
+boolByte flacEncoderFinish(FlacEncoder self);
+
+/**
+ * Stop the worker threads and free all memory. Samples which haven't been
+ * finished with flacEncoderFinish() are lost.
+ * @param self
+ */
+void freeFlacEncoder(FlacEncoder self);
+
+#endif
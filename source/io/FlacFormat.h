@@ -0,0 +1,96 @@
+//
+// FlacFormat.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_FlacFormat_h
+#define MrsWatson_FlacFormat_h
+
+#include <stddef.h>
+
+#include "base/Types.h"
+
+// Definitions shared by the FLAC decoder and encoder, see the format
+// specification at https://xiph.org/flac/format.html
+
+#define FLAC_STREAM_MARKER "fLaC"
+#define FLAC_METADATA_HEADER_SIZE 4
+#define FLAC_STREAMINFO_SIZE 34
+#define FLAC_SEEKPOINT_SIZE 18
+// Sample number of seek points which only reserve space in the seek table
+#define FLAC_SEEKPOINT_PLACEHOLDER 0xffffffffffffffffULL
+
+#define FLAC_FRAME_SYNC_CODE 0x3ffe
+#define FLAC_MAX_CHANNELS 8
+#define FLAC_MAX_BITS_PER_SAMPLE 32
+#define FLAC_MAX_BLOCKSIZE 65535
+#define FLAC_MAX_FIXED_ORDER 4
+#define FLAC_MAX_LPC_ORDER 32
+
+typedef enum {
+  FLAC_METADATA_STREAMINFO = 0,
+  FLAC_METADATA_PADDING = 1,
+  FLAC_METADATA_APPLICATION = 2,
+  FLAC_METADATA_SEEKTABLE = 3,
+  FLAC_METADATA_VORBIS_COMMENT = 4,
+  FLAC_METADATA_CUESHEET = 5,
+  FLAC_METADATA_PICTURE = 6
+} FlacMetadataType;
+
+// Values of the channel assignment field in frame headers. Values below
+// FLAC_CHANNELS_LEFT_SIDE give the number of independent channels minus one.
+typedef enum {
+  FLAC_CHANNELS_LEFT_SIDE = 8,
+  FLAC_CHANNELS_SIDE_RIGHT = 9,
+  FLAC_CHANNELS_MID_SIDE = 10
+} FlacChannelAssignment;
+
+typedef struct {
+  // Number of the first sample in the target frame
+  unsigned long long sampleNumber;
+  // Offset of the target frame from the first frame in the stream, in bytes
+  unsigned long long streamOffset;
+  // Number of samples in the target frame
+  unsigned int numSamples;
+} FlacSeekPoint;
+
+/**
+ * Calculate the CRC-8 which protects FLAC frame headers
+ * @param data Data to check
+ * @param numBytes Size of data
+ * @return Checksum, with polynomial x^8 + x^2 + x + 1 and an initial value of 0
+ */
+byte flacCrc8(const byte* data, size_t numBytes);
+
+/**
+ * Calculate the CRC-16 which protects whole FLAC frames
+ * @param data Data to check
+ * @param numBytes Size of data
+ * @return Checksum, with polynomial x^16 + x^15 + x^2 + 1 and an initial value
+ * of 0
+ */
+unsigned short flacCrc16(const byte* data, size_t numBytes);
+
+#endif
@@ -31,6 +31,16 @@
 #include "base/PlatformUtilities.h"
 #include "io/RiffFile.h"
 
+// The GUIDs of the RIFF and LIST chunks in Wave64 files start with their four
+// character ID, followed by this suffix
+static const byte kWave64RiffGuidSuffix[WAVE64_GUID_SIZE - 4] = {
+  0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00
+};
+// Suffix of the GUIDs for all other standard chunks, such as WAVE, fmt and data
+static const byte kWave64GuidSuffix[WAVE64_GUID_SIZE - 4] = {
+  0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A
+};
+
 RiffChunk newRiffChunk(void) {
   RiffChunk chunk = (RiffChunk)malloc(sizeof(RiffChunkMembers));
   memset(chunk->id, 0, 5);
@@ -60,8 +70,8 @@ boolByte riffChunkReadNext(RiffChunk self, FILE* fileHandle, boolByte readData)
     free(chunkSize);
 
     if(self->size > 0 && readData) {
-      self->data = (byte*)malloc(self->size);
-      itemsRead = fread(self->data, 1, self->size, fileHandle);
+      self->data = (byte*)malloc((size_t)self->size);
+      itemsRead = fread(self->data, 1, (size_t)self->size, fileHandle);
       if(itemsRead != self->size) {
         return false;
       }
@@ -71,6 +81,68 @@ boolByte riffChunkReadNext(RiffChunk self, FILE* fileHandle, boolByte readData)
   return (boolByte)!feof(fileHandle);
 }
 
+boolByte riffChunkReadNextBigEndian(RiffChunk self, FILE* fileHandle, boolByte readData) {
+  byte header[8];
+
+  if(fileHandle == NULL || fread(header, 1, 8, fileHandle) != 8) {
+    return false;
+  }
+  memcpy(self->id, header, 4);
+  self->size = ((unsigned long long)header[4] << 24) | ((unsigned long long)header[5] << 16) |
+    ((unsigned long long)header[6] << 8) | (unsigned long long)header[7];
+
+  if(self->size > 0 && readData) {
+    self->data = (byte*)malloc((size_t)self->size);
+    if(fread(self->data, 1, (size_t)self->size, fileHandle) != self->size) {
+      return false;
+    }
+  }
+
+  return (boolByte)!feof(fileHandle);
+}
+
+boolByte riffChunkReadNextWave64(RiffChunk self, FILE* fileHandle, boolByte readData) {
+  byte header[WAVE64_CHUNK_HEADER_SIZE];
+  unsigned long long chunkSize;
+
+  if(fileHandle == NULL || fread(header, 1, WAVE64_CHUNK_HEADER_SIZE, fileHandle) != WAVE64_CHUNK_HEADER_SIZE) {
+    return false;
+  }
+
+  if(!memcmp(header + 4, kWave64RiffGuidSuffix, sizeof(kWave64RiffGuidSuffix)) ||
+    !memcmp(header + 4, kWave64GuidSuffix, sizeof(kWave64GuidSuffix))) {
+    memcpy(self->id, header, 4);
+  }
+  else {
+    memset(self->id, 0, 4);
+  }
+
+  chunkSize = (unsigned long long)convertByteArrayToUnsignedLongLong(header + WAVE64_GUID_SIZE);
+  if(chunkSize < WAVE64_CHUNK_HEADER_SIZE) {
+    return false;
+  }
+  self->size = chunkSize - WAVE64_CHUNK_HEADER_SIZE;
+
+  if(self->size > 0 && readData) {
+    self->data = (byte*)malloc((size_t)self->size);
+    if(fread(self->data, 1, (size_t)self->size, fileHandle) != self->size) {
+      return false;
+    }
+  }
+
+  return (boolByte)!feof(fileHandle);
+}
+
+void riffChunkGetWave64Guid(const char* id, byte* outGuid) {
+  memcpy(outGuid, id, 4);
+  if(!strncmp(id, "riff", 4) || !strncmp(id, "list", 4)) {
+    memcpy(outGuid + 4, kWave64RiffGuidSuffix, sizeof(kWave64RiffGuidSuffix));
+  }
+  else {
+    memcpy(outGuid + 4, kWave64GuidSuffix, sizeof(kWave64GuidSuffix));
+  }
+}
+
 boolByte riffChunkIsIdEqualTo(const RiffChunk self, const char*id) {
   return (boolByte)(strncmp(self->id, id, 4) == 0);
 }
@@ -33,9 +33,14 @@
 #include "base/CharString.h"
 #include "base/Types.h"
 
+// Size of a Wave64 chunk header, which has a GUID and a 64-bit size
+#define WAVE64_CHUNK_HEADER_SIZE 24
+#define WAVE64_GUID_SIZE 16
+
 typedef struct {
   char id[5];
-  unsigned int size;
+  // Size of the chunk's data, not counting the header or any padding
+  unsigned long long size;
   byte* data;
 } RiffChunkMembers;
 typedef RiffChunkMembers* RiffChunk;
@@ -58,6 +63,37 @@ RiffChunk newRiffChunk(void);
  */
 boolByte riffChunkReadNext(RiffChunk self, FILE* fileHandle, boolByte readData);
 
+/**
+ * Read the next chunk of an IFF file, such as AIFF. These chunks are the same
+ * as RIFF chunks, except that the size is stored in big endian byte order.
+ * @param self
+ * @param fileHandle IFF file, which should be opened for reading
+ * @param readData If true, save the contents of the chunk in the data field
+ * @return True if the chunk was successfully read
+ */
+boolByte riffChunkReadNextBigEndian(RiffChunk self, FILE* fileHandle, boolByte readData);
+
+/**
+ * Read the next chunk of a Sony Wave64 file. Wave64 chunks have a GUID instead
+ * of a four character ID, and a 64-bit size which includes the header. The
+ * GUIDs of the standard RIFF chunks contain their four character ID, which is
+ * used for the chunk's ID so that it can be compared like that of a RIFF chunk.
+ * Chunks with other GUIDs get an empty ID.
+ * @param self
+ * @param fileHandle Wave64 file, which should be opened for reading
+ * @param readData If true, save the contents of the chunk in the data field
+ * @return True if the chunk was successfully read
+ */
+boolByte riffChunkReadNextWave64(RiffChunk self, FILE* fileHandle, boolByte readData);
+
+/**
+ * Get the Wave64 GUID for a standard RIFF chunk ID
+ * @param id Four character chunk ID, such as "riff", "wave", "fmt " or "data".
+ * Note that Wave64 uses lower case for the IDs of the RIFF and WAVE headers.
+ * @param outGuid Buffer which receives the 16-byte GUID, as stored in the file
+ */
+void riffChunkGetWave64Guid(const char* id, byte* outGuid);
+
 /**
  * Test to see if this chunk's ID is equal to the given four character sequence
  * @param self
@@ -31,6 +31,8 @@
 
 #include "base/File.h"
 #include "io/SampleSource.h"
+#include "io/SampleSourceFlac.h"
+#include "io/SampleSourcePcm.h"
 #include "logging/EventLogger.h"
 
 void sampleSourcePrintSupportedTypes(void) {
@@ -38,14 +40,9 @@ void sampleSourcePrintSupportedTypes(void) {
   // We can theoretically support more formats, pretty much anything audiofile supports
   // would work here. However, most of those file types are rather uncommon, and require
   // special setup when writing, so we only choose the most common ones.
-#if HAVE_LIBAUDIOFILE
-  logInfo("- AIFF (via libaudiofile)");
-#else
-  logInfo("- AIFF (internal, experimental)");
-#endif
-#if HAVE_LIBFLAC
-  logInfo("- FLAC");
-#endif
+  logInfo("- AIFF/AIFC (internal)");
+  logInfo("- FLAC (internal)");
+  logInfo("- MrsWatson planar float (internal)");
 #if HAVE_LIBLAME
   logInfo("- MP3");
 #endif
@@ -59,6 +56,12 @@ void sampleSourcePrintSupportedTypes(void) {
 #else
   logInfo("- WAV (internal)");
 #endif
+  logInfo("- Wave64 (internal)");
+}
+
+boolByte sampleSourceIsStdio(const CharString sampleSourceName) {
+  return (boolByte)(sampleSourceName != NULL && sampleSourceName->data[0] == '-' &&
+    (sampleSourceName->data[1] == '\0' || sampleSourceName->data[1] == '.'));
 }
 
 static SampleSourceType _sampleSourceGuess(const CharString sampleSourceName) {
@@ -70,7 +73,7 @@ static SampleSourceType _sampleSourceGuess(const CharString sampleSourceName) {
     result = SAMPLE_SOURCE_TYPE_SILENCE;
   }
   else {
-    // Look for stdin/stdout
+    // Look for stdin/stdout. Names like '-.wav' are guessed from their extension.
     if(strlen(sampleSourceName->data) == 1 && sampleSourceName->data[0] == '-') {
       result = SAMPLE_SOURCE_TYPE_PCM;
     }
@@ -90,14 +93,13 @@ static SampleSourceType _sampleSourceGuess(const CharString sampleSourceName) {
         result = SAMPLE_SOURCE_TYPE_PCM;
       }
       else if(charStringIsEqualToCString(sourceFileExtension, "aif", true) ||
-        charStringIsEqualToCString(sourceFileExtension, "aiff", true)) {
+        charStringIsEqualToCString(sourceFileExtension, "aiff", true) ||
+        charStringIsEqualToCString(sourceFileExtension, "aifc", true)) {
         result = SAMPLE_SOURCE_TYPE_AIFF;
       }
-#if HAVE_LIBFLAC
       else if(charStringIsEqualToCString(sourceFileExtension, "flac", true)) {
         result = SAMPLE_SOURCE_TYPE_FLAC;
       }
-#endif
 #if HAVE_LIBLAME
       else if(charStringIsEqualToCString(sourceFileExtension, "mp3", true)) {
         result = SAMPLE_SOURCE_TYPE_MP3;
@@ -113,6 +115,12 @@ static SampleSourceType _sampleSourceGuess(const CharString sampleSourceName) {
         charStringIsEqualToCString(sourceFileExtension, "wave", true)) {
         result = SAMPLE_SOURCE_TYPE_WAVE;
       }
+      else if(charStringIsEqualToCString(sourceFileExtension, "w64", true)) {
+        result = SAMPLE_SOURCE_TYPE_WAVE64;
+      }
+      else if(charStringIsEqualToCString(sourceFileExtension, "mwp", true)) {
+        result = SAMPLE_SOURCE_TYPE_PLANAR;
+      }
       else {
         logCritical("Sample source '%s' does not match any supported type", sampleSourceName->data);
         result = SAMPLE_SOURCE_TYPE_INVALID;
@@ -128,6 +136,8 @@ extern SampleSource _newSampleSourcePcm(const CharString sampleSourceName);
 extern SampleSource _newSampleSourceSilence();
 extern SampleSource _newSampleSourceAiff(const CharString sampleSourceName);
 extern SampleSource _newSampleSourceWave(const CharString sampleSourceName);
+extern SampleSource _newSampleSourceWave64(const CharString sampleSourceName);
+extern SampleSource _newSampleSourcePlanar(const CharString sampleSourceName);
 
 SampleSource sampleSourceFactory(const CharString sampleSourceName) {
   SampleSourceType sampleSourceType = _sampleSourceGuess(sampleSourceName);
@@ -138,10 +148,8 @@ SampleSource sampleSourceFactory(const CharString sampleSourceName) {
       return _newSampleSourcePcm(sampleSourceName);
     case SAMPLE_SOURCE_TYPE_AIFF:
       return _newSampleSourceAiff(sampleSourceName);
-#if HAVE_LIBFLAC
     case SAMPLE_SOURCE_TYPE_FLAC:
       return newSampleSourceFlac(sampleSourceName);
-#endif
 #if HAVE_LIBLAME
     case SAMPLE_SOURCE_TYPE_MP3:
       return newSampleSourceMp3(sampleSourceName);
@@ -152,11 +160,32 @@ SampleSource sampleSourceFactory(const CharString sampleSourceName) {
 #endif
     case SAMPLE_SOURCE_TYPE_WAVE:
       return _newSampleSourceWave(sampleSourceName);
+    case SAMPLE_SOURCE_TYPE_WAVE64:
+      return _newSampleSourceWave64(sampleSourceName);
+    case SAMPLE_SOURCE_TYPE_PLANAR:
+      return _newSampleSourcePlanar(sampleSourceName);
     default:
       return NULL;
   }
 }
 
+boolByte sampleSourcePreallocate(SampleSource self, unsigned long numFrames) {
+  if(self == NULL || self->openedAs != SAMPLE_SOURCE_OPEN_WRITE) {
+    return false;
+  }
+  switch(self->sampleSourceType) {
+    case SAMPLE_SOURCE_TYPE_PCM:
+    case SAMPLE_SOURCE_TYPE_AIFF:
+#if ! HAVE_LIBAUDIOFILE
+    case SAMPLE_SOURCE_TYPE_WAVE:
+#endif
+    case SAMPLE_SOURCE_TYPE_WAVE64:
+      return sampleSourcePcmPreallocate((SampleSourcePcmData)self->extraData, numFrames);
+    default:
+      return false;
+  }
+}
+
 void freeSampleSource(SampleSource self) {
   self->freeSampleSourceData(self->extraData);
   freeCharString(self->sourceName);
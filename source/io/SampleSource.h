@@ -41,6 +41,8 @@ typedef enum {
   SAMPLE_SOURCE_TYPE_MP3,
   SAMPLE_SOURCE_TYPE_OGG,
   SAMPLE_SOURCE_TYPE_WAVE,
+  SAMPLE_SOURCE_TYPE_WAVE64,
+  SAMPLE_SOURCE_TYPE_PLANAR,
   NUM_SAMPLE_SOURCES
 } SampleSourceType;
 
@@ -54,6 +56,7 @@ typedef enum {
 typedef boolByte (*OpenSampleSourceFunc)(void*, const SampleSourceOpenAs);
 typedef boolByte (*ReadSampleBlockFunc)(void*, SampleBuffer);
 typedef boolByte (*WriteSampleBlockFunc)(void*, const SampleBuffer);
+typedef boolByte (*SeekSampleSourceFunc)(void*, unsigned long);
 typedef void (*CloseSampleSourceFunc)(void*);
 typedef void (*FreeSampleSourceDataFunc)(void*);
 
@@ -62,10 +65,16 @@ typedef struct {
   SampleSourceOpenAs openedAs;
   CharString sourceName;
   unsigned long numSamplesProcessed;
+  // Length of a source opened for reading, or 0 if it is not known (ie, for
+  // streams or formats which don't store it)
+  unsigned long lengthInFrames;
 
   OpenSampleSourceFunc openSampleSource;
   ReadSampleBlockFunc readSampleBlock;
   WriteSampleBlockFunc writeSampleBlock;
+  // Move the read position to the given frame, may be NULL if the source
+  // type doesn't support seeking
+  SeekSampleSourceFunc seekSampleSource;
   CloseSampleSourceFunc closeSampleSource;
   FreeSampleSourceDataFunc freeSampleSourceData;
 
@@ -80,11 +89,29 @@ typedef SampleSourceMembers* SampleSource;
  */
 SampleSource sampleSourceFactory(const CharString sampleSourceName);
 
+/**
+ * Check if a source name refers to stdin or stdout. This is either '-' for raw
+ * PCM data, or '-' followed by an extension to select another type, such as
+ * '-.wav'.
+ * @param sampleSourceName Source name
+ * @return True if the source should be read from stdin or written to stdout
+ */
+boolByte sampleSourceIsStdio(const CharString sampleSourceName);
+
 /**
  * Print a list of all supported sample source pipes to the log
  */
 void sampleSourcePrintSupportedTypes(void);
 
+/**
+ * Reserve disk space for a source opened for writing, when the length of the
+ * output is known in advance. Only uncompressed file types are supported.
+ * @param self
+ * @param numFrames Expected number of frames which will be written
+ * @return True if space was reserved
+ */
+boolByte sampleSourcePreallocate(SampleSource self, unsigned long numFrames);
+
 /**
  * Release a sample source and associated resources
  * @param self
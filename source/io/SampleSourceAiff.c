@@ -25,54 +25,351 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "audio/AudioSettings.h"
+#include "io/RiffFile.h"
 #include "io/SampleSourcePcm.h"
 #include "logging/EventLogger.h"
 
-#if HAVE_LIBAUDIOFILE
-#include "io/SampleSourceAudiofile.h"
+// Size of the COMM chunk in AIFF files, and in AIFC files with an empty
+// compression name (a one byte length and a padding byte)
+#define AIFF_COMM_CHUNK_SIZE 18
+#define AIFC_COMM_CHUNK_SIZE (AIFF_COMM_CHUNK_SIZE + 4 + 2)
+// Version of the AIFC specification, which must be given in the FVER chunk
+#define AIFC_VERSION_1 0xA2805140u
+// Offset to the sample data in the SSND chunk, followed by the block size
+#define AIFF_SSND_HEADER_SIZE 8
+// Largest header which is written, that of an AIFC file with an FVER chunk
+#define AIFF_MAX_HEADER_SIZE (12 + 8 + 4 + 8 + AIFC_COMM_CHUNK_SIZE + 8 + AIFF_SSND_HEADER_SIZE)
 
-#if LINUX
-#include <audiofile.h>
-#else
-#include "audiofile.h"
-#endif
-#endif
+static unsigned int _getBigEndianShort(const byte* in) {
+  return ((unsigned int)in[0] << 8) | in[1];
+}
+
+static unsigned int _getBigEndianInt(const byte* in) {
+  return ((unsigned int)in[0] << 24) | ((unsigned int)in[1] << 16) | ((unsigned int)in[2] << 8) | in[3];
+}
+
+static void _setBigEndianShort(byte* out, unsigned int value) {
+  out[0] = (byte)((value >> 8) & 0xff);
+  out[1] = (byte)(value & 0xff);
+}
+
+static void _setBigEndianInt(byte* out, unsigned int value) {
+  out[0] = (byte)((value >> 24) & 0xff);
+  out[1] = (byte)((value >> 16) & 0xff);
+  out[2] = (byte)((value >> 8) & 0xff);
+  out[3] = (byte)(value & 0xff);
+}
+
+// The sample rate is stored as an 80-bit IEEE 754 extended precision number,
+// with a sign bit, a 15-bit exponent and a 64-bit mantissa with an explicit
+// integer bit
+static double _getAiffSampleRate(const byte* in) {
+  const int exponent = (int)(((in[0] & 0x7f) << 8) | in[1]);
+  const unsigned long long mantissa = ((unsigned long long)_getBigEndianInt(in + 2) << 32) | _getBigEndianInt(in + 6);
+  const double value = ldexp((double)mantissa, exponent - 16383 - 63);
+  return (in[0] & 0x80) ? -value : value;
+}
+
+static void _setAiffSampleRate(byte* out, double sampleRate) {
+  int exponent = 0;
+  unsigned long long mantissa;
+
+  memset(out, 0, 10);
+  if(sampleRate <= 0.0) {
+    return;
+  }
+  // frexp() gives a mantissa in [0.5, 1), so the integer bit is the top bit of
+  // the 64-bit mantissa
+  mantissa = (unsigned long long)ldexp(frexp(sampleRate, &exponent), 64);
+  _setBigEndianShort(out, (unsigned int)(exponent - 1 + 16383));
+  _setBigEndianInt(out + 2, (unsigned int)(mantissa >> 32));
+  _setBigEndianInt(out + 6, (unsigned int)(mantissa & 0xffffffff));
+}
+
+static PcmSampleFormat _getAiffIntegerFormat(unsigned int bitsPerSample) {
+  // Sample sizes which are not a multiple of 8 are padded to whole bytes, with
+  // the sample in the most significant bits
+  switch((bitsPerSample + 7) / 8) {
+    case 2:
+      return PCM_SAMPLE_FORMAT_INT16;
+    case 3:
+      return PCM_SAMPLE_FORMAT_INT24;
+    case 4:
+      return PCM_SAMPLE_FORMAT_INT32;
+    default:
+      return PCM_SAMPLE_FORMAT_NUM_FORMATS;
+  }
+}
+
+static boolByte _readAiffCommonChunk(const char* filename, const RiffChunk chunk, boolByte isAifc,
+  SampleSourcePcmData extraData, unsigned long* outNumFrames) {
+  const char* compressionType = "NONE";
+
+  if(chunk->size < AIFF_COMM_CHUNK_SIZE || (isAifc && chunk->size < AIFF_COMM_CHUNK_SIZE + 4)) {
+    logFileError(filename, "COMM chunk is too small");
+    return false;
+  }
+
+  extraData->numChannels = (unsigned short)_getBigEndianShort(chunk->data);
+  *outNumFrames = _getBigEndianInt(chunk->data + 2);
+  extraData->bitsPerSample = (unsigned short)_getBigEndianShort(chunk->data + 6);
+  extraData->sampleRate = (unsigned int)_getAiffSampleRate(chunk->data + 8);
+  if(isAifc) {
+    compressionType = (const char*)chunk->data + AIFF_COMM_CHUNK_SIZE;
+  }
+
+  // Uncompressed AIFC files may also have integer samples in little endian
+  // byte order, or floating point samples. The type IDs are case-sensitive,
+  // but some writers use upper case for the float types.
+  extraData->isLittleEndian = false;
+  if(!strncmp(compressionType, "NONE", 4) || !strncmp(compressionType, "twos", 4)) {
+    extraData->sampleFormat = _getAiffIntegerFormat(extraData->bitsPerSample);
+  }
+  else if(!strncmp(compressionType, "sowt", 4)) {
+    extraData->sampleFormat = _getAiffIntegerFormat(extraData->bitsPerSample);
+    extraData->isLittleEndian = true;
+  }
+  else if(!strncmp(compressionType, "fl32", 4) || !strncmp(compressionType, "FL32", 4)) {
+    extraData->sampleFormat = PCM_SAMPLE_FORMAT_FLOAT32;
+  }
+  else if(!strncmp(compressionType, "fl64", 4) || !strncmp(compressionType, "FL64", 4)) {
+    extraData->sampleFormat = PCM_SAMPLE_FORMAT_FLOAT64;
+  }
+  else {
+    logUnsupportedFeature("Compressed AIFF files");
+    return false;
+  }
+
+  if(extraData->sampleFormat == PCM_SAMPLE_FORMAT_NUM_FORMATS) {
+    logError("AIFF files with %d-bit samples are not supported", extraData->bitsPerSample);
+    return false;
+  }
+  // Samples are read as whole bytes, even if only some of the bits are used
+  extraData->bitsPerSample = (unsigned short)(pcmSampleFormatGetBytesPerSample(extraData->sampleFormat) * 8);
+  logDebug("AIFF file has %s %s-endian samples", pcmSampleFormatGetName(extraData->sampleFormat),
+    extraData->isLittleEndian ? "little" : "big");
+  return true;
+}
+
+// IFF chunks are padded to an even size
+static boolByte _skipAiffChunk(FILE* fileHandle, const RiffChunk chunk) {
+  return (boolByte)(fseek(fileHandle, (long)(chunk->size + (chunk->size & 1)), SEEK_CUR) == 0);
+}
+
+static boolByte _readAiffFileInfo(const char* filename, SampleSourcePcmData extraData, unsigned long* outNumFrames) {
+  RiffChunk chunk = newRiffChunk();
+  byte formType[4];
+  byte ssndHeader[AIFF_SSND_HEADER_SIZE];
+  boolByte isAifc;
+  boolByte hasCommonChunk = false;
+  unsigned long long dataSize = 0;
+  unsigned long frameSize;
+  boolByte result = false;
+
+  extraData->dataOffset = -1;
+  if(!riffChunkReadNextBigEndian(chunk, extraData->fileHandle, false) || !riffChunkIsIdEqualTo(chunk, "FORM") ||
+    fread(formType, 1, 4, extraData->fileHandle) != 4) {
+    logFileError(filename, "Invalid FORM chunk descriptor");
+    freeRiffChunk(chunk);
+    return false;
+  }
+  if(!strncmp((char*)formType, "AIFC", 4)) {
+    isAifc = true;
+  }
+  else if(!strncmp((char*)formType, "AIFF", 4)) {
+    isAifc = false;
+  }
+  else {
+    logFileError(filename, "Invalid format description");
+    freeRiffChunk(chunk);
+    return false;
+  }
+
+  // The COMM and SSND chunks may come in any order, along with other chunks
+  // which are skipped. The sample data itself is not read here, so only the
+  // position of the SSND chunk is remembered.
+  while((!hasCommonChunk || extraData->dataOffset < 0) &&
+    riffChunkReadNextBigEndian(chunk, extraData->fileHandle, false)) {
+    if(riffChunkIsIdEqualTo(chunk, "COMM")) {
+      chunk->data = (byte*)malloc((size_t)(chunk->size + (chunk->size & 1)));
+      if(fread(chunk->data, 1, (size_t)(chunk->size + (chunk->size & 1)), extraData->fileHandle) !=
+        chunk->size + (chunk->size & 1)) {
+        logFileError(filename, "Could not read COMM chunk");
+        break;
+      }
+      if(!_readAiffCommonChunk(filename, chunk, isAifc, extraData, outNumFrames)) {
+        break;
+      }
+      free(chunk->data);
+      chunk->data = NULL;
+      hasCommonChunk = true;
+    }
+    else if(riffChunkIsIdEqualTo(chunk, "SSND")) {
+      if(chunk->size < AIFF_SSND_HEADER_SIZE || fread(ssndHeader, 1, AIFF_SSND_HEADER_SIZE, extraData->fileHandle) !=
+        AIFF_SSND_HEADER_SIZE || _getBigEndianInt(ssndHeader) > chunk->size - AIFF_SSND_HEADER_SIZE) {
+        logFileError(filename, "Invalid SSND chunk");
+        break;
+      }
+      // Sample data starts after the given number of unused bytes
+      extraData->dataOffset = ftell(extraData->fileHandle) + (long)_getBigEndianInt(ssndHeader);
+      dataSize = chunk->size - AIFF_SSND_HEADER_SIZE - _getBigEndianInt(ssndHeader);
+      chunk->size -= AIFF_SSND_HEADER_SIZE;
+      if(!hasCommonChunk && !_skipAiffChunk(extraData->fileHandle, chunk)) {
+        break;
+      }
+    }
+    else {
+      logDebug("Skipping AIFF chunk '%s' of %llu bytes", chunk->id, chunk->size);
+      if(!_skipAiffChunk(extraData->fileHandle, chunk)) {
+        break;
+      }
+    }
+  }
+
+  if(!hasCommonChunk) {
+    logFileError(filename, "AIFF file has no COMM chunk");
+  }
+  else if(extraData->dataOffset < 0) {
+    logFileError(filename, "AIFF file has no SSND chunk");
+  }
+  else if(fseek(extraData->fileHandle, extraData->dataOffset, SEEK_SET) != 0) {
+    logFileError(filename, "Could not seek to sample data");
+  }
+  else {
+    // Trust the data size over the frame count in the header if they disagree
+    frameSize = (unsigned long)extraData->numChannels * extraData->bitsPerSample / 8;
+    if(frameSize > 0 && *outNumFrames > dataSize / frameSize) {
+      logWarn("AIFF file has %lu frames, but only %llu frames of data", *outNumFrames, dataSize / frameSize);
+      *outNumFrames = (unsigned long)(dataSize / frameSize);
+    }
+    logDebug("AIFF file has %lu frames", *outNumFrames);
+    result = true;
+  }
+
+  freeRiffChunk(chunk);
+  return result;
+}
+
+static boolByte _writeAiffFileInfo(SampleSourcePcmData extraData) {
+  byte header[AIFF_MAX_HEADER_SIZE];
+  unsigned int headerSize = 0;
+  const boolByte isAifc = pcmSampleFormatIsFloat(extraData->sampleFormat);
+
+  // The FORM and SSND sizes and the number of frames will need to be set again
+  // when the file is finished writing. Integer samples are written as plain
+  // AIFF, which is the most widely supported, and float samples need AIFC.
+  memset(header, 0, sizeof(header));
+  memcpy(header, "FORM", 4);
+  memcpy(header + 8, isAifc ? "AIFC" : "AIFF", 4);
+  headerSize = 12;
+
+  if(isAifc) {
+    memcpy(header + headerSize, "FVER", 4);
+    _setBigEndianInt(header + headerSize + 4, 4);
+    _setBigEndianInt(header + headerSize + 8, AIFC_VERSION_1);
+    headerSize += 12;
+  }
+
+  memcpy(header + headerSize, "COMM", 4);
+  _setBigEndianInt(header + headerSize + 4, isAifc ? AIFC_COMM_CHUNK_SIZE : AIFF_COMM_CHUNK_SIZE);
+  headerSize += 8;
+  _setBigEndianShort(header + headerSize, extraData->numChannels);
+  _setBigEndianShort(header + headerSize + 6, extraData->bitsPerSample);
+  _setAiffSampleRate(header + headerSize + 8, (double)extraData->sampleRate);
+  if(isAifc) {
+    // Followed by an empty compression name
+    memcpy(header + headerSize + AIFF_COMM_CHUNK_SIZE,
+      extraData->sampleFormat == PCM_SAMPLE_FORMAT_FLOAT64 ? "fl64" : "fl32", 4);
+    headerSize += AIFC_COMM_CHUNK_SIZE;
+  }
+  else {
+    headerSize += AIFF_COMM_CHUNK_SIZE;
+  }
+
+  // The SSND chunk has no unused bytes before the sample data
+  memcpy(header + headerSize, "SSND", 4);
+  headerSize += 8 + AIFF_SSND_HEADER_SIZE;
+
+  if(fwrite(header, 1, headerSize, extraData->fileHandle) != headerSize) {
+    logError("Could not write AIFF header");
+    return false;
+  }
+  extraData->dataOffset = (long)headerSize;
+  return true;
+}
+
+static boolByte _writeAiffHeaderInt(FILE* fileHandle, long offset, unsigned int value) {
+  byte bytes[4];
+  _setBigEndianInt(bytes, value);
+  return (boolByte)(fseek(fileHandle, offset, SEEK_SET) == 0 && fwrite(bytes, 1, 4, fileHandle) == 4);
+}
+
+static boolByte _finishAiffHeader(SampleSourcePcmData extraData, unsigned long long numBytesWritten,
+  unsigned long numFramesWritten) {
+  // The frame count directly follows the number of channels in the COMM chunk
+  const long commOffset = pcmSampleFormatIsFloat(extraData->sampleFormat) ? 24 : 12;
+  const unsigned long long formSize = (unsigned long long)extraData->dataOffset - 8 +
+    numBytesWritten + (numBytesWritten & 1);
+
+  if(formSize > 0xFFFFFFFFull) {
+    logError("AIFF files can't be larger than 4GB, use WAVE or Wave64 instead");
+    return false;
+  }
+  if(!_writeAiffHeaderInt(extraData->fileHandle, 4, (unsigned int)formSize) ||
+    !_writeAiffHeaderInt(extraData->fileHandle, commOffset + 8 + 2, (unsigned int)numFramesWritten) ||
+    !_writeAiffHeaderInt(extraData->fileHandle, extraData->dataOffset - AIFF_SSND_HEADER_SIZE - 4,
+      (unsigned int)(numBytesWritten + AIFF_SSND_HEADER_SIZE))) {
+    logError("Could not write AIFF file sizes during finalization");
+    return false;
+  }
+  return true;
+}
 
 static boolByte _openSampleSourceAiff(void *sampleSourcePtr, const SampleSourceOpenAs openAs) {
   SampleSource sampleSource = (SampleSource)sampleSourcePtr;
-#if HAVE_LIBAUDIOFILE
-  SampleSourceAudiofileData extraData = (SampleSourceAudiofileData)(sampleSource->extraData);
-#else
   SampleSourcePcmData extraData = (SampleSourcePcmData)(sampleSource->extraData);
-#endif
 
   if(openAs == SAMPLE_SOURCE_OPEN_READ) {
-#if HAVE_LIBAUDIOFILE
-    extraData->fileHandle = afOpenFile(sampleSource->sourceName->data, "r", NULL);
+    extraData->fileHandle = fopen(sampleSource->sourceName->data, "rb");
     if(extraData->fileHandle != NULL) {
-      setNumChannels(afGetVirtualChannels(extraData->fileHandle, AF_DEFAULT_TRACK));
-      setSampleRate((float)afGetRate(extraData->fileHandle, AF_DEFAULT_TRACK));
+      if(_readAiffFileInfo(sampleSource->sourceName->data, extraData, &sampleSource->lengthInFrames)) {
+        setNumChannels(extraData->numChannels);
+        setSampleRate(extraData->sampleRate);
+        // Only files in the host's byte order can be mapped, which includes
+        // little endian AIFC files on most machines
+        if(sampleSource->lengthInFrames > 0) {
+          sampleSourcePcmMapFile(extraData, sampleSource->sourceName, (size_t)sampleSource->lengthInFrames *
+            extraData->numChannels * pcmSampleFormatGetBytesPerSample(extraData->sampleFormat));
+        }
+      }
+      else {
+        fclose(extraData->fileHandle);
+        extraData->fileHandle = NULL;
+      }
     }
-#else
-    logUnsupportedFeature("Reading AIFF files");
-#endif
   }
   else if(openAs == SAMPLE_SOURCE_OPEN_WRITE) {
-#if HAVE_LIBAUDIOFILE
-    AFfilesetup outfileSetup = afNewFileSetup();
-    afInitFileFormat(outfileSetup, AF_FILE_AIFF);
-    afInitByteOrder(outfileSetup, AF_DEFAULT_TRACK, AF_BYTEORDER_BIGENDIAN);
-    afInitChannels(outfileSetup, AF_DEFAULT_TRACK, getNumChannels());
-    afInitRate(outfileSetup, AF_DEFAULT_TRACK, getSampleRate());
-    afInitSampleFormat(outfileSetup, AF_DEFAULT_TRACK, AF_SAMPFMT_TWOSCOMP, DEFAULT_BITRATE);
-    extraData->fileHandle = afOpenFile(sampleSource->sourceName->data, "w", outfileSetup);
-#else
-    logUnsupportedFeature("Writing AIFF files");
-#endif
+    extraData->fileHandle = fopen(sampleSource->sourceName->data, "wb");
+    if(extraData->fileHandle != NULL) {
+      extraData->isLittleEndian = false;
+      extraData->numChannels = (unsigned short)getNumChannels();
+      extraData->sampleRate = (unsigned int)getSampleRate();
+      extraData->sampleFormat = getOutputSampleFormat();
+      extraData->bitsPerSample = (unsigned short)(pcmSampleFormatGetBytesPerSample(extraData->sampleFormat) * 8);
+      if(_writeAiffFileInfo(extraData)) {
+        sampleSourcePcmStartWriteBehind(extraData);
+      }
+      else {
+        fclose(extraData->fileHandle);
+        extraData->fileHandle = NULL;
+      }
+    }
   }
   else {
     logInternalError("Invalid type for openAs in AIFF file");
@@ -80,7 +377,7 @@ static boolByte _openSampleSourceAiff(void *sampleSourcePtr, const SampleSourceO
   }
 
   if(extraData->fileHandle == NULL) {
-    logError("AIFF file '%s' could not be opened for '%s'",
+    logError("AIFF file '%s' could not be opened for %s",
       sampleSource->sourceName->data, openAs == SAMPLE_SOURCE_OPEN_READ ? "reading" : "writing");
     return false;
   }
@@ -98,6 +395,11 @@ static boolByte _readBlockFromAiffFile(void* sampleSourcePtr, SampleBuffer sampl
   return (boolByte)(originalBlocksize == sampleBuffer->blocksize);
 }
 
+static boolByte _seekAiffFile(void* sampleSourcePtr, unsigned long frame) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  return sampleSourcePcmSeek((SampleSourcePcmData)sampleSource->extraData, frame);
+}
+
 static boolByte _writeBlockToAiffFile(void* sampleSourcePtr, const SampleBuffer sampleBuffer) {
   SampleSource sampleSource = (SampleSource)sampleSourcePtr;
   SampleSourcePcmData extraData = (SampleSourcePcmData)(sampleSource->extraData);
@@ -106,51 +408,68 @@ static boolByte _writeBlockToAiffFile(void* sampleSourcePtr, const SampleBuffer
   return (boolByte)(samplesWritten == sampleBuffer->blocksize);
 }
 
-extern void _closeSampleSourceWave(void *pcmData);
+static void _closeSampleSourceAiff(void* sampleSourcePtr) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourcePcmData extraData = (SampleSourcePcmData)(sampleSource->extraData);
+  unsigned long long numBytesWritten;
+  static const byte kPadding = 0;
+
+  if(sampleSource->openedAs == SAMPLE_SOURCE_OPEN_WRITE && extraData->fileHandle != NULL) {
+    numBytesWritten = (unsigned long long)sampleSource->numSamplesProcessed * extraData->bitsPerSample / 8;
+    if(!sampleSourcePcmFinishWrite(extraData)) {
+      logError("Could not write all audio data to AIFF file");
+    }
+    // The SSND chunk must be padded to an even size, which is not counted in its size
+    if((numBytesWritten & 1) && fwrite(&kPadding, 1, 1, extraData->fileHandle) != 1) {
+      logError("Could not write padding during AIFF file finalization");
+    }
+    _finishAiffHeader(extraData, numBytesWritten, sampleSource->numSamplesProcessed / extraData->numChannels);
+    fclose(extraData->fileHandle);
+    extraData->fileHandle = NULL;
+  }
+  else if(sampleSource->openedAs == SAMPLE_SOURCE_OPEN_READ && extraData->fileHandle != NULL) {
+    sampleSourcePcmUnmapFile(extraData);
+    fclose(extraData->fileHandle);
+    extraData->fileHandle = NULL;
+  }
+}
 
 SampleSource _newSampleSourceAiff(const CharString sampleSourceName) {
   SampleSource sampleSource = (SampleSource)malloc(sizeof(SampleSourceMembers));
-#if HAVE_LIBAUDIOFILE
-  SampleSourceAudiofileData extraData = (SampleSourceAudiofileData)malloc(sizeof(SampleSourceAudiofileDataMembers));
-#else
   SampleSourcePcmData extraData = (SampleSourcePcmData)malloc(sizeof(SampleSourcePcmDataMembers));
-#endif
 
   sampleSource->sampleSourceType = SAMPLE_SOURCE_TYPE_AIFF;
   sampleSource->openedAs = SAMPLE_SOURCE_OPEN_NOT_OPENED;
   sampleSource->sourceName = newCharString();
   charStringCopy(sampleSource->sourceName, sampleSourceName);
   sampleSource->numSamplesProcessed = 0;
+  sampleSource->lengthInFrames = 0;
 
+  // AIFF files are always handled internally, since the samples only need
+  // their byte order swapped on the way to and from the sample buffer
   sampleSource->openSampleSource = _openSampleSourceAiff;
-#if HAVE_LIBAUDIOFILE
-  sampleSource->readSampleBlock = readBlockFromAudiofile;
-  sampleSource->writeSampleBlock = writeBlockToAudiofile;
-  sampleSource->closeSampleSource = closeSampleSourceAudiofile;
-  sampleSource->freeSampleSourceData = freeSampleSourceDataAudiofile;
-#else
   sampleSource->readSampleBlock = _readBlockFromAiffFile;
   sampleSource->writeSampleBlock = _writeBlockToAiffFile;
-  // The same function can be shared for both AIFF & WAVE here
-  sampleSource->closeSampleSource = _closeSampleSourceWave;
+  sampleSource->seekSampleSource = _seekAiffFile;
+  sampleSource->closeSampleSource = _closeSampleSourceAiff;
   sampleSource->freeSampleSourceData = freeSampleSourceDataPcm;
-#endif
 
-#if HAVE_LIBAUDIOFILE
-  extraData->fileHandle = NULL;
-  extraData->interlacedBuffer = NULL;
-  extraData->pcmBuffer = NULL;
-#else
   extraData->isStream = false;
   extraData->isLittleEndian = false;
   extraData->fileHandle = NULL;
+  extraData->dataOffset = 0;
   extraData->dataBufferNumItems = 0;
   extraData->interlacedPcmDataBuffer = NULL;
 
   extraData->numChannels = (unsigned short)getNumChannels();
   extraData->sampleRate = (unsigned int)getSampleRate();
   extraData->bitsPerSample = 16;
-#endif
+  extraData->sampleFormat = PCM_SAMPLE_FORMAT_INT16;
+  extraData->mappedFile = NULL;
+  extraData->mappedReadPosition = 0;
+  extraData->mappedDataEnd = 0;
+  extraData->asyncWriter = NULL;
+  extraData->isPreallocated = false;
 
   sampleSource->extraData = extraData;
 
@@ -25,43 +25,180 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
-#if HAVE_LIBFLAC
-
 #include <stdlib.h>
 
+#include "audio/AudioSettings.h"
+#include "base/PlatformUtilities.h"
 #include "io/SampleSourceFlac.h"
 #include "logging/EventLogger.h"
 
+// A few encoder threads easily keep up with the plugin chain, and each one
+// holds several frames of memory, so large machines don't start one per core
+#define FLAC_OUTPUT_MAX_THREADS 4
+
+static boolByte _openSampleSourceFlacForWriting(SampleSource sampleSource, SampleSourceFlacData extraData) {
+  unsigned int bitsPerSample;
+  unsigned int numThreads;
+
+  switch(getOutputSampleFormat()) {
+    case PCM_SAMPLE_FORMAT_INT16:
+      bitsPerSample = 16;
+      break;
+    case PCM_SAMPLE_FORMAT_INT24:
+      bitsPerSample = 24;
+      break;
+    default:
+      logWarn("FLAC only supports integer samples up to 24 bits, writing 24-bit output");
+      bitsPerSample = 24;
+      break;
+  }
+
+  // Leave one processor for the thread which runs the plugin chain
+  numThreads = getNumProcessors() - 1;
+  if(numThreads > FLAC_OUTPUT_MAX_THREADS) {
+    numThreads = FLAC_OUTPUT_MAX_THREADS;
+  }
+
+  extraData->fileHandle = fopen(sampleSource->sourceName->data, "wb");
+  if(extraData->fileHandle == NULL) {
+    logError("FLAC file '%s' could not be opened for writing", sampleSource->sourceName->data);
+    return false;
+  }
+  extraData->encoder = newFlacEncoder(extraData->fileHandle, (unsigned int)getSampleRate(), getNumChannels(),
+    bitsPerSample, getCompressionLevel(), numThreads);
+  if(extraData->encoder == NULL) {
+    fclose(extraData->fileHandle);
+    extraData->fileHandle = NULL;
+    return false;
+  }
+
+  sampleSource->openedAs = SAMPLE_SOURCE_OPEN_WRITE;
+  return true;
+}
+
 static boolByte _openSampleSourceFlac(void* sampleSourcePtr, const SampleSourceOpenAs openAs) {
-  logUnsupportedFeature("Flac file I/O");
-  return false;
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourceFlacData extraData = (SampleSourceFlacData)sampleSource->extraData;
+
+  if(openAs == SAMPLE_SOURCE_OPEN_WRITE) {
+    return _openSampleSourceFlacForWriting(sampleSource, extraData);
+  }
+  else if(openAs != SAMPLE_SOURCE_OPEN_READ) {
+    logInternalError("Invalid type for openAs in FLAC file");
+    return false;
+  }
+
+  extraData->fileHandle = fopen(sampleSource->sourceName->data, "rb");
+  if(extraData->fileHandle == NULL) {
+    logError("FLAC file '%s' could not be opened for reading", sampleSource->sourceName->data);
+    return false;
+  }
+  extraData->decoder = newFlacDecoder(extraData->fileHandle, sampleSource->sourceName->data);
+  if(extraData->decoder == NULL) {
+    fclose(extraData->fileHandle);
+    extraData->fileHandle = NULL;
+    return false;
+  }
+
+  setNumChannels(extraData->decoder->numChannels);
+  setSampleRate(extraData->decoder->sampleRate);
+  sampleSource->lengthInFrames = (unsigned long)extraData->decoder->totalSamples;
+  sampleSource->openedAs = SAMPLE_SOURCE_OPEN_READ;
+  return true;
 }
 
 static boolByte _readBlockFromFlacFile(void* sampleSourcePtr, SampleBuffer sampleBuffer) {
-  logUnsupportedFeature("Flac file I/O");
-  return false;
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourceFlacData extraData = (SampleSourceFlacData)sampleSource->extraData;
+  unsigned long originalBlocksize = sampleBuffer->blocksize;
+  unsigned long framesRead;
+
+  if(extraData->decoder == NULL) {
+    logCritical("Corrupt FLAC data structure");
+    return false;
+  }
+
+  framesRead = flacDecoderRead(extraData->decoder, sampleBuffer);
+  if(framesRead < originalBlocksize) {
+    logDebug("End of FLAC file reached");
+    // Set the blocksize of the sample buffer to be the number of frames read
+    sampleBuffer->blocksize = framesRead;
+  }
+  sampleSource->numSamplesProcessed += framesRead * sampleBuffer->numChannels;
+  return (boolByte)(originalBlocksize == sampleBuffer->blocksize);
 }
 
 static boolByte _writeBlockToFlacFile(void* sampleSourcePtr, const SampleBuffer sampleBuffer) {
-  logUnsupportedFeature("Flac file I/O");
-  return false;
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourceFlacData extraData = (SampleSourceFlacData)sampleSource->extraData;
+
+  if(extraData->encoder == NULL) {
+    logCritical("Corrupt FLAC data structure");
+    return false;
+  }
+  sampleSource->numSamplesProcessed += sampleBuffer->blocksize * extraData->encoder->numChannels;
+  return flacEncoderWrite(extraData->encoder, sampleBuffer);
+}
+
+static boolByte _seekFlacFile(void* sampleSourcePtr, unsigned long frame) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourceFlacData extraData = (SampleSourceFlacData)sampleSource->extraData;
+  if(extraData->decoder == NULL) {
+    return false;
+  }
+  return flacDecoderSeek(extraData->decoder, frame);
+}
+
+static void _closeSampleSourceFlac(void* sampleSourcePtr) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourceFlacData extraData = (SampleSourceFlacData)sampleSource->extraData;
+  freeFlacDecoder(extraData->decoder);
+  extraData->decoder = NULL;
+  if(extraData->encoder != NULL) {
+    if(!flacEncoderFinish(extraData->encoder)) {
+      logError("Could not finish writing FLAC file '%s'", sampleSource->sourceName->data);
+    }
+    freeFlacEncoder(extraData->encoder);
+    extraData->encoder = NULL;
+  }
+  if(extraData->fileHandle != NULL) {
+    fclose(extraData->fileHandle);
+    extraData->fileHandle = NULL;
+  }
 }
 
-static void _freeSampleSourceFlac(void* sampleSourceDataPtr) {
-  
+static void _freeSampleSourceDataFlac(void* sampleSourceDataPtr) {
+  SampleSourceFlacData extraData = (SampleSourceFlacData)sampleSourceDataPtr;
+  freeFlacDecoder(extraData->decoder);
+  freeFlacEncoder(extraData->encoder);
+  if(extraData->fileHandle != NULL) {
+    fclose(extraData->fileHandle);
+  }
+  free(extraData);
 }
 
 SampleSource newSampleSourceFlac(const CharString sampleSourceName) {
   SampleSource sampleSource = (SampleSource)malloc(sizeof(SampleSourceMembers));
-  
+  SampleSourceFlacData extraData = (SampleSourceFlacData)malloc(sizeof(SampleSourceFlacDataMembers));
+
   sampleSource->sampleSourceType = SAMPLE_SOURCE_TYPE_FLAC;
-  
+  sampleSource->openedAs = SAMPLE_SOURCE_OPEN_NOT_OPENED;
+  sampleSource->sourceName = newCharString();
+  charStringCopy(sampleSource->sourceName, sampleSourceName);
+  sampleSource->numSamplesProcessed = 0;
+  sampleSource->lengthInFrames = 0;
+
   sampleSource->openSampleSource = _openSampleSourceFlac;
   sampleSource->readSampleBlock = _readBlockFromFlacFile;
   sampleSource->writeSampleBlock = _writeBlockToFlacFile;
-  sampleSource->freeSampleSourceData = _freeSampleSourceFlac;
-  
+  sampleSource->seekSampleSource = _seekFlacFile;
+  sampleSource->closeSampleSource = _closeSampleSourceFlac;
+  sampleSource->freeSampleSourceData = _freeSampleSourceDataFlac;
+
+  extraData->fileHandle = NULL;
+  extraData->decoder = NULL;
+  extraData->encoder = NULL;
+  sampleSource->extraData = extraData;
+
   return sampleSource;
 }
-
-#endif
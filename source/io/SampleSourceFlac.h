@@ -25,14 +25,28 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
-#include "SampleSource.h"
-
 #ifndef MrsWatson_SampleSourceFlac_h
 #define MrsWatson_SampleSourceFlac_h
 
-#if HAVE_LIBFLAC
+#include <stdio.h>
+
+#include "io/FlacDecoder.h"
+#include "io/FlacEncoder.h"
+#include "io/SampleSource.h"
 
+typedef struct {
+  FILE* fileHandle;
+  FlacDecoder decoder;
+  FlacEncoder encoder;
+} SampleSourceFlacDataMembers;
+typedef SampleSourceFlacDataMembers* SampleSourceFlacData;
+
+/**
+ * Create a sample source for FLAC files, which are decoded with the internal
+ * FlacDecoder and encoded with the internal FlacEncoder.
+ * @param sampleSourceName File name
+ * @return Initialized sample source
+ */
 SampleSource newSampleSourceFlac(const CharString sampleSourceName);
 
 #endif
-#endif
@@ -25,6 +25,11 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#if LINUX
+// Needed for fallocate()
+#define _GNU_SOURCE 1
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +39,13 @@
 #include "io/SampleSourcePcm.h"
 #include "logging/EventLogger.h"
 
+#if LINUX
+#include <fcntl.h>
+#endif
+#if UNIX
+#include <unistd.h>
+#endif
+
 static boolByte openSampleSourcePcm(void* sampleSourcePtr, const SampleSourceOpenAs openAs) {
   SampleSource sampleSource = (SampleSource)sampleSourcePtr;
   SampleSourcePcmData extraData = (SampleSourcePcmData)(sampleSource->extraData);
@@ -58,6 +70,9 @@ static boolByte openSampleSourcePcm(void* sampleSourcePtr, const SampleSourceOpe
     else {
       extraData->fileHandle = fopen(sampleSource->sourceName->data, "wb");
     }
+    if(extraData->fileHandle != NULL) {
+      sampleSourcePcmStartWriteBehind(extraData);
+    }
   }
   else {
     logInternalError("Invalid type for openAs in PCM file");
@@ -70,11 +85,75 @@ static boolByte openSampleSourcePcm(void* sampleSourcePtr, const SampleSourceOpe
     return false;
   }
 
+  if(openAs == SAMPLE_SOURCE_OPEN_READ && !extraData->isStream) {
+    if(fseek(extraData->fileHandle, 0, SEEK_END) == 0) {
+      sampleSource->lengthInFrames = (unsigned long)ftell(extraData->fileHandle) /
+        (pcmSampleFormatGetBytesPerSample(extraData->sampleFormat) * extraData->numChannels);
+    }
+    rewind(extraData->fileHandle);
+    sampleSourcePcmMapFile(extraData, sampleSource->sourceName, 0);
+  }
+
   sampleSource->openedAs = openAs;
   return true;
 }
 
+// Make sure that the interlaced buffer can hold a full block of samples
+static void _sampleSourcePcmResizeBuffer(SampleSourcePcmData self, size_t numSamples) {
+  if(self->dataBufferNumItems < numSamples) {
+    self->dataBufferNumItems = numSamples;
+    self->interlacedPcmDataBuffer = (byte*)realloc(self->interlacedPcmDataBuffer,
+      pcmSampleFormatGetBytesPerSample(self->sampleFormat) * self->dataBufferNumItems);
+  }
+}
+
+// Float data in the native byte order needs no conversion, so mono files can
+// be read to and written from the sample buffer directly
+static boolByte _sampleSourcePcmIsDirectAccess(SampleSourcePcmData self, const SampleBuffer sampleBuffer) {
+  return (boolByte)(sampleBuffer->numChannels == 1 &&
+    self->sampleFormat == PCM_SAMPLE_FORMAT_FLOAT32 &&
+    self->isLittleEndian == isHostLittleEndian());
+}
+
+boolByte sampleSourcePcmMapFile(SampleSourcePcmData self, const CharString filename, size_t dataSize) {
+  if(self->isStream || self->isLittleEndian != isHostLittleEndian() || self->dataOffset < 0) {
+    return false;
+  }
+
+  sampleSourcePcmUnmapFile(self);
+  self->mappedFile = newMappedFile(filename);
+  if(self->mappedFile == NULL) {
+    logDebug("Reading '%s' with stdio", filename->data);
+    return false;
+  }
+  if((size_t)self->dataOffset > self->mappedFile->size) {
+    sampleSourcePcmUnmapFile(self);
+    return false;
+  }
+
+  self->mappedReadPosition = (size_t)self->dataOffset;
+  self->mappedDataEnd = self->mappedFile->size;
+  if(dataSize > 0 && dataSize < self->mappedFile->size - self->mappedReadPosition) {
+    self->mappedDataEnd = self->mappedReadPosition + dataSize;
+  }
+  logDebug("Mapped %lu bytes of sample data from '%s'",
+    (unsigned long)(self->mappedDataEnd - self->mappedReadPosition), filename->data);
+  return true;
+}
+
+void sampleSourcePcmUnmapFile(SampleSourcePcmData self) {
+  if(self->mappedFile != NULL) {
+    freeMappedFile(self->mappedFile);
+    self->mappedFile = NULL;
+  }
+  self->mappedReadPosition = 0;
+  self->mappedDataEnd = 0;
+}
+
 size_t sampleSourcePcmRead(SampleSourcePcmData self, SampleBuffer sampleBuffer) {
+  const size_t numSamplesToRead = (size_t)(sampleBuffer->numChannels * sampleBuffer->blocksize);
+  unsigned int bytesPerSample;
+  boolByte directAccess;
   size_t pcmSamplesRead = 0;
 
   if(self == NULL || self->fileHandle == NULL) {
@@ -82,26 +161,66 @@ size_t sampleSourcePcmRead(SampleSourcePcmData self, SampleBuffer sampleBuffer)
     return 0;
   }
 
-  if(self->dataBufferNumItems < (size_t)(sampleBuffer->numChannels * sampleBuffer->blocksize)) {
-    self->dataBufferNumItems = (size_t)(sampleBuffer->numChannels * sampleBuffer->blocksize);
-    self->interlacedPcmDataBuffer = (short*)realloc(self->interlacedPcmDataBuffer, sizeof(short) * self->dataBufferNumItems);
-  }
+  bytesPerSample = pcmSampleFormatGetBytesPerSample(self->sampleFormat);
+  directAccess = _sampleSourcePcmIsDirectAccess(self, sampleBuffer);
 
-  // Clear the PCM data buffer, or else the last block will have dirty samples in the end
-  memset(self->interlacedPcmDataBuffer, 0, sizeof(short) * self->dataBufferNumItems);
+  if(self->mappedFile != NULL) {
+    // Only take whole samples, and the conversion below reads from the mapped pages
+    pcmSamplesRead = (self->mappedDataEnd - self->mappedReadPosition) / bytesPerSample;
+    if(pcmSamplesRead > numSamplesToRead) {
+      pcmSamplesRead = numSamplesToRead;
+    }
+  }
+  else if(directAccess) {
+    pcmSamplesRead = fread(sampleBuffer->samples[0], sizeof(Sample), numSamplesToRead, self->fileHandle);
+  }
+  else {
+    // The buffer doesn't need to be cleared, since only whole frames which were
+    // actually read are converted
+    _sampleSourcePcmResizeBuffer(self, numSamplesToRead);
+    pcmSamplesRead = fread(self->interlacedPcmDataBuffer, bytesPerSample, numSamplesToRead, self->fileHandle);
+    if(self->isLittleEndian != isHostLittleEndian()) {
+      pcmFlipEndian(self->interlacedPcmDataBuffer, self->sampleFormat, pcmSamplesRead);
+    }
+  }
 
-  pcmSamplesRead = fread(self->interlacedPcmDataBuffer, sizeof(short), self->dataBufferNumItems, self->fileHandle);
-  if(pcmSamplesRead < self->dataBufferNumItems) {
+  if(pcmSamplesRead < numSamplesToRead) {
     logDebug("End of PCM file reached");
     // Set the blocksize of the sample buffer to be the number of frames read
     sampleBuffer->blocksize = pcmSamplesRead / sampleBuffer->numChannels;
   }
   logDebug("Read %d samples from PCM file", pcmSamplesRead);
 
-  sampleBufferCopyPcmSamples(sampleBuffer, self->interlacedPcmDataBuffer);
+  if(self->mappedFile != NULL) {
+    pcmDeinterleaveSamples(self->mappedFile->data + self->mappedReadPosition, self->sampleFormat,
+      sampleBuffer->samples, sampleBuffer->numChannels, sampleBuffer->blocksize);
+    self->mappedReadPosition += pcmSamplesRead * bytesPerSample;
+  }
+  else if(!directAccess) {
+    pcmDeinterleaveSamples(self->interlacedPcmDataBuffer, self->sampleFormat,
+      sampleBuffer->samples, sampleBuffer->numChannels, sampleBuffer->blocksize);
+  }
   return pcmSamplesRead;
 }
 
+boolByte sampleSourcePcmSeek(SampleSourcePcmData self, unsigned long frame) {
+  long offset = self->dataOffset + (long)(frame * self->numChannels * pcmSampleFormatGetBytesPerSample(self->sampleFormat));
+  if(self->isStream || self->fileHandle == NULL) {
+    return false;
+  }
+  if(self->mappedFile != NULL) {
+    // Like fseek, seeking past the end is allowed and the next read is empty
+    self->mappedReadPosition = (size_t)offset < self->mappedDataEnd ? (size_t)offset : self->mappedDataEnd;
+    return true;
+  }
+  return (boolByte)(fseek(self->fileHandle, offset, SEEK_SET) == 0);
+}
+
+static boolByte _seekPcmFile(void* sampleSourcePtr, unsigned long frame) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  return sampleSourcePcmSeek((SampleSourcePcmData)sampleSource->extraData, frame);
+}
+
 static boolByte readBlockFromPcmFile(void* sampleSourcePtr, SampleBuffer sampleBuffer) {
   SampleSource sampleSource = (SampleSource)sampleSourcePtr;
   SampleSourcePcmData extraData = (SampleSourcePcmData)(sampleSource->extraData);
@@ -111,25 +230,116 @@ static boolByte readBlockFromPcmFile(void* sampleSourcePtr, SampleBuffer sampleB
   return (boolByte)(originalBlocksize == sampleBuffer->blocksize);
 }
 
+boolByte sampleSourcePcmStartWriteBehind(SampleSourcePcmData self) {
+  if(!getUseWriteBehind() || self->fileHandle == NULL) {
+    return false;
+  }
+  if(self->asyncWriter == NULL) {
+    self->asyncWriter = newAsyncFileWriter(self->fileHandle,
+      ASYNC_FILE_WRITER_DEFAULT_BUFFER_SIZE, ASYNC_FILE_WRITER_DEFAULT_NUM_BUFFERS);
+    if(self->asyncWriter == NULL) {
+      logWarn("Could not start write-behind thread, writing output directly");
+      return false;
+    }
+  }
+  return true;
+}
+
+boolByte sampleSourcePcmPreallocate(SampleSourcePcmData self, unsigned long numFrames) {
+  unsigned long long numBytes;
+
+  if(self->isStream || self->fileHandle == NULL || numFrames == 0) {
+    return false;
+  }
+  numBytes = (unsigned long long)self->dataOffset +
+    (unsigned long long)numFrames * self->numChannels * pcmSampleFormatGetBytesPerSample(self->sampleFormat);
+
+#if LINUX
+  // Unlike posix_fallocate(), this fails on file systems which can't reserve
+  // space rather than writing zeroes to the whole file
+  if(fallocate(fileno(self->fileHandle), FALLOC_FL_KEEP_SIZE, 0, (off_t)numBytes) != 0) {
+    logDebug("Could not preallocate %llu bytes for output file", numBytes);
+    return false;
+  }
+  logDebug("Preallocated %llu bytes for output file", numBytes);
+  self->isPreallocated = true;
+  return true;
+#else
+  logDebug("Output file preallocation is not supported on this platform");
+  return false;
+#endif
+}
+
+boolByte sampleSourcePcmFinishWrite(SampleSourcePcmData self) {
+  boolByte result = true;
+
+  if(self->asyncWriter != NULL) {
+    result = asyncFileWriterFlush(self->asyncWriter);
+    logDebug("Wrote %llu bytes in %lu writes, processing waited for the disk %lu times",
+      self->asyncWriter->numBytesWritten, self->asyncWriter->numWrites, self->asyncWriter->producerStalls);
+    freeAsyncFileWriter(self->asyncWriter);
+    self->asyncWriter = NULL;
+  }
+
+#if UNIX
+  if(self->isPreallocated && self->fileHandle != NULL) {
+    // Reserved space past the end of the file stays allocated until the file
+    // is truncated
+    fflush(self->fileHandle);
+    if(ftruncate(fileno(self->fileHandle), (off_t)ftell(self->fileHandle)) != 0) {
+      logWarn("Could not release preallocated space in output file");
+    }
+  }
+#endif
+  self->isPreallocated = false;
+  return result;
+}
+
 size_t sampleSourcePcmWrite(SampleSourcePcmData self, const SampleBuffer sampleBuffer) {
   size_t pcmSamplesWritten = 0;
   size_t numSamplesToWrite = (size_t)(sampleBuffer->numChannels * sampleBuffer->blocksize);
+  byte* writeBuffer = NULL;
 
   if(self == NULL || self->fileHandle == NULL) {
     logCritical("Corrupt PCM data structure");
     return false;
   }
 
-  if(self->dataBufferNumItems < (size_t)(sampleBuffer->numChannels * sampleBuffer->blocksize)) {
-    self->dataBufferNumItems = (size_t)(sampleBuffer->numChannels * sampleBuffer->blocksize);
-    self->interlacedPcmDataBuffer = (short*)realloc(self->interlacedPcmDataBuffer, sizeof(short) * self->dataBufferNumItems);
+  if(self->asyncWriter != NULL) {
+    if(asyncFileWriterHasFailed(self->asyncWriter)) {
+      return 0;
+    }
+    writeBuffer = asyncFileWriterAcquire(self->asyncWriter,
+      numSamplesToWrite * pcmSampleFormatGetBytesPerSample(self->sampleFormat));
+    // Blocks which are larger than the writer's buffers are written directly,
+    // after everything before them
+    if(writeBuffer == NULL && !asyncFileWriterFlush(self->asyncWriter)) {
+      return 0;
+    }
   }
 
-  // Clear the PCM data buffer just to be safe
-  memset(self->interlacedPcmDataBuffer, 0, sizeof(short) * self->dataBufferNumItems);
-
-  sampleBufferGetPcmSamples(sampleBuffer, self->interlacedPcmDataBuffer, (boolByte)(self->isLittleEndian != isHostLittleEndian()));
-  pcmSamplesWritten = fwrite(self->interlacedPcmDataBuffer, sizeof(short), numSamplesToWrite, self->fileHandle);
+  if(writeBuffer != NULL) {
+    pcmInterleaveSamples(sampleBuffer->samples, sampleBuffer->numChannels, sampleBuffer->blocksize,
+      writeBuffer, self->sampleFormat);
+    if(self->isLittleEndian != isHostLittleEndian()) {
+      pcmFlipEndian(writeBuffer, self->sampleFormat, numSamplesToWrite);
+    }
+    asyncFileWriterCommit(self->asyncWriter, numSamplesToWrite * pcmSampleFormatGetBytesPerSample(self->sampleFormat));
+    pcmSamplesWritten = numSamplesToWrite;
+  }
+  else if(_sampleSourcePcmIsDirectAccess(self, sampleBuffer)) {
+    pcmSamplesWritten = fwrite(sampleBuffer->samples[0], sizeof(Sample), numSamplesToWrite, self->fileHandle);
+  }
+  else {
+    _sampleSourcePcmResizeBuffer(self, numSamplesToWrite);
+    pcmInterleaveSamples(sampleBuffer->samples, sampleBuffer->numChannels, sampleBuffer->blocksize,
+      self->interlacedPcmDataBuffer, self->sampleFormat);
+    if(self->isLittleEndian != isHostLittleEndian()) {
+      pcmFlipEndian(self->interlacedPcmDataBuffer, self->sampleFormat, numSamplesToWrite);
+    }
+    pcmSamplesWritten = fwrite(self->interlacedPcmDataBuffer, pcmSampleFormatGetBytesPerSample(self->sampleFormat),
+      numSamplesToWrite, self->fileHandle);
+  }
   if(pcmSamplesWritten < numSamplesToWrite) {
     logWarn("Short write to PCM file");
     return pcmSamplesWritten;
@@ -150,7 +360,9 @@ static boolByte writeBlockToPcmFile(void* sampleSourcePtr, const SampleBuffer sa
 static void _closeSampleSourcePcm(void* sampleSourcePtr) {
   SampleSource sampleSource = (SampleSource)sampleSourcePtr;
   SampleSourcePcmData extraData = (SampleSourcePcmData)sampleSource->extraData;
+  sampleSourcePcmUnmapFile(extraData);
   if(extraData->fileHandle != NULL) {
+    sampleSourcePcmFinishWrite(extraData);
     fclose(extraData->fileHandle);
   }
 }
@@ -169,6 +381,10 @@ void sampleSourcePcmSetNumChannels(void* sampleSourcePtr, int numChannels) {
 
 void freeSampleSourceDataPcm(void* sampleSourceDataPtr) {
   SampleSourcePcmData extraData = (SampleSourcePcmData)sampleSourceDataPtr;
+  sampleSourcePcmUnmapFile(extraData);
+  if(extraData->asyncWriter != NULL) {
+    freeAsyncFileWriter(extraData->asyncWriter);
+  }
   if(extraData->interlacedPcmDataBuffer != NULL) {
     free(extraData->interlacedPcmDataBuffer);
     extraData->interlacedPcmDataBuffer = NULL;
@@ -185,22 +401,31 @@ SampleSource _newSampleSourcePcm(const CharString sampleSourceName) {
   sampleSource->sourceName = newCharString();
   charStringCopy(sampleSource->sourceName, sampleSourceName);
   sampleSource->numSamplesProcessed = 0;
+  sampleSource->lengthInFrames = 0;
 
   sampleSource->openSampleSource = openSampleSourcePcm;
   sampleSource->readSampleBlock = readBlockFromPcmFile;
   sampleSource->writeSampleBlock = writeBlockToPcmFile;
+  sampleSource->seekSampleSource = _seekPcmFile;
   sampleSource->closeSampleSource = _closeSampleSourcePcm;
   sampleSource->freeSampleSourceData = freeSampleSourceDataPcm;
 
   extraData->isStream = false;
   extraData->isLittleEndian = true;
   extraData->fileHandle = NULL;
+  extraData->dataOffset = 0;
   extraData->dataBufferNumItems = 0;
   extraData->interlacedPcmDataBuffer = NULL;
 
   extraData->numChannels = (unsigned short)getNumChannels();
   extraData->sampleRate = (unsigned int)getSampleRate();
   extraData->bitsPerSample = 16;
+  extraData->sampleFormat = PCM_SAMPLE_FORMAT_INT16;
+  extraData->mappedFile = NULL;
+  extraData->mappedReadPosition = 0;
+  extraData->mappedDataEnd = 0;
+  extraData->asyncWriter = NULL;
+  extraData->isPreallocated = false;
   sampleSource->extraData = extraData;
 
   return sampleSource;
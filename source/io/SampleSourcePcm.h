@@ -30,18 +30,39 @@
 
 #include <stdio.h>
 
+#include "audio/PcmConversion.h"
+#include "base/MappedFile.h"
+#include "io/AsyncFileWriter.h"
 #include "io/SampleSource.h"
 
 typedef struct {
   boolByte isStream;
   boolByte isLittleEndian;
   FILE* fileHandle;
+  // Position of the first sample in the file, after any headers
+  long dataOffset;
+  // Size of the buffer, in samples of sampleFormat
   size_t dataBufferNumItems;
-  short* interlacedPcmDataBuffer;
+  byte* interlacedPcmDataBuffer;
 
   unsigned short numChannels;
   unsigned int sampleRate;
   unsigned short bitsPerSample;
+  // Format of the samples in the file, in the byte order given by isLittleEndian
+  PcmSampleFormat sampleFormat;
+
+  // Input file mapped into memory, or NULL when reading through fileHandle
+  MappedFile mappedFile;
+  // Byte positions of the next sample to read and the end of the sample data
+  // in the mapped file
+  size_t mappedReadPosition;
+  size_t mappedDataEnd;
+
+  // Writer thread for output files in write-behind mode, or NULL when writing
+  // directly to fileHandle
+  AsyncFileWriter asyncWriter;
+  // True if space for the output was reserved with sampleSourcePcmPreallocate()
+  boolByte isPreallocated;
 } SampleSourcePcmDataMembers;
 typedef SampleSourcePcmDataMembers *SampleSourcePcmData;
 
@@ -53,6 +74,25 @@ typedef SampleSourcePcmDataMembers *SampleSourcePcmData;
  */
 size_t sampleSourcePcmRead(SampleSourcePcmData self, SampleBuffer sampleBuffer);
 
+/**
+ * Map an input file into memory, so that blocks are converted directly from the
+ * mapped pages rather than being copied through the interlaced buffer. Streams
+ * and files which are not in the host byte order are left to use stdio. This
+ * must be called after dataOffset has been set.
+ * @param self
+ * @param filename Input file
+ * @param dataSize Size of the sample data in bytes, or 0 to read to the end of
+ * the file
+ * @return True if the file was mapped
+ */
+boolByte sampleSourcePcmMapFile(SampleSourcePcmData self, const CharString filename, size_t dataSize);
+
+/**
+ * Release the memory mapping of an input file, if there is one
+ * @param self
+ */
+void sampleSourcePcmUnmapFile(SampleSourcePcmData self);
+
 /**
  * Writes data from a sample buffer to a PCM output
  * @param self
@@ -61,6 +101,46 @@ size_t sampleSourcePcmRead(SampleSourcePcmData self, SampleBuffer sampleBuffer);
  */
 size_t sampleSourcePcmWrite(SampleSourcePcmData self, const SampleBuffer sampleBuffer);
 
+/**
+ * Start a writer thread for an output file if write-behind mode is enabled,
+ * see setUseWriteBehind().
+ * Blocks are then converted into the writer's buffers and written to disk on
+ * the writer thread. Streams are also written this way. This must be called
+ * after any header has been written.
+ * @param self
+ * @return True if write-behind is in use
+ */
+boolByte sampleSourcePcmStartWriteBehind(SampleSourcePcmData self);
+
+/**
+ * Reserve disk space for an output file, so that the file system doesn't need
+ * to allocate it as the file grows. The size of the file is not changed, and
+ * any space which is not used is released by sampleSourcePcmFinishWrite().
+ * Currently only supported on Linux.
+ * @param self
+ * @param numFrames Expected number of frames which will be written
+ * @return True if the space was reserved
+ */
+boolByte sampleSourcePcmPreallocate(SampleSourcePcmData self, unsigned long numFrames);
+
+/**
+ * Write all data which is still queued for an output file, and release any
+ * unused preallocated space. After this call, headers may be updated through
+ * fileHandle.
+ * @param self
+ * @return False if any data could not be written
+ */
+boolByte sampleSourcePcmFinishWrite(SampleSourcePcmData self);
+
+/**
+ * Move the read position of a PCM file to the given frame. Used by all sources
+ * which store uncompressed PCM data after the header.
+ * @param self
+ * @param frame Frame to read next, counted from the start of the data
+ * @return True on success, false if the file is a stream or could not be seeked
+ */
+boolByte sampleSourcePcmSeek(SampleSourcePcmData self, unsigned long frame);
+
 /**
  * Set the sample rate to be used for raw PCM file operations. This is most
  * relevant when writing a WAVE or a AIFF file, as the sample rate must be given
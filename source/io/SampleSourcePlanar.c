@@ -0,0 +1,393 @@
+//
+// SampleSourcePlanar.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/AudioSettings.h"
+#include "io/SampleSourcePcm.h"
+#include "io/SampleSourcePlanar.h"
+#include "logging/EventLogger.h"
+
+static const char kPlanarFileMagic[4] = {'M', 'W', 'P', 'F'};
+
+static unsigned int _flipIntEndian(unsigned int value) {
+  return (value << 24) | ((value << 8) & 0x00ff0000) | ((value >> 8) & 0x0000ff00) | (value >> 24);
+}
+
+static void _rewindPlanarFile(SampleSourcePlanarData self) {
+  self->blockDataOffset = PLANAR_FILE_HEADER_SIZE;
+  self->nextBlockOffset = PLANAR_FILE_HEADER_SIZE;
+  self->blockFrames = 0;
+  self->frameInBlock = 0;
+}
+
+// Copy bytes from the mapped file, or read them through stdio if the file
+// could not be mapped
+static boolByte _readPlanarBytes(SampleSourcePlanarData self, unsigned long long offset, void* out, size_t numBytes) {
+  if(offset + numBytes > self->fileSize) {
+    return false;
+  }
+  if(self->mappedFile != NULL) {
+    memcpy(out, self->mappedFile->data + offset, numBytes);
+    return true;
+  }
+  return (boolByte)(fseek(self->fileHandle, (long)offset, SEEK_SET) == 0 &&
+    fread(out, 1, numBytes, self->fileHandle) == numBytes);
+}
+
+/**
+ * Move the read position to the start of the next block
+ * @return False at the end of the file
+ */
+static boolByte _readNextPlanarBlock(SampleSourcePlanarData self) {
+  byte header[PLANAR_BLOCK_HEADER_SIZE];
+  unsigned int numFrames;
+  unsigned long long blockSize;
+
+  if(!_readPlanarBytes(self, self->nextBlockOffset, header, PLANAR_BLOCK_HEADER_SIZE)) {
+    return false;
+  }
+  memcpy(&numFrames, header, sizeof(numFrames));
+  blockSize = (unsigned long long)numFrames * self->numChannels * sizeof(Sample);
+  if(self->nextBlockOffset + PLANAR_BLOCK_HEADER_SIZE + blockSize > self->fileSize) {
+    logWarn("Planar float file is truncated, ignoring the last block");
+    return false;
+  }
+
+  self->blockDataOffset = self->nextBlockOffset + PLANAR_BLOCK_HEADER_SIZE;
+  self->nextBlockOffset = self->blockDataOffset + blockSize;
+  self->blockFrames = numFrames;
+  self->frameInBlock = 0;
+  return true;
+}
+
+static boolByte _readPlanarFileHeader(const char* filename, SampleSourcePlanarData self, unsigned long* outNumFrames) {
+  byte header[PLANAR_FILE_HEADER_SIZE];
+  unsigned int version;
+  unsigned long long headerNumFrames;
+
+  if(fread(header, 1, PLANAR_FILE_HEADER_SIZE, self->fileHandle) != PLANAR_FILE_HEADER_SIZE ||
+    memcmp(header, kPlanarFileMagic, sizeof(kPlanarFileMagic))) {
+    logFileError(filename, "Not a planar float file");
+    return false;
+  }
+  memcpy(&version, header + 4, sizeof(version));
+  if(version != PLANAR_FILE_VERSION) {
+    if(_flipIntEndian(version) == PLANAR_FILE_VERSION) {
+      logFileError(filename, "Planar float file was written on a machine with a different byte order");
+    }
+    else {
+      logFileError(filename, "Unsupported planar float file version");
+    }
+    return false;
+  }
+  memcpy(&self->numChannels, header + 8, sizeof(self->numChannels));
+  memcpy(&self->sampleRate, header + 12, sizeof(self->sampleRate));
+  memcpy(&headerNumFrames, header + 16, sizeof(headerNumFrames));
+  if(self->numChannels == 0) {
+    logFileError(filename, "Planar float file has no channels");
+    return false;
+  }
+
+  if(fseek(self->fileHandle, 0, SEEK_END) != 0) {
+    logFileError(filename, "Could not get file size");
+    return false;
+  }
+  self->fileSize = (unsigned long long)ftell(self->fileHandle);
+
+  // The block headers are tiny, so they are simply walked through to find the
+  // length. This also works for files which were never finished.
+  *outNumFrames = 0;
+  _rewindPlanarFile(self);
+  while(_readNextPlanarBlock(self)) {
+    *outNumFrames += self->blockFrames;
+  }
+  _rewindPlanarFile(self);
+  if(headerNumFrames != 0 && headerNumFrames != *outNumFrames) {
+    logWarn("Planar float file should have %llu frames, but has %lu", headerNumFrames, *outNumFrames);
+  }
+  logDebug("Planar float file has %lu frames", *outNumFrames);
+  return true;
+}
+
+static boolByte _openSampleSourcePlanar(void* sampleSourcePtr, const SampleSourceOpenAs openAs) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourcePlanarData extraData = (SampleSourcePlanarData)sampleSource->extraData;
+  byte header[PLANAR_FILE_HEADER_SIZE];
+  const unsigned int version = PLANAR_FILE_VERSION;
+
+  if(openAs == SAMPLE_SOURCE_OPEN_READ) {
+    extraData->fileHandle = fopen(sampleSource->sourceName->data, "rb");
+    if(extraData->fileHandle != NULL) {
+      if(_readPlanarFileHeader(sampleSource->sourceName->data, extraData, &sampleSource->lengthInFrames)) {
+        setNumChannels(extraData->numChannels);
+        setSampleRate(extraData->sampleRate);
+        extraData->mappedFile = newMappedFile(sampleSource->sourceName);
+        if(extraData->mappedFile != NULL && extraData->mappedFile->size != extraData->fileSize) {
+          freeMappedFile(extraData->mappedFile);
+          extraData->mappedFile = NULL;
+        }
+      }
+      else {
+        fclose(extraData->fileHandle);
+        extraData->fileHandle = NULL;
+      }
+    }
+  }
+  else if(openAs == SAMPLE_SOURCE_OPEN_WRITE) {
+    extraData->fileHandle = fopen(sampleSource->sourceName->data, "wb");
+    if(extraData->fileHandle != NULL) {
+      extraData->numChannels = (unsigned int)getNumChannels();
+      extraData->sampleRate = (unsigned int)getSampleRate();
+      // The number of frames is set when the file is closed
+      memset(header, 0, sizeof(header));
+      memcpy(header, kPlanarFileMagic, sizeof(kPlanarFileMagic));
+      memcpy(header + 4, &version, sizeof(version));
+      memcpy(header + 8, &extraData->numChannels, sizeof(extraData->numChannels));
+      memcpy(header + 12, &extraData->sampleRate, sizeof(extraData->sampleRate));
+      if(fwrite(header, 1, PLANAR_FILE_HEADER_SIZE, extraData->fileHandle) != PLANAR_FILE_HEADER_SIZE) {
+        logError("Could not write planar float file header");
+        fclose(extraData->fileHandle);
+        extraData->fileHandle = NULL;
+      }
+      else if(getUseWriteBehind()) {
+        extraData->asyncWriter = newAsyncFileWriter(extraData->fileHandle,
+          ASYNC_FILE_WRITER_DEFAULT_BUFFER_SIZE, ASYNC_FILE_WRITER_DEFAULT_NUM_BUFFERS);
+        if(extraData->asyncWriter == NULL) {
+          logWarn("Could not start write-behind thread, writing output directly");
+        }
+      }
+    }
+  }
+  else {
+    logInternalError("Invalid type for openAs in planar float file");
+    return false;
+  }
+
+  if(extraData->fileHandle == NULL) {
+    logError("Planar float file '%s' could not be opened for %s",
+      sampleSource->sourceName->data, openAs == SAMPLE_SOURCE_OPEN_READ ? "reading" : "writing");
+    return false;
+  }
+
+  sampleSource->openedAs = openAs;
+  return true;
+}
+
+static boolByte _readBlockFromPlanarFile(void* sampleSourcePtr, SampleBuffer sampleBuffer) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourcePlanarData extraData = (SampleSourcePlanarData)sampleSource->extraData;
+  const unsigned long originalBlocksize = sampleBuffer->blocksize;
+  unsigned long framesRead = 0;
+  unsigned long numFrames;
+  unsigned int channel;
+
+  // Blocks in the file may have a different size than the sample buffer, so
+  // each channel is copied from as many blocks as are needed
+  while(framesRead < originalBlocksize) {
+    if(extraData->frameInBlock >= extraData->blockFrames && !_readNextPlanarBlock(extraData)) {
+      break;
+    }
+    numFrames = extraData->blockFrames - extraData->frameInBlock;
+    if(numFrames > originalBlocksize - framesRead) {
+      numFrames = originalBlocksize - framesRead;
+    }
+    for(channel = 0; channel < sampleBuffer->numChannels; channel++) {
+      if(channel >= extraData->numChannels) {
+        memset(sampleBuffer->samples[channel] + framesRead, 0, numFrames * sizeof(Sample));
+      }
+      else if(!_readPlanarBytes(extraData, extraData->blockDataOffset +
+        ((unsigned long long)channel * extraData->blockFrames + extraData->frameInBlock) * sizeof(Sample),
+        sampleBuffer->samples[channel] + framesRead, numFrames * sizeof(Sample))) {
+        logError("Could not read from planar float file");
+        numFrames = 0;
+        break;
+      }
+    }
+    if(numFrames == 0) {
+      break;
+    }
+    extraData->frameInBlock += numFrames;
+    framesRead += numFrames;
+  }
+
+  if(framesRead < originalBlocksize) {
+    logDebug("End of planar float file reached");
+    sampleBuffer->blocksize = framesRead;
+  }
+  sampleSource->numSamplesProcessed += framesRead * sampleBuffer->numChannels;
+  return (boolByte)(originalBlocksize == sampleBuffer->blocksize);
+}
+
+static boolByte _seekPlanarFile(void* sampleSourcePtr, unsigned long frame) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourcePlanarData extraData = (SampleSourcePlanarData)sampleSource->extraData;
+
+  // Like fseek, seeking past the end is allowed and the next read is empty
+  _rewindPlanarFile(extraData);
+  while(_readNextPlanarBlock(extraData)) {
+    if(frame < extraData->blockFrames) {
+      extraData->frameInBlock = frame;
+      break;
+    }
+    frame -= extraData->blockFrames;
+    extraData->frameInBlock = extraData->blockFrames;
+  }
+  return true;
+}
+
+static boolByte _writeBlockToPlanarFile(void* sampleSourcePtr, const SampleBuffer sampleBuffer) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourcePlanarData extraData = (SampleSourcePlanarData)sampleSource->extraData;
+  const size_t channelSize = sampleBuffer->blocksize * sizeof(Sample);
+  const size_t blockSize = PLANAR_BLOCK_HEADER_SIZE + extraData->numChannels * channelSize;
+  byte header[PLANAR_BLOCK_HEADER_SIZE];
+  const unsigned int numFrames = (unsigned int)sampleBuffer->blocksize;
+  byte* writeBuffer = NULL;
+  unsigned int channel;
+
+  if(sampleBuffer->numChannels != extraData->numChannels) {
+    logError("Can't write %d channels to planar float file with %d channels",
+      sampleBuffer->numChannels, extraData->numChannels);
+    return false;
+  }
+
+  memset(header, 0, sizeof(header));
+  memcpy(header, &numFrames, sizeof(numFrames));
+
+  if(extraData->asyncWriter != NULL) {
+    if(asyncFileWriterHasFailed(extraData->asyncWriter)) {
+      return false;
+    }
+    writeBuffer = asyncFileWriterAcquire(extraData->asyncWriter, blockSize);
+    // Blocks which are larger than the writer's buffers are written directly
+    if(writeBuffer == NULL && !asyncFileWriterFlush(extraData->asyncWriter)) {
+      return false;
+    }
+  }
+
+  if(writeBuffer != NULL) {
+    memcpy(writeBuffer, header, PLANAR_BLOCK_HEADER_SIZE);
+    for(channel = 0; channel < extraData->numChannels; channel++) {
+      memcpy(writeBuffer + PLANAR_BLOCK_HEADER_SIZE + channel * channelSize, sampleBuffer->samples[channel], channelSize);
+    }
+    asyncFileWriterCommit(extraData->asyncWriter, blockSize);
+  }
+  else {
+    if(fwrite(header, 1, PLANAR_BLOCK_HEADER_SIZE, extraData->fileHandle) != PLANAR_BLOCK_HEADER_SIZE) {
+      logWarn("Short write to planar float file");
+      return false;
+    }
+    for(channel = 0; channel < extraData->numChannels; channel++) {
+      if(fwrite(sampleBuffer->samples[channel], 1, channelSize, extraData->fileHandle) != channelSize) {
+        logWarn("Short write to planar float file");
+        return false;
+      }
+    }
+  }
+
+  sampleSource->numSamplesProcessed += sampleBuffer->blocksize * sampleBuffer->numChannels;
+  return true;
+}
+
+static void _closeSampleSourcePlanar(void* sampleSourcePtr) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  SampleSourcePlanarData extraData = (SampleSourcePlanarData)sampleSource->extraData;
+  unsigned long long numFrames;
+
+  if(extraData->fileHandle == NULL) {
+    return;
+  }
+
+  if(sampleSource->openedAs == SAMPLE_SOURCE_OPEN_WRITE) {
+    if(extraData->asyncWriter != NULL) {
+      if(!asyncFileWriterFlush(extraData->asyncWriter)) {
+        logError("Could not write all audio data to planar float file");
+      }
+      logDebug("Wrote %llu bytes in %lu writes, processing waited for the disk %lu times",
+        extraData->asyncWriter->numBytesWritten, extraData->asyncWriter->numWrites,
+        extraData->asyncWriter->producerStalls);
+      freeAsyncFileWriter(extraData->asyncWriter);
+      extraData->asyncWriter = NULL;
+    }
+    numFrames = sampleSource->numSamplesProcessed / extraData->numChannels;
+    if(fseek(extraData->fileHandle, 16, SEEK_SET) != 0 ||
+      fwrite(&numFrames, sizeof(numFrames), 1, extraData->fileHandle) != 1) {
+      logError("Could not write planar float file length during finalization");
+    }
+  }
+  else if(extraData->mappedFile != NULL) {
+    freeMappedFile(extraData->mappedFile);
+    extraData->mappedFile = NULL;
+  }
+
+  fclose(extraData->fileHandle);
+  extraData->fileHandle = NULL;
+}
+
+static void _freeSampleSourceDataPlanar(void* sampleSourceDataPtr) {
+  SampleSourcePlanarData extraData = (SampleSourcePlanarData)sampleSourceDataPtr;
+  if(extraData->mappedFile != NULL) {
+    freeMappedFile(extraData->mappedFile);
+  }
+  if(extraData->asyncWriter != NULL) {
+    freeAsyncFileWriter(extraData->asyncWriter);
+  }
+  free(extraData);
+}
+
+SampleSource _newSampleSourcePlanar(const CharString sampleSourceName) {
+  SampleSource sampleSource = (SampleSource)malloc(sizeof(SampleSourceMembers));
+  SampleSourcePlanarData extraData = (SampleSourcePlanarData)malloc(sizeof(SampleSourcePlanarDataMembers));
+
+  sampleSource->sampleSourceType = SAMPLE_SOURCE_TYPE_PLANAR;
+  sampleSource->openedAs = SAMPLE_SOURCE_OPEN_NOT_OPENED;
+  sampleSource->sourceName = newCharString();
+  charStringCopy(sampleSource->sourceName, sampleSourceName);
+  sampleSource->numSamplesProcessed = 0;
+  sampleSource->lengthInFrames = 0;
+
+  sampleSource->openSampleSource = _openSampleSourcePlanar;
+  sampleSource->readSampleBlock = _readBlockFromPlanarFile;
+  sampleSource->writeSampleBlock = _writeBlockToPlanarFile;
+  sampleSource->seekSampleSource = _seekPlanarFile;
+  sampleSource->closeSampleSource = _closeSampleSourcePlanar;
+  sampleSource->freeSampleSourceData = _freeSampleSourceDataPlanar;
+
+  extraData->fileHandle = NULL;
+  extraData->mappedFile = NULL;
+  extraData->asyncWriter = NULL;
+  extraData->numChannels = (unsigned int)getNumChannels();
+  extraData->sampleRate = (unsigned int)getSampleRate();
+  extraData->fileSize = 0;
+  _rewindPlanarFile(extraData);
+
+  sampleSource->extraData = extraData;
+
+  return sampleSource;
+}
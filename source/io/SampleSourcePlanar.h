@@ -0,0 +1,77 @@
+//
+// SampleSourcePlanar.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_SampleSourcePlanar_h
+#define MrsWatson_SampleSourcePlanar_h
+
+#include <stdio.h>
+
+#include "base/MappedFile.h"
+#include "io/AsyncFileWriter.h"
+#include "io/SampleSource.h"
+
+// Planar float files store samples exactly as they are laid out in a
+// SampleBuffer, so that they can be passed between several runs of MrsWatson
+// without any conversion or loss of precision. All values are in the host's
+// byte order, so the files are meant as intermediate files on one machine.
+//
+// The file starts with a header of PLANAR_FILE_HEADER_SIZE bytes:
+//   0: "MWPF"
+//   4: Format version, 32-bit
+//   8: Number of channels, 32-bit
+//  12: Sample rate in Hertz, 32-bit
+//  16: Total number of frames, 64-bit, or 0 if the file was not finished
+//  24: Reserved
+// This is followed by one block for each sample buffer which was written:
+//   0: Number of frames in the block, 32-bit
+//   4: Reserved
+//  16: The float samples of each channel, one channel after the other
+#define PLANAR_FILE_HEADER_SIZE 32
+#define PLANAR_BLOCK_HEADER_SIZE 16
+#define PLANAR_FILE_VERSION 1
+
+typedef struct {
+  FILE* fileHandle;
+  // Input file mapped into memory, or NULL when reading through fileHandle
+  MappedFile mappedFile;
+  // Writer thread for output files in write-behind mode, or NULL
+  AsyncFileWriter asyncWriter;
+
+  unsigned int numChannels;
+  unsigned int sampleRate;
+
+  // Read position, given as the block which samples are currently taken from
+  // and the offset of the block after that
+  unsigned long long fileSize;
+  unsigned long long blockDataOffset;
+  unsigned long long nextBlockOffset;
+  unsigned long blockFrames;
+  unsigned long frameInBlock;
+} SampleSourcePlanarDataMembers;
+typedef SampleSourcePlanarDataMembers* SampleSourcePlanarData;
+
+#endif
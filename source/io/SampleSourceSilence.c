@@ -67,11 +67,13 @@ SampleSource _newSampleSourceSilence(void) {
   sampleSource->sourceName = newCharString();
   charStringCopyCString(sampleSource->sourceName, "(silence)");
   sampleSource->numSamplesProcessed = 0;
+  sampleSource->lengthInFrames = 0;
 
   sampleSource->openSampleSource = _openSampleSourceSilence;
   sampleSource->closeSampleSource = _closeSampleSourceSilence;
   sampleSource->readSampleBlock = _readBlockFromSilence;
   sampleSource->writeSampleBlock = _writeBlockToSilence;
+  sampleSource->seekSampleSource = NULL;
   sampleSource->freeSampleSourceData = _freeInputSourceDataSilence;
 
   return sampleSource;
@@ -40,243 +40,649 @@
 #include "io/SampleSourceAudiofile.h"
 #endif
 
-static boolByte _readWaveFileInfo(const char* filename, SampleSourcePcmData extraData) {
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+// Size of the format chunk for each kind of header, not counting the chunk ID
+// and size fields
+#define WAVE_FORMAT_CHUNK_SIZE_PCM 16
+#define WAVE_FORMAT_CHUNK_SIZE_FLOAT 18
+#define WAVE_FORMAT_CHUNK_SIZE_EXTENSIBLE 40
+// Contents of the ds64 chunk in RF64 files: 64-bit RIFF size, data size and
+// sample count, followed by the length of a table which is always empty here
+#define WAVE_DS64_CHUNK_SIZE 28
+// 32-bit sizes in RF64 files are set to this value, the actual sizes are in the
+// ds64 chunk. Streamed files also use it for sizes which are not known.
+#define WAVE_RF64_SIZE_PLACEHOLDER 0xFFFFFFFFu
+#define WAVE64_FACT_CHUNK_SIZE 8
+// Largest header which is written, that of a Wave64 file with an extensible
+// format chunk and a fact chunk. RIFF headers are smaller even with the space
+// reserved for a ds64 chunk.
+#define WAVE_MAX_HEADER_SIZE (WAVE64_CHUNK_HEADER_SIZE + WAVE64_GUID_SIZE + \
+  WAVE64_CHUNK_HEADER_SIZE + WAVE_FORMAT_CHUNK_SIZE_EXTENSIBLE + \
+  WAVE64_CHUNK_HEADER_SIZE + WAVE64_FACT_CHUNK_SIZE + WAVE64_CHUNK_HEADER_SIZE)
+
+// Sub-format GUID in WAVE_FORMAT_EXTENSIBLE headers, which follows the two
+// bytes holding the format tag
+static const byte kWaveSubFormatGuidSuffix[14] = {
+  0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+static void _setLittleEndianShort(byte* out, unsigned short value) {
+  out[0] = (byte)(value & 0xff);
+  out[1] = (byte)((value >> 8) & 0xff);
+}
+
+static void _setLittleEndianInt(byte* out, unsigned int value) {
+  out[0] = (byte)(value & 0xff);
+  out[1] = (byte)((value >> 8) & 0xff);
+  out[2] = (byte)((value >> 16) & 0xff);
+  out[3] = (byte)((value >> 24) & 0xff);
+}
+
+static void _setLittleEndianLongLong(byte* out, unsigned long long value) {
+  _setLittleEndianInt(out, (unsigned int)(value & 0xffffffff));
+  _setLittleEndianInt(out + 4, (unsigned int)(value >> 32));
+}
+
+static boolByte _isWave64(const SampleSource sampleSource) {
+  return (boolByte)(sampleSource->sampleSourceType == SAMPLE_SOURCE_TYPE_WAVE64);
+}
+
+// RIFF chunks are padded to an even number of bytes, and Wave64 chunks to a
+// multiple of 8 bytes
+static unsigned long long _getWaveChunkPadding(unsigned long long chunkSize, boolByte isWave64) {
+  if(isWave64) {
+    return (8 - (chunkSize & 7)) & 7;
+  }
+  return chunkSize & 1;
+}
+
+static boolByte _readWaveChunk(RiffChunk chunk, FILE* fileHandle, boolByte isWave64) {
+  return isWave64 ? riffChunkReadNextWave64(chunk, fileHandle, false) : riffChunkReadNext(chunk, fileHandle, false);
+}
+
+// Streams can't be seeked, so skipped data must be read instead
+static boolByte _skipWaveBytes(SampleSourcePcmData extraData, unsigned long long numBytes) {
+  byte buffer[4096];
+  size_t numBytesToRead;
+
+  if(!extraData->isStream) {
+    return (boolByte)(fseek(extraData->fileHandle, (long)numBytes, SEEK_CUR) == 0);
+  }
+  while(numBytes > 0) {
+    numBytesToRead = numBytes < sizeof(buffer) ? (size_t)numBytes : sizeof(buffer);
+    if(fread(buffer, 1, numBytesToRead, extraData->fileHandle) != numBytesToRead) {
+      return false;
+    }
+    numBytes -= numBytesToRead;
+  }
+  return true;
+}
+
+/**
+ * Skip chunks in a RIFF or Wave64 file until one with the given ID is found.
+ * The file position is then at the start of the chunk's data.
+ * @param extraData Source whose file is positioned at the start of a chunk header
+ * @param id Chunk ID to look for
+ * @param isWave64 True if the file has Wave64 chunk headers
+ * @param chunk Chunk which receives the ID and size of the found chunk
+ * @return True if the chunk was found
+ */
+static boolByte _findWaveChunk(SampleSourcePcmData extraData, const char* id, boolByte isWave64, RiffChunk chunk) {
+  while(_readWaveChunk(chunk, extraData->fileHandle, isWave64)) {
+    if(riffChunkIsIdEqualTo(chunk, id)) {
+      return true;
+    }
+    logDebug("Skipping WAVE chunk '%s' of %llu bytes", chunk->id, chunk->size);
+    if(!_skipWaveBytes(extraData, chunk->size + _getWaveChunkPadding(chunk->size, isWave64))) {
+      return false;
+    }
+  }
+  return false;
+}
+
+/**
+ * Read the contents of a chunk which was found with _findWaveChunk(), including
+ * any padding, into the chunk's data field
+ */
+static boolByte _readWaveChunkData(FILE* fileHandle, boolByte isWave64, RiffChunk chunk) {
+  const size_t numBytes = (size_t)(chunk->size + _getWaveChunkPadding(chunk->size, isWave64));
+  chunk->data = (byte*)malloc(numBytes);
+  return (boolByte)(fread(chunk->data, 1, numBytes, fileHandle) == numBytes);
+}
+
+static PcmSampleFormat _getWaveSampleFormat(unsigned int audioFormat, unsigned short bitsPerSample) {
+  if(audioFormat == WAVE_FORMAT_PCM) {
+    switch(bitsPerSample) {
+      case 16:
+        return PCM_SAMPLE_FORMAT_INT16;
+      case 24:
+        return PCM_SAMPLE_FORMAT_INT24;
+      case 32:
+        return PCM_SAMPLE_FORMAT_INT32;
+      default:
+        break;
+    }
+  }
+  else if(audioFormat == WAVE_FORMAT_IEEE_FLOAT) {
+    switch(bitsPerSample) {
+      case 32:
+        return PCM_SAMPLE_FORMAT_FLOAT32;
+      case 64:
+        return PCM_SAMPLE_FORMAT_FLOAT64;
+      default:
+        break;
+    }
+  }
+  return PCM_SAMPLE_FORMAT_NUM_FORMATS;
+}
+
+static boolByte _readWaveFormatChunk(const char* filename, const RiffChunk chunk, SampleSourcePcmData extraData) {
   int chunkOffset = 0;
-  RiffChunk chunk = newRiffChunk();
-  char format[4];
-  size_t itemsRead;
   unsigned int audioFormat;
   unsigned int byteRate;
   unsigned int expectedByteRate;
   unsigned int blockAlign;
   unsigned int expectedBlockAlign;
+  unsigned short validBitsPerSample;
 
-  if(riffChunkReadNext(chunk, extraData->fileHandle, false)) {
-    if(!riffChunkIsIdEqualTo(chunk, "RIFF")) {
-      logFileError(filename, "Invalid RIFF chunk descriptor");
-      freeRiffChunk(chunk);
-      return false;
-    }
+  if(chunk->size < WAVE_FORMAT_CHUNK_SIZE_PCM) {
+    logFileError(filename, "Format chunk is too small");
+    return false;
+  }
 
-    // The WAVE file format has two sub-chunks, with the size of both calculated in the size field. Before
-    // either of the subchunks, there are an extra 4 bytes which indicate the format type. We need to read
-    // that before either of the subchunks can be parsed.
-    itemsRead = fread(format, sizeof(byte), 4, extraData->fileHandle);
-    if(itemsRead != 4 || strncmp(format, "WAVE", 4)) {
-      logFileError(filename, "Invalid format description");
-      freeRiffChunk(chunk);
+  audioFormat = convertByteArrayToUnsignedShort(chunk->data + chunkOffset);
+  chunkOffset += 2;
+
+  extraData->numChannels = convertByteArrayToUnsignedShort(chunk->data + chunkOffset);
+  chunkOffset += 2;
+
+  extraData->sampleRate = convertByteArrayToUnsignedInt(chunk->data + chunkOffset);
+  chunkOffset += 4;
+
+  byteRate = convertByteArrayToUnsignedInt(chunk->data + chunkOffset);
+  chunkOffset += 4;
+
+  blockAlign = convertByteArrayToUnsignedShort(chunk->data + chunkOffset);
+  chunkOffset += 2;
+
+  extraData->bitsPerSample = convertByteArrayToUnsignedShort(chunk->data + chunkOffset);
+  chunkOffset += 2;
+
+  // Extensible headers store the actual format in the first two bytes of the
+  // sub-format GUID, after the extension size, valid bits and channel mask
+  if(audioFormat == WAVE_FORMAT_EXTENSIBLE) {
+    if(chunk->size < WAVE_FORMAT_CHUNK_SIZE_EXTENSIBLE) {
+      logFileError(filename, "Extensible format chunk is too small");
       return false;
     }
+    validBitsPerSample = convertByteArrayToUnsignedShort(chunk->data + chunkOffset + 2);
+    audioFormat = convertByteArrayToUnsignedShort(chunk->data + chunkOffset + 8);
+    if(validBitsPerSample != 0 && validBitsPerSample < extraData->bitsPerSample) {
+      logDebug("WAVE file has %d valid bits in %d-bit samples", validBitsPerSample, extraData->bitsPerSample);
+    }
   }
-  else {
-    logFileError(filename, "No chunks following descriptor");
-    freeRiffChunk(chunk);
+
+  if(audioFormat != WAVE_FORMAT_PCM && audioFormat != WAVE_FORMAT_IEEE_FLOAT) {
+    logUnsupportedFeature("Compressed WAVE files");
+    return false;
+  }
+  else if(audioFormat == WAVE_FORMAT_PCM && extraData->bitsPerSample < 16) {
+    logUnsupportedFeature("Bitrates lower than 16");
     return false;
   }
 
-  if(riffChunkReadNext(chunk, extraData->fileHandle, true)) {
-    if(!riffChunkIsIdEqualTo(chunk, "fmt ")) {
-      logError(filename, "Invalid format chunk header");
-      freeRiffChunk(chunk);
-      return false;
-    }
+  extraData->sampleFormat = _getWaveSampleFormat(audioFormat, extraData->bitsPerSample);
+  if(extraData->sampleFormat == PCM_SAMPLE_FORMAT_NUM_FORMATS) {
+    logError("WAVE files with %d-bit %s samples are not supported", extraData->bitsPerSample,
+      audioFormat == WAVE_FORMAT_IEEE_FLOAT ? "floating point" : "integer");
+    return false;
+  }
+  logDebug("WAVE file has %s samples", pcmSampleFormatGetName(extraData->sampleFormat));
 
-    audioFormat = convertByteArrayToUnsignedShort(chunk->data + chunkOffset);
-    chunkOffset += 2;
-    if(audioFormat != 1) {
-      logUnsupportedFeature("Compressed WAVE files");
-      freeRiffChunk(chunk);
-      return false;
-    }
+  expectedByteRate = extraData->sampleRate * extraData->numChannels * extraData->bitsPerSample / 8;
+  if(expectedByteRate != byteRate) {
+    logWarn("Possibly invalid bitrate %d, expected %d", byteRate, expectedByteRate);
+  }
 
-    extraData->numChannels = convertByteArrayToUnsignedShort(chunk->data + chunkOffset);
-    chunkOffset += 2;
-    setNumChannels(extraData->numChannels);
+  expectedBlockAlign = (unsigned int)(extraData->numChannels * extraData->bitsPerSample / 8);
+  if(expectedBlockAlign != blockAlign) {
+    logWarn("Possibly invalid block align %d, expected %d", blockAlign, expectedBlockAlign);
+  }
 
-    extraData->sampleRate = convertByteArrayToUnsignedInt(chunk->data + chunkOffset);
-    chunkOffset += 4;
-    setSampleRate(extraData->sampleRate);
+  return true;
+}
+
+
+/**
+ * Read the sizes from the ds64 chunk of an RF64 file, which must directly
+ * follow the RIFF header
+ * @return True if the chunk could be read
+ */
+static boolByte _readWaveDs64Chunk(const char* filename, FILE* fileHandle, unsigned long long* outDataSize) {
+  RiffChunk chunk = newRiffChunk();
+  boolByte result = false;
+
+  if(!riffChunkReadNext(chunk, fileHandle, false) || !riffChunkIsIdEqualTo(chunk, "ds64")) {
+    logFileError(filename, "RF64 file has no ds64 chunk");
+  }
+  else if(chunk->size < 24) {
+    logFileError(filename, "ds64 chunk is too small");
+  }
+  else if(!_readWaveChunkData(fileHandle, false, chunk)) {
+    logFileError(filename, "Could not read ds64 chunk");
+  }
+  else {
+    // The RIFF size comes first, and the sample count is only needed for compressed formats
+    *outDataSize = convertByteArrayToUnsignedLongLong(chunk->data + 8);
+    result = true;
+  }
 
-    byteRate = convertByteArrayToUnsignedInt(chunk->data + chunkOffset);
-    chunkOffset += 4;
+  freeRiffChunk(chunk);
+  return result;
+}
 
-    blockAlign = convertByteArrayToUnsignedShort(chunk->data + chunkOffset);
-    chunkOffset += 2;
+// Size of the data from the current position to the end of the file, or 0 if
+// it is not known because the file is a stream
+static unsigned long long _getWaveStreamDataSize(SampleSourcePcmData extraData) {
+  long endPosition;
 
-    extraData->bitsPerSample = convertByteArrayToUnsignedShort(chunk->data + chunkOffset);
-    if(extraData->bitsPerSample > 16) {
-      logUnsupportedFeature("Bitrates greater than 16");
+  if(extraData->isStream || fseek(extraData->fileHandle, 0, SEEK_END) != 0) {
+    return 0;
+  }
+  endPosition = ftell(extraData->fileHandle);
+  if(fseek(extraData->fileHandle, extraData->dataOffset, SEEK_SET) != 0 || endPosition < extraData->dataOffset) {
+    return 0;
+  }
+  return (unsigned long long)(endPosition - extraData->dataOffset);
+}
+
+static boolByte _readWaveFileInfo(const char* filename, boolByte isWave64, SampleSourcePcmData extraData,
+  unsigned long* outNumFrames) {
+  RiffChunk chunk = newRiffChunk();
+  byte format[WAVE64_GUID_SIZE];
+  byte waveGuid[WAVE64_GUID_SIZE];
+  const size_t formatSize = isWave64 ? WAVE64_GUID_SIZE : 4;
+  boolByte isRf64 = false;
+  unsigned long long dataSize;
+  unsigned long frameSize;
+  boolByte result;
+
+  riffChunkGetWave64Guid("wave", waveGuid);
+  if(_readWaveChunk(chunk, extraData->fileHandle, isWave64)) {
+    isRf64 = (boolByte)(!isWave64 && riffChunkIsIdEqualTo(chunk, "RF64"));
+    if(!riffChunkIsIdEqualTo(chunk, isWave64 ? "riff" : "RIFF") && !isRf64) {
+      logFileError(filename, "Invalid RIFF chunk descriptor");
       freeRiffChunk(chunk);
       return false;
     }
-    else if(extraData->bitsPerSample < 16) {
-      logUnsupportedFeature("Bitrates lower than 16");
+
+    // The WAVE file format has two sub-chunks, with the size of both calculated in the size field. Before
+    // either of the subchunks, there are an extra 4 bytes which indicate the format type. We need to read
+    // that before either of the subchunks can be parsed. Wave64 files have a GUID here instead.
+    if(fread(format, sizeof(byte), formatSize, extraData->fileHandle) != formatSize ||
+      (isWave64 ? memcmp(format, waveGuid, WAVE64_GUID_SIZE) : strncmp((char*)format, "WAVE", 4))) {
+      logFileError(filename, "Invalid format description");
       freeRiffChunk(chunk);
       return false;
     }
+  }
+  else {
+    logFileError(filename, "No chunks following descriptor");
+    freeRiffChunk(chunk);
+    return false;
+  }
 
-    expectedByteRate = extraData->sampleRate * extraData->numChannels * extraData->bitsPerSample / 8;
-    if(expectedByteRate != byteRate) {
-      logWarn("Possibly invalid bitrate %d, expected %d", byteRate, expectedByteRate);
-    }
+  if(isRf64 && !_readWaveDs64Chunk(filename, extraData->fileHandle, &dataSize)) {
+    freeRiffChunk(chunk);
+    return false;
+  }
 
-    expectedBlockAlign = (unsigned int)(extraData->numChannels * extraData->bitsPerSample / 8);
-    if(expectedBlockAlign != blockAlign) {
-      logWarn("Possibly invalid block align %d, expected %d", blockAlign, expectedBlockAlign);
-    }
+  // Other chunks (such as LIST or bext) may come before the format chunk
+  if(!_findWaveChunk(extraData, "fmt ", isWave64, chunk) || chunk->size == 0) {
+    logFileError(filename, "WAVE file has no format chunk");
+    freeRiffChunk(chunk);
+    return false;
   }
-  else {
-    logFileError(filename, "WAVE file has no chunks following format");
+  if(!_readWaveChunkData(extraData->fileHandle, isWave64, chunk)) {
+    logFileError(filename, "Could not read format chunk");
     freeRiffChunk(chunk);
     return false;
   }
+  result = _readWaveFormatChunk(filename, chunk, extraData);
 
   // We don't need the format data anymore, so free and re-alloc the chunk to avoid a small memory leak
   freeRiffChunk(chunk);
+  if(!result) {
+    return false;
+  }
   chunk = newRiffChunk();
 
-  if(riffChunkReadNext(chunk, extraData->fileHandle, false)) {
-    if(!riffChunkIsIdEqualTo(chunk, "data")) {
-      logFileError(filename, "WAVE file has invalid data chunk header");
-      freeRiffChunk(chunk);
-      return false;
+  if(_findWaveChunk(extraData, "data", isWave64, chunk)) {
+    // RF64 files may also have the actual size in the data chunk if it is small enough
+    if(!isRf64 || chunk->size != WAVE_RF64_SIZE_PLACEHOLDER) {
+      dataSize = chunk->size;
     }
-
-    logDebug("WAVE file has %d bytes", chunk->size);
+    // Sample data follows the chunk header directly
+    extraData->dataOffset = extraData->isStream ? -1 : ftell(extraData->fileHandle);
+
+    // Files written to a stream don't know their final size, and have either 0
+    // or the largest 32-bit value as the data size. The data then continues to
+    // the end of the file.
+    if(dataSize == 0 || (!isWave64 && dataSize == WAVE_RF64_SIZE_PLACEHOLDER)) {
+      dataSize = _getWaveStreamDataSize(extraData);
+      logDebug("WAVE file has no data size, reading until end of file");
+    }
+    else {
+      logDebug("WAVE file has %llu bytes", dataSize);
+    }
+    frameSize = (unsigned long)extraData->numChannels * extraData->bitsPerSample / 8;
+    *outNumFrames = frameSize > 0 ? (unsigned long)(dataSize / frameSize) : 0;
+  }
+  else {
+    logFileError(filename, "WAVE file has no data chunk");
+    freeRiffChunk(chunk);
+    return false;
   }
 
   freeRiffChunk(chunk);
   return true;
 }
 
-static boolByte _writeWaveFileInfo(SampleSourcePcmData extraData) {
-  RiffChunk chunk = newRiffChunk();
-  unsigned short audioFormat = 1;
-  unsigned int byteRate = extraData->sampleRate * extraData->numChannels * extraData->bitsPerSample / 8;
-  unsigned short blockAlign = (unsigned short)(extraData->numChannels * extraData->bitsPerSample / 8);
-  unsigned int extraParams = 0;
-
-  memcpy(chunk->id, "RIFF", 4);
-  if(fwrite(chunk->id, sizeof(byte), 4, extraData->fileHandle) != 4) {
-    logError("Could not write RIFF header");
-    freeRiffChunk(chunk);
-    return false;
+// Speaker positions for common channel layouts, or simply the first speakers
+// in order for any others
+static unsigned int _getWaveChannelMask(unsigned short numChannels) {
+  switch(numChannels) {
+    case 1:
+      return 0x4; // Front center
+    case 2:
+      return 0x3; // Front left and right
+    case 6:
+      return 0x3F; // 5.1
+    case 8:
+      return 0x63F; // 7.1
+    default:
+      return numChannels <= 18 ? (1u << numChannels) - 1 : 0;
   }
+}
 
-  // Write the size, but this will need to be set again when the file is finished writing
-  if(fwrite(&(chunk->size), sizeof(unsigned int), 1, extraData->fileHandle) != 1) {
-    logError("Could not write RIFF chunk size");
-    freeRiffChunk(chunk);
-    return false;
+// Write the ID and size of a chunk header, and return the size of the header
+static unsigned int _setWaveChunkHeader(byte* out, const char* id, unsigned long long size, boolByte isWave64) {
+  if(isWave64) {
+    riffChunkGetWave64Guid(id, out);
+    _setLittleEndianLongLong(out + WAVE64_GUID_SIZE, size + WAVE64_CHUNK_HEADER_SIZE);
+    return WAVE64_CHUNK_HEADER_SIZE;
   }
+  memcpy(out, id, 4);
+  _setLittleEndianInt(out + 4, (unsigned int)size);
+  return 8;
+}
 
-  memcpy(chunk->id, "WAVE", 4);
-  if(fwrite(chunk->id, sizeof(byte), 4, extraData->fileHandle) != 4) {
-    logError("Could not WAVE format");
-    freeRiffChunk(chunk);
-    return false;
+static boolByte _writeWaveFileInfo(SampleSourcePcmData extraData, boolByte isWave64) {
+  byte header[WAVE_MAX_HEADER_SIZE];
+  unsigned int headerSize = 0;
+  const boolByte isFloat = pcmSampleFormatIsFloat(extraData->sampleFormat);
+  // Extensible headers should be used for anything other than plain mono or
+  // stereo files, otherwise some readers will get the format wrong
+  const boolByte isExtensible = (boolByte)(extraData->numChannels > 2 || (!isFloat && extraData->bitsPerSample > 16));
+  const unsigned short audioFormat = isFloat ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+  const unsigned int byteRate = extraData->sampleRate * extraData->numChannels * extraData->bitsPerSample / 8;
+  const unsigned short blockAlign = (unsigned short)(extraData->numChannels * extraData->bitsPerSample / 8);
+  unsigned int formatChunkSize = WAVE_FORMAT_CHUNK_SIZE_PCM;
+
+  if(isExtensible) {
+    formatChunkSize = WAVE_FORMAT_CHUNK_SIZE_EXTENSIBLE;
+  }
+  else if(isFloat) {
+    formatChunkSize = WAVE_FORMAT_CHUNK_SIZE_FLOAT;
   }
 
-  // Write the format header
-  memcpy(chunk->id, "fmt ", 4);
-  chunk->size = 20;
-  if(fwrite(chunk->id, sizeof(byte), 4, extraData->fileHandle) != 4) {
-    logError("Could not write format header");
-    freeRiffChunk(chunk);
-    return false;
+  // The RIFF and data sizes will need to be set again when the file is finished writing.
+  // This isn't possible for streams, which use placeholder sizes that tell readers
+  // to continue until the end of the data instead. Sizes of 0 are used for this in
+  // Wave64 headers.
+  memset(header, 0, sizeof(header));
+  if(isWave64) {
+    headerSize += _setWaveChunkHeader(header, "riff", 0, true);
+    riffChunkGetWave64Guid("wave", header + headerSize);
+    headerSize += WAVE64_GUID_SIZE;
+  }
+  else {
+    headerSize += _setWaveChunkHeader(header, "RIFF", extraData->isStream ? WAVE_RF64_SIZE_PLACEHOLDER : 0, false);
+    memcpy(header + headerSize, "WAVE", 4);
+    headerSize += 4;
+    // Reserve space for a ds64 chunk, which replaces this one if the file turns
+    // out to be too large for 32-bit sizes
+    headerSize += _setWaveChunkHeader(header + headerSize, "JUNK", WAVE_DS64_CHUNK_SIZE, false);
+    headerSize += WAVE_DS64_CHUNK_SIZE;
   }
 
-  if(fwrite(&(chunk->size), sizeof(unsigned int), 1, extraData->fileHandle) != 1) {
-    logError("Could not write format chunk size");
-    freeRiffChunk(chunk);
-    return false;
+  headerSize += _setWaveChunkHeader(header + headerSize, "fmt ", formatChunkSize, isWave64);
+  _setLittleEndianShort(header + headerSize, isExtensible ? (unsigned short)WAVE_FORMAT_EXTENSIBLE : audioFormat);
+  _setLittleEndianShort(header + headerSize + 2, extraData->numChannels);
+  _setLittleEndianInt(header + headerSize + 4, extraData->sampleRate);
+  _setLittleEndianInt(header + headerSize + 8, byteRate);
+  _setLittleEndianShort(header + headerSize + 12, blockAlign);
+  _setLittleEndianShort(header + headerSize + 14, extraData->bitsPerSample);
+  if(isExtensible) {
+    _setLittleEndianShort(header + headerSize + 16, WAVE_FORMAT_CHUNK_SIZE_EXTENSIBLE - WAVE_FORMAT_CHUNK_SIZE_FLOAT);
+    _setLittleEndianShort(header + headerSize + 18, extraData->bitsPerSample);
+    _setLittleEndianInt(header + headerSize + 20, _getWaveChannelMask(extraData->numChannels));
+    _setLittleEndianShort(header + headerSize + 24, audioFormat);
+    memcpy(header + headerSize + 26, kWaveSubFormatGuidSuffix, 14);
+  }
+  else if(isFloat) {
+    _setLittleEndianShort(header + headerSize + 16, 0);
+  }
+  headerSize += formatChunkSize + (unsigned int)_getWaveChunkPadding(formatChunkSize, isWave64);
+
+  // Formats other than integer PCM must also have the number of frames in a
+  // fact chunk, which is set when the file is finished writing. Wave64 files
+  // store a 64-bit count there.
+  if(isFloat) {
+    headerSize += _setWaveChunkHeader(header + headerSize, "fact", isWave64 ? WAVE64_FACT_CHUNK_SIZE : 4, isWave64);
+    headerSize += isWave64 ? WAVE64_FACT_CHUNK_SIZE : 4;
   }
 
-  // NOTE: These calls will not work on big-endian platforms
+  if(isFloat && extraData->isStream && !isWave64) {
+    _setLittleEndianInt(header + headerSize - 4, WAVE_RF64_SIZE_PLACEHOLDER);
+  }
 
-  if(fwrite(&audioFormat, sizeof(unsigned short), 1, extraData->fileHandle) != 1) {
-    logError("Could not write audio format");
-    freeRiffChunk(chunk);
+  headerSize += _setWaveChunkHeader(header + headerSize, "data",
+    extraData->isStream && !isWave64 ? WAVE_RF64_SIZE_PLACEHOLDER : 0, isWave64);
+
+  if(fwrite(header, 1, headerSize, extraData->fileHandle) != headerSize) {
+    logError("Could not write WAVE header");
     return false;
   }
-  if(fwrite(&(extraData->numChannels), sizeof(unsigned short), 1, extraData->fileHandle) != 1) {
-    logError("Could not write channel count");
-    freeRiffChunk(chunk);
-    return false;
+  extraData->dataOffset = (long)headerSize;
+  return true;
+}
+
+static boolByte _writeWaveHeaderBytes(FILE* fileHandle, long offset, const byte* data, size_t numBytes) {
+  return (boolByte)(fseek(fileHandle, offset, SEEK_SET) == 0 && fwrite(data, 1, numBytes, fileHandle) == numBytes);
+}
+
+/**
+ * Set the sizes in the header of a finished RIFF file. If the file is too large
+ * for 32-bit sizes, it is turned into an RF64 file by replacing the RIFF ID and
+ * the JUNK chunk which was reserved after it.
+ */
+static boolByte _finishRiffHeader(SampleSourcePcmData extraData, unsigned long long numBytesWritten,
+  unsigned long long numFramesWritten) {
+  const unsigned long long riffSize = (unsigned long long)(extraData->dataOffset - 8) +
+    numBytesWritten + (numBytesWritten & 1);
+  const boolByte isRf64 = (boolByte)(riffSize >= WAVE_RF64_SIZE_PLACEHOLDER);
+  byte sizeBytes[4];
+  byte ds64[8 + WAVE_DS64_CHUNK_SIZE];
+
+  if(isRf64) {
+    logInfo("WAVE file is larger than 4GB, writing it as RF64");
+    memcpy(ds64, "ds64", 4);
+    _setLittleEndianInt(ds64 + 4, WAVE_DS64_CHUNK_SIZE);
+    _setLittleEndianLongLong(ds64 + 8, riffSize);
+    _setLittleEndianLongLong(ds64 + 16, numBytesWritten);
+    _setLittleEndianLongLong(ds64 + 24, numFramesWritten);
+    _setLittleEndianInt(ds64 + 32, 0);
+    if(!_writeWaveHeaderBytes(extraData->fileHandle, 12, ds64, sizeof(ds64)) ||
+      !_writeWaveHeaderBytes(extraData->fileHandle, 0, (const byte*)"RF64", 4)) {
+      logError("Could not write ds64 chunk during WAVE file finalization");
+      return false;
+    }
   }
-  if(fwrite(&(extraData->sampleRate), sizeof(unsigned int), 1, extraData->fileHandle) != 1) {
-    logError("Could not write sample rate");
-    freeRiffChunk(chunk);
+
+  // The data chunk size is just before the first sample
+  _setLittleEndianInt(sizeBytes, isRf64 ? WAVE_RF64_SIZE_PLACEHOLDER : (unsigned int)numBytesWritten);
+  if(!_writeWaveHeaderBytes(extraData->fileHandle, extraData->dataOffset - 4, sizeBytes, 4)) {
+    logError("Could not write WAVE file size during finalization");
     return false;
   }
-  if(fwrite(&(byteRate), sizeof(unsigned int), 1, extraData->fileHandle) != 1) {
-    logError("Could not write byte rate");
-    freeRiffChunk(chunk);
-    return false;
+
+  // Float files also have a fact chunk just before the data chunk
+  if(pcmSampleFormatIsFloat(extraData->sampleFormat)) {
+    _setLittleEndianInt(sizeBytes, isRf64 ? WAVE_RF64_SIZE_PLACEHOLDER : (unsigned int)numFramesWritten);
+    if(!_writeWaveHeaderBytes(extraData->fileHandle, extraData->dataOffset - 12, sizeBytes, 4)) {
+      logError("Could not write WAVE file length in fact chunk during finalization");
+      return false;
+    }
   }
-  if(fwrite(&(blockAlign), sizeof(unsigned short), 1, extraData->fileHandle) != 1) {
-    logError("Could not write block align");
-    freeRiffChunk(chunk);
+
+  // The RIFF chunk size covers everything after the size field itself
+  _setLittleEndianInt(sizeBytes, isRf64 ? WAVE_RF64_SIZE_PLACEHOLDER : (unsigned int)riffSize);
+  if(!_writeWaveHeaderBytes(extraData->fileHandle, 4, sizeBytes, 4)) {
+    logError("Could not write WAVE file size in RIFF chunk during finalization");
     return false;
   }
-  if(fwrite(&(extraData->bitsPerSample), sizeof(unsigned short), 1, extraData->fileHandle) != 1) {
-    logError("Could not write bits per sample");
-    freeRiffChunk(chunk);
+  return true;
+}
+
+// Wave64 sizes are 64-bit and include the chunk headers
+static boolByte _finishWave64Header(SampleSourcePcmData extraData, unsigned long long numBytesWritten,
+  unsigned long long numFramesWritten) {
+  const unsigned long long padding = _getWaveChunkPadding(numBytesWritten, true);
+  byte sizeBytes[8];
+
+  _setLittleEndianLongLong(sizeBytes, numBytesWritten + WAVE64_CHUNK_HEADER_SIZE);
+  if(!_writeWaveHeaderBytes(extraData->fileHandle, extraData->dataOffset - 8, sizeBytes, 8)) {
+    logError("Could not write Wave64 data size during finalization");
     return false;
   }
-  if(fwrite(&(extraParams), sizeof(byte), 4, extraData->fileHandle) != 4) {
-    logError("Could not write extra PCM parameters");
-    freeRiffChunk(chunk);
+
+  if(pcmSampleFormatIsFloat(extraData->sampleFormat)) {
+    _setLittleEndianLongLong(sizeBytes, numFramesWritten);
+    if(!_writeWaveHeaderBytes(extraData->fileHandle,
+      extraData->dataOffset - WAVE64_CHUNK_HEADER_SIZE - WAVE64_FACT_CHUNK_SIZE, sizeBytes, 8)) {
+      logError("Could not write Wave64 length in fact chunk during finalization");
+      return false;
+    }
+  }
+
+  _setLittleEndianLongLong(sizeBytes, (unsigned long long)extraData->dataOffset + numBytesWritten + padding);
+  if(!_writeWaveHeaderBytes(extraData->fileHandle, WAVE64_GUID_SIZE, sizeBytes, 8)) {
+    logError("Could not write Wave64 file size during finalization");
     return false;
   }
+  return true;
+}
 
-  memcpy(chunk->id, "data", 4);
-  if(fwrite(chunk->id, sizeof(byte), 4, extraData->fileHandle) != 4) {
-    logError("Could not write format header");
-    freeRiffChunk(chunk);
+// Files which aren't seekable, such as named pipes, are handled like stdin and stdout
+static void _checkWaveFileIsStream(SampleSourcePcmData extraData) {
+  if(!extraData->isStream && ftell(extraData->fileHandle) < 0) {
+    logDebug("WAVE file is not seekable, handling it as a stream");
+    extraData->isStream = true;
+  }
+}
+
+// stdin and stdout are left open, as they may still be used elsewhere
+static void _closeWaveFileHandle(SampleSourcePcmData extraData) {
+  if(extraData->fileHandle == stdout) {
+    fflush(extraData->fileHandle);
+  }
+  else if(extraData->fileHandle != stdin) {
+    fclose(extraData->fileHandle);
+  }
+  extraData->fileHandle = NULL;
+}
+
+static boolByte _openWaveFile(SampleSource sampleSource, const SampleSourceOpenAs openAs) {
+  SampleSourcePcmData extraData = (SampleSourcePcmData)sampleSource->extraData;
+  const boolByte isWave64 = _isWave64(sampleSource);
+
+  if(openAs == SAMPLE_SOURCE_OPEN_READ) {
+    if(sampleSourceIsStdio(sampleSource->sourceName)) {
+      extraData->fileHandle = stdin;
+      extraData->isStream = true;
+    }
+    else {
+      extraData->fileHandle = fopen(sampleSource->sourceName->data, "rb");
+    }
+    if(extraData->fileHandle != NULL) {
+      _checkWaveFileIsStream(extraData);
+      if(_readWaveFileInfo(sampleSource->sourceName->data, isWave64, extraData, &sampleSource->lengthInFrames)) {
+        setNumChannels(extraData->numChannels);
+        setSampleRate(extraData->sampleRate);
+        if(sampleSource->lengthInFrames > 0) {
+          sampleSourcePcmMapFile(extraData, sampleSource->sourceName, (size_t)sampleSource->lengthInFrames *
+            extraData->numChannels * pcmSampleFormatGetBytesPerSample(extraData->sampleFormat));
+        }
+      }
+      else {
+        _closeWaveFileHandle(extraData);
+      }
+    }
+  }
+  else if(openAs == SAMPLE_SOURCE_OPEN_WRITE) {
+    if(sampleSourceIsStdio(sampleSource->sourceName)) {
+      extraData->fileHandle = stdout;
+      extraData->isStream = true;
+    }
+    else {
+      extraData->fileHandle = fopen(sampleSource->sourceName->data, "wb");
+    }
+    if(extraData->fileHandle != NULL) {
+      extraData->numChannels = (unsigned short)getNumChannels();
+      extraData->sampleRate = (unsigned int)getSampleRate();
+      extraData->sampleFormat = getOutputSampleFormat();
+      extraData->bitsPerSample = (unsigned short)(pcmSampleFormatGetBytesPerSample(extraData->sampleFormat) * 8);
+      _checkWaveFileIsStream(extraData);
+      if(_writeWaveFileInfo(extraData, isWave64)) {
+        sampleSourcePcmStartWriteBehind(extraData);
+      }
+      else {
+        _closeWaveFileHandle(extraData);
+      }
+    }
+  }
+  else {
+    logInternalError("Invalid type for openAs in WAVE file");
     return false;
   }
-  if(fwrite(&(chunk->size), sizeof(unsigned int), 1, extraData->fileHandle) != 1) {
-    logError("Could not write data chunk size");
-    freeRiffChunk(chunk);
+
+  if(extraData->fileHandle == NULL) {
+    logError("%s file '%s' could not be opened for %s", isWave64 ? "Wave64" : "WAVE",
+      sampleSource->sourceName->data, openAs == SAMPLE_SOURCE_OPEN_READ ? "reading" : "writing");
     return false;
   }
 
-  freeRiffChunk(chunk);
+  sampleSource->openedAs = openAs;
   return true;
 }
 
+#if HAVE_LIBAUDIOFILE
 static boolByte _openSampleSourceWave(void *sampleSourcePtr, const SampleSourceOpenAs openAs) {
   SampleSource sampleSource = (SampleSource)sampleSourcePtr;
-#if HAVE_LIBAUDIOFILE
   SampleSourceAudiofileData extraData = sampleSource->extraData;
-#else
-  SampleSourcePcmData extraData = (SampleSourcePcmData)sampleSource->extraData;
-#endif
 
   if(openAs == SAMPLE_SOURCE_OPEN_READ) {
-#if HAVE_LIBAUDIOFILE
     extraData->fileHandle = afOpenFile(sampleSource->sourceName->data, "r", NULL);
     if(extraData->fileHandle != NULL) {
       setNumChannels(afGetVirtualChannels(extraData->fileHandle, AF_DEFAULT_TRACK));
       setSampleRate((float)afGetRate(extraData->fileHandle, AF_DEFAULT_TRACK));
     }
-#else
-    extraData->fileHandle = fopen(sampleSource->sourceName->data, "rb");
-    if(extraData->fileHandle != NULL) {
-      if(_readWaveFileInfo(sampleSource->sourceName->data, extraData)) {
-        setNumChannels(extraData->numChannels);
-        setSampleRate(extraData->sampleRate);
-      }
-      else {
-        fclose(extraData->fileHandle);
-        extraData->fileHandle = NULL;
-      }
-    }
-#endif
   }
   else if(openAs == SAMPLE_SOURCE_OPEN_WRITE) {
-#if HAVE_LIBAUDIOFILE
     AFfilesetup outfileSetup = afNewFileSetup();
     afInitFileFormat(outfileSetup, AF_FILE_WAVE);
     afInitByteOrder(outfileSetup, AF_DEFAULT_TRACK, AF_BYTEORDER_LITTLEENDIAN);
@@ -284,18 +690,6 @@ static boolByte _openSampleSourceWave(void *sampleSourcePtr, const SampleSourceO
     afInitRate(outfileSetup, AF_DEFAULT_TRACK, getSampleRate());
     afInitSampleFormat(outfileSetup, AF_DEFAULT_TRACK, AF_SAMPFMT_TWOSCOMP, DEFAULT_BITRATE);
     extraData->fileHandle = afOpenFile(sampleSource->sourceName->data, "w", outfileSetup);
-#else
-    extraData->fileHandle = fopen(sampleSource->sourceName->data, "wb");
-    if(extraData->fileHandle != NULL) {
-      extraData->numChannels = (unsigned short)getNumChannels();
-      extraData->sampleRate = (unsigned int)getSampleRate();
-      extraData->bitsPerSample = 16;
-      if(!_writeWaveFileInfo(extraData)) {
-        fclose(extraData->fileHandle);
-        extraData->fileHandle = NULL;
-      }
-    }
-#endif
   }
   else {
     logInternalError("Invalid type for openAs in WAVE file");
@@ -311,6 +705,7 @@ static boolByte _openSampleSourceWave(void *sampleSourcePtr, const SampleSourceO
   sampleSource->openedAs = openAs;
   return true;
 }
+#endif
 
 static boolByte _readBlockFromWaveFile(void* sampleSourcePtr, SampleBuffer sampleBuffer) {
   SampleSource sampleSource = (SampleSource)sampleSourcePtr;
@@ -321,6 +716,11 @@ static boolByte _readBlockFromWaveFile(void* sampleSourcePtr, SampleBuffer sampl
   return (boolByte)(originalBlocksize == sampleBuffer->blocksize);
 }
 
+static boolByte _seekWaveFile(void* sampleSourcePtr, unsigned long frame) {
+  SampleSource sampleSource = (SampleSource)sampleSourcePtr;
+  return sampleSourcePcmSeek((SampleSourcePcmData)sampleSource->extraData, frame);
+}
+
 static boolByte _writeBlockToWaveFile(void* sampleSourcePtr, const SampleBuffer sampleBuffer) {
   SampleSource sampleSource = (SampleSource)sampleSourcePtr;
   SampleSourcePcmData extraData = (SampleSourcePcmData)sampleSource->extraData;
@@ -329,123 +729,133 @@ static boolByte _writeBlockToWaveFile(void* sampleSourcePtr, const SampleBuffer
   return (boolByte)(samplesWritten == sampleBuffer->blocksize);
 }
 
-void _closeSampleSourceWave(void *sampleSourceDataPtr) {
-#if ! HAVE_LIBAUDIOFILE
-  SampleSource sampleSource = (SampleSource)sampleSourceDataPtr;
+static void _closeWaveFile(SampleSource sampleSource) {
   SampleSourcePcmData extraData = (SampleSourcePcmData)sampleSource->extraData;
-  size_t numBytesWritten;
-  RiffChunk chunk;
+  const boolByte isWave64 = _isWave64(sampleSource);
+  unsigned long long numBytesWritten;
+  unsigned long long numFramesWritten;
+  unsigned long long padding;
+  static const byte kPadding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
 
   if(sampleSource->openedAs == SAMPLE_SOURCE_OPEN_WRITE) {
-    // Re-open the file for editing
-    fflush(extraData->fileHandle);
-    if(fclose(extraData->fileHandle) != 0) {
-      logError("Could not close WAVE file for finalization");
-      return;
-    }
-    extraData->fileHandle = fopen(sampleSource->sourceName->data, "rb+");
-    if(extraData->fileHandle == NULL) {
-      logError("Could not reopen WAVE file for finalization");
-      return;
+    numBytesWritten = (unsigned long long)sampleSource->numSamplesProcessed * extraData->bitsPerSample / 8;
+    numFramesWritten = (unsigned long long)sampleSource->numSamplesProcessed / extraData->numChannels;
+    if(!sampleSourcePcmFinishWrite(extraData)) {
+      logError("Could not write all audio data to WAVE file");
     }
 
-    // First go to the second chunk in the file and re-read the chunk length
-    if(fseek(extraData->fileHandle, 12, SEEK_SET) != 0) {
-      logError("Could not seek to second chunk during WAVE file finalization");
-      fclose(extraData->fileHandle);
-      return;
-    }
-    chunk = newRiffChunk();
-    if(!riffChunkReadNext(chunk, extraData->fileHandle, false)) {
-      logError("Could not read RIFF chunk during WAVE file finalization");
-      fclose(extraData->fileHandle);
-      freeRiffChunk(chunk);
+    // Streams are read until the end of the data, and can't be seeked to set
+    // the sizes in the header, so they are left as they are
+    if(extraData->isStream) {
+      _closeWaveFileHandle(extraData);
       return;
     }
 
-    // Go to the next chunk, and then skip the type and write the new length
-    if(fseek(extraData->fileHandle, (long)(chunk->size + 4), SEEK_CUR) != 0) {
-      logError("Could not seek to next chunk during WAVE file finalization");
-      fclose(extraData->fileHandle);
-      freeRiffChunk(chunk);
-      return;
-    }
-    numBytesWritten = sampleSource->numSamplesProcessed * extraData->bitsPerSample / 8;
-    if(fwrite(&numBytesWritten, sizeof(unsigned int), 1, extraData->fileHandle) != 1) {
-      logError("Could not write WAVE file size during finalization");
-      fclose(extraData->fileHandle);
-      freeRiffChunk(chunk);
-      return;
+    // Chunks must be padded to an even size, or a multiple of 8 for Wave64.
+    // The padding is not counted in the data chunk's size.
+    padding = _getWaveChunkPadding(numBytesWritten, isWave64);
+    if(padding > 0 && fwrite(kPadding, 1, (size_t)padding, extraData->fileHandle) != padding) {
+      logError("Could not write padding during WAVE file finalization");
     }
 
-    // Add 40 bytes for fmt chunk size and write the RIFF chunk size
-    numBytesWritten += ftell(extraData->fileHandle) - 8;
-    if(fseek(extraData->fileHandle, 4, SEEK_SET) != 0) {
-      logError("Could not seek to fmt chunk during WAVE file finalization");
-      fclose(extraData->fileHandle);
-      freeRiffChunk(chunk);
-      return;
+    if(isWave64) {
+      _finishWave64Header(extraData, numBytesWritten, numFramesWritten);
     }
-    if(fwrite(&numBytesWritten, sizeof(unsigned int), 1, extraData->fileHandle) != 1) {
-      logError("Could not write WAVE file size in fmt chunk during finalization");
-      fclose(extraData->fileHandle);
-      freeRiffChunk(chunk);
-      return;
+    else {
+      _finishRiffHeader(extraData, numBytesWritten, numFramesWritten);
     }
     fflush(extraData->fileHandle);
-    fclose(extraData->fileHandle);
-    freeRiffChunk(chunk);
+    _closeWaveFileHandle(extraData);
   }
   else if(sampleSource->openedAs == SAMPLE_SOURCE_OPEN_READ && extraData->fileHandle != NULL) {
-    fclose(extraData->fileHandle);
+    sampleSourcePcmUnmapFile(extraData);
+    _closeWaveFileHandle(extraData);
   }
-#endif
 }
 
-SampleSource _newSampleSourceWave(const CharString sampleSourceName) {
+static boolByte _openSampleSourceWaveNative(void *sampleSourcePtr, const SampleSourceOpenAs openAs) {
+  return _openWaveFile((SampleSource)sampleSourcePtr, openAs);
+}
+
+static void _closeSampleSourceWaveNative(void *sampleSourcePtr) {
+  _closeWaveFile((SampleSource)sampleSourcePtr);
+}
+
+// Wave64 files and streams are always handled internally, even if libaudiofile
+// is used for WAVE files
+static SampleSource _newSampleSourceWaveNative(const CharString sampleSourceName, SampleSourceType sampleSourceType) {
   SampleSource sampleSource = (SampleSource)malloc(sizeof(SampleSourceMembers));
-#if HAVE_LIBAUDIOFILE
-  SampleSourceAudiofileData extraData = (SampleSourceAudiofileData)malloc(sizeof(SampleSourceAudiofileDataMembers));
-#else
   SampleSourcePcmData extraData = (SampleSourcePcmData)malloc(sizeof(SampleSourcePcmDataMembers));
-#endif
 
-  sampleSource->sampleSourceType = SAMPLE_SOURCE_TYPE_WAVE;
+  sampleSource->sampleSourceType = sampleSourceType;
   sampleSource->openedAs = SAMPLE_SOURCE_OPEN_NOT_OPENED;
   sampleSource->sourceName = newCharString();
   charStringCopy(sampleSource->sourceName, sampleSourceName);
   sampleSource->numSamplesProcessed = 0;
+  sampleSource->lengthInFrames = 0;
 
-  sampleSource->openSampleSource = _openSampleSourceWave;
-#if HAVE_LIBAUDIOFILE
-  sampleSource->readSampleBlock = readBlockFromAudiofile;
-  sampleSource->writeSampleBlock = writeBlockToAudiofile;
-  sampleSource->freeSampleSourceData = freeSampleSourceDataAudiofile;
-  sampleSource->closeSampleSource = closeSampleSourceAudiofile;
-#else
+  sampleSource->openSampleSource = _openSampleSourceWaveNative;
   sampleSource->readSampleBlock = _readBlockFromWaveFile;
   sampleSource->writeSampleBlock = _writeBlockToWaveFile;
-  sampleSource->closeSampleSource = _closeSampleSourceWave;
+  sampleSource->seekSampleSource = _seekWaveFile;
+  sampleSource->closeSampleSource = _closeSampleSourceWaveNative;
   sampleSource->freeSampleSourceData = freeSampleSourceDataPcm;
-#endif
 
-#if HAVE_LIBAUDIOFILE
-  extraData->fileHandle = NULL;
-  extraData->interlacedBuffer = NULL;
-  extraData->pcmBuffer = NULL;
-#else
   extraData->isStream = false;
   extraData->isLittleEndian = true;
   extraData->fileHandle = NULL;
+  extraData->dataOffset = 0;
   extraData->dataBufferNumItems = 0;
   extraData->interlacedPcmDataBuffer = NULL;
 
   extraData->numChannels = (unsigned short)getNumChannels();
   extraData->sampleRate = (unsigned int)getSampleRate();
   extraData->bitsPerSample = 16;
-#endif
-
+  extraData->sampleFormat = PCM_SAMPLE_FORMAT_INT16;
+  extraData->mappedFile = NULL;
+  extraData->mappedReadPosition = 0;
+  extraData->mappedDataEnd = 0;
+  extraData->asyncWriter = NULL;
+  extraData->isPreallocated = false;
   sampleSource->extraData = extraData;
 
   return sampleSource;
 }
+
+SampleSource _newSampleSourceWave(const CharString sampleSourceName) {
+#if HAVE_LIBAUDIOFILE
+  SampleSource sampleSource;
+  SampleSourceAudiofileData extraData;
+
+  if(!sampleSourceIsStdio(sampleSourceName)) {
+    sampleSource = (SampleSource)malloc(sizeof(SampleSourceMembers));
+    extraData = (SampleSourceAudiofileData)malloc(sizeof(SampleSourceAudiofileDataMembers));
+
+    sampleSource->sampleSourceType = SAMPLE_SOURCE_TYPE_WAVE;
+    sampleSource->openedAs = SAMPLE_SOURCE_OPEN_NOT_OPENED;
+    sampleSource->sourceName = newCharString();
+    charStringCopy(sampleSource->sourceName, sampleSourceName);
+    sampleSource->numSamplesProcessed = 0;
+    sampleSource->lengthInFrames = 0;
+
+    sampleSource->openSampleSource = _openSampleSourceWave;
+    sampleSource->readSampleBlock = readBlockFromAudiofile;
+    sampleSource->writeSampleBlock = writeBlockToAudiofile;
+    sampleSource->seekSampleSource = NULL;
+    sampleSource->freeSampleSourceData = freeSampleSourceDataAudiofile;
+    sampleSource->closeSampleSource = closeSampleSourceAudiofile;
+
+    extraData->fileHandle = NULL;
+    extraData->interlacedBuffer = NULL;
+    extraData->pcmBuffer = NULL;
+    sampleSource->extraData = extraData;
+
+    return sampleSource;
+  }
+#endif
+  return _newSampleSourceWaveNative(sampleSourceName, SAMPLE_SOURCE_TYPE_WAVE);
+}
+
+SampleSource _newSampleSourceWave64(const CharString sampleSourceName) {
+  return _newSampleSourceWaveNative(sampleSourceName, SAMPLE_SOURCE_TYPE_WAVE64);
+}
@@ -31,6 +31,7 @@
 #include <stdarg.h>
 
 #include "app/BuildInfo.h"
+#include "app/EngineContext.h"
 #include "audio/AudioSettings.h"
 #include "base/PlatformUtilities.h"
 #include "logging/EventLogger.h"
@@ -46,39 +47,61 @@
 #include <unistd.h>
 #endif
 
+// Log messages are formatted into stack buffers, since logging from the
+// render loop must not allocate. These match kCharStringLengthDefault * 2 and
+// kCharStringLengthLong, which can't be used as array sizes in C.
+#define LOG_MESSAGE_LENGTH 512
+#define LOG_LINE_LENGTH 8192
+
 EventLogger eventLoggerInstance = NULL;
 
-void initEventLogger(void) {
+// Location of the instance used by the calling thread
+static EventLogger* _getEventLoggerInstanceLocation(void) {
+  EngineContext context = getCurrentEngineContext();
+  return context != NULL ? &context->eventLogger : &eventLoggerInstance;
+}
+
+static EventLogger _getEventLoggerInstance(void) {
+  return *_getEventLoggerInstanceLocation();
+}
+
+EventLogger newEventLogger(void) {
+  EventLogger eventLogger;
 #if WINDOWS
   ULONGLONG currentTime;
 #else
   struct timeval currentTime;
 #endif
 
-  eventLoggerInstance = (EventLogger)malloc(sizeof(EventLoggerMembers));
-  eventLoggerInstance->logLevel = LOG_INFO;
-  eventLoggerInstance->logFile = NULL;
-  eventLoggerInstance->useColor = false;
-  eventLoggerInstance->zebraStripeSize = (unsigned long)DEFAULT_SAMPLE_RATE;
-  eventLoggerInstance->systemErrorMessage = NULL;
+  eventLogger = (EventLogger)malloc(sizeof(EventLoggerMembers));
+  eventLogger->logLevel = LOG_INFO;
+  eventLogger->logFile = NULL;
+  eventLogger->useColor = false;
+  eventLogger->zebraStripeSize = (unsigned long)DEFAULT_SAMPLE_RATE;
+  eventLogger->systemErrorMessage = NULL;
 
 #if WINDOWS
   currentTime = GetTickCount();
-  eventLoggerInstance->startTimeInSec = (unsigned long)(currentTime / 1000);
-  eventLoggerInstance->startTimeInMs = (unsigned long)currentTime;
+  eventLogger->startTimeInSec = (unsigned long)(currentTime / 1000);
+  eventLogger->startTimeInMs = (unsigned long)currentTime;
 #else
   gettimeofday(&currentTime, NULL);
-  eventLoggerInstance->startTimeInSec = currentTime.tv_sec;
-  eventLoggerInstance->startTimeInMs = currentTime.tv_usec / 1000;
+  eventLogger->startTimeInSec = currentTime.tv_sec;
+  eventLogger->startTimeInMs = currentTime.tv_usec / 1000;
 #endif
 
   if(isatty(1)) {
-    eventLoggerInstance->useColor = true;
+    eventLogger->useColor = true;
   }
+  return eventLogger;
 }
 
-static EventLogger _getEventLoggerInstance(void) {
-  return eventLoggerInstance;
+void initEventLogger(void) {
+  EventLogger* instance = _getEventLoggerInstanceLocation();
+  if(*instance != NULL) {
+    freeEventLogger();
+  }
+  *instance = newEventLogger();
 }
 
 char* stringForLastError(int errorNumber) {
@@ -195,23 +218,22 @@ static LogColor _logTimeZebraStripeColor(const long elapsedTime, const unsigned
 }
 
 static void _printMessage(const LogLevel logLevel, const long elapsedTimeInMs, const long numFramesProcessed, const char* message, const EventLogger eventLogger) {
-  char* logString = (char*)malloc(sizeof(char) * kCharStringLengthLong);
+  char logString[LOG_LINE_LENGTH];
   if(eventLogger->useColor) {
-    snprintf(logString, kCharStringLengthLong, "%c ", _logLevelStatusChar(logLevel));
+    snprintf(logString, LOG_LINE_LENGTH, "%c ", _logLevelStatusChar(logLevel));
     printToLog(_logLevelStatusColor(logLevel), eventLogger->logFile, logString);
-    snprintf(logString, kCharStringLengthLong, "%08ld ", numFramesProcessed);
+    snprintf(logString, LOG_LINE_LENGTH, "%08ld ", numFramesProcessed);
     printToLog(_logTimeZebraStripeColor(numFramesProcessed, eventLogger->zebraStripeSize),
       eventLogger->logFile, logString);
-    snprintf(logString, kCharStringLengthLong, "%06ld ", elapsedTimeInMs);
+    snprintf(logString, LOG_LINE_LENGTH, "%06ld ", elapsedTimeInMs);
     printToLog(_logTimeColor(), eventLogger->logFile, logString);
     printToLog(_logLevelStatusColor(logLevel), eventLogger->logFile, message);
   }
   else {
-    snprintf(logString, kCharStringLengthLong, "%c %08ld %06ld %s", _logLevelStatusChar(logLevel), numFramesProcessed, elapsedTimeInMs, message);
+    snprintf(logString, LOG_LINE_LENGTH, "%c %08ld %06ld %s", _logLevelStatusChar(logLevel), numFramesProcessed, elapsedTimeInMs, message);
     printToLog(COLOR_NONE, eventLogger->logFile, logString);
   }
   flushLog(eventLogger->logFile);
-  free(logString);
 }
 
 static void _logMessage(const LogLevel logLevel, const char* message, va_list arguments) {
@@ -224,8 +246,8 @@ static void _logMessage(const LogLevel logLevel, const char* message, va_list ar
 #endif
 
   if(eventLogger != NULL && logLevel >= eventLogger->logLevel) {
-    CharString formattedMessage = newCharStringWithCapacity(kCharStringLengthDefault * 2);
-    vsnprintf(formattedMessage->data, formattedMessage->capacity, message, arguments);
+    char formattedMessage[LOG_MESSAGE_LENGTH];
+    vsnprintf(formattedMessage, LOG_MESSAGE_LENGTH, message, arguments);
 #if WINDOWS
     currentTime = GetTickCount();
     elapsedTimeInMs = (unsigned long)(currentTime - eventLogger->startTimeInMs);
@@ -234,8 +256,7 @@ static void _logMessage(const LogLevel logLevel, const char* message, va_list ar
     elapsedTimeInMs = ((currentTime.tv_sec - (eventLogger->startTimeInSec + 1)) * 1000) +
       (currentTime.tv_usec / 1000) + (1000 - eventLogger->startTimeInMs);
 #endif
-    _printMessage(logLevel, elapsedTimeInMs, getAudioClock()->currentFrame, formattedMessage->data, eventLogger);
-    freeCharString(formattedMessage);
+    _printMessage(logLevel, elapsedTimeInMs, getAudioClock()->currentFrame, formattedMessage, eventLogger);
   }
 }
 
@@ -268,6 +289,7 @@ void logError(const char* message, ...) {
 }
 
 void logCritical(const char* message, ...) {
+  EventLogger eventLogger = _getEventLoggerInstance();
   va_list arguments;
   CharString formattedMessage = newCharString();
   CharString wrappedMessage;
@@ -278,8 +300,8 @@ void logCritical(const char* message, ...) {
   vsnprintf(formattedMessage->data, formattedMessage->capacity, message, arguments);
   wrappedMessage = charStringWrap(formattedMessage, 0);
   fprintf(stderr, "ERROR: %s\n", wrappedMessage->data);
-  if(eventLoggerInstance != NULL && eventLoggerInstance->logFile != NULL) {
-    fprintf(eventLoggerInstance->logFile, "ERROR: %s\n", wrappedMessage->data);
+  if(eventLogger != NULL && eventLogger->logFile != NULL) {
+    fprintf(eventLogger->logFile, "ERROR: %s\n", wrappedMessage->data);
   }
 
   freeCharString(formattedMessage);
@@ -288,6 +310,7 @@ void logCritical(const char* message, ...) {
 }
 
 void logInternalError(const char* message, ...) {
+  EventLogger eventLogger = _getEventLoggerInstance();
   va_list arguments;
   CharString formattedMessage = newCharString();
 
@@ -295,8 +318,8 @@ void logInternalError(const char* message, ...) {
   // Instead of going through the common logging method, we always dump critical messages to stderr
   vsnprintf(formattedMessage->data, formattedMessage->capacity, message, arguments);
   fprintf(stderr, "INTERNAL ERROR: %s\n", formattedMessage->data);
-  if(eventLoggerInstance != NULL && eventLoggerInstance->logFile != NULL) {
-  fprintf(eventLoggerInstance->logFile, "INTERNAL ERROR: %s\n", formattedMessage->data);
+  if(eventLogger != NULL && eventLogger->logFile != NULL) {
+  fprintf(eventLogger->logFile, "INTERNAL ERROR: %s\n", formattedMessage->data);
   }
   freeCharString(formattedMessage);
   va_end(arguments);
@@ -340,16 +363,19 @@ generate a diagnostic report to send to support.");
 }
 
 void flushErrorLog(void) {
-  if(eventLoggerInstance != NULL && eventLoggerInstance->logFile != NULL) {
-    fflush(eventLoggerInstance->logFile);
+  EventLogger eventLogger = _getEventLoggerInstance();
+  if(eventLogger != NULL && eventLogger->logFile != NULL) {
+    fflush(eventLogger->logFile);
   }
 }
 
 void freeEventLogger(void) {
-  if(eventLoggerInstance->logFile != NULL) {
-    fclose(eventLoggerInstance->logFile);
+  EventLogger* instance = _getEventLoggerInstanceLocation();
+  EventLogger eventLogger = *instance;
+  if(eventLogger->logFile != NULL) {
+    fclose(eventLogger->logFile);
   }
-  freeCharString(eventLoggerInstance->systemErrorMessage);
-  free(eventLoggerInstance);
-  eventLoggerInstance = NULL;
+  freeCharString(eventLogger->systemErrorMessage);
+  free(eventLogger);
+  *instance = NULL;
 }
@@ -55,9 +55,18 @@ typedef EventLoggerMembers* EventLogger;
 extern EventLogger eventLoggerInstance;
 
 /**
- * Initialize the global event logger instance. Unlike other classes, the event
- * logger exists as a global singleton, since it is called from numerous places
- * throughout the code base.
+ * Create a new event logger which writes to the console at the default level.
+ * This is mostly used by EngineContext, other code should use the logging
+ * functions below.
+ * @return Initialized EventLogger
+ */
+EventLogger newEventLogger(void);
+
+/**
+ * Initialize the event logger instance. Unlike other classes, the event logger
+ * is not passed around, since it is called from numerous places throughout the
+ * code base. Instead, the logger of the current EngineContext is used, or a
+ * global instance if no context is current on the calling thread.
  */
 void initEventLogger(void);
 
@@ -212,7 +221,7 @@ void logPossibleBug(const char* cause);
 void flushErrorLog(void);
 
 /**
- * Free all memory and associated resources from the global EventLogger instance
+ * Free all memory and associated resources from the current EventLogger instance
  */
 void freeEventLogger(void);
 
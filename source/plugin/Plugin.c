@@ -29,7 +29,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "audio/AudioSettings.h"
 #include "logging/EventLogger.h"
 #include "plugin/Plugin.h"
 #include "plugin/PluginPassthru.h"
@@ -133,9 +132,6 @@ boolByte openPlugin(Plugin self) {
   if(!self->openPlugin(self)){
     logError("Plugin '%s' could not be opened", self->pluginName->data);
     return false;
-  }else{
-    self->inputBuffer = newSampleBuffer((unsigned int)self->getSetting(self, PLUGIN_NUM_INPUTS), getBlocksize());
-    self->outputBuffer = newSampleBuffer((unsigned int)self->getSetting(self, PLUGIN_NUM_OUTPUTS), getBlocksize());
   }
   return true;
 }
@@ -148,6 +144,8 @@ boolByte closePlugin(Plugin self){
   self->closePlugin(self);
   freeSampleBuffer(self->inputBuffer);
   freeSampleBuffer(self->outputBuffer);
+  self->inputBuffer = NULL;
+  self->outputBuffer = NULL;
   return true;
 }
 
@@ -159,6 +157,8 @@ Plugin _newPlugin(PluginInterfaceType interfaceType, PluginType pluginType) {
   plugin->pluginName = newCharString();
   plugin->pluginLocation = newCharString();
   plugin->pluginAbsolutePath = newCharString();
+  plugin->inputBuffer = NULL;
+  plugin->outputBuffer = NULL;
 
   return plugin;
 }
@@ -172,6 +172,8 @@ void freePlugin(Plugin self) {
     freeCharString(self->pluginName);
     freeCharString(self->pluginLocation);
     freeCharString(self->pluginAbsolutePath);
+    freeSampleBuffer(self->inputBuffer);
+    freeSampleBuffer(self->outputBuffer);
     free(self);
   }
 }
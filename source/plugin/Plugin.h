@@ -55,6 +55,7 @@ typedef enum {
   PLUGIN_NUM_INPUTS,
   PLUGIN_NUM_OUTPUTS,
   PLUGIN_INITIAL_DELAY,
+  PLUGIN_NUM_PARAMETERS,
   NUM_PLUGIN_SETTINGS
 } PluginSetting;
 
@@ -102,12 +103,26 @@ typedef void (*PluginProcessMidiEventsFunc)(void* pluginPtr, LinkedList midiEven
  * @param value New value
  */
 typedef boolByte (*PluginSetParameterFunc)(void* pluginPtr, unsigned int index, float value);
+/**
+ * Get the current value of a parameter within a plugin
+ * @param pluginPtr self
+ * @param index Parameter index, less than the PLUGIN_NUM_PARAMETERS setting
+ * @return Current value
+ */
+typedef float (*PluginGetParameterFunc)(void* pluginPtr, unsigned int index);
 /**
  * Called once before audio processing begins. Some interfaces provide hooks for
  * a plugin to prepare itself before audio blocks are sent to it.
  * @param pluginPtr self
  */
 typedef void (*PluginPrepareForProcessingFunc)(void* pluginPtr);
+/**
+ * Called between renders so that the plugin discards any internal state, such
+ * as delay lines or sounding voices. The prepareForProcessing function will be
+ * called again before any more audio blocks are sent to the plugin.
+ * @param pluginPtr self
+ */
+typedef void (*PluginSuspendFunc)(void* pluginPtr);
 /**
  * Called when the plugin is to be uninitialized and closed.
  * @param pluginPtr self
@@ -132,9 +147,14 @@ typedef struct {
   PluginProcessAudioFunc processAudio;
   PluginProcessMidiEventsFunc processMidiEvents;
   PluginSetParameterFunc setParameter;
+  PluginGetParameterFunc getParameter;
   PluginPrepareForProcessingFunc prepareForProcessing;
+  PluginSuspendFunc suspend;
   PluginCloseFunc closePlugin;
   FreePluginDataFunc freePluginData;
+  // Buffers owned by the plugin, only allocated by hosts which process several
+  // plugins at the same time. Otherwise, the host passes shared buffers to
+  // processAudio() and these are NULL.
   SampleBuffer inputBuffer;
   SampleBuffer outputBuffer;
 
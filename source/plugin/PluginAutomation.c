@@ -0,0 +1,409 @@
+//
+// PluginAutomation.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "audio/AudioSettings.h"
+#include "base/File.h"
+#include "logging/EventLogger.h"
+#include "midi/MidiEvent.h"
+#include "plugin/PluginAutomation.h"
+
+PluginAutomation newPluginAutomation(void) {
+  PluginAutomation automation = (PluginAutomation)malloc(sizeof(PluginAutomationMembers));
+  automation->points = newLinkedList();
+  automation->_sortedPoints = NULL;
+  automation->_numPoints = 0;
+  automation->_lanes = NULL;
+  automation->_numLanes = 0;
+  automation->_nextPoint = 0;
+  automation->_inputChunk = NULL;
+  automation->_outputChunk = NULL;
+  automation->_chunkMidiEvents = newLinkedListWithCapacity(PLUGIN_AUTOMATION_MIDI_EVENTS_CAPACITY);
+  return automation;
+}
+
+static const char* _skipWhitespace(const char* position) {
+  while(*position != '\0' && isspace((unsigned char)*position)) {
+    position++;
+  }
+  return position;
+}
+
+// Parse a number followed by a field separator or the end of the line. When
+// outIsInFrames is given, the number may be followed by the frames suffix.
+static boolByte _parseAutomationField(const char** position, double* outValue, boolByte* outIsInFrames) {
+  const char* start = _skipWhitespace(*position);
+  char* end = NULL;
+
+  *outValue = strtod(start, &end);
+  if(end == start) {
+    return false;
+  }
+  if(outIsInFrames != NULL) {
+    *outIsInFrames = (boolByte)(*end == PLUGIN_AUTOMATION_FRAMES_SUFFIX);
+    if(*outIsInFrames) {
+      end++;
+    }
+  }
+
+  end = (char*)_skipWhitespace(end);
+  if(*end == PLUGIN_AUTOMATION_FIELD_SEPARATOR) {
+    end++;
+  }
+  else if(*end != '\0') {
+    return false;
+  }
+  *position = end;
+  return true;
+}
+
+boolByte pluginAutomationAddPointFromString(PluginAutomation self, const CharString line) {
+  PluginAutomationPoint point;
+  const char* position;
+  double pluginIndex;
+  double parameterIndex;
+  double value;
+
+  if(line == NULL || charStringIsEmpty(line)) {
+    return false;
+  }
+
+  point = (PluginAutomationPoint)malloc(sizeof(PluginAutomationPointMembers));
+  point->rampTimeInMs = 0.0;
+  point->rampTimeIsInFrames = false;
+  point->_frame = 0;
+  point->_rampLengthInFrames = 0;
+  point->_laneIndex = 0;
+  point->_fileOrder = (unsigned int)linkedListLength(self->points);
+
+  position = line->data;
+  if(!_parseAutomationField(&position, &point->timeInMs, &point->timeIsInFrames) ||
+    !_parseAutomationField(&position, &pluginIndex, NULL) ||
+    !_parseAutomationField(&position, &parameterIndex, NULL) ||
+    !_parseAutomationField(&position, &value, NULL) ||
+    (*position != '\0' && !_parseAutomationField(&position, &point->rampTimeInMs, &point->rampTimeIsInFrames)) ||
+    *position != '\0') {
+    logError("Automation line '%s' is malformed", line->data);
+    free(point);
+    return false;
+  }
+  if(point->timeInMs < 0.0 || point->rampTimeInMs < 0.0 || pluginIndex < 0.0 || parameterIndex < 0.0) {
+    logError("Automation line '%s' has negative times or indexes", line->data);
+    free(point);
+    return false;
+  }
+
+  point->pluginIndex = (unsigned int)pluginIndex;
+  point->parameterIndex = (unsigned int)parameterIndex;
+  point->value = (float)value;
+  linkedListAppend(self->points, point);
+  return true;
+}
+
+PluginAutomation newPluginAutomationWithFile(const CharString filename) {
+  PluginAutomation automation;
+  File automationFile;
+  LinkedList lines;
+  LinkedListIterator iterator;
+  CharString line;
+
+  if(filename == NULL || charStringIsEmpty(filename)) {
+    logError("Cannot read automation from empty filename");
+    return NULL;
+  }
+
+  automationFile = newFileWithPath(filename);
+  if(automationFile == NULL || automationFile->fileType != kFileTypeFile) {
+    logError("Automation file '%s' does not exist", filename->data);
+    freeFile(automationFile);
+    return NULL;
+  }
+
+  lines = fileReadLines(automationFile);
+  freeFile(automationFile);
+  if(lines == NULL) {
+    logError("Could not read automation file '%s'", filename->data);
+    return NULL;
+  }
+
+  automation = newPluginAutomation();
+  iterator = lines;
+  while(iterator != NULL) {
+    line = (CharString)iterator->item;
+    if(line != NULL && !charStringIsEmpty(line) && line->data[0] != PLUGIN_AUTOMATION_COMMENT_CHAR) {
+      if(!pluginAutomationAddPointFromString(automation, line)) {
+        freePluginAutomation(automation);
+        freeLinkedListAndItems(lines, (LinkedListFreeItemFunc)freeCharString);
+        return NULL;
+      }
+    }
+    iterator = iterator->nextItem;
+  }
+
+  freeLinkedListAndItems(lines, (LinkedListFreeItemFunc)freeCharString);
+  logDebug("Read %d automation points from '%s'", linkedListLength(automation->points), filename->data);
+  return automation;
+}
+
+static unsigned long _automationTimeToFrames(double time, boolByte isInFrames) {
+  if(isInFrames) {
+    return (unsigned long)(time + 0.5);
+  }
+  return (unsigned long)(time * getSampleRate() / 1000.0 + 0.5);
+}
+
+// Points at the same frame keep the order in which they appear in the file
+static int _compareAutomationPoints(const void* a, const void* b) {
+  const PluginAutomationPoint pointA = *(const PluginAutomationPoint*)a;
+  const PluginAutomationPoint pointB = *(const PluginAutomationPoint*)b;
+  if(pointA->_frame != pointB->_frame) {
+    return pointA->_frame < pointB->_frame ? -1 : 1;
+  }
+  return (int)pointA->_fileOrder - (int)pointB->_fileOrder;
+}
+
+boolByte pluginAutomationPrepare(PluginAutomation self, PluginChain pluginChain) {
+  LinkedListIterator iterator;
+  PluginAutomationPoint point;
+  unsigned int numPoints = (unsigned int)linkedListLength(self->points);
+  unsigned int i;
+  unsigned int lane;
+
+  free(self->_sortedPoints);
+  free(self->_lanes);
+  freeSampleBuffer(self->_inputChunk);
+  freeSampleBuffer(self->_outputChunk);
+  self->_sortedPoints = (PluginAutomationPoint*)malloc(sizeof(PluginAutomationPoint) * (numPoints + 1));
+  self->_lanes = (PluginAutomationLane)malloc(sizeof(PluginAutomationLaneMembers) * (numPoints + 1));
+  self->_numPoints = 0;
+  self->_numLanes = 0;
+  self->_inputChunk = newSampleBuffer(getNumChannels(), getBlocksize());
+  self->_outputChunk = newSampleBuffer(getNumChannels(), getBlocksize());
+
+  iterator = self->points;
+  while(iterator != NULL) {
+    point = (PluginAutomationPoint)iterator->item;
+    if(point != NULL) {
+      if(point->pluginIndex >= pluginChain->numPlugins) {
+        logError("Automation point at %.2fms refers to plugin %u, but the chain only has %u plugins",
+          point->timeInMs, point->pluginIndex, pluginChain->numPlugins);
+        return false;
+      }
+      point->_frame = _automationTimeToFrames(point->timeInMs, point->timeIsInFrames);
+      point->_rampLengthInFrames = _automationTimeToFrames(point->rampTimeInMs, point->rampTimeIsInFrames);
+
+      // Each parameter which is automated gets its own lane
+      for(lane = 0; lane < self->_numLanes; lane++) {
+        if(self->_lanes[lane].pluginIndex == point->pluginIndex &&
+          self->_lanes[lane].parameterIndex == point->parameterIndex) {
+          break;
+        }
+      }
+      if(lane == self->_numLanes) {
+        self->_lanes[lane].pluginIndex = point->pluginIndex;
+        self->_lanes[lane].parameterIndex = point->parameterIndex;
+        self->_numLanes++;
+      }
+      point->_laneIndex = lane;
+      self->_sortedPoints[self->_numPoints++] = point;
+    }
+    iterator = iterator->nextItem;
+  }
+
+  qsort(self->_sortedPoints, self->_numPoints, sizeof(PluginAutomationPoint), _compareAutomationPoints);
+  for(i = 0; i < self->_numLanes; i++) {
+    logDebug("Automating parameter %u of plugin '%s'", self->_lanes[i].parameterIndex,
+      pluginChain->plugins[self->_lanes[i].pluginIndex]->pluginName->data);
+  }
+  pluginAutomationRewind(self);
+  return true;
+}
+
+void pluginAutomationRewind(PluginAutomation self) {
+  unsigned int i;
+  self->_nextPoint = 0;
+  for(i = 0; i < self->_numLanes; i++) {
+    self->_lanes[i].hasValue = false;
+    self->_lanes[i].currentValue = 0.0f;
+    self->_lanes[i].isRamping = false;
+    self->_lanes[i].setParameterFailed = false;
+  }
+}
+
+static void _setAutomatedParameter(PluginChain pluginChain, PluginAutomationLane lane, float value) {
+  Plugin plugin = pluginChain->plugins[lane->pluginIndex];
+  if(lane->hasValue && lane->currentValue == value) {
+    return;
+  }
+  lane->hasValue = true;
+  lane->currentValue = value;
+  if(!plugin->setParameter(plugin, lane->parameterIndex, value) && !lane->setParameterFailed) {
+    lane->setParameterFailed = true;
+    logWarn("Could not set automated parameter %u of plugin '%s'", lane->parameterIndex, plugin->pluginName->data);
+  }
+}
+
+// Apply all points up to the given frame, and move any ramps to that frame
+static void _applyAutomationAtFrame(PluginAutomation self, PluginChain pluginChain, unsigned long frame) {
+  PluginAutomationPoint point;
+  PluginAutomationLane lane;
+  unsigned int i;
+
+  while(self->_nextPoint < self->_numPoints && self->_sortedPoints[self->_nextPoint]->_frame <= frame) {
+    point = self->_sortedPoints[self->_nextPoint];
+    lane = &(self->_lanes[point->_laneIndex]);
+    // Without a previous value there is nothing to ramp from, so jump straight to the target
+    if(point->_rampLengthInFrames == 0 || !lane->hasValue) {
+      lane->isRamping = false;
+      _setAutomatedParameter(pluginChain, lane, point->value);
+    }
+    else {
+      lane->isRamping = true;
+      lane->rampStartFrame = point->_frame;
+      lane->rampEndFrame = point->_frame + point->_rampLengthInFrames;
+      lane->rampStartValue = lane->currentValue;
+      lane->rampEndValue = point->value;
+    }
+    self->_nextPoint++;
+  }
+
+  for(i = 0; i < self->_numLanes; i++) {
+    lane = &(self->_lanes[i]);
+    if(lane->isRamping) {
+      if(frame >= lane->rampEndFrame) {
+        lane->isRamping = false;
+        _setAutomatedParameter(pluginChain, lane, lane->rampEndValue);
+      }
+      else {
+        _setAutomatedParameter(pluginChain, lane, lane->rampStartValue +
+          (lane->rampEndValue - lane->rampStartValue) *
+          (float)(frame - lane->rampStartFrame) / (float)(lane->rampEndFrame - lane->rampStartFrame));
+      }
+    }
+  }
+}
+
+// Find the next frame after the given one where a parameter changes
+static unsigned long _getNextAutomationFrame(PluginAutomation self, unsigned long frame, unsigned long endFrame) {
+  unsigned long nextFrame = endFrame;
+  unsigned long rampFrame;
+  unsigned int i;
+
+  if(self->_nextPoint < self->_numPoints && self->_sortedPoints[self->_nextPoint]->_frame < nextFrame) {
+    nextFrame = self->_sortedPoints[self->_nextPoint]->_frame;
+  }
+  for(i = 0; i < self->_numLanes; i++) {
+    if(self->_lanes[i].isRamping) {
+      rampFrame = frame + PLUGIN_AUTOMATION_RAMP_STEP_FRAMES;
+      if(rampFrame > self->_lanes[i].rampEndFrame) {
+        rampFrame = self->_lanes[i].rampEndFrame;
+      }
+      if(rampFrame < nextFrame) {
+        nextFrame = rampFrame;
+      }
+    }
+  }
+  return nextFrame;
+}
+
+/**
+ * Send the MIDI events which fall before the given frame to the chain, with
+ * their offsets counted from the start of the piece being processed.
+ * @return Iterator at the first event which was not sent
+ */
+static LinkedListIterator _sendAutomationChunkMidi(PluginAutomation self, PluginChain pluginChain,
+  LinkedListIterator iterator, unsigned long chunkStartFrame, unsigned long chunkEndFrame) {
+  MidiEvent midiEvent;
+
+  linkedListClear(self->_chunkMidiEvents);
+  while(iterator != NULL && iterator->item != NULL) {
+    midiEvent = (MidiEvent)iterator->item;
+    if(midiEvent->timestamp >= chunkEndFrame) {
+      break;
+    }
+    midiEvent->deltaFrames = midiEvent->timestamp > chunkStartFrame ? midiEvent->timestamp - chunkStartFrame : 0;
+    linkedListAppend(self->_chunkMidiEvents, midiEvent);
+    iterator = (LinkedListIterator)iterator->nextItem;
+  }
+  pluginChainProcessMidi(pluginChain, self->_chunkMidiEvents);
+  return iterator;
+}
+
+void pluginAutomationProcessAudio(PluginAutomation self, PluginChain pluginChain, AudioClock audioClock,
+  LinkedList midiEvents, SampleBuffer inBuffer, SampleBuffer outBuffer) {
+  const unsigned long blockStartFrame = audioClock->currentFrame;
+  const unsigned long blocksize = inBuffer->blocksize;
+  const unsigned long blockEndFrame = blockStartFrame + blocksize;
+  unsigned long frame = blockStartFrame;
+  unsigned long nextFrame;
+  unsigned long chunkSize;
+  LinkedListIterator midiIterator = midiEvents;
+
+  outBuffer->blocksize = blocksize;
+  while(frame < blockEndFrame) {
+    _applyAutomationAtFrame(self, pluginChain, frame);
+    nextFrame = _getNextAutomationFrame(self, frame, blockEndFrame);
+    chunkSize = nextFrame - frame;
+    if(chunkSize == blocksize) {
+      // Nothing changes within this block, so process it in one piece
+      if(midiEvents != NULL) {
+        pluginChainProcessMidi(pluginChain, midiEvents);
+      }
+      pluginChainProcessAudio(pluginChain, inBuffer, outBuffer);
+      return;
+    }
+
+    if(midiEvents != NULL) {
+      // The last piece also gets any events past the end of a short final block
+      midiIterator = _sendAutomationChunkMidi(self, pluginChain, midiIterator, frame,
+        nextFrame == blockEndFrame ? (unsigned long)-1 : nextFrame);
+    }
+    self->_inputChunk->blocksize = chunkSize;
+    self->_outputChunk->blocksize = chunkSize;
+    sampleBufferCopyAndMapChannelsWithOffset(self->_inputChunk, 0, inBuffer, frame - blockStartFrame, chunkSize);
+    audioClock->currentFrame = frame;
+    pluginChainProcessAudio(pluginChain, self->_inputChunk, self->_outputChunk);
+    sampleBufferCopyAndMapChannelsWithOffset(outBuffer, frame - blockStartFrame, self->_outputChunk, 0, chunkSize);
+    frame = nextFrame;
+  }
+
+  audioClock->currentFrame = blockStartFrame;
+}
+
+void freePluginAutomation(PluginAutomation self) {
+  if(self != NULL) {
+    freeLinkedListAndItems(self->points, free);
+    free(self->_sortedPoints);
+    free(self->_lanes);
+    freeSampleBuffer(self->_inputChunk);
+    freeSampleBuffer(self->_outputChunk);
+    freeLinkedList(self->_chunkMidiEvents);
+    free(self);
+  }
+}
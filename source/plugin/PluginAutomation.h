@@ -0,0 +1,176 @@
+//
+// PluginAutomation.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_PluginAutomation_h
+#define MrsWatson_PluginAutomation_h
+
+#include "audio/SampleBuffer.h"
+#include "base/CharString.h"
+#include "base/LinkedList.h"
+#include "plugin/PluginChain.h"
+#include "time/AudioClock.h"
+
+#define PLUGIN_AUTOMATION_FIELD_SEPARATOR ','
+#define PLUGIN_AUTOMATION_COMMENT_CHAR '#'
+// Times with this suffix are given in sample frames rather than milliseconds
+#define PLUGIN_AUTOMATION_FRAMES_SUFFIX 'f'
+// Ramps are applied in steps of this many frames
+#define PLUGIN_AUTOMATION_RAMP_STEP_FRAMES 32
+// Initial capacity of the list of MIDI events sent with each piece of a block
+#define PLUGIN_AUTOMATION_MIDI_EVENTS_CAPACITY 64
+
+/**
+ * A single change of a parameter value. When the ramp time is zero, the value
+ * is set at the exact frame given by the point's time. Otherwise the value
+ * ramps linearly from the parameter's previous automated value, starting at
+ * that frame.
+ */
+typedef struct {
+  double timeInMs;
+  double rampTimeInMs;
+  boolByte timeIsInFrames;
+  boolByte rampTimeIsInFrames;
+  unsigned int pluginIndex;
+  unsigned int parameterIndex;
+  float value;
+
+  // Private fields, set by pluginAutomationPrepare()
+  unsigned long _frame;
+  unsigned long _rampLengthInFrames;
+  unsigned int _laneIndex;
+  unsigned int _fileOrder;
+} PluginAutomationPointMembers;
+typedef PluginAutomationPointMembers* PluginAutomationPoint;
+
+/**
+ * State of one automated parameter while rendering
+ */
+typedef struct {
+  unsigned int pluginIndex;
+  unsigned int parameterIndex;
+  boolByte hasValue;
+  float currentValue;
+  boolByte isRamping;
+  unsigned long rampStartFrame;
+  unsigned long rampEndFrame;
+  float rampStartValue;
+  float rampEndValue;
+  // Set when the plugin refused a value, so that this is only logged once
+  boolByte setParameterFailed;
+} PluginAutomationLaneMembers;
+typedef PluginAutomationLaneMembers* PluginAutomationLane;
+
+/**
+ * Parameter changes which are applied to the plugins of a chain at exact
+ * sample offsets while rendering. Blocks are split at each change point and
+ * sent to the chain in pieces, so that the changes take effect on the correct
+ * frame regardless of the blocksize.
+ */
+typedef struct {
+  LinkedList points;
+
+  // Private fields, set by pluginAutomationPrepare()
+  PluginAutomationPoint* _sortedPoints;
+  unsigned int _numPoints;
+  PluginAutomationLane _lanes;
+  unsigned int _numLanes;
+  unsigned int _nextPoint;
+  SampleBuffer _inputChunk;
+  SampleBuffer _outputChunk;
+  LinkedList _chunkMidiEvents;
+} PluginAutomationMembers;
+typedef PluginAutomationMembers* PluginAutomation;
+
+/**
+ * Create a new automation with no points
+ * @return Initialized PluginAutomation
+ */
+PluginAutomation newPluginAutomation(void);
+
+/**
+ * Parse a line from an automation file and add it to the automation. Lines
+ * have the following format:
+ *
+ *   <time>,<plugin index>,<parameter index>,<value>[,<ramp time>]
+ *
+ * Times are in milliseconds, or in sample frames when followed by 'f'. Plugin
+ * indexes start at zero for the head of the chain.
+ * @param self
+ * @param line Line to parse
+ * @return True if the line was valid and the point was added
+ */
+boolByte pluginAutomationAddPointFromString(PluginAutomation self, const CharString line);
+
+/**
+ * Read an automation file. Empty lines and lines starting with '#' are ignored.
+ * @param filename Path to the automation file
+ * @return Initialized PluginAutomation, or NULL if the file could not be read
+ * or contained malformed lines
+ */
+PluginAutomation newPluginAutomationWithFile(const CharString filename);
+
+/**
+ * Convert the points to sample frames and allocate the buffers needed for
+ * processing. This must be called after the plugin chain has been initialized,
+ * and again whenever the sample rate, channel count, or blocksize changes.
+ * @param self
+ * @param pluginChain Chain which the automation will be applied to
+ * @return False if a point refers to a plugin which is not in the chain
+ */
+boolByte pluginAutomationPrepare(PluginAutomation self, PluginChain pluginChain);
+
+/**
+ * Move back to the first point and forget the automated values, so that the
+ * automation can be applied to another render.
+ * @param self
+ */
+void pluginAutomationRewind(PluginAutomation self);
+
+/**
+ * Process a block through the plugin chain, applying any parameter changes
+ * which fall within the block. The block starts at the clock's current frame.
+ * While a piece of the block is processed, the clock is moved to the start of
+ * that piece so that plugins see the correct transport position. The block's
+ * MIDI events are sent to the chain with the piece which contains them, with
+ * their offsets counted from the start of that piece.
+ * @param self
+ * @param pluginChain Chain to process the block with
+ * @param audioClock Clock giving the position of the block
+ * @param midiEvents MIDI events for the block, sorted by timestamp, or NULL
+ * @param inBuffer Input sample block
+ * @param outBuffer Output sample block
+ */
+void pluginAutomationProcessAudio(PluginAutomation self, PluginChain pluginChain, AudioClock audioClock,
+  LinkedList midiEvents, SampleBuffer inBuffer, SampleBuffer outBuffer);
+
+/**
+ * Free an automation and all of its points
+ * @param self
+ */
+void freePluginAutomation(PluginAutomation self);
+
+#endif
@@ -29,27 +29,73 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "app/EngineContext.h"
 #include "logging/EventLogger.h"
+#include "midi/MidiEvent.h"
 #include "plugin/PluginChain.h"
 #include "audio/AudioSettings.h"
+#include "time/AudioClock.h"
+
+// Number of MIDI events per block which can be held for splitting before the
+// event lists need to grow
+#define SPLIT_MIDI_EVENTS_CAPACITY 64
 
 PluginChain pluginChainInstance = NULL;
 
+static SampleBuffer _pluginChainProcessPlugin(void* userData, unsigned int pluginIndex, SampleBuffer inBuffer);
+static void _pluginChainPrepareBuffers(PluginChain self);
+
+// Location of the instance used by the calling thread
+static PluginChain* _getPluginChainInstance(void) {
+  EngineContext context = getCurrentEngineContext();
+  return context != NULL ? &context->pluginChain : &pluginChainInstance;
+}
+
 PluginChain getPluginChain(void) {
-  return pluginChainInstance;
+  return *_getPluginChainInstance();
 }
 
-void initPluginChain(void) {
-  pluginChainInstance = (PluginChain)malloc(sizeof(PluginChainMembers));
+PluginChain newPluginChain(void) {
+  PluginChain pluginChain = (PluginChain)malloc(sizeof(PluginChainMembers));
+  unsigned int i;
 
-  pluginChainInstance->numPlugins = 0;
-  pluginChainInstance->plugins = (Plugin*)malloc(sizeof(Plugin) * MAX_PLUGINS);
-  pluginChainInstance->presets = (PluginPreset*)malloc(sizeof(PluginPreset) * MAX_PLUGINS);
-  pluginChainInstance->audioTimers = (TaskTimer*)malloc(sizeof(TaskTimer) * MAX_PLUGINS);
-  pluginChainInstance->midiTimers = (TaskTimer*)malloc(sizeof(TaskTimer) * MAX_PLUGINS);
+  pluginChain->numPlugins = 0;
+  pluginChain->plugins = (Plugin*)malloc(sizeof(Plugin) * MAX_PLUGINS);
+  pluginChain->presets = (PluginPreset*)malloc(sizeof(PluginPreset) * MAX_PLUGINS);
+  pluginChain->audioTimers = (TaskTimer*)malloc(sizeof(TaskTimer) * MAX_PLUGINS);
+  pluginChain->midiTimers = (TaskTimer*)malloc(sizeof(TaskTimer) * MAX_PLUGINS);
+  pluginChain->_numInputs = (unsigned int*)malloc(sizeof(unsigned int) * MAX_PLUGINS);
+  pluginChain->_numOutputs = (unsigned int*)malloc(sizeof(unsigned int) * MAX_PLUGINS);
+  pluginChain->_initialParameters = (float**)malloc(sizeof(float*) * MAX_PLUGINS);
+  pluginChain->_numInitialParameters = (unsigned int*)malloc(sizeof(unsigned int) * MAX_PLUGINS);
+  for(i = 0; i < MAX_PLUGINS; i++) {
+    pluginChain->_initialParameters[i] = NULL;
+    pluginChain->_numInitialParameters[i] = 0;
+  }
+
+  pluginChain->realtimeScheduler = NULL;
+  pluginChain->taps = newLinkedList();
+  pluginChain->graph = NULL;
+  pluginChain->pipeline = NULL;
+  pluginChain->_splitMidiEvents = false;
+  pluginChain->_pendingMidiEvents = NULL;
+  pluginChain->_nextPendingMidiEvent = NULL;
+  pluginChain->_chunkMidiEvents = NULL;
+  pluginChain->_headInputChunk = NULL;
+  pluginChain->_headOutputChunk = NULL;
+  pluginChain->_pingPongBuffers[0] = NULL;
+  pluginChain->_pingPongBuffers[1] = NULL;
+  pluginChain->_channelMapBuffer = NULL;
+  return pluginChain;
+}
 
-  pluginChainInstance->_realtime = false;
-  pluginChainInstance->_realtimeTimer = NULL;
+void initPluginChain(void) {
+  PluginChain* instance = _getPluginChainInstance();
+  if(*instance != NULL) {
+    pluginChainShutdown(*instance);
+    freePluginChain(*instance);
+  }
+  *instance = newPluginChain();
 }
 
 boolByte pluginChainAppend(PluginChain self, Plugin plugin, PluginPreset preset) {
@@ -72,62 +118,112 @@ boolByte pluginChainAppend(PluginChain self, Plugin plugin, PluginPreset preset)
   }
 }
 
+// Add a plugin from an argument with an optional preset name after a comma, ie
+// "plugin,preset". Arguments for plugins which cannot be found are ignored.
+static boolByte _pluginChainAddFromPluginArgument(PluginChain pluginChain, const char* argument,
+  size_t argumentLength, const CharString userSearchPath) {
+  CharString pluginNameBuffer = newCharString();
+  CharString presetNameBuffer = newCharString();
+  char* presetSeparator;
+  PluginPreset preset;
+  Plugin plugin;
+
+  strncpy(pluginNameBuffer->data, argument, argumentLength);
+
+  // Look for the separator for presets to load into these plugins
+  presetSeparator = strchr(pluginNameBuffer->data, CHAIN_STRING_PROGRAM_SEPARATOR);
+  if(presetSeparator != NULL) {
+    // Null-terminate this string to force it to end, then extract preset name from next char
+    *presetSeparator = '\0';
+    strncpy(presetNameBuffer->data, presetSeparator + 1, strlen(presetSeparator + 1));
+  }
+
+  // Find preset for this plugin (if given)
+  preset = NULL;
+  if(strlen(presetNameBuffer->data) > 0) {
+    logInfo("Opening preset '%s' for plugin", presetNameBuffer->data);
+    preset = pluginPresetFactory(presetNameBuffer);
+  }
+
+  // Guess the plugin type from the file extension, search root, etc.
+  plugin = pluginFactory(pluginNameBuffer, userSearchPath);
+  if(plugin != NULL) {
+    if(!pluginChainAppend(pluginChain, plugin, preset)) {
+      logError("Plugin '%s' could not be added to the chain", pluginNameBuffer->data);
+      freeCharString(pluginNameBuffer);
+      freeCharString(presetNameBuffer);
+      return false;
+    }
+  }
+
+  freeCharString(pluginNameBuffer);
+  freeCharString(presetNameBuffer);
+  return true;
+}
+
+static boolByte _pluginChainAddGraphFromArgumentString(PluginChain pluginChain, const CharString argumentString,
+  const CharString userSearchPath) {
+  LinkedListIterator iterator;
+  CharString pluginArgument;
+
+  pluginChain->graph = newPluginGraphWithString(argumentString);
+  if(pluginChain->graph == NULL) {
+    return false;
+  }
+  for(iterator = pluginChain->graph->pluginArguments; iterator != NULL && iterator->item != NULL;
+    iterator = iterator->nextItem) {
+    pluginArgument = (CharString)iterator->item;
+    if(!_pluginChainAddFromPluginArgument(pluginChain, pluginArgument->data, strlen(pluginArgument->data),
+      userSearchPath)) {
+      return false;
+    }
+  }
+
+  // The graph refers to the plugins by index, so none of them may be missing
+  if(pluginChain->numPlugins != pluginGraphGetNumPlugins(pluginChain->graph)) {
+    logError("Not all plugins in the plugin graph could be loaded");
+    return false;
+  }
+  return true;
+}
+
 boolByte pluginChainAddFromArgumentString(PluginChain pluginChain, const CharString argumentString, const CharString userSearchPath) {
   // Expect a semicolon-separated string of plugins with comma separators for preset names
   // Example: plugin1,preset1name;plugin2,preset2name
   char* substringStart;
   char* pluginSeparator;
   char* endChar;
-  CharString pluginNameBuffer = NULL;
-  CharString presetNameBuffer = NULL;
-  char* presetSeparator;
-  PluginPreset preset;
-  Plugin plugin;
   size_t substringLength;
 
   if(charStringIsEmpty(argumentString)) {
     logWarn("Plugin chain string is empty");
     return false;
   }
+  else if(pluginGraphIsGraphString(argumentString)) {
+    if(pluginChain->numPlugins > 0 || pluginChain->graph != NULL) {
+      logError("Plugin graphs cannot be combined with other plugins");
+      return false;
+    }
+    return _pluginChainAddGraphFromArgumentString(pluginChain, argumentString, userSearchPath);
+  }
+  else if(pluginChain->graph != NULL) {
+    logError("Plugin graphs cannot be combined with other plugins");
+    return false;
+  }
+
   substringStart = argumentString->data;
   pluginSeparator = strchr(argumentString->data, CHAIN_STRING_PLUGIN_SEPARATOR);
   endChar = argumentString->data + strlen(argumentString->data);
 
   do {
     if(pluginSeparator == NULL) {
-      substringLength = strlen(argumentString->data);
+      substringLength = strlen(substringStart);
     }
     else {
       substringLength = pluginSeparator - substringStart;
     }
-    pluginNameBuffer = newCharString();
-    strncpy(pluginNameBuffer->data, substringStart, substringLength);
-
-    // Look for the separator for presets to load into these plugins
-    presetNameBuffer = newCharString();
-    presetSeparator = strchr(pluginNameBuffer->data, CHAIN_STRING_PROGRAM_SEPARATOR);
-    if(presetSeparator != NULL) {
-      // Null-terminate this string to force it to end, then extract preset name from next char
-      *presetSeparator = '\0';
-      strncpy(presetNameBuffer->data, presetSeparator + 1, strlen(presetSeparator + 1));
-    }
-
-    // Find preset for this plugin (if given)
-    preset = NULL;
-    if(strlen(presetNameBuffer->data) > 0) {
-      logInfo("Opening preset '%s' for plugin", presetNameBuffer->data);
-      preset = pluginPresetFactory(presetNameBuffer);
-    }
-
-    // Guess the plugin type from the file extension, search root, etc.
-    plugin = pluginFactory(pluginNameBuffer, userSearchPath);
-    if(plugin != NULL) {
-      if(!pluginChainAppend(pluginChain, plugin, preset)) {
-        logError("Plugin '%s' could not be added to the chain", pluginNameBuffer->data);
-        free(pluginNameBuffer);
-        free(presetNameBuffer);
-        return false;
-      }
+    if(!_pluginChainAddFromPluginArgument(pluginChain, substringStart, substringLength, userSearchPath)) {
+      return false;
     }
 
     if(pluginSeparator == NULL) {
@@ -139,8 +235,6 @@ boolByte pluginChainAddFromArgumentString(PluginChain pluginChain, const CharStr
     }
   } while(substringStart < endChar);
 
-  freeCharString(pluginNameBuffer);
-  freeCharString(presetNameBuffer);
   return true;
 }
 
@@ -163,6 +257,40 @@ static boolByte _loadPresetForPlugin(Plugin plugin, PluginPreset preset) {
   }
 }
 
+static void _saveInitialParameters(PluginChain self, unsigned int pluginIndex) {
+  Plugin plugin = self->plugins[pluginIndex];
+  int numParameters = plugin->getSetting(plugin, PLUGIN_NUM_PARAMETERS);
+  unsigned int i;
+
+  free(self->_initialParameters[pluginIndex]);
+  self->_initialParameters[pluginIndex] = NULL;
+  self->_numInitialParameters[pluginIndex] = 0;
+  if(numParameters <= 0) {
+    return;
+  }
+
+  self->_initialParameters[pluginIndex] = (float*)malloc(sizeof(float) * numParameters);
+  self->_numInitialParameters[pluginIndex] = (unsigned int)numParameters;
+  for(i = 0; i < (unsigned int)numParameters; i++) {
+    self->_initialParameters[pluginIndex][i] = plugin->getParameter(plugin, i);
+  }
+}
+
+static void _restoreInitialParameters(PluginChain self, unsigned int pluginIndex) {
+  Plugin plugin = self->plugins[pluginIndex];
+  float* initialParameters = self->_initialParameters[pluginIndex];
+  unsigned int i;
+
+  // Only parameters which were changed are set, since plugins may need to do
+  // some work (and we log something) for each parameter set
+  for(i = 0; i < self->_numInitialParameters[pluginIndex]; i++) {
+    if(plugin->getParameter(plugin, i) != initialParameters[i]) {
+      logDebug("Restoring parameter %d of plugin '%s'", i, plugin->pluginName->data);
+      plugin->setParameter(plugin, i, initialParameters[i]);
+    }
+  }
+}
+
 ReturnCodes pluginChainInitialize(PluginChain pluginChain) {
   Plugin plugin;
   PluginPreset preset;
@@ -174,7 +302,8 @@ ReturnCodes pluginChainInitialize(PluginChain pluginChain) {
       return RETURN_CODE_PLUGIN_ERROR;
     }
     else {
-      if(i > 0 && plugin->pluginType == PLUGIN_TYPE_INSTRUMENT) {
+      if(plugin->pluginType == PLUGIN_TYPE_INSTRUMENT &&
+        (i > 0 || (pluginChain->graph != NULL && !pluginGraphIsHeadPlugin(pluginChain->graph, i)))) {
         logError("Instrument plugin '%s' must be first in the chain", plugin->pluginName->data);
         return RETURN_CODE_INVALID_PLUGIN_CHAIN;
       }
@@ -193,12 +322,38 @@ ReturnCodes pluginChainInitialize(PluginChain pluginChain) {
           return RETURN_CODE_INVALID_ARGUMENT;
         }
       }
+      _saveInitialParameters(pluginChain, i);
     }
   }
 
   return RETURN_CODE_SUCCESS;
 }
 
+boolByte pluginChainReset(PluginChain self) {
+  Plugin plugin;
+  PluginPreset preset;
+  unsigned int i;
+
+  // Blocks which are still in the pipeline belong to the previous render
+  if(self->pipeline != NULL) {
+    pluginPipelineStop(self->pipeline);
+  }
+  for(i = 0; i < self->numPlugins; i++) {
+    plugin = self->plugins[i];
+    logDebug("Resetting plugin '%s'", plugin->pluginName->data);
+    plugin->suspend(plugin);
+    preset = self->presets[i];
+    if(preset != NULL) {
+      if(!_loadPresetForPlugin(plugin, preset)) {
+        return false;
+      }
+    }
+    _restoreInitialParameters(self, i);
+  }
+
+  return true;
+}
+
 void pluginChainInspect(PluginChain pluginChain) {
   Plugin plugin;
   unsigned int i;
@@ -208,6 +363,103 @@ void pluginChainInspect(PluginChain pluginChain) {
   }
 }
 
+void pluginChainSetMidiEventSplitting(PluginChain self, boolByte splitMidiEvents) {
+  self->_splitMidiEvents = splitMidiEvents;
+  if(splitMidiEvents && self->_pendingMidiEvents == NULL) {
+    self->_pendingMidiEvents = newLinkedListWithCapacity(SPLIT_MIDI_EVENTS_CAPACITY);
+    self->_chunkMidiEvents = newLinkedListWithCapacity(SPLIT_MIDI_EVENTS_CAPACITY);
+  }
+}
+
+boolByte pluginChainSetPipelineStages(PluginChain self, unsigned int maxNumStages) {
+  if(self->graph != NULL) {
+    logError("Plugin graphs can't be processed in pipeline stages");
+    return false;
+  }
+  else if(maxNumStages < 1) {
+    logError("Plugin pipeline needs at least one stage");
+    return false;
+  }
+
+  freePluginPipeline(self->pipeline);
+  self->pipeline = NULL;
+  if(maxNumStages > 1 && self->numPlugins > 1) {
+    self->pipeline = newPluginPipeline(maxNumStages, self->numPlugins);
+    logInfo("Processing plugins in %d pipeline stages, adding %lu frames of delay",
+      self->pipeline->numStages, pluginPipelineGetDelay(self->pipeline));
+  }
+  return true;
+}
+
+boolByte pluginChainAddTap(PluginChain self, PluginTap tap) {
+  Plugin plugin;
+  unsigned long skipHeadFrames = 0;
+  unsigned int i;
+
+  if(tap->pluginIndex >= self->numPlugins) {
+    logError("Tap refers to plugin %d, but the chain only has %d plugins", tap->pluginIndex, self->numPlugins);
+    return false;
+  }
+  if(self->graph != NULL) {
+    skipHeadFrames = pluginGraphGetProcessingDelayAtPlugin(self->graph, self->plugins, tap->pluginIndex);
+  }
+  else {
+    for(i = 0; i <= tap->pluginIndex; i++) {
+      plugin = self->plugins[i];
+      skipHeadFrames += plugin->getSetting(plugin, PLUGIN_INITIAL_DELAY);
+    }
+  }
+  if(!pluginTapOpen(tap, skipHeadFrames)) {
+    return false;
+  }
+
+  plugin = self->plugins[tap->pluginIndex];
+  logInfo("Tapping output of plugin '%s' to '%s', skipping %lu frames of delay",
+    plugin->pluginName->data, tap->outputSource->sourceName->data, skipHeadFrames);
+  linkedListAppend(self->taps, tap);
+  return true;
+}
+
+/**
+ * Look up the number of inputs and outputs of each plugin and allocate the
+ * buffers used for processing. Plugins in series share two buffers with
+ * enough channels for any plugin in the chain, while plugins in a graph or a
+ * pipeline need buffers of their own since they may run at the same time.
+ */
+static void _pluginChainPrepareBuffers(PluginChain self) {
+  Plugin plugin;
+  unsigned int numChannels = getNumChannels();
+  unsigned int i;
+
+  for(i = 0; i < self->numPlugins; i++) {
+    plugin = self->plugins[i];
+    self->_numInputs[i] = (unsigned int)plugin->getSetting(plugin, PLUGIN_NUM_INPUTS);
+    self->_numOutputs[i] = (unsigned int)plugin->getSetting(plugin, PLUGIN_NUM_OUTPUTS);
+    if(self->_numInputs[i] > numChannels) {
+      numChannels = self->_numInputs[i];
+    }
+    if(self->_numOutputs[i] > numChannels) {
+      numChannels = self->_numOutputs[i];
+    }
+
+    freeSampleBuffer(plugin->inputBuffer);
+    freeSampleBuffer(plugin->outputBuffer);
+    plugin->inputBuffer = NULL;
+    plugin->outputBuffer = NULL;
+    if(self->graph != NULL || self->pipeline != NULL) {
+      plugin->inputBuffer = newSampleBuffer(self->_numInputs[i], getBlocksize());
+      plugin->outputBuffer = newSampleBuffer(self->_numOutputs[i], getBlocksize());
+    }
+  }
+
+  freeSampleBuffer(self->_pingPongBuffers[0]);
+  freeSampleBuffer(self->_pingPongBuffers[1]);
+  freeSampleBuffer(self->_channelMapBuffer);
+  self->_pingPongBuffers[0] = newSampleBuffer(numChannels, getBlocksize());
+  self->_pingPongBuffers[1] = newSampleBuffer(numChannels, getBlocksize());
+  self->_channelMapBuffer = newSampleBuffer(numChannels, getBlocksize());
+}
+
 void pluginChainPrepareForProcessing(PluginChain self) {
   Plugin plugin;
   unsigned int i;
@@ -215,6 +467,25 @@ void pluginChainPrepareForProcessing(PluginChain self) {
     plugin = self->plugins[i];
     plugin->prepareForProcessing(plugin);
   }
+  _pluginChainPrepareBuffers(self);
+
+  if(self->_splitMidiEvents && self->numPlugins > 0) {
+    plugin = self->plugins[0];
+    logDebug("Splitting blocks at MIDI events for plugin '%s'", plugin->pluginName->data);
+    freeSampleBuffer(self->_headInputChunk);
+    freeSampleBuffer(self->_headOutputChunk);
+    self->_headInputChunk = newSampleBuffer(self->_numInputs[0], getBlocksize());
+    self->_headOutputChunk = newSampleBuffer(self->_numOutputs[0], getBlocksize());
+    linkedListClear(self->_pendingMidiEvents);
+    self->_nextPendingMidiEvent = NULL;
+  }
+
+  if(self->graph != NULL) {
+    pluginGraphPrepare(self->graph, self->plugins, _pluginChainProcessPlugin, self);
+  }
+  if(self->pipeline != NULL) {
+    pluginPipelinePrepare(self->pipeline, self->plugins, _pluginChainProcessPlugin, self);
+  }
 }
 
 int pluginChainGetMaximumTailTimeInMs(PluginChain pluginChain) {
@@ -235,10 +506,16 @@ int pluginChainGetMaximumTailTimeInMs(PluginChain pluginChain) {
 unsigned long pluginChainGetProcessingDelay(PluginChain self) {
   unsigned long processingDelay = 0;
   unsigned int i;
+  if(self->graph != NULL) {
+    return pluginGraphGetProcessingDelay(self->graph, self->plugins);
+  }
   for(i = 0; i < self->numPlugins; i++) {
     Plugin plugin = self->plugins[i];
     processingDelay += plugin->getSetting(plugin, PLUGIN_INITIAL_DELAY);
   }
+  if(self->pipeline != NULL) {
+    processingDelay += pluginPipelineGetDelay(self->pipeline);
+  }
   return processingDelay;
 }
 
@@ -264,12 +541,13 @@ void _pluginChainSetParameter(void* item, void* userData) {
   }
 
   // TODO: Need a "pair" type, this string parsing is done several times in the codebase
+  // Note that the string is not modified here, so that the same parameter list
+  // can be applied more than once (ie, in batch mode).
   comma = strchr(parameterValue, ',');
   if(comma == NULL) {
     logError("Malformed parameter string, see --help parameter for usage");
     return;
   }
-  *comma = '\0';
   index = (int)strtod(parameterValue, NULL);
   value = (float)strtod(comma + 1, NULL);
   logDebug("Set parameter %d to %f", index, value);
@@ -286,66 +564,207 @@ boolByte pluginChainSetParameters(PluginChain self, const LinkedList parameters)
 }
 
 void pluginChainSetRealtime(PluginChain self, boolByte realtime) {
-  self->_realtime = realtime;
-  if(realtime) {
-    self->_realtimeTimer = newTaskTimerWithCString("PluginChain", "Realtime");
+  if(realtime && self->realtimeScheduler == NULL) {
+    self->realtimeScheduler = newRealtimeScheduler();
   }
-  else if(self->_realtimeTimer) {
-    freeTaskTimer(self->_realtimeTimer);
+  else if(!realtime && self->realtimeScheduler != NULL) {
+    freeRealtimeScheduler(self->realtimeScheduler);
+    self->realtimeScheduler = NULL;
   }
 }
 
-void pluginChainProcessAudio(PluginChain pluginChain, SampleBuffer inBuffer, SampleBuffer outBuffer) {
-  Plugin plugin;
-  unsigned int i;
+/**
+ * Process a block with the head plugin in pieces, sending the pending MIDI
+ * events right before the piece which starts at their timestamp. The block
+ * starts at the audio clock's current frame, and events after the end of the
+ * block are kept for the next call.
+ */
+static void _pluginChainProcessHeadPluginWithMidi(PluginChain self, Plugin plugin,
+  SampleBuffer inBuffer, SampleBuffer outBuffer) {
+  const unsigned long blockStartFrame = getAudioClock()->currentFrame;
+  const unsigned long blocksize = inBuffer->blocksize;
+  unsigned long offset = 0;
+  unsigned long nextOffset;
+  LinkedListIterator iterator;
+  MidiEvent midiEvent;
+
+  while(offset < blocksize) {
+    linkedListClear(self->_chunkMidiEvents);
+    iterator = self->_nextPendingMidiEvent;
+    while(iterator != NULL && iterator->item != NULL) {
+      midiEvent = (MidiEvent)iterator->item;
+      if(midiEvent->timestamp > blockStartFrame + offset) {
+        break;
+      }
+      midiEvent->deltaFrames = 0;
+      linkedListAppend(self->_chunkMidiEvents, midiEvent);
+      iterator = (LinkedListIterator)iterator->nextItem;
+    }
+    self->_nextPendingMidiEvent = iterator;
+
+    nextOffset = blocksize;
+    if(iterator != NULL && iterator->item != NULL) {
+      midiEvent = (MidiEvent)iterator->item;
+      if(midiEvent->timestamp < blockStartFrame + blocksize) {
+        nextOffset = midiEvent->timestamp - blockStartFrame;
+      }
+    }
+
+    if(linkedListLength(self->_chunkMidiEvents) > 0) {
+      taskTimerStart(self->midiTimers[0]);
+      plugin->processMidiEvents(plugin, self->_chunkMidiEvents);
+      taskTimerStop(self->midiTimers[0]);
+    }
+
+    if(offset == 0 && nextOffset == blocksize) {
+      plugin->processAudio(plugin, inBuffer, outBuffer);
+      return;
+    }
+    self->_headInputChunk->blocksize = nextOffset - offset;
+    self->_headOutputChunk->blocksize = nextOffset - offset;
+    sampleBufferCopyAndMapChannelsWithOffset(self->_headInputChunk, 0, inBuffer, offset, nextOffset - offset);
+    plugin->processAudio(plugin, self->_headInputChunk, self->_headOutputChunk);
+    sampleBufferCopyAndMapChannelsWithOffset(outBuffer, offset, self->_headOutputChunk, 0, nextOffset - offset);
+    offset = nextOffset;
+  }
+}
+
+static void _pluginChainProcessTaps(PluginChain pluginChain, unsigned int pluginIndex, SampleBuffer buffer) {
+  LinkedListIterator iterator;
+  PluginTap tap;
+  for(iterator = pluginChain->taps; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    tap = (PluginTap)iterator->item;
+    if(tap->pluginIndex == pluginIndex) {
+      pluginTapProcessAudio(tap, buffer);
+    }
+  }
+}
+
+/**
+ * Process a block with a single plugin. The input is given to the plugin as-is
+ * if it has as many channels as the plugin has inputs, otherwise it is mapped
+ * into mapBuffer first. The output buffer is set to the plugin's number of
+ * outputs, so it must have been allocated with at least that many channels.
+ */
+static void _pluginChainRunPlugin(PluginChain pluginChain, unsigned int pluginIndex, SampleBuffer inBuffer,
+  SampleBuffer outBuffer, SampleBuffer mapBuffer) {
+  Plugin plugin = pluginChain->plugins[pluginIndex];
   double processingTimeInMs;
-  double totalProcessingTimeInMs;
   const double maxProcessingTimeInMs = inBuffer->blocksize * 1000.0 / getSampleRate();
 
-  if(pluginChain->_realtime) {
-    taskTimerStart(pluginChain->_realtimeTimer);
+  logDebug("Processing audio with plugin '%s'", plugin->pluginName->data);
+  if(inBuffer->numChannels != pluginChain->_numInputs[pluginIndex]) {
+    mapBuffer->numChannels = pluginChain->_numInputs[pluginIndex];
+    mapBuffer->blocksize = inBuffer->blocksize;
+    sampleBufferCopyAndMapChannels(mapBuffer, inBuffer);
+    inBuffer = mapBuffer;
+  }
+  outBuffer->numChannels = pluginChain->_numOutputs[pluginIndex];
+  outBuffer->blocksize = inBuffer->blocksize;
+  taskTimerStart(pluginChain->audioTimers[pluginIndex]);
+  if(pluginIndex == 0 && pluginChain->_nextPendingMidiEvent != NULL) {
+    _pluginChainProcessHeadPluginWithMidi(pluginChain, plugin, inBuffer, outBuffer);
+  }
+  else {
+    plugin->processAudio(plugin, inBuffer, outBuffer);
+  }
+  processingTimeInMs = taskTimerStop(pluginChain->audioTimers[pluginIndex]);
+  if(pluginChain->taps->item != NULL) {
+    _pluginChainProcessTaps(pluginChain, pluginIndex, outBuffer);
+  }
+  if(processingTimeInMs > maxProcessingTimeInMs) {
+    logWarn("Possible dropout! Plugin '%s' spent %dms processing time (%dms max)",
+      plugin->pluginName->data, (int)processingTimeInMs, (int)maxProcessingTimeInMs);
   }
+  else {
+    logDebug("Plugin '%s' spent %dms processing (%d%% effective CPU usage)",
+      plugin->pluginName->data, (int)processingTimeInMs,
+      (int)(processingTimeInMs / maxProcessingTimeInMs));
+  }
+}
 
-  SampleBuffer formerOutputBuffer = inBuffer;
-  SampleBuffer nextInputBuffer = NULL;
+// Used by the graph and the pipeline, which may process several plugins at the
+// same time, so each plugin uses its own buffers
+static SampleBuffer _pluginChainProcessPlugin(void* userData, unsigned int pluginIndex, SampleBuffer inBuffer) {
+  PluginChain pluginChain = (PluginChain)userData;
+  Plugin plugin = pluginChain->plugins[pluginIndex];
+  _pluginChainRunPlugin(pluginChain, pluginIndex, inBuffer, plugin->outputBuffer, plugin->inputBuffer);
+  return plugin->outputBuffer;
+}
+
+/**
+ * Process the plugins one after another. Each plugin reads the previous
+ * plugin's output and writes to the other one of two shared buffers, and the
+ * last plugin writes straight to outBuffer when it has the right number of
+ * channels, so that blocks are only copied where the channel layout changes.
+ * @return False if the result still needs to be copied from the buffer given
+ * in outResult
+ */
+static boolByte _pluginChainProcessSerial(PluginChain pluginChain, SampleBuffer inBuffer, SampleBuffer outBuffer,
+  SampleBuffer* outResult) {
+  SampleBuffer buffer = inBuffer;
+  SampleBuffer nextBuffer;
+  unsigned int i;
 
   for(i = 0; i < pluginChain->numPlugins; i++) {
-    plugin = pluginChain->plugins[i];
-    logDebug("Processing audio with plugin '%s'", plugin->pluginName->data);
-    nextInputBuffer = plugin->inputBuffer;
-    nextInputBuffer->blocksize = formerOutputBuffer->blocksize;
-    sampleBufferCopyAndMapChannels(nextInputBuffer, formerOutputBuffer);
-    plugin->outputBuffer->blocksize = plugin->inputBuffer->blocksize;
-    taskTimerStart(pluginChain->audioTimers[i]);
-    plugin->processAudio(plugin, plugin->inputBuffer, plugin->outputBuffer);
-    processingTimeInMs = taskTimerStop(pluginChain->audioTimers[i]);
-    if(processingTimeInMs > maxProcessingTimeInMs) {
-      logWarn("Possible dropout! Plugin '%s' spent %dms processing time (%dms max)",
-        plugin->pluginName->data, (int)processingTimeInMs, (int)maxProcessingTimeInMs);
+    if(i + 1 == pluginChain->numPlugins && outBuffer != buffer &&
+      outBuffer->numChannels == pluginChain->_numOutputs[i]) {
+      nextBuffer = outBuffer;
     }
     else {
-      logDebug("Plugin '%s' spent %dms processing (%d%% effective CPU usage)",
-        plugin->pluginName->data, (int)processingTimeInMs,
-        (int)(processingTimeInMs / maxProcessingTimeInMs));
+      nextBuffer = (buffer == pluginChain->_pingPongBuffers[0]) ?
+        pluginChain->_pingPongBuffers[1] : pluginChain->_pingPongBuffers[0];
     }
-    
-    formerOutputBuffer = plugin->outputBuffer;
+    _pluginChainRunPlugin(pluginChain, i, buffer, nextBuffer, pluginChain->_channelMapBuffer);
+    buffer = nextBuffer;
   }
-  nextInputBuffer = outBuffer;
-  nextInputBuffer->blocksize = formerOutputBuffer->blocksize;
-  sampleBufferCopyAndMapChannels(nextInputBuffer, formerOutputBuffer);
 
-  if(pluginChain->_realtime) {
-    totalProcessingTimeInMs = taskTimerStop(pluginChain->_realtimeTimer);
-    if(totalProcessingTimeInMs < maxProcessingTimeInMs) {
-      sleepMilliseconds(maxProcessingTimeInMs - totalProcessingTimeInMs);
-    }
+  *outResult = buffer;
+  return (boolByte)(buffer == outBuffer);
+}
+
+void pluginChainProcessAudio(PluginChain pluginChain, SampleBuffer inBuffer, SampleBuffer outBuffer) {
+  const double maxProcessingTimeInMs = inBuffer->blocksize * 1000.0 / getSampleRate();
+  SampleBuffer formerOutputBuffer = inBuffer;
+
+  if(pluginChain->_pingPongBuffers[0] == NULL) {
+    // Chains which were never prepared (mostly in tests) still need their buffers
+    _pluginChainPrepareBuffers(pluginChain);
+  }
+
+  if(pluginChain->graph != NULL) {
+    formerOutputBuffer = pluginGraphProcessAudio(pluginChain->graph, inBuffer);
+  }
+  else if(pluginChain->pipeline != NULL) {
+    pluginPipelineProcessAudio(pluginChain->pipeline, inBuffer, outBuffer);
+    formerOutputBuffer = NULL;
+  }
+  else if(_pluginChainProcessSerial(pluginChain, inBuffer, outBuffer, &formerOutputBuffer)) {
+    formerOutputBuffer = NULL;
+  }
+  if(formerOutputBuffer != NULL) {
+    outBuffer->blocksize = formerOutputBuffer->blocksize;
+    sampleBufferCopyAndMapChannels(outBuffer, formerOutputBuffer);
+  }
+
+  if(pluginChain->realtimeScheduler != NULL) {
+    realtimeSchedulerWaitForBlock(pluginChain->realtimeScheduler, maxProcessingTimeInMs);
   }
 }
 
 void pluginChainProcessMidi(PluginChain pluginChain, LinkedList midiEvents) {
   Plugin plugin;
+  LinkedListIterator iterator;
   if(midiEvents->item != NULL) {
+    if(pluginChain->_splitMidiEvents) {
+      // Sent to the head plugin during pluginChainProcessAudio()
+      linkedListClear(pluginChain->_pendingMidiEvents);
+      for(iterator = midiEvents; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+        linkedListAppend(pluginChain->_pendingMidiEvents, iterator->item);
+      }
+      pluginChain->_nextPendingMidiEvent = pluginChain->_pendingMidiEvents;
+      return;
+    }
     logDebug("Processing plugin chain MIDI events");
     // Right now, we only process MIDI in the first plugin in the chain
     // TODO: Is this really the correct behavior? How do other sequencers do it?
@@ -359,6 +778,9 @@ void pluginChainProcessMidi(PluginChain pluginChain, LinkedList midiEvents) {
 void pluginChainShutdown(PluginChain pluginChain) {
   Plugin plugin;
   unsigned int i;
+  if(pluginChain->pipeline != NULL) {
+    pluginPipelineStop(pluginChain->pipeline);
+  }
   for(i = 0; i < pluginChain->numPlugins; i++) {
     plugin = pluginChain->plugins[i];
     logInfo("Closing plugin '%s'", plugin->pluginName->data);
@@ -367,13 +789,22 @@ void pluginChainShutdown(PluginChain pluginChain) {
 }
 
 void freePluginChain(PluginChain pluginChain) {
+  PluginChain* instance = _getPluginChainInstance();
   unsigned int i;
 
+  if(*instance == pluginChain) {
+    *instance = NULL;
+  }
+
+  // Stops the graph's and pipeline's threads before the plugins go away
+  freePluginGraph(pluginChain->graph);
+  freePluginPipeline(pluginChain->pipeline);
   for(i = 0; i < pluginChain->numPlugins; i++) {
     freePluginPreset(pluginChain->presets[i]);
     freePlugin(pluginChain->plugins[i]);
     freeTaskTimer(pluginChain->audioTimers[i]);
     freeTaskTimer(pluginChain->midiTimers[i]);
+    free(pluginChain->_initialParameters[i]);
   }
 
   free(pluginChain->presets);
@@ -381,9 +812,19 @@ void freePluginChain(PluginChain pluginChain) {
   free(pluginChain->audioTimers);
   free(pluginChain->midiTimers);
 
-  if(pluginChain->_realtime) {
-    freeTaskTimer(pluginChain->_realtimeTimer);
-  }
+  freeRealtimeScheduler(pluginChain->realtimeScheduler);
+  freeLinkedListAndItems(pluginChain->taps, (LinkedListFreeItemFunc)freePluginTap);
+  freeLinkedList(pluginChain->_pendingMidiEvents);
+  freeLinkedList(pluginChain->_chunkMidiEvents);
+  freeSampleBuffer(pluginChain->_headInputChunk);
+  freeSampleBuffer(pluginChain->_headOutputChunk);
+  freeSampleBuffer(pluginChain->_pingPongBuffers[0]);
+  freeSampleBuffer(pluginChain->_pingPongBuffers[1]);
+  freeSampleBuffer(pluginChain->_channelMapBuffer);
+  free(pluginChain->_numInputs);
+  free(pluginChain->_numOutputs);
+  free(pluginChain->_initialParameters);
+  free(pluginChain->_numInitialParameters);
 
   free(pluginChain);
 }
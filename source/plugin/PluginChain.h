@@ -31,12 +31,18 @@
 #include "app/ReturnCodes.h"
 #include "base/LinkedList.h"
 #include "plugin/Plugin.h"
+#include "plugin/PluginGraph.h"
+#include "plugin/PluginPipeline.h"
 #include "plugin/PluginPreset.h"
+#include "plugin/PluginTap.h"
+#include "time/RealtimeScheduler.h"
 #include "time/TaskTimer.h"
 
 #define MAX_PLUGINS 8
 #define CHAIN_STRING_PLUGIN_SEPARATOR ';'
 #define CHAIN_STRING_PROGRAM_SEPARATOR ','
+// Separates alternative chains which render the same input to different outputs
+#define CHAIN_STRING_ALTERNATIVE_SEPARATOR '|'
 
 typedef struct {
   unsigned int numPlugins;
@@ -44,27 +50,64 @@ typedef struct {
   PluginPreset* presets;
   TaskTimer* audioTimers;
   TaskTimer* midiTimers;
+  // Paces processing in realtime mode, NULL otherwise
+  RealtimeScheduler realtimeScheduler;
+  // List of PluginTap objects which write the output of single plugins
+  LinkedList taps;
+  // Connections between the plugins when they are not processed in series,
+  // NULL for simple chains
+  PluginGraph graph;
+  // Processes the plugins on several threads, NULL when they are all processed
+  // on the calling thread
+  PluginPipeline pipeline;
 
   // Private fields
-  boolByte _realtime;
-  TaskTimer _realtimeTimer;
+  boolByte _splitMidiEvents;
+  // MIDI events for the current block which have not yet been sent to the
+  // head plugin, only used when splitting at MIDI events
+  LinkedList _pendingMidiEvents;
+  LinkedListIterator _nextPendingMidiEvent;
+  LinkedList _chunkMidiEvents;
+  SampleBuffer _headInputChunk;
+  SampleBuffer _headOutputChunk;
+  // Number of inputs and outputs of each plugin, set when preparing
+  unsigned int* _numInputs;
+  unsigned int* _numOutputs;
+  // Parameter values of each plugin after it was initialized, which are
+  // restored when the chain is reset
+  float** _initialParameters;
+  unsigned int* _numInitialParameters;
+  // Shared by the plugins when they are processed in series. Their channel
+  // count is set to that of the plugin using them, and may be less than the
+  // number of channels allocated.
+  SampleBuffer _pingPongBuffers[2];
+  SampleBuffer _channelMapBuffer;
 } PluginChainMembers;
 
 /**
- * Class which holds multiple plugins which process audio in serial. Only one
- * instrument may be present in a plugin chain.
+ * Class which holds multiple plugins which process audio in serial, or in
+ * parallel branches when the chain was created from a graph (see
+ * PluginGraph.h). Only one instrument may be present in a plugin chain.
  */
 typedef PluginChainMembers* PluginChain;
 
 /**
- * Get a reference to the global plugin chain instance.
- * @return Reference to global plugin chain, or NULL if the global instance has
- * not yet been initialized.
+ * Get a reference to the plugin chain of the current EngineContext, or the
+ * global instance if no context is current on the calling thread.
+ * @return Reference to the plugin chain, or NULL if it has not yet been
+ * initialized.
  */
 PluginChain getPluginChain(void);
 
 /**
- * Initialize the global plugin chain instance. Should be called fairly
+ * Create a new, empty plugin chain. This is mostly used by EngineContext, other
+ * code should use getPluginChain().
+ * @return Initialized PluginChain
+ */
+PluginChain newPluginChain(void);
+
+/**
+ * Initialize the current plugin chain instance. Should be called fairly
  * early in the program initialization.
  */
 void initPluginChain(void);
@@ -80,6 +123,7 @@ void initPluginChain(void);
 boolByte pluginChainAppend(PluginChain self, Plugin plugin, PluginPreset preset);
 
 // TODO: Deprecate and remove this function
+// Arguments containing groups in square brackets are parsed as a PluginGraph.
 boolByte pluginChainAddFromArgumentString(PluginChain self, const CharString argumentString, const CharString userSearchPath);
 
 /**
@@ -89,6 +133,17 @@ boolByte pluginChainAddFromArgumentString(PluginChain self, const CharString arg
  */
 ReturnCodes pluginChainInitialize(PluginChain self);
 
+/**
+ * Suspend all plugins in the chain so that they discard any internal state, and
+ * reload their presets. Parameters which have changed since the chain was
+ * initialized, for instance with pluginChainSetParameters(), are set back to
+ * their initial values. pluginChainPrepareForProcessing() must be called again
+ * before the chain processes more audio.
+ * @param self
+ * @return True if all presets could be reloaded
+ */
+boolByte pluginChainReset(PluginChain self);
+
 /**
  * Inspect each plugin in the chain
  * @param self
@@ -121,12 +176,51 @@ boolByte pluginChainSetParameters(PluginChain self, const LinkedList parameters)
 
 /**
  * Set realtime mode for the plugin chain. When set, calls to pluginChainProcessAudio()
- * will sleep for the additional time required to process the block in realtime.
+ * will sleep until the block's deadline in a realtime stream, see RealtimeScheduler.h.
  * @param realtime True to enable realtime mode, false to disable (default)
  * @param self
  */
 void pluginChainSetRealtime(PluginChain self, boolByte realtime);
 
+/**
+ * Set MIDI event splitting for the plugin chain. When set, the head plugin
+ * processes each block in pieces which start at the timestamps of the block's
+ * MIDI events, and each event is sent to it right before the piece where it
+ * occurs. This gives sample-accurate timing for instruments which ignore the
+ * deltaFrames of events, while the other plugins still process whole blocks.
+ * Must be called before pluginChainPrepareForProcessing().
+ * @param self
+ * @param splitMidiEvents True to enable splitting, false to disable (default)
+ */
+void pluginChainSetMidiEventSplitting(PluginChain self, boolByte splitMidiEvents);
+
+/**
+ * Process the plugins of the chain on several threads, see PluginPipeline.h.
+ * This adds one block of processing delay for each stage after the first one,
+ * which is included in pluginChainGetProcessingDelay(). Since the stages
+ * process different blocks at the same time, parameters of plugins other than
+ * the first stage's can't be changed in sync with the audio while processing.
+ * Must be called after all plugins have been added, and before
+ * pluginChainPrepareForProcessing().
+ * @param self
+ * @param maxNumStages Maximum number of threads, the plugins are divided evenly
+ * between them. There are never more stages than plugins.
+ * @return False if the chain can't be pipelined
+ */
+boolByte pluginChainSetPipelineStages(PluginChain self, unsigned int maxNumStages);
+
+/**
+ * Add a tap which writes the output of one of the plugins in the chain while
+ * processing. The tap's output is compensated for the processing delay of the
+ * tapped plugin and all plugins before it, so this must be called after the
+ * chain has been initialized. On success, the chain takes ownership of the tap.
+ * @param self
+ * @param tap Tap to add
+ * @return False if the tap refers to a plugin which is not in the chain, or if
+ * its output source could not be opened
+ */
+boolByte pluginChainAddTap(PluginChain self, PluginTap tap);
+
 /**
  * Prepare each plugin in the chain for processing. This should be called before
  * the first block of audio is sent to the chain.
@@ -144,7 +238,9 @@ void pluginChainProcessAudio(PluginChain self, SampleBuffer inBuffer, SampleBuff
 
 /**
  * Send a list of MIDI events to be processed by the chain. Currently, only the
- * first plugin in the chain will receive these events.
+ * first plugin in the chain will receive these events. When splitting at MIDI
+ * events, the events are sent during the following call to
+ * pluginChainProcessAudio() instead, so they must remain valid until then.
  * @param self
  * @param midiEvents List of events to process
  */
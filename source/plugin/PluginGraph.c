@@ -0,0 +1,528 @@
+//
+// PluginGraph.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "app/EngineContext.h"
+#include "audio/AudioSettings.h"
+#include "logging/EventLogger.h"
+#include "plugin/PluginGraph.h"
+
+static void _freePluginGraphBranch(void* item);
+
+static PluginGraphBranch _newPluginGraphBranch(PluginGraph graph) {
+  PluginGraphBranch branch = (PluginGraphBranch)malloc(sizeof(PluginGraphBranchMembers));
+  branch->nodes = newLinkedList();
+  branch->delayInFrames = 0;
+  branch->compensationInFrames = 0;
+  branch->_outputBuffer = NULL;
+  branch->_delayLines = NULL;
+  branch->_delayPosition = 0;
+  branch->_worker = NULL;
+  branch->_graph = graph;
+  branch->_workerInput = NULL;
+  branch->_numRequests = 0;
+  branch->_numFinished = 0;
+  branch->_stopWorker = false;
+  branch->_requestSignal = newThreadSignal();
+  branch->_finishedSignal = NULL;
+  return branch;
+}
+
+static PluginGraphNode _newPluginGraphNode(PluginGraphNodeType type) {
+  PluginGraphNode node = (PluginGraphNode)malloc(sizeof(PluginGraphNodeMembers));
+  node->type = type;
+  node->pluginIndex = 0;
+  node->branches = (type == PLUGIN_GRAPH_NODE_GROUP) ? newLinkedList() : NULL;
+  node->_mixBuffer = NULL;
+  node->_finishedSignal = (type == PLUGIN_GRAPH_NODE_GROUP) ? newThreadSignal() : NULL;
+  return node;
+}
+
+static void _freePluginGraphNode(void* item) {
+  PluginGraphNode node = (PluginGraphNode)item;
+  if(node->branches != NULL) {
+    freeLinkedListAndItems(node->branches, _freePluginGraphBranch);
+  }
+  freeSampleBuffer(node->_mixBuffer);
+  freeThreadSignal(node->_finishedSignal);
+  free(node);
+}
+
+static void _freeDelayLines(PluginGraphBranch branch) {
+  unsigned int i;
+  if(branch->_delayLines != NULL) {
+    for(i = 0; i < branch->_outputBuffer->numChannels; i++) {
+      free(branch->_delayLines[i]);
+    }
+    free(branch->_delayLines);
+    branch->_delayLines = NULL;
+  }
+}
+
+static void _freePluginGraphBranch(void* item) {
+  PluginGraphBranch branch = (PluginGraphBranch)item;
+  freeLinkedListAndItems(branch->nodes, _freePluginGraphNode);
+  _freeDelayLines(branch);
+  freeSampleBuffer(branch->_outputBuffer);
+  freeThreadSignal(branch->_requestSignal);
+  free(branch);
+}
+
+boolByte pluginGraphIsGraphString(const CharString argument) {
+  return (boolByte)(argument != NULL && (strchr(argument->data, PLUGIN_GRAPH_GROUP_START) != NULL ||
+    strchr(argument->data, PLUGIN_GRAPH_GROUP_END) != NULL));
+}
+
+static boolByte _parseBranch(PluginGraph self, PluginGraphBranch branch, const char** position);
+
+// Parses a group, where position points to the character after the opening bracket
+static boolByte _parseGroup(PluginGraph self, PluginGraphNode node, const char** position) {
+  PluginGraphBranch branch;
+
+  while(true) {
+    branch = _newPluginGraphBranch(self);
+    linkedListAppend(node->branches, branch);
+    if(!_parseBranch(self, branch, position)) {
+      return false;
+    }
+
+    if(**position == PLUGIN_GRAPH_BRANCH_SEPARATOR) {
+      (*position)++;
+    }
+    else if(**position == PLUGIN_GRAPH_GROUP_END) {
+      (*position)++;
+      return true;
+    }
+    else {
+      logError("Plugin graph has a group which is not closed with '%c'", PLUGIN_GRAPH_GROUP_END);
+      return false;
+    }
+  }
+}
+
+// Parses nodes separated by semicolons, and stops at the end of the string or
+// at the first character which ends a branch
+static boolByte _parseBranch(PluginGraph self, PluginGraphBranch branch, const char** position) {
+  PluginGraphNode node;
+  CharString pluginArgument;
+  size_t length;
+
+  while(true) {
+    if(**position == PLUGIN_GRAPH_GROUP_START) {
+      (*position)++;
+      node = _newPluginGraphNode(PLUGIN_GRAPH_NODE_GROUP);
+      linkedListAppend(branch->nodes, node);
+      if(!_parseGroup(self, node, position)) {
+        return false;
+      }
+    }
+    else {
+      length = strcspn(*position, ";+[]");
+      if(length > 0) {
+        pluginArgument = newCharStringWithCapacity(length + 1);
+        strncpy(pluginArgument->data, *position, length);
+        node = _newPluginGraphNode(PLUGIN_GRAPH_NODE_PLUGIN);
+        node->pluginIndex = pluginGraphGetNumPlugins(self);
+        linkedListAppend(self->pluginArguments, pluginArgument);
+        linkedListAppend(branch->nodes, node);
+        *position += length;
+      }
+    }
+
+    if(**position == PLUGIN_GRAPH_PLUGIN_SEPARATOR) {
+      (*position)++;
+    }
+    else if(**position == PLUGIN_GRAPH_GROUP_START) {
+      logError("Plugin graph is missing a '%c' before a group", PLUGIN_GRAPH_PLUGIN_SEPARATOR);
+      return false;
+    }
+    else {
+      return true;
+    }
+  }
+}
+
+PluginGraph newPluginGraphWithString(const CharString argument) {
+  PluginGraph graph = (PluginGraph)malloc(sizeof(PluginGraphMembers));
+  const char* position = argument->data;
+
+  graph->root = _newPluginGraphBranch(graph);
+  graph->pluginArguments = newLinkedList();
+  graph->_engineContext = NULL;
+  graph->_processPlugin = NULL;
+  graph->_processPluginUserData = NULL;
+
+  if(!_parseBranch(graph, graph->root, &position)) {
+    freePluginGraph(graph);
+    return NULL;
+  }
+  else if(*position != '\0') {
+    logError("Unexpected '%c' in plugin graph", *position);
+    freePluginGraph(graph);
+    return NULL;
+  }
+  else if(pluginGraphGetNumPlugins(graph) == 0) {
+    logError("Plugin graph does not contain any plugins");
+    freePluginGraph(graph);
+    return NULL;
+  }
+
+  return graph;
+}
+
+unsigned int pluginGraphGetNumPlugins(const PluginGraph self) {
+  return (unsigned int)linkedListLength(self->pluginArguments);
+}
+
+boolByte pluginGraphIsHeadPlugin(const PluginGraph self, unsigned int pluginIndex) {
+  PluginGraphNode node = (PluginGraphNode)self->root->nodes->item;
+  return (boolByte)(node != NULL && node->type == PLUGIN_GRAPH_NODE_PLUGIN && node->pluginIndex == pluginIndex);
+}
+
+static unsigned long _getNodeDelay(PluginGraphNode node, Plugin* plugins);
+
+static unsigned long _getBranchDelay(PluginGraphBranch branch, Plugin* plugins) {
+  LinkedListIterator iterator;
+  unsigned long delay = 0;
+  for(iterator = branch->nodes; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    delay += _getNodeDelay((PluginGraphNode)iterator->item, plugins);
+  }
+  return delay;
+}
+
+static unsigned long _getNodeDelay(PluginGraphNode node, Plugin* plugins) {
+  LinkedListIterator iterator;
+  unsigned long branchDelay;
+  unsigned long maxDelay = 0;
+  Plugin plugin;
+
+  if(node->type == PLUGIN_GRAPH_NODE_PLUGIN) {
+    plugin = plugins[node->pluginIndex];
+    return (unsigned long)plugin->getSetting(plugin, PLUGIN_INITIAL_DELAY);
+  }
+  for(iterator = node->branches; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    branchDelay = _getBranchDelay((PluginGraphBranch)iterator->item, plugins);
+    if(branchDelay > maxDelay) {
+      maxDelay = branchDelay;
+    }
+  }
+  return maxDelay;
+}
+
+unsigned long pluginGraphGetProcessingDelay(const PluginGraph self, Plugin* plugins) {
+  return _getBranchDelay(self->root, plugins);
+}
+
+// Adds the delay up to and including the plugin to outDelay, and returns true
+// if the plugin was found in the branch
+static boolByte _findDelayAtPlugin(PluginGraphBranch branch, Plugin* plugins, unsigned int pluginIndex,
+  unsigned long* outDelay) {
+  LinkedListIterator nodeIterator;
+  LinkedListIterator branchIterator;
+  PluginGraphNode node;
+  unsigned long branchDelay;
+
+  for(nodeIterator = branch->nodes; nodeIterator != NULL && nodeIterator->item != NULL;
+    nodeIterator = nodeIterator->nextItem) {
+    node = (PluginGraphNode)nodeIterator->item;
+    if(node->type == PLUGIN_GRAPH_NODE_GROUP) {
+      for(branchIterator = node->branches; branchIterator != NULL && branchIterator->item != NULL;
+        branchIterator = branchIterator->nextItem) {
+        branchDelay = *outDelay;
+        if(_findDelayAtPlugin((PluginGraphBranch)branchIterator->item, plugins, pluginIndex, &branchDelay)) {
+          *outDelay = branchDelay;
+          return true;
+        }
+      }
+    }
+    *outDelay += _getNodeDelay(node, plugins);
+    if(node->type == PLUGIN_GRAPH_NODE_PLUGIN && node->pluginIndex == pluginIndex) {
+      return true;
+    }
+  }
+  return false;
+}
+
+unsigned long pluginGraphGetProcessingDelayAtPlugin(const PluginGraph self, Plugin* plugins,
+  unsigned int pluginIndex) {
+  unsigned long delay = 0;
+  _findDelayAtPlugin(self->root, plugins, pluginIndex, &delay);
+  return delay;
+}
+
+static SampleBuffer _processBranch(PluginGraphBranch branch, SampleBuffer inBuffer);
+
+/**
+ * Process a branch of a group, and store its delay-compensated output in the
+ * branch's output buffer. This is called from the branch's worker thread, if it
+ * has one.
+ */
+static void _processGroupBranch(PluginGraphBranch branch, SampleBuffer inBuffer) {
+  SampleBuffer result = _processBranch(branch, inBuffer);
+  SampleBuffer outBuffer = branch->_outputBuffer;
+  unsigned long compensation = branch->compensationInFrames;
+  unsigned long position = 0;
+  unsigned long i;
+  unsigned int channel;
+  Sample* delayLine;
+  Sample* samples;
+  Sample sample;
+
+  outBuffer->blocksize = result->blocksize;
+  sampleBufferCopyAndMapChannels(outBuffer, result);
+  if(compensation == 0) {
+    return;
+  }
+
+  for(channel = 0; channel < outBuffer->numChannels; channel++) {
+    delayLine = branch->_delayLines[channel];
+    samples = outBuffer->samples[channel];
+    position = branch->_delayPosition;
+    for(i = 0; i < outBuffer->blocksize; i++) {
+      sample = delayLine[position];
+      delayLine[position] = samples[i];
+      samples[i] = sample;
+      if(++position == compensation) {
+        position = 0;
+      }
+    }
+  }
+  branch->_delayPosition = position;
+}
+
+static void* _branchWorkerThread(void* userData) {
+  PluginGraphBranch branch = (PluginGraphBranch)userData;
+  unsigned long generation;
+
+  if(branch->_graph->_engineContext != NULL) {
+    engineContextMakeCurrent((EngineContext)branch->_graph->_engineContext);
+  }
+
+  while(true) {
+    for(;;) {
+      generation = threadSignalGetGeneration(branch->_requestSignal);
+      if(branch->_stopWorker) {
+        return NULL;
+      }
+      if(branch->_numRequests != branch->_numFinished) {
+        break;
+      }
+      threadSignalWait(branch->_requestSignal, generation);
+    }
+    threadMemoryBarrier();
+    _processGroupBranch(branch, branch->_workerInput);
+    // The output must be visible before the group sees that the branch is done
+    threadMemoryBarrier();
+    branch->_numFinished++;
+    threadSignalNotify(branch->_finishedSignal);
+  }
+}
+
+static SampleBuffer _processGroup(PluginGraphNode node, SampleBuffer inBuffer) {
+  LinkedListIterator iterator;
+  PluginGraphBranch branch;
+  SampleBuffer mixBuffer = node->_mixBuffer;
+  unsigned long generation;
+  unsigned int channel;
+  unsigned long i;
+
+  // Start the workers first, so that they run while this thread processes
+  // the remaining branches
+  for(iterator = node->branches; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    branch = (PluginGraphBranch)iterator->item;
+    if(branch->_worker != NULL) {
+      branch->_workerInput = inBuffer;
+      threadMemoryBarrier();
+      branch->_numRequests++;
+      threadSignalNotify(branch->_requestSignal);
+    }
+  }
+  for(iterator = node->branches; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    branch = (PluginGraphBranch)iterator->item;
+    if(branch->_worker == NULL) {
+      _processGroupBranch(branch, inBuffer);
+    }
+  }
+
+  mixBuffer->blocksize = inBuffer->blocksize;
+  sampleBufferClear(mixBuffer);
+  for(iterator = node->branches; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    branch = (PluginGraphBranch)iterator->item;
+    for(;;) {
+      generation = threadSignalGetGeneration(node->_finishedSignal);
+      if(branch->_numFinished == branch->_numRequests) {
+        break;
+      }
+      threadSignalWait(node->_finishedSignal, generation);
+    }
+    threadMemoryBarrier();
+    for(channel = 0; channel < mixBuffer->numChannels; channel++) {
+      for(i = 0; i < mixBuffer->blocksize; i++) {
+        mixBuffer->samples[channel][i] += branch->_outputBuffer->samples[channel][i];
+      }
+    }
+  }
+
+  return mixBuffer;
+}
+
+static SampleBuffer _processBranch(PluginGraphBranch branch, SampleBuffer inBuffer) {
+  PluginGraph graph = branch->_graph;
+  LinkedListIterator iterator;
+  PluginGraphNode node;
+  SampleBuffer buffer = inBuffer;
+
+  for(iterator = branch->nodes; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    node = (PluginGraphNode)iterator->item;
+    if(node->type == PLUGIN_GRAPH_NODE_PLUGIN) {
+      buffer = graph->_processPlugin(graph->_processPluginUserData, node->pluginIndex, buffer);
+    }
+    else {
+      buffer = _processGroup(node, buffer);
+    }
+  }
+
+  return buffer;
+}
+
+SampleBuffer pluginGraphProcessAudio(PluginGraph self, SampleBuffer inBuffer) {
+  return _processBranch(self->root, inBuffer);
+}
+
+static void _stopBranchWorkers(PluginGraphBranch branch) {
+  LinkedListIterator nodeIterator;
+  LinkedListIterator branchIterator;
+  PluginGraphNode node;
+
+  if(branch->_worker != NULL) {
+    branch->_stopWorker = true;
+    threadSignalNotify(branch->_requestSignal);
+    threadJoin(branch->_worker);
+    freeThread(branch->_worker);
+    branch->_worker = NULL;
+    branch->_stopWorker = false;
+  }
+
+  for(nodeIterator = branch->nodes; nodeIterator != NULL && nodeIterator->item != NULL;
+    nodeIterator = nodeIterator->nextItem) {
+    node = (PluginGraphNode)nodeIterator->item;
+    if(node->type == PLUGIN_GRAPH_NODE_GROUP) {
+      for(branchIterator = node->branches; branchIterator != NULL && branchIterator->item != NULL;
+        branchIterator = branchIterator->nextItem) {
+        _stopBranchWorkers((PluginGraphBranch)branchIterator->item);
+      }
+    }
+  }
+}
+
+void pluginGraphStopWorkers(PluginGraph self) {
+  _stopBranchWorkers(self->root);
+}
+
+static void _prepareBranch(PluginGraphBranch branch, Plugin* plugins);
+
+static void _prepareGroup(PluginGraphNode node, Plugin* plugins) {
+  LinkedListIterator iterator;
+  PluginGraphBranch branch;
+  unsigned long groupDelay = _getNodeDelay(node, plugins);
+  unsigned int channel;
+  boolByte hasSerialBranch = false;
+
+  freeSampleBuffer(node->_mixBuffer);
+  node->_mixBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+
+  for(iterator = node->branches; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    branch = (PluginGraphBranch)iterator->item;
+    _prepareBranch(branch, plugins);
+    branch->compensationInFrames = groupDelay - branch->delayInFrames;
+    _freeDelayLines(branch);
+    freeSampleBuffer(branch->_outputBuffer);
+    branch->_outputBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+    branch->_delayPosition = 0;
+    if(branch->compensationInFrames > 0) {
+      logDebug("Delaying plugin graph branch by %lu frames", branch->compensationInFrames);
+      branch->_delayLines = (Samples*)malloc(sizeof(Samples) * branch->_outputBuffer->numChannels);
+      for(channel = 0; channel < branch->_outputBuffer->numChannels; channel++) {
+        branch->_delayLines[channel] = (Samples)calloc(branch->compensationInFrames, sizeof(Sample));
+      }
+    }
+
+    // The first branch with plugins is processed by the thread which processes
+    // the group, and branches without plugins are not worth a thread
+    if(branch->nodes->item == NULL) {
+      continue;
+    }
+    else if(!hasSerialBranch) {
+      hasSerialBranch = true;
+    }
+    else {
+      branch->_numRequests = 0;
+      branch->_numFinished = 0;
+      branch->_finishedSignal = node->_finishedSignal;
+      branch->_worker = newThread(_branchWorkerThread, branch);
+      if(!threadStart(branch->_worker)) {
+        logWarn("Could not start worker for plugin graph branch, processing it serially");
+        freeThread(branch->_worker);
+        branch->_worker = NULL;
+      }
+    }
+  }
+}
+
+static void _prepareBranch(PluginGraphBranch branch, Plugin* plugins) {
+  LinkedListIterator iterator;
+  PluginGraphNode node;
+
+  branch->delayInFrames = _getBranchDelay(branch, plugins);
+  for(iterator = branch->nodes; iterator != NULL && iterator->item != NULL; iterator = iterator->nextItem) {
+    node = (PluginGraphNode)iterator->item;
+    if(node->type == PLUGIN_GRAPH_NODE_GROUP) {
+      _prepareGroup(node, plugins);
+    }
+  }
+}
+
+void pluginGraphPrepare(PluginGraph self, Plugin* plugins, PluginGraphProcessPluginFunc processPlugin,
+  void* userData) {
+  pluginGraphStopWorkers(self);
+  self->_engineContext = getCurrentEngineContext();
+  self->_processPlugin = processPlugin;
+  self->_processPluginUserData = userData;
+  _prepareBranch(self->root, plugins);
+}
+
+void freePluginGraph(PluginGraph self) {
+  if(self == NULL) {
+    return;
+  }
+  pluginGraphStopWorkers(self);
+  _freePluginGraphBranch(self->root);
+  freeLinkedListAndItems(self->pluginArguments, (LinkedListFreeItemFunc)freeCharString);
+  free(self);
+}
@@ -0,0 +1,226 @@
+//
+// PluginGraph.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_PluginGraph_h
+#define MrsWatson_PluginGraph_h
+
+#include "audio/SampleBuffer.h"
+#include "base/CharString.h"
+#include "base/LinkedList.h"
+#include "base/Thread.h"
+#include "plugin/Plugin.h"
+
+#define PLUGIN_GRAPH_GROUP_START '['
+#define PLUGIN_GRAPH_GROUP_END ']'
+#define PLUGIN_GRAPH_BRANCH_SEPARATOR '+'
+// Same as CHAIN_STRING_PLUGIN_SEPARATOR
+#define PLUGIN_GRAPH_PLUGIN_SEPARATOR ';'
+
+/**
+ * Called by the graph to process a single plugin. The callback must copy the
+ * input into the plugin's input buffer and run the plugin, and may be called
+ * from worker threads for plugins inside of parallel branches.
+ * @param userData User data given to pluginGraphProcessAudio()
+ * @param pluginIndex Index of the plugin to process
+ * @param input Input for the plugin, which must not be modified
+ * @return Buffer holding the plugin's output
+ */
+typedef SampleBuffer (*PluginGraphProcessPluginFunc)(void* userData, unsigned int pluginIndex, SampleBuffer input);
+
+typedef enum {
+  PLUGIN_GRAPH_NODE_PLUGIN,
+  PLUGIN_GRAPH_NODE_GROUP
+} PluginGraphNodeType;
+
+struct PluginGraphNodeMembers;
+struct PluginGraphMembers;
+
+/**
+ * A sequence of nodes which are processed in series. An empty branch passes
+ * its input through unchanged, which can be used for dry signals.
+ */
+typedef struct {
+  // List of PluginGraphNode objects
+  LinkedList nodes;
+  // Set by pluginGraphPrepare()
+  unsigned long delayInFrames;
+  unsigned long compensationInFrames;
+
+  // Private fields
+  SampleBuffer _outputBuffer;
+  Samples* _delayLines;
+  unsigned long _delayPosition;
+  // Worker which processes this branch, NULL for branches processed by the
+  // thread which processes the group
+  Thread _worker;
+  struct PluginGraphMembers* _graph;
+  SampleBuffer _workerInput;
+  volatile unsigned long _numRequests;
+  volatile unsigned long _numFinished;
+  volatile boolByte _stopWorker;
+  // Notified when a block is requested from the worker, or when it should stop
+  ThreadSignal _requestSignal;
+  // Signal of the group which the branch belongs to, notified by the worker
+  // when it has finished a block
+  ThreadSignal _finishedSignal;
+} PluginGraphBranchMembers;
+typedef PluginGraphBranchMembers* PluginGraphBranch;
+
+/**
+ * Either a single plugin, or a group which splits its input into parallel
+ * branches and sums their outputs. Branches with less processing delay than
+ * the slowest branch in the group are delayed to line up with it.
+ */
+typedef struct PluginGraphNodeMembers {
+  PluginGraphNodeType type;
+  // Index of the plugin in the chain, only for plugin nodes
+  unsigned int pluginIndex;
+  // List of PluginGraphBranch objects, only for group nodes
+  LinkedList branches;
+
+  // Private fields
+  SampleBuffer _mixBuffer;
+  // Notified by the workers of the group's branches, only for group nodes
+  ThreadSignal _finishedSignal;
+} PluginGraphNodeMembers;
+typedef PluginGraphNodeMembers* PluginGraphNode;
+
+/**
+ * Describes how the plugins of a chain are connected when they should not
+ * simply be processed one after another. The graph only refers to plugins by
+ * their index in the chain, the plugins themselves are owned by PluginChain.
+ */
+typedef struct PluginGraphMembers {
+  PluginGraphBranch root;
+  // List of CharString objects with the plugin (and preset) argument for each
+  // plugin, in the order of their indexes
+  LinkedList pluginArguments;
+
+  // Private fields
+  void* _engineContext;
+  PluginGraphProcessPluginFunc _processPlugin;
+  void* _processPluginUserData;
+} PluginGraphMembers;
+typedef PluginGraphMembers* PluginGraph;
+
+/**
+ * Check if a plugin chain argument describes a graph rather than a simple
+ * list of plugins.
+ * @param argument Plugin chain argument
+ * @return True if the argument contains any group brackets
+ */
+boolByte pluginGraphIsGraphString(const CharString argument);
+
+/**
+ * Parse a graph from a plugin chain argument. Plugins are separated by ';' as
+ * usual, and groups of parallel branches are written in square brackets with
+ * '+' between the branches. The outputs of the branches are summed. Groups may
+ * be nested, and branches may be empty to pass the signal through. Examples:
+ *
+ *   compressor;[+reverb];limiter (dry signal summed with reverb)
+ *   [lowpass;compressor+highpass;exciter];limiter
+ *
+ * Plugins are numbered in the order in which they appear.
+ * @param argument Plugin chain argument
+ * @return Initialized PluginGraph, or NULL if the argument is malformed
+ */
+PluginGraph newPluginGraphWithString(const CharString argument);
+
+/**
+ * Get the number of plugins in the graph
+ * @param self
+ * @return Number of plugins
+ */
+unsigned int pluginGraphGetNumPlugins(const PluginGraph self);
+
+/**
+ * Check if a plugin receives the graph's input directly, rather than from
+ * another plugin or a group
+ * @param self
+ * @param pluginIndex Plugin index
+ * @return True if the plugin is the first node of the graph
+ */
+boolByte pluginGraphIsHeadPlugin(const PluginGraph self, unsigned int pluginIndex);
+
+/**
+ * Get the processing delay of the graph. For each group, this is the delay
+ * of its slowest branch.
+ * @param self
+ * @param plugins Plugins of the chain
+ * @return Processing delay, in frames
+ */
+unsigned long pluginGraphGetProcessingDelay(const PluginGraph self, Plugin* plugins);
+
+/**
+ * Get the processing delay of the path from the graph's input to the output
+ * of a plugin, including the plugin's own delay
+ * @param self
+ * @param plugins Plugins of the chain
+ * @param pluginIndex Plugin index
+ * @return Processing delay, in frames
+ */
+unsigned long pluginGraphGetProcessingDelayAtPlugin(const PluginGraph self, Plugin* plugins,
+  unsigned int pluginIndex);
+
+/**
+ * Calculate the delay compensation for each branch, allocate the buffers
+ * needed for processing, and start a worker thread for each branch which
+ * contains plugins, except for the first such branch of each group. This must be called
+ * after the plugins have been initialized, and again whenever the sample rate,
+ * channel count, or blocksize changes. Worker threads use the EngineContext of
+ * the calling thread.
+ * @param self
+ * @param plugins Plugins of the chain
+ * @param processPlugin Callback to process a single plugin
+ * @param userData User data to pass to processPlugin
+ */
+void pluginGraphPrepare(PluginGraph self, Plugin* plugins, PluginGraphProcessPluginFunc processPlugin,
+  void* userData);
+
+/**
+ * Process a block through the graph. Branches with worker threads are
+ * processed in parallel to the other branches of their group.
+ * @param self
+ * @param inBuffer Input sample block
+ * @return Buffer holding the graph's output, which is valid until the next call
+ */
+SampleBuffer pluginGraphProcessAudio(PluginGraph self, SampleBuffer inBuffer);
+
+/**
+ * Stop all worker threads of the graph. This is done automatically when the
+ * graph is prepared again or freed.
+ * @param self
+ */
+void pluginGraphStopWorkers(PluginGraph self);
+
+/**
+ * Free a graph and all of its nodes
+ * @param self
+ */
+void freePluginGraph(PluginGraph self);
+
+#endif
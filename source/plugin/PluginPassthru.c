@@ -73,6 +73,10 @@ static boolByte _pluginPassthruSetParameter(void* pluginPtr, unsigned int i, flo
   return false;
 }
 
+static float _pluginPassthruGetParameter(void* pluginPtr, unsigned int i) {
+  return 0.0f;
+}
+
 Plugin newPluginPassthru(const CharString pluginName) {
   Plugin plugin = _newPlugin(PLUGIN_TYPE_INTERNAL, PLUGIN_TYPE_EFFECT);
   charStringCopy(plugin->pluginName, pluginName);
@@ -82,9 +86,11 @@ Plugin newPluginPassthru(const CharString pluginName) {
   plugin->displayInfo = _pluginPassthruDisplayInfo;
   plugin->getSetting = _pluginPassthruGetSetting;
   plugin->prepareForProcessing = _pluginPassthruEmpty;
+  plugin->suspend = _pluginPassthruEmpty;
   plugin->processAudio = _pluginPassthruProcessAudio;
   plugin->processMidiEvents = _pluginPassthruProcessMidiEvents;
   plugin->setParameter = _pluginPassthruSetParameter;
+  plugin->getParameter = _pluginPassthruGetParameter;
   plugin->closePlugin = _pluginPassthruEmpty;
   plugin->freePluginData = _pluginPassthruEmpty;
 
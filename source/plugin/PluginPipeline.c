@@ -0,0 +1,272 @@
+//
+// PluginPipeline.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdlib.h>
+
+#include "app/EngineContext.h"
+#include "audio/AudioSettings.h"
+#include "logging/EventLogger.h"
+#include "plugin/PluginPipeline.h"
+
+PluginPipeline newPluginPipeline(unsigned int maxNumStages, unsigned int numPlugins) {
+  PluginPipeline pipeline = (PluginPipeline)malloc(sizeof(PluginPipelineMembers));
+  PluginPipelineStage stage;
+  unsigned int i;
+
+  pipeline->numStages = maxNumStages < numPlugins ? maxNumStages : numPlugins;
+  if(pipeline->numStages == 0) {
+    pipeline->numStages = 1;
+  }
+  pipeline->stages = (PluginPipelineStage*)malloc(sizeof(PluginPipelineStage) * pipeline->numStages);
+  for(i = 0; i < pipeline->numStages; i++) {
+    stage = (PluginPipelineStage)malloc(sizeof(PluginPipelineStageMembers));
+    stage->firstPlugin = i * numPlugins / pipeline->numStages;
+    stage->numPlugins = (i + 1) * numPlugins / pipeline->numStages - stage->firstPlugin;
+    stage->outputQueue = NULL;
+    stage->_pipeline = pipeline;
+    stage->_thread = NULL;
+    stage->_audioClock = newAudioClock();
+    stage->_engineContext = malloc(sizeof(EngineContextMembers));
+    stage->_numBlocksWritten = 0;
+    stage->_numBlocksRead = 0;
+    pipeline->stages[i] = stage;
+  }
+
+  pipeline->_numPlugins = numPlugins;
+  pipeline->_numBlocksInFlight = 0;
+  pipeline->_isRunning = false;
+  pipeline->_isSerial = false;
+  pipeline->_processPlugin = NULL;
+  pipeline->_processPluginUserData = NULL;
+  return pipeline;
+}
+
+unsigned long pluginPipelineGetDelay(const PluginPipeline self) {
+  return (self->numStages - 1) * getBlocksize();
+}
+
+static SampleBuffer _pluginPipelineProcessStage(PluginPipelineStage stage, SampleBuffer inBuffer) {
+  PluginPipeline pipeline = stage->_pipeline;
+  SampleBuffer buffer = inBuffer;
+  unsigned int i;
+  for(i = stage->firstPlugin; i < stage->firstPlugin + stage->numPlugins; i++) {
+    buffer = pipeline->_processPlugin(pipeline->_processPluginUserData, i, buffer);
+  }
+  return buffer;
+}
+
+// Pass the output of a stage on to the next one, along with the position of
+// the block. Returns false if the pipeline was stopped in the meantime.
+static boolByte _pluginPipelineWriteStageOutput(PluginPipelineStage stage, SampleBuffer buffer,
+  AudioClock audioClock) {
+  SampleBuffer queuedBuffer = sampleBufferQueueAcquireWrite(stage->outputQueue);
+  if(queuedBuffer == NULL) {
+    return false;
+  }
+  queuedBuffer->blocksize = buffer->blocksize;
+  sampleBufferCopyAndMapChannels(queuedBuffer, buffer);
+  stage->_outputClocks[stage->_numBlocksWritten % PLUGIN_PIPELINE_QUEUE_SIZE] = *audioClock;
+  stage->_numBlocksWritten++;
+  sampleBufferQueueCommitWrite(stage->outputQueue, false);
+  return true;
+}
+
+static void* _pluginPipelineStageThread(void* userData) {
+  PluginPipelineStage stage = (PluginPipelineStage)userData;
+  PluginPipeline pipeline = stage->_pipeline;
+  PluginPipelineStage previousStage = NULL;
+  SampleBufferQueue inputQueue;
+  SampleBuffer buffer;
+  unsigned int i;
+
+  engineContextMakeCurrent((EngineContext)stage->_engineContext);
+  for(i = 1; i < pipeline->numStages; i++) {
+    if(pipeline->stages[i] == stage) {
+      previousStage = pipeline->stages[i - 1];
+    }
+  }
+  inputQueue = previousStage->outputQueue;
+
+  while(true) {
+    buffer = sampleBufferQueueAcquireRead(inputQueue, NULL);
+    if(buffer == NULL) {
+      break;
+    }
+    *(stage->_audioClock) = previousStage->_outputClocks[stage->_numBlocksRead % PLUGIN_PIPELINE_QUEUE_SIZE];
+    stage->_numBlocksRead++;
+    buffer = _pluginPipelineProcessStage(stage, buffer);
+    // The first plugin of the stage has copied its input by now
+    sampleBufferQueueCommitRead(inputQueue);
+    if(!_pluginPipelineWriteStageOutput(stage, buffer, stage->_audioClock)) {
+      break;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * Stop the stage threads which were already started and process all stages on
+ * the calling thread instead. The last stage's queue is enlarged to hold as
+ * many blocks as are in flight, so that the pipeline's delay stays the same.
+ */
+static void _pluginPipelineStartSerial(PluginPipeline self, Plugin* plugins) {
+  PluginPipelineStage lastStage = self->stages[self->numStages - 1];
+  Plugin lastPlugin = plugins[lastStage->firstPlugin + lastStage->numPlugins - 1];
+
+  pluginPipelineStop(self);
+  lastStage->outputQueue = newSampleBufferQueue(self->numStages,
+    (unsigned int)lastPlugin->getSetting(lastPlugin, PLUGIN_NUM_OUTPUTS), getBlocksize());
+  self->_isSerial = true;
+  self->_isRunning = true;
+}
+
+void pluginPipelinePrepare(PluginPipeline self, Plugin* plugins, PluginPipelineProcessPluginFunc processPlugin,
+  void* userData) {
+  PluginPipelineStage stage;
+  Plugin lastPlugin;
+  unsigned int i;
+
+  pluginPipelineStop(self);
+  self->_processPlugin = processPlugin;
+  self->_processPluginUserData = userData;
+  self->_numBlocksInFlight = 0;
+  self->_isSerial = false;
+
+  for(i = 0; i < self->numStages; i++) {
+    stage = self->stages[i];
+    lastPlugin = plugins[stage->firstPlugin + stage->numPlugins - 1];
+    stage->outputQueue = newSampleBufferQueue(PLUGIN_PIPELINE_QUEUE_SIZE,
+      (unsigned int)lastPlugin->getSetting(lastPlugin, PLUGIN_NUM_OUTPUTS), getBlocksize());
+    stage->_numBlocksWritten = 0;
+    stage->_numBlocksRead = 0;
+    engineContextInitWithClock((EngineContext)stage->_engineContext, stage->_audioClock);
+  }
+  self->_isRunning = true;
+
+  for(i = 1; i < self->numStages; i++) {
+    stage = self->stages[i];
+    logDebug("Processing plugins %d-%d on pipeline stage %d", stage->firstPlugin,
+      stage->firstPlugin + stage->numPlugins - 1, i);
+    stage->_thread = newThread(_pluginPipelineStageThread, stage);
+    if(!threadStart(stage->_thread)) {
+      logWarn("Could not start thread for plugin pipeline stage %d, processing all stages serially", i);
+      freeThread(stage->_thread);
+      stage->_thread = NULL;
+      _pluginPipelineStartSerial(self, plugins);
+      return;
+    }
+  }
+}
+
+void pluginPipelineProcessAudio(PluginPipeline self, SampleBuffer inBuffer, SampleBuffer outBuffer) {
+  PluginPipelineStage lastStage = self->stages[self->numStages - 1];
+  SampleBufferQueue outputQueue = lastStage->outputQueue;
+  PluginPipelineStage writeStage = self->stages[0];
+  SampleBuffer buffer;
+  unsigned int i;
+
+  buffer = _pluginPipelineProcessStage(self->stages[0], inBuffer);
+  if(self->numStages == 1) {
+    outBuffer->blocksize = buffer->blocksize;
+    sampleBufferCopyAndMapChannels(outBuffer, buffer);
+    return;
+  }
+  if(self->_isSerial) {
+    // The last stage's queue then only delays the output like the threads would
+    for(i = 1; i < self->numStages; i++) {
+      buffer = _pluginPipelineProcessStage(self->stages[i], buffer);
+    }
+    writeStage = lastStage;
+  }
+  if(!_pluginPipelineWriteStageOutput(writeStage, buffer, getAudioClock())) {
+    logInternalError("Plugin pipeline was stopped during processing");
+    return;
+  }
+
+  if(self->_numBlocksInFlight < self->numStages - 1) {
+    self->_numBlocksInFlight++;
+    outBuffer->blocksize = inBuffer->blocksize;
+    sampleBufferClear(outBuffer);
+    return;
+  }
+
+  // The last stage is usually still working on this block, since it was sent
+  // into the pipeline numStages - 1 calls ago
+  buffer = sampleBufferQueueAcquireRead(outputQueue, NULL);
+  if(buffer == NULL) {
+    logInternalError("Plugin pipeline was stopped during processing");
+    return;
+  }
+  outBuffer->blocksize = buffer->blocksize;
+  sampleBufferCopyAndMapChannels(outBuffer, buffer);
+  sampleBufferQueueCommitRead(outputQueue);
+}
+
+void pluginPipelineStop(PluginPipeline self) {
+  PluginPipelineStage stage;
+  unsigned int i;
+
+  if(!self->_isRunning) {
+    return;
+  }
+  for(i = 0; i < self->numStages; i++) {
+    if(self->stages[i]->outputQueue != NULL) {
+      sampleBufferQueueCancel(self->stages[i]->outputQueue);
+    }
+  }
+  for(i = 0; i < self->numStages; i++) {
+    stage = self->stages[i];
+    if(stage->_thread != NULL) {
+      threadJoin(stage->_thread);
+      freeThread(stage->_thread);
+      stage->_thread = NULL;
+    }
+  }
+  for(i = 0; i < self->numStages; i++) {
+    stage = self->stages[i];
+    freeSampleBufferQueue(stage->outputQueue);
+    stage->outputQueue = NULL;
+  }
+  self->_isRunning = false;
+}
+
+void freePluginPipeline(PluginPipeline self) {
+  unsigned int i;
+  if(self == NULL) {
+    return;
+  }
+  pluginPipelineStop(self);
+  for(i = 0; i < self->numStages; i++) {
+    freeAudioClock(self->stages[i]->_audioClock);
+    // Only borrows the objects of the calling thread's context
+    free(self->stages[i]->_engineContext);
+    free(self->stages[i]);
+  }
+  free(self->stages);
+  free(self);
+}
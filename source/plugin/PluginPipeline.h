@@ -0,0 +1,153 @@
+//
+// PluginPipeline.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_PluginPipeline_h
+#define MrsWatson_PluginPipeline_h
+
+#include "audio/SampleBuffer.h"
+#include "audio/SampleBufferQueue.h"
+#include "base/Thread.h"
+#include "plugin/Plugin.h"
+#include "time/AudioClock.h"
+
+// Number of blocks which can be queued between two stages. Each stage only
+// ever runs one block ahead, so more does not help throughput.
+#define PLUGIN_PIPELINE_QUEUE_SIZE 2
+
+/**
+ * Called by the pipeline to process a single plugin, see PluginGraph.h.
+ */
+typedef SampleBuffer (*PluginPipelineProcessPluginFunc)(void* userData, unsigned int pluginIndex, SampleBuffer input);
+
+struct PluginPipelineMembers;
+
+/**
+ * A contiguous range of plugins which is processed by a single thread
+ */
+typedef struct {
+  unsigned int firstPlugin;
+  unsigned int numPlugins;
+  // Blocks processed by this stage, read by the next one or, for the last
+  // stage, by the caller of pluginPipelineProcessAudio()
+  SampleBufferQueue outputQueue;
+
+  // Private fields
+  struct PluginPipelineMembers* _pipeline;
+  Thread _thread;
+  // Position of the block which the stage's thread is working on, which is
+  // behind the calling thread's clock by one block for each stage before it
+  AudioClock _audioClock;
+  // EngineContext made current on the stage's thread, which uses _audioClock
+  void* _engineContext;
+  // Position of each block in outputQueue, indexed by the block number
+  AudioClockMembers _outputClocks[PLUGIN_PIPELINE_QUEUE_SIZE];
+  unsigned long _numBlocksWritten;
+  unsigned long _numBlocksRead;
+} PluginPipelineStageMembers;
+typedef PluginPipelineStageMembers* PluginPipelineStage;
+
+/**
+ * Processes the plugins of a chain in several stages which run on their own
+ * threads, so that a long chain of heavy plugins can use more than one core.
+ * The first stage runs on the calling thread, which keeps the head plugin on
+ * the thread which sends it MIDI events. Each further stage works on the block
+ * which the previous stage finished during the last call, so the output is
+ * delayed by one block for each stage after the first. Plugins in these stages
+ * see the position of the block they are processing in getAudioClock().
+ */
+typedef struct PluginPipelineMembers {
+  unsigned int numStages;
+  PluginPipelineStage* stages;
+
+  // Private fields
+  unsigned int _numPlugins;
+  // Number of blocks which were sent to the first stage but have not yet come
+  // out of the last one
+  unsigned int _numBlocksInFlight;
+  boolByte _isRunning;
+  // Set when a stage thread could not be started, all stages are then
+  // processed on the calling thread with the same delay
+  boolByte _isSerial;
+  PluginPipelineProcessPluginFunc _processPlugin;
+  void* _processPluginUserData;
+} PluginPipelineMembers;
+typedef PluginPipelineMembers* PluginPipeline;
+
+/**
+ * Create a new pipeline and divide the plugins evenly between its stages
+ * @param maxNumStages Maximum number of stages, the pipeline never has more
+ * stages than plugins.
+ * @param numPlugins Number of plugins in the chain
+ * @return Initialized PluginPipeline
+ */
+PluginPipeline newPluginPipeline(unsigned int maxNumStages, unsigned int numPlugins);
+
+/**
+ * Get the delay which the pipeline adds to the plugins' own processing delay
+ * @param self
+ * @return Delay, in frames
+ */
+unsigned long pluginPipelineGetDelay(const PluginPipeline self);
+
+/**
+ * Allocate the queues between the stages and start their threads. Any blocks
+ * which are still in the pipeline are discarded. This must be called after the
+ * plugins have been opened, and again whenever the blocksize or the number of
+ * channels change. Stage threads use the EngineContext of the calling thread.
+ * If a thread can't be started, the threads which were already started are
+ * stopped and the pipeline processes all stages on the calling thread.
+ * @param self
+ * @param plugins Plugins of the chain
+ * @param processPlugin Callback to process a single plugin
+ * @param userData User data to pass to processPlugin
+ */
+void pluginPipelinePrepare(PluginPipeline self, Plugin* plugins, PluginPipelineProcessPluginFunc processPlugin,
+  void* userData);
+
+/**
+ * Send a block into the pipeline and get the block which comes out of it. Until
+ * the pipeline has filled, the output is silent.
+ * @param self
+ * @param inBuffer Input sample block
+ * @param outBuffer Output sample block
+ */
+void pluginPipelineProcessAudio(PluginPipeline self, SampleBuffer inBuffer, SampleBuffer outBuffer);
+
+/**
+ * Stop the threads of all stages and discard the blocks in the pipeline. This
+ * is done automatically when the pipeline is prepared again or freed.
+ * @param self
+ */
+void pluginPipelineStop(PluginPipeline self);
+
+/**
+ * Free a pipeline and stop its threads
+ * @param self
+ */
+void freePluginPipeline(PluginPipeline self);
+
+#endif
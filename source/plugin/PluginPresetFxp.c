@@ -37,6 +37,10 @@
 static boolByte _openPluginPresetFxp(void* pluginPresetPtr) {
   PluginPreset pluginPreset = (PluginPreset)pluginPresetPtr;
   PluginPresetFxpData extraData = (PluginPresetFxpData)(pluginPreset->extraData);
+  // Presets are opened again each time they are reloaded into a plugin
+  if(extraData->fileHandle != NULL) {
+    fclose(extraData->fileHandle);
+  }
   extraData->fileHandle = fopen(pluginPreset->presetName->data, "rb");
   if(extraData->fileHandle == NULL) {
     logError("Preset '%s' could not be opened for reading", pluginPreset->presetName->data);
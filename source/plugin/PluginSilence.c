@@ -73,6 +73,10 @@ static boolByte _pluginSilenceSetParameter(void* pluginPtr, unsigned int i, floa
   return false;
 }
 
+static float _pluginSilenceGetParameter(void* pluginPtr, unsigned int i) {
+  return 0.0f;
+}
+
 Plugin newPluginSilence(const CharString pluginName) {
   Plugin plugin = _newPlugin(PLUGIN_TYPE_INTERNAL, PLUGIN_TYPE_INSTRUMENT);
   charStringCopy(plugin->pluginName, pluginName);
@@ -82,9 +86,11 @@ Plugin newPluginSilence(const CharString pluginName) {
   plugin->displayInfo = _pluginSilenceDisplayInfo;
   plugin->getSetting = _pluginSilenceGetSetting;
   plugin->prepareForProcessing = _pluginSilenceEmpty;
+  plugin->suspend = _pluginSilenceEmpty;
   plugin->processAudio = _pluginSilenceProcessAudio;
   plugin->processMidiEvents = _pluginSilenceProcessMidiEvents;
   plugin->setParameter = _pluginSilenceSetParameter;
+  plugin->getParameter = _pluginSilenceGetParameter;
   plugin->closePlugin = _pluginSilenceEmpty;
   plugin->freePluginData = _pluginSilenceEmpty;
 
@@ -0,0 +1,114 @@
+//
+// PluginTap.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/AudioSettings.h"
+#include "logging/EventLogger.h"
+#include "plugin/PluginTap.h"
+
+PluginTap newPluginTapWithString(const CharString argument) {
+  PluginTap tap = NULL;
+  CharString filename = NULL;
+  const char* separator;
+  char* end = NULL;
+  unsigned long pluginIndex;
+
+  if(charStringIsEmpty(argument)) {
+    logError("Tap argument is empty");
+    return NULL;
+  }
+  separator = strchr(argument->data, PLUGIN_TAP_SEPARATOR);
+  if(separator == NULL || separator == argument->data || *(separator + 1) == '\0') {
+    logError("Tap '%s' must have the format <plugin index>%c<file>", argument->data, PLUGIN_TAP_SEPARATOR);
+    return NULL;
+  }
+  pluginIndex = strtoul(argument->data, &end, 10);
+  if(end != separator || !isdigit((unsigned char)argument->data[0])) {
+    logError("Tap '%s' has an invalid plugin index", argument->data);
+    return NULL;
+  }
+
+  filename = newCharStringWithCString(separator + 1);
+  tap = (PluginTap)malloc(sizeof(PluginTapMembers));
+  tap->pluginIndex = (unsigned int)pluginIndex;
+  tap->outputSource = sampleSourceFactory(filename);
+  tap->skipHeadFrames = 0;
+  tap->framesProcessed = 0;
+  tap->_scratchBuffer = NULL;
+  freeCharString(filename);
+
+  if(tap->outputSource == NULL) {
+    logError("Tap '%s' has an unsupported output file type", argument->data);
+    freePluginTap(tap);
+    return NULL;
+  }
+  return tap;
+}
+
+boolByte pluginTapOpen(PluginTap self, unsigned long skipHeadFrames) {
+  self->skipHeadFrames = skipHeadFrames;
+  self->framesProcessed = 0;
+  freeSampleBuffer(self->_scratchBuffer);
+  self->_scratchBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+
+  if(self->outputSource->openedAs != SAMPLE_SOURCE_OPEN_WRITE &&
+    !self->outputSource->openSampleSource(self->outputSource, SAMPLE_SOURCE_OPEN_WRITE)) {
+    logError("Tap output source '%s' could not be opened", self->outputSource->sourceName->data);
+    return false;
+  }
+  return true;
+}
+
+void pluginTapProcessAudio(PluginTap self, const SampleBuffer buffer) {
+  unsigned long nextBlockStart = self->framesProcessed + buffer->blocksize;
+  unsigned long offset;
+
+  if(nextBlockStart > self->skipHeadFrames) {
+    offset = self->framesProcessed < self->skipHeadFrames ? self->skipHeadFrames - self->framesProcessed : 0;
+    self->_scratchBuffer->blocksize = buffer->blocksize - offset;
+    sampleBufferCopyAndMapChannelsWithOffset(self->_scratchBuffer, 0, buffer, offset, self->_scratchBuffer->blocksize);
+    self->outputSource->writeSampleBlock(self->outputSource, self->_scratchBuffer);
+  }
+  self->framesProcessed = nextBlockStart;
+}
+
+void freePluginTap(PluginTap self) {
+  if(self == NULL) {
+    return;
+  }
+  if(self->outputSource != NULL) {
+    if(self->outputSource->openedAs != SAMPLE_SOURCE_OPEN_NOT_OPENED) {
+      self->outputSource->closeSampleSource(self->outputSource);
+    }
+    freeSampleSource(self->outputSource);
+  }
+  freeSampleBuffer(self->_scratchBuffer);
+  free(self);
+}
@@ -0,0 +1,91 @@
+//
+// PluginTap.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_PluginTap_h
+#define MrsWatson_PluginTap_h
+
+#include "audio/SampleBuffer.h"
+#include "base/CharString.h"
+#include "io/SampleSource.h"
+
+#define PLUGIN_TAP_SEPARATOR ':'
+
+/**
+ * Writes the output of a single plugin in a chain to its own sample source
+ * while the chain is rendering. The start of the output is trimmed by the
+ * processing delay of the plugin and of all plugins before it, so that the
+ * tap lines up with the input in the same way as the chain's final output.
+ */
+typedef struct {
+  unsigned int pluginIndex;
+  SampleSource outputSource;
+  // Number of frames at the start of the plugin's output which are not written
+  unsigned long skipHeadFrames;
+  // Number of frames received from the plugin so far, including skipped ones
+  unsigned long framesProcessed;
+
+  // Private fields
+  SampleBuffer _scratchBuffer;
+} PluginTapMembers;
+typedef PluginTapMembers* PluginTap;
+
+/**
+ * Create a tap from a command line argument, which has the format
+ *
+ *   <plugin index>:<file>
+ *
+ * Plugin indexes start at zero for the head of the chain. The output source is
+ * not opened until the tap is added to a chain with pluginChainAddTap().
+ * @param argument Argument string to parse
+ * @return Initialized PluginTap, or NULL if the argument was malformed
+ */
+PluginTap newPluginTapWithString(const CharString argument);
+
+/**
+ * Open the tap's output source and reset the frame count
+ * @param self
+ * @param skipHeadFrames Number of frames to skip at the start of the plugin's
+ * output, which should be the processing delay of the plugin and all plugins
+ * before it in the chain
+ * @return True if the output source could be opened
+ */
+boolByte pluginTapOpen(PluginTap self, unsigned long skipHeadFrames);
+
+/**
+ * Write a block of the tapped plugin's output
+ * @param self
+ * @param buffer Output buffer of the tapped plugin
+ */
+void pluginTapProcessAudio(PluginTap self, const SampleBuffer buffer);
+
+/**
+ * Close the tap's output source and free all associated resources
+ * @param self
+ */
+void freePluginTap(PluginTap self);
+
+#endif
@@ -33,10 +33,13 @@
 // C includes
 extern "C" {
 #include <stdlib.h>
+#include <string.h>
 
+#include "app/EngineContext.h"
 #include "audio/AudioSettings.h"
 #include "base/File.h"
 #include "base/FileUtilities.h"
+#include "base/Thread.h"
 #include "logging/EventLogger.h"
 #include "midi/MidiEvent.h"
 #include "plugin/PluginVst2x.h"
@@ -58,11 +61,26 @@ typedef struct {
   boolByte isPluginShell;
   VstInt32 shellPluginId;
   // Must be retained until processReplacing() is called, so best to keep a
-  // reference in the plugin's data storage.
+  // reference in the plugin's data storage. Both the event list and the events
+  // it points to are reused for each block, and only grow when a block has more
+  // events than any block before it.
   struct VstEvents *vstEvents;
+  VstMidiEvent *vstMidiEvents;
+  int vstEventsCapacity;
+  // Returned to the plugin for audioMasterGetTime, which expects the host to
+  // own this struct. Each plugin gets its own copy so that plugins in
+  // different engine contexts can ask for the time concurrently.
+  VstTimeInfo timeInfo;
+  // Context which was current when the plugin was created, used by the host
+  // callback regardless of which thread the plugin calls it from.
+  EngineContext engineContext;
 } PluginVst2xDataMembers;
 typedef PluginVst2xDataMembers* PluginVst2xData;
 
+// Number of MIDI events which can be sent to a plugin in one block before the
+// event storage needs to grow
+static const int kVst2xMidiEventsInitialCapacity = 64;
+
 // Implementation body starts here
 extern "C" {
 // Current plugin ID, which is mostly used by shell plugins during initialization.
@@ -76,10 +94,10 @@ extern "C" {
 // extraData struct). Therefore it is not possible to have the plugin reach our host
 // callback with some custom data, and we must keep a global variable to the current
 // effect ID.
-// That said, this prevents initializing plugins in multiple threads in the future, as
-// as we must set this to the correct ID before calling the plugin's main() function
-// when setting up the effect chain.
-VstInt32 currentPluginUniqueId;
+// The plugin's main() function is called on the thread which opens the plugin, so
+// this variable is thread-local, which allows plugins to be opened by several engine
+// contexts at once.
+THREAD_LOCAL VstInt32 currentPluginUniqueId;
 
 static const char* _getVst2xPlatformExtension(void) {
   PlatformType platformType = getPlatformType();
@@ -372,6 +390,16 @@ unsigned long pluginVst2xGetVersion(const Plugin self) {
   return 0;
 }
 
+VstTimeInfo* pluginVst2xGetTimeInfo(const Plugin self) {
+  PluginVst2xData data = (PluginVst2xData)(self->extraData);
+  return &(data->timeInfo);
+}
+
+EngineContext pluginVst2xGetEngineContext(const Plugin self) {
+  PluginVst2xData data = (PluginVst2xData)(self->extraData);
+  return data->engineContext;
+}
+
 void pluginVst2xAudioMasterIOChanged(const Plugin self, AEffect const * const newValues) {
   PluginVst2xData data = (PluginVst2xData)(self->extraData);
   data->pluginHandle->initialDelay = newValues->initialDelay;
@@ -445,6 +473,9 @@ static boolByte _openVst2xPlugin(void* pluginPtr) {
   else {
     data->dispatcher = (Vst2xPluginDispatcherFunc)(pluginHandle->dispatcher);
     data->pluginHandle = pluginHandle;
+    // The resvd1 field is reserved for the host, use it to find this plugin
+    // again when the host callback is called.
+    pluginHandle->resvd1 = (VstIntPtr)plugin;
     result = _initVst2xPlugin(plugin);
     if(result) {
       data->pluginId = newPluginVst2xIdWithId((unsigned long)data->pluginHandle->uniqueID);
@@ -598,6 +629,8 @@ static int _getVst2xPluginSetting(void* pluginPtr, PluginSetting pluginSetting)
       return data->pluginHandle->numOutputs;
     case PLUGIN_INITIAL_DELAY:
       return data->pluginHandle->initialDelay;
+    case PLUGIN_NUM_PARAMETERS:
+      return data->pluginHandle->numParams;
     default:
       logUnsupportedFeature("Plugin setting for VST2.x");
       return 0;
@@ -645,15 +678,19 @@ static void _processMidiEventsVst2xPlugin(void *pluginPtr, LinkedList midiEvents
   PluginVst2xData data = (PluginVst2xData)(plugin->extraData);
   int numEvents = linkedListLength(midiEvents);
 
-  // Free events from the previous call
-  if(data->vstEvents != NULL) {
-    for(int i = 0; i < data->vstEvents->numEvents; i++) {
-      free(data->vstEvents->events[i]);
+  if(data->vstEvents == NULL || numEvents > data->vstEventsCapacity) {
+    int capacity = data->vstEventsCapacity > 0 ? data->vstEventsCapacity : kVst2xMidiEventsInitialCapacity;
+    while(capacity < numEvents) {
+      capacity *= 2;
     }
     free(data->vstEvents);
+    free(data->vstMidiEvents);
+    // VstEvents ends with a two-element array of event pointers, which the
+    // plugin expects to extend past the end of the struct
+    data->vstEvents = (struct VstEvents*)malloc(sizeof(struct VstEvents) + (capacity * sizeof(struct VstEvent*)));
+    data->vstMidiEvents = (VstMidiEvent*)malloc(capacity * sizeof(VstMidiEvent));
+    data->vstEventsCapacity = capacity;
   }
-
-  data->vstEvents = (struct VstEvents*)malloc(sizeof(struct VstEvent) + (numEvents * sizeof(struct VstEvent*)));
   data->vstEvents->numEvents = numEvents;
 
   // Some monophonic instruments have problems dealing with the order of MIDI events,
@@ -663,7 +700,7 @@ static void _processMidiEventsVst2xPlugin(void *pluginPtr, LinkedList midiEvents
   while(iterator != NULL && outIndex < numEvents) {
     MidiEvent midiEvent = (MidiEvent)(iterator->item);
     if(midiEvent != NULL && (midiEvent->status >> 4) == 0x08) {
-      VstMidiEvent* vstMidiEvent = (VstMidiEvent*)malloc(sizeof(VstMidiEvent));
+      VstMidiEvent* vstMidiEvent = &(data->vstMidiEvents[outIndex]);
       _fillVstMidiEvent(midiEvent, vstMidiEvent);
       data->vstEvents->events[outIndex] = (VstEvent*)vstMidiEvent;
       outIndex++;
@@ -675,7 +712,7 @@ static void _processMidiEventsVst2xPlugin(void *pluginPtr, LinkedList midiEvents
   while(iterator != NULL && outIndex < numEvents) {
     MidiEvent midiEvent = (MidiEvent)(iterator->item);
     if(midiEvent != NULL && (midiEvent->status >> 4) != 0x08) {
-      VstMidiEvent* vstMidiEvent = (VstMidiEvent*)malloc(sizeof(VstMidiEvent));
+      VstMidiEvent* vstMidiEvent = &(data->vstMidiEvents[outIndex]);
       _fillVstMidiEvent(midiEvent, vstMidiEvent);
       data->vstEvents->events[outIndex] = (VstEvent*)vstMidiEvent;
       outIndex++;
@@ -738,11 +775,25 @@ static boolByte _setParameterVst2xPlugin(void *pluginPtr, unsigned int index, fl
   }
 }
 
+static float _getParameterVst2xPlugin(void *pluginPtr, unsigned int index) {
+  Plugin plugin = (Plugin)pluginPtr;
+  PluginVst2xData data = (PluginVst2xData)(plugin->extraData);
+  if(index < (unsigned int)data->pluginHandle->numParams) {
+    return data->pluginHandle->getParameter(data->pluginHandle, index);
+  }
+  return 0.0f;
+}
+
 static void _prepareForProcessingVst2xPlugin(void* pluginPtr) {
   Plugin plugin = (Plugin)pluginPtr;
   _resumePlugin(plugin);
 }
 
+static void _suspendVst2xPlugin(void* pluginPtr) {
+  Plugin plugin = (Plugin)pluginPtr;
+  _suspendPlugin(plugin);
+}
+
 static void _closeVst2xPlugin(void *pluginPtr) {
   Plugin plugin = (Plugin)pluginPtr;
   _suspendPlugin(plugin);
@@ -756,12 +807,8 @@ static void _freeVst2xPluginData(void* pluginDataPtr) {
   data->pluginHandle = NULL;
   freePluginVst2xId(data->pluginId);
   closeLibraryHandle(data->libraryHandle);
-  if(data->vstEvents != NULL) {
-    for(int i = 0; i < data->vstEvents->numEvents; i++) {
-      free(data->vstEvents->events[i]);
-    }
-    free(data->vstEvents);
-  }
+  free(data->vstEvents);
+  free(data->vstMidiEvents);
 }
 
 Plugin newPluginVst2x(const CharString pluginName, const CharString pluginRoot) {
@@ -775,7 +822,9 @@ Plugin newPluginVst2x(const CharString pluginName, const CharString pluginRoot)
   plugin->processAudio = _processAudioVst2xPlugin;
   plugin->processMidiEvents = _processMidiEventsVst2xPlugin;
   plugin->setParameter = _setParameterVst2xPlugin;
+  plugin->getParameter = _getParameterVst2xPlugin;
   plugin->prepareForProcessing = _prepareForProcessingVst2xPlugin;
+  plugin->suspend = _suspendVst2xPlugin;
   plugin->closePlugin = _closeVst2xPlugin;
   plugin->freePluginData = _freeVst2xPluginData;
 
@@ -787,6 +836,10 @@ Plugin newPluginVst2x(const CharString pluginName, const CharString pluginRoot)
   extraData->isPluginShell = false;
   extraData->shellPluginId = 0;
   extraData->vstEvents = NULL;
+  extraData->vstMidiEvents = NULL;
+  extraData->vstEventsCapacity = 0;
+  memset(&(extraData->timeInfo), 0, sizeof(VstTimeInfo));
+  extraData->engineContext = getCurrentEngineContext();
   plugin->extraData = extraData;
 
   return plugin;
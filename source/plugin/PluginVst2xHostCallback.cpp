@@ -40,8 +40,10 @@ extern "C" {
 #include <math.h>
 
 #include "app/BuildInfo.h"
+#include "app/EngineContext.h"
 #include "audio/AudioSettings.h"
 #include "base/CharString.h"
+#include "base/Thread.h"
 #include "logging/EventLogger.h"
 #include "plugin/PluginChain.h"
 #include "plugin/PluginVst2x.h"
@@ -49,6 +51,8 @@ extern "C" {
 #include "time/AudioClock.h"
 
 void pluginVst2xAudioMasterIOChanged(const Plugin self, AEffect const * const newValues);
+VstTimeInfo* pluginVst2xGetTimeInfo(const Plugin self);
+EngineContext pluginVst2xGetEngineContext(const Plugin self);
 }
 
 // Global variables (sigh, unfortunately yes). When plugins ask for the time, they
@@ -57,16 +61,16 @@ void pluginVst2xAudioMasterIOChanged(const Plugin self, AEffect const * const ne
 // which is actually the correct thing to do, given that if this were the case, a
 // huge number of plugins would probably fail to do this and leak memory all over
 // the place.
-// Anyways, since we cannot scope this variable intelligently, we instead keep one
-// instance of it as a static variable, so it is always avaible to plugins when they
-// ask for the time.
-static VstTimeInfo vstTimeInfo;
+// Each plugin owns its own VstTimeInfo struct, which is found through the AEffect's
+// resvd1 field. However, plugins may ask for the time before that field has been set
+// during initialization, so a thread-local fallback instance is kept here.
+static THREAD_LOCAL VstTimeInfo vstTimeInfo;
 
 extern "C" {
 // Current plugin ID, which is mostly used by shell plugins during initialization.
 // Instance declared in PluginVst2x.cpp, see explanation for the global-ness and
 // need of this variable there.
-extern VstInt32 currentPluginUniqueId;
+extern THREAD_LOCAL VstInt32 currentPluginUniqueId;
 
 static int _canHostDo(const char* pluginName, const char* canDoString) {
   boolByte supported = false;
@@ -138,6 +142,15 @@ VstIntPtr VSTCALLBACK pluginVst2xHostCallback(AEffect *effect, VstInt32 opcode,
   }
   const char* pluginIdString = pluginId->idString->data;
   VstIntPtr result = 0;
+  // The resvd1 field is set once the plugin has been loaded, see _openVst2xPlugin()
+  Plugin plugin = (effect != NULL) ? (Plugin)effect->resvd1 : NULL;
+  EngineContext previousContext = getCurrentEngineContext();
+
+  // Plugins may call the host from their own threads, so always answer with the
+  // settings and clock of the context which the plugin belongs to.
+  if(plugin != NULL && pluginVst2xGetEngineContext(plugin) != NULL) {
+    engineContextMakeCurrent(pluginVst2xGetEngineContext(plugin));
+  }
 
   logDebug("Plugin '%s' called host dispatcher with %d, %d, %d", pluginIdString, opcode, index, value);
   switch(opcode) {
@@ -168,15 +181,16 @@ VstIntPtr VSTCALLBACK pluginVst2xHostCallback(AEffect *effect, VstInt32 opcode,
       break;
     case audioMasterGetTime: {
       AudioClock audioClock = getAudioClock();
+      VstTimeInfo* timeInfo = (plugin != NULL) ? pluginVst2xGetTimeInfo(plugin) : &vstTimeInfo;
 
       // These values are always valid
-      vstTimeInfo.samplePos = audioClock->currentFrame;
-      vstTimeInfo.sampleRate = getSampleRate();
+      timeInfo->samplePos = audioClock->currentFrame;
+      timeInfo->sampleRate = getSampleRate();
 
       // Set flags for transport state
-      vstTimeInfo.flags = 0;
-      vstTimeInfo.flags |= audioClock->transportChanged ? kVstTransportChanged : 0;
-      vstTimeInfo.flags |= audioClock->isPlaying ? kVstTransportPlaying : 0;
+      timeInfo->flags = 0;
+      timeInfo->flags |= audioClock->transportChanged ? kVstTransportChanged : 0;
+      timeInfo->flags |= audioClock->isPlaying ? kVstTransportPlaying : 0;
 
       // Fill values based on other flags which may have been requested
       if(value & kVstNanosValid) {
@@ -190,31 +204,31 @@ VstIntPtr VSTCALLBACK pluginVst2xHostCallback(AEffect *effect, VstInt32 opcode,
         // TODO: Move calculations to AudioClock
         double samplesPerBeat = (60.0 / getTempo()) * getSampleRate();
         // Musical time starts with 1, not 0
-        vstTimeInfo.ppqPos = (vstTimeInfo.samplePos / samplesPerBeat) + 1.0;
-        logDebug("Current PPQ position is %g", vstTimeInfo.ppqPos);
-        vstTimeInfo.flags |= kVstPpqPosValid;
+        timeInfo->ppqPos = (timeInfo->samplePos / samplesPerBeat) + 1.0;
+        logDebug("Current PPQ position is %g", timeInfo->ppqPos);
+        timeInfo->flags |= kVstPpqPosValid;
       }
       if(value & kVstTempoValid) {
-        vstTimeInfo.tempo = getTempo();
-        vstTimeInfo.flags |= kVstTempoValid;
+        timeInfo->tempo = getTempo();
+        timeInfo->flags |= kVstTempoValid;
       }
       if(value & kVstBarsValid) {
         if(!(value & kVstPpqPosValid)) {
           logError("Plugin requested position in bars, but not PPQ");
         }
         // TODO: Move calculations to AudioClock
-        double currentBarPos = floor(vstTimeInfo.ppqPos / (double)getTimeSignatureBeatsPerMeasure());
-        vstTimeInfo.barStartPos = currentBarPos * (double)getTimeSignatureBeatsPerMeasure() + 1.0;
-        logDebug("Current bar is %g", vstTimeInfo.barStartPos);
-        vstTimeInfo.flags |= kVstBarsValid;
+        double currentBarPos = floor(timeInfo->ppqPos / (double)getTimeSignatureBeatsPerMeasure());
+        timeInfo->barStartPos = currentBarPos * (double)getTimeSignatureBeatsPerMeasure() + 1.0;
+        logDebug("Current bar is %g", timeInfo->barStartPos);
+        timeInfo->flags |= kVstBarsValid;
       }
       if(value & kVstCyclePosValid) {
         // We don't support cycling, so this is always 0
       }
       if(value & kVstTimeSigValid) {
-        vstTimeInfo.timeSigNumerator = getTimeSignatureBeatsPerMeasure();
-        vstTimeInfo.timeSigDenominator = getTimeSignatureNoteValue();
-        vstTimeInfo.flags |= kVstTimeSigValid;
+        timeInfo->timeSigNumerator = getTimeSignatureBeatsPerMeasure();
+        timeInfo->timeSigDenominator = getTimeSignatureNoteValue();
+        timeInfo->flags |= kVstTimeSigValid;
       }
       if(value & kVstSmpteValid) {
         logUnsupportedFeature("Current time in SMPTE format");
@@ -223,7 +237,7 @@ VstIntPtr VSTCALLBACK pluginVst2xHostCallback(AEffect *effect, VstInt32 opcode,
         logUnsupportedFeature("Sample frames until next clock");
       }
 
-      result = (VstIntPtr)&vstTimeInfo;
+      result = (VstIntPtr)timeInfo;
       break;
     }
     case audioMasterProcessEvents:
@@ -381,6 +395,7 @@ VstIntPtr VSTCALLBACK pluginVst2xHostCallback(AEffect *effect, VstInt32 opcode,
       break;
   }
 
+  engineContextMakeCurrent(previousContext);
   freePluginVst2xId(pluginId);
   return result;
 }
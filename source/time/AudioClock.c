@@ -28,19 +28,35 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "app/EngineContext.h"
 #include "time/AudioClock.h"
 
 AudioClock audioClockInstance = NULL;
 
+// Location of the instance used by the calling thread
+static AudioClock* _getAudioClockInstance(void) {
+  EngineContext context = getCurrentEngineContext();
+  return context != NULL ? &context->audioClock : &audioClockInstance;
+}
+
+AudioClock newAudioClock(void) {
+  AudioClock audioClock = (AudioClock)malloc(sizeof(AudioClockMembers));
+  audioClock->currentFrame = 0;
+  audioClock->transportChanged = false;
+  audioClock->isPlaying = false;
+  return audioClock;
+}
+
 void initAudioClock(void) {
-  audioClockInstance = (AudioClock)malloc(sizeof(AudioClockMembers));
-  audioClockInstance->currentFrame = 0;
-  audioClockInstance->transportChanged = false;
-  audioClockInstance->isPlaying = false;
+  AudioClock* instance = _getAudioClockInstance();
+  if(*instance != NULL) {
+    freeAudioClock(*instance);
+  }
+  *instance = newAudioClock();
 }
 
 AudioClock getAudioClock(void) {
-  return audioClockInstance;
+  return *_getAudioClockInstance();
 }
 
 void advanceAudioClock(AudioClock self, const unsigned long blocksize) {
@@ -59,9 +75,19 @@ void audioClockStop(AudioClock self) {
   self->transportChanged = true;
 }
 
+void audioClockReset(AudioClock self) {
+  self->currentFrame = 0;
+  self->transportChanged = false;
+  self->isPlaying = false;
+}
+
 void freeAudioClock(AudioClock self) {
+  AudioClock* instance;
   if(self != NULL) {
+    instance = _getAudioClockInstance();
+    if(*instance == self) {
+      *instance = NULL;
+    }
     free(self);
-    self = NULL;
   }
 }
@@ -32,9 +32,10 @@
 
 /**
  * The AudioClock class keeps track of the sequence time and delivers the
- * position in a variety of formats. Unlike most other classes, this one
- * maintains a singleton instance because it must be accessed from C++
- * callbacks where it is difficult to pass a void* pointer.
+ * position in a variety of formats. Unlike most other classes, this one is
+ * reached through getAudioClock() because it must be accessed from C++
+ * callbacks where it is difficult to pass a void* pointer. That instance
+ * belongs to the current EngineContext, or is global if no context is current.
  */
 
 typedef struct {
@@ -46,16 +47,23 @@ typedef AudioClockMembers* AudioClock;
 extern AudioClock audioClockInstance;
 
 /**
- * Initialize the global audio clock instance. Should be called fairly
+ * Create a new audio clock positioned at the first frame. This is mostly used
+ * by EngineContext, other code should use getAudioClock().
+ * @return Initialized AudioClock
+ */
+AudioClock newAudioClock(void);
+
+/**
+ * Initialize the current audio clock instance. Should be called fairly
  * early in the program initialization, as other components may depend
  * on knowing the current position.
  */
 void initAudioClock(void);
 
 /**
- * Get a reference to the global audio clock instance.
- * @return Reference to global audio clock, or NULL if the global instance has
- * not yet been initialized.
+ * Get a reference to the current audio clock instance.
+ * @return Reference to the audio clock, or NULL if it has not yet been
+ * initialized.
  */
 AudioClock getAudioClock(void);
 
@@ -73,6 +81,13 @@ void advanceAudioClock(AudioClock self, const unsigned long blocksize);
  */
 void audioClockStop(AudioClock self);
 
+/**
+ * Rewind the clock to the first frame and stop playback, as if the clock had
+ * just been initialized.
+ * @param self
+ */
+void audioClockReset(AudioClock self);
+
 /**
  * Free an audio clock instance and its associated resources.
  * @param self
@@ -0,0 +1,210 @@
+//
+// RealtimeScheduler.c - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "base/PlatformUtilities.h"
+#include "logging/EventLogger.h"
+#include "time/RealtimeScheduler.h"
+
+#if LINUX
+#include <errno.h>
+#include <time.h>
+#elif MACOSX
+#include <mach/mach_time.h>
+#endif
+
+// Upper limits of the histogram buckets, the last bucket has no limit
+static const double kRealtimeSchedulerBucketLimitsInMs[REALTIME_SCHEDULER_HISTOGRAM_SIZE - 1] = {
+  1.0, 2.0, 5.0, 10.0, 20.0, 50.0, 100.0
+};
+
+RealtimeScheduler newRealtimeScheduler(void) {
+  RealtimeScheduler scheduler = (RealtimeScheduler)malloc(sizeof(RealtimeSchedulerMembers));
+#if WINDOWS
+  LARGE_INTEGER queryFrequency;
+#elif MACOSX
+  mach_timebase_info_data_t timebase;
+#endif
+
+  scheduler->numBlocks = 0;
+  scheduler->numLateBlocks = 0;
+  scheduler->maxLatenessInMs = 0.0;
+  memset(scheduler->latenessHistogram, 0, sizeof(scheduler->latenessHistogram));
+  scheduler->_started = false;
+  scheduler->_deadline = 0.0;
+
+#if WINDOWS
+  QueryPerformanceFrequency(&queryFrequency);
+  scheduler->_counterFrequency = (double)(queryFrequency.QuadPart) / 1000.0;
+#elif MACOSX
+  mach_timebase_info(&timebase);
+  scheduler->_timebaseToMs = (double)timebase.numer / (double)timebase.denom / 1000000.0;
+#endif
+
+  return scheduler;
+}
+
+static double _getMonotonicTimeInMs(RealtimeScheduler self) {
+#if LINUX
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+#elif MACOSX
+  return (double)mach_absolute_time() * self->_timebaseToMs;
+#elif WINDOWS
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return (double)now.QuadPart / self->_counterFrequency;
+#else
+  return 0.0;
+#endif
+}
+
+static void _sleepUntil(RealtimeScheduler self, double deadline) {
+#if LINUX
+  struct timespec deadlineTime;
+  deadlineTime.tv_sec = (time_t)(deadline / 1000.0);
+  deadlineTime.tv_nsec = (long)((deadline - (double)deadlineTime.tv_sec * 1000.0) * 1000000.0);
+  // Restart if interrupted by a signal, the deadline stays the same
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadlineTime, NULL) == EINTR);
+#elif MACOSX
+  mach_wait_until((uint64_t)(deadline / self->_timebaseToMs));
+#else
+  // No absolute sleep here, but the deadline still prevents drift
+  sleepMilliseconds(deadline - _getMonotonicTimeInMs(self));
+#endif
+}
+
+void realtimeSchedulerRestart(RealtimeScheduler self) {
+  self->_started = false;
+}
+
+static void _recordLateBlock(RealtimeScheduler self, double latenessInMs) {
+  unsigned int bucket;
+
+  self->numLateBlocks++;
+  if(latenessInMs > self->maxLatenessInMs) {
+    self->maxLatenessInMs = latenessInMs;
+  }
+  for(bucket = 0; bucket < REALTIME_SCHEDULER_HISTOGRAM_SIZE - 1; bucket++) {
+    if(latenessInMs < kRealtimeSchedulerBucketLimitsInMs[bucket]) {
+      break;
+    }
+  }
+  self->latenessHistogram[bucket]++;
+}
+
+double realtimeSchedulerWaitForBlock(RealtimeScheduler self, double blockDurationInMs) {
+  double now = _getMonotonicTimeInMs(self);
+  double latenessInMs;
+
+  if(!self->_started) {
+    // The first block of a schedule has no deadline to miss
+    self->_deadline = now;
+    self->_started = true;
+  }
+  self->_deadline += blockDurationInMs;
+  self->numBlocks++;
+
+  if(now < self->_deadline) {
+    _sleepUntil(self, self->_deadline);
+    return 0.0;
+  }
+
+  // The deadline is not moved, so the next blocks are not slept for until
+  // processing has caught up with the schedule
+  latenessInMs = now - self->_deadline;
+  _recordLateBlock(self, latenessInMs);
+  return latenessInMs;
+}
+
+double realtimeSchedulerGetHistogramBucketLimitInMs(unsigned int bucket) {
+  return bucket < REALTIME_SCHEDULER_HISTOGRAM_SIZE - 1 ? kRealtimeSchedulerBucketLimitsInMs[bucket] : -1.0;
+}
+
+void realtimeSchedulerPrintStats(RealtimeScheduler self) {
+  unsigned int i;
+  double lowerLimit = 0.0;
+
+  logInfo("Realtime: %lu of %lu blocks were late, worst lateness %.2fms",
+    self->numLateBlocks, self->numBlocks, self->maxLatenessInMs);
+  for(i = 0; i < REALTIME_SCHEDULER_HISTOGRAM_SIZE; i++) {
+    if(self->latenessHistogram[i] > 0) {
+      if(i < REALTIME_SCHEDULER_HISTOGRAM_SIZE - 1) {
+        logInfo("  %.0f-%.0fms late: %lu blocks", lowerLimit, kRealtimeSchedulerBucketLimitsInMs[i],
+          self->latenessHistogram[i]);
+      }
+      else {
+        logInfo("  %.0fms or more late: %lu blocks", lowerLimit, self->latenessHistogram[i]);
+      }
+    }
+    if(i < REALTIME_SCHEDULER_HISTOGRAM_SIZE - 1) {
+      lowerLimit = kRealtimeSchedulerBucketLimitsInMs[i];
+    }
+  }
+}
+
+boolByte realtimeSchedulerWriteStats(RealtimeScheduler self, const CharString filename) {
+  FILE* fileHandle = fopen(filename->data, "w");
+  unsigned int i;
+  double limit;
+
+  if(fileHandle == NULL) {
+    logError("Could not open '%s' for writing realtime statistics", filename->data);
+    return false;
+  }
+
+  fprintf(fileHandle, "{\n");
+  fprintf(fileHandle, "  \"blocks\": %lu,\n", self->numBlocks);
+  fprintf(fileHandle, "  \"lateBlocks\": %lu,\n", self->numLateBlocks);
+  fprintf(fileHandle, "  \"maxLatenessMs\": %.3f,\n", self->maxLatenessInMs);
+  fprintf(fileHandle, "  \"latenessHistogram\": [\n");
+  for(i = 0; i < REALTIME_SCHEDULER_HISTOGRAM_SIZE; i++) {
+    limit = realtimeSchedulerGetHistogramBucketLimitInMs(i);
+    if(limit < 0.0) {
+      fprintf(fileHandle, "    {\"limitMs\": null, \"blocks\": %lu}\n", self->latenessHistogram[i]);
+    }
+    else {
+      fprintf(fileHandle, "    {\"limitMs\": %.0f, \"blocks\": %lu},\n", limit, self->latenessHistogram[i]);
+    }
+  }
+  fprintf(fileHandle, "  ]\n");
+  fprintf(fileHandle, "}\n");
+
+  if(fclose(fileHandle) != 0) {
+    logError("Could not write realtime statistics to '%s'", filename->data);
+    return false;
+  }
+  return true;
+}
+
+void freeRealtimeScheduler(RealtimeScheduler self) {
+  free(self);
+}
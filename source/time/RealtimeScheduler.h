@@ -0,0 +1,116 @@
+//
+// RealtimeScheduler.h - MrsWatson
+// Created by agent on 18 Oct 26.
+// Copyright (c) 2026 Teragon Audio. All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MrsWatson_RealtimeScheduler_h
+#define MrsWatson_RealtimeScheduler_h
+
+#include "base/CharString.h"
+#include "base/Types.h"
+
+#define REALTIME_SCHEDULER_HISTOGRAM_SIZE 8
+
+/**
+ * Paces processing to realtime for --realtime. Each block has a deadline on a
+ * monotonic clock, which is the previous block's deadline plus the duration of
+ * the block, and the scheduler sleeps until that absolute time. Unlike
+ * sleeping for the time left in each block, this does not drift over long
+ * streams, and time spent outside of the plugin chain (ie, reading the input
+ * source) is accounted for. Blocks which finish after their deadline are
+ * counted as late, and following blocks are processed without sleeping until
+ * the schedule has caught up again.
+ */
+typedef struct {
+  unsigned long numBlocks;
+  unsigned long numLateBlocks;
+  double maxLatenessInMs;
+  // Number of late blocks by lateness, see realtimeSchedulerGetHistogramBucketLimitInMs()
+  unsigned long latenessHistogram[REALTIME_SCHEDULER_HISTOGRAM_SIZE];
+
+  boolByte _started;
+  // Deadline of the last block, in milliseconds on the monotonic clock
+  double _deadline;
+#if WINDOWS
+  double _counterFrequency;
+#elif MACOSX
+  double _timebaseToMs;
+#endif
+} RealtimeSchedulerMembers;
+typedef RealtimeSchedulerMembers* RealtimeScheduler;
+
+/**
+ * Create a new scheduler. The schedule starts with the first block.
+ * @return Initialized RealtimeScheduler
+ */
+RealtimeScheduler newRealtimeScheduler(void);
+
+/**
+ * Start a new schedule with the next block, for instance when a new render is
+ * started with the same plugin chain. Statistics are kept.
+ * @param self
+ */
+void realtimeSchedulerRestart(RealtimeScheduler self);
+
+/**
+ * Called after a block has been processed, and sleeps until the block's
+ * deadline. If the deadline has already passed, the block is counted as late
+ * and this returns right away.
+ * @param self
+ * @param blockDurationInMs Duration of the block's audio
+ * @return How late the block was in milliseconds, or 0 if it was on time
+ */
+double realtimeSchedulerWaitForBlock(RealtimeScheduler self, double blockDurationInMs);
+
+/**
+ * Get the upper limit for a bucket of the lateness histogram. A late block is
+ * counted in the first bucket whose limit is greater than its lateness.
+ * @param bucket Index of the bucket
+ * @return Limit in milliseconds, or a negative value for the last bucket,
+ * which has no upper limit
+ */
+double realtimeSchedulerGetHistogramBucketLimitInMs(unsigned int bucket);
+
+/**
+ * Log a summary of the statistics
+ * @param self
+ */
+void realtimeSchedulerPrintStats(RealtimeScheduler self);
+
+/**
+ * Write the statistics to a file as a JSON object, for use by other programs.
+ * @param self
+ * @param filename File to write
+ * @return True on success
+ */
+boolByte realtimeSchedulerWriteStats(RealtimeScheduler self, const CharString filename);
+
+/**
+ * Free a scheduler
+ * @param self
+ */
+void freeRealtimeScheduler(RealtimeScheduler self);
+
+#endif
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "unit/TestRunner.h"
+#include "app/BatchManifest.h"
+
+#if UNIX
+#define TEST_MANIFEST_FILE "/tmp/mrswatsontest-manifest.txt"
+#elif WINDOWS
+#define TEST_MANIFEST_FILE "C:\\Temp\\mrswatsontest-manifest.txt"
+#else
+#define TEST_MANIFEST_FILE "mrswatsontest-manifest.txt"
+#endif
+
+static void _batchManifestTeardown(void) {
+  unlink(TEST_MANIFEST_FILE);
+}
+
+static BatchJob _newBatchJobWithCString(const char* line) {
+  CharString c = newCharStringWithCString(line);
+  BatchJob job = newBatchJobWithManifestLine(c);
+  freeCharString(c);
+  return job;
+}
+
+static int _testParseJobWithInputAndOutput(void) {
+  BatchJob job = _newBatchJobWithCString("in.wav,out.wav");
+  assertNotNull(job);
+  assertCharStringEquals(job->inputSource, "in.wav");
+  assertCharStringEquals(job->outputSource, "out.wav");
+  assert(charStringIsEmpty(job->midiSource));
+  freeBatchJob(job);
+  return 0;
+}
+
+static int _testParseJobWithAllFields(void) {
+  BatchJob job = _newBatchJobWithCString("in.wav,out.wav,song.mid");
+  assertNotNull(job);
+  assertCharStringEquals(job->inputSource, "in.wav");
+  assertCharStringEquals(job->outputSource, "out.wav");
+  assertCharStringEquals(job->midiSource, "song.mid");
+  freeBatchJob(job);
+  return 0;
+}
+
+static int _testParseJobWithEmptyInput(void) {
+  BatchJob job = _newBatchJobWithCString(",out.wav,song.mid");
+  assertNotNull(job);
+  assert(charStringIsEmpty(job->inputSource));
+  assertCharStringEquals(job->outputSource, "out.wav");
+  assertCharStringEquals(job->midiSource, "song.mid");
+  freeBatchJob(job);
+  return 0;
+}
+
+static int _testParseJobWithPathSpaces(void) {
+  BatchJob job = _newBatchJobWithCString("my input.pcm,my output.pcm");
+  assertNotNull(job);
+  assertCharStringEquals(job->inputSource, "my input.pcm");
+  assertCharStringEquals(job->outputSource, "my output.pcm");
+  freeBatchJob(job);
+  return 0;
+}
+
+static int _testParseInvalidJobs(void) {
+  assertIsNull(_newBatchJobWithCString("in.wav"));
+  assertIsNull(_newBatchJobWithCString("in.wav,"));
+  assertIsNull(_newBatchJobWithCString(",out.wav"));
+  assertIsNull(_newBatchJobWithCString("a,b,c,d"));
+  assertIsNull(newBatchJobWithManifestLine(NULL));
+  return 0;
+}
+
+static int _testReadManifest(void) {
+  CharString filename = newCharStringWithCString(TEST_MANIFEST_FILE);
+  FILE* fp = fopen(TEST_MANIFEST_FILE, "w");
+  LinkedList jobs;
+  BatchJob job;
+
+  fprintf(fp, "# Comment line\n\na.pcm,a-out.pcm\n,b-out.pcm,b.mid\n");
+  fclose(fp);
+  jobs = batchManifestReadJobs(filename);
+  assertNotNull(jobs);
+  assertIntEquals(linkedListLength(jobs), 2);
+  job = (BatchJob)jobs->item;
+  assertCharStringEquals(job->outputSource, "a-out.pcm");
+  job = (BatchJob)((LinkedListIterator)jobs->nextItem)->item;
+  assertCharStringEquals(job->midiSource, "b.mid");
+
+  freeLinkedListAndItems(jobs, (LinkedListFreeItemFunc)freeBatchJob);
+  freeCharString(filename);
+  return 0;
+}
+
+static int _testReadManifestWithInvalidLine(void) {
+  CharString filename = newCharStringWithCString(TEST_MANIFEST_FILE);
+  FILE* fp = fopen(TEST_MANIFEST_FILE, "w");
+  fprintf(fp, "a.pcm,a-out.pcm\ninvalid\n");
+  fclose(fp);
+  assertIsNull(batchManifestReadJobs(filename));
+  freeCharString(filename);
+  return 0;
+}
+
+static int _testReadInvalidManifest(void) {
+  CharString filename = newCharStringWithCString("invalid");
+  assertIsNull(batchManifestReadJobs(filename));
+  assertIsNull(batchManifestReadJobs(NULL));
+  freeCharString(filename);
+  return 0;
+}
+
+TestSuite addBatchManifestTests(void);
+TestSuite addBatchManifestTests(void) {
+  TestSuite testSuite = newTestSuite("BatchManifest", NULL, _batchManifestTeardown);
+  addTest(testSuite, "ParseJobWithInputAndOutput", _testParseJobWithInputAndOutput);
+  addTest(testSuite, "ParseJobWithAllFields", _testParseJobWithAllFields);
+  addTest(testSuite, "ParseJobWithEmptyInput", _testParseJobWithEmptyInput);
+  addTest(testSuite, "ParseJobWithPathSpaces", _testParseJobWithPathSpaces);
+  addTest(testSuite, "ParseInvalidJobs", _testParseInvalidJobs);
+  addTest(testSuite, "ReadManifest", _testReadManifest);
+  addTest(testSuite, "ReadManifestWithInvalidLine", _testReadManifestWithInvalidLine);
+  addTest(testSuite, "ReadInvalidManifest", _testReadInvalidManifest);
+  return testSuite;
+}
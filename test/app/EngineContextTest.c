@@ -0,0 +1,132 @@
+#include "unit/TestRunner.h"
+#include "app/EngineContext.h"
+#include "base/Thread.h"
+
+static void _engineContextTestTeardown(void) {
+  engineContextMakeCurrent(NULL);
+}
+
+static int _testNewEngineContext(void) {
+  EngineContext c = newEngineContext();
+  assertNotNull(c);
+  assertNotNull(c->audioSettings);
+  assertNotNull(c->audioClock);
+  assertNotNull(c->pluginChain);
+  assertNotNull(c->eventLogger);
+  assertDoubleEquals(c->audioSettings->sampleRate, DEFAULT_SAMPLE_RATE, TEST_FLOAT_TOLERANCE);
+  assertIntEquals(c->pluginChain->numPlugins, 0);
+  assertUnsignedLongEquals(c->audioClock->currentFrame, 0l);
+  freeEngineContext(c);
+  return 0;
+}
+
+static int _testNoCurrentEngineContext(void) {
+  assertIsNull(getCurrentEngineContext());
+  return 0;
+}
+
+static int _testMakeEngineContextCurrent(void) {
+  EngineContext c = newEngineContext();
+  engineContextMakeCurrent(c);
+  assert(getCurrentEngineContext() == c);
+  assert(getAudioClock() == c->audioClock);
+  assert(getPluginChain() == c->pluginChain);
+  engineContextMakeCurrent(NULL);
+  assertIsNull(getCurrentEngineContext());
+  freeEngineContext(c);
+  return 0;
+}
+
+static int _testSettingsAreSeparateFromGlobal(void) {
+  EngineContext c = newEngineContext();
+  double globalSampleRate = getSampleRate();
+  double contextSampleRate = globalSampleRate + 1000.0;
+
+  engineContextMakeCurrent(c);
+  setSampleRate(contextSampleRate);
+  assertDoubleEquals(getSampleRate(), contextSampleRate, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(c->audioSettings->sampleRate, contextSampleRate, TEST_FLOAT_TOLERANCE);
+  engineContextMakeCurrent(NULL);
+  assertDoubleEquals(getSampleRate(), globalSampleRate, TEST_FLOAT_TOLERANCE);
+
+  freeEngineContext(c);
+  return 0;
+}
+
+static int _testInitReplacesContextInstances(void) {
+  EngineContext c = newEngineContext();
+  AudioClock globalClock = getAudioClock();
+
+  engineContextMakeCurrent(c);
+  advanceAudioClock(getAudioClock(), 100);
+  initAudioClock();
+  assert(getAudioClock() == c->audioClock);
+  assertUnsignedLongEquals(c->audioClock->currentFrame, 0l);
+  freeAudioClock(getAudioClock());
+  assertIsNull(c->audioClock);
+  engineContextMakeCurrent(NULL);
+  assert(getAudioClock() == globalClock);
+
+  freeEngineContext(c);
+  return 0;
+}
+
+static void* _engineContextTestThread(void* userData) {
+  EngineContext c = (EngineContext)userData;
+  const double sampleRate = c->audioSettings->sampleRate;
+  int i;
+
+  engineContextMakeCurrent(c);
+  for(i = 0; i < 1000; i++) {
+    threadYield();
+    if(getSampleRate() != sampleRate || getAudioClock() != c->audioClock) {
+      return c;
+    }
+    advanceAudioClock(getAudioClock(), 1);
+  }
+  engineContextMakeCurrent(NULL);
+  return NULL;
+}
+
+static int _testContextsOnSeparateThreads(void) {
+  EngineContext c1 = newEngineContext();
+  EngineContext c2 = newEngineContext();
+  Thread t1 = newThread(_engineContextTestThread, c1);
+  Thread t2 = newThread(_engineContextTestThread, c2);
+
+  c1->audioSettings->sampleRate = 44100.0;
+  c2->audioSettings->sampleRate = 96000.0;
+  assert(threadStart(t1));
+  assert(threadStart(t2));
+  threadJoin(t1);
+  threadJoin(t2);
+
+  assertUnsignedLongEquals(c1->audioClock->currentFrame, 1000l);
+  assertUnsignedLongEquals(c2->audioClock->currentFrame, 1000l);
+  assertDoubleEquals(c1->audioSettings->sampleRate, 44100.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(c2->audioSettings->sampleRate, 96000.0, TEST_FLOAT_TOLERANCE);
+
+  freeThread(t1);
+  freeThread(t2);
+  freeEngineContext(c1);
+  freeEngineContext(c2);
+  return 0;
+}
+
+static int _testFreeNullEngineContext(void) {
+  freeEngineContext(NULL);
+  return 0;
+}
+
+TestSuite addEngineContextTests(void);
+TestSuite addEngineContextTests(void) {
+  TestSuite testSuite = newTestSuite("EngineContext", NULL, _engineContextTestTeardown);
+  addTest(testSuite, "NewObject", _testNewEngineContext);
+  addTest(testSuite, "NoCurrentContext", _testNoCurrentEngineContext);
+  addTest(testSuite, "MakeContextCurrent", _testMakeEngineContextCurrent);
+  addTest(testSuite, "SettingsAreSeparateFromGlobal", _testSettingsAreSeparateFromGlobal);
+  addTest(testSuite, "InitReplacesContextInstances", _testInitReplacesContextInstances);
+  addTest(testSuite, "ContextsOnSeparateThreads", _testContextsOnSeparateThreads);
+  addTest(testSuite, "FreeNullEngineContext", _testFreeNullEngineContext);
+  return testSuite;
+}
@@ -0,0 +1,121 @@
+#include "unit/TestRunner.h"
+#include "app/PluginChainPool.h"
+
+static int _testNewPluginChainPool(void) {
+  PluginChainPool p = newPluginChainPool(2);
+  assertNotNull(p);
+  assertIntEquals(p->numEntries, 0);
+  assertIntEquals(p->maxEntries, 2);
+  freePluginChainPool(p);
+  return 0;
+}
+
+static int _testNewPluginChainPoolWithZeroSize(void) {
+  PluginChainPool p = newPluginChainPool(0);
+  assertIntEquals(p->maxEntries, 1);
+  freePluginChainPool(p);
+  return 0;
+}
+
+static int _testGetFromEmptyPool(void) {
+  PluginChainPool p = newPluginChainPool(2);
+  CharString k = newCharStringWithCString("again");
+  assertIsNull(pluginChainPoolGet(p, k));
+  freeCharString(k);
+  freePluginChainPool(p);
+  return 0;
+}
+
+static int _testAddAndGet(void) {
+  PluginChainPool p = newPluginChainPool(2);
+  CharString k = newCharStringWithCString("again");
+  EngineContext c = newEngineContext();
+  pluginChainPoolAdd(p, k, c);
+  assertIntEquals(p->numEntries, 1);
+  assert(pluginChainPoolGet(p, k) == c);
+  freeCharString(k);
+  freePluginChainPool(p);
+  return 0;
+}
+
+static int _testGetWithOtherKey(void) {
+  PluginChainPool p = newPluginChainPool(2);
+  CharString k = newCharStringWithCString("again");
+  CharString k2 = newCharStringWithCString("again,preset.fxp");
+  pluginChainPoolAdd(p, k, newEngineContext());
+  assertIsNull(pluginChainPoolGet(p, k2));
+  freeCharString(k);
+  freeCharString(k2);
+  freePluginChainPool(p);
+  return 0;
+}
+
+static int _testAddReplacesSameKey(void) {
+  PluginChainPool p = newPluginChainPool(2);
+  CharString k = newCharStringWithCString("again");
+  EngineContext c = newEngineContext();
+  pluginChainPoolAdd(p, k, newEngineContext());
+  pluginChainPoolAdd(p, k, c);
+  assertIntEquals(p->numEntries, 1);
+  assert(pluginChainPoolGet(p, k) == c);
+  freeCharString(k);
+  freePluginChainPool(p);
+  return 0;
+}
+
+static int _testAddEvictsLeastRecentlyUsed(void) {
+  PluginChainPool p = newPluginChainPool(2);
+  CharString k1 = newCharStringWithCString("a");
+  CharString k2 = newCharStringWithCString("b");
+  CharString k3 = newCharStringWithCString("c");
+  EngineContext c1 = newEngineContext();
+
+  pluginChainPoolAdd(p, k1, c1);
+  pluginChainPoolAdd(p, k2, newEngineContext());
+  // Using the first chain again makes the second one the oldest
+  assert(pluginChainPoolGet(p, k1) == c1);
+  pluginChainPoolAdd(p, k3, newEngineContext());
+  assertIntEquals(p->numEntries, 2);
+  assert(pluginChainPoolGet(p, k1) == c1);
+  assertIsNull(pluginChainPoolGet(p, k2));
+  assertNotNull(pluginChainPoolGet(p, k3));
+
+  freeCharString(k1);
+  freeCharString(k2);
+  freeCharString(k3);
+  freePluginChainPool(p);
+  return 0;
+}
+
+static int _testRemove(void) {
+  PluginChainPool p = newPluginChainPool(2);
+  CharString k = newCharStringWithCString("again");
+  pluginChainPoolAdd(p, k, newEngineContext());
+  assert(pluginChainPoolRemove(p, k));
+  assertIntEquals(p->numEntries, 0);
+  assertIsNull(pluginChainPoolGet(p, k));
+  assertFalse(pluginChainPoolRemove(p, k));
+  freeCharString(k);
+  freePluginChainPool(p);
+  return 0;
+}
+
+static int _testFreeNullPluginChainPool(void) {
+  freePluginChainPool(NULL);
+  return 0;
+}
+
+TestSuite addPluginChainPoolTests(void);
+TestSuite addPluginChainPoolTests(void) {
+  TestSuite testSuite = newTestSuite("PluginChainPool", NULL, NULL);
+  addTest(testSuite, "NewObject", _testNewPluginChainPool);
+  addTest(testSuite, "NewObjectWithZeroSize", _testNewPluginChainPoolWithZeroSize);
+  addTest(testSuite, "GetFromEmptyPool", _testGetFromEmptyPool);
+  addTest(testSuite, "AddAndGet", _testAddAndGet);
+  addTest(testSuite, "GetWithOtherKey", _testGetWithOtherKey);
+  addTest(testSuite, "AddReplacesSameKey", _testAddReplacesSameKey);
+  addTest(testSuite, "AddEvictsLeastRecentlyUsed", _testAddEvictsLeastRecentlyUsed);
+  addTest(testSuite, "Remove", _testRemove);
+  addTest(testSuite, "FreeNullPluginChainPool", _testFreeNullPluginChainPool);
+  return testSuite;
+}
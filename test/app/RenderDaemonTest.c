@@ -0,0 +1,210 @@
+#include "unit/TestRunner.h"
+#include "app/RenderDaemon.h"
+
+#if UNIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static const char* kRenderDaemonTestSocket = "mrswatson-test.sock";
+
+static int _testNewJobWithRequest(void) {
+  RenderDaemonJob j = newRenderDaemonJobWithRequest("--plugin again --input in.wav");
+  assertNotNull(j);
+  assertIntEquals(j->argc, 5);
+  // First argument is the program name, like a regular argv
+  assertNotNull(j->argv[0]);
+  assert(strcmp(j->argv[1], "--plugin") == 0);
+  assert(strcmp(j->argv[2], "again") == 0);
+  assert(strcmp(j->argv[3], "--input") == 0);
+  assert(strcmp(j->argv[4], "in.wav") == 0);
+  assertCharStringEquals(j->request, "--plugin again --input in.wav");
+  freeRenderDaemonJob(j);
+  return 0;
+}
+
+static int _testNewJobWithQuotedArguments(void) {
+  RenderDaemonJob j = newRenderDaemonJobWithRequest("--input \"my file.wav\" --plugin \"again;vstxsynth\"");
+  assertNotNull(j);
+  assertIntEquals(j->argc, 5);
+  assert(strcmp(j->argv[2], "my file.wav") == 0);
+  assert(strcmp(j->argv[4], "again;vstxsynth") == 0);
+  freeRenderDaemonJob(j);
+  return 0;
+}
+
+static int _testNewJobWithEmptyQuotedArgument(void) {
+  RenderDaemonJob j = newRenderDaemonJobWithRequest("--plugin-root \"\"");
+  assertNotNull(j);
+  assertIntEquals(j->argc, 3);
+  assert(strcmp(j->argv[2], "") == 0);
+  freeRenderDaemonJob(j);
+  return 0;
+}
+
+static int _testNewJobWithExtraWhitespace(void) {
+  RenderDaemonJob j = newRenderDaemonJobWithRequest("  --plugin \t again  ");
+  assertNotNull(j);
+  assertIntEquals(j->argc, 3);
+  assert(strcmp(j->argv[2], "again") == 0);
+  freeRenderDaemonJob(j);
+  return 0;
+}
+
+static int _testNewJobWithEmptyRequest(void) {
+  assertIsNull(newRenderDaemonJobWithRequest(""));
+  assertIsNull(newRenderDaemonJobWithRequest("   "));
+  assertIsNull(newRenderDaemonJobWithRequest(NULL));
+  return 0;
+}
+
+static int _testNewJobWithUnterminatedQuote(void) {
+  assertIsNull(newRenderDaemonJobWithRequest("--input \"in.wav"));
+  return 0;
+}
+
+static int _testShutdownRequest(void) {
+  RenderDaemonJob j = newRenderDaemonJobWithRequest(RENDER_DAEMON_SHUTDOWN_REQUEST);
+  RenderDaemonJob j2 = newRenderDaemonJobWithRequest("--plugin again");
+  assert(renderDaemonJobIsShutdownRequest(j));
+  assertFalse(renderDaemonJobIsShutdownRequest(j2));
+  freeRenderDaemonJob(j);
+  freeRenderDaemonJob(j2);
+  return 0;
+}
+
+static int _testSendMessageWithoutConnection(void) {
+  RenderDaemonJob j = newRenderDaemonJobWithRequest("--plugin again");
+  assertFalse(renderDaemonJobSendMessage(j, "done %d", 0));
+  freeRenderDaemonJob(j);
+  return 0;
+}
+
+#if UNIX
+static int _testAcceptJobFromClient(void) {
+  CharString socketPath = newCharStringWithCString(kRenderDaemonTestSocket);
+  RenderDaemon d = newRenderDaemon(socketPath);
+  RenderDaemonJob j;
+  struct sockaddr_un address;
+  const char* request = "--plugin again --output out.wav\n";
+  char reply[64];
+  ssize_t replyLength;
+  int client;
+
+  assert(renderDaemonListen(d));
+  client = socket(AF_UNIX, SOCK_STREAM, 0);
+  assert(client >= 0);
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, kRenderDaemonTestSocket, sizeof(address.sun_path) - 1);
+  assertIntEquals(connect(client, (struct sockaddr*)&address, sizeof(address)), 0);
+  // The connection is queued until accepted, so the request can be sent first
+  assertIntEquals((int)send(client, request, strlen(request), 0), (int)strlen(request));
+
+  j = renderDaemonAcceptJob(d);
+  assertNotNull(j);
+  assertIntEquals(j->argc, 5);
+  assert(strcmp(j->argv[4], "out.wav") == 0);
+  assert(renderDaemonJobSendMessage(j, "done %d", 0));
+  freeRenderDaemonJob(j);
+
+  replyLength = recv(client, reply, sizeof(reply) - 1, 0);
+  assertIntEquals((int)replyLength, 7);
+  reply[replyLength] = '\0';
+  assert(strcmp(reply, "done 0\n") == 0);
+
+  close(client);
+  freeRenderDaemon(d);
+  assertIntEquals(access(kRenderDaemonTestSocket, F_OK), -1);
+  freeCharString(socketPath);
+  return 0;
+}
+
+static int _testListenRefusesRegularFile(void) {
+  CharString socketPath = newCharStringWithCString(kRenderDaemonTestSocket);
+  RenderDaemon d = newRenderDaemon(socketPath);
+  FILE* fp = fopen(kRenderDaemonTestSocket, "w");
+
+  assertNotNull(fp);
+  fclose(fp);
+  assertFalse(renderDaemonListen(d));
+  // A mistyped socket path must not delete the user's file
+  assertIntEquals(access(kRenderDaemonTestSocket, F_OK), 0);
+
+  freeRenderDaemon(d);
+  unlink(kRenderDaemonTestSocket);
+  freeCharString(socketPath);
+  return 0;
+}
+
+static int _testListenReplacesStaleSocket(void) {
+  CharString socketPath = newCharStringWithCString(kRenderDaemonTestSocket);
+  RenderDaemon d = newRenderDaemon(socketPath);
+  struct sockaddr_un address;
+  int stale;
+
+  // Leave a socket file behind without anyone listening on it, as happens when
+  // a daemon is killed
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, kRenderDaemonTestSocket, sizeof(address.sun_path) - 1);
+  stale = socket(AF_UNIX, SOCK_STREAM, 0);
+  assert(stale >= 0);
+  assertIntEquals(bind(stale, (struct sockaddr*)&address, sizeof(address)), 0);
+  close(stale);
+
+  assert(renderDaemonListen(d));
+  freeRenderDaemon(d);
+  freeCharString(socketPath);
+  return 0;
+}
+
+static int _testListenRefusesRunningDaemon(void) {
+  CharString socketPath = newCharStringWithCString(kRenderDaemonTestSocket);
+  RenderDaemon running = newRenderDaemon(socketPath);
+  RenderDaemon d = newRenderDaemon(socketPath);
+
+  assert(renderDaemonListen(running));
+  assertFalse(renderDaemonListen(d));
+  freeRenderDaemon(d);
+  // The running daemon's socket must still be there
+  assertIntEquals(access(kRenderDaemonTestSocket, F_OK), 0);
+
+  freeRenderDaemon(running);
+  freeCharString(socketPath);
+  return 0;
+}
+#endif
+
+static int _testFreeNullRenderDaemon(void) {
+  freeRenderDaemon(NULL);
+  freeRenderDaemonJob(NULL);
+  return 0;
+}
+
+TestSuite addRenderDaemonTests(void);
+TestSuite addRenderDaemonTests(void) {
+  TestSuite testSuite = newTestSuite("RenderDaemon", NULL, NULL);
+  addTest(testSuite, "NewJobWithRequest", _testNewJobWithRequest);
+  addTest(testSuite, "NewJobWithQuotedArguments", _testNewJobWithQuotedArguments);
+  addTest(testSuite, "NewJobWithEmptyQuotedArgument", _testNewJobWithEmptyQuotedArgument);
+  addTest(testSuite, "NewJobWithExtraWhitespace", _testNewJobWithExtraWhitespace);
+  addTest(testSuite, "NewJobWithEmptyRequest", _testNewJobWithEmptyRequest);
+  addTest(testSuite, "NewJobWithUnterminatedQuote", _testNewJobWithUnterminatedQuote);
+  addTest(testSuite, "ShutdownRequest", _testShutdownRequest);
+  addTest(testSuite, "SendMessageWithoutConnection", _testSendMessageWithoutConnection);
+#if UNIX
+  addTest(testSuite, "AcceptJobFromClient", _testAcceptJobFromClient);
+  addTest(testSuite, "ListenRefusesRegularFile", _testListenRefusesRegularFile);
+  addTest(testSuite, "ListenReplacesStaleSocket", _testListenReplacesStaleSocket);
+  addTest(testSuite, "ListenRefusesRunningDaemon", _testListenRefusesRunningDaemon);
+#else
+  addTest(testSuite, "AcceptJobFromClient", NULL);
+  addTest(testSuite, "ListenRefusesRegularFile", NULL);
+  addTest(testSuite, "ListenReplacesStaleSocket", NULL);
+  addTest(testSuite, "ListenRefusesRunningDaemon", NULL);
+#endif
+  addTest(testSuite, "FreeNullRenderDaemon", _testFreeNullRenderDaemon);
+  return testSuite;
+}
@@ -0,0 +1,105 @@
+#include "unit/TestRunner.h"
+#include "app/RenderSegment.h"
+
+static RenderSegment _getSegment(LinkedList segments, int index) {
+  LinkedListIterator iterator = segments;
+  int i;
+  for(i = 0; i < index; i++) {
+    iterator = (LinkedListIterator)iterator->nextItem;
+  }
+  return (RenderSegment)iterator->item;
+}
+
+static void _freeSegments(LinkedList segments) {
+  freeLinkedListAndItems(segments, (LinkedListFreeItemFunc)freeRenderSegment);
+}
+
+static int _testSplitEvenly(void) {
+  LinkedList s = newRenderSegmentList(4096, 4, 0, 256);
+  int i;
+  assertIntEquals(linkedListLength(s), 4);
+  for(i = 0; i < 4; i++) {
+    assertUnsignedLongEquals(_getSegment(s, i)->startFrame, (unsigned long)(i * 1024));
+    assertUnsignedLongEquals(_getSegment(s, i)->numFrames, 1024ul);
+    assert(_getSegment(s, i)->isLast == (i == 3));
+  }
+  _freeSegments(s);
+  return 0;
+}
+
+static int _testSplitWithPartialLastBlock(void) {
+  // 9 blocks, where the last one is only 100 frames long
+  LinkedList s = newRenderSegmentList(8 * 256 + 100, 2, 0, 256);
+  assertIntEquals(linkedListLength(s), 2);
+  assertUnsignedLongEquals(_getSegment(s, 0)->startFrame, 0ul);
+  assertUnsignedLongEquals(_getSegment(s, 0)->numFrames, 5ul * 256);
+  assertUnsignedLongEquals(_getSegment(s, 1)->startFrame, 5ul * 256);
+  assertUnsignedLongEquals(_getSegment(s, 1)->numFrames, 3ul * 256 + 100);
+  _freeSegments(s);
+  return 0;
+}
+
+static int _testSplitCoversWholeInput(void) {
+  LinkedList s = newRenderSegmentList(123457, 7, 1000, 512);
+  LinkedListIterator iterator = s;
+  RenderSegment segment;
+  unsigned long nextFrame = 0;
+
+  while(iterator != NULL) {
+    segment = (RenderSegment)iterator->item;
+    assertUnsignedLongEquals(segment->startFrame, nextFrame);
+    assertUnsignedLongEquals(segment->startFrame % 512, 0ul);
+    nextFrame += segment->numFrames;
+    iterator = (LinkedListIterator)iterator->nextItem;
+  }
+  assertUnsignedLongEquals(nextFrame, 123457ul);
+  _freeSegments(s);
+  return 0;
+}
+
+static int _testMoreSegmentsThanBlocks(void) {
+  LinkedList s = newRenderSegmentList(3 * 256, 8, 0, 256);
+  assertIntEquals(linkedListLength(s), 3);
+  assert(_getSegment(s, 2)->isLast);
+  _freeSegments(s);
+  return 0;
+}
+
+static int _testEmptyInput(void) {
+  LinkedList s = newRenderSegmentList(0, 4, 0, 256);
+  assertIntEquals(linkedListLength(s), 1);
+  assertUnsignedLongEquals(_getSegment(s, 0)->numFrames, 0ul);
+  assert(_getSegment(s, 0)->isLast);
+  _freeSegments(s);
+  return 0;
+}
+
+static int _testWarmupRoundedToBlocks(void) {
+  LinkedList s = newRenderSegmentList(4096, 4, 300, 256);
+  assertUnsignedLongEquals(_getSegment(s, 0)->warmupFrames, 0ul);
+  assertUnsignedLongEquals(_getSegment(s, 1)->warmupFrames, 512ul);
+  assertUnsignedLongEquals(_getSegment(s, 3)->warmupFrames, 512ul);
+  _freeSegments(s);
+  return 0;
+}
+
+static int _testWarmupLimitedToStartOfInput(void) {
+  LinkedList s = newRenderSegmentList(4096, 4, 2000, 256);
+  assertUnsignedLongEquals(_getSegment(s, 1)->warmupFrames, 1024ul);
+  assertUnsignedLongEquals(_getSegment(s, 2)->warmupFrames, 2048ul);
+  _freeSegments(s);
+  return 0;
+}
+
+TestSuite addRenderSegmentTests(void);
+TestSuite addRenderSegmentTests(void) {
+  TestSuite testSuite = newTestSuite("RenderSegment", NULL, NULL);
+  addTest(testSuite, "SplitEvenly", _testSplitEvenly);
+  addTest(testSuite, "SplitWithPartialLastBlock", _testSplitWithPartialLastBlock);
+  addTest(testSuite, "SplitCoversWholeInput", _testSplitCoversWholeInput);
+  addTest(testSuite, "MoreSegmentsThanBlocks", _testMoreSegmentsThanBlocks);
+  addTest(testSuite, "EmptyInput", _testEmptyInput);
+  addTest(testSuite, "WarmupRoundedToBlocks", _testWarmupRoundedToBlocks);
+  addTest(testSuite, "WarmupLimitedToStartOfInput", _testWarmupLimitedToStartOfInput);
+  return testSuite;
+}
@@ -16,6 +16,8 @@ static int _testInitAudioSettings(void) {
   assertDoubleEquals(getTempo(), DEFAULT_TEMPO, TEST_FLOAT_TOLERANCE);
   assertIntEquals(getTimeSignatureBeatsPerMeasure(), DEFAULT_TIMESIG_BEATS_PER_MEASURE);
   assertIntEquals(getTimeSignatureNoteValue(), DEFAULT_TIMESIG_NOTE_VALUE);
+  assertIntEquals(getOutputSampleFormat(), DEFAULT_OUTPUT_SAMPLE_FORMAT);
+  assertIntEquals(getCompressionLevel(), DEFAULT_COMPRESSION_LEVEL);
   return 0;
 }
 
@@ -166,6 +168,37 @@ static int _testSetTimeSignatureFromNullString(void) {
   return 0;
 }
 
+static int _testSetOutputSampleFormatFromString(void) {
+  CharString s = newCharStringWithCString("float32");
+  assert(setOutputSampleFormatFromString(s));
+  assertIntEquals(getOutputSampleFormat(), PCM_SAMPLE_FORMAT_FLOAT32);
+  freeCharString(s);
+  return 0;
+}
+
+static int _testSetOutputSampleFormatFromInvalidString(void) {
+  CharString s = newCharStringWithCString("int12");
+  assert(setOutputSampleFormat(PCM_SAMPLE_FORMAT_INT24));
+  assertFalse(setOutputSampleFormatFromString(s));
+  assertFalse(setOutputSampleFormatFromString(NULL));
+  assertIntEquals(getOutputSampleFormat(), PCM_SAMPLE_FORMAT_INT24);
+  freeCharString(s);
+  return 0;
+}
+
+static int _testSetCompressionLevel(void) {
+  assert(setCompressionLevel(8));
+  assertIntEquals(getCompressionLevel(), 8);
+  return 0;
+}
+
+static int _testSetInvalidCompressionLevel(void) {
+  assert(setCompressionLevel(2));
+  assertFalse(setCompressionLevel(MAX_COMPRESSION_LEVEL + 1));
+  assertIntEquals(getCompressionLevel(), 2);
+  return 0;
+}
+
 TestSuite addAudioSettingsTests(void);
 TestSuite addAudioSettingsTests(void) {
   TestSuite testSuite = newTestSuite("AudioSettings", _audioSettingsSetup, _audioSettingsTeardown);
@@ -188,5 +221,10 @@ TestSuite addAudioSettingsTests(void) {
   addTest(testSuite, "SetTimeSignatureFromString", _testSetTimeSignatureFromString);
   addTest(testSuite, "SetTimeSignatureFromInvalidString", _testSetTimeSignatureFromInvalidString);
   addTest(testSuite, "SetTimeSignatureFromNullString", _testSetTimeSignatureFromNullString);
+
+  addTest(testSuite, "SetOutputSampleFormatFromString", _testSetOutputSampleFormatFromString);
+  addTest(testSuite, "SetOutputSampleFormatFromInvalidString", _testSetOutputSampleFormatFromInvalidString);
+  addTest(testSuite, "SetCompressionLevel", _testSetCompressionLevel);
+  addTest(testSuite, "SetInvalidCompressionLevel", _testSetInvalidCompressionLevel);
   return testSuite;
 }
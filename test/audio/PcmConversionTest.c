@@ -0,0 +1,319 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/PcmConversion.h"
+#include "base/PlatformUtilities.h"
+#include "unit/TestRunner.h"
+
+#define NUM_TEST_CHANNEL_COUNTS 5
+#define NUM_TEST_FRAME_COUNTS 4
+
+static const unsigned int _testChannelCounts[NUM_TEST_CHANNEL_COUNTS] = {1, 2, 3, 6, 8};
+// Includes sizes which are not a multiple of any vector width, and one which
+// spans several conversion chunks
+static const unsigned long _testFrameCounts[NUM_TEST_FRAME_COUNTS] = {1, 7, 37, 1500};
+
+static unsigned int _randomSeed;
+
+static byte _getRandomByte(void) {
+  _randomSeed = _randomSeed * 1103515245 + 12345;
+  return (byte)(_randomSeed >> 16);
+}
+
+static void _pcmConversionTestSetup(void) {
+  _randomSeed = 1;
+}
+
+static void _pcmConversionTestTeardown(void) {
+  int i;
+  // Go back to the fastest kernels, like the conversion functions would pick
+  for(i = PCM_INSTRUCTION_SET_NUM_SETS - 1; i >= 0; i--) {
+    if(pcmSetInstructionSet((PcmInstructionSet)i)) {
+      break;
+    }
+  }
+}
+
+static Samples* _newPlanarSamples(unsigned int numChannels, unsigned long numFrames) {
+  Samples* result = (Samples*)malloc(sizeof(Samples) * numChannels);
+  unsigned int i;
+  for(i = 0; i < numChannels; i++) {
+    result[i] = (Samples)calloc(numFrames, sizeof(Sample));
+  }
+  return result;
+}
+
+static void _freePlanarSamples(Samples* samples, unsigned int numChannels) {
+  unsigned int i;
+  for(i = 0; i < numChannels; i++) {
+    free(samples[i]);
+  }
+  free(samples);
+}
+
+static boolByte _deinterleaveMatchesScalar(PcmInstructionSet instructionSet, PcmSampleFormat format,
+  unsigned int numChannels, unsigned long numFrames) {
+  const unsigned long numBytes = numChannels * numFrames * pcmSampleFormatGetBytesPerSample(format);
+  byte* pcm = (byte*)malloc(numBytes);
+  Samples* expected = _newPlanarSamples(numChannels, numFrames);
+  Samples* actual = _newPlanarSamples(numChannels, numFrames);
+  boolByte result = true;
+  unsigned long i;
+  unsigned int channel;
+
+  // Random bytes cover every possible integer value. For floats this may
+  // produce NaNs, which should also be copied untouched.
+  for(i = 0; i < numBytes; i++) {
+    pcm[i] = _getRandomByte();
+  }
+
+  pcmSetInstructionSet(PCM_INSTRUCTION_SET_SCALAR);
+  pcmDeinterleaveSamples(pcm, format, expected, numChannels, numFrames);
+  pcmSetInstructionSet(instructionSet);
+  pcmDeinterleaveSamples(pcm, format, actual, numChannels, numFrames);
+  for(channel = 0; channel < numChannels; channel++) {
+    if(memcmp(expected[channel], actual[channel], sizeof(Sample) * numFrames) != 0) {
+      result = false;
+    }
+  }
+
+  free(pcm);
+  _freePlanarSamples(expected, numChannels);
+  _freePlanarSamples(actual, numChannels);
+  return result;
+}
+
+static boolByte _interleaveMatchesScalar(PcmInstructionSet instructionSet, PcmSampleFormat format,
+  unsigned int numChannels, unsigned long numFrames) {
+  const unsigned long numBytes = numChannels * numFrames * pcmSampleFormatGetBytesPerSample(format);
+  byte* expected = (byte*)calloc(numBytes, 1);
+  byte* actual = (byte*)calloc(numBytes, 1);
+  Samples* samples = _newPlanarSamples(numChannels, numFrames);
+  boolByte result;
+  unsigned long i;
+  unsigned int channel;
+
+  // Include values which must be clipped
+  for(channel = 0; channel < numChannels; channel++) {
+    for(i = 0; i < numFrames; i++) {
+      samples[channel][i] = ((Sample)_getRandomByte() - 128.0f) / 80.0f;
+    }
+  }
+
+  pcmSetInstructionSet(PCM_INSTRUCTION_SET_SCALAR);
+  pcmInterleaveSamples(samples, numChannels, numFrames, expected, format);
+  pcmSetInstructionSet(instructionSet);
+  pcmInterleaveSamples(samples, numChannels, numFrames, actual, format);
+  result = (boolByte)(memcmp(expected, actual, numBytes) == 0);
+
+  free(expected);
+  free(actual);
+  _freePlanarSamples(samples, numChannels);
+  return result;
+}
+
+static boolByte _flipEndianMatchesScalar(PcmInstructionSet instructionSet, PcmSampleFormat format,
+  unsigned int numChannels, unsigned long numFrames) {
+  const unsigned long numSamples = numChannels * numFrames;
+  const unsigned long numBytes = numSamples * pcmSampleFormatGetBytesPerSample(format);
+  byte* expected = (byte*)malloc(numBytes);
+  byte* actual = (byte*)malloc(numBytes);
+  boolByte result;
+  unsigned long i;
+
+  for(i = 0; i < numBytes; i++) {
+    expected[i] = _getRandomByte();
+  }
+  memcpy(actual, expected, numBytes);
+
+  pcmSetInstructionSet(PCM_INSTRUCTION_SET_SCALAR);
+  pcmFlipEndian(expected, format, numSamples);
+  pcmSetInstructionSet(instructionSet);
+  pcmFlipEndian(actual, format, numSamples);
+  result = (boolByte)(memcmp(expected, actual, numBytes) == 0);
+
+  free(expected);
+  free(actual);
+  return result;
+}
+
+static int _testGetBytesPerSample(void) {
+  assertIntEquals(pcmSampleFormatGetBytesPerSample(PCM_SAMPLE_FORMAT_INT16), 2);
+  assertIntEquals(pcmSampleFormatGetBytesPerSample(PCM_SAMPLE_FORMAT_INT24), 3);
+  assertIntEquals(pcmSampleFormatGetBytesPerSample(PCM_SAMPLE_FORMAT_INT32), 4);
+  assertIntEquals(pcmSampleFormatGetBytesPerSample(PCM_SAMPLE_FORMAT_FLOAT32), 4);
+  assertIntEquals(pcmSampleFormatGetBytesPerSample(PCM_SAMPLE_FORMAT_FLOAT64), 8);
+  return 0;
+}
+
+static int _testSampleFormatFromName(void) {
+  assertIntEquals(pcmSampleFormatFromName("int24"), PCM_SAMPLE_FORMAT_INT24);
+  assertIntEquals(pcmSampleFormatFromName("float64"), PCM_SAMPLE_FORMAT_FLOAT64);
+  assertIntEquals(pcmSampleFormatFromName("invalid"), PCM_SAMPLE_FORMAT_NUM_FORMATS);
+  assertIntEquals(pcmSampleFormatFromName(NULL), PCM_SAMPLE_FORMAT_NUM_FORMATS);
+  return 0;
+}
+
+static int _testScalarAlwaysSupported(void) {
+  assert(pcmIsInstructionSetSupported(PCM_INSTRUCTION_SET_SCALAR));
+  assert(pcmSetInstructionSet(PCM_INSTRUCTION_SET_SCALAR));
+  assertIntEquals(pcmGetInstructionSet(), PCM_INSTRUCTION_SET_SCALAR);
+  return 0;
+}
+
+static int _testSetUnsupportedInstructionSet(void) {
+  assertFalse(pcmSetInstructionSet(PCM_INSTRUCTION_SET_NUM_SETS));
+  return 0;
+}
+
+static int _testDeinterleaveInt16(void) {
+  const short pcm[6] = {32767, -32767, 0, 16384, -32768, 1};
+  Samples* samples = _newPlanarSamples(2, 3);
+  pcmDeinterleaveSamples(pcm, PCM_SAMPLE_FORMAT_INT16, samples, 2, 3);
+  assertDoubleEquals(samples[0][0], 1.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(samples[1][0], -1.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(samples[0][1], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(samples[1][1], 0.5, TEST_FLOAT_TOLERANCE);
+  // The smallest value can't be scaled symmetrically
+  assert(samples[0][2] < -1.0f);
+  _freePlanarSamples(samples, 2);
+  return 0;
+}
+
+static int _testDeinterleaveInt24(void) {
+  byte pcm[6];
+  Samples* samples = _newPlanarSamples(1, 2);
+  // Largest positive and negative values, in host byte order
+  if(isHostLittleEndian()) {
+    pcm[0] = 0xff; pcm[1] = 0xff; pcm[2] = 0x7f;
+    pcm[3] = 0x01; pcm[4] = 0x00; pcm[5] = 0x80;
+  }
+  else {
+    pcm[0] = 0x7f; pcm[1] = 0xff; pcm[2] = 0xff;
+    pcm[3] = 0x80; pcm[4] = 0x00; pcm[5] = 0x01;
+  }
+  pcmDeinterleaveSamples(pcm, PCM_SAMPLE_FORMAT_INT24, samples, 1, 2);
+  assertDoubleEquals(samples[0][0], 1.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(samples[0][1], -1.0, TEST_FLOAT_TOLERANCE);
+  _freePlanarSamples(samples, 1);
+  return 0;
+}
+
+static int _testInterleaveClipsSamples(void) {
+  short pcm[4];
+  Samples* samples = _newPlanarSamples(2, 2);
+  samples[0][0] = 2.0f;
+  samples[1][0] = -2.0f;
+  samples[0][1] = 0.5f;
+  samples[1][1] = -1.0f;
+  pcmInterleaveSamples(samples, 2, 2, pcm, PCM_SAMPLE_FORMAT_INT16);
+  assertIntEquals(pcm[0], 32767);
+  assertIntEquals(pcm[1], -32768);
+  assertIntEquals(pcm[2], 16384);
+  assertIntEquals(pcm[3], -32767);
+  _freePlanarSamples(samples, 2);
+  return 0;
+}
+
+static int _testConvertSamplesToInt(void) {
+  const Sample samples[4] = {2.0f, -2.0f, 0.5f, -1.0f};
+  int result[4];
+  pcmConvertSamplesToInt(samples, result, 4, 16);
+  assertIntEquals(result[0], 32767);
+  assertIntEquals(result[1], -32768);
+  assertIntEquals(result[2], 16384);
+  assertIntEquals(result[3], -32767);
+  pcmConvertSamplesToInt(samples, result, 4, 24);
+  assertIntEquals(result[0], 8388607);
+  assertIntEquals(result[1], -8388608);
+  return 0;
+}
+
+static int _testInt16RoundTrip(void) {
+  short pcm[256];
+  short result[256];
+  Samples* samples = _newPlanarSamples(2, 128);
+  int i;
+  for(i = 0; i < 256; i++) {
+    pcm[i] = (short)((i - 128) * 255);
+  }
+  pcmDeinterleaveSamples(pcm, PCM_SAMPLE_FORMAT_INT16, samples, 2, 128);
+  pcmInterleaveSamples(samples, 2, 128, result, PCM_SAMPLE_FORMAT_INT16);
+  assertIntEquals(memcmp(pcm, result, sizeof(pcm)), 0);
+  _freePlanarSamples(samples, 2);
+  return 0;
+}
+
+static int _testFlipEndian(void) {
+  byte pcm[6] = {1, 2, 3, 4, 5, 6};
+  pcmFlipEndian(pcm, PCM_SAMPLE_FORMAT_INT24, 2);
+  assertIntEquals(pcm[0], 3);
+  assertIntEquals(pcm[2], 1);
+  assertIntEquals(pcm[3], 6);
+  assertIntEquals(pcm[5], 4);
+  pcmFlipEndian(pcm, PCM_SAMPLE_FORMAT_INT16, 3);
+  assertIntEquals(pcm[0], 2);
+  assertIntEquals(pcm[1], 3);
+  return 0;
+}
+
+static int _testFlipEndianWideSamples(void) {
+  byte pcm[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  pcmFlipEndian(pcm, PCM_SAMPLE_FORMAT_FLOAT32, 2);
+  assertIntEquals(pcm[0], 4);
+  assertIntEquals(pcm[3], 1);
+  assertIntEquals(pcm[4], 8);
+  assertIntEquals(pcm[7], 5);
+  pcmFlipEndian(pcm, PCM_SAMPLE_FORMAT_FLOAT64, 1);
+  assertIntEquals(pcm[0], 5);
+  assertIntEquals(pcm[3], 8);
+  assertIntEquals(pcm[4], 1);
+  assertIntEquals(pcm[7], 4);
+  return 0;
+}
+
+static int _testKernelsMatchScalar(PcmInstructionSet instructionSet) {
+  int format;
+  unsigned int i, j;
+
+  if(!pcmIsInstructionSetSupported(instructionSet)) {
+    return 0;
+  }
+  for(format = 0; format < PCM_SAMPLE_FORMAT_NUM_FORMATS; format++) {
+    for(i = 0; i < NUM_TEST_CHANNEL_COUNTS; i++) {
+      for(j = 0; j < NUM_TEST_FRAME_COUNTS; j++) {
+        assert(_deinterleaveMatchesScalar(instructionSet, (PcmSampleFormat)format, _testChannelCounts[i], _testFrameCounts[j]));
+        assert(_interleaveMatchesScalar(instructionSet, (PcmSampleFormat)format, _testChannelCounts[i], _testFrameCounts[j]));
+        assert(_flipEndianMatchesScalar(instructionSet, (PcmSampleFormat)format, _testChannelCounts[i], _testFrameCounts[j]));
+      }
+    }
+  }
+  return 0;
+}
+
+static int _testSse2KernelsMatchScalar(void) {
+  return _testKernelsMatchScalar(PCM_INSTRUCTION_SET_SSE2);
+}
+
+static int _testAvx2KernelsMatchScalar(void) {
+  return _testKernelsMatchScalar(PCM_INSTRUCTION_SET_AVX2);
+}
+
+TestSuite addPcmConversionTests(void);
+TestSuite addPcmConversionTests(void) {
+  TestSuite testSuite = newTestSuite("PcmConversion", _pcmConversionTestSetup, _pcmConversionTestTeardown);
+  addTest(testSuite, "GetBytesPerSample", _testGetBytesPerSample);
+  addTest(testSuite, "SampleFormatFromName", _testSampleFormatFromName);
+  addTest(testSuite, "ScalarAlwaysSupported", _testScalarAlwaysSupported);
+  addTest(testSuite, "SetUnsupportedInstructionSet", _testSetUnsupportedInstructionSet);
+  addTest(testSuite, "DeinterleaveInt16", _testDeinterleaveInt16);
+  addTest(testSuite, "DeinterleaveInt24", _testDeinterleaveInt24);
+  addTest(testSuite, "InterleaveClipsSamples", _testInterleaveClipsSamples);
+  addTest(testSuite, "ConvertSamplesToInt", _testConvertSamplesToInt);
+  addTest(testSuite, "Int16RoundTrip", _testInt16RoundTrip);
+  addTest(testSuite, "FlipEndian", _testFlipEndian);
+  addTest(testSuite, "FlipEndianWideSamples", _testFlipEndianWideSamples);
+  addTest(testSuite, "Sse2KernelsMatchScalar", _testSse2KernelsMatchScalar);
+  addTest(testSuite, "Avx2KernelsMatchScalar", _testAvx2KernelsMatchScalar);
+  return testSuite;
+}
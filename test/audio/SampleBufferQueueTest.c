@@ -0,0 +1,289 @@
+#include "audio/SampleBufferQueue.h"
+#include "base/Thread.h"
+#include "unit/TestRunner.h"
+
+static const unsigned long kQueueTestNumBlocks = 1000;
+
+static int _testNewSampleBufferQueue(void) {
+  SampleBufferQueue q = newSampleBufferQueue(4, 2, 64);
+  assertNotNull(q);
+  assertUnsignedLongEquals(q->capacity, 4l);
+  assertIntEquals(q->buffers[0]->numChannels, 2);
+  assertUnsignedLongEquals(q->buffers[0]->blocksize, 64l);
+  assertUnsignedLongEquals(sampleBufferQueueGetOccupancy(q), 0l);
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testNewSampleBufferQueueWithZeroCapacity(void) {
+  SampleBufferQueue q = newSampleBufferQueue(0, 1, 1);
+  assertUnsignedLongEquals(q->capacity, 1l);
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testWriteAndReadBlock(void) {
+  SampleBufferQueue q = newSampleBufferQueue(2, 1, 8);
+  SampleBuffer b;
+  boolByte isLastBlock = true;
+
+  b = sampleBufferQueueAcquireWrite(q);
+  assertNotNull(b);
+  b->samples[0][0] = 0.5f;
+  sampleBufferQueueCommitWrite(q, false);
+  assertUnsignedLongEquals(sampleBufferQueueGetOccupancy(q), 1l);
+
+  b = sampleBufferQueueAcquireRead(q, &isLastBlock);
+  assertNotNull(b);
+  assertFalse(isLastBlock);
+  assertDoubleEquals(b->samples[0][0], 0.5, TEST_FLOAT_TOLERANCE);
+  sampleBufferQueueCommitRead(q);
+  assertUnsignedLongEquals(sampleBufferQueueGetOccupancy(q), 0l);
+
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testLastBlockFlag(void) {
+  SampleBufferQueue q = newSampleBufferQueue(2, 1, 8);
+  boolByte isLastBlock = false;
+
+  sampleBufferQueueAcquireWrite(q);
+  sampleBufferQueueCommitWrite(q, true);
+  assertNotNull(sampleBufferQueueAcquireRead(q, &isLastBlock));
+  assert(isLastBlock);
+
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testOccupancyStatistics(void) {
+  SampleBufferQueue q = newSampleBufferQueue(4, 1, 8);
+
+  sampleBufferQueueAcquireWrite(q);
+  sampleBufferQueueCommitWrite(q, false);
+  sampleBufferQueueAcquireWrite(q);
+  sampleBufferQueueCommitWrite(q, false);
+  assertUnsignedLongEquals(q->numBlocksPushed, 2l);
+  assertUnsignedLongEquals(q->maxOccupancy, 2l);
+  assertDoubleEquals(sampleBufferQueueGetAverageOccupancy(q), 1.5, TEST_FLOAT_TOLERANCE);
+
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testCancelEmptyQueue(void) {
+  SampleBufferQueue q = newSampleBufferQueue(1, 1, 8);
+  sampleBufferQueueCancel(q);
+  assertIsNull(sampleBufferQueueAcquireRead(q, NULL));
+  assertIsNull(sampleBufferQueueAcquireWrite(q));
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testCancelFullQueue(void) {
+  SampleBufferQueue q = newSampleBufferQueue(1, 1, 8);
+  sampleBufferQueueAcquireWrite(q);
+  sampleBufferQueueCommitWrite(q, false);
+  sampleBufferQueueCancel(q);
+  // Blocks which were already queued can still be read after cancelling
+  assertNotNull(sampleBufferQueueAcquireRead(q, NULL));
+  assertIsNull(sampleBufferQueueAcquireWrite(q));
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testResetCancelledQueue(void) {
+  SampleBufferQueue q = newSampleBufferQueue(2, 1, 8);
+  sampleBufferQueueAcquireWrite(q);
+  sampleBufferQueueCommitWrite(q, true);
+  sampleBufferQueueCancel(q);
+  sampleBufferQueueReset(q);
+  assertUnsignedLongEquals(sampleBufferQueueGetOccupancy(q), 0l);
+  assertNotNull(sampleBufferQueueAcquireWrite(q));
+  sampleBufferQueueCommitWrite(q, false);
+  assertUnsignedLongEquals(sampleBufferQueueGetOccupancy(q), 1l);
+  // Statistics from before the reset are kept
+  assertUnsignedLongEquals(q->numBlocksPushed, 2l);
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static void* _queueProducerThread(void* userData) {
+  SampleBufferQueue q = (SampleBufferQueue)userData;
+  SampleBuffer b;
+  unsigned long i;
+
+  for(i = 0; i < kQueueTestNumBlocks; i++) {
+    b = sampleBufferQueueAcquireWrite(q);
+    b->samples[0][0] = (Sample)i;
+    sampleBufferQueueCommitWrite(q, (boolByte)(i == kQueueTestNumBlocks - 1));
+  }
+  return NULL;
+}
+
+static int _testProducerConsumerThreads(void) {
+  SampleBufferQueue q = newSampleBufferQueue(3, 1, 8);
+  Thread producer = newThread(_queueProducerThread, q);
+  SampleBuffer b;
+  boolByte isLastBlock = false;
+  unsigned long numBlocksRead = 0;
+
+  assert(threadStart(producer));
+  while(!isLastBlock) {
+    b = sampleBufferQueueAcquireRead(q, &isLastBlock);
+    assertNotNull(b);
+    // Blocks must arrive in order and none may be skipped
+    assertUnsignedLongEquals((unsigned long)b->samples[0][0], numBlocksRead);
+    numBlocksRead++;
+    sampleBufferQueueCommitRead(q);
+  }
+  assert(threadJoin(producer));
+  assertUnsignedLongEquals(numBlocksRead, kQueueTestNumBlocks);
+  assert(q->maxOccupancy <= q->capacity);
+
+  freeThread(producer);
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testMultipleConsumersReadEveryBlock(void) {
+  SampleBufferQueue q = newSampleBufferQueueWithConsumers(2, 2, 1, 8);
+  SampleBuffer b;
+
+  assertIntEquals(q->numConsumers, 2);
+  b = sampleBufferQueueAcquireWrite(q);
+  b->samples[0][0] = 0.25f;
+  sampleBufferQueueCommitWrite(q, false);
+  b = sampleBufferQueueAcquireWrite(q);
+  b->samples[0][0] = 0.75f;
+  sampleBufferQueueCommitWrite(q, true);
+
+  b = sampleBufferQueueAcquireReadForConsumer(q, 0, NULL);
+  assertDoubleEquals(b->samples[0][0], 0.25, TEST_FLOAT_TOLERANCE);
+  sampleBufferQueueCommitReadForConsumer(q, 0);
+  b = sampleBufferQueueAcquireReadForConsumer(q, 0, NULL);
+  assertDoubleEquals(b->samples[0][0], 0.75, TEST_FLOAT_TOLERANCE);
+  sampleBufferQueueCommitReadForConsumer(q, 0);
+  // The slots are still held by the second consumer
+  assertUnsignedLongEquals(sampleBufferQueueGetOccupancy(q), 2l);
+
+  b = sampleBufferQueueAcquireReadForConsumer(q, 1, NULL);
+  assertDoubleEquals(b->samples[0][0], 0.25, TEST_FLOAT_TOLERANCE);
+  sampleBufferQueueCommitReadForConsumer(q, 1);
+  assertUnsignedLongEquals(sampleBufferQueueGetOccupancy(q), 1l);
+
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testCancelQueueWithSlowConsumer(void) {
+  SampleBufferQueue q = newSampleBufferQueueWithConsumers(1, 2, 1, 8);
+  sampleBufferQueueAcquireWrite(q);
+  sampleBufferQueueCommitWrite(q, false);
+  assertNotNull(sampleBufferQueueAcquireReadForConsumer(q, 0, NULL));
+  sampleBufferQueueCommitReadForConsumer(q, 0);
+  // Otherwise this would wait for the second consumer forever
+  sampleBufferQueueCancel(q);
+  assertIsNull(sampleBufferQueueAcquireWrite(q));
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+typedef struct {
+  SampleBufferQueue queue;
+  unsigned int consumer;
+  unsigned long numBlocksRead;
+  boolByte blocksInOrder;
+} _QueueTestConsumerData;
+
+static void* _queueConsumerThread(void* userData) {
+  _QueueTestConsumerData* data = (_QueueTestConsumerData*)userData;
+  SampleBuffer b;
+  boolByte isLastBlock = false;
+
+  while(!isLastBlock) {
+    b = sampleBufferQueueAcquireReadForConsumer(data->queue, data->consumer, &isLastBlock);
+    if(b == NULL) {
+      break;
+    }
+    if((unsigned long)b->samples[0][0] != data->numBlocksRead) {
+      data->blocksInOrder = false;
+    }
+    data->numBlocksRead++;
+    sampleBufferQueueCommitReadForConsumer(data->queue, data->consumer);
+  }
+  return NULL;
+}
+
+static int _testProducerMultipleConsumerThreads(void) {
+  SampleBufferQueue q = newSampleBufferQueueWithConsumers(3, 2, 1, 8);
+  _QueueTestConsumerData consumerData[2];
+  Thread consumers[2];
+  unsigned int i;
+
+  for(i = 0; i < 2; i++) {
+    consumerData[i].queue = q;
+    consumerData[i].consumer = i;
+    consumerData[i].numBlocksRead = 0;
+    consumerData[i].blocksInOrder = true;
+    consumers[i] = newThread(_queueConsumerThread, &consumerData[i]);
+    assert(threadStart(consumers[i]));
+  }
+  _queueProducerThread(q);
+  for(i = 0; i < 2; i++) {
+    assert(threadJoin(consumers[i]));
+    freeThread(consumers[i]);
+    assertUnsignedLongEquals(consumerData[i].numBlocksRead, kQueueTestNumBlocks);
+    assert(consumerData[i].blocksInOrder);
+  }
+  assert(q->maxOccupancy <= q->capacity);
+
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static void* _queueBlockedConsumerThread(void* userData) {
+  SampleBufferQueue q = (SampleBufferQueue)userData;
+  // Waits on the empty queue until it is cancelled
+  return sampleBufferQueueAcquireRead(q, NULL);
+}
+
+static int _testCancelWakesWaitingConsumer(void) {
+  SampleBufferQueue q = newSampleBufferQueue(1, 1, 8);
+  Thread consumer = newThread(_queueBlockedConsumerThread, q);
+
+  assert(threadStart(consumer));
+  sleepMilliseconds(10);
+  sampleBufferQueueCancel(q);
+  assert(threadJoin(consumer));
+
+  freeThread(consumer);
+  freeSampleBufferQueue(q);
+  return 0;
+}
+
+static int _testFreeNullSampleBufferQueue(void) {
+  freeSampleBufferQueue(NULL);
+  return 0;
+}
+
+TestSuite addSampleBufferQueueTests(void);
+TestSuite addSampleBufferQueueTests(void) {
+  TestSuite testSuite = newTestSuite("SampleBufferQueue", NULL, NULL);
+  addTest(testSuite, "NewObject", _testNewSampleBufferQueue);
+  addTest(testSuite, "NewObjectWithZeroCapacity", _testNewSampleBufferQueueWithZeroCapacity);
+  addTest(testSuite, "WriteAndReadBlock", _testWriteAndReadBlock);
+  addTest(testSuite, "LastBlockFlag", _testLastBlockFlag);
+  addTest(testSuite, "OccupancyStatistics", _testOccupancyStatistics);
+  addTest(testSuite, "CancelEmptyQueue", _testCancelEmptyQueue);
+  addTest(testSuite, "CancelFullQueue", _testCancelFullQueue);
+  addTest(testSuite, "ResetCancelledQueue", _testResetCancelledQueue);
+  addTest(testSuite, "ProducerConsumerThreads", _testProducerConsumerThreads);
+  addTest(testSuite, "MultipleConsumersReadEveryBlock", _testMultipleConsumersReadEveryBlock);
+  addTest(testSuite, "CancelQueueWithSlowConsumer", _testCancelQueueWithSlowConsumer);
+  addTest(testSuite, "ProducerMultipleConsumerThreads", _testProducerMultipleConsumerThreads);
+  addTest(testSuite, "CancelWakesWaitingConsumer", _testCancelWakesWaitingConsumer);
+  addTest(testSuite, "FreeNullSampleBufferQueue", _testFreeNullSampleBufferQueue);
+  return testSuite;
+}
@@ -29,6 +29,57 @@ static int _testNewSampleBufferMultichannel(void) {
   return 0;
 }
 
+static int _testNewSampleBufferChannelsAligned(void) {
+  SampleBuffer s = newSampleBuffer(3, 100);
+  unsigned long address;
+  unsigned int i;
+  assertNotNull(s);
+  for(i = 0; i < s->numChannels; ++i) {
+    address = (unsigned long)s->samples[i];
+    assertUnsignedLongEquals(address % SAMPLE_BUFFER_ALIGNMENT, 0ul);
+  }
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testNewSampleBufferChannelsContiguous(void) {
+  SampleBuffer s = newSampleBuffer(4, 100);
+  unsigned long stride;
+  unsigned int i;
+  assertNotNull(s);
+  // 100 samples are padded up to the next multiple of 16
+  for(i = 1; i < s->numChannels; ++i) {
+    stride = (unsigned long)(s->samples[i] - s->samples[i - 1]);
+    assertUnsignedLongEquals(stride, 112ul);
+  }
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testNewSampleBufferWithHugePages(void) {
+  SampleBuffer s;
+  unsigned long blocksize = SAMPLE_BUFFER_HUGE_PAGE_THRESHOLD / sizeof(Sample);
+  setUseHugePages(true);
+  s = newSampleBuffer(2, blocksize);
+  setUseHugePages(false);
+  // Huge pages may not be available here, but the buffer should be usable
+  // either way
+  assertNotNull(s);
+  s->samples[1][blocksize - 1] = 0.5f;
+  assertDoubleEquals(s->samples[0][0], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(s->samples[1][blocksize - 1], 0.5, TEST_FLOAT_TOLERANCE);
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testNewSampleBufferNoChannels(void) {
+  SampleBuffer s = newSampleBuffer(0, 128);
+  assertNotNull(s);
+  sampleBufferClear(s);
+  freeSampleBuffer(s);
+  return 0;
+}
+
 static int _testClearSampleBuffer(void) {
   SampleBuffer s = _newMockSampleBuffer();
   s->samples[0][0] = 123;
@@ -111,6 +162,10 @@ TestSuite addSampleBufferTests(void) {
   TestSuite testSuite = newTestSuite("SampleBuffer", NULL, NULL);
   addTest(testSuite, "NewObject", _testNewSampleBuffer);
   addTest(testSuite, "NewSampleBufferMultichannel", _testNewSampleBufferMultichannel);
+  addTest(testSuite, "NewSampleBufferChannelsAligned", _testNewSampleBufferChannelsAligned);
+  addTest(testSuite, "NewSampleBufferChannelsContiguous", _testNewSampleBufferChannelsContiguous);
+  addTest(testSuite, "NewSampleBufferWithHugePages", _testNewSampleBufferWithHugePages);
+  addTest(testSuite, "NewSampleBufferNoChannels", _testNewSampleBufferNoChannels);
   addTest(testSuite, "ClearSampleBuffer", _testClearSampleBuffer);
   addTest(testSuite, "CopyAndMapChannelsSampleBuffers", _testCopyAndMapChannelsSampleBuffers);
   addTest(testSuite, "CopyAndMapChannelsSampleBuffersDifferentSizes",  _testCopyAndMapChannelsSampleBuffersDifferentBlocksizes);
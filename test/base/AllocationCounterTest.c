@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "unit/TestRunner.h"
+#include "app/EngineContext.h"
+#include "app/ReturnCodes.h"
+#include "base/AllocationCounter.h"
+#include "MrsWatson.h"
+
+#if UNIX
+#define TEST_INPUT_FILE "/tmp/mrswatsontest-allocations-in.pcm"
+#define TEST_OUTPUT_FILE "/tmp/mrswatsontest-allocations-out.pcm"
+#elif WINDOWS
+#define TEST_INPUT_FILE "C:\\Temp\\mrswatsontest-allocations-in.pcm"
+#define TEST_OUTPUT_FILE "C:\\Temp\\mrswatsontest-allocations-out.pcm"
+#else
+#define TEST_INPUT_FILE "mrswatsontest-allocations-in.pcm"
+#define TEST_OUTPUT_FILE "mrswatsontest-allocations-out.pcm"
+#endif
+
+// Enough blocks at the default blocksize that any per-block allocation shows up
+#define TEST_NUM_FRAMES (100 * 512 + 100)
+
+static void _allocationCounterTeardown(void) {
+  allocationCounterStop();
+  allocationCounterReset();
+  unlink(TEST_INPUT_FILE);
+  unlink(TEST_OUTPUT_FILE);
+}
+
+static int _testAllocationCounterIsAvailable(void) {
+#if WITH_ALLOCATION_COUNTER
+  assert(allocationCounterIsAvailable());
+#else
+  assertFalse(allocationCounterIsAvailable());
+#endif
+  return 0;
+}
+
+#if WITH_ALLOCATION_COUNTER
+static boolByte _writeTestInputFile(void) {
+  FILE* fp = fopen(TEST_INPUT_FILE, "wb");
+  short frame[2];
+  int i;
+
+  if(fp == NULL) {
+    return false;
+  }
+  for(i = 0; i < TEST_NUM_FRAMES; i++) {
+    frame[0] = frame[1] = (short)((i % 100) * 100);
+    fwrite(frame, sizeof(short), 2, fp);
+  }
+  fclose(fp);
+  return true;
+}
+
+static int _renderTestInputFile(const char* pipelineQueueSize) {
+  EngineContext engineContext = newEngineContext();
+  char* argv[] = {
+    "mrswatson", "--quiet", "--plugin", "mrs_passthru", "--tail-time", "100",
+    "--input", TEST_INPUT_FILE, "--output", TEST_OUTPUT_FILE, "--pipeline", NULL
+  };
+  // Leave out the --pipeline argument when running serially
+  int argc = pipelineQueueSize != NULL ? 12 : 10;
+  int result;
+
+  argv[11] = (char*)pipelineQueueSize;
+  result = mrsWatsonRender(engineContext, argc, argv);
+  freeEngineContext(engineContext);
+  return result;
+}
+
+static int _testCountAllocations(void) {
+  // Otherwise the compiler may remove the unused malloc() and free() pairs
+  void* volatile p;
+
+  allocationCounterReset();
+  allocationCounterStart();
+  p = malloc(16);
+  free(p);
+  allocationCounterStop();
+  p = malloc(16);
+  free(p);
+
+  assertUnsignedLongEquals(allocationCounterGetNumAllocations(), 1l);
+  assertUnsignedLongEquals(allocationCounterGetNumFrees(), 1l);
+  return 0;
+}
+
+static int _testNoAllocationsInRenderLoop(void) {
+  assert(_writeTestInputFile());
+  allocationCounterReset();
+  assertIntEquals(_renderTestInputFile(NULL), RETURN_CODE_SUCCESS);
+  assertUnsignedLongEquals(allocationCounterGetNumAllocations(), 0l);
+  return 0;
+}
+
+static int _testNoAllocationsInPipelinedRenderLoop(void) {
+  assert(_writeTestInputFile());
+  allocationCounterReset();
+  assertIntEquals(_renderTestInputFile("2"), RETURN_CODE_SUCCESS);
+  assertUnsignedLongEquals(allocationCounterGetNumAllocations(), 0l);
+  return 0;
+}
+#endif
+
+TestSuite addAllocationCounterTests(void);
+TestSuite addAllocationCounterTests(void) {
+  TestSuite testSuite = newTestSuite("AllocationCounter", NULL, _allocationCounterTeardown);
+  addTest(testSuite, "IsAvailable", _testAllocationCounterIsAvailable);
+#if WITH_ALLOCATION_COUNTER
+  addTest(testSuite, "CountAllocations", _testCountAllocations);
+  addTest(testSuite, "NoAllocationsInRenderLoop", _testNoAllocationsInRenderLoop);
+  addTest(testSuite, "NoAllocationsInPipelinedRenderLoop", _testNoAllocationsInPipelinedRenderLoop);
+#else
+  // Allocations can only be counted in instrumented builds
+  addTest(testSuite, "CountAllocations", NULL);
+  addTest(testSuite, "NoAllocationsInRenderLoop", NULL);
+  addTest(testSuite, "NoAllocationsInPipelinedRenderLoop", NULL);
+#endif
+  return testSuite;
+}
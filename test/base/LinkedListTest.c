@@ -189,6 +189,88 @@ static int _testForeachOverUserData(void) {
   return 0;
 }
 
+static int _testNewLinkedListWithCapacity(void) {
+  LinkedList l = newLinkedListWithCapacity(3);
+  LinkedListIterator i;
+  assertNotNull(l);
+  assertIntEquals(linkedListLength(l), 0);
+  assertIsNull(l->item);
+  i = (LinkedListIterator)(l->nextItem);
+  assertNotNull(i);
+  i = (LinkedListIterator)(i->nextItem);
+  assertNotNull(i);
+  assertIsNull(i->nextItem);
+  freeLinkedList(l);
+  return 0;
+}
+
+static int _testAppendToListWithCapacity(void) {
+  LinkedList l = newLinkedListWithCapacity(2);
+  LinkedListIterator second = (LinkedListIterator)(l->nextItem);
+  CharString c = newCharStringWithCString(TEST_ITEM_STRING);
+  CharString c2 = newCharStringWithCString(OTHER_TEST_ITEM_STRING);
+  linkedListAppend(l, c);
+  linkedListAppend(l, c2);
+  assertIntEquals(linkedListLength(l), 2);
+  // The preallocated node should be used instead of a new one
+  assert(l->nextItem == second);
+  assert(second->item == c2);
+  assertIsNull(second->nextItem);
+  freeLinkedListAndItems(l, (LinkedListFreeItemFunc)freeCharString);
+  return 0;
+}
+
+static int _testClearList(void) {
+  LinkedList l = newLinkedList();
+  CharString c = newCharStringWithCString(TEST_ITEM_STRING);
+  linkedListAppend(l, c);
+  linkedListAppend(l, c);
+  linkedListClear(l);
+  assertIntEquals(linkedListLength(l), 0);
+  assertIsNull(l->item);
+  linkedListForeach(l, _linkedListEmptyCallback, NULL);
+  assertIntEquals(_gNumForeachCallbacksMade, 0);
+  assertIsNull(linkedListToArray(l));
+  freeLinkedList(l);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testAppendAfterClearReusesNodes(void) {
+  LinkedList l = newLinkedList();
+  LinkedListIterator second;
+  CharString c = newCharStringWithCString(TEST_ITEM_STRING);
+  CharString c2 = newCharStringWithCString(OTHER_TEST_ITEM_STRING);
+
+  linkedListAppend(l, c);
+  linkedListAppend(l, c);
+  second = (LinkedListIterator)(l->nextItem);
+  linkedListClear(l);
+  linkedListAppend(l, c2);
+  assertIntEquals(linkedListLength(l), 1);
+  assert(l->item == c2);
+  assert(l->nextItem == second);
+  assertIsNull(second->item);
+  linkedListAppend(l, c);
+  assertIntEquals(linkedListLength(l), 2);
+  assert(second->item == c);
+  assertIsNull(second->nextItem);
+
+  freeLinkedList(l);
+  freeCharString(c);
+  freeCharString(c2);
+  return 0;
+}
+
+static int _testFreePartiallyFilledListAndItems(void) {
+  LinkedList l = newLinkedListWithCapacity(4);
+  linkedListAppend(l, newCharStringWithCString(TEST_ITEM_STRING));
+  linkedListAppend(l, newCharStringWithCString(OTHER_TEST_ITEM_STRING));
+  // Should not call the free function for the empty nodes
+  freeLinkedListAndItems(l, (LinkedListFreeItemFunc)freeCharString);
+  return 0;
+}
+
 static int _testFreeNullLinkedList(void) {
   freeLinkedList(NULL);
   return 0;
@@ -216,6 +298,12 @@ TestSuite addLinkedListTests(void) {
   addTest(testSuite, "ForeachOverList", _testForeachOverList);
   addTest(testSuite, "ForeachWithUserData", _testForeachOverUserData);
 
+  addTest(testSuite, "NewObjectWithCapacity", _testNewLinkedListWithCapacity);
+  addTest(testSuite, "AppendToListWithCapacity", _testAppendToListWithCapacity);
+  addTest(testSuite, "ClearList", _testClearList);
+  addTest(testSuite, "AppendAfterClearReusesNodes", _testAppendAfterClearReusesNodes);
+  addTest(testSuite, "FreePartiallyFilledListAndItems", _testFreePartiallyFilledListAndItems);
+
   addTest(testSuite, "FreeNullLinkedList", _testFreeNullLinkedList);
 
   return testSuite;
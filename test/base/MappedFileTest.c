@@ -0,0 +1,68 @@
+#include "unit/TestRunner.h"
+#include "base/MappedFile.h"
+
+#define TEST_MAPPED_FILENAME "test_mapped_file.bin"
+
+static void _mappedFileTestTeardown(void) {
+  remove(TEST_MAPPED_FILENAME);
+}
+
+static int _testMapFile(void) {
+  CharString p = newCharStringWithCString(TEST_MAPPED_FILENAME);
+  const char contents[] = "mapped file contents";
+  MappedFile m;
+  FILE* fp = fopen(TEST_MAPPED_FILENAME, "wb");
+
+  assertNotNull(fp);
+  fwrite(contents, 1, sizeof(contents), fp);
+  fclose(fp);
+
+  m = newMappedFile(p);
+  assertNotNull(m);
+  assertSizeEquals(m->size, sizeof(contents));
+  assertIntEquals(memcmp(m->data, contents, sizeof(contents)), 0);
+
+  freeMappedFile(m);
+  freeCharString(p);
+  return 0;
+}
+
+static int _testMapEmptyFile(void) {
+  CharString p = newCharStringWithCString(TEST_MAPPED_FILENAME);
+  FILE* fp = fopen(TEST_MAPPED_FILENAME, "wb");
+  assertNotNull(fp);
+  fclose(fp);
+  assertIsNull(newMappedFile(p));
+  freeCharString(p);
+  return 0;
+}
+
+static int _testMapInvalidFile(void) {
+  CharString p = newCharStringWithCString("invalid");
+  assertIsNull(newMappedFile(p));
+  freeCharString(p);
+  return 0;
+}
+
+static int _testMapDirectory(void) {
+  CharString p = newCharStringWithCString(".");
+  assertIsNull(newMappedFile(p));
+  freeCharString(p);
+  return 0;
+}
+
+static int _testMapNullPath(void) {
+  assertIsNull(newMappedFile(NULL));
+  return 0;
+}
+
+TestSuite addMappedFileTests(void);
+TestSuite addMappedFileTests(void) {
+  TestSuite testSuite = newTestSuite("MappedFile", NULL, _mappedFileTestTeardown);
+  addTest(testSuite, "MapFile", _testMapFile);
+  addTest(testSuite, "MapEmptyFile", _testMapEmptyFile);
+  addTest(testSuite, "MapInvalidFile", _testMapInvalidFile);
+  addTest(testSuite, "MapDirectory", _testMapDirectory);
+  addTest(testSuite, "MapNullPath", _testMapNullPath);
+  return testSuite;
+}
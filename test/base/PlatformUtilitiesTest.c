@@ -183,6 +183,23 @@ static int _testConvertByteArrayToUnsignedInt(void) {
   return 0;
 }
 
+static int _testConvertByteArrayToUnsignedLongLong(void) {
+  byte b[8];
+  int i;
+  unsigned long long s;
+  for(i = 0; i < 8; i++) {
+    b[i] = (byte)(0xa0 + i);
+  }
+  s = convertByteArrayToUnsignedLongLong(b);
+
+#if HOST_BIG_ENDIAN
+  assert(s == 0xa0a1a2a3a4a5a6a7ull);
+#elif HOST_LITTLE_ENDIAN
+  assert(s == 0xa7a6a5a4a3a2a1a0ull);
+#endif
+  return 0;
+}
+
 static int _testSleepMilliseconds(void) {
   double elapsedTime;
   TaskTimer t = newTaskTimerWithCString("test", "test");
@@ -211,6 +228,7 @@ TestSuite addPlatformUtilitiesTests(void) {
 
   addTest(testSuite, "ConvertByteArrayToUnsignedShort", _testConvertByteArrayToUnsignedShort);
   addTest(testSuite, "ConvertByteArrayToUnsignedInt", _testConvertByteArrayToUnsignedInt);
+  addTest(testSuite, "ConvertByteArrayToUnsignedLongLong", _testConvertByteArrayToUnsignedLongLong);
 
   addTest(testSuite, "SleepMilliseconds", _testSleepMilliseconds);
   return testSuite;
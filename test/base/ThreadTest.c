@@ -0,0 +1,97 @@
+#include "base/Thread.h"
+#include "unit/TestRunner.h"
+
+static void* _setFlagThreadFunc(void* userData) {
+  boolByte* flag = (boolByte*)userData;
+  *flag = true;
+  return NULL;
+}
+
+static int _testNewThread(void) {
+  boolByte flag = false;
+  Thread t = newThread(_setFlagThreadFunc, &flag);
+  assertNotNull(t);
+  assertFalse(t->running);
+  assertFalse(flag);
+  freeThread(t);
+  return 0;
+}
+
+static int _testStartAndJoinThread(void) {
+  boolByte flag = false;
+  Thread t = newThread(_setFlagThreadFunc, &flag);
+  assert(threadStart(t));
+  assert(t->running);
+  assert(threadJoin(t));
+  assertFalse(t->running);
+  assert(flag);
+  freeThread(t);
+  return 0;
+}
+
+static int _testJoinThreadNotStarted(void) {
+  Thread t = newThread(_setFlagThreadFunc, NULL);
+  assertFalse(threadJoin(t));
+  freeThread(t);
+  return 0;
+}
+
+static int _testFreeRunningThread(void) {
+  boolByte flag = false;
+  Thread t = newThread(_setFlagThreadFunc, &flag);
+  assert(threadStart(t));
+  // Should join the thread before freeing it
+  freeThread(t);
+  assert(flag);
+  return 0;
+}
+
+static void* _notifySignalThreadFunc(void* userData) {
+  ThreadSignal signal = (ThreadSignal)userData;
+  sleepMilliseconds(10);
+  threadSignalNotify(signal);
+  return NULL;
+}
+
+static int _testThreadSignalWaitForNotify(void) {
+  ThreadSignal signal = newThreadSignal();
+  Thread t = newThread(_notifySignalThreadFunc, signal);
+  unsigned long generation = threadSignalGetGeneration(signal);
+
+  assert(threadStart(t));
+  threadSignalWait(signal, generation);
+  assertUnsignedLongEquals(threadSignalGetGeneration(signal), generation + 1);
+  assert(threadJoin(t));
+
+  freeThread(t);
+  freeThreadSignal(signal);
+  return 0;
+}
+
+static int _testThreadSignalWaitAfterNotify(void) {
+  ThreadSignal signal = newThreadSignal();
+  unsigned long generation = threadSignalGetGeneration(signal);
+  threadSignalNotify(signal);
+  // Should return at once, since the notification was already made
+  threadSignalWait(signal, generation);
+  freeThreadSignal(signal);
+  return 0;
+}
+
+static int _testFreeNullThread(void) {
+  freeThread(NULL);
+  return 0;
+}
+
+TestSuite addThreadTests(void);
+TestSuite addThreadTests(void) {
+  TestSuite testSuite = newTestSuite("Thread", NULL, NULL);
+  addTest(testSuite, "NewObject", _testNewThread);
+  addTest(testSuite, "StartAndJoin", _testStartAndJoinThread);
+  addTest(testSuite, "JoinThreadNotStarted", _testJoinThreadNotStarted);
+  addTest(testSuite, "FreeRunningThread", _testFreeRunningThread);
+  addTest(testSuite, "ThreadSignalWaitForNotify", _testThreadSignalWaitForNotify);
+  addTest(testSuite, "ThreadSignalWaitAfterNotify", _testThreadSignalWaitAfterNotify);
+  addTest(testSuite, "FreeNullThread", _testFreeNullThread);
+  return testSuite;
+}
@@ -0,0 +1,118 @@
+#include "unit/TestRunner.h"
+#include "io/AsyncFileWriter.h"
+
+#define TEST_ASYNC_FILENAME "test_async_writer.bin"
+
+static void _asyncFileWriterTestTeardown(void) {
+  remove(TEST_ASYNC_FILENAME);
+}
+
+static int _testWriteCoalescesBlocks(void) {
+  FILE* fp = fopen(TEST_ASYNC_FILENAME, "wb");
+  AsyncFileWriter w;
+  byte* data;
+  byte contents[100 * 100];
+  unsigned int i, j;
+
+  assertNotNull(fp);
+  w = newAsyncFileWriter(fp, 4096, 2);
+  assertNotNull(w);
+  for(i = 0; i < 100; i++) {
+    data = asyncFileWriterAcquire(w, 100);
+    assertNotNull(data);
+    for(j = 0; j < 100; j++) {
+      data[j] = (byte)(i + j);
+    }
+    asyncFileWriterCommit(w, 100);
+  }
+  assert(asyncFileWriterFlush(w));
+  assertUnsignedLongEquals(w->numBytesWritten, 10000ul);
+  // Each 4096 byte buffer holds 40 blocks
+  assertUnsignedLongEquals(w->numWrites, 3ul);
+  freeAsyncFileWriter(w);
+  fclose(fp);
+
+  fp = fopen(TEST_ASYNC_FILENAME, "rb");
+  assertNotNull(fp);
+  assertSizeEquals(fread(contents, 1, sizeof(contents), fp), sizeof(contents));
+  fclose(fp);
+  for(i = 0; i < 100; i++) {
+    for(j = 0; j < 100; j++) {
+      assertIntEquals(contents[i * 100 + j], (byte)(i + j));
+    }
+  }
+  return 0;
+}
+
+static int _testAcquireBuffersAreAligned(void) {
+  FILE* fp = fopen(TEST_ASYNC_FILENAME, "wb");
+  AsyncFileWriter w = newAsyncFileWriter(fp, 1000, 3);
+  byte* data;
+
+  assertNotNull(w);
+  assertSizeEquals(w->bufferSize, (size_t)ASYNC_FILE_WRITER_ALIGNMENT);
+  assertIntEquals(w->numBuffers, 3);
+  data = asyncFileWriterAcquire(w, 10);
+  assertSizeEquals((size_t)data % ASYNC_FILE_WRITER_ALIGNMENT, (size_t)0);
+  asyncFileWriterCommit(w, 10);
+  // The next buffer is started once this one is full
+  data = asyncFileWriterAcquire(w, ASYNC_FILE_WRITER_ALIGNMENT);
+  assertSizeEquals((size_t)data % ASYNC_FILE_WRITER_ALIGNMENT, (size_t)0);
+  asyncFileWriterCommit(w, ASYNC_FILE_WRITER_ALIGNMENT);
+
+  freeAsyncFileWriter(w);
+  fclose(fp);
+  return 0;
+}
+
+static int _testAcquireLargerThanBuffer(void) {
+  FILE* fp = fopen(TEST_ASYNC_FILENAME, "wb");
+  AsyncFileWriter w = newAsyncFileWriter(fp, 4096, 2);
+  assertNotNull(w);
+  assertIsNull(asyncFileWriterAcquire(w, 4097));
+  freeAsyncFileWriter(w);
+  fclose(fp);
+  return 0;
+}
+
+static int _testFlushWithNoData(void) {
+  FILE* fp = fopen(TEST_ASYNC_FILENAME, "wb");
+  AsyncFileWriter w = newAsyncFileWriter(fp, 4096, 2);
+  assertNotNull(w);
+  assert(asyncFileWriterFlush(w));
+  assertUnsignedLongEquals(w->numWrites, 0ul);
+  freeAsyncFileWriter(w);
+  fclose(fp);
+  return 0;
+}
+
+static int _testWriteToReadOnlyFile(void) {
+  FILE* fp;
+  AsyncFileWriter w;
+  byte* data;
+
+  fp = fopen(TEST_ASYNC_FILENAME, "wb");
+  fclose(fp);
+  fp = fopen(TEST_ASYNC_FILENAME, "rb");
+  w = newAsyncFileWriter(fp, 4096, 2);
+  assertNotNull(w);
+  data = asyncFileWriterAcquire(w, 16);
+  memset(data, 0, 16);
+  asyncFileWriterCommit(w, 16);
+  assertFalse(asyncFileWriterFlush(w));
+  assert(asyncFileWriterHasFailed(w));
+  freeAsyncFileWriter(w);
+  fclose(fp);
+  return 0;
+}
+
+TestSuite addAsyncFileWriterTests(void);
+TestSuite addAsyncFileWriterTests(void) {
+  TestSuite testSuite = newTestSuite("AsyncFileWriter", NULL, _asyncFileWriterTestTeardown);
+  addTest(testSuite, "WriteCoalescesBlocks", _testWriteCoalescesBlocks);
+  addTest(testSuite, "AcquireBuffersAreAligned", _testAcquireBuffersAreAligned);
+  addTest(testSuite, "AcquireLargerThanBuffer", _testAcquireLargerThanBuffer);
+  addTest(testSuite, "FlushWithNoData", _testFlushWithNoData);
+  addTest(testSuite, "WriteToReadOnlyFile", _testWriteToReadOnlyFile);
+  return testSuite;
+}
@@ -0,0 +1,307 @@
+#include <string.h>
+
+#include "unit/TestRunner.h"
+#include "io/FlacDecoder.h"
+
+#define TEST_FLAC_FILENAME "test_decoder.flac"
+
+// Test streams made with a reference encoder. The mono stream has three frames
+// of 16 samples with verbatim, fixed and LPC subframes, and the LPC subframe
+// has an escaped residual partition.
+static const byte kFlacMono16[174] = {
+  0x66, 0x4c, 0x61, 0x43, 0x00, 0x00, 0x00, 0x22, 0x00, 0x10, 0x00, 0x10,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0xc4, 0x40, 0xf0, 0x00, 0x00,
+  0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x84, 0x00, 0x00, 0x08, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xf8, 0x60, 0x08, 0x00, 0x0f,
+  0x96, 0x02, 0xfc, 0x18, 0xfc, 0x3d, 0xfc, 0xac, 0xfd, 0x65, 0xfe, 0x68,
+  0xff, 0xb5, 0x01, 0x4c, 0x03, 0x2d, 0xfd, 0x88, 0xff, 0xfd, 0x02, 0xbc,
+  0xfd, 0xf5, 0x01, 0x48, 0xfd, 0x15, 0x00, 0xfc, 0xfd, 0x5d, 0x11, 0x12,
+  0xff, 0xf8, 0x60, 0x08, 0x01, 0x0f, 0x83, 0x14, 0x01, 0xd8, 0xfe, 0xcd,
+  0x02, 0x82, 0x1a, 0x0e, 0x17, 0x25, 0x24, 0xa0, 0x43, 0x41, 0xc2, 0xe4,
+  0xa4, 0x94, 0x92, 0x92, 0x52, 0x4a, 0x49, 0x49, 0x29, 0x25, 0x00, 0x6f,
+  0x37, 0xff, 0xf8, 0x60, 0x08, 0x02, 0x0f, 0xbc, 0x42, 0x03, 0x78, 0xfd,
+  0x3d, 0x20, 0x2e, 0x05, 0x90, 0x69, 0x12, 0x91, 0x28, 0xf0, 0xb2, 0x0d,
+  0x1e, 0x16, 0x41, 0xa3, 0xc2, 0xc8, 0x34, 0x78, 0x59, 0x06, 0x8f, 0x0b,
+  0x89, 0x42, 0x0d, 0x00, 0x0d, 0x1b
+};
+
+// Two frames of 16 stereo 24-bit samples with mid/side coding, a seek point
+// for each frame, and an ID3v2 tag before the stream marker
+static const byte kFlacStereo24MidSide[403] = {
+  0x49, 0x44, 0x33, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x66, 0x4c, 0x61, 0x43, 0x00, 0x00,
+  0x00, 0x22, 0x00, 0x10, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x0b, 0xb8, 0x03, 0x70, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x03, 0x00, 0x00, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x8c, 0x00, 0x10, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x84, 0x00,
+  0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xf8,
+  0x60, 0xac, 0x00, 0x0f, 0x75, 0x12, 0xff, 0x06, 0x00, 0x03, 0xa9, 0x40,
+  0x77, 0x80, 0x5c, 0x82, 0x20, 0xc0, 0x19, 0xa0, 0x04, 0xb8, 0x01, 0xc2,
+  0x08, 0x00, 0x52, 0x7f, 0x0f, 0x50, 0x00, 0xbf, 0x00, 0x00, 0xc6, 0xfa,
+  0x06, 0x98, 0x00, 0x0b, 0x2f, 0xe0, 0x39, 0xc0, 0x00, 0x9e, 0xfa, 0x25,
+  0xfa, 0x24, 0x00, 0x03, 0x9b, 0xc0, 0x81, 0x34, 0x10, 0x03, 0x58, 0x10,
+  0x00, 0x49, 0x04, 0x00, 0x01, 0x9c, 0x08, 0x00, 0x00, 0x45, 0x04, 0x00,
+  0x00, 0x03, 0x18, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xdd, 0xf6, 0x00, 0x00, 0x00, 0x0b, 0xe0, 0x40, 0x00, 0x00, 0x00, 0x1f,
+  0x41, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x15, 0x3f, 0x40, 0x00,
+  0x00, 0x00, 0x00, 0x79, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2c,
+  0x7e, 0x80, 0x00, 0x00, 0x00, 0x00, 0x01, 0xd4, 0x10, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x5c, 0xfd, 0x64, 0xb0, 0xff, 0xf8, 0x60, 0xac, 0x01, 0x0f,
+  0x60, 0x12, 0x00, 0x76, 0x04, 0x03, 0x80, 0x8a, 0xfe, 0x00, 0x47, 0x80,
+  0x0f, 0x6f, 0xa1, 0x59, 0xfc, 0x71, 0x7f, 0x00, 0x0b, 0x70, 0x06, 0x77,
+  0xd2, 0x13, 0xfa, 0xeb, 0xff, 0x87, 0xfa, 0x6f, 0xb4, 0x60, 0x3b, 0x40,
+  0x2d, 0xc0, 0x10, 0x20, 0x84, 0x80, 0x58, 0x83, 0x00, 0x70, 0x00, 0x00,
+  0x00, 0x00, 0x60, 0xfd, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0d,
+  0xa0, 0x80, 0x00, 0x00, 0x00, 0xc9, 0xfa, 0x00, 0x00, 0x00, 0x46, 0xfb,
+  0x00, 0x00, 0x03, 0x47, 0xe8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x01, 0x94, 0x10, 0x00, 0x06, 0xcf, 0xd0, 0x00, 0x9d, 0xf6, 0x01,
+  0xc3, 0xf4, 0x14, 0xbe, 0xdd, 0x3f, 0x5a, 0x41, 0x01, 0x1c, 0x08, 0x03,
+  0x28, 0x20, 0x00, 0x43, 0x02, 0xbb, 0x6d
+};
+
+// One frame of 16 mono samples with a value of 512, stored as a constant
+// subframe with 9 wasted bits
+static const byte kFlacConstantWithWastedBits[66] = {
+  0x66, 0x4c, 0x61, 0x43, 0x00, 0x00, 0x00, 0x22, 0x00, 0x10, 0x00, 0x10,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0a, 0xc4, 0x40, 0xf0, 0x00, 0x00,
+  0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x84, 0x00, 0x00, 0x08, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0xf8, 0x60, 0x08, 0x00, 0x0f,
+  0x96, 0x01, 0x00, 0x81, 0x2d, 0x94
+};
+
+static int _getTestSample(unsigned int i) {
+  return (int)((i * i * 37) % 2000) - 1000;
+}
+
+static FILE* _writeTestStream(const byte* data, size_t numBytes) {
+  FILE* fp = fopen(TEST_FLAC_FILENAME, "wb");
+  if(fp == NULL) {
+    return NULL;
+  }
+  fwrite(data, 1, numBytes, fp);
+  fclose(fp);
+  return fopen(TEST_FLAC_FILENAME, "rb");
+}
+
+static void _flacDecoderTeardown(void) {
+  remove(TEST_FLAC_FILENAME);
+}
+
+static int _testDecodeMono16(void) {
+  FILE* fp = _writeTestStream(kFlacMono16, sizeof(kFlacMono16));
+  FlacDecoder d = newFlacDecoder(fp, TEST_FLAC_FILENAME);
+  SampleBuffer b = newSampleBuffer(1, 64);
+  unsigned int i;
+
+  assertNotNull(d);
+  assertIntEquals(d->sampleRate, 44100);
+  assertIntEquals(d->numChannels, 1);
+  assertIntEquals(d->bitsPerSample, 16);
+  assertUnsignedLongEquals((unsigned long)d->totalSamples, 48ul);
+  assertIntEquals(d->numSeekPoints, 0);
+
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 48ul);
+  for(i = 0; i < 48; i++) {
+    assertDoubleEquals(b->samples[0][i], _getTestSample(i) / 32767.0, TEST_FLOAT_TOLERANCE);
+  }
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 0ul);
+
+  freeSampleBuffer(b);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return 0;
+}
+
+static int _testDecodeStereo24MidSide(void) {
+  FILE* fp = _writeTestStream(kFlacStereo24MidSide, sizeof(kFlacStereo24MidSide));
+  FlacDecoder d = newFlacDecoder(fp, TEST_FLAC_FILENAME);
+  SampleBuffer b = newSampleBuffer(2, 10);
+  unsigned long framesRead = 0;
+  unsigned long numFrames;
+  int left;
+  unsigned int i;
+
+  assertNotNull(d);
+  assertIntEquals(d->sampleRate, 48000);
+  assertIntEquals(d->numChannels, 2);
+  assertIntEquals(d->bitsPerSample, 24);
+  assertUnsignedLongEquals((unsigned long)d->totalSamples, 32ul);
+
+  // Reads which aren't aligned to frames
+  while((numFrames = flacDecoderRead(d, b)) > 0) {
+    for(i = 0; i < numFrames; i++) {
+      left = _getTestSample((unsigned int)(framesRead + i)) * 256 + (int)(framesRead + i);
+      assertDoubleEquals(b->samples[0][i], left / 8388607.0, TEST_FLOAT_TOLERANCE);
+      assertDoubleEquals(b->samples[1][i], -(left >> 1) / 8388607.0, TEST_FLOAT_TOLERANCE);
+    }
+    framesRead += numFrames;
+  }
+  assertUnsignedLongEquals(framesRead, 32ul);
+
+  freeSampleBuffer(b);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return 0;
+}
+
+static int _testDecodeConstantWithWastedBits(void) {
+  FILE* fp = _writeTestStream(kFlacConstantWithWastedBits, sizeof(kFlacConstantWithWastedBits));
+  FlacDecoder d = newFlacDecoder(fp, TEST_FLAC_FILENAME);
+  SampleBuffer b = newSampleBuffer(1, 16);
+  unsigned int i;
+
+  assertNotNull(d);
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 16ul);
+  for(i = 0; i < 16; i++) {
+    assertDoubleEquals(b->samples[0][i], 512.0 / 32767.0, TEST_FLOAT_TOLERANCE);
+  }
+
+  freeSampleBuffer(b);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return 0;
+}
+
+static int _testReadSilencesExtraChannels(void) {
+  FILE* fp = _writeTestStream(kFlacMono16, sizeof(kFlacMono16));
+  FlacDecoder d = newFlacDecoder(fp, TEST_FLAC_FILENAME);
+  SampleBuffer b = newSampleBuffer(2, 8);
+  unsigned int i;
+
+  assertNotNull(d);
+  b->samples[1][0] = 1.0f;
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 8ul);
+  for(i = 0; i < 8; i++) {
+    assertDoubleEquals(b->samples[1][i], 0.0, TEST_FLOAT_TOLERANCE);
+  }
+
+  freeSampleBuffer(b);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return 0;
+}
+
+static int _testSeekWithSeekTable(void) {
+  FILE* fp = _writeTestStream(kFlacStereo24MidSide, sizeof(kFlacStereo24MidSide));
+  FlacDecoder d = newFlacDecoder(fp, TEST_FLAC_FILENAME);
+  SampleBuffer b = newSampleBuffer(2, 1);
+
+  assertNotNull(d);
+  assertIntEquals(d->numSeekPoints, 2);
+  assertUnsignedLongEquals((unsigned long)d->seekPoints[1].sampleNumber, 16ul);
+
+  assert(flacDecoderSeek(d, 20));
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 1ul);
+  assertDoubleEquals(b->samples[0][0], (_getTestSample(20) * 256 + 20) / 8388607.0, TEST_FLOAT_TOLERANCE);
+
+  // Seeking backwards within the stream
+  assert(flacDecoderSeek(d, 3));
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 1ul);
+  assertDoubleEquals(b->samples[0][0], (_getTestSample(3) * 256 + 3) / 8388607.0, TEST_FLOAT_TOLERANCE);
+
+  assert(flacDecoderSeek(d, 32));
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 0ul);
+  assertFalse(flacDecoderSeek(d, 33));
+
+  freeSampleBuffer(b);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return 0;
+}
+
+static int _testSeekWithoutSeekTable(void) {
+  FILE* fp = _writeTestStream(kFlacMono16, sizeof(kFlacMono16));
+  FlacDecoder d = newFlacDecoder(fp, TEST_FLAC_FILENAME);
+  SampleBuffer b = newSampleBuffer(1, 2);
+
+  assertNotNull(d);
+  assert(flacDecoderSeek(d, 47));
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 1ul);
+  assertDoubleEquals(b->samples[0][0], _getTestSample(47) / 32767.0, TEST_FLOAT_TOLERANCE);
+
+  freeSampleBuffer(b);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return 0;
+}
+
+static int _testOpenInvalidStream(void) {
+  const byte data[] = "RIFF\0\0\0\0WAVEfmt ";
+  FILE* fp = _writeTestStream(data, sizeof(data));
+  assertIsNull(newFlacDecoder(fp, TEST_FLAC_FILENAME));
+  fclose(fp);
+  return 0;
+}
+
+static int _testOpenTruncatedMetadata(void) {
+  FILE* fp = _writeTestStream(kFlacMono16, 20);
+  assertIsNull(newFlacDecoder(fp, TEST_FLAC_FILENAME));
+  fclose(fp);
+  return 0;
+}
+
+static int _testDecodeCorruptFrame(void) {
+  byte data[sizeof(kFlacMono16)];
+  FILE* fp;
+  FlacDecoder d;
+  SampleBuffer b = newSampleBuffer(1, 64);
+
+  // Flip a bit in the last frame, so that its CRC doesn't match
+  memcpy(data, kFlacMono16, sizeof(data));
+  data[sizeof(data) - 4] ^= 0x10;
+  fp = _writeTestStream(data, sizeof(data));
+  d = newFlacDecoder(fp, TEST_FLAC_FILENAME);
+  assertNotNull(d);
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 32ul);
+
+  freeSampleBuffer(b);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return 0;
+}
+
+static int _testDecodeTruncatedFrame(void) {
+  FILE* fp = _writeTestStream(kFlacMono16, sizeof(kFlacMono16) - 3);
+  FlacDecoder d = newFlacDecoder(fp, TEST_FLAC_FILENAME);
+  SampleBuffer b = newSampleBuffer(1, 64);
+
+  assertNotNull(d);
+  assertUnsignedLongEquals(flacDecoderRead(d, b), 32ul);
+
+  freeSampleBuffer(b);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return 0;
+}
+
+static int _testCrc(void) {
+  const byte data[] = "123456789";
+  // Check values for the FLAC CRC polynomials
+  assertIntEquals(flacCrc8(data, 9), 0xf4);
+  assertIntEquals(flacCrc16(data, 9), 0xfee8);
+  return 0;
+}
+
+TestSuite addFlacDecoderTests(void);
+TestSuite addFlacDecoderTests(void) {
+  TestSuite testSuite = newTestSuite("FlacDecoder", NULL, _flacDecoderTeardown);
+  addTest(testSuite, "DecodeMono16", _testDecodeMono16);
+  addTest(testSuite, "DecodeStereo24MidSide", _testDecodeStereo24MidSide);
+  addTest(testSuite, "DecodeConstantWithWastedBits", _testDecodeConstantWithWastedBits);
+  addTest(testSuite, "ReadSilencesExtraChannels", _testReadSilencesExtraChannels);
+  addTest(testSuite, "SeekWithSeekTable", _testSeekWithSeekTable);
+  addTest(testSuite, "SeekWithoutSeekTable", _testSeekWithoutSeekTable);
+  addTest(testSuite, "OpenInvalidStream", _testOpenInvalidStream);
+  addTest(testSuite, "OpenTruncatedMetadata", _testOpenTruncatedMetadata);
+  addTest(testSuite, "DecodeCorruptFrame", _testDecodeCorruptFrame);
+  addTest(testSuite, "DecodeTruncatedFrame", _testDecodeTruncatedFrame);
+  addTest(testSuite, "Crc", _testCrc);
+  return testSuite;
+}
@@ -0,0 +1,245 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unit/TestRunner.h"
+#include "audio/PcmConversion.h"
+#include "io/FlacDecoder.h"
+#include "io/FlacEncoder.h"
+
+#define TEST_FLAC_FILENAME "test_encoder.flac"
+#define TEST_FLAC_OTHER_FILENAME "test_encoder_other.flac"
+
+// Sine waves with a bit of noise, which gives the predictors something to do
+static SampleBuffer _newTestSignal(unsigned int numChannels, unsigned long numFrames) {
+  SampleBuffer sampleBuffer = newSampleBuffer(numChannels, numFrames);
+  unsigned int seed = 12345;
+  unsigned int channel;
+  unsigned long i;
+
+  for(channel = 0; channel < numChannels; channel++) {
+    for(i = 0; i < numFrames; i++) {
+      seed = seed * 1103515245 + 12345;
+      sampleBuffer->samples[channel][i] = (Sample)(0.6 * sin(i * 0.031 * (channel + 1)) +
+        0.2 * sin(i * 0.27) + ((int)((seed >> 16) % 200) - 100) / 200000.0);
+    }
+  }
+  return sampleBuffer;
+}
+
+static boolByte _encodeTestFile(const char* filename, const SampleBuffer sampleBuffer, unsigned long chunkSize,
+  unsigned int numChannels, unsigned int bitsPerSample, unsigned int level, unsigned int numThreads) {
+  FILE* fp = fopen(filename, "wb");
+  SampleBuffer chunk = newSampleBuffer(sampleBuffer->numChannels, chunkSize);
+  FlacEncoder e = newFlacEncoder(fp, 44100, numChannels, bitsPerSample, level, numThreads);
+  unsigned long frame;
+  unsigned int channel;
+  boolByte result = (boolByte)(e != NULL);
+
+  for(frame = 0; result && frame < sampleBuffer->blocksize; frame += chunkSize) {
+    chunk->blocksize = sampleBuffer->blocksize - frame < chunkSize ? sampleBuffer->blocksize - frame : chunkSize;
+    for(channel = 0; channel < sampleBuffer->numChannels; channel++) {
+      memcpy(chunk->samples[channel], sampleBuffer->samples[channel] + frame, sizeof(Sample) * chunk->blocksize);
+    }
+    result = flacEncoderWrite(e, chunk);
+  }
+  if(result) {
+    result = flacEncoderFinish(e);
+  }
+
+  freeFlacEncoder(e);
+  chunk->blocksize = chunkSize;
+  freeSampleBuffer(chunk);
+  fclose(fp);
+  return result;
+}
+
+// Decode the file and check that every sample matches the input after conversion to integers
+static boolByte _decodedFileMatches(const char* filename, const SampleBuffer sampleBuffer,
+  unsigned int numChannels, unsigned int bitsPerSample) {
+  FILE* fp = fopen(filename, "rb");
+  FlacDecoder d = newFlacDecoder(fp, filename);
+  SampleBuffer decoded = newSampleBuffer(numChannels, sampleBuffer->blocksize + 1);
+  int* expected = (int*)malloc(sizeof(int) * sampleBuffer->blocksize);
+  int* actual = (int*)malloc(sizeof(int) * sampleBuffer->blocksize);
+  boolByte result = false;
+  unsigned int channel;
+
+  if(d != NULL && d->numChannels == numChannels && d->bitsPerSample == bitsPerSample &&
+    d->totalSamples == sampleBuffer->blocksize &&
+    flacDecoderRead(d, decoded) == sampleBuffer->blocksize) {
+    result = true;
+    for(channel = 0; channel < numChannels; channel++) {
+      if(channel < sampleBuffer->numChannels) {
+        pcmConvertSamplesToInt(sampleBuffer->samples[channel], expected, sampleBuffer->blocksize, bitsPerSample);
+      }
+      else {
+        memset(expected, 0, sizeof(int) * sampleBuffer->blocksize);
+      }
+      pcmConvertSamplesToInt(decoded->samples[channel], actual, sampleBuffer->blocksize, bitsPerSample);
+      if(memcmp(expected, actual, sizeof(int) * sampleBuffer->blocksize) != 0) {
+        result = false;
+      }
+    }
+  }
+
+  free(expected);
+  free(actual);
+  freeSampleBuffer(decoded);
+  freeFlacDecoder(d);
+  fclose(fp);
+  return result;
+}
+
+static long _getFileSize(const char* filename) {
+  FILE* fp = fopen(filename, "rb");
+  long result;
+  fseek(fp, 0, SEEK_END);
+  result = ftell(fp);
+  fclose(fp);
+  return result;
+}
+
+static void _flacEncoderTeardown(void) {
+  remove(TEST_FLAC_FILENAME);
+  remove(TEST_FLAC_OTHER_FILENAME);
+}
+
+static int _testEncodeMono16(void) {
+  SampleBuffer s = _newTestSignal(1, 20000);
+  assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 512, 1, 16, 5, 0));
+  assert(_decodedFileMatches(TEST_FLAC_FILENAME, s, 1, 16));
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testEncodeStereo24(void) {
+  SampleBuffer s = _newTestSignal(2, 20000);
+  assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 512, 2, 24, 8, 2));
+  assert(_decodedFileMatches(TEST_FLAC_FILENAME, s, 2, 24));
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testEncodeAllCompressionLevels(void) {
+  SampleBuffer s = _newTestSignal(2, 10000);
+  unsigned int level;
+
+  for(level = 0; level <= FLAC_ENCODER_MAX_COMPRESSION_LEVEL; level++) {
+    assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 1000, 2, 16, level, 2));
+    assert(_decodedFileMatches(TEST_FLAC_FILENAME, s, 2, 16));
+  }
+
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testEncodeShortFinalBlock(void) {
+  // Neither the length nor the chunk size are multiples of the encoder's blocksize
+  SampleBuffer s = _newTestSignal(2, 4096 * 3 + 5);
+  assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 333, 2, 16, 5, 2));
+  assert(_decodedFileMatches(TEST_FLAC_FILENAME, s, 2, 16));
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testEncodeClippedSignal(void) {
+  SampleBuffer s = _newTestSignal(1, 8192);
+  unsigned long i;
+
+  for(i = 0; i < s->blocksize; i++) {
+    s->samples[0][i] *= i % 2 ? 4.0f : -4.0f;
+  }
+  assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 8192, 1, 24, 8, 0));
+  assert(_decodedFileMatches(TEST_FLAC_FILENAME, s, 1, 24));
+
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testEncodeSilence(void) {
+  SampleBuffer s = newSampleBuffer(2, 44100);
+  sampleBufferClear(s);
+  assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 512, 2, 16, 5, 2));
+  assert(_decodedFileMatches(TEST_FLAC_FILENAME, s, 2, 16));
+  // Each frame only needs a constant subframe for each channel
+  assert(_getFileSize(TEST_FLAC_FILENAME) < 1000);
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testEncodeMissingChannels(void) {
+  SampleBuffer s = _newTestSignal(1, 5000);
+  assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 512, 2, 16, 5, 0));
+  assert(_decodedFileMatches(TEST_FLAC_FILENAME, s, 2, 16));
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testEncodeCompressesSignal(void) {
+  SampleBuffer s = _newTestSignal(2, 44100);
+  const long rawSize = 44100 * 2 * 2;
+
+  assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 512, 2, 16, 5, 0));
+  assert(_getFileSize(TEST_FLAC_FILENAME) < rawSize / 2);
+  assert(_encodeTestFile(TEST_FLAC_OTHER_FILENAME, s, 512, 2, 16, 0, 0));
+  assert(_getFileSize(TEST_FLAC_FILENAME) < _getFileSize(TEST_FLAC_OTHER_FILENAME));
+
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testThreadedOutputMatchesSingleThreaded(void) {
+  SampleBuffer s = _newTestSignal(2, 50000);
+  long size;
+  byte* expected;
+  byte* actual;
+  FILE* fp;
+
+  assert(_encodeTestFile(TEST_FLAC_FILENAME, s, 256, 2, 16, 5, 0));
+  assert(_encodeTestFile(TEST_FLAC_OTHER_FILENAME, s, 256, 2, 16, 5, 3));
+  size = _getFileSize(TEST_FLAC_FILENAME);
+  assertLongEquals(_getFileSize(TEST_FLAC_OTHER_FILENAME), size);
+
+  expected = (byte*)malloc((size_t)size);
+  actual = (byte*)malloc((size_t)size);
+  fp = fopen(TEST_FLAC_FILENAME, "rb");
+  assertSizeEquals(fread(expected, 1, (size_t)size, fp), (size_t)size);
+  fclose(fp);
+  fp = fopen(TEST_FLAC_OTHER_FILENAME, "rb");
+  assertSizeEquals(fread(actual, 1, (size_t)size, fp), (size_t)size);
+  fclose(fp);
+  assertIntEquals(memcmp(expected, actual, (size_t)size), 0);
+
+  free(expected);
+  free(actual);
+  freeSampleBuffer(s);
+  return 0;
+}
+
+static int _testNewFlacEncoderWithInvalidSettings(void) {
+  FILE* fp = fopen(TEST_FLAC_FILENAME, "wb");
+  assertIsNull(newFlacEncoder(fp, 44100, 0, 16, 5, 0));
+  assertIsNull(newFlacEncoder(fp, 44100, 9, 16, 5, 0));
+  assertIsNull(newFlacEncoder(fp, 44100, 2, 32, 5, 0));
+  assertIsNull(newFlacEncoder(fp, 44100, 2, 16, 9, 0));
+  assertIsNull(newFlacEncoder(NULL, 44100, 2, 16, 5, 0));
+  fclose(fp);
+  return 0;
+}
+
+TestSuite addFlacEncoderTests(void);
+TestSuite addFlacEncoderTests(void) {
+  TestSuite testSuite = newTestSuite("FlacEncoder", NULL, _flacEncoderTeardown);
+  addTest(testSuite, "EncodeMono16", _testEncodeMono16);
+  addTest(testSuite, "EncodeStereo24", _testEncodeStereo24);
+  addTest(testSuite, "EncodeAllCompressionLevels", _testEncodeAllCompressionLevels);
+  addTest(testSuite, "EncodeShortFinalBlock", _testEncodeShortFinalBlock);
+  addTest(testSuite, "EncodeClippedSignal", _testEncodeClippedSignal);
+  addTest(testSuite, "EncodeSilence", _testEncodeSilence);
+  addTest(testSuite, "EncodeMissingChannels", _testEncodeMissingChannels);
+  addTest(testSuite, "EncodeCompressesSignal", _testEncodeCompressesSignal);
+  addTest(testSuite, "ThreadedOutputMatchesSingleThreaded", _testThreadedOutputMatchesSingleThreaded);
+  addTest(testSuite, "NewFlacEncoderWithInvalidSettings", _testNewFlacEncoderWithInvalidSettings);
+  return testSuite;
+}
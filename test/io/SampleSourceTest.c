@@ -1,8 +1,16 @@
+#include <string.h>
+
 #include "unit/TestRunner.h"
+#include "base/PlatformUtilities.h"
 #include "io/SampleSource.h"
+#include "io/SampleSourcePcm.h"
 #include "audio/AudioSettings.h"
 
 const char* TEST_SAMPLESOURCE_FILENAME = "test.pcm";
+const char* TEST_SAMPLESOURCE_WAVE_FILENAME = "test.wav";
+const char* TEST_SAMPLESOURCE_WAVE64_FILENAME = "test.w64";
+const char* TEST_SAMPLESOURCE_AIFF_FILENAME = "test.aif";
+const char* TEST_SAMPLESOURCE_PLANAR_FILENAME = "test.mwp";
 
 static void _sampleSourceSetup(void) {
   initAudioSettings();
@@ -39,11 +47,634 @@ static int _testGuessSampleSourceTypeWrongCase(void) {
   return 0;
 }
 
+static int _testGuessSampleSourceTypeFlac(void) {
+  CharString c = newCharStringWithCString("test.flac");
+  SampleSource s = sampleSourceFactory(c);
+  assertIntEquals(s->sampleSourceType, SAMPLE_SOURCE_TYPE_FLAC);
+  freeSampleSource(s);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testGuessSampleSourceTypeWave64(void) {
+  CharString c = newCharStringWithCString("test.W64");
+  SampleSource s = sampleSourceFactory(c);
+  assertIntEquals(s->sampleSourceType, SAMPLE_SOURCE_TYPE_WAVE64);
+  freeSampleSource(s);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testGuessSampleSourceTypePlanar(void) {
+  CharString c = newCharStringWithCString("test.mwp");
+  SampleSource s = sampleSourceFactory(c);
+  assertIntEquals(s->sampleSourceType, SAMPLE_SOURCE_TYPE_PLANAR);
+  freeSampleSource(s);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testGuessSampleSourceTypeAifc(void) {
+  CharString c = newCharStringWithCString("test.aifc");
+  SampleSource s = sampleSourceFactory(c);
+  assertIntEquals(s->sampleSourceType, SAMPLE_SOURCE_TYPE_AIFF);
+  freeSampleSource(s);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testGuessSampleSourceTypeWaveStdio(void) {
+  CharString c = newCharStringWithCString("-.wav");
+  SampleSource s = sampleSourceFactory(c);
+  assertIntEquals(s->sampleSourceType, SAMPLE_SOURCE_TYPE_WAVE);
+  assert(sampleSourceIsStdio(c));
+  freeSampleSource(s);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testSampleSourceIsStdio(void) {
+  CharString c = newCharStringWithCString("-");
+  assert(sampleSourceIsStdio(c));
+  charStringCopyCString(c, "a-.wav");
+  assertFalse(sampleSourceIsStdio(c));
+  charStringCopyCString(c, "-a.wav");
+  assertFalse(sampleSourceIsStdio(c));
+  freeCharString(c);
+  return 0;
+}
+
+static void _writeTestPcmFile(const CharString filename, unsigned long numFrames) {
+  SampleSource s = sampleSourceFactory(filename);
+  SampleBuffer b = newSampleBuffer(getNumChannels(), numFrames);
+  unsigned long i;
+  unsigned int j;
+
+  for(i = 0; i < numFrames; i++) {
+    for(j = 0; j < b->numChannels; j++) {
+      b->samples[j][i] = (Sample)i / (Sample)numFrames;
+    }
+  }
+  s->openSampleSource(s, SAMPLE_SOURCE_OPEN_WRITE);
+  s->writeSampleBlock(s, b);
+  s->closeSampleSource(s);
+  freeSampleBuffer(b);
+  freeSampleSource(s);
+}
+
+static int _testSeekPcmFile(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_FILENAME);
+  SampleSource s;
+  SampleBuffer b = newSampleBuffer(getNumChannels(), 1);
+
+  _writeTestPcmFile(c, 10);
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertUnsignedLongEquals(s->lengthInFrames, 10ul);
+  assertNotNull(s->seekSampleSource);
+  assert(s->seekSampleSource(s, 5));
+  assert(s->readSampleBlock(s, b));
+  assertDoubleEquals(b->samples[0][0], 0.5, 0.02);
+
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testReadPcmFileMapped(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_FILENAME);
+  SampleSource s;
+  SampleBuffer b = newSampleBuffer(getNumChannels(), 4);
+
+  _writeTestPcmFile(c, 10);
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertNotNull(((SampleSourcePcmData)s->extraData)->mappedFile);
+  assert(s->readSampleBlock(s, b));
+  assert(s->readSampleBlock(s, b));
+  assertDoubleEquals(b->samples[1][0], 0.4, 0.02);
+  // The last block is short, which signals the end of the file
+  assertFalse(s->readSampleBlock(s, b));
+  assertUnsignedLongEquals(b->blocksize, 2ul);
+  assertDoubleEquals(b->samples[0][1], 0.9, 0.02);
+  assertUnsignedLongEquals(s->numSamplesProcessed, 20ul);
+
+  s->closeSampleSource(s);
+  assertIsNull(((SampleSourcePcmData)s->extraData)->mappedFile);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testReadWaveFileMappedIgnoresTrailingChunks(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_WAVE_FILENAME);
+  const byte trailingChunk[12] = {'L', 'I', 'S', 'T', 4, 0, 0, 0, 'I', 'N', 'F', 'O'};
+  SampleSource s;
+  SampleBuffer b;
+  FILE* fp;
+
+  _writeTestPcmFile(c, 11);
+  fp = fopen(TEST_SAMPLESOURCE_WAVE_FILENAME, "ab");
+  assertNotNull(fp);
+  fwrite(trailingChunk, 1, sizeof(trailingChunk), fp);
+  fclose(fp);
+
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertNotNull(((SampleSourcePcmData)s->extraData)->mappedFile);
+  b = newSampleBuffer(getNumChannels(), 16);
+  assertFalse(s->readSampleBlock(s, b));
+  assertUnsignedLongEquals(b->blocksize, 11ul);
+  assert(s->seekSampleSource(s, 10));
+  b->blocksize = 16;
+  s->readSampleBlock(s, b);
+  assertUnsignedLongEquals(b->blocksize, 1ul);
+  assertDoubleEquals(b->samples[0][0], 10.0 / 11.0, TEST_FLOAT_TOLERANCE);
+
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_WAVE_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testWriteBehindPcmFile(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_FILENAME);
+  SampleSource s;
+  SampleBuffer b = newSampleBuffer(getNumChannels(), 100);
+
+  setUseWriteBehind(true);
+  _writeTestPcmFile(c, 100);
+  setUseWriteBehind(false);
+
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertUnsignedLongEquals(s->lengthInFrames, 100ul);
+  s->readSampleBlock(s, b);
+  assertDoubleEquals(b->samples[0][50], 0.5, 0.02);
+  assertDoubleEquals(b->samples[1][99], 0.99, 0.02);
+
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testPreallocateWaveFile(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_WAVE_FILENAME);
+  SampleSource s = sampleSourceFactory(c);
+  SampleBuffer b = newSampleBuffer(getNumChannels(), 10);
+  FILE* fp;
+  long fileSize;
+
+  assertFalse(sampleSourcePreallocate(s, 44100));
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_WRITE));
+#if LINUX
+  assert(sampleSourcePreallocate(s, 44100));
+#endif
+  s->writeSampleBlock(s, b);
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+
+  // Space which was reserved but not written must not show up in the file
+  fp = fopen(TEST_SAMPLESOURCE_WAVE_FILENAME, "rb");
+  assertNotNull(fp);
+  fseek(fp, 0, SEEK_END);
+  fileSize = ftell(fp);
+  fclose(fp);
+  // The header has space reserved for an RF64 ds64 chunk
+  assertLongEquals(fileSize, 80l + 10 * 2 * 2);
+
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_WAVE_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testWaveFileRoundTripWithType(const char* filename, SampleSourceType type,
+  PcmSampleFormat format, unsigned int numChannels) {
+  CharString c = newCharStringWithCString(filename);
+  SampleSource s;
+  SampleBuffer b;
+
+  setNumChannels(numChannels);
+  assert(setOutputSampleFormat(format));
+  // An odd number of frames also tests padding for 24-bit mono files
+  _writeTestPcmFile(c, 11);
+  // Reading the file should set the channel count again
+  setNumChannels(numChannels + 1);
+
+  s = sampleSourceFactory(c);
+  assertIntEquals(s->sampleSourceType, type);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertIntEquals(getNumChannels(), numChannels);
+  assertUnsignedLongEquals(s->lengthInFrames, 11ul);
+  b = newSampleBuffer(numChannels, 11);
+  s->readSampleBlock(s, b);
+  assertUnsignedLongEquals(b->blocksize, 11ul);
+  assertDoubleEquals(b->samples[0][0], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(b->samples[numChannels - 1][10], 10.0 / 11.0, TEST_FLOAT_TOLERANCE);
+
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(filename);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testWaveFileRoundTrip(PcmSampleFormat format, unsigned int numChannels) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_WAVE_FILENAME, SAMPLE_SOURCE_TYPE_WAVE, format, numChannels);
+}
+
+static int _testWaveFileInt16(void) {
+  return _testWaveFileRoundTrip(PCM_SAMPLE_FORMAT_INT16, 2);
+}
+
+static int _testWaveFileInt24(void) {
+  return _testWaveFileRoundTrip(PCM_SAMPLE_FORMAT_INT24, 1);
+}
+
+static int _testWaveFileInt32(void) {
+  return _testWaveFileRoundTrip(PCM_SAMPLE_FORMAT_INT32, 2);
+}
+
+static int _testWaveFileFloat32(void) {
+  return _testWaveFileRoundTrip(PCM_SAMPLE_FORMAT_FLOAT32, 2);
+}
+
+static int _testWaveFileFloat32Mono(void) {
+  return _testWaveFileRoundTrip(PCM_SAMPLE_FORMAT_FLOAT32, 1);
+}
+
+static int _testWaveFileFloat64Multichannel(void) {
+  return _testWaveFileRoundTrip(PCM_SAMPLE_FORMAT_FLOAT64, 6);
+}
+
+static int _testWave64FileInt16(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_WAVE64_FILENAME, SAMPLE_SOURCE_TYPE_WAVE64,
+    PCM_SAMPLE_FORMAT_INT16, 2);
+}
+
+static int _testWave64FileFloat32Mono(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_WAVE64_FILENAME, SAMPLE_SOURCE_TYPE_WAVE64,
+    PCM_SAMPLE_FORMAT_FLOAT32, 1);
+}
+
+static int _testWave64FileHeaderSizes(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_WAVE64_FILENAME);
+  byte header[24];
+  FILE* fp;
+  long fileSize;
+
+  setNumChannels(1);
+  // 11 mono 16-bit frames need 2 bytes of padding
+  _writeTestPcmFile(c, 11);
+  fp = fopen(TEST_SAMPLESOURCE_WAVE64_FILENAME, "rb");
+  assertNotNull(fp);
+  fseek(fp, 0, SEEK_END);
+  fileSize = ftell(fp);
+  assertLongEquals(fileSize % 8, 0l);
+  fseek(fp, 0, SEEK_SET);
+  assertSizeEquals(fread(header, 1, 24, fp), (size_t)24);
+  assertIntEquals(memcmp(header, "riff", 4), 0);
+  assert(convertByteArrayToUnsignedLongLong(header + 16) == (unsigned long long)fileSize);
+  // The data chunk is last, and its size includes the header but not the padding
+  fseek(fp, fileSize - 24 - 24, SEEK_SET);
+  assertSizeEquals(fread(header, 1, 24, fp), (size_t)24);
+  assertIntEquals(memcmp(header, "data", 4), 0);
+  assert(convertByteArrayToUnsignedLongLong(header + 16) == 24 + 11 * 2);
+  fclose(fp);
+
+  remove(TEST_SAMPLESOURCE_WAVE64_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testAiffFileInt16(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_AIFF_FILENAME, SAMPLE_SOURCE_TYPE_AIFF,
+    PCM_SAMPLE_FORMAT_INT16, 2);
+}
+
+static int _testAiffFileInt24Mono(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_AIFF_FILENAME, SAMPLE_SOURCE_TYPE_AIFF,
+    PCM_SAMPLE_FORMAT_INT24, 1);
+}
+
+static int _testAiffFileInt32(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_AIFF_FILENAME, SAMPLE_SOURCE_TYPE_AIFF,
+    PCM_SAMPLE_FORMAT_INT32, 2);
+}
+
+static int _testAiffFileFloat32(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_AIFF_FILENAME, SAMPLE_SOURCE_TYPE_AIFF,
+    PCM_SAMPLE_FORMAT_FLOAT32, 2);
+}
+
+static int _testAiffFileFloat64Multichannel(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_AIFF_FILENAME, SAMPLE_SOURCE_TYPE_AIFF,
+    PCM_SAMPLE_FORMAT_FLOAT64, 6);
+}
+
+static int _testAiffFileHeader(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_AIFF_FILENAME);
+  // Sample rate of 48000 as an 80-bit extended float
+  const byte expectedSampleRate[10] = {0x40, 0x0e, 0xbb, 0x80, 0, 0, 0, 0, 0, 0};
+  byte header[54];
+  SampleSource s;
+  FILE* fp;
+
+  setNumChannels(1);
+  setSampleRate(48000.0);
+  // 11 mono 24-bit frames need a byte of padding
+  assert(setOutputSampleFormat(PCM_SAMPLE_FORMAT_INT24));
+  _writeTestPcmFile(c, 11);
+  fp = fopen(TEST_SAMPLESOURCE_AIFF_FILENAME, "rb");
+  assertNotNull(fp);
+  fseek(fp, 0, SEEK_END);
+  assertLongEquals(ftell(fp), 54l + 11 * 3 + 1);
+  fseek(fp, 0, SEEK_SET);
+  assertSizeEquals(fread(header, 1, 54, fp), (size_t)54);
+  fclose(fp);
+
+  assertIntEquals(memcmp(header, "FORM", 4), 0);
+  assertIntEquals(header[7], 46 + 11 * 3 + 1);
+  assertIntEquals(memcmp(header + 8, "AIFFCOMM", 8), 0);
+  // Number of frames and bits per sample
+  assertIntEquals(header[25], 11);
+  assertIntEquals(header[27], 24);
+  assertIntEquals(memcmp(header + 28, expectedSampleRate, 10), 0);
+  assertIntEquals(memcmp(header + 38, "SSND", 4), 0);
+  assertIntEquals(header[45], 8 + 11 * 3);
+
+  setSampleRate(44100.0);
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertDoubleEquals(getSampleRate(), 48000.0, TEST_FLOAT_TOLERANCE);
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+
+  remove(TEST_SAMPLESOURCE_AIFF_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testReadAifcLittleEndianFile(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_AIFF_FILENAME);
+  // Mono 16-bit little endian AIFC file with 3 frames, where the SSND chunk
+  // comes first and has 2 unused bytes before the sample data
+  const byte header[] = {
+    'F', 'O', 'R', 'M', 0, 0, 0, 60, 'A', 'I', 'F', 'C',
+    'S', 'S', 'N', 'D', 0, 0, 0, 16, 0, 0, 0, 2, 0, 0, 0, 0,
+    0xff, 0xff, 0x00, 0x00, 0x00, 0x40, 0x01, 0xc0,
+    'C', 'O', 'M', 'M', 0, 0, 0, 24,
+    0, 1, 0, 0, 0, 3, 0, 16, 0x40, 0x0e, 0xac, 0x44, 0, 0, 0, 0, 0, 0,
+    's', 'o', 'w', 't', 0, 0
+  };
+  SampleSource s;
+  SampleBuffer b = newSampleBuffer(1, 4);
+  FILE* fp = fopen(TEST_SAMPLESOURCE_AIFF_FILENAME, "wb");
+
+  assertNotNull(fp);
+  fwrite(header, 1, sizeof(header), fp);
+  fclose(fp);
+
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertUnsignedLongEquals(s->lengthInFrames, 3ul);
+  assertDoubleEquals(getSampleRate(), 44100.0, TEST_FLOAT_TOLERANCE);
+  assertFalse(s->readSampleBlock(s, b));
+  assertUnsignedLongEquals(b->blocksize, 3ul);
+  assertDoubleEquals(b->samples[0][0], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(b->samples[0][1], 0.5, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(b->samples[0][2], -0.5, TEST_FLOAT_TOLERANCE);
+
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_AIFF_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testReadRf64File(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_WAVE_FILENAME);
+  // Mono 16-bit RF64 file with 3 frames, where the 32-bit sizes are all placeholders
+  const byte header[] = {
+    'R', 'F', '6', '4', 0xff, 0xff, 0xff, 0xff, 'W', 'A', 'V', 'E',
+    'd', 's', '6', '4', 28, 0, 0, 0,
+    50, 0, 0, 0, 0, 0, 0, 0, 6, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    'f', 'm', 't', ' ', 16, 0, 0, 0,
+    1, 0, 1, 0, 0x44, 0xac, 0, 0, 0x88, 0x58, 0x01, 0, 2, 0, 16, 0,
+    'd', 'a', 't', 'a', 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x40, 0x01, 0xc0
+  };
+  SampleSource s;
+  SampleBuffer b = newSampleBuffer(1, 4);
+  FILE* fp = fopen(TEST_SAMPLESOURCE_WAVE_FILENAME, "wb");
+
+  assertNotNull(fp);
+  fwrite(header, 1, sizeof(header), fp);
+  fclose(fp);
+
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertUnsignedLongEquals(s->lengthInFrames, 3ul);
+  assertFalse(s->readSampleBlock(s, b));
+  assertUnsignedLongEquals(b->blocksize, 3ul);
+  assertDoubleEquals(b->samples[0][0], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(b->samples[0][1], 0.5, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(b->samples[0][2], -0.5, TEST_FLOAT_TOLERANCE);
+
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_WAVE_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+// Mono 16-bit WAVE file with 3 frames and a LIST chunk before the format
+// chunk, where the data size is given as dataSize, like files written to a pipe
+static int _testReadWaveFileWithDataSize(byte dataSize) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_WAVE_FILENAME);
+  const byte header[] = {
+    'R', 'I', 'F', 'F', dataSize, dataSize, dataSize, dataSize, 'W', 'A', 'V', 'E',
+    'L', 'I', 'S', 'T', 3, 0, 0, 0, 'a', 'b', 'c', 0,
+    'f', 'm', 't', ' ', 16, 0, 0, 0,
+    1, 0, 1, 0, 0x44, 0xac, 0, 0, 0x88, 0x58, 0x01, 0, 2, 0, 16, 0,
+    'd', 'a', 't', 'a', dataSize, dataSize, dataSize, dataSize,
+    0x00, 0x00, 0x00, 0x40, 0x01, 0xc0
+  };
+  SampleSource s;
+  SampleBuffer b = newSampleBuffer(1, 4);
+  FILE* fp = fopen(TEST_SAMPLESOURCE_WAVE_FILENAME, "wb");
+
+  assertNotNull(fp);
+  fwrite(header, 1, sizeof(header), fp);
+  fclose(fp);
+
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertUnsignedLongEquals(s->lengthInFrames, 3ul);
+  assertFalse(s->readSampleBlock(s, b));
+  assertUnsignedLongEquals(b->blocksize, 3ul);
+  assertDoubleEquals(b->samples[0][1], 0.5, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(b->samples[0][2], -0.5, TEST_FLOAT_TOLERANCE);
+
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_WAVE_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testReadWaveFileWithPlaceholderSize(void) {
+  return _testReadWaveFileWithDataSize(0xff);
+}
+
+static int _testReadWaveFileWithZeroSize(void) {
+  return _testReadWaveFileWithDataSize(0);
+}
+
+static int _testPlanarFileStereo(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_PLANAR_FILENAME, SAMPLE_SOURCE_TYPE_PLANAR,
+    PCM_SAMPLE_FORMAT_INT16, 2);
+}
+
+static int _testPlanarFileMultichannel(void) {
+  return _testWaveFileRoundTripWithType(TEST_SAMPLESOURCE_PLANAR_FILENAME, SAMPLE_SOURCE_TYPE_PLANAR,
+    PCM_SAMPLE_FORMAT_INT16, 6);
+}
+
+static int _testReadPlanarFileAcrossBlocks(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_PLANAR_FILENAME);
+  SampleSource s = sampleSourceFactory(c);
+  SampleBuffer b = newSampleBuffer(2, 10);
+  unsigned long i, j;
+
+  // Write 3 blocks of 10 frames, where each sample is its frame number divided
+  // by 100, and negative for the right channel
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_WRITE));
+  for(i = 0; i < 3; i++) {
+    for(j = 0; j < 10; j++) {
+      b->samples[0][j] = (Sample)(i * 10 + j) / 100.0f;
+      b->samples[1][j] = -b->samples[0][j];
+    }
+    assert(s->writeSampleBlock(s, b));
+  }
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+
+  s = sampleSourceFactory(c);
+  assert(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  assertUnsignedLongEquals(s->lengthInFrames, 30ul);
+  b = newSampleBuffer(2, 16);
+  assert(s->readSampleBlock(s, b));
+  assert(b->samples[0][15] == 0.15f);
+  assert(b->samples[1][9] == -0.09f);
+  assert(b->samples[1][10] == -0.10f);
+  assertFalse(s->readSampleBlock(s, b));
+  assertUnsignedLongEquals(b->blocksize, 14ul);
+  assert(b->samples[0][13] == 0.29f);
+
+  assert(s->seekSampleSource(s, 25));
+  b->blocksize = 16;
+  assertFalse(s->readSampleBlock(s, b));
+  assertUnsignedLongEquals(b->blocksize, 5ul);
+  assert(b->samples[0][0] == 0.25f);
+  assert(s->seekSampleSource(s, 40));
+  b->blocksize = 16;
+  assertFalse(s->readSampleBlock(s, b));
+  assertUnsignedLongEquals(b->blocksize, 0ul);
+
+  s->closeSampleSource(s);
+  freeSampleSource(s);
+  freeSampleBuffer(b);
+  remove(TEST_SAMPLESOURCE_PLANAR_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testReadPlanarFileWithBadMagic(void) {
+  CharString c = newCharStringWithCString(TEST_SAMPLESOURCE_PLANAR_FILENAME);
+  SampleSource s;
+  byte header[32];
+  FILE* fp;
+
+  memset(header, 0, sizeof(header));
+  memcpy(header, "MWPX", 4);
+  fp = fopen(TEST_SAMPLESOURCE_PLANAR_FILENAME, "wb");
+  assertNotNull(fp);
+  fwrite(header, 1, sizeof(header), fp);
+  fclose(fp);
+
+  s = sampleSourceFactory(c);
+  assertFalse(s->openSampleSource(s, SAMPLE_SOURCE_OPEN_READ));
+  freeSampleSource(s);
+  remove(TEST_SAMPLESOURCE_PLANAR_FILENAME);
+  freeCharString(c);
+  return 0;
+}
+
+static int _testSilenceHasNoLength(void) {
+  SampleSource s = sampleSourceFactory(NULL);
+  assertUnsignedLongEquals(s->lengthInFrames, 0ul);
+  assertIsNull(s->seekSampleSource);
+  freeSampleSource(s);
+  return 0;
+}
+
 TestSuite addSampleSourceTests(void);
 TestSuite addSampleSourceTests(void) {
   TestSuite testSuite = newTestSuite("SampleSource", _sampleSourceSetup, _sampleSourceTeardown);
   addTest(testSuite, "GuessSampleSourceTypePcm", _testGuessSampleSourceTypePcm);
   addTest(testSuite, "GuessSampleSourceTypeEmpty", _testGuessSampleSourceTypeEmpty);
   addTest(testSuite, "GuessSampleSourceTypeWrongCase", _testGuessSampleSourceTypeWrongCase);
+  addTest(testSuite, "GuessSampleSourceTypeFlac", _testGuessSampleSourceTypeFlac);
+  addTest(testSuite, "GuessSampleSourceTypeWave64", _testGuessSampleSourceTypeWave64);
+  addTest(testSuite, "GuessSampleSourceTypePlanar", _testGuessSampleSourceTypePlanar);
+  addTest(testSuite, "GuessSampleSourceTypeAifc", _testGuessSampleSourceTypeAifc);
+  addTest(testSuite, "GuessSampleSourceTypeWaveStdio", _testGuessSampleSourceTypeWaveStdio);
+  addTest(testSuite, "SampleSourceIsStdio", _testSampleSourceIsStdio);
+  addTest(testSuite, "SeekPcmFile", _testSeekPcmFile);
+  addTest(testSuite, "ReadPcmFileMapped", _testReadPcmFileMapped);
+  addTest(testSuite, "ReadWaveFileMappedIgnoresTrailingChunks", _testReadWaveFileMappedIgnoresTrailingChunks);
+  addTest(testSuite, "WriteBehindPcmFile", _testWriteBehindPcmFile);
+  addTest(testSuite, "PreallocateWaveFile", _testPreallocateWaveFile);
+  addTest(testSuite, "WaveFileInt16", _testWaveFileInt16);
+  addTest(testSuite, "WaveFileInt24", _testWaveFileInt24);
+  addTest(testSuite, "WaveFileInt32", _testWaveFileInt32);
+  addTest(testSuite, "WaveFileFloat32", _testWaveFileFloat32);
+  addTest(testSuite, "WaveFileFloat32Mono", _testWaveFileFloat32Mono);
+  addTest(testSuite, "WaveFileFloat64Multichannel", _testWaveFileFloat64Multichannel);
+  addTest(testSuite, "Wave64FileInt16", _testWave64FileInt16);
+  addTest(testSuite, "Wave64FileFloat32Mono", _testWave64FileFloat32Mono);
+  addTest(testSuite, "Wave64FileHeaderSizes", _testWave64FileHeaderSizes);
+  addTest(testSuite, "ReadRf64File", _testReadRf64File);
+  addTest(testSuite, "AiffFileInt16", _testAiffFileInt16);
+  addTest(testSuite, "AiffFileInt24Mono", _testAiffFileInt24Mono);
+  addTest(testSuite, "AiffFileInt32", _testAiffFileInt32);
+  addTest(testSuite, "AiffFileFloat32", _testAiffFileFloat32);
+  addTest(testSuite, "AiffFileFloat64Multichannel", _testAiffFileFloat64Multichannel);
+  addTest(testSuite, "AiffFileHeader", _testAiffFileHeader);
+  addTest(testSuite, "ReadAifcLittleEndianFile", _testReadAifcLittleEndianFile);
+  addTest(testSuite, "ReadWaveFileWithPlaceholderSize", _testReadWaveFileWithPlaceholderSize);
+  addTest(testSuite, "ReadWaveFileWithZeroSize", _testReadWaveFileWithZeroSize);
+  addTest(testSuite, "PlanarFileStereo", _testPlanarFileStereo);
+  addTest(testSuite, "PlanarFileMultichannel", _testPlanarFileMultichannel);
+  addTest(testSuite, "ReadPlanarFileAcrossBlocks", _testReadPlanarFileAcrossBlocks);
+  addTest(testSuite, "ReadPlanarFileWithBadMagic", _testReadPlanarFileWithBadMagic);
+  addTest(testSuite, "SilenceHasNoLength", _testSilenceHasNoLength);
   return testSuite;
 }
@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "unit/TestRunner.h"
+#include "audio/AudioSettings.h"
+#include "midi/MidiEvent.h"
+#include "plugin/PluginAutomation.h"
+
+#include "PluginMock.h"
+
+#if UNIX
+#define TEST_AUTOMATION_FILE "/tmp/mrswatsontest-automation.txt"
+#elif WINDOWS
+#define TEST_AUTOMATION_FILE "C:\\Temp\\mrswatsontest-automation.txt"
+#else
+#define TEST_AUTOMATION_FILE "mrswatsontest-automation.txt"
+#endif
+
+static void _pluginAutomationTestSetup(void) {
+  initAudioSettings();
+  initAudioClock();
+}
+
+static void _pluginAutomationTestTeardown(void) {
+  unlink(TEST_AUTOMATION_FILE);
+  freeAudioClock(getAudioClock());
+  freeAudioSettings();
+}
+
+static boolByte _addPointFromCString(PluginAutomation automation, const char* line) {
+  CharString c = newCharStringWithCString(line);
+  boolByte result = pluginAutomationAddPointFromString(automation, c);
+  freeCharString(c);
+  return result;
+}
+
+static PluginAutomationPoint _getPoint(PluginAutomation automation, int index) {
+  LinkedListIterator iterator = automation->points;
+  int i;
+  for(i = 0; i < index; i++) {
+    iterator = iterator->nextItem;
+  }
+  return (PluginAutomationPoint)iterator->item;
+}
+
+static PluginChain _newPluginChainWithMock(Plugin* outMock) {
+  PluginChain pluginChain = newPluginChain();
+  *outMock = newPluginMock();
+  pluginChainAppend(pluginChain, *outMock, NULL);
+  pluginChainInitialize(pluginChain);
+  return pluginChain;
+}
+
+static int _testNewPluginAutomation(void) {
+  PluginAutomation a = newPluginAutomation();
+  assertNotNull(a);
+  assertIntEquals(linkedListLength(a->points), 0);
+  freePluginAutomation(a);
+  return 0;
+}
+
+static int _testParsePoint(void) {
+  PluginAutomation a = newPluginAutomation();
+  PluginAutomationPoint p;
+
+  assert(_addPointFromCString(a, "1500.5,1,2,0.75"));
+  assertIntEquals(linkedListLength(a->points), 1);
+  p = _getPoint(a, 0);
+  assertDoubleEquals(p->timeInMs, 1500.5, TEST_FLOAT_TOLERANCE);
+  assertFalse(p->timeIsInFrames);
+  assertIntEquals(p->pluginIndex, 1);
+  assertIntEquals(p->parameterIndex, 2);
+  assertDoubleEquals(p->value, 0.75, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(p->rampTimeInMs, 0.0, TEST_FLOAT_TOLERANCE);
+
+  freePluginAutomation(a);
+  return 0;
+}
+
+static int _testParsePointWithFramesAndRamp(void) {
+  PluginAutomation a = newPluginAutomation();
+  PluginAutomationPoint p;
+
+  assert(_addPointFromCString(a, "44100f, 0, 3, 1.0, 64f"));
+  p = _getPoint(a, 0);
+  assertDoubleEquals(p->timeInMs, 44100.0, TEST_FLOAT_TOLERANCE);
+  assert(p->timeIsInFrames);
+  assertIntEquals(p->parameterIndex, 3);
+  assertDoubleEquals(p->rampTimeInMs, 64.0, TEST_FLOAT_TOLERANCE);
+  assert(p->rampTimeIsInFrames);
+
+  freePluginAutomation(a);
+  return 0;
+}
+
+static int _testParseInvalidPoints(void) {
+  PluginAutomation a = newPluginAutomation();
+
+  assertFalse(_addPointFromCString(a, ""));
+  assertFalse(_addPointFromCString(a, "100,0,1"));
+  assertFalse(_addPointFromCString(a, "100,0,,1,0.5"));
+  assertFalse(_addPointFromCString(a, "100,0,1,0.5,10,20"));
+  assertFalse(_addPointFromCString(a, "abc,0,1,0.5"));
+  assertFalse(_addPointFromCString(a, "100,0,1,0.5x"));
+  assertFalse(_addPointFromCString(a, "-100,0,1,0.5"));
+  assertIntEquals(linkedListLength(a->points), 0);
+
+  freePluginAutomation(a);
+  return 0;
+}
+
+static int _testReadFile(void) {
+  CharString filename = newCharStringWithCString(TEST_AUTOMATION_FILE);
+  FILE* fp = fopen(TEST_AUTOMATION_FILE, "w");
+  PluginAutomation a;
+
+  fprintf(fp, "# time,plugin,parameter,value,ramp\n0,0,1,0.25\n\n1000,0,1,0.75,500\n");
+  fclose(fp);
+  a = newPluginAutomationWithFile(filename);
+  assertNotNull(a);
+  assertIntEquals(linkedListLength(a->points), 2);
+  assertDoubleEquals(_getPoint(a, 1)->rampTimeInMs, 500.0, TEST_FLOAT_TOLERANCE);
+
+  freePluginAutomation(a);
+  freeCharString(filename);
+  return 0;
+}
+
+static int _testReadInvalidFile(void) {
+  CharString filename = newCharStringWithCString(TEST_AUTOMATION_FILE);
+  FILE* fp = fopen(TEST_AUTOMATION_FILE, "w");
+
+  fprintf(fp, "0,0,1,0.25\ninvalid\n");
+  fclose(fp);
+  assertIsNull(newPluginAutomationWithFile(filename));
+  unlink(TEST_AUTOMATION_FILE);
+  assertIsNull(newPluginAutomationWithFile(filename));
+
+  freeCharString(filename);
+  return 0;
+}
+
+static int _testPrepareWithInvalidPluginIndex(void) {
+  PluginAutomation a = newPluginAutomation();
+  Plugin mock;
+  PluginChain p = _newPluginChainWithMock(&mock);
+
+  assert(_addPointFromCString(a, "0,1,0,0.5"));
+  assertFalse(pluginAutomationPrepare(a, p));
+
+  freePluginAutomation(a);
+  freePluginChain(p);
+  return 0;
+}
+
+static int _testChangeAtExactFrame(void) {
+  PluginAutomation a = newPluginAutomation();
+  Plugin mock;
+  PluginChain p = _newPluginChainWithMock(&mock);
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+
+  assert(_addPointFromCString(a, "100f,0,0,0.5"));
+  assert(pluginAutomationPrepare(a, p));
+  pluginAutomationProcessAudio(a, p, getAudioClock(), NULL, inBuffer, outBuffer);
+
+  assertIntEquals(((PluginMockData)mock->extraData)->numProcessAudioCalls, 2);
+  assertUnsignedLongEquals(outBuffer->blocksize, (unsigned long)DEFAULT_BLOCKSIZE);
+  assertDoubleEquals(outBuffer->samples[0][99], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[0][100], 0.5, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[1][DEFAULT_BLOCKSIZE - 1], 0.5, TEST_FLOAT_TOLERANCE);
+  assertUnsignedLongEquals(getAudioClock()->currentFrame, 0l);
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginAutomation(a);
+  freePluginChain(p);
+  return 0;
+}
+
+static int _testChangeInLaterBlock(void) {
+  PluginAutomation a = newPluginAutomation();
+  Plugin mock;
+  PluginChain p = _newPluginChainWithMock(&mock);
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+
+  assert(_addPointFromCString(a, "1000f,0,0,0.5"));
+  assert(pluginAutomationPrepare(a, p));
+  pluginAutomationProcessAudio(a, p, getAudioClock(), NULL, inBuffer, outBuffer);
+  assertIntEquals(((PluginMockData)mock->extraData)->numProcessAudioCalls, 1);
+  advanceAudioClock(getAudioClock(), DEFAULT_BLOCKSIZE);
+  pluginAutomationProcessAudio(a, p, getAudioClock(), NULL, inBuffer, outBuffer);
+  assertIntEquals(((PluginMockData)mock->extraData)->numProcessAudioCalls, 3);
+  assertDoubleEquals(outBuffer->samples[0][1000 - DEFAULT_BLOCKSIZE - 1], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[0][1000 - DEFAULT_BLOCKSIZE], 0.5, TEST_FLOAT_TOLERANCE);
+  assertUnsignedLongEquals(getAudioClock()->currentFrame, (unsigned long)DEFAULT_BLOCKSIZE);
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginAutomation(a);
+  freePluginChain(p);
+  return 0;
+}
+
+static int _testChangeAtBlockStartDoesNotSplitBlock(void) {
+  PluginAutomation a = newPluginAutomation();
+  Plugin mock;
+  PluginChain p = _newPluginChainWithMock(&mock);
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+
+  assert(_addPointFromCString(a, "0f,0,0,0.5"));
+  assert(pluginAutomationPrepare(a, p));
+  pluginAutomationProcessAudio(a, p, getAudioClock(), NULL, inBuffer, outBuffer);
+  assertIntEquals(((PluginMockData)mock->extraData)->numProcessAudioCalls, 1);
+  assertDoubleEquals(outBuffer->samples[0][0], 0.5, TEST_FLOAT_TOLERANCE);
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginAutomation(a);
+  freePluginChain(p);
+  return 0;
+}
+
+static int _testRamp(void) {
+  PluginAutomation a = newPluginAutomation();
+  Plugin mock;
+  PluginChain p = _newPluginChainWithMock(&mock);
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  const int rampLength = PLUGIN_AUTOMATION_RAMP_STEP_FRAMES * 2;
+  char line[64];
+
+  assert(_addPointFromCString(a, "0f,0,0,0.0"));
+  snprintf(line, 64, "100f,0,0,1.0,%df", rampLength);
+  assert(_addPointFromCString(a, line));
+  assert(pluginAutomationPrepare(a, p));
+  pluginAutomationProcessAudio(a, p, getAudioClock(), NULL, inBuffer, outBuffer);
+
+  assertDoubleEquals(outBuffer->samples[0][100], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[0][100 + PLUGIN_AUTOMATION_RAMP_STEP_FRAMES - 1], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[0][100 + PLUGIN_AUTOMATION_RAMP_STEP_FRAMES], 0.5, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[0][100 + rampLength - 1], 0.5, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[0][100 + rampLength], 1.0, TEST_FLOAT_TOLERANCE);
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginAutomation(a);
+  freePluginChain(p);
+  return 0;
+}
+
+static int _testPointsAreSortedByTime(void) {
+  PluginAutomation a = newPluginAutomation();
+  Plugin mock;
+  PluginChain p = _newPluginChainWithMock(&mock);
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+
+  assert(_addPointFromCString(a, "200f,0,0,0.75"));
+  assert(_addPointFromCString(a, "100f,0,0,0.25"));
+  assert(pluginAutomationPrepare(a, p));
+  pluginAutomationProcessAudio(a, p, getAudioClock(), NULL, inBuffer, outBuffer);
+
+  assertDoubleEquals(outBuffer->samples[0][150], 0.25, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[0][250], 0.75, TEST_FLOAT_TOLERANCE);
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginAutomation(a);
+  freePluginChain(p);
+  return 0;
+}
+
+static int _testRewind(void) {
+  PluginAutomation a = newPluginAutomation();
+  Plugin mock;
+  PluginChain p = _newPluginChainWithMock(&mock);
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+
+  assert(_addPointFromCString(a, "100f,0,0,0.5"));
+  assert(pluginAutomationPrepare(a, p));
+  pluginAutomationProcessAudio(a, p, getAudioClock(), NULL, inBuffer, outBuffer);
+  ((PluginMockData)mock->extraData)->parameterValue = 0.0f;
+  pluginAutomationRewind(a);
+  pluginAutomationProcessAudio(a, p, getAudioClock(), NULL, inBuffer, outBuffer);
+  assertDoubleEquals(outBuffer->samples[0][99], 0.0, TEST_FLOAT_TOLERANCE);
+  assertDoubleEquals(outBuffer->samples[0][100], 0.5, TEST_FLOAT_TOLERANCE);
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginAutomation(a);
+  freePluginChain(p);
+  return 0;
+}
+
+static MidiEvent _newNoteOnAtFrame(unsigned long timestamp) {
+  MidiEvent midiEvent = newMidiEvent();
+  midiEvent->eventType = MIDI_TYPE_REGULAR;
+  midiEvent->status = 0x90;
+  midiEvent->data1 = 60;
+  midiEvent->data2 = 127;
+  midiEvent->timestamp = timestamp;
+  midiEvent->deltaFrames = timestamp;
+  return midiEvent;
+}
+
+static int _testMidiEventsAreSentWithTheirChunk(void) {
+  PluginAutomation a = newPluginAutomation();
+  Plugin mock;
+  PluginChain p = _newPluginChainWithMock(&mock);
+  PluginMockData mockData;
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  LinkedList midiEvents = newLinkedList();
+  MidiEvent beforeSplit = _newNoteOnAtFrame(50);
+  MidiEvent afterSplit = _newNoteOnAtFrame(300);
+
+  linkedListAppend(midiEvents, beforeSplit);
+  linkedListAppend(midiEvents, afterSplit);
+  assert(_addPointFromCString(a, "100f,0,0,0.5"));
+  assert(pluginAutomationPrepare(a, p));
+  pluginAutomationProcessAudio(a, p, getAudioClock(), midiEvents, inBuffer, outBuffer);
+
+  mockData = (PluginMockData)mock->extraData;
+  assertIntEquals(mockData->numProcessAudioCalls, 2);
+  assertIntEquals(mockData->numMidiEvents, 2);
+  // The first event is sent before the first piece, at its offset in the block
+  assertIntEquals(mockData->midiEventProcessAudioCalls[0], 0);
+  assertUnsignedLongEquals(mockData->midiEventDeltaFrames[0], 50l);
+  // The second event is sent before the second piece, which starts at frame 100
+  assertIntEquals(mockData->midiEventProcessAudioCalls[1], 1);
+  assertUnsignedLongEquals(mockData->midiEventDeltaFrames[1], 200l);
+
+  freeMidiEvent(beforeSplit);
+  freeMidiEvent(afterSplit);
+  freeLinkedList(midiEvents);
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginAutomation(a);
+  freePluginChain(p);
+  return 0;
+}
+
+static int _testFreeNullPluginAutomation(void) {
+  freePluginAutomation(NULL);
+  return 0;
+}
+
+TestSuite addPluginAutomationTests(void);
+TestSuite addPluginAutomationTests(void) {
+  TestSuite testSuite = newTestSuite("PluginAutomation", _pluginAutomationTestSetup, _pluginAutomationTestTeardown);
+  addTest(testSuite, "NewObject", _testNewPluginAutomation);
+  addTest(testSuite, "ParsePoint", _testParsePoint);
+  addTest(testSuite, "ParsePointWithFramesAndRamp", _testParsePointWithFramesAndRamp);
+  addTest(testSuite, "ParseInvalidPoints", _testParseInvalidPoints);
+  addTest(testSuite, "ReadFile", _testReadFile);
+  addTest(testSuite, "ReadInvalidFile", _testReadInvalidFile);
+  addTest(testSuite, "PrepareWithInvalidPluginIndex", _testPrepareWithInvalidPluginIndex);
+  addTest(testSuite, "ChangeAtExactFrame", _testChangeAtExactFrame);
+  addTest(testSuite, "ChangeInLaterBlock", _testChangeInLaterBlock);
+  addTest(testSuite, "ChangeAtBlockStartDoesNotSplitBlock", _testChangeAtBlockStartDoesNotSplitBlock);
+  addTest(testSuite, "Ramp", _testRamp);
+  addTest(testSuite, "PointsAreSortedByTime", _testPointsAreSortedByTime);
+  addTest(testSuite, "Rewind", _testRewind);
+  addTest(testSuite, "MidiEventsAreSentWithTheirChunk", _testMidiEventsAreSentWithTheirChunk);
+  addTest(testSuite, "FreeNullPluginAutomation", _testFreeNullPluginAutomation);
+  return testSuite;
+}
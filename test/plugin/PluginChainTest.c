@@ -3,6 +3,7 @@
 #include "midi/MidiEvent.h"
 #include "plugin/PluginChain.h"
 #include "plugin/PluginPassthru.h"
+#include "time/AudioClock.h"
 
 #include "PluginMock.h"
 #include "PluginPresetMock.h"
@@ -198,6 +199,42 @@ static int _testPrepareForProcessing(void) {
   return 0;  
 }
 
+static int _testResetPluginChain(void) {
+  Plugin mock = newPluginMock();
+  PluginChain p = getPluginChain();
+  PluginPreset mockPreset = newPluginPresetMock();
+
+  assert(pluginChainAppend(p, mock, mockPreset));
+  assertIntEquals(pluginChainInitialize(p), RETURN_CODE_SUCCESS);
+  pluginChainPrepareForProcessing(p);
+  ((PluginPresetMockData)mockPreset->extraData)->isLoaded = false;
+
+  assert(pluginChainReset(p));
+  assertFalse(((PluginMockData)mock->extraData)->isPrepared);
+  assertIntEquals(((PluginMockData)mock->extraData)->numSuspendCalls, 1);
+  assert(((PluginPresetMockData)mockPreset->extraData)->isLoaded);
+  pluginChainPrepareForProcessing(p);
+  assert(((PluginMockData)mock->extraData)->isPrepared);
+
+  return 0;
+}
+
+static int _testResetPluginChainRestoresParameters(void) {
+  Plugin mock = newPluginMock();
+  PluginChain p = getPluginChain();
+  PluginMockData mockData = (PluginMockData)mock->extraData;
+
+  assert(pluginChainAppend(p, mock, NULL));
+  assertIntEquals(pluginChainInitialize(p), RETURN_CODE_SUCCESS);
+  mock->setParameter(mock, 0, 0.5f);
+  assertDoubleEquals(mockData->parameterValue, 0.5, 0.0);
+
+  assert(pluginChainReset(p));
+  assertDoubleEquals(mockData->parameterValue, 0.0, 0.0);
+
+  return 0;
+}
+
 static int _testProcessPluginChainAudio(void) {
   Plugin mock = newPluginMock();
   PluginChain p = getPluginChain();
@@ -213,6 +250,90 @@ static int _testProcessPluginChainAudio(void) {
   return 0;
 }
 
+static int _getMonoPluginSetting(void* pluginPtr, PluginSetting pluginSetting) {
+  switch(pluginSetting) {
+    case PLUGIN_NUM_INPUTS:
+    case PLUGIN_NUM_OUTPUTS:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+static int _testProcessPluginChainAudioWithChannelMapping(void) {
+  Plugin mock = newPluginMock();
+  PluginChain p = getPluginChain();
+  CharString testArgs = newCharStringWithCString(kInternalPluginPassthruName);
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+
+  mock->getSetting = _getMonoPluginSetting;
+  ((PluginMockData)mock->extraData)->parameterValue = 0.5f;
+  assert(pluginChainAppend(p, mock, NULL));
+  assert(pluginChainAddFromArgumentString(p, testArgs, NULL));
+  pluginChainPrepareForProcessing(p);
+  pluginChainProcessAudio(p, inBuffer, outBuffer);
+  assertIntEquals(outBuffer->numChannels, DEFAULT_NUM_CHANNELS);
+  assertDoubleEquals(outBuffer->samples[0][0], 0.5, 0.0001);
+  assertDoubleEquals(outBuffer->samples[1][DEFAULT_BLOCKSIZE - 1], 0.5, 0.0001);
+
+  freeCharString(testArgs);
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  return 0;
+}
+
+static int _testProcessPluginGraphAudio(void) {
+  PluginChain p = getPluginChain();
+  CharString testArgs = newCharStringWithCString("mrs_passthru;[mrs_passthru+]");
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+
+  inBuffer->samples[0][0] = 0.25f;
+  assert(pluginChainAddFromArgumentString(p, testArgs, NULL));
+  assertIntEquals(p->numPlugins, 2);
+  assertNotNull(p->graph);
+  assertIntEquals(pluginChainInitialize(p), RETURN_CODE_SUCCESS);
+  pluginChainPrepareForProcessing(p);
+  pluginChainProcessAudio(p, inBuffer, outBuffer);
+  assertDoubleEquals(outBuffer->samples[0][0], 0.5, 0.0001);
+  assertDoubleEquals(outBuffer->samples[0][1], 0.0, 0.0001);
+
+  freeCharString(testArgs);
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  return 0;
+}
+
+static int _testSetPipelineStages(void) {
+  PluginChain p = getPluginChain();
+  CharString testArgs = newCharStringWithCString("mrs_passthru;mrs_passthru;mrs_passthru");
+
+  assert(pluginChainAddFromArgumentString(p, testArgs, NULL));
+  assert(pluginChainSetPipelineStages(p, 2));
+  assertNotNull(p->pipeline);
+  assertUnsignedLongEquals(pluginChainGetProcessingDelay(p), (unsigned long)getBlocksize());
+  assert(pluginChainSetPipelineStages(p, 1));
+  assertIsNull(p->pipeline);
+  assertUnsignedLongEquals(pluginChainGetProcessingDelay(p), 0ul);
+  assertFalse(pluginChainSetPipelineStages(p, 0));
+
+  freeCharString(testArgs);
+  return 0;
+}
+
+static int _testSetPipelineStagesWithGraph(void) {
+  PluginChain p = getPluginChain();
+  CharString testArgs = newCharStringWithCString("[mrs_passthru+mrs_passthru]");
+
+  assert(pluginChainAddFromArgumentString(p, testArgs, NULL));
+  assertFalse(pluginChainSetPipelineStages(p, 2));
+  assertIsNull(p->pipeline);
+
+  freeCharString(testArgs);
+  return 0;
+}
+
 static int _testProcessPluginChainAudioRealtime(void) {
   Plugin mock = newPluginMock();
   PluginChain p = getPluginChain();
@@ -253,6 +374,61 @@ static int _testProcessPluginChainMidiEvents(void) {
   return 0;
 }
 
+static int _processMidiEventsWithSplitting(unsigned long timestamp1, unsigned long timestamp2,
+  PluginMockData* outMockData) {
+  Plugin mock = newPluginMock();
+  PluginChain p = getPluginChain();
+  SampleBuffer inBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  SampleBuffer outBuffer = newSampleBuffer(DEFAULT_NUM_CHANNELS, DEFAULT_BLOCKSIZE);
+  LinkedList list = newLinkedList();
+  MidiEvent midi1 = newMidiEvent();
+  MidiEvent midi2 = newMidiEvent();
+
+  initAudioClock();
+  midi1->timestamp = timestamp1;
+  midi2->timestamp = timestamp2;
+  linkedListAppend(list, midi1);
+  linkedListAppend(list, midi2);
+  assert(pluginChainAppend(p, mock, NULL));
+  assertIntEquals(pluginChainInitialize(p), RETURN_CODE_SUCCESS);
+  pluginChainSetMidiEventSplitting(p, true);
+  pluginChainPrepareForProcessing(p);
+  pluginChainProcessMidi(p, list);
+  pluginChainProcessAudio(p, inBuffer, outBuffer);
+  *outMockData = (PluginMockData)mock->extraData;
+
+  freeMidiEvent(midi1);
+  freeMidiEvent(midi2);
+  freeLinkedList(list);
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  return 0;
+}
+
+static int _testProcessMidiEventsWithSplitting(void) {
+  PluginMockData mockData;
+  assertIntEquals(_processMidiEventsWithSplitting(100, 300, &mockData), 0);
+  assertIntEquals(mockData->numProcessMidiCalls, 2);
+  assertIntEquals(mockData->numProcessAudioCalls, 3);
+  return 0;
+}
+
+static int _testProcessSimultaneousMidiEventsWithSplitting(void) {
+  PluginMockData mockData;
+  assertIntEquals(_processMidiEventsWithSplitting(100, 100, &mockData), 0);
+  assertIntEquals(mockData->numProcessMidiCalls, 1);
+  assertIntEquals(mockData->numProcessAudioCalls, 2);
+  return 0;
+}
+
+static int _testProcessMidiEventsAtBlockStartWithSplitting(void) {
+  PluginMockData mockData;
+  assertIntEquals(_processMidiEventsWithSplitting(0, 0, &mockData), 0);
+  assertIntEquals(mockData->numProcessMidiCalls, 1);
+  assertIntEquals(mockData->numProcessAudioCalls, 1);
+  return 0;
+}
+
 static int _testShutdown(void) {
   Plugin mock = newPluginMock();
   PluginChain p = getPluginChain();
@@ -284,10 +460,19 @@ TestSuite addPluginChainTests(void) {
   addTest(testSuite, "GetMaximumTailTime", _testGetMaximumTailTime);
 
   addTest(testSuite, "PrepareForProcessing", _testPrepareForProcessing);
+  addTest(testSuite, "ResetPluginChain", _testResetPluginChain);
+  addTest(testSuite, "ResetPluginChainRestoresParameters", _testResetPluginChainRestoresParameters);
   addTest(testSuite, "ProcessPluginChainAudio", _testProcessPluginChainAudio);
+  addTest(testSuite, "ProcessPluginChainAudioWithChannelMapping", _testProcessPluginChainAudioWithChannelMapping);
+  addTest(testSuite, "ProcessPluginGraphAudio", _testProcessPluginGraphAudio);
+  addTest(testSuite, "SetPipelineStages", _testSetPipelineStages);
+  addTest(testSuite, "SetPipelineStagesWithGraph", _testSetPipelineStagesWithGraph);
   addTest(testSuite, "ProcessPluginChainAudioRealtime", _testProcessPluginChainAudioRealtime);
   addTest(testSuite, "ProcessPluginChainMidiEvents", _testProcessPluginChainMidiEvents);
 
+  addTest(testSuite, "ProcessMidiEventsWithSplitting", _testProcessMidiEventsWithSplitting);
+  addTest(testSuite, "ProcessSimultaneousMidiEventsWithSplitting", _testProcessSimultaneousMidiEventsWithSplitting);
+  addTest(testSuite, "ProcessMidiEventsAtBlockStartWithSplitting", _testProcessMidiEventsAtBlockStartWithSplitting);
   addTest(testSuite, "Shutdown", _testShutdown);
 
   return testSuite;
@@ -0,0 +1,218 @@
+#include "unit/TestRunner.h"
+#include "audio/AudioSettings.h"
+#include "plugin/PluginGraph.h"
+
+#include "PluginMock.h"
+
+#define TEST_NUM_PLUGINS 5
+static const int kTestShortDelay = 10;
+static const int kTestLongDelay = 100;
+
+static Plugin _testPlugins[TEST_NUM_PLUGINS];
+
+static int _getSettingWithShortDelay(void* pluginPtr, PluginSetting pluginSetting) {
+  return pluginSetting == PLUGIN_INITIAL_DELAY ? kTestShortDelay : 2;
+}
+
+static int _getSettingWithLongDelay(void* pluginPtr, PluginSetting pluginSetting) {
+  return pluginSetting == PLUGIN_INITIAL_DELAY ? kTestLongDelay : 2;
+}
+
+static void _pluginGraphTestSetup(void) {
+  unsigned int i;
+  initAudioSettings();
+  for(i = 0; i < TEST_NUM_PLUGINS; i++) {
+    _testPlugins[i] = newPluginMock();
+    openPlugin(_testPlugins[i]);
+    // Normally allocated by the chain when preparing
+    _testPlugins[i]->inputBuffer = newSampleBuffer(2, getBlocksize());
+    _testPlugins[i]->outputBuffer = newSampleBuffer(2, getBlocksize());
+  }
+}
+
+static void _pluginGraphTestTeardown(void) {
+  unsigned int i;
+  for(i = 0; i < TEST_NUM_PLUGINS; i++) {
+    closePlugin(_testPlugins[i]);
+    freePlugin(_testPlugins[i]);
+  }
+  freeAudioSettings();
+}
+
+static PluginGraph _newPluginGraphWithCString(const char* argument) {
+  CharString c = newCharStringWithCString(argument);
+  PluginGraph graph = newPluginGraphWithString(c);
+  freeCharString(c);
+  return graph;
+}
+
+static void _setMockValue(unsigned int pluginIndex, float value) {
+  ((PluginMockData)_testPlugins[pluginIndex]->extraData)->parameterValue = value;
+}
+
+static SampleBuffer _processTestPlugin(void* userData, unsigned int pluginIndex, SampleBuffer input) {
+  Plugin plugin = _testPlugins[pluginIndex];
+  plugin->inputBuffer->blocksize = input->blocksize;
+  sampleBufferCopyAndMapChannels(plugin->inputBuffer, input);
+  plugin->outputBuffer->blocksize = input->blocksize;
+  plugin->processAudio(plugin, plugin->inputBuffer, plugin->outputBuffer);
+  return plugin->outputBuffer;
+}
+
+static void* _getItem(LinkedList list, int index) {
+  LinkedListIterator iterator = list;
+  while(index-- > 0) {
+    iterator = iterator->nextItem;
+  }
+  return iterator->item;
+}
+
+static PluginGraphNode _getNode(LinkedList nodes, int index) {
+  return (PluginGraphNode)_getItem(nodes, index);
+}
+
+static int _testIsGraphString(void) {
+  CharString c = newCharStringWithCString("a;b");
+  assertFalse(pluginGraphIsGraphString(c));
+  charStringCopyCString(c, "a;[b+c]");
+  assert(pluginGraphIsGraphString(c));
+  charStringCopyCString(c, "a]");
+  assert(pluginGraphIsGraphString(c));
+  freeCharString(c);
+  return 0;
+}
+
+static int _testParseGraph(void) {
+  PluginGraph g = _newPluginGraphWithCString("a,preset;[b+c;d];e");
+  PluginGraphNode group;
+  PluginGraphBranch branch;
+  CharString argument;
+
+  assertNotNull(g);
+  assertIntEquals(pluginGraphGetNumPlugins(g), 5);
+  argument = (CharString)g->pluginArguments->item;
+  assertCharStringEquals(argument, "a,preset");
+  assertIntEquals(linkedListLength(g->root->nodes), 3);
+  assertIntEquals(_getNode(g->root->nodes, 0)->type, PLUGIN_GRAPH_NODE_PLUGIN);
+  assertIntEquals(_getNode(g->root->nodes, 2)->pluginIndex, 4);
+
+  group = _getNode(g->root->nodes, 1);
+  assertIntEquals(group->type, PLUGIN_GRAPH_NODE_GROUP);
+  assertIntEquals(linkedListLength(group->branches), 2);
+  branch = (PluginGraphBranch)_getItem(group->branches, 1);
+  assertIntEquals(linkedListLength(branch->nodes), 2);
+  assertIntEquals(_getNode(branch->nodes, 0)->pluginIndex, 2);
+  assertIntEquals(_getNode(branch->nodes, 1)->pluginIndex, 3);
+
+  assert(pluginGraphIsHeadPlugin(g, 0));
+  assertFalse(pluginGraphIsHeadPlugin(g, 1));
+  freePluginGraph(g);
+  return 0;
+}
+
+static int _testParseGraphWithEmptyBranch(void) {
+  PluginGraph g = _newPluginGraphWithCString("[+a]");
+  PluginGraphNode group;
+
+  assertNotNull(g);
+  assertIntEquals(pluginGraphGetNumPlugins(g), 1);
+  group = _getNode(g->root->nodes, 0);
+  assertIntEquals(linkedListLength(group->branches), 2);
+  assertIsNull(((PluginGraphBranch)group->branches->item)->nodes->item);
+  assertFalse(pluginGraphIsHeadPlugin(g, 0));
+
+  freePluginGraph(g);
+  return 0;
+}
+
+static int _testParseInvalidGraphs(void) {
+  assertIsNull(_newPluginGraphWithCString("[a"));
+  assertIsNull(_newPluginGraphWithCString("a]"));
+  assertIsNull(_newPluginGraphWithCString("[a+b"));
+  assertIsNull(_newPluginGraphWithCString("a[b]"));
+  assertIsNull(_newPluginGraphWithCString("[a]b"));
+  assertIsNull(_newPluginGraphWithCString("a+b"));
+  assertIsNull(_newPluginGraphWithCString("[+]"));
+  return 0;
+}
+
+static int _testGetProcessingDelay(void) {
+  PluginGraph g = _newPluginGraphWithCString("a;[b+c;d];e");
+
+  _testPlugins[0]->getSetting = _getSettingWithShortDelay;
+  _testPlugins[1]->getSetting = _getSettingWithLongDelay;
+  _testPlugins[2]->getSetting = _getSettingWithShortDelay;
+  _testPlugins[3]->getSetting = _getSettingWithShortDelay;
+  assertUnsignedLongEquals(pluginGraphGetProcessingDelay(g, _testPlugins), 110ul);
+  assertUnsignedLongEquals(pluginGraphGetProcessingDelayAtPlugin(g, _testPlugins, 0), 10ul);
+  assertUnsignedLongEquals(pluginGraphGetProcessingDelayAtPlugin(g, _testPlugins, 1), 110ul);
+  assertUnsignedLongEquals(pluginGraphGetProcessingDelayAtPlugin(g, _testPlugins, 2), 20ul);
+  assertUnsignedLongEquals(pluginGraphGetProcessingDelayAtPlugin(g, _testPlugins, 3), 30ul);
+  assertUnsignedLongEquals(pluginGraphGetProcessingDelayAtPlugin(g, _testPlugins, 4), 110ul);
+
+  freePluginGraph(g);
+  return 0;
+}
+
+static int _testProcessParallelBranches(void) {
+  PluginGraph g = _newPluginGraphWithCString("[a+b+c]");
+  SampleBuffer b = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer result;
+  unsigned int i;
+
+  _setMockValue(0, 0.1f);
+  _setMockValue(1, 0.2f);
+  _setMockValue(2, 0.3f);
+  pluginGraphPrepare(g, _testPlugins, _processTestPlugin, NULL);
+  for(i = 0; i < 3; i++) {
+    result = pluginGraphProcessAudio(g, b);
+    assertUnsignedLongEquals(result->blocksize, getBlocksize());
+    assertDoubleEquals(result->samples[0][0], 0.6, 0.0001);
+    assertDoubleEquals(result->samples[1][getBlocksize() - 1], 0.6, 0.0001);
+  }
+  assertIntEquals(((PluginMockData)_testPlugins[2]->extraData)->numProcessAudioCalls, 3);
+
+  freeSampleBuffer(b);
+  freePluginGraph(g);
+  return 0;
+}
+
+static int _testProcessWithDelayCompensation(void) {
+  PluginGraph g = _newPluginGraphWithCString("[a+]");
+  SampleBuffer b = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer result;
+  unsigned int i;
+
+  for(i = 0; i < getBlocksize(); i++) {
+    b->samples[0][i] = 1.0f;
+    b->samples[1][i] = 1.0f;
+  }
+  _testPlugins[0]->getSetting = _getSettingWithLongDelay;
+  _setMockValue(0, 0.5f);
+  pluginGraphPrepare(g, _testPlugins, _processTestPlugin, NULL);
+
+  // The dry branch is delayed to line up with the plugin
+  result = pluginGraphProcessAudio(g, b);
+  assertDoubleEquals(result->samples[0][0], 0.5, 0.0001);
+  assertDoubleEquals(result->samples[0][kTestLongDelay - 1], 0.5, 0.0001);
+  assertDoubleEquals(result->samples[0][kTestLongDelay], 1.5, 0.0001);
+  result = pluginGraphProcessAudio(g, b);
+  assertDoubleEquals(result->samples[1][0], 1.5, 0.0001);
+
+  freeSampleBuffer(b);
+  freePluginGraph(g);
+  return 0;
+}
+
+TestSuite addPluginGraphTests(void);
+TestSuite addPluginGraphTests(void) {
+  TestSuite testSuite = newTestSuite("PluginGraph", _pluginGraphTestSetup, _pluginGraphTestTeardown);
+  addTest(testSuite, "IsGraphString", _testIsGraphString);
+  addTest(testSuite, "ParseGraph", _testParseGraph);
+  addTest(testSuite, "ParseGraphWithEmptyBranch", _testParseGraphWithEmptyBranch);
+  addTest(testSuite, "ParseInvalidGraphs", _testParseInvalidGraphs);
+  addTest(testSuite, "GetProcessingDelay", _testGetProcessingDelay);
+  addTest(testSuite, "ProcessParallelBranches", _testProcessParallelBranches);
+  addTest(testSuite, "ProcessWithDelayCompensation", _testProcessWithDelayCompensation);
+  return testSuite;
+}
@@ -1,4 +1,5 @@
 #include "PluginMock.h"
+#include "midi/MidiEvent.h"
 
 
 static void _pluginMockEmpty(void* pluginPtr) {
@@ -22,6 +23,8 @@ static int _pluginMockGetSetting(void* pluginPtr, PluginSetting pluginSetting) {
       return 2;
     case PLUGIN_INITIAL_DELAY:
       return 0;
+    case PLUGIN_NUM_PARAMETERS:
+      return 1;
     default:
       return 0;
   }
@@ -33,21 +36,54 @@ static void _pluginMockPrepareForProcessing(void* pluginPtr) {
   extraData->isPrepared = true;
 }
 
+static void _pluginMockSuspend(void* pluginPtr) {
+  Plugin self = (Plugin)pluginPtr;
+  PluginMockData extraData = (PluginMockData)self->extraData;
+  extraData->isPrepared = false;
+  extraData->numSuspendCalls++;
+}
+
 static void _pluginMockProcessAudio(void* pluginPtr, SampleBuffer inputs, SampleBuffer outputs) {
   Plugin self = (Plugin)pluginPtr;
   PluginMockData extraData = (PluginMockData)self->extraData;
+  unsigned int i;
+  unsigned long j;
   extraData->processAudioCalled = true;
-  sampleBufferClear(outputs);
+  extraData->numProcessAudioCalls++;
+  for(i = 0; i < outputs->numChannels; i++) {
+    for(j = 0; j < outputs->blocksize; j++) {
+      outputs->samples[i][j] = extraData->parameterValue;
+    }
+  }
 }
 
 static void _pluginMockProcessMidiEvents(void* pluginPtr, LinkedList midiEvents) {
   Plugin self = (Plugin)pluginPtr;
   PluginMockData extraData = (PluginMockData)self->extraData;
+  LinkedListIterator iterator = midiEvents;
   extraData->processMidiCalled = true;
+  extraData->numProcessMidiCalls++;
+  while(iterator != NULL && iterator->item != NULL) {
+    if(extraData->numMidiEvents < PLUGIN_MOCK_MAX_MIDI_EVENTS) {
+      extraData->midiEventDeltaFrames[extraData->numMidiEvents] = ((MidiEvent)iterator->item)->deltaFrames;
+      extraData->midiEventProcessAudioCalls[extraData->numMidiEvents] = extraData->numProcessAudioCalls;
+      extraData->numMidiEvents++;
+    }
+    iterator = (LinkedListIterator)iterator->nextItem;
+  }
 }
 
 static boolByte _pluginMockSetParameter(void* pluginPtr, unsigned int i, float value) {
-  return false;
+  Plugin self = (Plugin)pluginPtr;
+  PluginMockData extraData = (PluginMockData)self->extraData;
+  extraData->parameterValue = value;
+  return true;
+}
+
+static float _pluginMockGetParameter(void* pluginPtr, unsigned int i) {
+  Plugin self = (Plugin)pluginPtr;
+  PluginMockData extraData = (PluginMockData)self->extraData;
+  return extraData->parameterValue;
 }
 
 static void _pluginMockClose(void* pluginPtr) {
@@ -65,9 +101,11 @@ Plugin newPluginMock(void) {
   plugin->displayInfo = _pluginMockEmpty;
   plugin->getSetting = _pluginMockGetSetting;
   plugin->prepareForProcessing = _pluginMockPrepareForProcessing;
+  plugin->suspend = _pluginMockSuspend;
   plugin->processAudio = _pluginMockProcessAudio;
   plugin->processMidiEvents = _pluginMockProcessMidiEvents;
   plugin->setParameter = _pluginMockSetParameter;
+  plugin->getParameter = _pluginMockGetParameter;
   plugin->closePlugin = _pluginMockClose;
   plugin->freePluginData = _pluginMockEmpty;
 
@@ -76,6 +114,11 @@ Plugin newPluginMock(void) {
   extraData->isPrepared = false;
   extraData->processAudioCalled = false;
   extraData->processMidiCalled = false;
+  extraData->numSuspendCalls = 0;
+  extraData->numProcessAudioCalls = 0;
+  extraData->numProcessMidiCalls = 0;
+  extraData->numMidiEvents = 0;
+  extraData->parameterValue = 0.0f;
   plugin->extraData = extraData;
 
   return plugin;
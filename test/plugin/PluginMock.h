@@ -5,12 +5,23 @@
 #include "plugin/Plugin.h"
 
 static const int kPluginMockTailTime = 123;
+#define PLUGIN_MOCK_MAX_MIDI_EVENTS 16
 
 typedef struct {
   boolByte isOpen;
   boolByte isPrepared;
   boolByte processAudioCalled;
   boolByte processMidiCalled;
+  int numSuspendCalls;
+  int numProcessAudioCalls;
+  int numProcessMidiCalls;
+  // Offset of each MIDI event received, and how many audio blocks had been
+  // processed when it arrived
+  int numMidiEvents;
+  unsigned long midiEventDeltaFrames[PLUGIN_MOCK_MAX_MIDI_EVENTS];
+  int midiEventProcessAudioCalls[PLUGIN_MOCK_MAX_MIDI_EVENTS];
+  // Last value given to setParameter(), which is written to all output samples
+  float parameterValue;
 } PluginMockDataMembers;
 typedef PluginMockDataMembers* PluginMockData;
 
@@ -0,0 +1,189 @@
+#include "unit/TestRunner.h"
+#include "audio/AudioSettings.h"
+#include "plugin/PluginPipeline.h"
+
+#include "PluginMock.h"
+
+#define TEST_NUM_PLUGINS 3
+
+static Plugin _testPlugins[TEST_NUM_PLUGINS];
+
+static void _pluginPipelineTestSetup(void) {
+  unsigned int i;
+  initAudioSettings();
+  initAudioClock();
+  for(i = 0; i < TEST_NUM_PLUGINS; i++) {
+    _testPlugins[i] = newPluginMock();
+    openPlugin(_testPlugins[i]);
+    // Normally allocated by the chain when preparing
+    _testPlugins[i]->inputBuffer = newSampleBuffer(2, getBlocksize());
+    _testPlugins[i]->outputBuffer = newSampleBuffer(2, getBlocksize());
+  }
+}
+
+static void _pluginPipelineTestTeardown(void) {
+  unsigned int i;
+  for(i = 0; i < TEST_NUM_PLUGINS; i++) {
+    closePlugin(_testPlugins[i]);
+    freePlugin(_testPlugins[i]);
+  }
+  freeAudioClock(getAudioClock());
+  freeAudioSettings();
+}
+
+// Adds 1.0 to each sample, so the output shows how many plugins a block went through
+static SampleBuffer _processTestPlugin(void* userData, unsigned int pluginIndex, SampleBuffer input) {
+  Plugin plugin = _testPlugins[pluginIndex];
+  unsigned int i;
+  unsigned long j;
+
+  plugin->outputBuffer->blocksize = input->blocksize;
+  for(i = 0; i < plugin->outputBuffer->numChannels; i++) {
+    for(j = 0; j < input->blocksize; j++) {
+      plugin->outputBuffer->samples[i][j] = input->samples[i][j] + 1.0f;
+    }
+  }
+  return plugin->outputBuffer;
+}
+
+// Like _processTestPlugin, but writes the number of the block which the plugin
+// sees in the audio clock to the first sample of the second channel
+static SampleBuffer _processTestPluginWithClock(void* userData, unsigned int pluginIndex, SampleBuffer input) {
+  SampleBuffer output = _processTestPlugin(userData, pluginIndex, input);
+  output->samples[1][0] = (Sample)(getAudioClock()->currentFrame / getBlocksize());
+  return output;
+}
+
+static void _fillBuffer(SampleBuffer buffer, Sample value) {
+  unsigned int i;
+  unsigned long j;
+  for(i = 0; i < buffer->numChannels; i++) {
+    for(j = 0; j < buffer->blocksize; j++) {
+      buffer->samples[i][j] = value;
+    }
+  }
+}
+
+static int _testNewPipelineDividesPlugins(void) {
+  PluginPipeline p = newPluginPipeline(3, 5);
+  assertIntEquals(p->numStages, 3);
+  assertIntEquals(p->stages[0]->firstPlugin, 0);
+  assertIntEquals(p->stages[0]->numPlugins, 1);
+  assertIntEquals(p->stages[1]->firstPlugin, 1);
+  assertIntEquals(p->stages[1]->numPlugins, 2);
+  assertIntEquals(p->stages[2]->firstPlugin, 3);
+  assertIntEquals(p->stages[2]->numPlugins, 2);
+  freePluginPipeline(p);
+  return 0;
+}
+
+static int _testNewPipelineWithMoreStagesThanPlugins(void) {
+  PluginPipeline p = newPluginPipeline(8, 2);
+  assertIntEquals(p->numStages, 2);
+  assertIntEquals(p->stages[1]->firstPlugin, 1);
+  assertIntEquals(p->stages[1]->numPlugins, 1);
+  freePluginPipeline(p);
+  return 0;
+}
+
+static int _testGetDelay(void) {
+  PluginPipeline p = newPluginPipeline(3, 5);
+  assertUnsignedLongEquals(pluginPipelineGetDelay(p), 2 * getBlocksize());
+  freePluginPipeline(p);
+  p = newPluginPipeline(1, 5);
+  assertUnsignedLongEquals(pluginPipelineGetDelay(p), 0ul);
+  freePluginPipeline(p);
+  return 0;
+}
+
+static int _testProcessAudio(void) {
+  PluginPipeline p = newPluginPipeline(TEST_NUM_PLUGINS, TEST_NUM_PLUGINS);
+  SampleBuffer inBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer outBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  double expected;
+  unsigned int i;
+
+  pluginPipelinePrepare(p, _testPlugins, _processTestPlugin, NULL);
+  for(i = 0; i < 8; i++) {
+    _fillBuffer(inBuffer, (Sample)i);
+    pluginPipelineProcessAudio(p, inBuffer, outBuffer);
+    assertUnsignedLongEquals(outBuffer->blocksize, getBlocksize());
+    if(i < TEST_NUM_PLUGINS - 1) {
+      assertDoubleEquals(outBuffer->samples[0][0], 0.0, 0.0001);
+    }
+    else {
+      // Block i - 2 after passing through all three plugins
+      expected = i - 2.0 + TEST_NUM_PLUGINS;
+      assertDoubleEquals(outBuffer->samples[0][0], expected, 0.0001);
+      assertDoubleEquals(outBuffer->samples[1][getBlocksize() - 1], expected, 0.0001);
+    }
+  }
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginPipeline(p);
+  return 0;
+}
+
+static int _testStagesSeeClockOfTheirBlock(void) {
+  PluginPipeline p = newPluginPipeline(TEST_NUM_PLUGINS, TEST_NUM_PLUGINS);
+  SampleBuffer inBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer outBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  double expected;
+  unsigned int i;
+
+  pluginPipelinePrepare(p, _testPlugins, _processTestPluginWithClock, NULL);
+  for(i = 0; i < 8; i++) {
+    _fillBuffer(inBuffer, (Sample)i);
+    pluginPipelineProcessAudio(p, inBuffer, outBuffer);
+    if(i >= TEST_NUM_PLUGINS - 1) {
+      // The last plugin processed block i - 2, even though the clock has moved on
+      expected = i - 2.0;
+      assertDoubleEquals(outBuffer->samples[1][0], expected, 0.0001);
+      expected = i - 2.0 + TEST_NUM_PLUGINS;
+      assertDoubleEquals(outBuffer->samples[0][0], expected, 0.0001);
+    }
+    advanceAudioClock(getAudioClock(), getBlocksize());
+  }
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginPipeline(p);
+  return 0;
+}
+
+static int _testPrepareDiscardsQueuedBlocks(void) {
+  PluginPipeline p = newPluginPipeline(2, 2);
+  SampleBuffer inBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer outBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+
+  pluginPipelinePrepare(p, _testPlugins, _processTestPlugin, NULL);
+  _fillBuffer(inBuffer, 1.0f);
+  pluginPipelineProcessAudio(p, inBuffer, outBuffer);
+  pluginPipelineProcessAudio(p, inBuffer, outBuffer);
+  assertDoubleEquals(outBuffer->samples[0][0], 3.0, 0.0001);
+
+  pluginPipelinePrepare(p, _testPlugins, _processTestPlugin, NULL);
+  _fillBuffer(inBuffer, 5.0f);
+  pluginPipelineProcessAudio(p, inBuffer, outBuffer);
+  assertDoubleEquals(outBuffer->samples[0][0], 0.0, 0.0001);
+  pluginPipelineProcessAudio(p, inBuffer, outBuffer);
+  assertDoubleEquals(outBuffer->samples[0][0], 7.0, 0.0001);
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  freePluginPipeline(p);
+  return 0;
+}
+
+TestSuite addPluginPipelineTests(void);
+TestSuite addPluginPipelineTests(void) {
+  TestSuite testSuite = newTestSuite("PluginPipeline", _pluginPipelineTestSetup, _pluginPipelineTestTeardown);
+  addTest(testSuite, "NewPipelineDividesPlugins", _testNewPipelineDividesPlugins);
+  addTest(testSuite, "NewPipelineWithMoreStagesThanPlugins", _testNewPipelineWithMoreStagesThanPlugins);
+  addTest(testSuite, "GetDelay", _testGetDelay);
+  addTest(testSuite, "ProcessAudio", _testProcessAudio);
+  addTest(testSuite, "StagesSeeClockOfTheirBlock", _testStagesSeeClockOfTheirBlock);
+  addTest(testSuite, "PrepareDiscardsQueuedBlocks", _testPrepareDiscardsQueuedBlocks);
+  return testSuite;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "unit/TestRunner.h"
+#include "audio/AudioSettings.h"
+#include "plugin/PluginChain.h"
+#include "time/AudioClock.h"
+
+#include "PluginMock.h"
+
+#if UNIX
+#define TEST_TAP_FILE "/tmp/mrswatsontest-tap.pcm"
+#elif WINDOWS
+#define TEST_TAP_FILE "C:\\Temp\\mrswatsontest-tap.pcm"
+#else
+#define TEST_TAP_FILE "mrswatsontest-tap.pcm"
+#endif
+
+static void _pluginTapTestSetup(void) {
+  initAudioSettings();
+  initAudioClock();
+}
+
+static void _pluginTapTestTeardown(void) {
+  unlink(TEST_TAP_FILE);
+  freeAudioClock(getAudioClock());
+  freeAudioSettings();
+}
+
+static PluginTap _newPluginTapWithCString(const char* argument) {
+  CharString c = newCharStringWithCString(argument);
+  PluginTap tap = newPluginTapWithString(c);
+  freeCharString(c);
+  return tap;
+}
+
+static unsigned long _getFramesWritten(PluginTap tap) {
+  return tap->outputSource->numSamplesProcessed / getNumChannels();
+}
+
+static int _testParseTap(void) {
+  PluginTap t = _newPluginTapWithCString("2:" TEST_TAP_FILE);
+  assertNotNull(t);
+  assertIntEquals(t->pluginIndex, 2);
+  assertNotNull(t->outputSource);
+  assertCharStringEquals(t->outputSource->sourceName, TEST_TAP_FILE);
+  assertUnsignedLongEquals(t->skipHeadFrames, 0ul);
+  freePluginTap(t);
+  return 0;
+}
+
+static int _testParseInvalidTaps(void) {
+  assertIsNull(_newPluginTapWithCString(""));
+  assertIsNull(_newPluginTapWithCString(TEST_TAP_FILE));
+  assertIsNull(_newPluginTapWithCString(":" TEST_TAP_FILE));
+  assertIsNull(_newPluginTapWithCString("1:"));
+  assertIsNull(_newPluginTapWithCString("x:" TEST_TAP_FILE));
+  assertIsNull(_newPluginTapWithCString("-1:" TEST_TAP_FILE));
+  assertIsNull(_newPluginTapWithCString("1x:" TEST_TAP_FILE));
+  return 0;
+}
+
+static int _testSkipHeadFrames(void) {
+  PluginTap t = _newPluginTapWithCString("0:" TEST_TAP_FILE);
+  SampleBuffer b = newSampleBuffer(getNumChannels(), getBlocksize());
+  const unsigned long skipHeadFrames = getBlocksize() + 100;
+
+  assert(pluginTapOpen(t, skipHeadFrames));
+  pluginTapProcessAudio(t, b);
+  assertUnsignedLongEquals(_getFramesWritten(t), 0ul);
+  pluginTapProcessAudio(t, b);
+  assertUnsignedLongEquals(_getFramesWritten(t), getBlocksize() - 100ul);
+  pluginTapProcessAudio(t, b);
+  assertUnsignedLongEquals(_getFramesWritten(t), 2 * getBlocksize() - 100ul);
+  assertUnsignedLongEquals(t->framesProcessed, 3 * getBlocksize());
+
+  freeSampleBuffer(b);
+  freePluginTap(t);
+  return 0;
+}
+
+static int _testAddTapWithInvalidPluginIndex(void) {
+  PluginChain c = newPluginChain();
+  PluginTap t = _newPluginTapWithCString("1:" TEST_TAP_FILE);
+  pluginChainAppend(c, newPluginMock(), NULL);
+  assertFalse(pluginChainAddTap(c, t));
+  assertIsNull(c->taps->item);
+  freePluginTap(t);
+  freePluginChain(c);
+  return 0;
+}
+
+static int _testChainWritesTap(void) {
+  PluginChain c = newPluginChain();
+  PluginTap t = _newPluginTapWithCString("0:" TEST_TAP_FILE);
+  SampleBuffer inBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+  SampleBuffer outBuffer = newSampleBuffer(getNumChannels(), getBlocksize());
+
+  pluginChainAppend(c, newPluginMock(), NULL);
+  assertIntEquals(pluginChainInitialize(c), RETURN_CODE_SUCCESS);
+  assert(pluginChainAddTap(c, t));
+  pluginChainPrepareForProcessing(c);
+  pluginChainProcessAudio(c, inBuffer, outBuffer);
+  assertUnsignedLongEquals(_getFramesWritten(t), (unsigned long)getBlocksize());
+
+  freeSampleBuffer(inBuffer);
+  freeSampleBuffer(outBuffer);
+  pluginChainShutdown(c);
+  freePluginChain(c);
+  return 0;
+}
+
+static int _testFreeNullPluginTap(void) {
+  freePluginTap(NULL);
+  return 0;
+}
+
+TestSuite addPluginTapTests(void);
+TestSuite addPluginTapTests(void) {
+  TestSuite testSuite = newTestSuite("PluginTap", _pluginTapTestSetup, _pluginTapTestTeardown);
+  addTest(testSuite, "ParseTap", _testParseTap);
+  addTest(testSuite, "ParseInvalidTaps", _testParseInvalidTaps);
+  addTest(testSuite, "SkipHeadFrames", _testSkipHeadFrames);
+  addTest(testSuite, "AddTapWithInvalidPluginIndex", _testAddTapWithInvalidPluginIndex);
+  addTest(testSuite, "ChainWritesTap", _testChainWritesTap);
+  addTest(testSuite, "FreeNullPluginTap", _testFreeNullPluginTap);
+  return testSuite;
+}
@@ -60,6 +60,19 @@ static int _testAdvanceClockMulitpleTimes(void) {
   return 0;
 }
 
+static int _testResetAudioClock(void) {
+  AudioClock audioClock = getAudioClock();
+  advanceAudioClock(audioClock, kAudioClockTestBlocksize);
+  audioClockStop(audioClock);
+  audioClockReset(audioClock);
+  assertUnsignedLongEquals(audioClock->currentFrame, 0l);
+  assertFalse(audioClock->isPlaying);
+  assertFalse(audioClock->transportChanged);
+  advanceAudioClock(audioClock, kAudioClockTestBlocksize);
+  assert(audioClock->transportChanged);
+  return 0;
+}
+
 TestSuite addAudioClockTests(void);
 TestSuite addAudioClockTests(void) {
   TestSuite testSuite = newTestSuite("AudioClock", _audioClockTestSetup, _audioClockTestTeardown);
@@ -68,5 +81,6 @@ TestSuite addAudioClockTests(void) {
   addTest(testSuite, "StopClock", _testStopAudioClock);
   addTest(testSuite, "RestartClock", _testRestartAudioClock);
   addTest(testSuite, "MultipleAdvance", _testAdvanceClockMulitpleTimes);
+  addTest(testSuite, "ResetClock", _testResetAudioClock);
   return testSuite;
 }
@@ -0,0 +1,158 @@
+#include "unit/TestRunner.h"
+#include "time/RealtimeScheduler.h"
+#include "time/TaskTimer.h"
+
+#define TEST_STATS_FILENAME "realtime-stats.json"
+// Sleeping may take quite a bit longer than requested on a loaded machine
+#define MAX_OVERSLEEP_MS 20.0
+
+static RealtimeScheduler _testRealtimeScheduler;
+static TaskTimer _testTimer;
+
+static void _realtimeSchedulerSetup(void) {
+  _testRealtimeScheduler = newRealtimeScheduler();
+  _testTimer = newTaskTimerWithCString("test", "realtime");
+}
+
+static void _realtimeSchedulerTeardown(void) {
+  freeRealtimeScheduler(_testRealtimeScheduler);
+  freeTaskTimer(_testTimer);
+}
+
+static int _testNewRealtimeScheduler(void) {
+  RealtimeScheduler s = _testRealtimeScheduler;
+  unsigned int i;
+
+  assertUnsignedLongEquals(s->numBlocks, 0ul);
+  assertUnsignedLongEquals(s->numLateBlocks, 0ul);
+  assertDoubleEquals(s->maxLatenessInMs, 0.0, TEST_FLOAT_TOLERANCE);
+  for(i = 0; i < REALTIME_SCHEDULER_HISTOGRAM_SIZE; i++) {
+    assertUnsignedLongEquals(s->latenessHistogram[i], 0ul);
+  }
+  return 0;
+}
+
+static int _testWaitSleepsUntilDeadline(void) {
+  double elapsedTimeInMs;
+
+  taskTimerStart(_testTimer);
+  assertDoubleEquals(realtimeSchedulerWaitForBlock(_testRealtimeScheduler, 10.0), 0.0, TEST_FLOAT_TOLERANCE);
+  elapsedTimeInMs = taskTimerStop(_testTimer);
+  assert(elapsedTimeInMs >= 9.0);
+  assert(elapsedTimeInMs < 10.0 + MAX_OVERSLEEP_MS);
+  assertUnsignedLongEquals(_testRealtimeScheduler->numBlocks, 1ul);
+  assertUnsignedLongEquals(_testRealtimeScheduler->numLateBlocks, 0ul);
+  return 0;
+}
+
+static int _testWaitDoesNotDrift(void) {
+  double firstDeadline;
+  double scheduledTimeInMs;
+  double elapsedTimeInMs;
+  int i;
+
+  taskTimerStart(_testTimer);
+  realtimeSchedulerWaitForBlock(_testRealtimeScheduler, 2.0);
+  firstDeadline = _testRealtimeScheduler->_deadline;
+  for(i = 0; i < 20; i++) {
+    // Processing time for each block must not push back the deadlines
+    sleepMilliseconds(0.5);
+    realtimeSchedulerWaitForBlock(_testRealtimeScheduler, 2.0);
+  }
+  elapsedTimeInMs = taskTimerStop(_testTimer);
+  scheduledTimeInMs = _testRealtimeScheduler->_deadline - firstDeadline;
+  assertDoubleEquals(scheduledTimeInMs, 40.0, TEST_FLOAT_TOLERANCE);
+  assert(elapsedTimeInMs >= 41.0);
+  return 0;
+}
+
+static int _testLateBlockIsCounted(void) {
+  RealtimeScheduler s = _testRealtimeScheduler;
+  double latenessInMs;
+
+  realtimeSchedulerWaitForBlock(s, 1.0);
+  sleepMilliseconds(30.0);
+  latenessInMs = realtimeSchedulerWaitForBlock(s, 1.0);
+  assert(latenessInMs >= 28.0);
+  assertUnsignedLongEquals(s->numBlocks, 2ul);
+  assertUnsignedLongEquals(s->numLateBlocks, 1ul);
+  assertDoubleEquals(s->maxLatenessInMs, latenessInMs, TEST_FLOAT_TOLERANCE);
+  // 20-50ms bucket
+  assertUnsignedLongEquals(s->latenessHistogram[5], 1ul);
+  return 0;
+}
+
+static int _testCatchesUpAfterLateBlock(void) {
+  RealtimeScheduler s = _testRealtimeScheduler;
+
+  realtimeSchedulerWaitForBlock(s, 1.0);
+  sleepMilliseconds(30.0);
+  realtimeSchedulerWaitForBlock(s, 1.0);
+  // These blocks are still behind the schedule, so they don't sleep
+  assert(realtimeSchedulerWaitForBlock(s, 10.0) > 0.0);
+  assert(realtimeSchedulerWaitForBlock(s, 10.0) > 0.0);
+  // And this one is back on time
+  assertDoubleEquals(realtimeSchedulerWaitForBlock(s, 50.0), 0.0, TEST_FLOAT_TOLERANCE);
+  assertUnsignedLongEquals(s->numLateBlocks, 3ul);
+  return 0;
+}
+
+static int _testRestartKeepsStatistics(void) {
+  RealtimeScheduler s = _testRealtimeScheduler;
+
+  realtimeSchedulerWaitForBlock(s, 1.0);
+  sleepMilliseconds(30.0);
+  realtimeSchedulerWaitForBlock(s, 1.0);
+  realtimeSchedulerRestart(s);
+  sleepMilliseconds(30.0);
+  // The time between renders doesn't make the next block late
+  assertDoubleEquals(realtimeSchedulerWaitForBlock(s, 1.0), 0.0, TEST_FLOAT_TOLERANCE);
+  assertUnsignedLongEquals(s->numBlocks, 3ul);
+  assertUnsignedLongEquals(s->numLateBlocks, 1ul);
+  return 0;
+}
+
+static int _testGetHistogramBucketLimits(void) {
+  assertDoubleEquals(realtimeSchedulerGetHistogramBucketLimitInMs(0), 1.0, TEST_FLOAT_TOLERANCE);
+  assert(realtimeSchedulerGetHistogramBucketLimitInMs(REALTIME_SCHEDULER_HISTOGRAM_SIZE - 1) < 0.0);
+  return 0;
+}
+
+static int _testWriteStats(void) {
+  CharString filename = newCharStringWithCString(TEST_STATS_FILENAME);
+  CharString contents = newCharStringWithCapacity(kCharStringLengthLong);
+  FILE* fileHandle;
+  size_t bytesRead;
+
+  _testRealtimeScheduler->numBlocks = 10;
+  _testRealtimeScheduler->numLateBlocks = 2;
+  assert(realtimeSchedulerWriteStats(_testRealtimeScheduler, filename));
+  fileHandle = fopen(TEST_STATS_FILENAME, "r");
+  assertNotNull(fileHandle);
+  bytesRead = fread(contents->data, 1, contents->capacity - 1, fileHandle);
+  contents->data[bytesRead] = '\0';
+  fclose(fileHandle);
+  remove(TEST_STATS_FILENAME);
+
+  assertCharStringContains(contents, "\"blocks\": 10,");
+  assertCharStringContains(contents, "\"lateBlocks\": 2,");
+  assertCharStringContains(contents, "\"limitMs\": null");
+
+  freeCharString(filename);
+  freeCharString(contents);
+  return 0;
+}
+
+TestSuite addRealtimeSchedulerTests(void);
+TestSuite addRealtimeSchedulerTests(void) {
+  TestSuite testSuite = newTestSuite("RealtimeScheduler", _realtimeSchedulerSetup, _realtimeSchedulerTeardown);
+  addTest(testSuite, "NewObject", _testNewRealtimeScheduler);
+  addTest(testSuite, "WaitSleepsUntilDeadline", _testWaitSleepsUntilDeadline);
+  addTest(testSuite, "WaitDoesNotDrift", _testWaitDoesNotDrift);
+  addTest(testSuite, "LateBlockIsCounted", _testLateBlockIsCounted);
+  addTest(testSuite, "CatchesUpAfterLateBlock", _testCatchesUpAfterLateBlock);
+  addTest(testSuite, "RestartKeepsStatistics", _testRestartKeepsStatistics);
+  addTest(testSuite, "GetHistogramBucketLimits", _testGetHistogramBucketLimits);
+  addTest(testSuite, "WriteStats", _testWriteStats);
+  return testSuite;
+}
@@ -4,12 +4,19 @@
 #include <stdarg.h>
 
 #include "ApplicationRunner.h"
+#include "app/RenderDaemon.h"
 #include "base/File.h"
 #include "analysis/AnalyzeFile.h"
 
+#if UNIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
 const char* kDefaultTestOutputFileType = "pcm";
 static const char* kApplicationRunnerOutputFolder = "out";
 static const int kApplicationRunnerWaitTimeoutInMs = 1000;
+static const int kApplicationRunnerDaemonTimeoutInMs = 10000;
 
 CharString buildTestArgumentString(const char* arguments, ...) {
   CharString formattedArguments;
@@ -97,6 +104,21 @@ static void _removeOutputFiles(const char* testName) {
   outputFilename = getTestOutputFilename(testName, "txt");
   _removeOutputFile(outputFilename->data);
   freeCharString(outputFilename);
+  outputFilename = getTestOutputFilename(testName, "sock");
+  _removeOutputFile(outputFilename->data);
+  freeCharString(outputFilename);
+}
+
+static void _prepareOutputFolder(const char* testName) {
+  // Remove files from a previous test run
+  File outputFolder = newFileWithPathCString(kApplicationRunnerOutputFolder);
+  if(fileExists(outputFolder)) {
+    _removeOutputFiles(testName);
+  }
+  else {
+    fileCreate(outputFolder, kFileTypeDirectory);
+  }
+  freeFile(outputFolder);
 }
 
 static const char* _getResultCodeString(const int resultCode) {
@@ -115,6 +137,68 @@ static const char* _getResultCodeString(const int resultCode) {
   }
 }
 
+static void _checkApplicationTestResult(const TestEnvironment testEnvironment, const char* testName,
+  ReturnCodes resultCode, ReturnCodes expectedResultCode, const char* outputFileType, const char* outputFilename) {
+  CharString failedAnalysisFunctionName = newCharString();
+  unsigned long failedAnalysisSample;
+
+  if(resultCode == RETURN_CODE_FORK_FAILED ||
+     resultCode == RETURN_CODE_SHELL_FAILED ||
+     resultCode == RETURN_CODE_LAUNCH_FAILED_OTHER) {
+    if(testEnvironment->results->onlyPrintFailing) {
+      printTestName(testName);
+    }
+    printTestFail();
+    logCritical("Could not launch shell, got return code %d\n\
+Please check the executable path specified in the --mrswatson-path argument.",
+      resultCode);
+    testEnvironment->results->numFail++;
+  }
+  else if(resultCode == expectedResultCode) {
+    if(outputFileType != NULL) {
+      if(analyzeFile(outputFilename, failedAnalysisFunctionName, &failedAnalysisSample)) {
+        testEnvironment->results->numSuccess++;
+        if(!testEnvironment->results->keepFiles) {
+          _removeOutputFiles(testName);
+        }
+        if(!testEnvironment->results->onlyPrintFailing) {
+          printTestSuccess();
+        }
+      }
+      else {
+        if(testEnvironment->results->onlyPrintFailing) {
+          printTestName(testName);
+        }
+        fprintf(stderr, "Analysis function %s failed at sample %lu. ",
+          failedAnalysisFunctionName->data, failedAnalysisSample);
+        printTestFail();
+        testEnvironment->results->numFail++;
+      }
+    }
+    else {
+      testEnvironment->results->numSuccess++;
+      if(!testEnvironment->results->keepFiles) {
+        _removeOutputFiles(testName);
+      }
+      if(!testEnvironment->results->onlyPrintFailing) {
+        printTestSuccess();
+      }
+    }
+  }
+  else {
+    if(testEnvironment->results->onlyPrintFailing) {
+      printTestName(testName);
+    }
+    fprintf(stderr, "Expected result code %d (%s), got %d (%s). ",
+      expectedResultCode, _getResultCodeString(expectedResultCode),
+      resultCode, _getResultCodeString(resultCode));
+    printTestFail();
+    testEnvironment->results->numFail++;
+  }
+
+  freeCharString(failedAnalysisFunctionName);
+}
+
 void runApplicationTest(const TestEnvironment testEnvironment,
   const char *testName, CharString testArguments,
   ReturnCodes expectedResultCode, const char* outputFileType)
@@ -123,9 +207,6 @@ void runApplicationTest(const TestEnvironment testEnvironment,
   ReturnCodes resultCode = (ReturnCodes)result;
   CharString arguments = newCharStringWithCapacity(kCharStringLengthLong);
   CharString defaultArguments;
-  CharString failedAnalysisFunctionName = newCharString();
-  unsigned long failedAnalysisSample;
-  File outputFolder = NULL;
   CharString outputFilename = getTestOutputFilename(testName,
     outputFileType == NULL ? kDefaultTestOutputFileType : outputFileType);
 
@@ -134,14 +215,7 @@ void runApplicationTest(const TestEnvironment testEnvironment,
   PROCESS_INFORMATION  processInfo;
 #endif
 
-  // Remove files from a previous test run
-  outputFolder = newFileWithPathCString(kApplicationRunnerOutputFolder);
-  if(fileExists(outputFolder)) {
-    _removeOutputFiles(testName);
-  }
-  else {
-    fileCreate(outputFolder, kFileTypeDirectory);
-  }
+  _prepareOutputFolder(testName);
 
   // Create the command line argument
   charStringAppendCString(arguments, "\"");
@@ -179,65 +253,166 @@ void runApplicationTest(const TestEnvironment testEnvironment,
   resultCode = (ReturnCodes)WEXITSTATUS(result);
 #endif
 
-  if(resultCode == RETURN_CODE_FORK_FAILED ||
-     resultCode == RETURN_CODE_SHELL_FAILED ||
-     resultCode == RETURN_CODE_LAUNCH_FAILED_OTHER) {
-    if(testEnvironment->results->onlyPrintFailing) {
-      printTestName(testName);
+  _checkApplicationTestResult(testEnvironment, testName, resultCode, expectedResultCode,
+    outputFileType, outputFilename->data);
+
+  freeCharString(outputFilename);
+  freeCharString(arguments);
+  freeCharString(defaultArguments);
+  freeCharString(testArguments);
+}
+
+#if UNIX
+static int _connectToDaemon(const char* socketPath) {
+  struct sockaddr_un address;
+  int connection;
+  int i;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+  // The daemon may still be starting up, so keep trying for a while
+  for(i = 0; i < kApplicationRunnerDaemonTimeoutInMs / 10; i++) {
+    connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(connection < 0) {
+      return -1;
     }
-    printTestFail();
-    logCritical("Could not launch shell, got return code %d\n\
-Please check the executable path specified in the --mrswatson-path argument.",
-      resultCode);
-    testEnvironment->results->numFail++;
+    if(connect(connection, (struct sockaddr*)&address, sizeof(address)) == 0) {
+      return connection;
+    }
+    close(connection);
+    sleepMilliseconds(10);
   }
-  else if(resultCode == expectedResultCode) {
-    if(outputFileType != NULL) {
-      if(analyzeFile(outputFilename->data, failedAnalysisFunctionName, &failedAnalysisSample)) {
-        testEnvironment->results->numSuccess++;
-        if(!testEnvironment->results->keepFiles) {
-          _removeOutputFiles(testName);
-        }
-        if(!testEnvironment->results->onlyPrintFailing) {
-          printTestSuccess();
-        }
-      }
-      else {
-        if(testEnvironment->results->onlyPrintFailing) {
-          printTestName(testName);
-        }
-        fprintf(stderr, "Analysis function %s failed at sample %lu. ",
-          failedAnalysisFunctionName->data, failedAnalysisSample);
-        printTestFail();
-        testEnvironment->results->numFail++;
-      }
+  return -1;
+}
+
+/**
+ * Send a request to a running daemon and read its replies until it closes the
+ * connection.
+ * @param socketPath Path to the daemon's socket
+ * @param request Request line, without the trailing newline
+ * @param outChainWasWarm Set to true if the daemon reused a loaded chain
+ * @return Return code from the daemon's "done" message, or
+ * RETURN_CODE_INTERNAL_ERROR if the daemon could not be reached or did not
+ * send one
+ */
+static int _sendDaemonRequest(const char* socketPath, const char* request, boolByte* outChainWasWarm) {
+  char line[RENDER_DAEMON_MAX_MESSAGE_LENGTH];
+  int connection = _connectToDaemon(socketPath);
+  int resultCode = -1;
+  FILE* replies;
+
+  *outChainWasWarm = false;
+  if(connection < 0) {
+    logCritical("Could not connect to daemon at '%s'", socketPath);
+    return RETURN_CODE_INTERNAL_ERROR;
+  }
+  if(send(connection, request, strlen(request), 0) != (ssize_t)strlen(request) ||
+    send(connection, "\n", 1, 0) != 1) {
+    close(connection);
+    return RETURN_CODE_INTERNAL_ERROR;
+  }
+
+  replies = fdopen(connection, "r");
+  if(replies == NULL) {
+    close(connection);
+    return RETURN_CODE_INTERNAL_ERROR;
+  }
+  while(fgets(line, sizeof(line), replies) != NULL) {
+    if(!strncmp(line, "chain warm", 10)) {
+      *outChainWasWarm = true;
     }
-    else {
-      testEnvironment->results->numSuccess++;
-      if(!testEnvironment->results->keepFiles) {
-        _removeOutputFiles(testName);
-      }
-      if(!testEnvironment->results->onlyPrintFailing) {
-        printTestSuccess();
-      }
+    else if(!strncmp(line, "done ", 5)) {
+      sscanf(line + 5, "%d", &resultCode);
     }
   }
-  else {
-    if(testEnvironment->results->onlyPrintFailing) {
-      printTestName(testName);
+  fclose(replies);
+
+  if(resultCode < 0) {
+    logCritical("Daemon closed the connection without finishing the job");
+    return RETURN_CODE_INTERNAL_ERROR;
+  }
+  return resultCode;
+}
+#endif
+
+void runDaemonApplicationTest(const TestEnvironment testEnvironment,
+  const char *testName, CharString testArguments,
+  ReturnCodes expectedResultCode, const char* outputFileType)
+{
+  CharString firstJobArguments = newCharStringWithCapacity(testArguments->capacity);
+  charStringCopy(firstJobArguments, testArguments);
+  runDaemonApplicationTestAfterJob(testEnvironment, testName, firstJobArguments, testArguments,
+    expectedResultCode, outputFileType);
+}
+
+void runDaemonApplicationTestAfterJob(const TestEnvironment testEnvironment,
+  const char *testName, CharString firstJobArguments, CharString testArguments,
+  ReturnCodes expectedResultCode, const char* outputFileType)
+{
+#if UNIX
+  CharString outputFilename = getTestOutputFilename(testName,
+    outputFileType == NULL ? kDefaultTestOutputFileType : outputFileType);
+  CharString socketPath = getTestOutputFilename(testName, "sock");
+  CharString logfileName = getTestOutputFilename(testName, "txt");
+  CharString pluginRoot = _getTestPluginResourcesPath(testEnvironment->resourcesPath);
+  CharString command = newCharStringWithCapacity(kCharStringLengthLong);
+  CharString firstRequest = newCharStringWithCapacity(kCharStringLengthLong);
+  CharString request = newCharStringWithCapacity(kCharStringLengthLong);
+  int resultCode = -1;
+  boolByte chainWasWarm = false;
+  int i;
+
+  _prepareOutputFolder(testName);
+  if(!testEnvironment->results->onlyPrintFailing) {
+    printTestName(testName);
+  }
+
+  // Jobs are logged to the console of the daemon, so it is redirected to the
+  // log file instead of using --log-file
+  snprintf(command->data, command->capacity,
+    "\"%s\" --verbose --plugin-root \"%s\" --daemon \"%s\" > \"%s\" 2>&1 &",
+    testEnvironment->applicationPath, pluginRoot->data, socketPath->data, logfileName->data);
+  snprintf(firstRequest->data, firstRequest->capacity, "%s --output \"%s\"", firstJobArguments->data, outputFilename->data);
+  snprintf(request->data, request->capacity, "%s --output \"%s\"", testArguments->data, outputFilename->data);
+
+  if(system(command->data) == 0) {
+    // Send two jobs, the second one should be rendered with the plugin chain
+    // which the daemon kept loaded from the first one
+    resultCode = _sendDaemonRequest(socketPath->data, firstRequest->data, &chainWasWarm);
+    if(resultCode == (int)expectedResultCode) {
+      resultCode = _sendDaemonRequest(socketPath->data, request->data, &chainWasWarm);
+      if(resultCode == RETURN_CODE_SUCCESS && !chainWasWarm) {
+        logCritical("Daemon did not reuse the plugin chain");
+        resultCode = RETURN_CODE_INTERNAL_ERROR;
+      }
+    }
+    _sendDaemonRequest(socketPath->data, RENDER_DAEMON_SHUTDOWN_REQUEST, &chainWasWarm);
+    // The daemon removes its socket when it exits
+    for(i = 0; i < kApplicationRunnerDaemonTimeoutInMs / 10 && access(socketPath->data, F_OK) == 0; i++) {
+      sleepMilliseconds(10);
     }
-    fprintf(stderr, "Expected result code %d (%s), got %d (%s). ",
-      expectedResultCode, _getResultCodeString(expectedResultCode),
-      resultCode, _getResultCodeString(resultCode));
-    printTestFail();
-    testEnvironment->results->numFail++;
   }
 
+  _checkApplicationTestResult(testEnvironment, testName, (ReturnCodes)resultCode, expectedResultCode,
+    outputFileType, outputFilename->data);
+
   freeCharString(outputFilename);
-  freeCharString(arguments);
-  freeCharString(defaultArguments);
+  freeCharString(socketPath);
+  freeCharString(logfileName);
+  freeCharString(pluginRoot);
+  freeCharString(command);
+  freeCharString(firstRequest);
+  freeCharString(request);
+#else
+  // The daemon is only supported on Unix platforms
+  printTestName(testName);
+  printToLog(getLogColor(kTestLogEventSkip), NULL, "Skipped");
+  flushLog(NULL);
+  testEnvironment->results->numSkips++;
+#endif
+  freeCharString(firstJobArguments);
   freeCharString(testArguments);
-  freeCharString(failedAnalysisFunctionName);
 }
 
 void freeTestEnvironment(TestEnvironment self) {
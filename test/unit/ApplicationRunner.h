@@ -31,6 +31,24 @@ void runApplicationTest(const TestEnvironment testEnvironment,
   const char *testName, CharString testArguments,
   ReturnCodes expectedResultCode, const char* outputFileType);
 
+/**
+ * Start the application as a render daemon and send it the test arguments as a
+ * request, then send the same request again and check that the daemon reused
+ * its plugin chain. The daemon is shut down afterwards.
+ */
+void runDaemonApplicationTest(const TestEnvironment testEnvironment,
+  const char *testName, CharString testArguments,
+  ReturnCodes expectedResultCode, const char* outputFileType);
+
+/**
+ * Like runDaemonApplicationTest(), but the first request sent to the daemon is
+ * made with different arguments. This checks that settings from one job do not
+ * carry over to the next job which reuses the same plugin chain.
+ */
+void runDaemonApplicationTestAfterJob(const TestEnvironment testEnvironment,
+  const char *testName, CharString firstJobArguments, CharString testArguments,
+  ReturnCodes expectedResultCode, const char* outputFileType);
+
 CharString buildTestArgumentString(const char* arguments, ...);
 CharString getTestResourceFilename(const char* resourcesPath, const char* resourceType, const char* resourceName);
 CharString getTestOutputFilename(const char* testName, const char* fileExtension);
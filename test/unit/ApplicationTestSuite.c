@@ -60,6 +60,14 @@ void runApplicationTestSuite(TestEnvironment environment) {
     buildTestArgumentString("--plugin again --input \"%s\" --parameter 1,0.5", a440_stereo_pcm),
     RETURN_CODE_INVALID_ARGUMENT, NULL
   );
+  runApplicationTest(environment, "Set invalid output format",
+    buildTestArgumentString("--plugin again --input \"%s\" --output-format int12", a440_stereo_pcm),
+    RETURN_CODE_INVALID_ARGUMENT, NULL
+  );
+  runApplicationTest(environment, "Set invalid compression level",
+    buildTestArgumentString("--plugin again --input \"%s\" --compression-level 9", a440_stereo_pcm),
+    RETURN_CODE_INVALID_ARGUMENT, NULL
+  );
   runApplicationTest(environment, "Set invalid time signature",
     buildTestArgumentString("--plugin again --input \"%s\" --time-signature invalid", a440_stereo_pcm),
     RETURN_CODE_INVALID_ARGUMENT, NULL
@@ -74,6 +82,22 @@ void runApplicationTestSuite(TestEnvironment environment) {
     buildTestArgumentString("--plugin again --input \"%s\"", a440_stereo_pcm),
     RETURN_CODE_SUCCESS, "wav"
   );
+  runApplicationTest(environment, "Write 24-bit WAV file",
+    buildTestArgumentString("--plugin again --input \"%s\" --output-format int24", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, "wav"
+  );
+  runApplicationTest(environment, "Write floating point WAV file",
+    buildTestArgumentString("--plugin again --input \"%s\" --output-format float32", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, "wav"
+  );
+  runApplicationTest(environment, "Write FLAC file",
+    buildTestArgumentString("--plugin again --input \"%s\"", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, "flac"
+  );
+  runApplicationTest(environment, "Write FLAC file with compression level",
+    buildTestArgumentString("--plugin again --input \"%s\" --compression-level 8 --output-format int24", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, "flac"
+  );
 
   // Configuration tests
   runApplicationTest(environment, "Read mono input source",
@@ -100,6 +124,49 @@ void runApplicationTestSuite(TestEnvironment environment) {
     buildTestArgumentString("--plugin again --input \"%s\" --time-signature 3/4", a440_stereo_pcm),
     RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
   );
+  runApplicationTest(environment, "Process with pipelined threads",
+    buildTestArgumentString("--plugin again --input \"%s\" --pipeline --tail-time 10", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+  runApplicationTest(environment, "Process with parallel segments",
+    buildTestArgumentString("--plugin again --input \"%s\" --segments 4 --segment-overlap 10", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+  runApplicationTest(environment, "Process with parallel plugin branches",
+    buildTestArgumentString("--plugin \"again;[+again]\" --input \"%s\"", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+  runApplicationTest(environment, "Process with pipelined plugins",
+    buildTestArgumentString("--plugin \"again;again;again\" --input \"%s\" --pipeline-plugins", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+  runApplicationTest(environment, "Write output with write-behind thread",
+    buildTestArgumentString("--plugin again --input \"%s\" --write-behind", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+  runApplicationTest(environment, "Process with huge page buffers",
+    buildTestArgumentString("--plugin again --input \"%s\" --blocksize 524288 --huge-pages", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+  runApplicationTest(environment, "Process MIDI with pipelined threads",
+    buildTestArgumentString("--plugin vstxsynth --midi-file \"%s\" --pipeline 2", c_scale_mid),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+
+  // Render daemon
+  runDaemonApplicationTest(environment, "Render through daemon",
+    buildTestArgumentString("--plugin again --input \"%s\"", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+  runDaemonApplicationTestAfterJob(environment, "Render through daemon after job with parameters",
+    buildTestArgumentString("--plugin again --input \"%s\" --parameter 0,0.0", a440_stereo_pcm),
+    buildTestArgumentString("--plugin again --input \"%s\"", a440_stereo_pcm),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
+  runDaemonApplicationTest(environment, "Render MIDI through daemon",
+    buildTestArgumentString("--plugin vstxsynth,again --midi-file \"%s\"", c_scale_mid),
+    RETURN_CODE_SUCCESS, kDefaultTestOutputFileType
+  );
 
   // Internal plugins
   runApplicationTest(environment, "Process with internal passthru plugin",
@@ -2,23 +2,41 @@
 #include "base/LinkedList.h"
 #include "unit/TestRunner.h"
 
+extern TestSuite addAllocationCounterTests(void);
+extern TestSuite addAsyncFileWriterTests(void);
 extern TestSuite addAudioClockTests(void);
 extern TestSuite addAudioSettingsTests(void);
+extern TestSuite addBatchManifestTests(void);
 extern TestSuite addCharStringTests(void);
+extern TestSuite addEngineContextTests(void);
 extern TestSuite addFileTests(void);
 extern TestSuite addFileUtilitiesTests(void);
+extern TestSuite addFlacDecoderTests(void);
+extern TestSuite addFlacEncoderTests(void);
 extern TestSuite addLinkedListTests(void);
+extern TestSuite addMappedFileTests(void);
 extern TestSuite addMidiSequenceTests(void);
 extern TestSuite addMidiSourceTests(void);
+extern TestSuite addPcmConversionTests(void);
 extern TestSuite addPlatformUtilitiesTests(void);
 extern TestSuite addPluginTests(void);
+extern TestSuite addPluginAutomationTests(void);
 extern TestSuite addPluginChainTests(void);
+extern TestSuite addPluginChainPoolTests(void);
+extern TestSuite addPluginGraphTests(void);
+extern TestSuite addPluginPipelineTests(void);
 extern TestSuite addPluginPresetTests(void);
+extern TestSuite addPluginTapTests(void);
 extern TestSuite addPluginVst2xIdTests(void);
 extern TestSuite addProgramOptionTests(void);
+extern TestSuite addRealtimeSchedulerTests(void);
+extern TestSuite addRenderDaemonTests(void);
+extern TestSuite addRenderSegmentTests(void);
 extern TestSuite addSampleBufferTests(void);
+extern TestSuite addSampleBufferQueueTests(void);
 extern TestSuite addSampleSourceTests(void);
 extern TestSuite addTaskTimerTests(void);
+extern TestSuite addThreadTests(void);
 
 extern TestSuite addAnalysisClippingTests(void);
 extern TestSuite addAnalysisDistortionTests(void);
@@ -37,23 +55,41 @@ static void _sumTestSuiteResults(void* item, void* extraData) {
 LinkedList getTestSuites(void);
 LinkedList getTestSuites(void) {
   LinkedList internalTestSuites = newLinkedList();
+  linkedListAppend(internalTestSuites, addAllocationCounterTests());
+  linkedListAppend(internalTestSuites, addAsyncFileWriterTests());
   linkedListAppend(internalTestSuites, addAudioClockTests());
   linkedListAppend(internalTestSuites, addAudioSettingsTests());
+  linkedListAppend(internalTestSuites, addBatchManifestTests());
   linkedListAppend(internalTestSuites, addCharStringTests());
+  linkedListAppend(internalTestSuites, addEngineContextTests());
   linkedListAppend(internalTestSuites, addFileTests());
   linkedListAppend(internalTestSuites, addFileUtilitiesTests());
+  linkedListAppend(internalTestSuites, addFlacDecoderTests());
+  linkedListAppend(internalTestSuites, addFlacEncoderTests());
   linkedListAppend(internalTestSuites, addLinkedListTests());
+  linkedListAppend(internalTestSuites, addMappedFileTests());
   linkedListAppend(internalTestSuites, addMidiSequenceTests());
   linkedListAppend(internalTestSuites, addMidiSourceTests());
+  linkedListAppend(internalTestSuites, addPcmConversionTests());
   linkedListAppend(internalTestSuites, addPlatformUtilitiesTests());
   linkedListAppend(internalTestSuites, addPluginTests());
+  linkedListAppend(internalTestSuites, addPluginAutomationTests());
   linkedListAppend(internalTestSuites, addPluginChainTests());
+  linkedListAppend(internalTestSuites, addPluginChainPoolTests());
+  linkedListAppend(internalTestSuites, addPluginGraphTests());
+  linkedListAppend(internalTestSuites, addPluginPipelineTests());
   linkedListAppend(internalTestSuites, addPluginPresetTests());
+  linkedListAppend(internalTestSuites, addPluginTapTests());
   linkedListAppend(internalTestSuites, addPluginVst2xIdTests());
   linkedListAppend(internalTestSuites, addProgramOptionTests());
+  linkedListAppend(internalTestSuites, addRealtimeSchedulerTests());
+  linkedListAppend(internalTestSuites, addRenderDaemonTests());
+  linkedListAppend(internalTestSuites, addRenderSegmentTests());
   linkedListAppend(internalTestSuites, addSampleBufferTests());
+  linkedListAppend(internalTestSuites, addSampleBufferQueueTests());
   linkedListAppend(internalTestSuites, addSampleSourceTests());
   linkedListAppend(internalTestSuites, addTaskTimerTests());
+  linkedListAppend(internalTestSuites, addThreadTests());
 
   linkedListAppend(internalTestSuites, addAnalysisClippingTests());
   linkedListAppend(internalTestSuites, addAnalysisDistortionTests());